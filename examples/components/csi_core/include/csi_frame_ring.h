@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_frame_ring.h
+ * @brief Preallocated CSI frame pool with a single-producer/single-consumer ring
+ *
+ * All slots are allocated once at init. The Wi-Fi CSI callback (producer)
+ * acquires the next free slot, fills it in place and commits it; the
+ * processing task (consumer) receives the oldest slot, uses it in place and
+ * releases it. No heap is touched on the packet path. When the ring is full
+ * the new frame is dropped and counted as an overrun.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t committed;     /**< Frames handed to the consumer */
+    uint32_t released;      /**< Frames returned by the consumer */
+    uint32_t overruns;      /**< Frames dropped because the ring was full */
+    uint32_t flushed;       /**< Frames discarded by csi_frame_ring_flush() */
+    uint32_t high_water;    /**< Largest number of pending frames seen */
+} csi_frame_ring_stats_t;
+
+typedef struct {
+    uint8_t *pool;              /**< capacity * slot_size bytes */
+    size_t slot_size;
+    uint32_t capacity;          /**< Power of two */
+    uint32_t head;              /**< Free-running producer index */
+    uint32_t tail;              /**< Free-running consumer index */
+    uint32_t flush_mark;        /**< head snapshot taken by csi_frame_ring_flush() */
+    uint32_t flush_pending;
+    SemaphoreHandle_t ready;    /**< Counts committed frames */
+    csi_frame_ring_stats_t stats;
+} csi_frame_ring_t;
+
+/**
+ * @brief Allocate the frame pool and ring
+ *
+ * @param ring      Ring to initialize
+ * @param slot_size Bytes per frame
+ * @param capacity  Number of frames, must be a power of two
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if capacity is not a power of two
+ *      - ESP_ERR_NO_MEM if the pool could not be allocated
+ */
+esp_err_t csi_frame_ring_init(csi_frame_ring_t *ring, size_t slot_size, uint32_t capacity);
+
+/**
+ * @brief Producer: get the next free slot to fill in place
+ *
+ * @return Slot pointer, or NULL if the ring is full (counted as an overrun)
+ */
+void *csi_frame_ring_acquire(csi_frame_ring_t *ring);
+
+/**
+ * @brief Producer: publish the slot returned by the last csi_frame_ring_acquire()
+ */
+void csi_frame_ring_commit(csi_frame_ring_t *ring);
+
+/**
+ * @brief Consumer: wait for the oldest committed frame
+ *
+ * The slot stays owned by the consumer until csi_frame_ring_release().
+ *
+ * @return Slot pointer, or NULL on timeout
+ */
+void *csi_frame_ring_receive(csi_frame_ring_t *ring, TickType_t ticks_to_wait);
+
+/**
+ * @brief Consumer: return the slot obtained by csi_frame_ring_receive()
+ */
+void csi_frame_ring_release(csi_frame_ring_t *ring);
+
+/**
+ * @brief Discard every frame committed so far
+ *
+ * Safe to call from an ISR; the frames are dropped by the consumer on its
+ * next csi_frame_ring_receive().
+ */
+void csi_frame_ring_flush(csi_frame_ring_t *ring);
+
+/**
+ * @brief Number of committed frames not yet released
+ */
+uint32_t csi_frame_ring_count(const csi_frame_ring_t *ring);
+
+/**
+ * @brief Copy the ring counters
+ */
+void csi_frame_ring_get_stats(const csi_frame_ring_t *ring, csi_frame_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
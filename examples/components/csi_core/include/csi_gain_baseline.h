@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_gain_baseline.h
+ * @brief Fix the gain baseline of esp_csi_gain_ctrl once for the whole receiver
+ *
+ * esp_csi_gain_ctrl_get_gain_compensation() compensates against the
+ * component's own baseline, the mean of the gains passed to
+ * esp_csi_gain_ctrl_record_rx_gain(). The receivers compensate against
+ * baselines of their own, one per link from csi_gain_track, by dividing the
+ * compensation of a frame by the compensation of the link baseline. The
+ * component baseline cancels in that division only while it stays where it
+ * was when the link baseline was compensated.
+ *
+ * esp_csi_gain_ctrl_get_rx_gain_baseline() is what fixes it: besides
+ * returning the baseline, the call takes the mean of the recorded gains as
+ * the baseline of every later compensation. Recording more gains after it
+ * would move that baseline again. csi_gain_baseline_record() therefore
+ * stops feeding the component once csi_gain_baseline_lock() has run, and
+ * the lock runs once, at the first baseline of any link, before that
+ * baseline is compensated.
+ *
+ * Header only, since csi_core does not depend on esp_csi_gain_ctrl:
+ * include it from a component that does. The state belongs to the Wi-Fi
+ * CSI callback.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_csi_gain_ctrl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool locked;    /**< Component baseline fixed, no more gains are recorded */
+} csi_gain_baseline_t;
+
+/**
+ * @brief Record the gains of a frame into the component baseline, until it is locked
+ */
+static inline void csi_gain_baseline_record(csi_gain_baseline_t *baseline, uint8_t agc_gain, int8_t fft_gain)
+{
+    if (!baseline->locked) {
+        esp_csi_gain_ctrl_record_rx_gain(agc_gain, fft_gain);
+    }
+}
+
+/**
+ * @brief Fix the component baseline, the first call only
+ *
+ * Call it before the first esp_csi_gain_ctrl_get_gain_compensation() whose
+ * result is kept, e.g. the compensation of a link baseline.
+ */
+static inline void csi_gain_baseline_lock(csi_gain_baseline_t *baseline)
+{
+    if (!baseline->locked) {
+        /* Called for its side effect, the component baseline is not used here */
+        uint8_t agc_gain = 0;
+        int8_t fft_gain = 0;
+        esp_csi_gain_ctrl_get_rx_gain_baseline(&agc_gain, &fft_gain);
+        baseline->locked = true;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
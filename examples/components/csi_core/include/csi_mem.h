@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_mem.h
+ * @brief Where the CSI buffers go: internal RAM for the packet path, PSRAM for the bulk
+ *
+ * The default allocator decides by size alone: with
+ * CONFIG_SPIRAM_USE_MALLOC a frame pool above the always-internal limit
+ * ends up in PSRAM, next to the UI, while a large history buffer takes
+ * internal RAM the Wi-Fi driver needs for its RX buffers. Each allocation
+ * here names its class instead:
+ *
+ *  - CSI_MEM_HOT: touched for every frame, internal RAM.
+ *  - CSI_MEM_DMA: read by a peripheral DMA, internal DMA-capable RAM.
+ *  - CSI_MEM_BULK: large and touched rarely, PSRAM with
+ *    CONFIG_CSI_MEM_BULK_PSRAM, internal RAM when there is none or it is full.
+ *
+ * Allocations and the static buffers and code given to csi_mem_note() are
+ * kept in a map of CSI_MEM_MAP_MAX entries, logged by csi_mem_log_map() with
+ * the memory each one landed in, so the cost of every queue depth and
+ * display buffer can be read at boot.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_MEM_MAP_MAX     32      /**< Entries kept for csi_mem_log_map() */
+
+/**
+ * @brief Static buffer in PSRAM with CONFIG_CSI_MEM_BULK_PSRAM, for history rings and the like
+ *
+ * Needs CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY, the buffer stays in
+ * internal RAM without it. Such a buffer is zeroed, not initialized.
+ */
+#if CONFIG_CSI_MEM_BULK_PSRAM && CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY
+#define CSI_MEM_BULK_BSS_ATTR   EXT_RAM_BSS_ATTR
+#else
+#define CSI_MEM_BULK_BSS_ATTR
+#endif
+
+typedef enum {
+    CSI_MEM_HOT = 0,
+    CSI_MEM_DMA,
+    CSI_MEM_BULK,
+    CSI_MEM_CLASS_MAX,
+} csi_mem_class_t;
+
+/**
+ * @brief Allocate zeroed memory of a class and note it in the map
+ *
+ * @param name Static string shown in the map
+ *
+ * @return The memory, or NULL if no memory of the class is left
+ */
+void *csi_mem_calloc(csi_mem_class_t mem_class, size_t num, size_t size, const char *name);
+
+/**
+ * @brief Free memory of csi_mem_calloc() and drop it from the map, NULL is ignored
+ */
+void csi_mem_free(void *ptr);
+
+/**
+ * @brief Note a static buffer, a constant asset or a function in the map
+ *
+ * @param size Bytes, 0 for a function
+ */
+void csi_mem_note(const char *name, const void *ptr, size_t size);
+
+/**
+ * @brief Memory an address is in: "iram", "dram", "psram", "flash", or "?" for any other
+ */
+const char *csi_mem_region(const void *ptr);
+
+/**
+ * @brief Log every entry of the map with its memory, the bytes per memory and the free heap of each
+ */
+void csi_mem_log_map(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_perf.h
+ * @brief Fixed-memory latency histograms for the stages of the CSI pipeline
+ *
+ * A stage is registered once by name. Each probe records one duration in
+ * microseconds into a log-bucket histogram: four buckets per power of two,
+ * so any percentile is known within 25 %, from 1 us up to about a minute.
+ * Recording is a short critical section and never allocates, so probes may
+ * sit in the Wi-Fi callbacks. Stages can also count drops, e.g. full queues.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_PERF_STAGE_MAX      12      /**< Stages that can be registered */
+#define CSI_PERF_BUCKETS        100     /**< Histogram buckets per stage */
+#define CSI_PERF_STAGE_NONE     0xff    /**< Returned when the table is full, probes on it do nothing */
+
+typedef uint8_t csi_perf_stage_t;
+
+typedef struct {
+    const char *name;
+    uint32_t count;         /**< Durations recorded */
+    uint32_t drops;         /**< csi_perf_drop() calls */
+    uint32_t mean_us;
+    uint32_t p50_us;        /**< Upper bound of the bucket holding the percentile */
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} csi_perf_summary_t;
+
+/**
+ * @brief Register a stage, or look it up if the name is already registered
+ *
+ * @param name Static string, kept by reference
+ *
+ * @return Stage handle, CSI_PERF_STAGE_NONE if CSI_PERF_STAGE_MAX stages exist
+ */
+csi_perf_stage_t csi_perf_register(const char *name);
+
+/**
+ * @brief Record one duration
+ */
+void csi_perf_record(csi_perf_stage_t stage, uint32_t duration_us);
+
+/**
+ * @brief Timestamp to pass to csi_perf_end()
+ */
+static inline int64_t csi_perf_begin(void)
+{
+    return esp_timer_get_time();
+}
+
+/**
+ * @brief Record the time since start, a csi_perf_begin() or any esp_timer_get_time() value
+ */
+static inline void csi_perf_end(csi_perf_stage_t stage, int64_t start_us)
+{
+    csi_perf_record(stage, esp_timer_get_time() - start_us);
+}
+
+/**
+ * @brief Count an item the stage had to drop
+ */
+void csi_perf_drop(csi_perf_stage_t stage);
+
+/**
+ * @brief Number of registered stages, handles are 0 to this minus one
+ */
+uint8_t csi_perf_stage_num(void);
+
+/**
+ * @brief Summarize the histogram of a stage
+ *
+ * @return false if stage is not registered
+ */
+bool csi_perf_get(csi_perf_stage_t stage, csi_perf_summary_t *summary);
+
+/**
+ * @brief Clear the histograms and counters of all stages
+ */
+void csi_perf_reset(void);
+
+/**
+ * @brief Print one line per stage with ESP_LOGI
+ */
+void csi_perf_print(void);
+
+/**
+ * @brief Write all stages as a JSON object
+ *
+ * @return Length written without the terminator, truncated to size - 1
+ */
+int csi_perf_json(char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
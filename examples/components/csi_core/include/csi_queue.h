@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_queue.h
+ * @brief FreeRTOS queue with an overflow policy and overflow accounting
+ *
+ * Items are copied in and out, so a dropped item never leaks memory. Sending
+ * never blocks; when the queue is full or getting full, the configured
+ * policy decides what is lost:
+ *
+ *  - CSI_QUEUE_DROP_NEWEST: the item being sent, for consumers that need
+ *    the history, e.g. a join waiting for the partner of an older record.
+ *  - CSI_QUEUE_DROP_OLDEST: the oldest waiting item, so the consumer always
+ *    sees the latest data.
+ *  - CSI_QUEUE_DECIMATE: once decimate_level items wait, only every
+ *    decimate_ratio-th item is queued, e.g. for a display that can skip
+ *    frames but should keep moving. Items are dropped as for DROP_NEWEST
+ *    when the queue is full anyway.
+ *
+ * Every drop is counted, together with the high-water mark, so the stage
+ * that saturates first can be found from the counters.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_QUEUE_ITEM_MAX      128     /**< Largest item for CSI_QUEUE_DROP_OLDEST, it is read back on the stack */
+
+typedef enum {
+    CSI_QUEUE_DROP_NEWEST,
+    CSI_QUEUE_DROP_OLDEST,
+    CSI_QUEUE_DECIMATE,
+} csi_queue_policy_t;
+
+typedef struct {
+    const char *name;               /**< Static string, used in logs and statistics */
+    uint32_t length;
+    size_t item_size;
+    csi_queue_policy_t policy;
+    uint32_t decimate_level;        /**< CSI_QUEUE_DECIMATE: waiting items from which it decimates */
+    uint32_t decimate_ratio;        /**< CSI_QUEUE_DECIMATE: keep one of this many items */
+} csi_queue_config_t;
+
+#define CSI_QUEUE_CONFIG_DEFAULT(name_, length_, item_size_) { \
+    .name = name_, \
+    .length = length_, \
+    .item_size = item_size_, \
+    .policy = CSI_QUEUE_DROP_NEWEST, \
+    .decimate_level = (length_) / 2, \
+    .decimate_ratio = 2, \
+}
+
+typedef struct {
+    uint32_t sent;                  /**< Items queued */
+    uint32_t received;
+    uint32_t dropped_newest;        /**< Items refused because the queue was full */
+    uint32_t dropped_oldest;        /**< Waiting items discarded for a newer one */
+    uint32_t decimated;             /**< Items skipped by CSI_QUEUE_DECIMATE */
+    uint32_t high_water;            /**< Most items seen waiting */
+} csi_queue_stats_t;
+
+typedef struct {
+    QueueHandle_t handle;
+    csi_queue_config_t config;
+    uint32_t decimate_count;
+    portMUX_TYPE lock;              /* Guards stats and decimate_count */
+    csi_queue_stats_t stats;
+} csi_queue_t;
+
+/**
+ * @brief Create the queue
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the config is incomplete or the item too large for its policy
+ *      - ESP_ERR_NO_MEM if the queue could not be allocated
+ */
+esp_err_t csi_queue_init(csi_queue_t *queue, const csi_queue_config_t *config);
+
+/**
+ * @brief Copy an item into the queue, never blocks
+ *
+ * @return true if the item was queued, false if the policy dropped it
+ */
+bool csi_queue_send(csi_queue_t *queue, const void *item);
+
+/**
+ * @brief Copy the oldest item out of the queue
+ *
+ * @return true if an item was received before the timeout
+ */
+bool csi_queue_receive(csi_queue_t *queue, void *item, TickType_t ticks_to_wait);
+
+/**
+ * @brief Number of waiting items
+ */
+uint32_t csi_queue_count(const csi_queue_t *queue);
+
+/**
+ * @brief Copy the counters
+ */
+void csi_queue_get_stats(csi_queue_t *queue, csi_queue_stats_t *stats);
+
+/**
+ * @brief Sum of all drops, whatever the policy
+ */
+uint32_t csi_queue_drops(const csi_queue_stats_t *stats);
+
+/**
+ * @brief Write the counters as a JSON object
+ *
+ * @return Length written without the terminator, truncated to size - 1
+ */
+int csi_queue_json(csi_queue_t *queue, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
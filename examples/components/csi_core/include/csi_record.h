@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_record.h
+ * @brief Compact binary CSI record written to the console UART
+ *
+ * Each record is a fixed little-endian header followed by the raw CSI buffer,
+ * written with a single call. It replaces the CSV line when the CSV output
+ * cannot keep up with the packet rate. The matching decoder lives in
+ * get-started/tools/csi_data_read_parse.py (--format binary).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_RECORD_MAGIC_0              0xC5
+#define CSI_RECORD_MAGIC_1              0x1B
+#define CSI_RECORD_VERSION              1
+#define CSI_RECORD_MAX_DATA_LEN         1024
+
+/* Payload is packed 12-bit LLTF samples (int16 little endian), otherwise int8 */
+#define CSI_RECORD_FLAG_LLTF_12BIT      (1 << 0)
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic[2];           /**< CSI_RECORD_MAGIC_0, CSI_RECORD_MAGIC_1 */
+    uint8_t version;            /**< CSI_RECORD_VERSION */
+    uint8_t flags;              /**< CSI_RECORD_FLAG_* */
+    uint16_t len;               /**< Payload length in bytes */
+    uint32_t seq;
+    uint32_t local_timestamp;
+    uint8_t mac[6];
+    int8_t rssi;
+    uint8_t rate;
+    int8_t noise_floor;
+    int8_t fft_gain;
+    uint8_t agc_gain;
+    uint8_t channel;
+    uint16_t sig_len;
+    uint8_t rx_state;
+    uint8_t first_word_invalid;
+    float compensate_gain;      /**< Not applied to the payload, the host multiplies */
+} csi_record_header_t;
+
+#define CSI_RECORD_MAX_LEN              (sizeof(csi_record_header_t) + CSI_RECORD_MAX_DATA_LEN)
+
+/**
+ * @brief Write one CSI packet as a binary record into a buffer
+ *
+ * @param record Buffer of CSI_RECORD_MAX_LEN bytes, the other arguments are those of csi_record_output()
+ *
+ * @return Record length, header included
+ */
+size_t csi_record_build(uint8_t *record, uint32_t seq, const wifi_csi_info_t *info, int8_t fft_gain,
+                        uint8_t agc_gain, float compensate_gain, bool lltf_12bit);
+
+/**
+ * @brief Install the console UART driver with a TX ring buffer so records are queued without blocking
+ */
+esp_err_t csi_record_output_init(void);
+
+/**
+ * @brief Write one CSI packet as a binary record
+ *
+ * @param seq             Sequence number reported in the record
+ * @param info            CSI packet from the Wi-Fi driver
+ * @param fft_gain        FFT gain of the packet
+ * @param agc_gain        AGC gain of the packet
+ * @param compensate_gain Gain compensation factor for the host
+ * @param lltf_12bit      Payload is packed 12-bit LLTF data (acquire_csi_force_lltf)
+ */
+void csi_record_output(uint32_t seq, const wifi_csi_info_t *info, int8_t fft_gain, uint8_t agc_gain,
+                       float compensate_gain, bool lltf_12bit);
+
+#ifdef __cplusplus
+}
+#endif
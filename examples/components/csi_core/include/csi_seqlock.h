@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_seqlock.h
+ * @brief Lock-free publication of records from one writer task to any number of readers
+ *
+ * The writer never waits: it makes the sequence number odd, copies the
+ * record and makes it even again. A reader copies the record out and keeps
+ * the copy only if the sequence number was even and unchanged around it,
+ * otherwise it retries a few times and gives up, so a torn record is never
+ * returned. Only one task may write a given lock; readers may be in any
+ * task but not in an ISR.
+ *
+ * csi_seqlock_table_t keeps one such slot per record id, indexed by the id
+ * modulo a power-of-two capacity, for tables of per-packet or per-link
+ * records.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_SEQLOCK_READ_RETRY      4
+
+typedef struct {
+    uint32_t seq;               /**< Odd while the writer is updating the record */
+} csi_seqlock_t;
+
+#define CSI_SEQLOCK_INIT() { .seq = 0 }
+
+/**
+ * @brief Writer: copy size bytes from src to the record dst guarded by lock
+ */
+void csi_seqlock_write(csi_seqlock_t *lock, void *dst, const void *src, size_t size);
+
+/**
+ * @brief Reader: copy a consistent snapshot of the record src guarded by lock
+ *
+ * @param torn_reads Incremented for every attempt that met the writer, may be NULL
+ *
+ * @return false if the writer was active during all CSI_SEQLOCK_READ_RETRY attempts, dst is then undefined
+ */
+bool csi_seqlock_read(const csi_seqlock_t *lock, void *dst, const void *src, size_t size, uint32_t *torn_reads);
+
+/**
+ * @brief Bytes of one table slot, a csi_seqlock_t and the record, 4-byte aligned
+ */
+#define CSI_SEQLOCK_SLOT_SIZE(record_size)  ((sizeof(csi_seqlock_t) + (record_size) + 3) & ~(size_t)3)
+
+/**
+ * @brief uint32_t elements of the table storage
+ */
+#define CSI_SEQLOCK_TABLE_STORAGE_LEN(record_size, capacity) \
+    ((capacity) * CSI_SEQLOCK_SLOT_SIZE(record_size) / sizeof(uint32_t))
+
+typedef struct {
+    uint8_t *slots;
+    size_t record_size;
+    size_t slot_size;
+    uint32_t mask;              /**< Capacity - 1 */
+    uint32_t published;         /**< Records written */
+    uint32_t torn_reads;        /**< Read attempts that met the writer */
+} csi_seqlock_table_t;
+
+/**
+ * @brief Initialize a table over caller storage, every slot starts zeroed
+ *
+ * @param storage  CSI_SEQLOCK_TABLE_STORAGE_LEN(record_size, capacity) elements
+ * @param capacity Power of two
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL or zero, or the capacity is not a power of two
+ */
+esp_err_t csi_seqlock_table_init(csi_seqlock_table_t *table, uint32_t *storage, size_t record_size, uint32_t capacity);
+
+/**
+ * @brief Writer: publish the record of an id, overwriting the id capacity slots before it
+ */
+void csi_seqlock_table_publish(csi_seqlock_table_t *table, uint32_t id, const void *record);
+
+/**
+ * @brief Reader: copy the record in the slot of an id
+ *
+ * The slot may hold an older id sharing it, or zeros if none was
+ * published, the caller tells them apart by the record content.
+ *
+ * @return false if the writer kept the slot busy, record is then undefined
+ */
+bool csi_seqlock_table_read(csi_seqlock_table_t *table, uint32_t id, void *record);
+
+#ifdef __cplusplus
+}
+#endif
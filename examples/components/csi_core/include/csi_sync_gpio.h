@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_sync_gpio.h
+ * @brief Falling edge of a shared sync line restarts the CSI time base
+ *
+ * On the esp-crab boards both chips see the same line; every edge stamps
+ * the new time zero and drops the frames still waiting in the ring, so the
+ * records of both chips count from the same moment.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "csi_frame_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int gpio_num;                   /**< Input with pull-up, interrupt on the falling edge */
+    csi_frame_ring_t *ring;         /**< Flushed on every edge, may be NULL */
+    int64_t *time_zero;             /**< Set to esp_timer_get_time() on every edge */
+} csi_sync_gpio_config_t;
+
+/**
+ * @brief Configure the pin and install its interrupt, the GPIO ISR service is shared
+ */
+esp_err_t csi_sync_gpio_init(const csi_sync_gpio_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
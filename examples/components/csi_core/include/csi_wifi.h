@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_wifi.h
+ * @brief Station and ESP-NOW bring-up of the CSI examples, one per-target ladder for all
+ *
+ * The targets differ in how band, protocol and bandwidth are set: the
+ * esp32c5 has both bands, the esp32c6 (IDF 5.4 and later) and esp32c61
+ * take the per-band calls for 2.4 GHz only, the others the single
+ * bandwidth call. The band follows the channel, above 14 is 5 GHz.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t channel;                /**< Primary channel */
+    wifi_bandwidth_t bandwidth;     /**< WIFI_BW_HT20 or WIFI_BW_HT40 */
+    wifi_second_chan_t second;      /**< Secondary of HT40, WIFI_SECOND_CHAN_NONE picks it with csi_wifi_second_chan() */
+    const uint8_t *mac;             /**< Station MAC, NULL keeps the factory one */
+} csi_wifi_config_t;
+
+#define CSI_WIFI_CONFIG_DEFAULT() { \
+    .channel = 11, \
+    .bandwidth = WIFI_BW_HT40, \
+    .second = WIFI_SECOND_CHAN_NONE, \
+    .mac = NULL, \
+}
+
+/**
+ * @brief HT40 secondary channel on the side that exists, WIFI_SECOND_CHAN_NONE for HT20
+ *
+ * 2.4 GHz channels 1 to 4 pair above, the others below; 5 GHz channels pair
+ * within their 40 MHz block, e.g. 36 above and 40 below.
+ */
+wifi_second_chan_t csi_wifi_second_chan(uint8_t channel, wifi_bandwidth_t bandwidth);
+
+/**
+ * @brief Bring up the default event loop, netif and Wi-Fi as a station
+ *
+ * 802.11n only, power save off, on the configured channel.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - The error of the first Wi-Fi call that failed
+ */
+esp_err_t csi_wifi_init(const csi_wifi_config_t *config);
+
+/**
+ * @brief Initialize ESP-NOW, add the peer and fix its PHY rate
+ */
+esp_err_t csi_wifi_esp_now_init(const esp_now_peer_info_t *peer, wifi_phy_mode_t phymode, wifi_phy_rate_t rate);
+
+#ifdef __cplusplus
+}
+#endif
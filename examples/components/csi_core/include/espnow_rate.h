@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file espnow_rate.h
+ * @brief Per-peer ESP-NOW rate selection and airtime accounting per traffic class
+ *
+ * The CSI excitation frames stay on the configured sensing rate, so the
+ * CSI of every packet comes from the same modulation. Report and command
+ * frames to a unicast peer take the fastest HT MCS its RSSI allows with
+ * a margin. The rate drops one step when the share of acknowledged frames
+ * falls below step_down_percent, and climbs back one step at a time
+ * after hold_ms. Broadcasts get no acknowledgement, so they stay on the
+ * fallback rate.
+ *
+ * Every frame sent, and every sensing frame heard, adds its estimated
+ * airtime to its class: preamble, payload at the rate and, for a unicast
+ * frame, the acknowledgement.
+ *
+ * espnow_rate_rx() and espnow_rate_tx_done() are meant for the ESP-NOW
+ * callbacks. The rate of a peer changes in espnow_rate_send(), from a task.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESPNOW_RATE_PEER_MAX        16
+#define ESPNOW_RATE_FRAME_OVERHEAD  43      /**< Bytes around the payload: MAC header, vendor action header and FCS */
+#define ESPNOW_RATE_ACK_US          54      /**< SIFS and a legacy ACK at 6 Mbps after a unicast frame */
+
+typedef enum {
+    ESPNOW_RATE_CLASS_SENSING = 0,  /**< CSI excitation frames, on the sensing rate */
+    ESPNOW_RATE_CLASS_REPORT,       /**< Results of the sensing nodes */
+    ESPNOW_RATE_CLASS_CONTROL,      /**< Commands and configuration */
+    ESPNOW_RATE_CLASS_MAX,
+} espnow_rate_class_t;
+
+typedef struct {
+    wifi_phy_mode_t phymode;        /**< WIFI_PHY_MODE_HT20 or WIFI_PHY_MODE_HT40 adapts, others keep the fallback rate */
+    wifi_phy_mode_t sensing_phymode; /**< PHY mode of the sensing frames, for their airtime */
+    wifi_phy_rate_t sensing_rate;   /**< Rate of the sensing frames, for their airtime */
+    wifi_phy_rate_t fallback_rate;  /**< Rate of broadcasts and of peers not heard yet */
+    int8_t rssi_margin;             /**< dB above the sensitivity of an MCS before it is used */
+    uint8_t window;                 /**< Frames per delivery window */
+    uint8_t step_down_percent;      /**< Delivery below which a peer drops one step */
+    uint8_t step_up_percent;        /**< Delivery at or above which it may climb one step */
+    uint32_t hold_ms;               /**< After a drop, time before the rate climbs again */
+} espnow_rate_config_t;
+
+#define ESPNOW_RATE_CONFIG_DEFAULT() { \
+    .phymode = WIFI_PHY_MODE_HT20, \
+    .sensing_phymode = WIFI_PHY_MODE_HT20, \
+    .sensing_rate = WIFI_PHY_RATE_MCS0_LGI, \
+    .fallback_rate = WIFI_PHY_RATE_MCS0_LGI, \
+    .rssi_margin = 10, \
+    .window = 10, \
+    .step_down_percent = 80, \
+    .step_up_percent = 95, \
+    .hold_ms = 10000, \
+}
+
+typedef struct {
+    uint32_t frames;
+    uint64_t bytes;                 /**< Payload bytes */
+    uint64_t airtime_us;            /**< Estimated time on the air */
+} espnow_rate_class_stats_t;
+
+typedef struct {
+    espnow_rate_class_stats_t classes[ESPNOW_RATE_CLASS_MAX];
+    uint32_t elapsed_ms;            /**< Since the previous reset */
+    uint32_t rate_changes;          /**< Rates applied to a peer */
+} espnow_rate_stats_t;
+
+typedef struct {
+    wifi_phy_rate_t rate;           /**< Rate the next frame goes out at */
+    int8_t rssi;                    /**< Average RSSI of the frames heard from the peer, 0 if none */
+    uint8_t delivery_percent;       /**< Acknowledged share of the last complete window, 100 before the first */
+    uint32_t sent;
+    uint32_t failed;                /**< Frames never acknowledged */
+} espnow_rate_peer_stats_t;
+
+/**
+ * @brief Start the rate selection and the airtime accounting
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if config is NULL, the window is 0 or the percentages are not ordered
+ */
+esp_err_t espnow_rate_init(const espnow_rate_config_t *config);
+
+/**
+ * @brief Note the RSSI of a frame heard from a peer, from the ESP-NOW receive callback
+ *
+ * The first frame of a MAC adds it to the table, as long as there is room.
+ */
+void espnow_rate_rx(const uint8_t *mac, int8_t rssi);
+
+/**
+ * @brief Note whether a unicast frame was acknowledged, from the ESP-NOW send callback
+ */
+void espnow_rate_tx_done(const uint8_t *mac, bool success);
+
+/**
+ * @brief Add the airtime of a frame sent or heard outside espnow_rate_send(), e.g. a sensing frame
+ */
+void espnow_rate_account(espnow_rate_class_t traffic_class, wifi_phy_rate_t rate, size_t len, bool unicast);
+
+/**
+ * @brief esp_now_send() at the rate of the peer, counted in a class
+ *
+ * A unicast peer that is new, or whose rate changed, gets its rate with
+ * esp_now_set_peer_rate_config() first; it must already be an ESP-NOW peer.
+ *
+ * @return The result of esp_now_send()
+ */
+esp_err_t espnow_rate_send(const uint8_t *mac, espnow_rate_class_t traffic_class, const uint8_t *data, size_t len);
+
+/**
+ * @brief Copy the per-class counters, optionally starting them over
+ */
+void espnow_rate_get_stats(espnow_rate_stats_t *stats, bool reset);
+
+/**
+ * @brief Copy the state of one peer
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the MAC is not in the table
+ */
+esp_err_t espnow_rate_get_peer(const uint8_t *mac, espnow_rate_peer_stats_t *peer);
+
+/**
+ * @brief Estimated airtime of one frame
+ *
+ * @param len     Payload bytes
+ * @param unicast Adds the acknowledgement
+ */
+uint32_t espnow_rate_airtime_us(wifi_phy_mode_t phymode, wifi_phy_rate_t rate, size_t len, bool unicast);
+
+/**
+ * @brief Log the airtime share of each class and reset the counters
+ */
+void espnow_rate_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file send_pacer.h
+ * @brief Timer-driven ESP-NOW transmit scheduler for CSI senders
+ *
+ * Packets are sent from a periodic esp_timer on a fixed time grid, so the send
+ * time and errors of one packet never shift the next one. Each packet carries
+ * its slot number as a uint32_t; a slot that could not be served leaves a gap
+ * in the numbering instead of delaying the following packets.
+ *
+ * A duty cycle restricts sending to the first burst_slots of every
+ * cycle_slots slots. The slot numbers keep running, so a receiver that heard
+ * one packet knows when the next burst starts.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEND_PACER_MAX_FREQUENCY    20000   /**< esp_timer periods are at least 50 us */
+
+typedef struct {
+    uint32_t frequency;         /**< Packets per second */
+    uint8_t peer_addr[6];       /**< ESP-NOW peer, already added with esp_now_add_peer() */
+    uint8_t max_in_flight;      /**< Skip a slot while this many sends wait for their send callback */
+    uint8_t retry_max;          /**< Retries of a slot when the ESP-NOW queue is full */
+    uint32_t retry_delay_us;    /**< Delay before each retry, retries stop at half a period */
+} send_pacer_config_t;
+
+#define SEND_PACER_CONFIG_DEFAULT(freq) { \
+    .frequency = (freq), \
+    .peer_addr = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff}, \
+    .max_in_flight = 2, \
+    .retry_max = 3, \
+    .retry_delay_us = 200, \
+}
+
+typedef struct {
+    uint32_t slots;             /**< Slots elapsed */
+    uint32_t sent;              /**< Packets accepted by esp_now_send() */
+    uint32_t send_ok;           /**< Send callbacks reporting success */
+    uint32_t send_fail;         /**< Send callbacks reporting failure */
+    uint32_t missed;            /**< Slots the timer callback came too late for */
+    uint32_t busy;              /**< Slots skipped because max_in_flight sends were pending */
+    uint32_t retries;           /**< Queue-full retries */
+    uint32_t dropped;           /**< Slots given up after the queue stayed full */
+    uint32_t idle;              /**< Slots outside the bursts of the duty cycle */
+    uint32_t jitter_avg_us;     /**< Mean |interval - period| between consecutive packets */
+    uint32_t jitter_max_us;     /**< Largest |interval - period| between consecutive packets */
+    float rate;                 /**< Achieved packets per second */
+} send_pacer_stats_t;
+
+/**
+ * @brief Register the send callback and start sending
+ *
+ * @note Takes over esp_now_register_send_cb()
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the frequency is 0 or above SEND_PACER_MAX_FREQUENCY
+ *      - ESP_ERR_INVALID_STATE if the pacer is already running
+ *      - Error codes of esp_timer_create() and esp_now_register_send_cb()
+ */
+esp_err_t send_pacer_start(const send_pacer_config_t *config);
+
+/**
+ * @brief Send only the first burst_slots of every cycle_slots slots, from the next slot on
+ *
+ * @param cycle_slots 0 or burst_slots >= cycle_slots sends every slot again
+ */
+void send_pacer_set_duty(uint16_t cycle_slots, uint16_t burst_slots);
+
+/**
+ * @brief Get the statistics since the start or the last reset
+ *
+ * @param stats Filled with the counters, jitter and achieved rate
+ * @param reset Start a new measurement interval
+ */
+void send_pacer_get_stats(send_pacer_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file settings_store.h
+ * @brief Versioned, CRC-protected settings blob in NVS with coalesced writes
+ *
+ * The application keeps its settings in one plain struct. settings_store_save()
+ * only copies it; a low-priority task writes the latest copy once no change
+ * arrived for debounce_ms, or at the latest max_delay_ms after the first
+ * pending change, and skips the write if the content equals what is in flash.
+ * A burst of changes, e.g. dragging a slider, costs one flash write.
+ *
+ * The blob starts with a header holding the layout version, the payload length
+ * and a CRC32 over both and the payload. Older layouts and settings stored
+ * before this module existed are converted by the migrate callback.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "nvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SETTINGS_STORE_VERSION_LEGACY   0   /**< No blob, the settings are in separate keys or absent */
+
+/**
+ * @brief Convert stored settings of another layout to the current one
+ *
+ * @param handle   Open read-only handle of the namespace, to read legacy keys
+ * @param version  Layout version of blob, SETTINGS_STORE_VERSION_LEGACY if there is no blob
+ * @param blob     Stored payload, NULL for SETTINGS_STORE_VERSION_LEGACY
+ * @param len      Payload length
+ * @param settings Current layout, holds the defaults on entry
+ *
+ * @return true if settings were filled and should be written in the current layout
+ */
+typedef bool (*settings_store_migrate_t)(nvs_handle_t handle, uint16_t version, const void *blob, size_t len,
+                                         void *settings);
+
+typedef struct {
+    const char *nvs_namespace;
+    const char *key;
+    uint16_t version;                   /**< Current layout, bump on any change of the struct */
+    size_t size;                        /**< sizeof() the settings struct */
+    uint32_t debounce_ms;               /**< Quiet time before a pending change is written */
+    uint32_t max_delay_ms;              /**< Longest a change may stay pending during continuous changes */
+    settings_store_migrate_t migrate;   /**< May be NULL, other layouts are then ignored */
+} settings_store_config_t;
+
+#define SETTINGS_STORE_CONFIG_DEFAULT() { \
+    .nvs_namespace = "settings", \
+    .key = "settings", \
+    .version = 1, \
+    .size = 0, \
+    .debounce_ms = 2000, \
+    .max_delay_ms = 10000, \
+    .migrate = NULL, \
+}
+
+typedef struct {
+    uint32_t saves;             /**< settings_store_save() calls */
+    uint32_t writes;            /**< Blobs committed to flash */
+    uint32_t unchanged;         /**< Pending changes dropped because flash already held them */
+    uint32_t errors;            /**< Failed writes, retried with the next change or flush */
+} settings_store_stats_t;
+
+/**
+ * @brief Load the settings and start the writer task
+ *
+ * settings must hold the defaults, they are kept if nothing valid is stored.
+ * A blob with a bad CRC is treated as missing.
+ *
+ * @return
+ *      - ESP_OK on success, also when defaults are used
+ *      - ESP_ERR_INVALID_ARG if the config is incomplete
+ *      - ESP_ERR_INVALID_STATE if already initialized
+ *      - ESP_ERR_NO_MEM if the buffers or the task could not be allocated
+ */
+esp_err_t settings_store_init(const settings_store_config_t *config, void *settings);
+
+/**
+ * @brief Schedule a write of the settings, returns at once
+ *
+ * Safe from any task, also from the Wi-Fi task.
+ */
+void settings_store_save(const void *settings);
+
+/**
+ * @brief Write a pending change now and wait for it
+ *
+ * @return
+ *      - ESP_OK if nothing was pending or the write succeeded
+ *      - Error codes of the NVS functions
+ */
+esp_err_t settings_store_flush(void);
+
+/**
+ * @brief Copy the counters
+ */
+void settings_store_get_stats(settings_store_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
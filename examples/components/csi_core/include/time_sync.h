@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file time_sync.h
+ * @brief Reference-broadcast clock sync between receivers of the same CSI sender
+ *
+ * Every receiver hears each sender packet at practically the same instant, so
+ * the local arrival times of one packet sequence number, taken on two nodes,
+ * form a (remote, local) pair of the same event. time_sync_update() feeds such
+ * pairs into an alpha-beta filter that tracks the offset and drift of the
+ * remote clock; afterwards any remote timestamp can be moved to the local
+ * timebase with time_sync_to_local(). No sync traffic is added, the remote
+ * node only has to forward the arrival time of a recent packet.
+ *
+ * All times are microseconds. A time_sync_t is not thread safe.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIME_SYNC_LOCK_PAIRS        16      /**< Pairs before the estimate is trusted */
+#define TIME_SYNC_ALPHA             0.05f   /**< Offset gain once locked */
+#define TIME_SYNC_MAX_DRIFT_PPM     200     /**< Crystal tolerance of both nodes, the estimate is clamped to it */
+#define TIME_SYNC_OUTLIER_MIN_US    500     /**< Prediction errors below this are never outliers */
+#define TIME_SYNC_OUTLIER_RESET     8       /**< Consecutive outliers that restart the estimate */
+
+#define TIME_SYNC_BEACON_HISTORY    32      /**< Sender packets remembered by time_sync_beacons_t, power of two */
+
+typedef struct {
+    int64_t ref_remote_us;      /**< Remote time of the last accepted pair */
+    double offset_us;           /**< Local minus remote time at ref_remote_us */
+    double drift;               /**< Offset change per remote microsecond */
+    float residual_us;          /**< Mean absolute prediction error */
+    uint32_t pairs;             /**< Accepted pairs since the last restart */
+    uint32_t outliers;          /**< Rejected pairs */
+    uint8_t outlier_run;
+} time_sync_t;
+
+typedef struct {
+    uint32_t seq;
+    int64_t local_us;
+} time_sync_beacon_t;
+
+/**
+ * @brief Local arrival times of the latest sender packets, indexed by sequence number
+ */
+typedef struct {
+    time_sync_beacon_t entries[TIME_SYNC_BEACON_HISTORY];     /**< local_us is 0 in unused entries */
+} time_sync_beacons_t;
+
+/**
+ * @brief Forget all pairs
+ */
+void time_sync_init(time_sync_t *sync);
+
+/**
+ * @brief Feed the remote and local time of the same event
+ *
+ * Pairs must come in increasing remote time, older or duplicate ones are ignored.
+ */
+void time_sync_update(time_sync_t *sync, int64_t remote_us, int64_t local_us);
+
+/**
+ * @brief Whether enough pairs were accepted for the conversions to be meaningful
+ */
+bool time_sync_locked(const time_sync_t *sync);
+
+/**
+ * @brief Convert a remote time to the local timebase
+ */
+int64_t time_sync_to_local(const time_sync_t *sync, int64_t remote_us);
+
+/**
+ * @brief Extend a wrapping 32-bit remote microsecond counter to 64 bits
+ *
+ * Uses the last accepted pair as reference, valid while the value is within
+ * 35 minutes of it.
+ */
+int64_t time_sync_extend32(const time_sync_t *sync, uint32_t remote_us);
+
+/**
+ * @brief Drift of the remote clock relative to the local one in ppm, positive if the local clock is faster
+ */
+float time_sync_drift_ppm(const time_sync_t *sync);
+
+/**
+ * @brief Record the local arrival time of a sender packet
+ */
+void time_sync_beacon_put(time_sync_beacons_t *beacons, uint32_t seq, int64_t local_us);
+
+/**
+ * @brief Look up the local arrival time of a sender packet
+ *
+ * @return false if the packet was not heard or is older than TIME_SYNC_BEACON_HISTORY packets
+ */
+bool time_sync_beacon_find(const time_sync_beacons_t *beacons, uint32_t seq, int64_t *local_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file uart_link.h
+ * @brief Framed, CRC-checked, batched csi_data_t link between esp-crab slave_recv and master_recv
+ *
+ * Frame layout (little endian):
+ *
+ *     | 0xA5 0x5A | seq (1) | count (1) | len (2) | count * csi_data_t | crc16 (2) |
+ *
+ * len is the payload length in bytes and must equal count * sizeof(csi_data_t).
+ * The CRC is esp_rom_crc16_le() over seq, count, len and the payload. The
+ * sequence number increments once per frame so the receiver can count lost
+ * frames; after a CRC or length error the parser resynchronizes on the next
+ * sync word.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UART_LINK_SYNC_0            0xA5
+#define UART_LINK_SYNC_1            0x5A
+#define UART_LINK_HEADER_LEN        6
+#define UART_LINK_CRC_LEN           2
+#define UART_LINK_MAX_RECORDS       8
+/**
+ * @brief One CIR record of the link
+ */
+typedef struct {
+    uint8_t start[2];
+    uint32_t id;
+    int64_t time_delta;
+    float cir[4];
+    uint8_t end[2];
+} __attribute__((packed)) csi_data_t;
+
+#define UART_LINK_MAX_FRAME_LEN     (UART_LINK_HEADER_LEN + UART_LINK_MAX_RECORDS * sizeof(csi_data_t) + UART_LINK_CRC_LEN)
+
+typedef struct {
+    uint32_t frames;        /**< Frames with a valid CRC */
+    uint32_t records;       /**< Records delivered to the callback */
+    uint32_t crc_errors;    /**< Frames dropped on CRC mismatch */
+    uint32_t length_errors; /**< Headers with an impossible length or count */
+    uint32_t lost_frames;   /**< Frames missing according to the sequence number */
+    uint32_t resync_bytes;  /**< Bytes skipped while looking for a sync word */
+} uart_link_stats_t;
+
+/**
+ * @brief Batches records into one frame
+ */
+typedef struct {
+    uint8_t frame[UART_LINK_MAX_FRAME_LEN];
+    uint8_t count;
+    uint8_t seq;
+} uart_link_encoder_t;
+
+/**
+ * @brief Append one record to the pending frame
+ *
+ * @return true when the frame is full and must be sent with uart_link_encoder_finish()
+ */
+bool uart_link_encoder_add(uart_link_encoder_t *enc, const csi_data_t *record);
+
+/**
+ * @brief Close the pending frame (header + CRC) and start a new one
+ *
+ * @param[out] frame Start of the encoded frame, valid until the next encoder call
+ *
+ * @return Frame length in bytes, 0 if no record was pending
+ */
+size_t uart_link_encoder_finish(uart_link_encoder_t *enc, const uint8_t **frame);
+
+/**
+ * @brief Called for every record of a valid frame; the record points into the parser buffer
+ */
+typedef void (*uart_link_record_cb_t)(const csi_data_t *record, void *ctx);
+
+/**
+ * @brief Streaming frame parser
+ *
+ * Bytes are read straight into the parser buffer (uart_link_parser_get_buffer()
+ * + uart_link_parser_commit()), frames split across reads are kept until complete,
+ * and records are handed to the callback without an intermediate copy.
+ */
+typedef struct {
+    uint8_t buf[2 * UART_LINK_MAX_FRAME_LEN];
+    size_t len;
+    bool seq_valid;
+    uint8_t next_seq;
+    uart_link_record_cb_t cb;
+    void *ctx;
+    uart_link_stats_t stats;
+} uart_link_parser_t;
+
+void uart_link_parser_init(uart_link_parser_t *parser, uart_link_record_cb_t cb, void *ctx);
+
+/**
+ * @brief Free space at the end of the parser buffer
+ *
+ * @param[out] space Number of bytes that may be written
+ */
+uint8_t *uart_link_parser_get_buffer(uart_link_parser_t *parser, size_t *space);
+
+/**
+ * @brief Account for bytes written into the buffer and decode every complete frame
+ */
+void uart_link_parser_commit(uart_link_parser_t *parser, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_frame_ring.c
+ * @brief Preallocated CSI frame pool with a single-producer/single-consumer ring
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "csi_attr.h"
+#include "csi_mem.h"
+#include "csi_frame_ring.h"
+
+static const char *TAG = "csi_frame_ring";
+
+#define RING_SLOT(ring, index) ((ring)->pool + ((index) & ((ring)->capacity - 1)) * (ring)->slot_size)
+
+esp_err_t csi_frame_ring_init(csi_frame_ring_t *ring, size_t slot_size, uint32_t capacity)
+{
+    if (!ring || !slot_size || !capacity || (capacity & (capacity - 1))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(ring, 0, sizeof(csi_frame_ring_t));
+    ring->pool = csi_mem_calloc(CSI_MEM_HOT, capacity, slot_size, "csi_frame_ring");
+    /* Dropped frames keep their token until the consumer absorbs it, hence 2x */
+    ring->ready = xSemaphoreCreateCounting(2 * capacity, 0);
+
+    if (!ring->pool || !ring->ready) {
+        ESP_LOGE(TAG, "Failed to allocate %u x %u byte frame pool", (unsigned)capacity, (unsigned)slot_size);
+        csi_mem_free(ring->pool);
+        if (ring->ready) {
+            vSemaphoreDelete(ring->ready);
+        }
+        memset(ring, 0, sizeof(csi_frame_ring_t));
+        return ESP_ERR_NO_MEM;
+    }
+
+    ring->slot_size = slot_size;
+    ring->capacity  = capacity;
+
+    return ESP_OK;
+}
+
+void *CSI_HOT_ATTR csi_frame_ring_acquire(csi_frame_ring_t *ring)
+{
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (ring->head - tail >= ring->capacity) {
+        ring->stats.overruns++;
+        return NULL;
+    }
+
+    return RING_SLOT(ring, ring->head);
+}
+
+void CSI_HOT_ATTR csi_frame_ring_commit(csi_frame_ring_t *ring)
+{
+    uint32_t head    = ring->head + 1;
+    uint32_t pending = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (pending > ring->stats.high_water) {
+        ring->stats.high_water = pending;
+    }
+
+    ring->stats.committed++;
+    __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+    xSemaphoreGive(ring->ready);
+}
+
+void *csi_frame_ring_receive(csi_frame_ring_t *ring, TickType_t ticks_to_wait)
+{
+    while (xSemaphoreTake(ring->ready, ticks_to_wait) == pdTRUE) {
+        if (__atomic_exchange_n(&ring->flush_pending, 0, __ATOMIC_ACQUIRE)) {
+            uint32_t mark = __atomic_load_n(&ring->flush_mark, __ATOMIC_ACQUIRE);
+            uint32_t drop = mark - ring->tail;
+
+            if (drop && drop <= ring->capacity) {
+                ring->stats.flushed += drop;
+                __atomic_store_n(&ring->tail, mark, __ATOMIC_RELEASE);
+            }
+        }
+
+        /* A token whose frame was flushed finds the ring empty, wait for the next one */
+        if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) != ring->tail) {
+            return RING_SLOT(ring, ring->tail);
+        }
+    }
+
+    return NULL;
+}
+
+void csi_frame_ring_release(csi_frame_ring_t *ring)
+{
+    ring->stats.released++;
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+void CSI_HOT_ATTR csi_frame_ring_flush(csi_frame_ring_t *ring)
+{
+    __atomic_store_n(&ring->flush_mark, __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->flush_pending, 1, __ATOMIC_RELEASE);
+}
+
+uint32_t csi_frame_ring_count(const csi_frame_ring_t *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+void csi_frame_ring_get_stats(const csi_frame_ring_t *ring, csi_frame_ring_stats_t *stats)
+{
+    *stats = ring->stats;
+}
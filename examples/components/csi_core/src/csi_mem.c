@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_mem.c
+ * @brief Where the CSI buffers go: internal RAM for the packet path, PSRAM for the bulk
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "csi_mem.h"
+
+#define CSI_MEM_NOTED       CSI_MEM_CLASS_MAX   /* Class of the entries of csi_mem_note() */
+#define CSI_MEM_REGION_NUM  5
+
+static const char *TAG = "csi_mem";
+
+static const char *const s_class_names[] = {
+    [CSI_MEM_HOT]   = "hot",
+    [CSI_MEM_DMA]   = "dma",
+    [CSI_MEM_BULK]  = "bulk",
+    [CSI_MEM_NOTED] = "static",
+};
+
+static const char *const s_region_names[CSI_MEM_REGION_NUM] = {"iram", "dram", "psram", "flash", "?"};
+
+typedef struct {
+    const char *name;
+    const void *ptr;
+    uint32_t size;
+    uint8_t mem_class;
+} csi_mem_entry_t;
+
+static csi_mem_entry_t s_map[CSI_MEM_MAP_MAX];
+static uint8_t s_map_num;
+static bool s_map_full_logged;
+static portMUX_TYPE s_map_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int csi_mem_region_index(const void *ptr)
+{
+    if (esp_ptr_external_ram(ptr)) {
+        return 2;
+    } else if (esp_ptr_in_dram(ptr)) {
+        return 1;
+    } else if (esp_ptr_in_iram(ptr)) {
+        return 0;
+    } else if (esp_ptr_in_drom(ptr) || esp_ptr_executable(ptr)) {
+        return 3;
+    }
+
+    return 4;
+}
+
+const char *csi_mem_region(const void *ptr)
+{
+    return s_region_names[csi_mem_region_index(ptr)];
+}
+
+static void csi_mem_map_add(const char *name, const void *ptr, size_t size, uint8_t mem_class)
+{
+    bool added = false;
+
+    portENTER_CRITICAL(&s_map_lock);
+    if (s_map_num < CSI_MEM_MAP_MAX) {
+        s_map[s_map_num++] = (csi_mem_entry_t) {
+            .name = name, .ptr = ptr, .size = size, .mem_class = mem_class,
+        };
+        added = true;
+    }
+    portEXIT_CRITICAL(&s_map_lock);
+
+    if (!added && !s_map_full_logged) {
+        s_map_full_logged = true;
+        ESP_LOGW(TAG, "Map full, %s and later entries are not shown", name);
+    }
+}
+
+void *csi_mem_calloc(csi_mem_class_t mem_class, size_t num, size_t size, const char *name)
+{
+    void *ptr = NULL;
+
+    switch (mem_class) {
+    case CSI_MEM_HOT:
+        ptr = heap_caps_calloc(num, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        break;
+
+    case CSI_MEM_DMA:
+        ptr = heap_caps_calloc(num, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+        break;
+
+    case CSI_MEM_BULK:
+#if CONFIG_CSI_MEM_BULK_PSRAM
+        ptr = heap_caps_calloc_prefer(num, size, 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+                                      MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        ptr = heap_caps_calloc(num, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+        break;
+
+    default:
+        return NULL;
+    }
+
+    if (!ptr) {
+        ESP_LOGE(TAG, "No %s memory for %s, %u bytes", s_class_names[mem_class], name, (unsigned)(num * size));
+        return NULL;
+    }
+
+    csi_mem_map_add(name, ptr, num * size, mem_class);
+
+    return ptr;
+}
+
+void csi_mem_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_map_lock);
+    for (int i = 0; i < s_map_num; i++) {
+        if (s_map[i].ptr == ptr && s_map[i].mem_class != CSI_MEM_NOTED) {
+            /* Shifted rather than swapped, the map stays in allocation order */
+            memmove(&s_map[i], &s_map[i + 1], (--s_map_num - i) * sizeof(csi_mem_entry_t));
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_map_lock);
+
+    heap_caps_free(ptr);
+}
+
+void csi_mem_note(const char *name, const void *ptr, size_t size)
+{
+    if (ptr) {
+        csi_mem_map_add(name, ptr, size, CSI_MEM_NOTED);
+    }
+}
+
+void csi_mem_log_map(void)
+{
+    uint32_t region_bytes[CSI_MEM_REGION_NUM] = {0};
+    csi_mem_entry_t entry;
+
+#if CONFIG_CSI_HOT_PATH_IN_FLASH
+    ESP_LOGI(TAG, "Per-frame path in flash");
+#else
+    ESP_LOGI(TAG, "Per-frame path in IRAM");
+#endif
+    ESP_LOGI(TAG, "%-20s %-6s %-5s %8s %10s", "buffer", "class", "mem", "bytes", "address");
+
+    for (int i = 0; i < CSI_MEM_MAP_MAX; i++) {
+        bool valid;
+
+        portENTER_CRITICAL(&s_map_lock);
+        valid = i < s_map_num;
+        if (valid) {
+            entry = s_map[i];
+        }
+        portEXIT_CRITICAL(&s_map_lock);
+
+        if (!valid) {
+            break;
+        }
+
+        int region = csi_mem_region_index(entry.ptr);
+        region_bytes[region] += entry.size;
+
+        if (entry.size) {
+            ESP_LOGI(TAG, "%-20s %-6s %-5s %8lu %10p", entry.name, s_class_names[entry.mem_class],
+                     s_region_names[region], (unsigned long)entry.size, entry.ptr);
+        } else {
+            ESP_LOGI(TAG, "%-20s %-6s %-5s %8s %10p", entry.name, "code", s_region_names[region], "-", entry.ptr);
+        }
+    }
+
+    for (int r = 0; r < CSI_MEM_REGION_NUM - 1; r++) {
+        if (region_bytes[r]) {
+            ESP_LOGI(TAG, "%-5s %8lu bytes in the map", s_region_names[r], (unsigned long)region_bytes[r]);
+        }
+    }
+
+    ESP_LOGI(TAG, "Free: internal %u (largest %u), DMA %u (largest %u), PSRAM %u (largest %u)",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_DMA),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_DMA),
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+}
@@ -0,0 +1,203 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_perf.c
+ * @brief Fixed-memory latency histograms for the stages of the CSI pipeline
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "csi_perf.h"
+
+/* Bucket i >= 4 starts at (4 + i % 4) << (i / 4 - 1), values below 4 have one bucket each */
+#define CSI_PERF_BUCKET_MAX_US  ((uint32_t)(8 << (CSI_PERF_BUCKETS / 4 - 1)) - 1)
+
+static const char *TAG = "csi_perf";
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t drops;
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t buckets[CSI_PERF_BUCKETS];
+} csi_perf_stage_info_t;
+
+static csi_perf_stage_info_t s_stages[CSI_PERF_STAGE_MAX];
+static uint8_t s_stage_num = 0;
+static portMUX_TYPE s_perf_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t csi_perf_bucket(uint32_t us)
+{
+    if (us < 4) {
+        return us;
+    }
+
+    if (us > CSI_PERF_BUCKET_MAX_US) {
+        return CSI_PERF_BUCKETS - 1;
+    }
+
+    uint32_t msb = 31 - __builtin_clz(us);
+    return (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+}
+
+static uint32_t csi_perf_bucket_upper(uint32_t bucket)
+{
+    if (bucket < 4) {
+        return bucket;
+    }
+
+    return ((5 + bucket % 4) << (bucket / 4 - 1)) - 1;
+}
+
+csi_perf_stage_t csi_perf_register(const char *name)
+{
+    csi_perf_stage_t stage = CSI_PERF_STAGE_NONE;
+
+    portENTER_CRITICAL(&s_perf_lock);
+    for (int i = 0; i < s_stage_num; i++) {
+        if (!strcmp(s_stages[i].name, name)) {
+            stage = i;
+            break;
+        }
+    }
+
+    if (stage == CSI_PERF_STAGE_NONE && s_stage_num < CSI_PERF_STAGE_MAX) {
+        stage = s_stage_num++;
+        s_stages[stage].name = name;
+    }
+    portEXIT_CRITICAL(&s_perf_lock);
+
+    if (stage == CSI_PERF_STAGE_NONE) {
+        ESP_LOGW(TAG, "No room for stage %s", name);
+    }
+
+    return stage;
+}
+
+void csi_perf_record(csi_perf_stage_t stage, uint32_t duration_us)
+{
+    if (stage >= CSI_PERF_STAGE_MAX) {
+        return;
+    }
+
+    csi_perf_stage_info_t *info = &s_stages[stage];
+    uint32_t bucket = csi_perf_bucket(duration_us);
+
+    portENTER_CRITICAL(&s_perf_lock);
+    info->count++;
+    info->sum_us += duration_us;
+    info->buckets[bucket]++;
+    if (duration_us > info->max_us) {
+        info->max_us = duration_us;
+    }
+    portEXIT_CRITICAL(&s_perf_lock);
+}
+
+void csi_perf_drop(csi_perf_stage_t stage)
+{
+    if (stage >= CSI_PERF_STAGE_MAX) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_perf_lock);
+    s_stages[stage].drops++;
+    portEXIT_CRITICAL(&s_perf_lock);
+}
+
+uint8_t csi_perf_stage_num(void)
+{
+    return s_stage_num;
+}
+
+bool csi_perf_get(csi_perf_stage_t stage, csi_perf_summary_t *summary)
+{
+    csi_perf_stage_info_t copy;
+
+    if (stage >= s_stage_num) {
+        return false;
+    }
+
+    memset(summary, 0, sizeof(csi_perf_summary_t));
+
+    portENTER_CRITICAL(&s_perf_lock);
+    copy = s_stages[stage];
+    portEXIT_CRITICAL(&s_perf_lock);
+
+    const csi_perf_stage_info_t *info = &copy;
+    summary->name = info->name;
+    summary->count = info->count;
+    summary->drops = info->drops;
+    summary->max_us = info->max_us;
+
+    if (info->count) {
+        uint32_t *percentiles[] = { &summary->p50_us, &summary->p90_us, &summary->p99_us };
+        const uint32_t ranks[] = {
+            (info->count + 1) / 2, (info->count * 9 + 9) / 10, (info->count * 99 + 99) / 100,
+        };
+        uint32_t seen = 0;
+        int next = 0;
+
+        summary->mean_us = info->sum_us / info->count;
+
+        for (int i = 0; i < CSI_PERF_BUCKETS && next < 3; i++) {
+            seen += info->buckets[i];
+            while (next < 3 && seen >= ranks[next]) {
+                *percentiles[next++] = MIN(csi_perf_bucket_upper(i), info->max_us);
+            }
+        }
+    }
+
+    return true;
+}
+
+void csi_perf_reset(void)
+{
+    portENTER_CRITICAL(&s_perf_lock);
+    for (int i = 0; i < s_stage_num; i++) {
+        const char *name = s_stages[i].name;
+        memset(&s_stages[i], 0, sizeof(csi_perf_stage_info_t));
+        s_stages[i].name = name;
+    }
+    portEXIT_CRITICAL(&s_perf_lock);
+}
+
+void csi_perf_print(void)
+{
+    csi_perf_summary_t summary;
+
+    ESP_LOGI(TAG, "%-16s %10s %8s %8s %8s %8s %8s %8s", "stage", "count", "drops", "mean", "p50", "p90", "p99", "max");
+
+    for (int i = 0; csi_perf_get(i, &summary); i++) {
+        ESP_LOGI(TAG, "%-16s %10u %8u %8u %8u %8u %8u %8u", summary.name, summary.count, summary.drops,
+                 summary.mean_us, summary.p50_us, summary.p90_us, summary.p99_us, summary.max_us);
+    }
+}
+
+int csi_perf_json(char *buf, size_t size)
+{
+    csi_perf_summary_t summary;
+    int len = snprintf(buf, size, "{\"uptime_ms\":%llu,\"stages\":[", (unsigned long long)(esp_timer_get_time() / 1000));
+
+    for (int i = 0; (size_t)len < size && csi_perf_get(i, &summary); i++) {
+        len += snprintf(buf + len, size - len,
+                        "%s{\"name\":\"%s\",\"count\":%u,\"drops\":%u,\"mean_us\":%u,"
+                        "\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,\"max_us\":%u}",
+                        i ? "," : "", summary.name, (unsigned)summary.count, (unsigned)summary.drops,
+                        (unsigned)summary.mean_us, (unsigned)summary.p50_us, (unsigned)summary.p90_us,
+                        (unsigned)summary.p99_us, (unsigned)summary.max_us);
+    }
+
+    if ((size_t)len < size) {
+        len += snprintf(buf + len, size - len, "]}");
+    }
+
+    return MIN(len, (int)size - 1);
+}
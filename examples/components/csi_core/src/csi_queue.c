@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_queue.c
+ * @brief FreeRTOS queue with an overflow policy and overflow accounting
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "esp_log.h"
+#include "esp_idf_version.h"
+#include "esp_heap_caps.h"
+#include "csi_queue.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#include "freertos/idf_additions.h"
+#endif
+
+static const char *TAG = "csi_queue";
+
+esp_err_t csi_queue_init(csi_queue_t *queue, const csi_queue_config_t *config)
+{
+    if (!queue || !config || !config->name || !config->length || !config->item_size
+            || (config->policy == CSI_QUEUE_DROP_OLDEST && config->item_size > CSI_QUEUE_ITEM_MAX)
+            || (config->policy == CSI_QUEUE_DECIMATE && !config->decimate_ratio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(queue, 0, sizeof(csi_queue_t));
+    queue->config = *config;
+    portMUX_INITIALIZE(&queue->lock);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    /* Sent to on the packet path, kept out of PSRAM whatever the malloc threshold */
+    queue->handle = xQueueCreateWithCaps(config->length, config->item_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    queue->handle = xQueueCreate(config->length, config->item_size);
+#endif
+
+    if (!queue->handle) {
+        ESP_LOGE(TAG, "Failed to allocate queue %s, %u x %u bytes", config->name,
+                 (unsigned)config->length, (unsigned)config->item_size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+bool csi_queue_send(csi_queue_t *queue, const void *item)
+{
+    const csi_queue_config_t *config = &queue->config;
+    uint32_t waiting = uxQueueMessagesWaiting(queue->handle);
+    bool sent = false;
+
+    if (config->policy == CSI_QUEUE_DECIMATE && waiting >= config->decimate_level) {
+        bool skip;
+
+        portENTER_CRITICAL(&queue->lock);
+        skip = queue->decimate_count++ % config->decimate_ratio;
+        queue->stats.decimated += skip;
+        portEXIT_CRITICAL(&queue->lock);
+
+        if (skip) {
+            return false;
+        }
+    }
+
+    sent = xQueueSend(queue->handle, item, 0) == pdTRUE;
+
+    /* Make room by discarding the head; another sender may take the room first, so give up after two tries */
+    if (!sent && config->policy == CSI_QUEUE_DROP_OLDEST) {
+        uint8_t oldest[CSI_QUEUE_ITEM_MAX];
+
+        for (int i = 0; i < 2 && !sent; i++) {
+            if (xQueueReceive(queue->handle, oldest, 0) == pdTRUE) {
+                portENTER_CRITICAL(&queue->lock);
+                queue->stats.dropped_oldest++;
+                portEXIT_CRITICAL(&queue->lock);
+            }
+
+            sent = xQueueSend(queue->handle, item, 0) == pdTRUE;
+        }
+    }
+
+    waiting = uxQueueMessagesWaiting(queue->handle);
+
+    portENTER_CRITICAL(&queue->lock);
+    if (sent) {
+        queue->stats.sent++;
+    } else {
+        queue->stats.dropped_newest++;
+    }
+    if (waiting > queue->stats.high_water) {
+        queue->stats.high_water = waiting;
+    }
+    portEXIT_CRITICAL(&queue->lock);
+
+    return sent;
+}
+
+bool csi_queue_receive(csi_queue_t *queue, void *item, TickType_t ticks_to_wait)
+{
+    if (xQueueReceive(queue->handle, item, ticks_to_wait) != pdTRUE) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&queue->lock);
+    queue->stats.received++;
+    portEXIT_CRITICAL(&queue->lock);
+
+    return true;
+}
+
+uint32_t csi_queue_count(const csi_queue_t *queue)
+{
+    return uxQueueMessagesWaiting(queue->handle);
+}
+
+void csi_queue_get_stats(csi_queue_t *queue, csi_queue_stats_t *stats)
+{
+    portENTER_CRITICAL(&queue->lock);
+    *stats = queue->stats;
+    portEXIT_CRITICAL(&queue->lock);
+}
+
+uint32_t csi_queue_drops(const csi_queue_stats_t *stats)
+{
+    return stats->dropped_newest + stats->dropped_oldest + stats->decimated;
+}
+
+int csi_queue_json(csi_queue_t *queue, char *buf, size_t size)
+{
+    csi_queue_stats_t stats;
+
+    csi_queue_get_stats(queue, &stats);
+    int len = snprintf(buf, size, "{\"name\":\"%s\",\"length\":%u,\"waiting\":%u,\"high_water\":%u,\"sent\":%u,"
+                       "\"received\":%u,\"dropped_newest\":%u,\"dropped_oldest\":%u,\"decimated\":%u}",
+                       queue->config.name, (unsigned)queue->config.length, (unsigned)csi_queue_count(queue),
+                       (unsigned)stats.high_water, (unsigned)stats.sent, (unsigned)stats.received,
+                       (unsigned)stats.dropped_newest, (unsigned)stats.dropped_oldest, (unsigned)stats.decimated);
+
+    return MIN(len, (int)size - 1);
+}
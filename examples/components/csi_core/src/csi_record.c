@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_record.c
+ * @brief Compact binary CSI record written to the console UART
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "driver/uart.h"
+#include "csi_record.h"
+
+#define CSI_RECORD_UART_TX_BUF_SIZE     (8 * 1024)
+#define CSI_RECORD_UART_RX_BUF_SIZE     256
+
+static const char *TAG = "csi_record";
+
+esp_err_t csi_record_output_init(void)
+{
+#if CONFIG_ESP_CONSOLE_UART
+    /**
+     * @brief With a TX ring buffer uart_write_bytes() only copies the record,
+     *        the Wi-Fi task no longer waits for the bytes to leave the FIFO
+     */
+    if (!uart_is_driver_installed(CONFIG_ESP_CONSOLE_UART_NUM)) {
+        esp_err_t ret = uart_driver_install(CONFIG_ESP_CONSOLE_UART_NUM, CSI_RECORD_UART_RX_BUF_SIZE,
+                                            CSI_RECORD_UART_TX_BUF_SIZE, 0, NULL, 0);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "<%s> uart_driver_install", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+#endif
+
+    return ESP_OK;
+}
+
+static void csi_record_write(const uint8_t *data, size_t len)
+{
+#if CONFIG_ESP_CONSOLE_UART
+    uart_write_bytes(CONFIG_ESP_CONSOLE_UART_NUM, data, len);
+#else
+    fwrite(data, 1, len, stdout);
+    fflush(stdout);
+#endif
+}
+
+size_t csi_record_build(uint8_t *record, uint32_t seq, const wifi_csi_info_t *info, int8_t fft_gain,
+                        uint8_t agc_gain, float compensate_gain, bool lltf_12bit)
+{
+    csi_record_header_t *header = (csi_record_header_t *)record;
+    const wifi_pkt_rx_ctrl_t *rx_ctrl = &info->rx_ctrl;
+
+    /* The last two bytes of a 12-bit LLTF buffer are padding, same as the CSV output */
+    uint16_t len = lltf_12bit ? MAX(info->len - 2, 0) : info->len;
+    len = MIN(len, CSI_RECORD_MAX_DATA_LEN);
+
+    header->magic[0]           = CSI_RECORD_MAGIC_0;
+    header->magic[1]           = CSI_RECORD_MAGIC_1;
+    header->version            = CSI_RECORD_VERSION;
+    header->flags              = lltf_12bit ? CSI_RECORD_FLAG_LLTF_12BIT : 0;
+    header->len                = len;
+    header->seq                = seq;
+    header->local_timestamp    = rx_ctrl->timestamp;
+    memcpy(header->mac, info->mac, sizeof(header->mac));
+    header->rssi               = rx_ctrl->rssi;
+    header->rate               = rx_ctrl->rate;
+    header->noise_floor        = rx_ctrl->noise_floor;
+    header->fft_gain           = fft_gain;
+    header->agc_gain           = agc_gain;
+    header->channel            = rx_ctrl->channel;
+    header->sig_len            = rx_ctrl->sig_len;
+    header->rx_state           = rx_ctrl->rx_state;
+    header->first_word_invalid = info->first_word_invalid;
+    header->compensate_gain    = compensate_gain;
+    memcpy(record + sizeof(csi_record_header_t), info->buf, len);
+
+    return sizeof(csi_record_header_t) + len;
+}
+
+void csi_record_output(uint32_t seq, const wifi_csi_info_t *info, int8_t fft_gain, uint8_t agc_gain,
+                       float compensate_gain, bool lltf_12bit)
+{
+    /* Only called from the Wi-Fi task, one buffer is enough */
+    static uint8_t s_record[CSI_RECORD_MAX_LEN];
+
+    csi_record_write(s_record, csi_record_build(s_record, seq, info, fft_gain, agc_gain, compensate_gain, lltf_12bit));
+}
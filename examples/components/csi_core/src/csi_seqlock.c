@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_seqlock.c
+ * @brief Lock-free publication of records from one writer task to any number of readers
+ */
+
+#include <string.h>
+#include "csi_seqlock.h"
+
+#define TABLE_SLOT(table, id)   ((table)->slots + ((id) & (table)->mask) * (table)->slot_size)
+
+void csi_seqlock_write(csi_seqlock_t *lock, void *dst, const void *src, size_t size)
+{
+    uint32_t seq = lock->seq;
+
+    __atomic_store_n(&lock->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dst, src, size);
+    __atomic_store_n(&lock->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+bool csi_seqlock_read(const csi_seqlock_t *lock, void *dst, const void *src, size_t size, uint32_t *torn_reads)
+{
+    for (int i = 0; i < CSI_SEQLOCK_READ_RETRY; i++) {
+        uint32_t seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+
+        if (!(seq & 1)) {
+            memcpy(dst, src, size);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (__atomic_load_n(&lock->seq, __ATOMIC_RELAXED) == seq) {
+                return true;
+            }
+        }
+
+        if (torn_reads) {
+            __atomic_fetch_add(torn_reads, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return false;
+}
+
+esp_err_t csi_seqlock_table_init(csi_seqlock_table_t *table, uint32_t *storage, size_t record_size, uint32_t capacity)
+{
+    if (!table || !storage || !record_size || !capacity || (capacity & (capacity - 1))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(table, 0, sizeof(csi_seqlock_table_t));
+    table->slots = (uint8_t *)storage;
+    table->record_size = record_size;
+    table->slot_size = CSI_SEQLOCK_SLOT_SIZE(record_size);
+    table->mask = capacity - 1;
+    memset(storage, 0, capacity * table->slot_size);
+
+    return ESP_OK;
+}
+
+void csi_seqlock_table_publish(csi_seqlock_table_t *table, uint32_t id, const void *record)
+{
+    uint8_t *slot = TABLE_SLOT(table, id);
+
+    csi_seqlock_write((csi_seqlock_t *)slot, slot + sizeof(csi_seqlock_t), record, table->record_size);
+    table->published++;
+}
+
+bool csi_seqlock_table_read(csi_seqlock_table_t *table, uint32_t id, void *record)
+{
+    const uint8_t *slot = TABLE_SLOT(table, id);
+
+    return csi_seqlock_read((const csi_seqlock_t *)slot, record, slot + sizeof(csi_seqlock_t), table->record_size,
+                            &table->torn_reads);
+}
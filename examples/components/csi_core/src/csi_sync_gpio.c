@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_sync_gpio.c
+ * @brief Falling edge of a shared sync line restarts the CSI time base
+ */
+
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "csi_sync_gpio.h"
+
+static const char *TAG = "csi_sync_gpio";
+
+static csi_sync_gpio_config_t s_config;
+
+static void IRAM_ATTR csi_sync_gpio_isr(void *arg)
+{
+    if (s_config.ring) {
+        csi_frame_ring_flush(s_config.ring);
+    }
+
+    *s_config.time_zero = esp_timer_get_time();
+}
+
+esp_err_t csi_sync_gpio_init(const csi_sync_gpio_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config && config->time_zero, ESP_ERR_INVALID_ARG, TAG, "No time zero");
+
+    s_config = *config;
+
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_NEGEDGE,
+        .mode = GPIO_MODE_INPUT,
+        .pin_bit_mask = 1ULL << config->gpio_num,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+    };
+    ESP_RETURN_ON_ERROR(gpio_config(&io_conf), TAG, "GPIO %d", config->gpio_num);
+
+    esp_err_t ret = gpio_install_isr_service(0);
+
+    /* Installed already by another driver */
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        return ret;
+    }
+
+    ESP_RETURN_ON_ERROR(gpio_isr_handler_add(config->gpio_num, csi_sync_gpio_isr, NULL), TAG, "ISR");
+    ESP_LOGI(TAG, "GPIO %d configured with negative edge interrupt.", config->gpio_num);
+
+    return ESP_OK;
+}
@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_wifi.c
+ * @brief Station and ESP-NOW bring-up of the CSI examples, one per-target ladder for all
+ */
+
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_mac.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "channel_survey.h"
+#include "csi_wifi.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
+#define ESP_IF_WIFI_STA ESP_MAC_WIFI_STA
+#endif
+
+#if CONFIG_IDF_TARGET_ESP32C5
+#define CSI_WIFI_BANDS      2
+#elif (CONFIG_IDF_TARGET_ESP32C6 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)) || CONFIG_IDF_TARGET_ESP32C61
+#define CSI_WIFI_BANDS      1
+#else
+#define CSI_WIFI_BANDS      0   /**< Single bandwidth call, no band mode */
+#endif
+
+static const char *TAG = "csi_wifi";
+
+wifi_second_chan_t csi_wifi_second_chan(uint8_t channel, wifi_bandwidth_t bandwidth)
+{
+    if (bandwidth == WIFI_BW_HT20) {
+        return WIFI_SECOND_CHAN_NONE;
+    }
+
+    bool above = channel <= 14 ? channel_survey_second_above(channel) : (channel / 4) % 2;
+
+    return above ? WIFI_SECOND_CHAN_ABOVE : WIFI_SECOND_CHAN_BELOW;
+}
+
+esp_err_t csi_wifi_init(const csi_wifi_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(config, ESP_ERR_INVALID_ARG, TAG, "No config");
+
+    ESP_RETURN_ON_ERROR(esp_event_loop_create_default(), TAG, "Event loop");
+    ESP_RETURN_ON_ERROR(esp_netif_init(), TAG, "Netif");
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_RETURN_ON_ERROR(esp_wifi_init(&cfg), TAG, "Wi-Fi init");
+    ESP_RETURN_ON_ERROR(esp_wifi_set_mode(WIFI_MODE_STA), TAG, "Mode");
+    ESP_RETURN_ON_ERROR(esp_wifi_set_storage(WIFI_STORAGE_RAM), TAG, "Storage");
+
+#if CSI_WIFI_BANDS
+    ESP_RETURN_ON_ERROR(esp_wifi_start(), TAG, "Start");
+    esp_wifi_set_band_mode(config->channel > 14 ? WIFI_BAND_MODE_5G_ONLY : WIFI_BAND_MODE_2G_ONLY);
+
+    wifi_protocols_t protocols = {
+        .ghz_2g = WIFI_PROTOCOL_11N,
+#if CSI_WIFI_BANDS == 2
+        .ghz_5g = WIFI_PROTOCOL_11N,
+#endif
+    };
+    ESP_RETURN_ON_ERROR(esp_wifi_set_protocols(ESP_IF_WIFI_STA, &protocols), TAG, "Protocols");
+
+    wifi_bandwidths_t bandwidths = {
+        .ghz_2g = config->bandwidth,
+#if CSI_WIFI_BANDS == 2
+        .ghz_5g = config->bandwidth,
+#endif
+    };
+    ESP_RETURN_ON_ERROR(esp_wifi_set_bandwidths(ESP_IF_WIFI_STA, &bandwidths), TAG, "Bandwidths");
+#else
+    ESP_RETURN_ON_ERROR(esp_wifi_set_bandwidth(ESP_IF_WIFI_STA, config->bandwidth), TAG, "Bandwidth");
+    ESP_RETURN_ON_ERROR(esp_wifi_start(), TAG, "Start");
+#endif
+
+    ESP_RETURN_ON_ERROR(esp_wifi_set_ps(WIFI_PS_NONE), TAG, "Power save");
+
+    wifi_second_chan_t second = config->bandwidth == WIFI_BW_HT20 ? WIFI_SECOND_CHAN_NONE : config->second;
+
+    if (config->bandwidth != WIFI_BW_HT20 && second == WIFI_SECOND_CHAN_NONE) {
+        second = csi_wifi_second_chan(config->channel, config->bandwidth);
+    }
+
+    ESP_RETURN_ON_ERROR(esp_wifi_set_channel(config->channel, second), TAG, "Channel %d", config->channel);
+
+    if (config->mac) {
+        ESP_RETURN_ON_ERROR(esp_wifi_set_mac(WIFI_IF_STA, config->mac), TAG, "MAC");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t csi_wifi_esp_now_init(const esp_now_peer_info_t *peer, wifi_phy_mode_t phymode, wifi_phy_rate_t rate)
+{
+    ESP_RETURN_ON_FALSE(peer, ESP_ERR_INVALID_ARG, TAG, "No peer");
+
+    ESP_RETURN_ON_ERROR(esp_now_init(), TAG, "ESP-NOW init");
+    ESP_RETURN_ON_ERROR(esp_now_set_pmk((uint8_t *)"pmk1234567890123"), TAG, "PMK");
+    ESP_RETURN_ON_ERROR(esp_now_add_peer(peer), TAG, "Peer");
+
+    esp_now_rate_config_t rate_config = {
+        .phymode = phymode,
+        .rate = rate,
+        .ersu = false,
+        .dcm = false
+    };
+
+    return esp_now_set_peer_rate_config(peer->peer_addr, &rate_config);
+}
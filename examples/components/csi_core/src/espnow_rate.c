@@ -0,0 +1,364 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file espnow_rate.c
+ * @brief Per-peer ESP-NOW rate selection and airtime accounting per traffic class
+ */
+
+#include <string.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "espnow_rate.h"
+
+#define ESPNOW_RATE_RSSI_SHIFT      3       /* The RSSI average moves 1/8 of the way per frame */
+#define ESPNOW_RATE_STEP_NONE       -1      /* No rate applied to the peer yet */
+#define ESPNOW_RATE_STEP_FALLBACK   -2      /* The fallback rate is applied */
+
+/* HT20 MCS, long guard interval, and the typical sensitivity of each */
+static const wifi_phy_rate_t s_ladder[] = {
+    WIFI_PHY_RATE_MCS0_LGI, WIFI_PHY_RATE_MCS1_LGI, WIFI_PHY_RATE_MCS2_LGI, WIFI_PHY_RATE_MCS3_LGI,
+    WIFI_PHY_RATE_MCS4_LGI, WIFI_PHY_RATE_MCS5_LGI, WIFI_PHY_RATE_MCS6_LGI, WIFI_PHY_RATE_MCS7_LGI,
+};
+static const int8_t s_sensitivity_dbm[] = {-93, -90, -88, -85, -81, -77, -75, -74};
+
+#define ESPNOW_RATE_STEP_NUM        (int)(sizeof(s_ladder) / sizeof(s_ladder[0]))
+
+typedef struct {
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    bool used;
+    bool heard;
+    int16_t rssi_avg;           /* dBm << ESPNOW_RATE_RSSI_SHIFT */
+    uint8_t step;               /* Index in s_ladder */
+    int8_t applied_step;        /* Step set with esp_now_set_peer_rate_config() */
+    uint8_t window_sent;
+    uint8_t window_ok;
+    uint8_t delivery_percent;
+    uint32_t sent;
+    uint32_t failed;
+    int64_t hold_until_us;
+} espnow_rate_peer_t;
+
+static const char *TAG = "espnow_rate";
+
+static espnow_rate_config_t s_config;
+static bool s_adaptive;
+static espnow_rate_peer_t s_peers[ESPNOW_RATE_PEER_MAX];
+static espnow_rate_stats_t s_stats;
+static int64_t s_stats_start_us;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t espnow_rate_kbps(wifi_phy_rate_t rate)
+{
+    switch (rate) {
+    case WIFI_PHY_RATE_1M_L:        return 1000;
+    case WIFI_PHY_RATE_2M_L:
+    case WIFI_PHY_RATE_2M_S:        return 2000;
+    case WIFI_PHY_RATE_5M_L:
+    case WIFI_PHY_RATE_5M_S:        return 5500;
+    case WIFI_PHY_RATE_11M_L:
+    case WIFI_PHY_RATE_11M_S:       return 11000;
+    case WIFI_PHY_RATE_6M:          return 6000;
+    case WIFI_PHY_RATE_9M:          return 9000;
+    case WIFI_PHY_RATE_12M:         return 12000;
+    case WIFI_PHY_RATE_18M:         return 18000;
+    case WIFI_PHY_RATE_24M:         return 24000;
+    case WIFI_PHY_RATE_36M:         return 36000;
+    case WIFI_PHY_RATE_48M:         return 48000;
+    case WIFI_PHY_RATE_54M:         return 54000;
+    default:
+        break;
+    }
+
+    if (rate >= WIFI_PHY_RATE_MCS0_LGI && rate <= WIFI_PHY_RATE_MCS7_LGI) {
+        static const uint32_t s_mcs_kbps[] = {6500, 13000, 19500, 26000, 39000, 52000, 58500, 65000};
+        return s_mcs_kbps[rate - WIFI_PHY_RATE_MCS0_LGI];
+    }
+
+    if (rate >= WIFI_PHY_RATE_MCS0_SGI && rate <= WIFI_PHY_RATE_MCS7_SGI) {
+        static const uint32_t s_mcs_kbps[] = {7200, 14400, 21700, 28900, 43300, 57800, 65000, 72200};
+        return s_mcs_kbps[rate - WIFI_PHY_RATE_MCS0_SGI];
+    }
+
+    return 1000;
+}
+
+uint32_t espnow_rate_airtime_us(wifi_phy_mode_t phymode, wifi_phy_rate_t rate, size_t len, bool unicast)
+{
+    uint32_t kbps = espnow_rate_kbps(rate);
+    uint32_t preamble_us;
+
+    if (rate >= WIFI_PHY_RATE_MCS0_LGI && rate <= WIFI_PHY_RATE_MCS7_SGI) {
+        preamble_us = 36;   /* HT mixed format */
+        kbps = phymode == WIFI_PHY_MODE_HT40 ? 2 * kbps + kbps / 13 : kbps;
+    } else if (kbps >= 6000 && kbps != 11000) {
+        preamble_us = 20;   /* OFDM */
+    } else {
+        preamble_us = rate == WIFI_PHY_RATE_2M_S || rate == WIFI_PHY_RATE_5M_S || rate == WIFI_PHY_RATE_11M_S ? 96 : 192;
+    }
+
+    return preamble_us + (uint32_t)((len + ESPNOW_RATE_FRAME_OVERHEAD) * 8 * 1000 / kbps)
+           + (unicast ? ESPNOW_RATE_ACK_US : 0);
+}
+
+static inline bool espnow_rate_is_unicast(const uint8_t *mac)
+{
+    return !(mac[0] & 0x01);
+}
+
+/* Under s_lock */
+static espnow_rate_peer_t *espnow_rate_find(const uint8_t *mac, bool add)
+{
+    espnow_rate_peer_t *free_peer = NULL;
+
+    for (int i = 0; i < ESPNOW_RATE_PEER_MAX; i++) {
+        if (!s_peers[i].used) {
+            free_peer = free_peer ? free_peer : &s_peers[i];
+        } else if (!memcmp(s_peers[i].mac, mac, ESP_NOW_ETH_ALEN)) {
+            return &s_peers[i];
+        }
+    }
+
+    if (!add || !free_peer) {
+        return NULL;
+    }
+
+    *free_peer = (espnow_rate_peer_t) {
+        .used = true,
+        .applied_step = ESPNOW_RATE_STEP_NONE,
+        .delivery_percent = 100,
+    };
+    memcpy(free_peer->mac, mac, ESP_NOW_ETH_ALEN);
+    return free_peer;
+}
+
+/* Fastest step the RSSI allows with the margin */
+static uint8_t espnow_rate_rssi_step(const espnow_rate_peer_t *peer)
+{
+    int rssi = peer->rssi_avg >> ESPNOW_RATE_RSSI_SHIFT;
+    uint8_t step = 0;
+
+    while (step + 1 < ESPNOW_RATE_STEP_NUM && rssi >= s_sensitivity_dbm[step + 1] + s_config.rssi_margin) {
+        step++;
+    }
+
+    return step;
+}
+
+static wifi_phy_rate_t espnow_rate_peer_rate(const espnow_rate_peer_t *peer)
+{
+    return s_adaptive && peer && peer->heard ? s_ladder[peer->step] : s_config.fallback_rate;
+}
+
+esp_err_t espnow_rate_init(const espnow_rate_config_t *config)
+{
+    if (!config || !config->window || config->step_down_percent > config->step_up_percent
+            || config->step_up_percent > 100) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_config = *config;
+    s_adaptive = config->phymode == WIFI_PHY_MODE_HT20 || config->phymode == WIFI_PHY_MODE_HT40;
+    memset(s_peers, 0, sizeof(s_peers));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats_start_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+void espnow_rate_rx(const uint8_t *mac, int8_t rssi)
+{
+    if (!espnow_rate_is_unicast(mac)) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    espnow_rate_peer_t *peer = espnow_rate_find(mac, true);
+
+    if (peer) {
+        if (!peer->heard) {
+            peer->rssi_avg = rssi << ESPNOW_RATE_RSSI_SHIFT;
+            peer->heard = true;
+            peer->step = espnow_rate_rssi_step(peer);
+        } else {
+            peer->rssi_avg += rssi - (peer->rssi_avg >> ESPNOW_RATE_RSSI_SHIFT);
+        }
+
+        /* A weaker link drops at once, a stronger one climbs through the delivery windows */
+        peer->step = MIN(peer->step, espnow_rate_rssi_step(peer));
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void espnow_rate_tx_done(const uint8_t *mac, bool success)
+{
+    if (!espnow_rate_is_unicast(mac)) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    espnow_rate_peer_t *peer = espnow_rate_find(mac, false);
+
+    if (peer) {
+        peer->window_sent++;
+        peer->window_ok += success;
+        peer->failed += !success;
+
+        if (peer->window_sent >= s_config.window) {
+            peer->delivery_percent = peer->window_ok * 100 / peer->window_sent;
+            peer->window_sent = 0;
+            peer->window_ok = 0;
+
+            if (peer->delivery_percent < s_config.step_down_percent) {
+                peer->step = peer->step ? peer->step - 1 : 0;
+                peer->hold_until_us = now_us + (int64_t)s_config.hold_ms * 1000;
+            } else if (peer->delivery_percent >= s_config.step_up_percent && now_us >= peer->hold_until_us
+                       && peer->heard && peer->step < espnow_rate_rssi_step(peer)) {
+                peer->step++;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void espnow_rate_account(espnow_rate_class_t traffic_class, wifi_phy_rate_t rate, size_t len, bool unicast)
+{
+    if (traffic_class >= ESPNOW_RATE_CLASS_MAX) {
+        return;
+    }
+
+    wifi_phy_mode_t phymode = traffic_class == ESPNOW_RATE_CLASS_SENSING ? s_config.sensing_phymode : s_config.phymode;
+    uint32_t airtime_us = espnow_rate_airtime_us(phymode, rate, len, unicast);
+
+    portENTER_CRITICAL(&s_lock);
+    espnow_rate_class_stats_t *stats = &s_stats.classes[traffic_class];
+    stats->frames++;
+    stats->bytes += len;
+    stats->airtime_us += airtime_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t espnow_rate_send(const uint8_t *mac, espnow_rate_class_t traffic_class, const uint8_t *data, size_t len)
+{
+    bool unicast = espnow_rate_is_unicast(mac);
+    wifi_phy_rate_t rate = traffic_class == ESPNOW_RATE_CLASS_SENSING ? s_config.sensing_rate : s_config.fallback_rate;
+    int8_t step = ESPNOW_RATE_STEP_NONE;
+    bool apply = false;
+
+    if (unicast && traffic_class != ESPNOW_RATE_CLASS_SENSING) {
+        portENTER_CRITICAL(&s_lock);
+        espnow_rate_peer_t *peer = espnow_rate_find(mac, true);
+
+        if (peer) {
+            rate = espnow_rate_peer_rate(peer);
+            step = s_adaptive && peer->heard ? peer->step : ESPNOW_RATE_STEP_FALLBACK;
+            apply = peer->applied_step != step;
+            peer->sent++;
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+
+    if (apply) {
+        esp_now_rate_config_t rate_config = {
+            .phymode = s_config.phymode,
+            .rate = rate,
+            .ersu = false,
+            .dcm = false,
+        };
+        esp_err_t ret = esp_now_set_peer_rate_config(mac, &rate_config);
+
+        portENTER_CRITICAL(&s_lock);
+        espnow_rate_peer_t *peer = espnow_rate_find(mac, false);
+
+        if (peer && ret == ESP_OK) {
+            peer->applied_step = step;
+            s_stats.rate_changes++;
+        }
+        portEXIT_CRITICAL(&s_lock);
+
+        if (ret != ESP_OK) {
+            ESP_LOGD(TAG, "Rate of " MACSTR ": %s", MAC2STR(mac), esp_err_to_name(ret));
+        }
+    }
+
+    esp_err_t ret = esp_now_send(mac, data, len);
+
+    if (ret == ESP_OK) {
+        espnow_rate_account(traffic_class, rate, len, unicast);
+    }
+
+    return ret;
+}
+
+void espnow_rate_get_stats(espnow_rate_stats_t *stats, bool reset)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->elapsed_ms = (now_us - s_stats_start_us) / 1000;
+
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+        s_stats_start_us = now_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t espnow_rate_get_peer(const uint8_t *mac, espnow_rate_peer_stats_t *stats)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    portENTER_CRITICAL(&s_lock);
+    const espnow_rate_peer_t *peer = espnow_rate_find(mac, false);
+
+    if (peer) {
+        *stats = (espnow_rate_peer_stats_t) {
+            .rate = espnow_rate_peer_rate(peer),
+            .rssi = peer->heard ? peer->rssi_avg >> ESPNOW_RATE_RSSI_SHIFT : 0,
+            .delivery_percent = peer->delivery_percent,
+            .sent = peer->sent,
+            .failed = peer->failed,
+        };
+        ret = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return ret;
+}
+
+void espnow_rate_log_stats(void)
+{
+    static const char *const s_class_names[ESPNOW_RATE_CLASS_MAX] = {"sensing", "report", "control"};
+    espnow_rate_stats_t stats;
+
+    espnow_rate_get_stats(&stats, true);
+
+    if (!stats.elapsed_ms) {
+        return;
+    }
+
+    for (int i = 0; i < ESPNOW_RATE_CLASS_MAX; i++) {
+        const espnow_rate_class_stats_t *class_stats = &stats.classes[i];
+
+        if (class_stats->frames) {
+            ESP_LOGI(TAG, "Airtime %s: %lu frames, %llu bytes, %.2f%% of %lu ms", s_class_names[i],
+                     (unsigned long)class_stats->frames, (unsigned long long)class_stats->bytes,
+                     class_stats->airtime_us / (stats.elapsed_ms * 10.0), (unsigned long)stats.elapsed_ms);
+        }
+    }
+
+    if (stats.rate_changes) {
+        ESP_LOGI(TAG, "Peer rates changed %lu times", (unsigned long)stats.rate_changes);
+    }
+}
@@ -0,0 +1,263 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file send_pacer.c
+ * @brief Timer-driven ESP-NOW transmit scheduler for CSI senders
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_now.h"
+#include "esp_idf_version.h"
+#include "send_pacer.h"
+
+static const char *TAG = "send_pacer";
+
+typedef struct {
+    send_pacer_config_t config;
+    int64_t period_us;
+    int64_t start_us;           /* Time of slot 0 */
+    int64_t stats_start_us;
+    int64_t last_send_us;
+    uint32_t last_send_slot;
+    uint32_t slot;              /* Slot being served, the first one is 1 */
+    uint8_t retry_count;
+    bool retry_pending;
+    uint32_t in_flight;         /* Sends waiting for their send callback */
+    uint32_t duty;              /* cycle_slots << 16 | burst_slots, 0 sends every slot */
+    uint64_t jitter_sum_us;
+    uint32_t jitter_num;
+    send_pacer_stats_t stats;
+    esp_timer_handle_t period_timer;
+    esp_timer_handle_t retry_timer;
+} send_pacer_t;
+
+/* The timers run in the esp_timer task, the send callback in the Wi-Fi task */
+static send_pacer_t s_pacer;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void pacer_try_send(int64_t now)
+{
+    send_pacer_t *pacer = &s_pacer;
+
+    if (__atomic_load_n(&pacer->in_flight, __ATOMIC_RELAXED) >= pacer->config.max_in_flight) {
+        portENTER_CRITICAL(&s_stats_lock);
+        pacer->stats.busy++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return;
+    }
+
+    esp_err_t ret = esp_now_send(pacer->config.peer_addr, (const uint8_t *)&pacer->slot, sizeof(pacer->slot));
+
+    if (ret == ESP_OK) {
+        __atomic_add_fetch(&pacer->in_flight, 1, __ATOMIC_RELAXED);
+
+        portENTER_CRITICAL(&s_stats_lock);
+        pacer->stats.sent++;
+        if (pacer->last_send_us && pacer->slot == pacer->last_send_slot + 1) {
+            uint32_t jitter = llabs(now - pacer->last_send_us - pacer->period_us);
+            pacer->jitter_sum_us += jitter;
+            pacer->jitter_num++;
+            if (jitter > pacer->stats.jitter_max_us) {
+                pacer->stats.jitter_max_us = jitter;
+            }
+        }
+        portEXIT_CRITICAL(&s_stats_lock);
+
+        pacer->last_send_us = now;
+        pacer->last_send_slot = pacer->slot;
+        return;
+    }
+
+    /* Retry a full queue while the packet is still closer to its own slot than to the next one */
+    int64_t slot_us = pacer->start_us + (int64_t)pacer->slot * pacer->period_us;
+    if (ret == ESP_ERR_ESPNOW_NO_MEM && pacer->retry_count < pacer->config.retry_max
+            && now + pacer->config.retry_delay_us - slot_us < pacer->period_us / 2) {
+        pacer->retry_count++;
+        pacer->retry_pending = esp_timer_start_once(pacer->retry_timer, pacer->config.retry_delay_us) == ESP_OK;
+        if (pacer->retry_pending) {
+            portENTER_CRITICAL(&s_stats_lock);
+            pacer->stats.retries++;
+            portEXIT_CRITICAL(&s_stats_lock);
+            return;
+        }
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    pacer->stats.dropped++;
+    portEXIT_CRITICAL(&s_stats_lock);
+    ESP_LOGD(TAG, "<%s> slot %lu dropped", esp_err_to_name(ret), (unsigned long)pacer->slot);
+}
+
+/* Slots come from the time grid, not from counting callbacks, so a late callback cannot shift later packets */
+static void pacer_period_cb(void *arg)
+{
+    send_pacer_t *pacer = &s_pacer;
+    int64_t now = esp_timer_get_time();
+    uint32_t slot = (now - pacer->start_us + pacer->period_us / 2) / pacer->period_us;
+
+    if (slot <= pacer->slot) {
+        return;
+    }
+
+    if (pacer->retry_pending) {
+        esp_timer_stop(pacer->retry_timer);
+        pacer->retry_pending = false;
+        portENTER_CRITICAL(&s_stats_lock);
+        pacer->stats.dropped++;
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    pacer->stats.slots += slot - pacer->slot;
+    pacer->stats.missed += slot - pacer->slot - 1;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    pacer->slot = slot;
+    pacer->retry_count = 0;
+
+    uint32_t duty = __atomic_load_n(&pacer->duty, __ATOMIC_RELAXED);
+    if (duty && slot % (duty >> 16) >= (duty & 0xffff)) {
+        portENTER_CRITICAL(&s_stats_lock);
+        pacer->stats.idle++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return;
+    }
+
+    pacer_try_send(now);
+}
+
+static void pacer_retry_cb(void *arg)
+{
+    if (s_pacer.retry_pending) {
+        s_pacer.retry_pending = false;
+        pacer_try_send(esp_timer_get_time());
+    }
+}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void pacer_send_cb(const esp_now_send_info_t *tx_info, esp_now_send_status_t status)
+#else
+static void pacer_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status)
+#endif
+{
+    send_pacer_t *pacer = &s_pacer;
+    uint32_t in_flight = __atomic_load_n(&pacer->in_flight, __ATOMIC_RELAXED);
+
+    /* Never wrap, even for a callback of a send made before the pacer started */
+    while (in_flight && !__atomic_compare_exchange_n(&pacer->in_flight, &in_flight, in_flight - 1,
+                                                     true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    if (status == ESP_NOW_SEND_SUCCESS) {
+        pacer->stats.send_ok++;
+    } else {
+        pacer->stats.send_fail++;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+esp_err_t send_pacer_start(const send_pacer_config_t *config)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (!config || !config->frequency || config->frequency > SEND_PACER_MAX_FREQUENCY) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_pacer.period_timer) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(&s_pacer, 0, sizeof(s_pacer));
+    s_pacer.config = *config;
+    s_pacer.config.max_in_flight = config->max_in_flight ? config->max_in_flight : 1;
+    s_pacer.period_us = 1000 * 1000 / config->frequency;
+
+    const esp_timer_create_args_t period_args = {
+        .callback = pacer_period_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "send_pacer",
+        .skip_unhandled_events = true,
+    };
+    const esp_timer_create_args_t retry_args = {
+        .callback = pacer_retry_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "send_retry",
+    };
+
+    ret = esp_timer_create(&retry_args, &s_pacer.retry_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> esp_timer_create", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = esp_timer_create(&period_args, &s_pacer.period_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> esp_timer_create", esp_err_to_name(ret));
+        goto err;
+    }
+
+    ret = esp_now_register_send_cb(pacer_send_cb);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> esp_now_register_send_cb", esp_err_to_name(ret));
+        goto err;
+    }
+
+    s_pacer.start_us = esp_timer_get_time();
+    s_pacer.stats_start_us = s_pacer.start_us;
+
+    ret = esp_timer_start_periodic(s_pacer.period_timer, s_pacer.period_us);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> esp_timer_start_periodic", esp_err_to_name(ret));
+        esp_now_unregister_send_cb();
+        goto err;
+    }
+
+    ESP_LOGI(TAG, "Sending %lu packets/s, period %lld us", (unsigned long)config->frequency, (long long)s_pacer.period_us);
+    return ESP_OK;
+
+err:
+    if (s_pacer.period_timer) {
+        esp_timer_delete(s_pacer.period_timer);
+        s_pacer.period_timer = NULL;
+    }
+    esp_timer_delete(s_pacer.retry_timer);
+    s_pacer.retry_timer = NULL;
+    return ret;
+}
+
+void send_pacer_set_duty(uint16_t cycle_slots, uint16_t burst_slots)
+{
+    uint32_t duty = cycle_slots && burst_slots < cycle_slots ? (uint32_t)cycle_slots << 16 | burst_slots : 0;
+
+    __atomic_store_n(&s_pacer.duty, duty, __ATOMIC_RELAXED);
+}
+
+void send_pacer_get_stats(send_pacer_stats_t *stats, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_pacer.stats;
+    stats->jitter_avg_us = s_pacer.jitter_num ? s_pacer.jitter_sum_us / s_pacer.jitter_num : 0;
+    int64_t elapsed_us = now - s_pacer.stats_start_us;
+
+    if (reset) {
+        memset(&s_pacer.stats, 0, sizeof(s_pacer.stats));
+        s_pacer.jitter_sum_us = 0;
+        s_pacer.jitter_num = 0;
+        s_pacer.stats_start_us = now;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    stats->rate = elapsed_us > 0 ? stats->sent * 1000000.0f / elapsed_us : 0;
+}
@@ -0,0 +1,309 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file settings_store.c
+ * @brief Versioned, CRC-protected settings blob in NVS with coalesced writes
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "settings_store.h"
+
+#define SETTINGS_STORE_MAGIC        0x31475453  /* "STG1" */
+#define SETTINGS_STORE_TASK_STACK   3072
+#define SETTINGS_STORE_TASK_PRIO    1           /* Below everything that handles CSI */
+
+static const char *TAG = "settings_store";
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t len;               /* Payload length */
+    uint32_t crc;               /* esp_rom_crc32_le() over version, len and the payload */
+} settings_store_header_t;
+
+static struct {
+    settings_store_config_t config;
+    SemaphoreHandle_t lock;     /* Guards pending, dirty, flush_requested and stats */
+    SemaphoreHandle_t flush_lock;
+    SemaphoreHandle_t flush_done;
+    TaskHandle_t task;
+    uint8_t *pending;           /* Latest settings_store_save() */
+    uint8_t *blob;              /* Header and payload being written, writer task only */
+    uint8_t *stored;            /* Payload in flash, writer task only */
+    bool stored_valid;
+    bool dirty;
+    bool flush_requested;
+    esp_err_t flush_result;
+    settings_store_stats_t stats;
+} s_store;
+
+static uint32_t settings_store_crc(const settings_store_header_t *header, const uint8_t *payload)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&header->version, sizeof(header->version) + sizeof(header->len));
+
+    return esp_rom_crc32_le(crc, payload, header->len);
+}
+
+/* Write the latest pending copy if it differs from flash, false in *flush unless a flush asked for it */
+static esp_err_t settings_store_write(bool *flush)
+{
+    settings_store_header_t *header = (settings_store_header_t *)s_store.blob;
+    uint8_t *payload = s_store.blob + sizeof(settings_store_header_t);
+    size_t size = s_store.config.size;
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(s_store.lock, portMAX_DELAY);
+    bool dirty = s_store.dirty;
+    memcpy(payload, s_store.pending, size);
+    s_store.dirty = false;
+    *flush = s_store.flush_requested;
+    s_store.flush_requested = false;
+    xSemaphoreGive(s_store.lock);
+
+    if (!dirty) {
+        return ESP_OK;
+    }
+
+    if (s_store.stored_valid && !memcmp(payload, s_store.stored, size)) {
+        xSemaphoreTake(s_store.lock, portMAX_DELAY);
+        s_store.stats.unchanged++;
+        xSemaphoreGive(s_store.lock);
+        return ESP_OK;
+    }
+
+    header->magic = SETTINGS_STORE_MAGIC;
+    header->version = s_store.config.version;
+    header->len = size;
+    header->crc = settings_store_crc(header, payload);
+
+    nvs_handle_t handle;
+    ret = nvs_open(s_store.config.nvs_namespace, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, s_store.config.key, s_store.blob, sizeof(settings_store_header_t) + size);
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+
+    xSemaphoreTake(s_store.lock, portMAX_DELAY);
+    if (ret == ESP_OK) {
+        s_store.stats.writes++;
+    } else {
+        s_store.stats.errors++;
+        s_store.dirty = true;
+    }
+    xSemaphoreGive(s_store.lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> write %s/%s", esp_err_to_name(ret), s_store.config.nvs_namespace, s_store.config.key);
+        return ret;
+    }
+
+    memcpy(s_store.stored, payload, size);
+    s_store.stored_valid = true;
+    ESP_LOGI(TAG, "Settings saved (%u bytes)", (unsigned)size);
+    return ESP_OK;
+}
+
+static void settings_store_task(void *arg)
+{
+    const TickType_t debounce = MAX(pdMS_TO_TICKS(s_store.config.debounce_ms), 1);
+    const TickType_t max_delay = pdMS_TO_TICKS(s_store.config.max_delay_ms);
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        /* Every further change restarts the quiet time, up to max_delay after the first one */
+        TickType_t first = xTaskGetTickCount();
+        while (!__atomic_load_n(&s_store.flush_requested, __ATOMIC_RELAXED)) {
+            TickType_t elapsed = xTaskGetTickCount() - first;
+            if (elapsed >= max_delay) {
+                break;
+            }
+
+            if (!ulTaskNotifyTake(pdTRUE, MIN(debounce, max_delay - elapsed))) {
+                break;
+            }
+        }
+
+        bool flush = false;
+        esp_err_t ret = settings_store_write(&flush);
+
+        if (flush) {
+            s_store.flush_result = ret;
+            xSemaphoreGive(s_store.flush_done);
+        }
+    }
+}
+
+/* Read and check the blob, NULL if there is none or it is damaged */
+static uint8_t *settings_store_read(nvs_handle_t handle, settings_store_header_t **header)
+{
+    size_t len = 0;
+
+    if (nvs_get_blob(handle, s_store.config.key, NULL, &len) != ESP_OK
+            || len < sizeof(settings_store_header_t) || len > sizeof(settings_store_header_t) + UINT16_MAX) {
+        return NULL;
+    }
+
+    uint8_t *blob = malloc(len);
+    if (!blob) {
+        return NULL;
+    }
+
+    *header = (settings_store_header_t *)blob;
+    if (nvs_get_blob(handle, s_store.config.key, blob, &len) != ESP_OK
+            || (*header)->magic != SETTINGS_STORE_MAGIC
+            || (*header)->len != len - sizeof(settings_store_header_t)
+            || (*header)->crc != settings_store_crc(*header, blob + sizeof(settings_store_header_t))) {
+        ESP_LOGW(TAG, "%s/%s damaged, using defaults", s_store.config.nvs_namespace, s_store.config.key);
+        free(blob);
+        return NULL;
+    }
+
+    return blob;
+}
+
+/* Fill settings from flash, true if they must be written back in the current layout */
+static bool settings_store_load(void *settings)
+{
+    const settings_store_config_t *config = &s_store.config;
+    nvs_handle_t handle;
+    bool migrated = false;
+
+    if (nvs_open(config->nvs_namespace, NVS_READONLY, &handle) != ESP_OK) {
+        ESP_LOGI(TAG, "No saved settings, using defaults");
+        return false;
+    }
+
+    settings_store_header_t *header = NULL;
+    uint8_t *blob = settings_store_read(handle, &header);
+    const uint8_t *payload = blob ? blob + sizeof(settings_store_header_t) : NULL;
+
+    if (blob && header->version == config->version && header->len == config->size) {
+        memcpy(settings, payload, config->size);
+        memcpy(s_store.stored, payload, config->size);
+        s_store.stored_valid = true;
+        ESP_LOGI(TAG, "Settings loaded, layout %u", header->version);
+    } else if (config->migrate) {
+        uint16_t version = blob ? header->version : SETTINGS_STORE_VERSION_LEGACY;
+        migrated = config->migrate(handle, version, payload, blob ? header->len : 0, settings);
+        if (migrated) {
+            ESP_LOGI(TAG, "Settings migrated from layout %u to %u", version, config->version);
+        }
+    }
+
+    free(blob);
+    nvs_close(handle);
+    return migrated;
+}
+
+esp_err_t settings_store_init(const settings_store_config_t *config, void *settings)
+{
+    if (!config || !settings || !config->nvs_namespace || !config->key
+            || !config->size || config->size > UINT16_MAX || config->version == SETTINGS_STORE_VERSION_LEGACY) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_store.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_store.config = *config;
+    s_store.lock = xSemaphoreCreateMutex();
+    s_store.flush_lock = xSemaphoreCreateMutex();
+    s_store.flush_done = xSemaphoreCreateBinary();
+    s_store.pending = malloc(config->size);
+    s_store.stored = malloc(config->size);
+    s_store.blob = malloc(sizeof(settings_store_header_t) + config->size);
+
+    if (!s_store.lock || !s_store.flush_lock || !s_store.flush_done
+            || !s_store.pending || !s_store.stored || !s_store.blob) {
+        goto err;
+    }
+
+    bool migrated = settings_store_load(settings);
+    memcpy(s_store.pending, settings, config->size);
+
+    if (xTaskCreate(settings_store_task, "settings", SETTINGS_STORE_TASK_STACK, NULL,
+                    SETTINGS_STORE_TASK_PRIO, &s_store.task) != pdPASS) {
+        goto err;
+    }
+
+    if (migrated) {
+        s_store.dirty = true;
+        settings_store_flush();
+    }
+
+    return ESP_OK;
+
+err:
+    if (s_store.lock) {
+        vSemaphoreDelete(s_store.lock);
+    }
+    if (s_store.flush_lock) {
+        vSemaphoreDelete(s_store.flush_lock);
+    }
+    if (s_store.flush_done) {
+        vSemaphoreDelete(s_store.flush_done);
+    }
+    free(s_store.pending);
+    free(s_store.stored);
+    free(s_store.blob);
+    memset(&s_store, 0, sizeof(s_store));
+    return ESP_ERR_NO_MEM;
+}
+
+void settings_store_save(const void *settings)
+{
+    if (!s_store.task) {
+        return;
+    }
+
+    xSemaphoreTake(s_store.lock, portMAX_DELAY);
+    memcpy(s_store.pending, settings, s_store.config.size);
+    s_store.dirty = true;
+    s_store.stats.saves++;
+    xSemaphoreGive(s_store.lock);
+
+    xTaskNotifyGive(s_store.task);
+}
+
+esp_err_t settings_store_flush(void)
+{
+    if (!s_store.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_store.flush_lock, portMAX_DELAY);
+
+    xSemaphoreTake(s_store.lock, portMAX_DELAY);
+    s_store.flush_requested = true;
+    xSemaphoreGive(s_store.lock);
+
+    xTaskNotifyGive(s_store.task);
+    xSemaphoreTake(s_store.flush_done, portMAX_DELAY);
+    esp_err_t ret = s_store.flush_result;
+
+    xSemaphoreGive(s_store.flush_lock);
+    return ret;
+}
+
+void settings_store_get_stats(settings_store_stats_t *stats)
+{
+    xSemaphoreTake(s_store.lock, portMAX_DELAY);
+    *stats = s_store.stats;
+    xSemaphoreGive(s_store.lock);
+}
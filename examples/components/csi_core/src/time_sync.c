@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file time_sync.c
+ * @brief Reference-broadcast clock sync between receivers of the same CSI sender
+ */
+
+#include <string.h>
+#include <math.h>
+#include <sys/param.h>
+#include "time_sync.h"
+
+#define TIME_SYNC_MAX_DRIFT     (TIME_SYNC_MAX_DRIFT_PPM * 1e-6)
+
+void time_sync_init(time_sync_t *sync)
+{
+    memset(sync, 0, sizeof(time_sync_t));
+}
+
+void time_sync_update(time_sync_t *sync, int64_t remote_us, int64_t local_us)
+{
+    double measured = (double)(local_us - remote_us);
+
+    if (!sync->pairs) {
+        sync->ref_remote_us = remote_us;
+        sync->offset_us = measured;
+        sync->drift = 0;
+        sync->residual_us = 0;
+        sync->pairs = 1;
+        return;
+    }
+
+    int64_t dt = remote_us - sync->ref_remote_us;
+    if (dt <= 0) {
+        return;
+    }
+
+    double predicted = sync->offset_us + sync->drift * dt;
+    double error = measured - predicted;
+    bool locked = time_sync_locked(sync);
+
+    if (locked && fabs(error) > MAX(TIME_SYNC_OUTLIER_MIN_US, 8 * sync->residual_us)) {
+        sync->outliers++;
+
+        /* A run of outliers means the remote clock jumped, e.g. after a reboot */
+        if (++sync->outlier_run >= TIME_SYNC_OUTLIER_RESET) {
+            uint32_t outliers = sync->outliers;
+            time_sync_init(sync);
+            sync->outliers = outliers;
+            time_sync_update(sync, remote_us, local_us);
+        }
+
+        return;
+    }
+
+    /* Average the first pairs, then follow slowly; beta keeps the filter critically damped */
+    float alpha = locked ? TIME_SYNC_ALPHA : MAX(1.0f / (sync->pairs + 1), TIME_SYNC_ALPHA);
+    float beta = alpha * alpha / (2 - alpha);
+
+    sync->offset_us = predicted + alpha * error;
+    sync->drift = MIN(MAX(sync->drift + beta * error / dt, -TIME_SYNC_MAX_DRIFT), TIME_SYNC_MAX_DRIFT);
+    sync->ref_remote_us = remote_us;
+    sync->residual_us += ((float)fabs(error) - sync->residual_us) / (locked ? 16 : sync->pairs + 1);
+    sync->outlier_run = 0;
+    sync->pairs++;
+}
+
+bool time_sync_locked(const time_sync_t *sync)
+{
+    return sync->pairs >= TIME_SYNC_LOCK_PAIRS;
+}
+
+int64_t time_sync_to_local(const time_sync_t *sync, int64_t remote_us)
+{
+    double offset = sync->offset_us + sync->drift * (remote_us - sync->ref_remote_us);
+
+    return remote_us + (int64_t)llround(offset);
+}
+
+int64_t time_sync_extend32(const time_sync_t *sync, uint32_t remote_us)
+{
+    return sync->ref_remote_us + (int32_t)(remote_us - (uint32_t)sync->ref_remote_us);
+}
+
+float time_sync_drift_ppm(const time_sync_t *sync)
+{
+    return sync->drift * 1e6;
+}
+
+void time_sync_beacon_put(time_sync_beacons_t *beacons, uint32_t seq, int64_t local_us)
+{
+    time_sync_beacon_t *entry = &beacons->entries[seq & (TIME_SYNC_BEACON_HISTORY - 1)];
+
+    entry->seq = seq;
+    entry->local_us = local_us;
+}
+
+bool time_sync_beacon_find(const time_sync_beacons_t *beacons, uint32_t seq, int64_t *local_us)
+{
+    const time_sync_beacon_t *entry = &beacons->entries[seq & (TIME_SYNC_BEACON_HISTORY - 1)];
+
+    if (entry->seq != seq || !entry->local_us) {
+        return false;
+    }
+
+    *local_us = entry->local_us;
+    return true;
+}
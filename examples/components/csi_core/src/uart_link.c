@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file uart_link.c
+ * @brief Framed, CRC-checked, batched csi_data_t link between slave_recv and master_recv
+ */
+
+#include <string.h>
+#include "esp_rom_crc.h"
+#include "uart_link.h"
+
+#define RECORD_SIZE     sizeof(csi_data_t)
+
+bool uart_link_encoder_add(uart_link_encoder_t *enc, const csi_data_t *record)
+{
+    if (enc->count < UART_LINK_MAX_RECORDS) {
+        memcpy(enc->frame + UART_LINK_HEADER_LEN + enc->count * RECORD_SIZE, record, RECORD_SIZE);
+        enc->count++;
+    }
+
+    return enc->count >= UART_LINK_MAX_RECORDS;
+}
+
+size_t uart_link_encoder_finish(uart_link_encoder_t *enc, const uint8_t **frame)
+{
+    if (!enc->count) {
+        return 0;
+    }
+
+    uint16_t payload_len = enc->count * RECORD_SIZE;
+    uint8_t *f = enc->frame;
+
+    f[0] = UART_LINK_SYNC_0;
+    f[1] = UART_LINK_SYNC_1;
+    f[2] = enc->seq++;
+    f[3] = enc->count;
+    f[4] = payload_len & 0xff;
+    f[5] = payload_len >> 8;
+
+    uint16_t crc = esp_rom_crc16_le(0, f + 2, UART_LINK_HEADER_LEN - 2 + payload_len);
+    f[UART_LINK_HEADER_LEN + payload_len]     = crc & 0xff;
+    f[UART_LINK_HEADER_LEN + payload_len + 1] = crc >> 8;
+
+    enc->count = 0;
+    *frame = f;
+
+    return UART_LINK_HEADER_LEN + payload_len + UART_LINK_CRC_LEN;
+}
+
+void uart_link_parser_init(uart_link_parser_t *parser, uart_link_record_cb_t cb, void *ctx)
+{
+    memset(parser, 0, sizeof(uart_link_parser_t));
+    parser->cb  = cb;
+    parser->ctx = ctx;
+}
+
+uint8_t *uart_link_parser_get_buffer(uart_link_parser_t *parser, size_t *space)
+{
+    *space = sizeof(parser->buf) - parser->len;
+    return parser->buf + parser->len;
+}
+
+void uart_link_parser_commit(uart_link_parser_t *parser, size_t len)
+{
+    size_t pos = 0;
+    parser->len += len;
+
+    while (parser->len - pos >= UART_LINK_HEADER_LEN) {
+        const uint8_t *f = parser->buf + pos;
+
+        if (f[0] != UART_LINK_SYNC_0 || f[1] != UART_LINK_SYNC_1) {
+            parser->stats.resync_bytes++;
+            pos++;
+            continue;
+        }
+
+        uint8_t count = f[3];
+        uint16_t payload_len = f[4] | (f[5] << 8);
+
+        if (!count || count > UART_LINK_MAX_RECORDS || payload_len != count * RECORD_SIZE) {
+            parser->stats.length_errors++;
+            pos++;
+            continue;
+        }
+
+        size_t frame_len = UART_LINK_HEADER_LEN + payload_len + UART_LINK_CRC_LEN;
+
+        if (parser->len - pos < frame_len) {
+            break;  /* Wait for the rest of the frame */
+        }
+
+        uint16_t crc = f[frame_len - 2] | (f[frame_len - 1] << 8);
+
+        if (esp_rom_crc16_le(0, f + 2, UART_LINK_HEADER_LEN - 2 + payload_len) != crc) {
+            parser->stats.crc_errors++;
+            pos++;
+            continue;
+        }
+
+        if (parser->seq_valid) {
+            parser->stats.lost_frames += (uint8_t)(f[2] - parser->next_seq);
+        }
+
+        parser->next_seq  = f[2] + 1;
+        parser->seq_valid = true;
+
+        for (int i = 0; i < count; i++) {
+            parser->cb((const csi_data_t *)(f + UART_LINK_HEADER_LEN + i * RECORD_SIZE), parser->ctx);
+        }
+
+        parser->stats.frames++;
+        parser->stats.records += count;
+        pos += frame_len;
+    }
+
+    /* Keep the unparsed tail, always shorter than one frame */
+    memmove(parser->buf, parser->buf + pos, parser->len - pos);
+    parser->len -= pos;
+}
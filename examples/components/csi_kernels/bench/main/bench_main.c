@@ -0,0 +1,981 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file bench_main.c
+ * @brief Replay CSI frames through the csi_kernels and report the cost of each kernel
+ *
+ * On the linux target the frames come from a CSV capture saved by
+ * csi_data_read_parse.py (CSI_BENCH_CAPTURE), otherwise from a fixed
+ * synthetic sequence. Time is taken with clock_gettime() on the host and
+ * with the CPU cycle counter on the chip. Each kernel also prints a
+ * checksum of its outputs, so a behaviour change shows up next to a speed
+ * change when two runs on the same input are compared.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "csi_fft.h"
+#include "csi_frame.h"
+#include "csi_phase.h"
+#include "radar_window.h"
+#include "minmax_window.h"
+#include "csi_gain_lut.h"
+#include "csi_unpack.h"
+#include "radar_detect.h"
+#include "presence_vote.h"
+#include "online_calib.h"
+#include "motion_features.h"
+#include "csi_link_table.h"
+#include "csi_gain_track.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#endif
+
+#define BENCH_SYNTHETIC_FRAMES  512
+#if CONFIG_IDF_TARGET_LINUX
+#define BENCH_MAX_FRAMES        20000
+#define BENCH_REPEAT_DEFAULT    20
+#else
+#define BENCH_MAX_FRAMES        BENCH_SYNTHETIC_FRAMES
+#define BENCH_REPEAT_DEFAULT    5
+#endif
+#define BENCH_WINDOW_LEN        25      /* console_test predict_window_size */
+#define BENCH_LINK_NUM          3
+#define BENCH_MINMAX_LEN        33      /* esp-crab chart points */
+#define BENCH_PHASE_MEAN_LEN    20      /* esp-crab phase smoothing */
+#define BENCH_FRAME_OFFSET      4       /* esp-crab zero subcarriers before the reported ones */
+#define BENCH_LINE_MAX          8192
+#define BENCH_CHECK_MAX_ERR     64      /* Q16 LSB allowed between cir_taps_iq() and fft_iq() */
+#define BENCH_CHECK_POLAR_MAX_ERR 64    /* Q16 LSB allowed between cir_taps_polar_iq() and cir_taps_polar() */
+#define BENCH_CHECK_QUANTILE_MAX_ERR 0.1f /* Relative error allowed between the P-square and the exact quantile */
+#define BENCH_CHECK_DOPPLER_BIN 4       /* Rotations of the moving path per feature window */
+#define BENCH_CHECK_DOPPLER_MAX_STATIC 0.001f /* Doppler share allowed for a static room */
+#define BENCH_GAIN_AGC_MIN      16      /* Gain window of the table, the synthetic gains stay inside */
+#define BENCH_GAIN_AGC_NUM      32
+#define BENCH_GAIN_FFT_MIN      -8
+#define BENCH_GAIN_FFT_NUM      16
+#define BENCH_LLTF_FRAMES       16      /* 12-bit LLTF buffers derived from the first frames */
+#define BENCH_LLTF_LEN          (4 * FFT_MAX_N + 2) /* Two slots per subcarrier and the padding, as on the C5 */
+#define BENCH_CHECK_UNPACK_MAX_ERR 1    /* LSB allowed between csi_unpack_lltf12() and the float gain */
+#define BENCH_LINK_SENDERS      CSI_LINK_TABLE_MAX /* Transmitters of the link table, a full table */
+#define BENCH_GAIN_STEP_AT      1000    /* Frame of the lasting 6-step AGC change of the gain tracking check */
+
+static const char *TAG = "csi_bench";
+
+typedef struct {
+    int8_t csi[2 * FFT_MAX_N];
+    int8_t rssi;
+} bench_frame_t;
+
+/* Derived once before timing, so each kernel is measured on its own */
+typedef struct {
+    float magnitude;
+    float phase;
+    float wander;
+    float jitter;
+} bench_input_t;
+
+typedef struct {
+    const char *name;
+    void (*reset)(void);
+    void (*run)(size_t index);
+} bench_kernel_t;
+
+static bench_frame_t *s_frames;
+static bench_input_t *s_inputs;
+static size_t s_frame_num;
+static double s_checksum;
+
+static float s_wander_storage[RADAR_WINDOW_STORAGE_LEN(BENCH_WINDOW_LEN)];
+static float s_jitter_storage[RADAR_WINDOW_STORAGE_LEN(BENCH_WINDOW_LEN)];
+static radar_window_t s_wander_win;
+static radar_window_t s_jitter_win;
+static minmax_window_entry_t s_minmax_storage[MINMAX_WINDOW_STORAGE_LEN(BENCH_MINMAX_LEN)];
+static minmax_window_t s_minmax_win;
+static float s_phase_storage[CIRCULAR_MEAN_STORAGE_LEN(BENCH_PHASE_MEAN_LEN)];
+static circular_mean_t s_phase_mean;
+static int32_t s_gain_storage[CSI_GAIN_LUT_STORAGE_LEN(BENCH_GAIN_AGC_NUM, BENCH_GAIN_FFT_NUM)];
+static csi_gain_lut_t s_gain_lut;
+static uint8_t s_lltf[BENCH_LLTF_FRAMES][BENCH_LLTF_LEN];
+static float s_lltf_gain[BENCH_LLTF_FRAMES];
+static online_calib_t s_calib;
+static const motion_features_config_t s_features_config = MOTION_FEATURES_CONFIG_DEFAULT();
+static Complex s_features_storage[MOTION_FEATURES_STORAGE_LEN(FFT_MAX_N, MOTION_FEATURES_TAP_MAX)];
+static motion_features_t s_features;
+static radar_detect_config_t s_detect_config = {
+    .vote_len = 5,
+    .move_votes = 2,
+    .wander_sensitivity = 1.0f,
+    .jitter_sensitivity = 1.0f,
+};
+static const presence_vote_config_t s_vote_config = PRESENCE_VOTE_CONFIG_DEFAULT();
+static const uint8_t s_cir_taps[] = {0};
+static csi_link_table_t s_link_table;
+static csi_gain_track_t s_gain_track;
+
+#if CONFIG_IDF_TARGET_LINUX
+static inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline double bench_to_ns(uint64_t ticks)
+{
+    return ticks;
+}
+#else
+static inline uint64_t bench_now(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+static inline double bench_to_ns(uint64_t cycles)
+{
+    return cycles * 1000.0 / esp_rom_get_cpu_ticks_per_us();
+}
+#endif
+
+/* Deterministic, so two runs without a capture see the same frames */
+static uint32_t bench_rand(void)
+{
+    static uint32_t s_seed = 0x1234567;
+    s_seed = s_seed * 1664525 + 1013904223;
+    return s_seed >> 8;
+}
+
+/* A few paths whose phases drift at different speeds, plus noise */
+static void bench_synthesize(void)
+{
+    for (size_t i = 0; i < BENCH_SYNTHETIC_FRAMES; i++) {
+        bench_frame_t *frame = &s_frames[i];
+        float drift = 0.02f * i;
+
+        for (int k = 0; k < FFT_MAX_N; k++) {
+            float re = 40 * cosf(0.1f * k) + 20 * cosf(0.35f * k + drift) + 8 * cosf(0.8f * k - 3 * drift);
+            float im = 40 * sinf(0.1f * k) + 20 * sinf(0.35f * k + drift) + 8 * sinf(0.8f * k - 3 * drift);
+            frame->csi[2 * k] = (int8_t)(im + (int)(bench_rand() % 7) - 3);
+            frame->csi[2 * k + 1] = (int8_t)(re + (int)(bench_rand() % 7) - 3);
+        }
+
+        frame->rssi = -40 - (int8_t)(bench_rand() % 40);
+    }
+
+    s_frame_num = BENCH_SYNTHETIC_FRAMES;
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief Parse one CSV row: type,id,mac,rssi,...,len,first_word,"[data]"
+ */
+static bool bench_parse_row(const char *line, bench_frame_t *frame)
+{
+    const char *p = line;
+
+    if (strncmp(line, "CSI_DATA", 8)) {
+        return false;
+    }
+
+    for (int field = 0; field < 3 && p; field++) {
+        p = strchr(p, ',');
+        p = p ? p + 1 : NULL;
+    }
+
+    const char *data = strstr(line, "\"[");
+
+    if (!p || !data) {
+        return false;
+    }
+
+    memset(frame, 0, sizeof(bench_frame_t));
+    frame->rssi = atoi(p);
+    p = data + 2;
+
+    for (size_t i = 0; i < sizeof(frame->csi) && *p && *p != ']'; i++) {
+        char *end = NULL;
+        frame->csi[i] = (int8_t)strtol(p, &end, 10);
+
+        if (end == p) {
+            break;
+        }
+
+        p = (*end == ',') ? end + 1 : end;
+    }
+
+    return true;
+}
+
+static bool bench_load_capture(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char *line = malloc(BENCH_LINE_MAX);
+
+    if (!fp || !line) {
+        ESP_LOGE(TAG, "Cannot read %s", path);
+        if (fp) {
+            fclose(fp);
+        }
+        free(line);
+        return false;
+    }
+
+    s_frame_num = 0;
+
+    while (s_frame_num < BENCH_MAX_FRAMES && fgets(line, BENCH_LINE_MAX, fp)) {
+        if (bench_parse_row(line, &s_frames[s_frame_num])) {
+            s_frame_num++;
+        }
+    }
+
+    fclose(fp);
+    free(line);
+    return s_frame_num > 0;
+}
+#endif
+
+/* Radar-like inputs: wander from the direct-path magnitude, jitter from its phase steps */
+static void bench_prepare(void)
+{
+    float prev_magnitude = 0;
+    float prev_phase = 0;
+    double wander_sum = 0;
+    double jitter_sum = 0;
+
+    for (size_t i = 0; i < s_frame_num; i++) {
+        bench_input_t *input = &s_inputs[i];
+
+        cir_taps_polar(s_frames[i].csi, s_cir_taps, 1, &input->magnitude, &input->phase);
+        input->wander = i ? fabsf(input->magnitude - prev_magnitude) / (input->magnitude + 1) : 0;
+        input->jitter = i ? fabsf(circular_difference(prev_phase, input->phase)) * 0.01f : 0;
+        prev_magnitude = input->magnitude;
+        prev_phase = input->phase;
+        wander_sum += input->wander;
+        jitter_sum += input->jitter;
+    }
+
+    /* Each value scaled to 12 bits, the unused top nibble of its slot left as noise */
+    for (size_t i = 0; i < BENCH_LLTF_FRAMES; i++) {
+        for (int k = 0; k < 2 * FFT_MAX_N; k++) {
+            uint16_t slot = ((s_frames[i % s_frame_num].csi[k] * 16) & 0xfff) | (bench_rand() & 0xf000);
+
+            s_lltf[i][2 * k] = slot & 0xff;
+            s_lltf[i][2 * k + 1] = slot >> 8;
+        }
+        s_lltf_gain[i] = 0.5f + (float)(bench_rand() % 1000) / 250;
+    }
+
+    /* Thresholds at the mean, so both branches of the decision run */
+    s_detect_config.wander_threshold = wander_sum / s_frame_num;
+    s_detect_config.jitter_threshold = jitter_sum / s_frame_num;
+}
+
+/* cir_taps_iq() evaluates single inverse DFT bins, they must match the full fft_iq() */
+static bool bench_check(void)
+{
+    static const uint8_t taps[] = {0, 1, 2};
+    int32_t max_err = 0;
+
+    for (size_t i = 0; i < s_frame_num; i++) {
+        Complex_Iq x[FFT_MAX_N];
+        Complex_Iq direct[sizeof(taps)];
+
+        for (int k = 0; k < FFT_MAX_N; k++) {
+            x[k].real = s_frames[i].csi[2 * k] * 65536;
+            x[k].imag = s_frames[i].csi[2 * k + 1] * 65536;
+        }
+
+        fft_iq(x, 1);
+        cir_taps_iq(s_frames[i].csi, taps, sizeof(taps), direct);
+
+        for (size_t t = 0; t < sizeof(taps); t++) {
+            int32_t err = MAX(abs(direct[t].real - x[taps[t]].real), abs(direct[t].imag - x[taps[t]].imag));
+            max_err = MAX(max_err, err);
+        }
+    }
+
+    printf("CHECK,cir_taps_vs_fft_iq,%" PRIi32 ",%s\n", max_err, max_err <= BENCH_CHECK_MAX_ERR ? "ok" : "fail");
+    return max_err <= BENCH_CHECK_MAX_ERR;
+}
+
+/* The integer CORDIC path must give the magnitude and phase of the float path */
+static bool bench_check_polar(void)
+{
+    int32_t max_err = 0;
+
+    for (size_t i = 0; i < s_frame_num; i++) {
+        float magnitude;
+        float phase;
+        _iq16 magnitude_iq;
+        _iq16 phase_iq;
+
+        cir_taps_polar(s_frames[i].csi, s_cir_taps, 1, &magnitude, &phase);
+        cir_taps_polar_iq(s_frames[i].csi, s_cir_taps, 1, &magnitude_iq, &phase_iq);
+
+        max_err = MAX(max_err, abs(magnitude_iq - (int32_t)lroundf(magnitude * 65536)));
+        /* The phase of a tap within a few LSB of zero is noise, and -pi equals pi */
+        if (magnitude > 0.01f) {
+            int32_t phase_err = abs(phase_iq - (int32_t)lroundf(phase * 65536));
+            max_err = MAX(max_err, MIN(phase_err, abs(phase_err - 411775)));
+        }
+    }
+
+    printf("CHECK,cir_taps_polar_iq_vs_float,%" PRIi32 ",%s\n", max_err,
+           max_err <= BENCH_CHECK_POLAR_MAX_ERR ? "ok" : "fail");
+    return max_err <= BENCH_CHECK_POLAR_MAX_ERR;
+}
+
+/* The esp-crab dual-antenna copy that cir_taps_frame_polar_iq() replaced: a zero-padded interleaved buffer */
+/* The esp-crab frame slot: zero-padded interleaved copy of both antennas */
+static void bench_dual_copy(size_t index, int8_t buf[4 * FFT_MAX_N])
+{
+    size_t len = MIN(sizeof(s_frames[index].csi), 4 * FFT_MAX_N - 2 * BENCH_FRAME_OFFSET);
+
+    memset(buf, 0, 2 * BENCH_FRAME_OFFSET);
+    memcpy(buf + 2 * BENCH_FRAME_OFFSET, s_frames[index].csi, len);
+    memset(buf + 2 * BENCH_FRAME_OFFSET + len, 0, 4 * FFT_MAX_N - 2 * BENCH_FRAME_OFFSET - len);
+}
+
+static void bench_dual_interleaved(size_t index, _iq16 *magnitude, _iq16 *phase)
+{
+    int8_t buf[4 * FFT_MAX_N];
+
+    bench_dual_copy(index, buf);
+    cir_taps_polar_iq(buf, s_cir_taps, 1, &magnitude[0], &phase[0]);
+    cir_taps_polar_iq(buf + 2 * FFT_MAX_N, s_cir_taps, 1, &magnitude[1], &phase[1]);
+}
+
+static void bench_dual_pass(size_t index, _iq16 *magnitude, _iq16 *phase)
+{
+    int8_t buf[4 * FFT_MAX_N];
+
+    bench_dual_copy(index, buf);
+    cir_taps_dual_polar_iq(buf, s_cir_taps, 1, magnitude, phase);
+}
+
+static void bench_dual_frame(size_t index, _iq16 *magnitude, _iq16 *phase)
+{
+    csi_frame_t frame;
+
+    csi_frame_deinterleave(&frame, s_frames[index].csi, sizeof(s_frames[index].csi), BENCH_FRAME_OFFSET,
+                           FFT_MAX_N, CSI_FRAME_SEGMENT_MAX);
+    cir_taps_frame_polar_iq(&frame, s_cir_taps, 1, magnitude, phase);
+}
+
+/* The frame layout and the dual-antenna pass only move samples, both antennas must come out bit-exact */
+static bool bench_check_frame(void)
+{
+    int32_t max_err[2] = {0};
+
+    for (size_t i = 0; i < s_frame_num; i++) {
+        _iq16 magnitude[3][CSI_FRAME_SEGMENT_MAX];
+        _iq16 phase[3][CSI_FRAME_SEGMENT_MAX];
+
+        bench_dual_interleaved(i, magnitude[0], phase[0]);
+        bench_dual_frame(i, magnitude[1], phase[1]);
+        bench_dual_pass(i, magnitude[2], phase[2]);
+
+        for (int p = 0; p < 2; p++) {
+            for (int s = 0; s < CSI_FRAME_SEGMENT_MAX; s++) {
+                max_err[p] = MAX(max_err[p], abs(magnitude[0][s] - magnitude[p + 1][s]));
+                max_err[p] = MAX(max_err[p], abs(phase[0][s] - phase[p + 1][s]));
+            }
+        }
+    }
+
+    printf("CHECK,cir_taps_frame_vs_interleaved,%" PRIi32 ",%s\n", max_err[0], max_err[0] == 0 ? "ok" : "fail");
+    printf("CHECK,cir_taps_dual_vs_interleaved,%" PRIi32 ",%s\n", max_err[1], max_err[1] == 0 ? "ok" : "fail");
+    return max_err[0] == 0 && max_err[1] == 0;
+}
+
+static int bench_compare_float(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* The streaming calibration threshold must stay close to the quantile of the sorted wander samples */
+static bool bench_check_quantile(void)
+{
+    float *sorted = malloc(s_frame_num * sizeof(float));
+    online_calib_result_t result;
+
+    if (!sorted) {
+        ESP_LOGE(TAG, "Out of memory for the quantile check");
+        return false;
+    }
+
+    online_calib_init(&s_calib, NULL);
+    for (size_t i = 0; i < s_frame_num; i++) {
+        sorted[i] = s_inputs[i].wander;
+        online_calib_push(&s_calib, s_inputs[i].wander, s_inputs[i].jitter);
+    }
+    online_calib_get(&s_calib, &result);
+
+    qsort(sorted, s_frame_num, sizeof(float), bench_compare_float);
+    size_t rank = MIN((size_t)ceilf(s_calib.config.quantile * s_frame_num), s_frame_num) - 1;
+    float exact = sorted[rank];
+    float err = exact > 0 ? fabsf(result.wander_threshold - exact) / exact : fabsf(result.wander_threshold);
+    free(sorted);
+
+    printf("CHECK,online_calib_vs_sorted_quantile,%.4f,%s\n", err, err <= BENCH_CHECK_QUANTILE_MAX_ERR ? "ok" : "fail");
+    return err <= BENCH_CHECK_QUANTILE_MAX_ERR;
+}
+
+/* The example receivers before csi_unpack: one slot at a time, float gain and cast per value */
+static uint16_t bench_lltf_unpack_float(int16_t *out, const uint8_t *buf, uint16_t len, float gain)
+{
+    uint16_t num = 0;
+
+    for (int i = 0; i < len - 2; i += 2) {
+        int16_t csi = ((int16_t)(((((uint16_t)buf[i + 1]) << 8) | buf[i]) << 4) >> 4);
+        out[num++] = (int16_t)(gain * csi);
+    }
+
+    return num;
+}
+
+static bool bench_check_unpack(void)
+{
+    int16_t expected[2 * FFT_MAX_N];
+    int16_t samples[2 * FFT_MAX_N];
+    int32_t max_err = 0;
+
+    for (size_t i = 0; i < BENCH_LLTF_FRAMES; i++) {
+        uint16_t num = bench_lltf_unpack_float(expected, s_lltf[i], BENCH_LLTF_LEN, s_lltf_gain[i]);
+
+        if (csi_unpack_lltf12(samples, s_lltf[i], BENCH_LLTF_LEN, csi_unpack_gain_q16(s_lltf_gain[i])) != num) {
+            max_err = INT16_MAX;
+            break;
+        }
+
+        for (int k = 0; k < num; k++) {
+            max_err = MAX(max_err, abs(expected[k] - samples[k]));
+        }
+    }
+
+    printf("CHECK,lltf_unpack_vs_float,%" PRIi32 ",%s\n", max_err, max_err <= BENCH_CHECK_UNPACK_MAX_ERR ? "ok" : "fail");
+    return max_err <= BENCH_CHECK_UNPACK_MAX_ERR;
+}
+
+/* Transmitter i of the bench, as csi_send with CONFIG_CSI_SEND_INDEX i; past the table they are unknown */
+static void bench_link_mac(uint8_t mac[6], uint32_t i)
+{
+    static const uint8_t base[6] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+    memcpy(mac, base, 6);
+    mac[4] = i >> 8;
+    mac[5] = i & 0xff;
+}
+
+static void bench_link_table_fill(void)
+{
+    uint8_t mac[6];
+
+    csi_link_table_init(&s_link_table);
+
+    for (int i = 0; i < BENCH_LINK_SENDERS; i++) {
+        bench_link_mac(mac, i);
+        csi_link_table_add(&s_link_table, mac, NULL);
+    }
+}
+
+/* Every transmitter finds its own link, a repeated add keeps it, others miss */
+static bool bench_check_link_table(void)
+{
+    uint8_t mac[6];
+    int errors = 0;
+    int index;
+
+    bench_link_table_fill();
+    bench_link_mac(mac, BENCH_LINK_SENDERS);
+    errors += csi_link_table_add(&s_link_table, mac, &index) != ESP_ERR_NO_MEM;
+
+    for (int i = 0; i < 1024; i++) {
+        bench_link_mac(mac, i);
+        errors += csi_link_table_find(&s_link_table, mac) != (i < BENCH_LINK_SENDERS ? i : CSI_LINK_NONE);
+    }
+
+    bench_link_mac(mac, BENCH_LINK_SENDERS - 1);
+    errors += csi_link_table_add(&s_link_table, mac, &index) != ESP_OK || index != BENCH_LINK_SENDERS - 1;
+
+    printf("CHECK,link_table_lookup,%d,%s\n", errors, errors ? "fail" : "ok");
+    return !errors;
+}
+
+/* Sizes of 0 or above capacity are rejected and leave the window as it was */
+static bool bench_check_window_size(void)
+{
+    int errors = 0;
+
+    errors += radar_window_init(&s_wander_win, s_wander_storage, BENCH_WINDOW_LEN, 0) != ESP_ERR_INVALID_ARG;
+    errors += radar_window_init(&s_wander_win, s_wander_storage, BENCH_WINDOW_LEN, BENCH_WINDOW_LEN + 1) != ESP_ERR_INVALID_ARG;
+    errors += radar_window_init(&s_wander_win, s_wander_storage, BENCH_WINDOW_LEN, BENCH_WINDOW_LEN) != ESP_OK;
+
+    for (int i = 0; i < BENCH_WINDOW_LEN; i++) {
+        radar_window_push(&s_wander_win, i);
+    }
+
+    errors += radar_window_set_size(&s_wander_win, 0) != ESP_ERR_INVALID_ARG;
+    errors += radar_window_set_size(&s_wander_win, BENCH_WINDOW_LEN + 1) != ESP_ERR_INVALID_ARG;
+    errors += s_wander_win.size != BENCH_WINDOW_LEN || !radar_window_full(&s_wander_win);
+    errors += radar_window_set_size(&s_wander_win, 1) != ESP_OK || radar_window_median(&s_wander_win) != BENCH_WINDOW_LEN - 1;
+
+    printf("CHECK,radar_window_size_range,%d,%s\n", errors, errors ? "fail" : "ok");
+    return !errors;
+}
+
+/* AGC jitter of one step around 30, then around 36 from BENCH_GAIN_STEP_AT on, like a door that opened */
+static bool bench_check_gain_track(void)
+{
+    csi_gain_track_config_t config = CSI_GAIN_TRACK_CONFIG_DEFAULT();
+    int rebaseline_at = -1;
+    int early = 0;
+
+    csi_gain_track_init(&s_gain_track, &config);
+
+    for (int i = 0; i < BENCH_GAIN_STEP_AT + 2 * config.drift_packets; i++) {
+        uint8_t agc_gain = (i < BENCH_GAIN_STEP_AT ? 30 : 36) + (int)(bench_rand() % 3) - 1;
+        uint32_t flags = csi_gain_track_push(&s_gain_track, agc_gain, (int8_t)(bench_rand() % 5) - 2);
+
+        /* Neither a jump nor a new baseline before the step */
+        early += i >= config.warmup_packets && i < BENCH_GAIN_STEP_AT && flags;
+        if (i >= BENCH_GAIN_STEP_AT && (flags & CSI_GAIN_TRACK_FLAG_REBASELINE) && rebaseline_at < 0) {
+            rebaseline_at = i - BENCH_GAIN_STEP_AT;
+        }
+    }
+
+    bool ok = !early && s_gain_track.jumps > 0 && rebaseline_at >= config.drift_packets
+              && s_gain_track.rebaselines == 1 && s_gain_track.agc_gain_baseline == 36;
+    printf("CHECK,gain_track_rebaseline,%d,%s\n", rebaseline_at, ok ? "ok" : "fail");
+    return ok;
+}
+
+/* A static path plus, when moving, one at the same delay turning BENCH_CHECK_DOPPLER_BIN times per window */
+static void bench_doppler_frame(int8_t *csi, int frame, bool moving)
+{
+    float turn = moving ? 2 * (float)M_PI * BENCH_CHECK_DOPPLER_BIN * frame / s_features_config.window_len : 0;
+
+    for (int k = 0; k < FFT_MAX_N; k++) {
+        float slope = -0.1f * k;
+        float dynamic = moving ? 15 : 0;
+
+        csi[2 * k] = (int8_t)(40 * cosf(slope) + dynamic * cosf(slope + turn));
+        csi[2 * k + 1] = (int8_t)(40 * sinf(slope) + dynamic * sinf(slope + turn));
+    }
+}
+
+static bool bench_check_doppler(void)
+{
+    motion_features_vector_t vector[2] = {0};
+    int8_t csi[2 * FFT_MAX_N];
+
+    for (int moving = 0; moving < 2; moving++) {
+        motion_features_init(&s_features, s_features_storage, &s_features_config);
+
+        for (int i = 0; i < 4 * s_features_config.window_len; i++) {
+            bench_doppler_frame(csi, i, moving);
+            motion_features_push(&s_features, csi, sizeof(csi), &vector[moving]);
+        }
+    }
+
+    int peak = 0;
+
+    for (int k = 1; k < vector[1].doppler_num; k++) {
+        if (vector[1].doppler[k] > vector[1].doppler[peak]) {
+            peak = k;
+        }
+    }
+
+    bool ok = peak + 1 == BENCH_CHECK_DOPPLER_BIN && vector[0].motion_energy <= BENCH_CHECK_DOPPLER_MAX_STATIC;
+    printf("CHECK,motion_features_doppler_peak,%d,%s\n", peak + 1, ok ? "ok" : "fail");
+    return ok;
+}
+
+/* Stands in for esp_csi_gain_ctrl_get_gain_compensation(): float dB math per call */
+static esp_err_t bench_gain_compensation(float *compensate_gain, uint8_t agc_gain, int8_t fft_gain)
+{
+    *compensate_gain = powf(10.0f, ((int)agc_gain - 24 + fft_gain * 0.25f) / 20.0f);
+    return ESP_OK;
+}
+
+/* Gains that drift around a baseline like a live capture */
+static inline uint8_t bench_agc_gain(size_t index)
+{
+    return 20 + (s_frames[index].rssi & 7);
+}
+
+static inline int8_t bench_fft_gain(size_t index)
+{
+    return (int8_t)(index % 5) - 2;
+}
+
+static void bench_reset_none(void)
+{
+}
+
+static void bench_reset_phase_mean(void)
+{
+    circular_mean_init(&s_phase_mean, s_phase_storage, BENCH_PHASE_MEAN_LEN);
+}
+
+static void bench_reset_gain_lut(void)
+{
+    csi_gain_lut_init(&s_gain_lut, s_gain_storage, bench_gain_compensation,
+                      BENCH_GAIN_AGC_MIN, BENCH_GAIN_AGC_NUM, BENCH_GAIN_FFT_MIN, BENCH_GAIN_FFT_NUM);
+}
+
+static void bench_reset_windows(void)
+{
+    radar_window_init(&s_wander_win, s_wander_storage, BENCH_WINDOW_LEN, BENCH_WINDOW_LEN);
+    radar_window_init(&s_jitter_win, s_jitter_storage, BENCH_WINDOW_LEN, BENCH_WINDOW_LEN);
+}
+
+static void bench_reset_minmax(void)
+{
+    minmax_window_init(&s_minmax_win, s_minmax_storage, BENCH_MINMAX_LEN);
+}
+
+static void bench_reset_calib(void)
+{
+    online_calib_init(&s_calib, NULL);
+}
+
+static void bench_reset_features(void)
+{
+    motion_features_init(&s_features, s_features_storage, &s_features_config);
+}
+
+static void bench_run_cir_taps(size_t index)
+{
+    float magnitude;
+    float phase;
+
+    cir_taps_polar(s_frames[index].csi, s_cir_taps, 1, &magnitude, &phase);
+    s_checksum += magnitude;
+}
+
+/* The esp-crab decode before the integer path: float polar form and a compensation computed per packet */
+static void bench_run_cir_gain_float(size_t index)
+{
+    float magnitude;
+    float phase;
+    float gain;
+
+    cir_taps_polar(s_frames[index].csi, s_cir_taps, 1, &magnitude, &phase);
+    bench_gain_compensation(&gain, bench_agc_gain(index), bench_fft_gain(index));
+    s_checksum += magnitude * gain;
+}
+
+/* The esp-crab decode now: CORDIC and a table lookup, float only for the result */
+static void bench_run_cir_gain_iq(size_t index)
+{
+    _iq16 magnitude;
+    _iq16 phase;
+
+    cir_taps_polar_iq(s_frames[index].csi, s_cir_taps, 1, &magnitude, &phase);
+    magnitude = csi_gain_lut_apply(magnitude, csi_gain_lut_get(&s_gain_lut, bench_agc_gain(index), bench_fft_gain(index)));
+    s_checksum += magnitude / 65536.0f;
+}
+
+static void bench_run_cir_dual_interleaved(size_t index)
+{
+    _iq16 magnitude[CSI_FRAME_SEGMENT_MAX];
+    _iq16 phase[CSI_FRAME_SEGMENT_MAX];
+
+    bench_dual_interleaved(index, magnitude, phase);
+    s_checksum += (magnitude[0] + magnitude[1]) / 65536.0f;
+}
+
+static void bench_run_cir_dual_frame(size_t index)
+{
+    _iq16 magnitude[CSI_FRAME_SEGMENT_MAX];
+    _iq16 phase[CSI_FRAME_SEGMENT_MAX];
+
+    bench_dual_frame(index, magnitude, phase);
+    s_checksum += (magnitude[0] + magnitude[1]) / 65536.0f;
+}
+
+static void bench_run_cir_dual_pass(size_t index)
+{
+    _iq16 magnitude[CSI_FRAME_SEGMENT_MAX];
+    _iq16 phase[CSI_FRAME_SEGMENT_MAX];
+
+    bench_dual_pass(index, magnitude, phase);
+    s_checksum += (magnitude[0] + magnitude[1]) / 65536.0f;
+}
+
+static void bench_run_fft_iq(size_t index)
+{
+    Complex_Iq x[FFT_MAX_N];
+
+    for (int k = 0; k < FFT_MAX_N; k++) {
+        x[k].real = s_frames[index].csi[2 * k] * 65536;
+        x[k].imag = s_frames[index].csi[2 * k + 1] * 65536;
+    }
+
+    fft_iq(x, 1);
+    s_checksum += complex_magnitude_iq(x[0]);
+}
+
+static void bench_run_fft(size_t index)
+{
+    Complex x[FFT_MAX_N];
+
+    for (int k = 0; k < FFT_MAX_N; k++) {
+        x[k].real = s_frames[index].csi[2 * k];
+        x[k].imag = s_frames[index].csi[2 * k + 1];
+    }
+
+    fft(x, FFT_MAX_N, 1);
+    s_checksum += complex_magnitude(x[0]);
+}
+
+static void bench_run_circular_difference(size_t index)
+{
+    size_t prev = index ? index - 1 : s_frame_num - 1;
+
+    s_checksum += circular_difference(s_inputs[prev].phase, s_inputs[index].phase);
+}
+
+static void bench_run_circular_mean(size_t index)
+{
+    circular_mean_push(&s_phase_mean, s_inputs[index].phase);
+    s_checksum += circular_mean_get(&s_phase_mean) + circular_mean_variance(&s_phase_mean);
+}
+
+static void bench_run_radar_window(size_t index)
+{
+    radar_window_push(&s_wander_win, s_inputs[index].wander);
+    s_checksum += radar_window_trimmean(&s_wander_win, 0.5f) + radar_window_median(&s_wander_win);
+}
+
+static void bench_run_minmax_window(size_t index)
+{
+    minmax_window_push(&s_minmax_win, s_inputs[index].magnitude);
+    s_checksum += minmax_window_max(&s_minmax_win) - minmax_window_min(&s_minmax_win);
+}
+
+static void bench_run_radar_detect(size_t index)
+{
+    radar_detect_result_t result;
+
+    if (radar_detect_update(&s_detect_config, &s_wander_win, &s_jitter_win,
+                            s_inputs[index].wander, s_inputs[index].jitter, &result)) {
+        s_checksum += result.room_status + 2 * result.human_status;
+    }
+}
+
+/* Every link sees a later frame of the capture, with a growing report age */
+static void bench_run_presence_vote(size_t index)
+{
+    presence_vote_t votes[BENCH_LINK_NUM];
+    bool room_status;
+    bool human_status;
+
+    for (int l = 0; l < BENCH_LINK_NUM; l++) {
+        const bench_input_t *input = &s_inputs[(index + l) % s_frame_num];
+
+        votes[l].weight = presence_vote_weight(&s_vote_config, l > 0, s_frames[(index + l) % s_frame_num].rssi, l * 500);
+        votes[l].room_status = input->wander > s_detect_config.wander_threshold;
+        votes[l].human_status = input->jitter > s_detect_config.jitter_threshold;
+    }
+
+    presence_vote_fuse(&s_vote_config, votes, BENCH_LINK_NUM, &room_status, &human_status);
+    s_checksum += room_status + 2 * human_status;
+}
+
+static void bench_run_online_calib(size_t index)
+{
+    online_calib_result_t result;
+
+    online_calib_push(&s_calib, s_inputs[index].wander, s_inputs[index].jitter);
+    online_calib_get(&s_calib, &result);
+    s_checksum += result.wander_threshold + result.jitter_threshold;
+}
+
+/* One vector every interval frames, the Doppler spectra are included in the per-frame cost */
+static void bench_run_motion_features(size_t index)
+{
+    motion_features_vector_t vector;
+
+    if (motion_features_push(&s_features, s_frames[index].csi, sizeof(s_frames[index].csi), &vector)) {
+        s_checksum += vector.motion_energy + vector.phase_diff_variance + vector.amp_variance[0];
+    }
+}
+
+/* One slot at a time with the float gain, as the get-started receivers did */
+static void bench_run_lltf_unpack_float(size_t index)
+{
+    int16_t samples[2 * FFT_MAX_N];
+    size_t slot = index % BENCH_LLTF_FRAMES;
+
+    bench_lltf_unpack_float(samples, s_lltf[slot], BENCH_LLTF_LEN, s_lltf_gain[slot]);
+    s_checksum += samples[0] + samples[2 * FFT_MAX_N - 1];
+}
+
+static void bench_run_lltf_unpack(size_t index)
+{
+    int16_t samples[2 * FFT_MAX_N];
+    size_t slot = index % BENCH_LLTF_FRAMES;
+
+    csi_unpack_lltf12(samples, s_lltf[slot], BENCH_LLTF_LEN, csi_unpack_gain_q16(s_lltf_gain[slot]));
+    s_checksum += samples[0] + samples[2 * FFT_MAX_N - 1];
+}
+
+static void bench_reset_gain_track(void)
+{
+    csi_gain_track_init(&s_gain_track, NULL);
+}
+
+static void bench_run_gain_track(size_t index)
+{
+    s_checksum += csi_gain_track_push(&s_gain_track, bench_agc_gain(index), bench_fft_gain(index));
+}
+
+/* Half of the frames from configured transmitters, half from strangers */
+static void bench_run_link_find(size_t index)
+{
+    uint8_t mac[6];
+
+    bench_link_mac(mac, index % (2 * BENCH_LINK_SENDERS));
+    s_checksum += csi_link_table_find(&s_link_table, mac);
+}
+
+static const bench_kernel_t s_kernels[] = {
+    {"cir_taps",            bench_reset_none,       bench_run_cir_taps},
+    {"cir_gain_float",      bench_reset_none,       bench_run_cir_gain_float},
+    {"cir_gain_iq",         bench_reset_gain_lut,   bench_run_cir_gain_iq},
+    {"cir_dual_interleaved", bench_reset_none,      bench_run_cir_dual_interleaved},
+    {"cir_dual_frame",      bench_reset_none,       bench_run_cir_dual_frame},
+    {"cir_dual_pass",       bench_reset_none,       bench_run_cir_dual_pass},
+    {"fft_iq",              bench_reset_none,       bench_run_fft_iq},
+    {"fft",                 bench_reset_none,       bench_run_fft},
+    {"circular_difference", bench_reset_none,       bench_run_circular_difference},
+    {"circular_mean",       bench_reset_phase_mean, bench_run_circular_mean},
+    {"radar_window",        bench_reset_windows,    bench_run_radar_window},
+    {"minmax_window",       bench_reset_minmax,     bench_run_minmax_window},
+    {"radar_detect",        bench_reset_windows,    bench_run_radar_detect},
+    {"presence_vote",       bench_reset_none,       bench_run_presence_vote},
+    {"online_calib",        bench_reset_calib,      bench_run_online_calib},
+    {"motion_features",     bench_reset_features,   bench_run_motion_features},
+    {"lltf_unpack_float",   bench_reset_none,       bench_run_lltf_unpack_float},
+    {"lltf_unpack",         bench_reset_none,       bench_run_lltf_unpack},
+    {"link_find",           bench_link_table_fill,  bench_run_link_find},
+    {"gain_track",          bench_reset_gain_track, bench_run_gain_track},
+};
+
+static void bench_run(const bench_kernel_t *kernel, uint32_t repeat)
+{
+    uint64_t elapsed = 0;
+
+    s_checksum = 0;
+    kernel->reset();
+
+    for (uint32_t r = 0; r < repeat; r++) {
+        uint64_t start = bench_now();
+
+        for (size_t i = 0; i < s_frame_num; i++) {
+            kernel->run(i);
+        }
+
+        /* Per pass, the cycle counter is only 32 bits wide */
+#if CONFIG_IDF_TARGET_LINUX
+        elapsed += bench_now() - start;
+#else
+        elapsed += (uint32_t)(bench_now() - start);
+#endif
+    }
+
+    uint64_t frames = (uint64_t)repeat * s_frame_num;
+    double ns_per_frame = bench_to_ns(elapsed) / frames;
+
+#if CONFIG_IDF_TARGET_LINUX
+    printf("BENCH,%s,%" PRIu64 ",%.1f,%.0f,%.6g\n", kernel->name, frames,
+           ns_per_frame, 1e9 / ns_per_frame, s_checksum / repeat);
+#else
+    printf("BENCH,%s,%" PRIu64 ",%.1f,%.0f,%.6g,%.1f\n", kernel->name, frames,
+           ns_per_frame, 1e9 / ns_per_frame, s_checksum / repeat, (double)elapsed / frames);
+#endif
+}
+
+void app_main(void)
+{
+    uint32_t repeat = BENCH_REPEAT_DEFAULT;
+    const char *source = "synthetic";
+    bool ok = true;
+
+    s_frames = calloc(BENCH_MAX_FRAMES, sizeof(bench_frame_t));
+    s_inputs = calloc(BENCH_MAX_FRAMES, sizeof(bench_input_t));
+
+    if (!s_frames || !s_inputs) {
+        ESP_LOGE(TAG, "Out of memory for %d frames", BENCH_MAX_FRAMES);
+        abort();
+    }
+
+#if CONFIG_IDF_TARGET_LINUX
+    const char *capture = getenv("CSI_BENCH_CAPTURE");
+
+    if (getenv("CSI_BENCH_REPEAT")) {
+        repeat = MAX(atoi(getenv("CSI_BENCH_REPEAT")), 1);
+    }
+
+    if (capture) {
+        if (!bench_load_capture(capture)) {
+            ESP_LOGE(TAG, "No CSI_DATA rows in %s", capture);
+            exit(2);
+        }
+        source = capture;
+    }
+#endif
+
+    if (!s_frame_num) {
+        bench_synthesize();
+    }
+
+    bench_prepare();
+    ESP_LOGI(TAG, "%u frames from %s, %" PRIu32 " passes", (unsigned)s_frame_num, source, repeat);
+
+    ok = bench_check();
+    ok = bench_check_polar() && ok;
+    ok = bench_check_frame() && ok;
+    ok = bench_check_quantile() && ok;
+    ok = bench_check_doppler() && ok;
+    ok = bench_check_unpack() && ok;
+    ok = bench_check_link_table() && ok;
+    ok = bench_check_window_size() && ok;
+    ok = bench_check_gain_track() && ok;
+
+#if CONFIG_IDF_TARGET_LINUX
+    printf("type,kernel,frames,ns_per_frame,frames_per_s,checksum\n");
+#else
+    printf("type,kernel,frames,ns_per_frame,frames_per_s,checksum,cycles_per_frame\n");
+#endif
+
+    for (size_t i = 0; i < sizeof(s_kernels) / sizeof(s_kernels[0]); i++) {
+        bench_run(&s_kernels[i], repeat);
+    }
+
+    free(s_frames);
+    free(s_inputs);
+
+#if CONFIG_IDF_TARGET_LINUX
+    exit(ok ? 0 : 1);
+#endif
+}
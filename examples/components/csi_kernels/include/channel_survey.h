@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file channel_survey.h
+ * @brief Per-channel congestion statistics and the choice of the sensing channel
+ *
+ * While a channel is surveyed every frame heard is added: frames of other
+ * devices count towards the busy time with an airtime estimated from their
+ * length, frames of the CSI sender towards its packet success rate. The
+ * channel with the lowest weighted sum of busy share, noise floor and CSI
+ * packet loss wins, the current channel keeps its place unless another one
+ * beats it by the hysteresis.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHANNEL_SURVEY_PREAMBLE_US  20  /**< Added to the airtime of every frame */
+
+typedef struct {
+    float busy_weight;          /**< Score of a channel busy all the time */
+    float noise_weight;         /**< Score per dB of noise floor above noise_ref_dbm */
+    int8_t noise_ref_dbm;
+    float loss_weight;          /**< Score of a channel losing every CSI packet */
+    float hysteresis;           /**< Score a channel must win by to replace the current one */
+    uint16_t rate_kbps;         /**< Rate the airtime of foreign frames is estimated at */
+} channel_survey_config_t;
+
+#define CHANNEL_SURVEY_CONFIG_DEFAULT() { \
+    .busy_weight = 1.0f, \
+    .noise_weight = 0.02f, \
+    .noise_ref_dbm = -95, \
+    .loss_weight = 1.0f, \
+    .hysteresis = 0.1f, \
+    .rate_kbps = 6000, \
+}
+
+typedef struct {
+    uint8_t channel;
+    uint32_t dwell_us;          /**< Time listened */
+    uint32_t airtime_us;        /**< Estimated airtime of the frames of other devices */
+    uint32_t frames;            /**< Frames of other devices */
+    int32_t noise_sum;
+    uint32_t noise_num;
+    uint32_t csi_received;      /**< Packets of the CSI sender */
+    uint32_t csi_expected;      /**< Packets it sent in dwell_us */
+} channel_survey_stat_t;
+
+/**
+ * @brief Start the statistics of a channel
+ */
+void channel_survey_reset(channel_survey_stat_t *stat, uint8_t channel);
+
+/**
+ * @brief Add a frame heard on the channel
+ *
+ * @param len         Frame length in bytes
+ * @param noise_floor Noise floor reported with the frame, dBm
+ * @param csi         The frame is from the CSI sender
+ */
+void channel_survey_add_frame(const channel_survey_config_t *config, channel_survey_stat_t *stat,
+                              uint16_t len, int8_t noise_floor, bool csi);
+
+/**
+ * @brief Share of dwell_us the channel was busy with other devices, 0 to 1
+ */
+float channel_survey_busy(const channel_survey_stat_t *stat);
+
+/**
+ * @brief Mean noise floor, noise_ref_dbm if no frame was heard
+ */
+int8_t channel_survey_noise_dbm(const channel_survey_config_t *config, const channel_survey_stat_t *stat);
+
+/**
+ * @brief Share of the CSI packets received, 0 to 1, 1 if none was expected
+ */
+float channel_survey_csi_rate(const channel_survey_stat_t *stat);
+
+/**
+ * @brief Congestion score of a channel, lower is better
+ */
+float channel_survey_score(const channel_survey_config_t *config, const channel_survey_stat_t *stat);
+
+/**
+ * @brief Pick the channel to sense on
+ *
+ * @param current Channel in use, kept unless another one scores better by the hysteresis
+ *
+ * @return Index in stats of the channel picked, -1 if num is 0
+ */
+int channel_survey_pick(const channel_survey_config_t *config, const channel_survey_stat_t *stats, size_t num,
+                        uint8_t current);
+
+/**
+ * @brief Whether the HT40 secondary channel of a 2.4 GHz channel lies above it
+ *
+ * Channels 1 to 4 have no channel 4 below them.
+ */
+static inline bool channel_survey_second_above(uint8_t channel)
+{
+    return channel <= 4;
+}
+
+#ifdef __cplusplus
+}
+#endif
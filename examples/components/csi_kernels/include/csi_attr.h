@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_attr.h
+ * @brief Placement of the code and tables run for every CSI frame
+ *
+ * CSI_HOT_ATTR puts a function in IRAM and CSI_HOT_DATA_ATTR a constant
+ * table in DRAM, so the per-frame path never waits on a flash cache miss
+ * while the UI or the HTTP server evict it. CONFIG_CSI_HOT_PATH_IN_FLASH
+ * leaves both in flash to give the IRAM back on chips that run short.
+ */
+#pragma once
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+#if CONFIG_CSI_HOT_PATH_IN_FLASH
+#define CSI_HOT_ATTR
+#define CSI_HOT_DATA_ATTR
+#else
+#define CSI_HOT_ATTR        IRAM_ATTR
+#define CSI_HOT_DATA_ATTR   DRAM_ATTR
+#endif
@@ -0,0 +1,160 @@
+/*
+ * SPDX-FileCopyrightText: 2025-2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_fft.h
+ * @brief Table-driven 64-point FFT and direct CIR taps
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "csi_attr.h"
+#include "csi_frame.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+/* IQmath is not available on the host, csi_fft.c carries the few Q16 helpers it needs */
+typedef int32_t _iq16;
+#else
+#include "IQmathLib.h"
+#endif
+
+/* Largest supported transform; the const twiddle and bit-reverse tables are sized for it */
+#define FFT_MAX_N 64
+
+typedef struct {
+    float real;
+    float imag;
+} Complex;
+typedef struct {
+    _iq16 real;
+    _iq16 imag;
+} Complex_Iq;
+/**
+ * @brief 64-point fixed-point FFT, computed in place
+ *
+ * Uses const twiddle and bit-reverse tables kept in DRAM; no heap and no
+ * workspace beyond X itself, so it is safe to call at packet rate.
+ *
+ * @param X       FFT_MAX_N Q16 samples, overwritten with the result
+ * @param inverse Non-zero for the inverse transform (scaled by 1/N)
+ */
+void CSI_HOT_ATTR fft_iq(Complex_Iq *X,  int inverse) ;
+
+/**
+ * @brief Floating-point FFT, computed in place
+ *
+ * @param X       N samples, overwritten with the result
+ * @param N       Power of two in [2, FFT_MAX_N]
+ * @param inverse Non-zero for the inverse transform (scaled by 1/N)
+ */
+void CSI_HOT_ATTR fft(Complex *X, int N, int inverse);
+
+/**
+ * @brief Compute selected CIR taps directly from a 64-subcarrier CSI vector
+ *
+ * Each tap t is one bin of the inverse DFT, X[t] = 1/N * sum(H[k] * e^(j*2*pi*k*t/N)),
+ * evaluated as an integer dot product against the Q16 twiddle table. This is
+ * O(tap_num * N) instead of a full O(N log N) transform when only a few taps are used.
+ *
+ * @param csi     FFT_MAX_N interleaved {real, imag} int8 samples
+ * @param taps    Tap indices in [0, FFT_MAX_N), e.g. {0, 1, 2} for the first delay taps
+ * @param tap_num Number of entries in taps
+ * @param out     tap_num Q16 results, equal to the matching fft_iq() inverse bins
+ */
+void CSI_HOT_ATTR cir_taps_iq(const int8_t *csi, const uint8_t *taps, int tap_num, Complex_Iq *out);
+
+/**
+ * @brief Same as cir_taps_iq() but returns the magnitude and phase of each tap
+ *
+ * @param magnitude tap_num magnitudes, in CSI units
+ * @param phase     tap_num phases in radians, may be NULL when not needed
+ */
+void CSI_HOT_ATTR cir_taps_polar(const int8_t *csi, const uint8_t *taps, int tap_num, float *magnitude, float *phase);
+
+/**
+ * @brief Integer-only cir_taps_polar(), for pipelines that stay in Q16 up to their output
+ *
+ * @param magnitude tap_num magnitudes, in Q16 CSI units
+ * @param phase     tap_num phases in Q16 radians within [-pi, pi], may be NULL when not needed
+ */
+void CSI_HOT_ATTR cir_taps_polar_iq(const int8_t *csi, const uint8_t *taps, int tap_num, _iq16 *magnitude, _iq16 *phase);
+
+/**
+ * @brief cir_taps_iq() over the two antennas of a dual-antenna CSI buffer in one pass
+ *
+ * Reads the interleaved buffer in place, antenna 1 starting FFT_MAX_N
+ * pairs after antenna 0, and loads each twiddle once for both.
+ *
+ * @param csi     2 * FFT_MAX_N interleaved {real, imag} int8 samples
+ * @param taps    Tap indices in [0, FFT_MAX_N)
+ * @param tap_num Number of entries in taps
+ * @param out     2 * tap_num Q16 results, antenna-major: out[s * tap_num + t]
+ */
+void CSI_HOT_ATTR cir_taps_dual_iq(const int8_t *csi, const uint8_t *taps, int tap_num, Complex_Iq *out);
+
+/**
+ * @brief Same as cir_taps_dual_iq() but returns the magnitude and phase of each tap, as cir_taps_polar()
+ *
+ * @param magnitude 2 * tap_num magnitudes in CSI units, antenna-major
+ * @param phase     2 * tap_num phases in radians, antenna-major, may be NULL when not needed
+ */
+void CSI_HOT_ATTR cir_taps_dual_polar(const int8_t *csi, const uint8_t *taps, int tap_num, float *magnitude, float *phase);
+
+/**
+ * @brief Same as cir_taps_dual_iq() but returns the Q16 magnitude and phase of each tap
+ *
+ * @param magnitude 2 * tap_num magnitudes, antenna-major
+ * @param phase     2 * tap_num phases, antenna-major, may be NULL when not needed
+ */
+void CSI_HOT_ATTR cir_taps_dual_polar_iq(const int8_t *csi, const uint8_t *taps, int tap_num,
+                                      _iq16 *magnitude, _iq16 *phase);
+
+/**
+ * @brief cir_taps_iq() over every segment of a frame in one pass
+ *
+ * Each twiddle is loaded once for all segments. Segments must hold
+ * FFT_MAX_N subcarriers, other frames give zero taps.
+ *
+ * @param frame   Frame filled by csi_frame_deinterleave()
+ * @param taps    Tap indices in [0, FFT_MAX_N)
+ * @param tap_num Number of entries in taps
+ * @param out     segment_num * tap_num Q16 results, segment-major: out[s * tap_num + t]
+ */
+void CSI_HOT_ATTR cir_taps_frame_iq(const csi_frame_t *frame, const uint8_t *taps, int tap_num, Complex_Iq *out);
+
+/**
+ * @brief Same as cir_taps_frame_iq() but returns the Q16 magnitude and phase of each tap
+ *
+ * @param magnitude segment_num * tap_num magnitudes, segment-major
+ * @param phase     segment_num * tap_num phases, segment-major, may be NULL when not needed
+ */
+void CSI_HOT_ATTR cir_taps_frame_polar_iq(const csi_frame_t *frame, const uint8_t *taps, int tap_num,
+                                       _iq16 *magnitude, _iq16 *phase);
+
+/**
+ * @brief Magnitude and phase of a Q16 value by CORDIC vectoring
+ *
+ * 16 shift-and-add rotations and one multiply for the CORDIC gain, no
+ * float and no division. Errors are a few Q16 LSB on top of the 2^-15 rad
+ * angle resolution.
+ *
+ * @param z         Value, each component within +-2^28
+ * @param magnitude |z| in Q16
+ * @param phase     atan2(imag, real) in Q16 radians, may be NULL
+ */
+void CSI_HOT_ATTR complex_polar_cordic_iq(Complex_Iq z, _iq16 *magnitude, _iq16 *phase);
+
+float complex_magnitude_iq(Complex_Iq z);
+float complex_phase_iq(Complex_Iq z);
+float complex_magnitude(Complex z);
+float complex_phase(Complex z);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
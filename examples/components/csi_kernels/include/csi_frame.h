@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_frame.h
+ * @brief CSI frame with one contiguous array per segment and component
+ *
+ * The Wi-Fi driver reports CSI as interleaved {real, imag} int8 pairs. A
+ * frame splits the pairs into segments of subcarrier_num subcarriers, one
+ * per antenna or LTF, and keeps the real and imaginary parts of each segment
+ * in arrays of their own. Kernels then walk unit
+ * strides, the same twiddle serves every segment, and the layout grows to
+ * wider bandwidths by raising CSI_FRAME_SUBCARRIER_MAX.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CSI_FRAME_SUBCARRIER_MAX
+#define CSI_FRAME_SUBCARRIER_MAX    64      /**< Subcarriers per segment, 64 for HT20, 128 for HT40 */
+#endif
+#define CSI_FRAME_SEGMENT_MAX       2       /**< Segments per frame, e.g. two antennas */
+
+typedef struct {
+    uint16_t subcarrier_num;    /**< Subcarriers per segment */
+    uint8_t segment_num;        /**< Segments in use */
+    uint8_t offset;             /**< Zero subcarriers placed before the first reported one */
+    uint16_t valid_num;         /**< Reported subcarriers, the others are zero */
+    int8_t real[CSI_FRAME_SEGMENT_MAX][CSI_FRAME_SUBCARRIER_MAX];
+    int8_t imag[CSI_FRAME_SEGMENT_MAX][CSI_FRAME_SUBCARRIER_MAX];
+} csi_frame_t;
+
+/**
+ * @brief Fill a frame from an interleaved CSI buffer in one pass
+ *
+ * Reported pair i becomes subcarrier offset + i of the concatenated
+ * segments. Only the subcarriers before offset and after the last reported
+ * one are zeroed, so nothing is cleared twice.
+ *
+ * @param frame          Frame to fill
+ * @param buf            Interleaved int8 pairs, e.g. wifi_csi_info_t.buf
+ * @param len            Bytes in buf
+ * @param offset         Zero subcarriers before the first reported one
+ * @param subcarrier_num Subcarriers per segment, clamped to [1, CSI_FRAME_SUBCARRIER_MAX]
+ * @param segment_num    Segments, clamped to [1, CSI_FRAME_SEGMENT_MAX]
+ */
+void csi_frame_deinterleave(csi_frame_t *frame, const int8_t *buf, uint16_t len, uint8_t offset,
+                            uint16_t subcarrier_num, uint8_t segment_num);
+
+#ifdef __cplusplus
+}
+#endif
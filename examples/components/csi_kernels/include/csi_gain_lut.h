@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_gain_lut.h
+ * @brief Gain compensation factors in Q16, looked up by (agc_gain, fft_gain)
+ *
+ * Computing the compensation of a packet from its AGC and FFT gains costs
+ * float math on every packet, while the gains only take a handful of
+ * values. The table holds one Q16 factor per gain pair of a window and
+ * fills each entry on its first use with the compute callback, e.g.
+ * esp_csi_gain_ctrl_get_gain_compensation(). Pairs outside the window call
+ * the callback every time. The factors depend on the gain baseline, so the
+ * table must be reset when the baseline changes.
+ *
+ * A table is not thread safe; it belongs to the task that decodes the frames.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_GAIN_LUT_ONE    (1 << 16)   /**< Factor 1.0 in Q16 */
+
+/**
+ * @brief Computes the compensation factor of a gain pair, same signature as esp_csi_gain_ctrl_get_gain_compensation()
+ */
+typedef esp_err_t (*csi_gain_lut_compute_t)(float *compensate_gain, uint8_t agc_gain, int8_t fft_gain);
+
+typedef struct {
+    int32_t *table;                 /**< agc_num x fft_num Q16 factors, 0 until computed */
+    csi_gain_lut_compute_t compute;
+    uint8_t agc_min;
+    uint8_t agc_num;
+    int8_t fft_min;
+    uint8_t fft_num;
+    uint32_t hits;                  /**< Lookups served from the table */
+    uint32_t computes;              /**< Entries filled */
+    uint32_t outside;               /**< Lookups outside the window, computed each time */
+} csi_gain_lut_t;
+
+/**
+ * @brief Number of entries the storage passed to csi_gain_lut_init() must hold
+ */
+#define CSI_GAIN_LUT_STORAGE_LEN(agc_num, fft_num)  ((agc_num) * (fft_num))
+
+/**
+ * @brief Initialize an empty table on caller-provided storage
+ *
+ * @param lut     Table to initialize
+ * @param storage Buffer of CSI_GAIN_LUT_STORAGE_LEN(agc_num, fft_num) entries
+ * @param compute Callback filling the entries
+ * @param agc_min First AGC gain of the window
+ * @param agc_num AGC gains in the window
+ * @param fft_min First FFT gain of the window
+ * @param fft_num FFT gains in the window
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL or the window is empty
+ */
+esp_err_t csi_gain_lut_init(csi_gain_lut_t *lut, int32_t *storage, csi_gain_lut_compute_t compute,
+                            uint8_t agc_min, uint8_t agc_num, int8_t fft_min, uint8_t fft_num);
+
+/**
+ * @brief Forget the computed factors, e.g. once a new gain baseline is recorded
+ */
+void csi_gain_lut_reset(csi_gain_lut_t *lut);
+
+/**
+ * @brief Compensation factor of a gain pair in Q16
+ *
+ * A failing callback gives CSI_GAIN_LUT_ONE, which is not stored. Factors
+ * are capped at 128 so that scaling a CIR tap magnitude cannot overflow.
+ */
+int32_t csi_gain_lut_get(csi_gain_lut_t *lut, uint8_t agc_gain, int8_t fft_gain);
+
+/**
+ * @brief Q16 reciprocal of the factor of a baseline pair, for csi_gain_lut_relative()
+ *
+ * The only division of the relative compensation, taken once per baseline
+ * rather than once per frame: a 64-bit division is a library call on RV32.
+ * The relative factor stays within 0.1 % of the divided one for baseline
+ * factors up to 8.
+ */
+static inline int32_t csi_gain_lut_reciprocal(int32_t baseline)
+{
+    int64_t reciprocal = ((int64_t)1 << 32) / (baseline > 0 ? baseline : CSI_GAIN_LUT_ONE);
+    return reciprocal > INT32_MAX ? INT32_MAX : (int32_t)reciprocal;
+}
+
+/**
+ * @brief Factor of a gain pair relative to the factor of a baseline pair, all in Q16
+ *
+ * Takes the compensation against a baseline of one's own, e.g. one from
+ * csi_gain_track, whatever baseline the compute callback holds. Capped at
+ * 128 like the table factors.
+ *
+ * @param gain                Factor of the gain pair
+ * @param baseline_reciprocal csi_gain_lut_reciprocal() of the factor of the baseline pair
+ */
+static inline int32_t csi_gain_lut_relative(int32_t gain, int32_t baseline_reciprocal)
+{
+    int64_t relative = ((int64_t)gain * baseline_reciprocal) >> 16;
+    return relative > 128 * CSI_GAIN_LUT_ONE ? 128 * CSI_GAIN_LUT_ONE : (int32_t)relative;
+}
+
+/**
+ * @brief Scale a Q16 value by a Q16 factor
+ */
+static inline int32_t csi_gain_lut_apply(int32_t value, int32_t gain)
+{
+    return (int32_t)(((int64_t)value * gain) >> 16);
+}
+
+#ifdef __cplusplus
+}
+#endif
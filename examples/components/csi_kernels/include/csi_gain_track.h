@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_gain_track.h
+ * @brief Gain baseline that follows the environment, with drift and jump detection
+ *
+ * The receivers used to average the AGC and FFT gains of their first 100
+ * packets once and compensate against that baseline for good. After a door
+ * opens or the HVAC starts, the gains settle elsewhere and the stale
+ * baseline shows up as motion. The tracker keeps an exponential mean of
+ * both gains and compares their level, agc_gain + fft_weight * fft_gain,
+ * with the level of the baseline:
+ *
+ * - a frame whose level is more than jump_threshold away from the mean is
+ *   flagged CSI_GAIN_TRACK_FLAG_JUMP, the AGC switched under it and its
+ *   amplitude is not comparable with its neighbours';
+ * - once the mean stays more than drift_threshold away from the baseline
+ *   for drift_packets frames, the mean becomes the new baseline and the
+ *   frame is flagged CSI_GAIN_TRACK_FLAG_REBASELINE.
+ *
+ * Each push is O(1) and the state is a few dozen bytes, so one tracker per
+ * link fits the CSI callback. A tracker is not thread safe; consumers in
+ * other tasks get the baseline with each frame rather than reading it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_GAIN_TRACK_FLAG_WARMUP      (1 << 0)    /**< No baseline yet, the first one is being averaged */
+#define CSI_GAIN_TRACK_FLAG_JUMP        (1 << 1)    /**< Gain away from the running mean, skip the frame */
+#define CSI_GAIN_TRACK_FLAG_DRIFT       (1 << 2)    /**< Mean away from the baseline, a new one is pending */
+#define CSI_GAIN_TRACK_FLAG_REBASELINE  (1 << 3)    /**< This frame set a new baseline */
+
+typedef struct {
+    uint16_t warmup_packets;    /**< Frames averaged for the first baseline */
+    uint16_t drift_packets;     /**< Frames the mean must stay away before a new baseline */
+    float alpha;                /**< Weight of a frame in the running mean, in (0, 1] */
+    float fft_weight;           /**< Level of one FFT gain step relative to an AGC step */
+    float drift_threshold;      /**< Level between mean and baseline that counts as drift */
+    float jump_threshold;       /**< Level between frame and mean that counts as a jump */
+} csi_gain_track_config_t;
+
+/* 1 s of warmup as the former fixed calibration and 2 s of drift at 100 Hz, levels in AGC steps */
+#define CSI_GAIN_TRACK_CONFIG_DEFAULT() { \
+    .warmup_packets = 100, \
+    .drift_packets = 200, \
+    .alpha = 1.0f / 32, \
+    .fft_weight = 0.25f, \
+    .drift_threshold = 1.5f, \
+    .jump_threshold = 3.0f, \
+}
+
+typedef struct {
+    csi_gain_track_config_t config;
+    float agc_mean;
+    float fft_mean;
+    float baseline_level;
+    uint32_t count;             /**< Frames since the last reset */
+    uint16_t drift_count;       /**< Consecutive frames in drift */
+    uint8_t agc_gain_baseline;
+    int8_t fft_gain_baseline;
+    uint8_t seq;                /**< Baselines set since init, 0 until the first one */
+    uint32_t jumps;             /**< Frames flagged CSI_GAIN_TRACK_FLAG_JUMP */
+    uint32_t rebaselines;       /**< Baselines set after the first one */
+} csi_gain_track_t;
+
+/**
+ * @brief Set up a tracker, config may be NULL for CSI_GAIN_TRACK_CONFIG_DEFAULT()
+ */
+void csi_gain_track_init(csi_gain_track_t *track, const csi_gain_track_config_t *config);
+
+/**
+ * @brief Start over with a new warmup, keeping the config, seq and counters
+ */
+void csi_gain_track_reset(csi_gain_track_t *track);
+
+/**
+ * @brief Add the gains of one frame
+ *
+ * @return CSI_GAIN_TRACK_FLAG_* of the frame
+ */
+uint32_t csi_gain_track_push(csi_gain_track_t *track, uint8_t agc_gain, int8_t fft_gain);
+
+/**
+ * @brief Whether the tracker holds a baseline
+ */
+static inline bool csi_gain_track_ready(const csi_gain_track_t *track)
+{
+    return track->count >= track->config.warmup_packets;
+}
+
+#ifdef __cplusplus
+}
+#endif
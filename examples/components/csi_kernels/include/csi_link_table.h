@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_link_table.h
+ * @brief Transmitter MAC to link index lookup for the CSI callback
+ *
+ * A receiver that listens to several transmitters keeps one decode state per
+ * link, in arrays the caller indexes by the link index of this table. The
+ * table hashes the MAC into twice as many buckets as links and probes
+ * linearly, so a lookup in the Wi-Fi callback reads one or two buckets
+ * instead of comparing the frame against every configured MAC. Frames of
+ * unknown transmitters miss on the first empty bucket.
+ *
+ * Links are only added at init; lookups are then safe from any task.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_LINK_TABLE_MAX      8                           /**< Transmitters per receiver */
+#define CSI_LINK_TABLE_BUCKETS  (2 * CSI_LINK_TABLE_MAX)    /**< Power of two */
+#define CSI_LINK_NONE           (-1)
+
+typedef struct {
+    uint8_t mac[CSI_LINK_TABLE_MAX][6];         /**< MAC of each link, in the order they were added */
+    int8_t bucket[CSI_LINK_TABLE_BUCKETS];      /**< Link index, CSI_LINK_NONE when empty */
+    uint8_t num;                                /**< Links added */
+} csi_link_table_t;
+
+/**
+ * @brief Initialize an empty table
+ */
+void csi_link_table_init(csi_link_table_t *table);
+
+/**
+ * @brief Add a transmitter, links are numbered from 0 in the order they are added
+ *
+ * @param table Table
+ * @param mac   Transmitter MAC
+ * @param index Link index of the MAC, may be NULL
+ *
+ * @return
+ *      - ESP_OK on success, also when the MAC is already in the table
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL
+ *      - ESP_ERR_NO_MEM if the table holds CSI_LINK_TABLE_MAX links
+ */
+esp_err_t csi_link_table_add(csi_link_table_t *table, const uint8_t mac[6], int *index);
+
+/**
+ * @brief Link index of a transmitter
+ *
+ * @return Index in [0, num), or CSI_LINK_NONE if the MAC is not in the table
+ */
+int csi_link_table_find(const csi_link_table_t *table, const uint8_t mac[6]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_phase.h
+ * @brief Phase arithmetic on the circle
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Signed difference angle2 - angle1, wrapped to [-pi, pi)
+ */
+float circular_difference(float angle1, float angle2);
+
+/**
+ * @brief Running circular mean and variance of phases
+ *
+ * Each phase enters as a unit vector, and the mean is the angle of the sum
+ * of the vectors. A push costs one sinf() and one cosf() whatever the
+ * window length, instead of a wrapped difference per sample in the window.
+ * With a window, the vectors are kept in a ring and the oldest one leaves
+ * the sums; they are recomputed once per window length, so float rounding
+ * cannot build up. Without one, the sums decay exponentially.
+ */
+typedef struct {
+    float *sin_ring;    /**< Window mode: sines in arrival order, NULL in exponential mode */
+    float *cos_ring;
+    uint16_t capacity;  /**< Window length */
+    uint16_t count;     /**< Phases held, <= capacity */
+    uint16_t head;      /**< Next ring slot to write */
+    uint16_t since_sum; /**< Pushes since the sums were last recomputed */
+    float alpha;        /**< Exponential mode: weight of the newest phase */
+    float sin_sum;
+    float cos_sum;
+    float weight;       /**< Sum of the weights of the held phases */
+} circular_mean_t;
+
+/**
+ * @brief Number of floats the storage passed to circular_mean_init() must hold
+ */
+#define CIRCULAR_MEAN_STORAGE_LEN(capacity)  (2 * (capacity))
+
+/**
+ * @brief Initialize a mean over the last capacity phases, on caller-provided storage
+ *
+ * @param mean     Mean to initialize
+ * @param storage  Buffer of CIRCULAR_MEAN_STORAGE_LEN(capacity) floats
+ * @param capacity Window length, at least 1
+ */
+void circular_mean_init(circular_mean_t *mean, float *storage, uint16_t capacity);
+
+/**
+ * @brief Initialize an exponentially weighted mean, which needs no storage
+ *
+ * @param mean  Mean to initialize
+ * @param alpha Weight of the newest phase in (0, 1], roughly 2 / (N + 1) for an N-phase window
+ */
+void circular_mean_init_exp(circular_mean_t *mean, float alpha);
+
+/**
+ * @brief Drop all phases
+ */
+void circular_mean_reset(circular_mean_t *mean);
+
+/**
+ * @brief Add one phase in radians, evicting the oldest one once the window is full
+ */
+void circular_mean_push(circular_mean_t *mean, float angle);
+
+/**
+ * @brief Mean phase in [-pi, pi], 0 when empty
+ */
+float circular_mean_get(const circular_mean_t *mean);
+
+/**
+ * @brief Mean resultant length in [0, 1]: 1 when all phases agree, near 0 when spread around the circle
+ */
+float circular_mean_resultant(const circular_mean_t *mean);
+
+/**
+ * @brief Circular variance, 1 - circular_mean_resultant()
+ */
+static inline float circular_mean_variance(const circular_mean_t *mean)
+{
+    return 1.0f - circular_mean_resultant(mean);
+}
+
+#ifdef __cplusplus
+}
+#endif
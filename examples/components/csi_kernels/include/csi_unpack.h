@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_unpack.h
+ * @brief Whole CSI buffers to int16 samples with the gain compensation applied
+ *
+ * With acquire_csi_force_lltf the C5 and C61 report each LLTF value as a
+ * 12-bit two's complement number in a little-endian 16-bit slot, the last
+ * two bytes of the buffer being padding. csi_unpack_lltf12() reads the
+ * buffer a 32-bit word, two samples, at a time, sign extends both with
+ * shifts and scales them by a Q16 factor such as csi_gain_lut_get() gives,
+ * instead of assembling bytes and multiplying by a float per value.
+ * csi_unpack_int8() does the same for the int8 buffers of the other modes.
+ *
+ * The scaled samples are truncated toward zero like the float cast they
+ * replace, and saturated to the int16 range.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_UNPACK_GAIN_ONE     (1 << 16)   /**< Factor 1.0 in Q16, same as CSI_GAIN_LUT_ONE */
+
+/**
+ * @brief Samples csi_unpack_lltf12() gives for a buffer of len bytes, without the padding
+ */
+#define CSI_UNPACK_LLTF12_NUM(len)  ((len) > 2 ? ((len) - 2) / 2 : 0)
+
+/**
+ * @brief Q16 factor of a float gain, rounded, 0 for a negative or NaN gain
+ */
+int32_t csi_unpack_gain_q16(float gain);
+
+/**
+ * @brief Unpack a 12-bit LLTF buffer into int16 samples scaled by a Q16 factor
+ *
+ * @param out      CSI_UNPACK_LLTF12_NUM(len) samples
+ * @param buf      wifi_csi_info_t buf, any alignment
+ * @param len      wifi_csi_info_t len, padding included
+ * @param gain_q16 Factor, CSI_UNPACK_GAIN_ONE to only sign extend
+ *
+ * @return Samples written
+ */
+uint16_t csi_unpack_lltf12(int16_t *out, const void *buf, uint16_t len, int32_t gain_q16);
+
+/**
+ * @brief Widen an int8 CSI buffer into int16 samples scaled by a Q16 factor
+ *
+ * @param out      len samples
+ *
+ * @return Samples written
+ */
+uint16_t csi_unpack_int8(int16_t *out, const int8_t *buf, uint16_t len, int32_t gain_q16);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file excitation.h
+ * @brief Motion-adaptive rate of the packets sent only to excite CSI
+ *
+ * The rate jumps to the ceiling on motion, so the movement that follows is
+ * sampled in full, and stays there for hold_ms. A room without motion then
+ * halves the rate every decay_ms down to the floor, which still senses the
+ * next movement, only at a coarser time resolution.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint16_t floor_hz;          /**< Rate of a static or empty room */
+    uint16_t ceiling_hz;        /**< Rate on motion */
+    uint32_t hold_ms;           /**< Time at the ceiling after the last motion */
+    uint32_t decay_ms;          /**< Time per halving of the rate once the hold ended */
+} excitation_config_t;
+
+#define EXCITATION_CONFIG_DEFAULT() { \
+    .floor_hz = 10, \
+    .ceiling_hz = 100, \
+    .hold_ms = 30 * 1000, \
+    .decay_ms = 10 * 1000, \
+}
+
+typedef struct {
+    excitation_config_t config;
+    uint16_t rate_hz;
+    uint32_t motion_ms;         /**< Time of the last motion */
+    uint32_t step_ms;           /**< Time of the last change of the rate */
+} excitation_t;
+
+/**
+ * @brief Start at the ceiling, as after a motion at now_ms
+ *
+ * floor_hz is raised to 1 and ceiling_hz to floor_hz if needed.
+ */
+void excitation_init(excitation_t *exc, const excitation_config_t *config, uint32_t now_ms);
+
+/**
+ * @brief Feed the motion state and advance the rate to now_ms
+ *
+ * @param motion Motion was detected since the previous call
+ *
+ * @return Whether the rate changed
+ */
+bool excitation_update(excitation_t *exc, bool motion, uint32_t now_ms);
+
+static inline uint16_t excitation_rate_hz(const excitation_t *exc)
+{
+    return exc->rate_hz;
+}
+
+static inline uint32_t excitation_interval_ms(const excitation_t *exc)
+{
+    return 1000 / exc->rate_hz;
+}
+
+/**
+ * @brief Relative change of the subcarrier amplitudes since the previous frame
+ *
+ * The amplitude of a subcarrier is approximated by |real| + |imag|. The
+ * result is the sum of the absolute amplitude differences over the sum of
+ * the previous amplitudes, 0 for the first frame, and the frame becomes the
+ * previous one.
+ *
+ * @param buf  Interleaved int8 pairs, e.g. wifi_csi_info_t.buf
+ * @param len  Bytes in buf, pairs beyond num are ignored
+ * @param prev Amplitudes of the previous frame, num entries zeroed before the first call
+ * @param num  Subcarriers compared
+ */
+float excitation_csi_change(const int8_t *buf, uint16_t len, uint16_t *prev, uint16_t num);
+
+#ifdef __cplusplus
+}
+#endif
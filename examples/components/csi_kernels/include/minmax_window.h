@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file minmax_window.h
+ * @brief Sliding-window minimum and maximum in amortized O(1)
+ *
+ * Two monotonic deques keep only the samples that can still become the
+ * minimum or the maximum: a new sample evicts every older one it dominates
+ * and the front expires once it leaves the window. Each sample enters and
+ * leaves each deque once, so a push costs O(1) amortized and the extremes
+ * are read from the fronts, where a rescan of the window would cost O(N).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    float value;
+    uint32_t seq;       /**< Push the value came with */
+} minmax_window_entry_t;
+
+typedef struct {
+    minmax_window_entry_t *min_queue;   /**< Ascending values, the front is the minimum */
+    minmax_window_entry_t *max_queue;   /**< Descending values, the front is the maximum */
+    uint16_t capacity;  /**< Window length */
+    uint16_t min_head;
+    uint16_t min_len;
+    uint16_t max_head;
+    uint16_t max_len;
+    uint32_t seq;       /**< Pushes since the last reset */
+} minmax_window_t;
+
+/**
+ * @brief Number of entries the storage passed to minmax_window_init() must hold
+ */
+#define MINMAX_WINDOW_STORAGE_LEN(capacity)  (2 * (capacity))
+
+/**
+ * @brief Initialize a window on caller-provided storage
+ *
+ * @param win      Window to initialize
+ * @param storage  Buffer of MINMAX_WINDOW_STORAGE_LEN(capacity) entries
+ * @param capacity Window length, at least 1
+ */
+void minmax_window_init(minmax_window_t *win, minmax_window_entry_t *storage, uint16_t capacity);
+
+/**
+ * @brief Drop all samples
+ */
+void minmax_window_reset(minmax_window_t *win);
+
+/**
+ * @brief Push the envelope of one slot, evicting the oldest slot once the window is full
+ *
+ * The minimum is taken over @p low and the maximum over @p high, so a slot
+ * that aggregates several samples keeps their whole range. A NaN bound is
+ * skipped, the slot still ages the window.
+ */
+void minmax_window_push_range(minmax_window_t *win, float low, float high);
+
+/**
+ * @brief Push one sample
+ */
+static inline void minmax_window_push(minmax_window_t *win, float value)
+{
+    minmax_window_push_range(win, value, value);
+}
+
+/**
+ * @brief Whether the window holds at least one sample
+ */
+static inline bool minmax_window_valid(const minmax_window_t *win)
+{
+    return win->min_len && win->max_len;
+}
+
+/**
+ * @brief Smallest sample in the window, 0 when it is empty
+ */
+static inline float minmax_window_min(const minmax_window_t *win)
+{
+    return win->min_len ? win->min_queue[win->min_head].value : 0;
+}
+
+/**
+ * @brief Largest sample in the window, 0 when it is empty
+ */
+static inline float minmax_window_max(const minmax_window_t *win)
+{
+    return win->max_len ? win->max_queue[win->max_head].value : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file motion_features.h
+ * @brief Compact motion feature vectors computed from the CSI frames on the device
+ *
+ * Every frame adds the first CIR taps to a history ring, the amplitude of
+ * each subcarrier to an exponential mean and variance, and the phase
+ * difference of each pair of adjacent subcarriers, as a unit vector, to an
+ * exponential circular mean. Once the history is full, every interval
+ * frames the history of each tap is windowed and transformed into a
+ * Doppler spectrum, and one vector of a few dozen floats stands for the
+ * interval frames of 64 subcarriers each.
+ *
+ * The Doppler bins hold the share of the tap energy at each rate of
+ * change, so they do not depend on the gain; a static room keeps it in the
+ * mean, which is left out. The time constant of the statistics is the
+ * window length, so all features describe about the same span.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "csi_fft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOTION_FEATURES_WINDOW_MIN  8
+#define MOTION_FEATURES_TAP_MAX     4
+#define MOTION_FEATURES_BAND_MAX    16
+#define MOTION_FEATURES_DOPPLER_MAX (FFT_MAX_N / 2)
+
+typedef struct {
+    uint16_t window_len;        /**< Frames of tap history per Doppler spectrum, power of two in [8, FFT_MAX_N] */
+    uint16_t interval;          /**< Frames from one vector to the next, at least 1 */
+    uint8_t tap_num;            /**< CIR taps 0 to tap_num - 1 in the spectrum, at most MOTION_FEATURES_TAP_MAX */
+    uint8_t band_num;           /**< Groups of adjacent subcarriers of the amplitude variance, at most MOTION_FEATURES_BAND_MAX */
+} motion_features_config_t;
+
+#define MOTION_FEATURES_CONFIG_DEFAULT() { \
+    .window_len = 32, \
+    .interval = 10, \
+    .tap_num = 3, \
+    .band_num = 8, \
+}
+
+/**
+ * @brief One feature vector
+ */
+typedef struct {
+    uint32_t seq;               /**< Vectors since the reset, the first is 0 */
+    uint16_t frames;            /**< Frames since the previous vector */
+    uint8_t doppler_num;        /**< window_len / 2 */
+    uint8_t band_num;
+    float doppler[MOTION_FEATURES_DOPPLER_MAX];     /**< Share of the tap energy in bin k + 1, at (k + 1) * rate / window_len Hz */
+    float motion_energy;        /**< Sum of doppler[], the share of the tap energy that is not static */
+    float amp_variance[MOTION_FEATURES_BAND_MAX];   /**< Amplitude variance over squared mean amplitude, mean of the band */
+    float phase_diff_mean;      /**< Circular mean of the adjacent-subcarrier phase differences, radians */
+    float phase_diff_variance;  /**< Circular variance in time of each difference, mean of the pairs, in [0, 1] */
+} motion_features_vector_t;
+
+typedef struct {
+    motion_features_config_t config;
+    Complex *history;           /**< Tap-major rings, tap t at history[t * window_len] */
+    uint16_t head;              /**< Next ring slot to write */
+    uint16_t since_vector;      /**< Frames since the previous vector */
+    uint32_t frames;            /**< Frames since the reset */
+    uint32_t seq;               /**< Next vector */
+    float alpha;                /**< Weight of the newest frame in the statistics */
+    float window_energy;        /**< Sum of the squared window coefficients */
+    float window[FFT_MAX_N];    /**< Hann window of window_len points */
+    float amp_mean[FFT_MAX_N];
+    float amp_variance[FFT_MAX_N];
+    float diff_cos[FFT_MAX_N - 1];
+    float diff_sin[FFT_MAX_N - 1];
+    float diff_weight[FFT_MAX_N - 1];   /**< Share of the recent frames in which the pair was not null */
+} motion_features_t;
+
+/**
+ * @brief Number of Complex entries the storage passed to motion_features_init() must hold
+ */
+#define MOTION_FEATURES_STORAGE_LEN(window_len, tap_num)  ((window_len) * (tap_num))
+
+/**
+ * @brief Initialize the statistics on caller-provided history storage
+ *
+ * @param storage Buffer of MOTION_FEATURES_STORAGE_LEN(config->window_len, config->tap_num) entries
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL or out of range
+ */
+esp_err_t motion_features_init(motion_features_t *mf, Complex *storage, const motion_features_config_t *config);
+
+/**
+ * @brief Drop the history and the statistics, the next vector is again seq 0
+ */
+void motion_features_reset(motion_features_t *mf);
+
+/**
+ * @brief Add one frame and compute a vector when one is due
+ *
+ * @param csi    Interleaved {real, imag} int8 samples, the first FFT_MAX_N subcarriers are used
+ * @param len    Bytes of csi, fewer than 2 * FFT_MAX_N are padded with null subcarriers
+ * @param vector Filled when the function returns true
+ *
+ * @return true if a vector is due: the history is full and interval frames have passed since the previous one
+ */
+bool motion_features_push(motion_features_t *mf, const int8_t *csi, uint16_t len, motion_features_vector_t *vector);
+
+#ifdef __cplusplus
+}
+#endif
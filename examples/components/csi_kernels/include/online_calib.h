@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file online_calib.h
+ * @brief Streaming calibration of the presence thresholds in constant memory
+ *
+ * Each sample of the empty room updates a Welford mean and variance and a
+ * P-square quantile estimator (Jain and Chlamtac, 1985) per waveform. P-square
+ * keeps five markers whose heights track the minimum, the p/2, p and (1+p)/2
+ * quantiles and the maximum, moved by a piecewise-parabolic fit as samples
+ * arrive. A run costs the same few dozen bytes however long it lasts, so it
+ * can be extended, read while it runs, or run in the background while
+ * detection keeps using the previous thresholds.
+ *
+ * The thresholds are the estimated quantile of the empty-room waveform, the
+ * level radar_detect_update() compares the scaled window values against.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define P2_QUANTILE_MARKERS     5
+#define ONLINE_CALIB_MIN_SAMPLES P2_QUANTILE_MARKERS   /**< Below this there are no thresholds */
+
+/**
+ * @brief Running mean and variance
+ */
+typedef struct {
+    uint32_t count;
+    float mean;
+    float m2;           /**< Sum of squared differences to the mean */
+} welford_t;
+
+static inline void welford_reset(welford_t *w)
+{
+    w->count = 0;
+    w->mean = 0;
+    w->m2 = 0;
+}
+
+static inline void welford_push(welford_t *w, float value)
+{
+    float delta = value - w->mean;
+
+    w->count++;
+    w->mean += delta / w->count;
+    w->m2 += delta * (value - w->mean);
+}
+
+/**
+ * @brief Sample variance, 0 below two samples
+ */
+static inline float welford_variance(const welford_t *w)
+{
+    return w->count > 1 ? w->m2 / (w->count - 1) : 0;
+}
+
+/**
+ * @brief Streaming estimate of one quantile
+ */
+typedef struct {
+    float p;                                /**< Quantile in (0, 1) */
+    uint32_t count;
+    float height[P2_QUANTILE_MARKERS];      /**< The first samples, sorted, until there are five */
+    int32_t position[P2_QUANTILE_MARKERS];  /**< Actual marker positions, 0-based */
+    float desired[P2_QUANTILE_MARKERS];     /**< Desired marker positions */
+} p2_quantile_t;
+
+/**
+ * @brief Initialize an estimator of quantile p in (0, 1)
+ */
+void p2_quantile_init(p2_quantile_t *q, float p);
+
+/**
+ * @brief Add one sample, NaN is ignored
+ */
+void p2_quantile_push(p2_quantile_t *q, float value);
+
+/**
+ * @brief Estimated quantile, exact until five samples, 0 when empty
+ */
+float p2_quantile_get(const p2_quantile_t *q);
+
+typedef struct {
+    float quantile;             /**< Share of the empty-room samples below the thresholds */
+    uint32_t target_samples;    /**< Samples for a complete run, progress 1 */
+} online_calib_config_t;
+
+/* 30 s at the 100 Hz radar rate, the length of the former fixed training */
+#define ONLINE_CALIB_CONFIG_DEFAULT() { \
+    .quantile = 0.99f, \
+    .target_samples = 3000, \
+}
+
+typedef struct {
+    online_calib_config_t config;
+    welford_t wander;
+    welford_t jitter;
+    p2_quantile_t wander_level;
+    p2_quantile_t jitter_level;
+} online_calib_t;
+
+typedef struct {
+    uint32_t samples;
+    float progress;             /**< samples / target_samples, at most 1 */
+    float confidence;           /**< progress times 1 minus the worst relative standard error of the means, in [0, 1] */
+    float wander_mean;
+    float wander_std;
+    float wander_threshold;     /**< Estimated quantile of the wander waveform */
+    float jitter_mean;
+    float jitter_std;
+    float jitter_threshold;
+} online_calib_result_t;
+
+/**
+ * @brief Set up a run, config may be NULL for ONLINE_CALIB_CONFIG_DEFAULT()
+ */
+void online_calib_init(online_calib_t *calib, const online_calib_config_t *config);
+
+/**
+ * @brief Drop the samples, keeping the config
+ */
+void online_calib_reset(online_calib_t *calib);
+
+/**
+ * @brief Add one sample of the empty room, O(1); a NaN in either waveform drops the sample
+ */
+void online_calib_push(online_calib_t *calib, float wander, float jitter);
+
+/**
+ * @brief Whether the run holds enough samples for thresholds
+ */
+static inline bool online_calib_ready(const online_calib_t *calib)
+{
+    return calib->wander.count >= ONLINE_CALIB_MIN_SAMPLES;
+}
+
+/**
+ * @brief Whether the run reached target_samples
+ */
+static inline bool online_calib_complete(const online_calib_t *calib)
+{
+    return calib->wander.count >= calib->config.target_samples;
+}
+
+/**
+ * @brief Read the statistics and thresholds of the run so far
+ */
+void online_calib_get(const online_calib_t *calib, online_calib_result_t *result);
+
+/**
+ * @brief Move a threshold towards a new estimate, a threshold still unset takes the estimate
+ *
+ * @param weight Share of the estimate in [0, 1], 1 replaces the threshold
+ */
+static inline float online_calib_blend(float threshold, float estimate, float weight)
+{
+    return threshold > 0 ? threshold + weight * (estimate - threshold) : estimate;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file presence_vote.h
+ * @brief Confidence-weighted vote over the detection results of several links
+ *
+ * Each link votes with a weight from its signal strength and the age of its
+ * last result. The room is occupied when the weighted share of links
+ * detecting presence or motion exceeds the ratio, and someone is moving when
+ * the share detecting motion exceeds it as well. With equal weights and a
+ * ratio of 0.5 this is the 1-of-1, 2-of-2 and 2-of-3 majority vote.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    float ratio;                /**< Weighted share of links that must agree, exclusive */
+    int8_t rssi_floor_dbm;      /**< RSSI mapped to rssi_weight_min */
+    uint8_t rssi_span_db;       /**< RSSI above the floor that reaches full weight */
+    float rssi_weight_min;
+    uint32_t timeout_ms;        /**< Result age at which the weight reaches 0 */
+} presence_vote_config_t;
+
+#define PRESENCE_VOTE_CONFIG_DEFAULT() { \
+    .ratio = 0.5f, \
+    .rssi_floor_dbm = -90, \
+    .rssi_span_db = 40, \
+    .rssi_weight_min = 0.25f, \
+    .timeout_ms = 3000, \
+}
+
+typedef struct {
+    float weight;
+    bool room_status;
+    bool human_status;
+} presence_vote_t;
+
+/**
+ * @brief Vote weight of a link
+ *
+ * Signal strength scales linearly from rssi_weight_min at rssi_floor_dbm to
+ * 1 at rssi_span_db above it, and the weight fades to 0 as the age
+ * approaches timeout_ms.
+ *
+ * @param has_rssi false for a link without RSSI, e.g. the local radar, it counts at full signal weight
+ */
+float presence_vote_weight(const presence_vote_config_t *config, bool has_rssi, int8_t rssi, uint32_t age_ms);
+
+/**
+ * @brief Fuse the votes of the active links
+ */
+void presence_vote_fuse(const presence_vote_config_t *config, const presence_vote_t *votes, size_t vote_num,
+                        bool *room_status, bool *human_status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file radar_detect.h
+ * @brief Presence and motion decision on the esp-radar wander/jitter waveforms
+ *
+ * Presence: the trimmed mean of the wander window, scaled by the
+ * sensitivity, exceeds the wander threshold. Motion: at least move_votes of
+ * the last vote_len jitter samples, scaled by the sensitivity, exceed the
+ * jitter threshold or the window median.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "radar_window.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_DETECT_JITTER_FLOOR       0.0002f     /**< Jitter below this never beats the median, it is noise */
+#define RADAR_DETECT_THRESHOLD_MIN      0.0001f     /**< With calibrated_only, thresholds up to this detect nothing */
+
+typedef struct {
+    uint32_t vote_len;              /**< Recent jitter samples that vote, clamped to the window length */
+    uint32_t move_votes;            /**< Votes needed for motion */
+    float wander_threshold;
+    float wander_sensitivity;
+    float jitter_threshold;
+    float jitter_sensitivity;
+    bool calibrated_only;           /**< Detect nothing until calibration set the thresholds */
+} radar_detect_config_t;
+
+typedef struct {
+    float wander_average;           /**< Trimmed mean of the wander window */
+    float jitter_median;
+    bool room_status;               /**< Someone is present */
+    bool human_status;              /**< Someone is moving */
+} radar_detect_result_t;
+
+/**
+ * @brief Push one radar sample into the windows and decide
+ *
+ * @return false while the jitter window holds fewer than vote_len samples, result is then untouched
+ */
+bool radar_detect_update(const radar_detect_config_t *config, radar_window_t *wander_win, radar_window_t *jitter_win,
+                         float wander, float jitter, radar_detect_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
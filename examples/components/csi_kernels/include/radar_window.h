@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file radar_window.h
+ * @brief Sliding-window order statistics for radar post-processing
+ *
+ * The window keeps the last N samples twice: once in arrival order (ring)
+ * and once sorted. Each push evicts the oldest sample and inserts the new
+ * one with a binary search plus memmove, so trimmed mean, median and
+ * quantiles are read directly from the sorted copy without any sorting or
+ * heap allocation on the radar callback path.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    float *ring;        /**< Samples in arrival order */
+    float *sorted;      /**< Same samples, ascending */
+    uint16_t capacity;  /**< Number of slots in ring and sorted */
+    uint16_t size;      /**< Active window length, <= capacity */
+    uint16_t count;     /**< Samples currently held, <= size */
+    uint16_t head;      /**< Next ring slot to write */
+    uint32_t total;     /**< Samples pushed since the last reset */
+} radar_window_t;
+
+/**
+ * @brief Number of floats the storage passed to radar_window_init() must hold
+ */
+#define RADAR_WINDOW_STORAGE_LEN(capacity)  (2 * (capacity))
+
+/**
+ * @brief Initialize a window on caller-provided storage
+ *
+ * @param win      Window to initialize
+ * @param storage  Buffer of RADAR_WINDOW_STORAGE_LEN(capacity) floats
+ * @param capacity Maximum window length
+ * @param size     Initial window length, in [1, capacity]
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL or size is out of range
+ */
+esp_err_t radar_window_init(radar_window_t *win, float *storage, uint16_t capacity, uint16_t size);
+
+/**
+ * @brief Change the window length at runtime
+ *
+ * The newest samples that still fit are kept, so statistics stay valid
+ * across the change.
+ *
+ * @param win  Window
+ * @param size New window length, in [1, capacity]
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if size is out of range, the window is then unchanged
+ */
+esp_err_t radar_window_set_size(radar_window_t *win, uint16_t size);
+
+/**
+ * @brief Drop all samples, keeping the configured length
+ */
+void radar_window_reset(radar_window_t *win);
+
+/**
+ * @brief Push one sample, evicting the oldest one once the window is full
+ *
+ * NaN samples are ignored since they have no place in the sorted order.
+ */
+void radar_window_push(radar_window_t *win, float value);
+
+/**
+ * @brief Sample pushed @p age frames ago (0 = newest)
+ *
+ * @return The sample, or 0 if the window holds fewer than age + 1 samples
+ */
+float radar_window_recent(const radar_window_t *win, uint16_t age);
+
+/**
+ * @brief Mean after discarding percent/2 of the samples at each end
+ *
+ * Matches the classic trimmean(array, len, percent) definition.
+ */
+float radar_window_trimmean(const radar_window_t *win, float percent);
+
+/**
+ * @brief Quantile with linear interpolation between neighbouring ranks
+ *
+ * @param q Quantile in [0, 1]; 0.5 gives the median
+ */
+float radar_window_quantile(const radar_window_t *win, float q);
+
+/**
+ * @brief Median of the samples in the window
+ */
+static inline float radar_window_median(const radar_window_t *win)
+{
+    return radar_window_quantile(win, 0.5f);
+}
+
+/**
+ * @brief Whether the window holds its full configured length
+ */
+static inline bool radar_window_full(const radar_window_t *win)
+{
+    return win->count == win->size;
+}
+
+#ifdef __cplusplus
+}
+#endif
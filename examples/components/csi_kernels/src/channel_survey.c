@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file channel_survey.c
+ * @brief Per-channel congestion statistics and the choice of the sensing channel
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "channel_survey.h"
+
+void channel_survey_reset(channel_survey_stat_t *stat, uint8_t channel)
+{
+    memset(stat, 0, sizeof(*stat));
+    stat->channel = channel;
+}
+
+void channel_survey_add_frame(const channel_survey_config_t *config, channel_survey_stat_t *stat,
+                              uint16_t len, int8_t noise_floor, bool csi)
+{
+    stat->noise_sum += noise_floor;
+    stat->noise_num++;
+
+    if (csi) {
+        stat->csi_received++;
+        return;
+    }
+
+    stat->frames++;
+    stat->airtime_us += CHANNEL_SURVEY_PREAMBLE_US + (uint32_t)len * 8 * 1000 / MAX(config->rate_kbps, 1);
+}
+
+float channel_survey_busy(const channel_survey_stat_t *stat)
+{
+    return stat->dwell_us ? MIN((float)stat->airtime_us / stat->dwell_us, 1.0f) : 0;
+}
+
+int8_t channel_survey_noise_dbm(const channel_survey_config_t *config, const channel_survey_stat_t *stat)
+{
+    return stat->noise_num ? stat->noise_sum / (int32_t)stat->noise_num : config->noise_ref_dbm;
+}
+
+float channel_survey_csi_rate(const channel_survey_stat_t *stat)
+{
+    return stat->csi_expected ? MIN((float)stat->csi_received / stat->csi_expected, 1.0f) : 1.0f;
+}
+
+float channel_survey_score(const channel_survey_config_t *config, const channel_survey_stat_t *stat)
+{
+    int noise_db = MAX(channel_survey_noise_dbm(config, stat) - config->noise_ref_dbm, 0);
+
+    return config->busy_weight * channel_survey_busy(stat)
+           + config->noise_weight * noise_db
+           + config->loss_weight * (1.0f - channel_survey_csi_rate(stat));
+}
+
+int channel_survey_pick(const channel_survey_config_t *config, const channel_survey_stat_t *stats, size_t num,
+                        uint8_t current)
+{
+    int best = -1;
+    int current_idx = -1;
+    float best_score = 0;
+
+    for (size_t i = 0; i < num; i++) {
+        float score = channel_survey_score(config, &stats[i]);
+
+        if (best < 0 || score < best_score) {
+            best = i;
+            best_score = score;
+        }
+
+        if (stats[i].channel == current) {
+            current_idx = i;
+        }
+    }
+
+    if (current_idx >= 0 && best != current_idx
+            && channel_survey_score(config, &stats[current_idx]) - best_score <= config->hysteresis) {
+        return current_idx;
+    }
+
+    return best;
+}
@@ -0,0 +1,439 @@
+/*
+ * SPDX-FileCopyrightText: 2025-2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_fft.c
+ * @brief Table-driven 64-point FFT and direct CIR taps
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "csi_attr.h"
+#include "esp_log.h"
+#include "csi_fft.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#define _IQ16mpy(a, b)      ((_iq16)(((int64_t)(a) * (b)) >> 16))
+#define _IQdiv64(a)         ((a) >> 6)
+#define _IQ16toF(a)         ((float)(a) / 65536.0f)
+#define _IQ16mag(re, im)    ((_iq16)(hypotf((float)(re), (float)(im))))
+#define _IQ16atan2(y, x)    ((_iq16)(atan2f((float)(y), (float)(x)) * 65536.0f))
+#endif
+
+static const char *TAG = "csi_fft";
+
+/* Bit-reversed index for N = 64, applied in place by swapping i <-> rev[i] */
+static const CSI_HOT_DATA_ATTR uint8_t s_bit_reverse[FFT_MAX_N] = {
+    0, 32, 16, 48, 8, 40, 24, 56,
+    4, 36, 20, 52, 12, 44, 28, 60,
+    2, 34, 18, 50, 10, 42, 26, 58,
+    6, 38, 22, 54, 14, 46, 30, 62,
+    1, 33, 17, 49, 9, 41, 25, 57,
+    5, 37, 21, 53, 13, 45, 29, 61,
+    3, 35, 19, 51, 11, 43, 27, 59,
+    7, 39, 23, 55, 15, 47, 31, 63
+};
+
+/* {cos, sin} of 2*pi*k/64 in Q16, k = 0..63 */
+static const CSI_HOT_DATA_ATTR Complex_Iq s_twiddle_iq[FFT_MAX_N] = {
+    {65536, 0}, {65220, 6424}, {64277, 12785}, {62714, 19024},
+    {60547, 25080}, {57798, 30893}, {54491, 36410}, {50660, 41576},
+    {46341, 46341}, {41576, 50660}, {36410, 54491}, {30893, 57798},
+    {25080, 60547}, {19024, 62714}, {12785, 64277}, {6424, 65220},
+    {0, 65536}, {-6424, 65220}, {-12785, 64277}, {-19024, 62714},
+    {-25080, 60547}, {-30893, 57798}, {-36410, 54491}, {-41576, 50660},
+    {-46341, 46341}, {-50660, 41576}, {-54491, 36410}, {-57798, 30893},
+    {-60547, 25080}, {-62714, 19024}, {-64277, 12785}, {-65220, 6424},
+    {-65536, 0}, {-65220, -6424}, {-64277, -12785}, {-62714, -19024},
+    {-60547, -25080}, {-57798, -30893}, {-54491, -36410}, {-50660, -41576},
+    {-46341, -46341}, {-41576, -50660}, {-36410, -54491}, {-30893, -57798},
+    {-25080, -60547}, {-19024, -62714}, {-12785, -64277}, {-6424, -65220},
+    {0, -65536}, {6424, -65220}, {12785, -64277}, {19024, -62714},
+    {25080, -60547}, {30893, -57798}, {36410, -54491}, {41576, -50660},
+    {46341, -46341}, {50660, -41576}, {54491, -36410}, {57798, -30893},
+    {60547, -25080}, {62714, -19024}, {64277, -12785}, {65220, -6424},
+};
+
+/* {cos, sin} of 2*pi*k/64, k = 0..63 */
+static const CSI_HOT_DATA_ATTR Complex s_twiddle[FFT_MAX_N] = {
+    {1.000000000f, 0.000000000f}, {0.995184727f, 0.098017140f},
+    {0.980785280f, 0.195090322f}, {0.956940336f, 0.290284677f},
+    {0.923879533f, 0.382683432f}, {0.881921264f, 0.471396737f},
+    {0.831469612f, 0.555570233f}, {0.773010453f, 0.634393284f},
+    {0.707106781f, 0.707106781f}, {0.634393284f, 0.773010453f},
+    {0.555570233f, 0.831469612f}, {0.471396737f, 0.881921264f},
+    {0.382683432f, 0.923879533f}, {0.290284677f, 0.956940336f},
+    {0.195090322f, 0.980785280f}, {0.098017140f, 0.995184727f},
+    {0.000000000f, 1.000000000f}, {-0.098017140f, 0.995184727f},
+    {-0.195090322f, 0.980785280f}, {-0.290284677f, 0.956940336f},
+    {-0.382683432f, 0.923879533f}, {-0.471396737f, 0.881921264f},
+    {-0.555570233f, 0.831469612f}, {-0.634393284f, 0.773010453f},
+    {-0.707106781f, 0.707106781f}, {-0.773010453f, 0.634393284f},
+    {-0.831469612f, 0.555570233f}, {-0.881921264f, 0.471396737f},
+    {-0.923879533f, 0.382683432f}, {-0.956940336f, 0.290284677f},
+    {-0.980785280f, 0.195090322f}, {-0.995184727f, 0.098017140f},
+    {-1.000000000f, 0.000000000f}, {-0.995184727f, -0.098017140f},
+    {-0.980785280f, -0.195090322f}, {-0.956940336f, -0.290284677f},
+    {-0.923879533f, -0.382683432f}, {-0.881921264f, -0.471396737f},
+    {-0.831469612f, -0.555570233f}, {-0.773010453f, -0.634393284f},
+    {-0.707106781f, -0.707106781f}, {-0.634393284f, -0.773010453f},
+    {-0.555570233f, -0.831469612f}, {-0.471396737f, -0.881921264f},
+    {-0.382683432f, -0.923879533f}, {-0.290284677f, -0.956940336f},
+    {-0.195090322f, -0.980785280f}, {-0.098017140f, -0.995184727f},
+    {0.000000000f, -1.000000000f}, {0.098017140f, -0.995184727f},
+    {0.195090322f, -0.980785280f}, {0.290284677f, -0.956940336f},
+    {0.382683432f, -0.923879533f}, {0.471396737f, -0.881921264f},
+    {0.555570233f, -0.831469612f}, {0.634393284f, -0.773010453f},
+    {0.707106781f, -0.707106781f}, {0.773010453f, -0.634393284f},
+    {0.831469612f, -0.555570233f}, {0.881921264f, -0.471396737f},
+    {0.923879533f, -0.382683432f}, {0.956940336f, -0.290284677f},
+    {0.980785280f, -0.195090322f}, {0.995184727f, -0.098017140f},
+};
+
+#define CORDIC_ITERATIONS       16
+#define CORDIC_PI_IQ16          205887      /* pi in Q16 */
+#define CORDIC_INV_GAIN_IQ16    39797       /* 1 / prod(sqrt(1 + 2^-2i)) in Q16 */
+
+/* atan(2^-i) in Q16 radians */
+static const CSI_HOT_DATA_ATTR int32_t s_cordic_atan_iq[CORDIC_ITERATIONS] = {
+    51472, 30386, 16055, 8150, 4091, 2047, 1024, 512,
+    256, 128, 64, 32, 16, 8, 4, 2,
+};
+
+void CSI_HOT_ATTR fft_iq(Complex_Iq *X, int inverse)
+{
+    const int N = FFT_MAX_N;
+    const int log2N = 6;
+
+    // In-place bit-reversed permutation
+    for (int i = 0; i < N; i++) {
+        int j = s_bit_reverse[i];
+        if (i < j) {
+            Complex_Iq tmp = X[i];
+            X[i] = X[j];
+            X[j] = tmp;
+        }
+    }
+
+    // Cooley-Tukey iterative FFT, twiddle for stage m at index j * (N / m)
+    for (int s = 1; s <= log2N; ++s) {
+        int m = 1 << s;
+        int m2 = m >> 1;
+        int stride = N >> s;
+
+        for (int j = 0; j < m2; ++j) {
+            _iq16 w_real = s_twiddle_iq[j * stride].real;
+            _iq16 w_imag = inverse ? s_twiddle_iq[j * stride].imag : -s_twiddle_iq[j * stride].imag;
+
+            for (int k = j; k < N; k += m) {
+                Complex_Iq t, u;
+                u = X[k];
+                t.real = _IQ16mpy(w_real, X[k + m2].real) - _IQ16mpy(w_imag, X[k + m2].imag);
+                t.imag = _IQ16mpy(w_real, X[k + m2].imag) + _IQ16mpy(w_imag, X[k + m2].real);
+                X[k].real = u.real + t.real;
+                X[k].imag = u.imag + t.imag;
+                X[k + m2].real = u.real - t.real;
+                X[k + m2].imag = u.imag - t.imag;
+            }
+        }
+    }
+
+    // Scale for inverse FFT
+    if (inverse) {
+        for (int i = 0; i < N; i++) {
+            X[i].real = _IQdiv64(X[i].real);
+            X[i].imag = _IQdiv64(X[i].imag);
+        }
+    }
+}
+
+void CSI_HOT_ATTR fft(Complex *X, int N, int inverse)
+{
+    if (N < 2 || N > FFT_MAX_N || (N & (N - 1))) {
+        ESP_LOGE(TAG, "Unsupported FFT size %d", N);
+        return;
+    }
+
+    int log2N = __builtin_ctz(N);
+    int rev_shift = 6 - log2N;
+
+    // In-place bit-reversed permutation, the 64-point table shifted down to log2N bits
+    for (int i = 0; i < N; i++) {
+        int j = s_bit_reverse[i] >> rev_shift;
+        if (i < j) {
+            Complex tmp = X[i];
+            X[i] = X[j];
+            X[j] = tmp;
+        }
+    }
+
+    // Cooley-Tukey iterative FFT
+    for (int s = 1; s <= log2N; ++s) {
+        int m = 1 << s;
+        int m2 = m >> 1;
+        int stride = FFT_MAX_N >> s;
+
+        for (int j = 0; j < m2; ++j) {
+            float w_real = s_twiddle[j * stride].real;
+            float w_imag = inverse ? s_twiddle[j * stride].imag : -s_twiddle[j * stride].imag;
+
+            for (int k = j; k < N; k += m) {
+                Complex t, u;
+                u = X[k];
+                t.real = w_real * X[k + m2].real - w_imag * X[k + m2].imag;
+                t.imag = w_real * X[k + m2].imag + w_imag * X[k + m2].real;
+                X[k].real = u.real + t.real;
+                X[k].imag = u.imag + t.imag;
+                X[k + m2].real = u.real - t.real;
+                X[k + m2].imag = u.imag - t.imag;
+            }
+        }
+    }
+
+    // Scale for inverse FFT
+    if (inverse) {
+        float scale = 1.0f / N;
+        for (int i = 0; i < N; i++) {
+            X[i].real *= scale;
+            X[i].imag *= scale;
+        }
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_iq(const int8_t *csi, const uint8_t *taps, int tap_num, Complex_Iq *out)
+{
+    for (int t = 0; t < tap_num; t++) {
+        /* |int8 * Q16| * 2 * 64 terms stays below 2^31, so int32 accumulators cannot overflow */
+        int32_t acc_real = 0;
+        int32_t acc_imag = 0;
+        int step = taps[t] & (FFT_MAX_N - 1);
+
+        if (step == 0) {
+            for (int k = 0; k < FFT_MAX_N; k++) {
+                acc_real += csi[2 * k];
+                acc_imag += csi[2 * k + 1];
+            }
+            /* Twiddle is 1.0: scale the plain sum straight to Q16 / N */
+            out[t].real = acc_real * (65536 / FFT_MAX_N);
+            out[t].imag = acc_imag * (65536 / FFT_MAX_N);
+            continue;
+        }
+
+        for (int k = 0, idx = 0; k < FFT_MAX_N; k++, idx = (idx + step) & (FFT_MAX_N - 1)) {
+            int32_t h_real = csi[2 * k];
+            int32_t h_imag = csi[2 * k + 1];
+            acc_real += h_real * s_twiddle_iq[idx].real - h_imag * s_twiddle_iq[idx].imag;
+            acc_imag += h_real * s_twiddle_iq[idx].imag + h_imag * s_twiddle_iq[idx].real;
+        }
+
+        out[t].real = acc_real >> 6;
+        out[t].imag = acc_imag >> 6;
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_polar(const int8_t *csi, const uint8_t *taps, int tap_num, float *magnitude, float *phase)
+{
+    for (int t = 0; t < tap_num; t++) {
+        Complex_Iq tap;
+        cir_taps_iq(csi, &taps[t], 1, &tap);
+        magnitude[t] = complex_magnitude_iq(tap);
+        if (phase) {
+            phase[t] = complex_phase_iq(tap);
+        }
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_polar_iq(const int8_t *csi, const uint8_t *taps, int tap_num, _iq16 *magnitude, _iq16 *phase)
+{
+    for (int t = 0; t < tap_num; t++) {
+        Complex_Iq tap;
+        cir_taps_iq(csi, &taps[t], 1, &tap);
+        complex_polar_cordic_iq(tap, &magnitude[t], phase ? &phase[t] : NULL);
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_dual_iq(const int8_t *csi, const uint8_t *taps, int tap_num, Complex_Iq *out)
+{
+    const int8_t *csi1 = csi + 2 * FFT_MAX_N;
+
+    for (int t = 0; t < tap_num; t++) {
+        int32_t acc0_real = 0;
+        int32_t acc0_imag = 0;
+        int32_t acc1_real = 0;
+        int32_t acc1_imag = 0;
+        int step = taps[t] & (FFT_MAX_N - 1);
+
+        if (step == 0) {
+            for (int k = 0; k < FFT_MAX_N; k++) {
+                acc0_real += csi[2 * k];
+                acc0_imag += csi[2 * k + 1];
+                acc1_real += csi1[2 * k];
+                acc1_imag += csi1[2 * k + 1];
+            }
+            out[t].real = acc0_real * (65536 / FFT_MAX_N);
+            out[t].imag = acc0_imag * (65536 / FFT_MAX_N);
+            out[tap_num + t].real = acc1_real * (65536 / FFT_MAX_N);
+            out[tap_num + t].imag = acc1_imag * (65536 / FFT_MAX_N);
+            continue;
+        }
+
+        for (int k = 0, idx = 0; k < FFT_MAX_N; k++, idx = (idx + step) & (FFT_MAX_N - 1)) {
+            int32_t w_real = s_twiddle_iq[idx].real;
+            int32_t w_imag = s_twiddle_iq[idx].imag;
+            int32_t h0_real = csi[2 * k];
+            int32_t h0_imag = csi[2 * k + 1];
+            int32_t h1_real = csi1[2 * k];
+            int32_t h1_imag = csi1[2 * k + 1];
+
+            acc0_real += h0_real * w_real - h0_imag * w_imag;
+            acc0_imag += h0_real * w_imag + h0_imag * w_real;
+            acc1_real += h1_real * w_real - h1_imag * w_imag;
+            acc1_imag += h1_real * w_imag + h1_imag * w_real;
+        }
+
+        out[t].real = acc0_real >> 6;
+        out[t].imag = acc0_imag >> 6;
+        out[tap_num + t].real = acc1_real >> 6;
+        out[tap_num + t].imag = acc1_imag >> 6;
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_dual_polar(const int8_t *csi, const uint8_t *taps, int tap_num, float *magnitude, float *phase)
+{
+    for (int t = 0; t < tap_num; t++) {
+        Complex_Iq tap[2];
+        cir_taps_dual_iq(csi, &taps[t], 1, tap);
+
+        for (int s = 0; s < 2; s++) {
+            magnitude[s * tap_num + t] = complex_magnitude_iq(tap[s]);
+            if (phase) {
+                phase[s * tap_num + t] = complex_phase_iq(tap[s]);
+            }
+        }
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_dual_polar_iq(const int8_t *csi, const uint8_t *taps, int tap_num,
+                                      _iq16 *magnitude, _iq16 *phase)
+{
+    for (int t = 0; t < tap_num; t++) {
+        Complex_Iq tap[2];
+        cir_taps_dual_iq(csi, &taps[t], 1, tap);
+
+        for (int s = 0; s < 2; s++) {
+            complex_polar_cordic_iq(tap[s], &magnitude[s * tap_num + t], phase ? &phase[s * tap_num + t] : NULL);
+        }
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_frame_iq(const csi_frame_t *frame, const uint8_t *taps, int tap_num, Complex_Iq *out)
+{
+    int segment_num = frame->segment_num;
+
+    if (frame->subcarrier_num != FFT_MAX_N) {
+        memset(out, 0, segment_num * tap_num * sizeof(Complex_Iq));
+        return;
+    }
+
+    for (int t = 0; t < tap_num; t++) {
+        int32_t acc_real[CSI_FRAME_SEGMENT_MAX] = {0};
+        int32_t acc_imag[CSI_FRAME_SEGMENT_MAX] = {0};
+        int step = taps[t] & (FFT_MAX_N - 1);
+
+        if (step == 0) {
+            for (int s = 0; s < segment_num; s++) {
+                for (int k = 0; k < FFT_MAX_N; k++) {
+                    acc_real[s] += frame->real[s][k];
+                    acc_imag[s] += frame->imag[s][k];
+                }
+                out[s * tap_num + t].real = acc_real[s] * (65536 / FFT_MAX_N);
+                out[s * tap_num + t].imag = acc_imag[s] * (65536 / FFT_MAX_N);
+            }
+            continue;
+        }
+
+        for (int k = 0, idx = 0; k < FFT_MAX_N; k++, idx = (idx + step) & (FFT_MAX_N - 1)) {
+            int32_t w_real = s_twiddle_iq[idx].real;
+            int32_t w_imag = s_twiddle_iq[idx].imag;
+
+            for (int s = 0; s < segment_num; s++) {
+                int32_t h_real = frame->real[s][k];
+                int32_t h_imag = frame->imag[s][k];
+                acc_real[s] += h_real * w_real - h_imag * w_imag;
+                acc_imag[s] += h_real * w_imag + h_imag * w_real;
+            }
+        }
+
+        for (int s = 0; s < segment_num; s++) {
+            out[s * tap_num + t].real = acc_real[s] >> 6;
+            out[s * tap_num + t].imag = acc_imag[s] >> 6;
+        }
+    }
+}
+
+void CSI_HOT_ATTR cir_taps_frame_polar_iq(const csi_frame_t *frame, const uint8_t *taps, int tap_num,
+                                       _iq16 *magnitude, _iq16 *phase)
+{
+    for (int t = 0; t < tap_num; t++) {
+        Complex_Iq tap[CSI_FRAME_SEGMENT_MAX];
+        cir_taps_frame_iq(frame, &taps[t], 1, tap);
+
+        for (int s = 0; s < frame->segment_num; s++) {
+            complex_polar_cordic_iq(tap[s], &magnitude[s * tap_num + t], phase ? &phase[s * tap_num + t] : NULL);
+        }
+    }
+}
+
+void CSI_HOT_ATTR complex_polar_cordic_iq(Complex_Iq z, _iq16 *magnitude, _iq16 *phase)
+{
+    int32_t x = z.real;
+    int32_t y = z.imag;
+    int32_t angle = 0;
+
+    /* Rotate into the right half plane, where the iterations converge */
+    if (x < 0) {
+        angle = y < 0 ? -CORDIC_PI_IQ16 : CORDIC_PI_IQ16;
+        x = -x;
+        y = -y;
+    }
+
+    for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+        int32_t dx = y >> i;
+        int32_t dy = x >> i;
+
+        if (y > 0) {
+            x += dx;
+            y -= dy;
+            angle += s_cordic_atan_iq[i];
+        } else {
+            x -= dx;
+            y += dy;
+            angle -= s_cordic_atan_iq[i];
+        }
+    }
+
+    *magnitude = (_iq16)(((int64_t)x * CORDIC_INV_GAIN_IQ16) >> 16);
+    if (phase) {
+        /* Rounding may step just past +-pi, keep the documented range */
+        *phase = angle > CORDIC_PI_IQ16 ? CORDIC_PI_IQ16 : angle < -CORDIC_PI_IQ16 ? -CORDIC_PI_IQ16 : angle;
+    }
+}
+
+float complex_magnitude_iq(Complex_Iq z) {
+    return _IQ16toF(_IQ16mag(z.real, z.imag));
+} 
+
+float complex_phase_iq(Complex_Iq z) {
+    return _IQ16toF(_IQ16atan2(z.imag, z.real));
+}
+
+float complex_magnitude(Complex z) {
+    return sqrt(z.real * z.real + z.imag * z.imag);
+}
+float complex_phase(Complex z) {
+    return atan2(z.imag, z.real);
+}
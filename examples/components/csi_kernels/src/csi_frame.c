@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_frame.c
+ * @brief CSI frame with one contiguous array per segment and component
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "csi_attr.h"
+#include "csi_frame.h"
+
+/* Two pairs per 32-bit word: bytes 0 and 2 are real, 1 and 3 imaginary on the little-endian ESP chips */
+static inline void csi_frame_split(int8_t *real, int8_t *imag, const int8_t *pair, int num)
+{
+    int i = 0;
+
+    for (; i + 2 <= num; i += 2) {
+        uint32_t word;
+        memcpy(&word, pair + 2 * i, sizeof(word));
+
+        uint16_t even = (word & 0xff) | ((word >> 8) & 0xff00);
+        uint16_t odd = ((word >> 8) & 0xff) | ((word >> 16) & 0xff00);
+        memcpy(real + i, &even, sizeof(even));
+        memcpy(imag + i, &odd, sizeof(odd));
+    }
+
+    for (; i < num; i++) {
+        real[i] = pair[2 * i];
+        imag[i] = pair[2 * i + 1];
+    }
+}
+
+void CSI_HOT_ATTR csi_frame_deinterleave(csi_frame_t *frame, const int8_t *buf, uint16_t len, uint8_t offset,
+                                      uint16_t subcarrier_num, uint8_t segment_num)
+{
+    subcarrier_num = MIN(MAX(subcarrier_num, 1), CSI_FRAME_SUBCARRIER_MAX);
+    segment_num = MIN(MAX(segment_num, 1), CSI_FRAME_SEGMENT_MAX);
+
+    int total = subcarrier_num * segment_num;
+    int first = MIN(offset, total);
+    int last = MIN(first + len / 2, total);
+    const int8_t *pair = buf;
+
+    frame->subcarrier_num = subcarrier_num;
+    frame->segment_num = segment_num;
+    frame->offset = first;
+    frame->valid_num = last - first;
+
+    for (int s = 0; s < segment_num; s++) {
+        int begin = s * subcarrier_num;
+        int end = begin + subcarrier_num;
+        int copy_begin = MIN(MAX(first, begin), end);
+        int copy_end = MAX(MIN(last, end), copy_begin);
+        int8_t *real = frame->real[s];
+        int8_t *imag = frame->imag[s];
+
+        memset(real, 0, copy_begin - begin);
+        memset(imag, 0, copy_begin - begin);
+
+        csi_frame_split(real + copy_begin - begin, imag + copy_begin - begin, pair, copy_end - copy_begin);
+        pair += 2 * (copy_end - copy_begin);
+
+        memset(real + copy_end - begin, 0, end - copy_end);
+        memset(imag + copy_end - begin, 0, end - copy_end);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_gain_lut.c
+ * @brief Gain compensation factors in Q16, looked up by (agc_gain, fft_gain)
+ */
+
+#include <string.h>
+#include "csi_attr.h"
+#include "csi_gain_lut.h"
+
+/* Keeps the Q16 product of a CIR tap magnitude (below 2^23.5) and the factor within int32 */
+#define CSI_GAIN_LUT_MAX    (128 * CSI_GAIN_LUT_ONE)
+
+esp_err_t csi_gain_lut_init(csi_gain_lut_t *lut, int32_t *storage, csi_gain_lut_compute_t compute,
+                            uint8_t agc_min, uint8_t agc_num, int8_t fft_min, uint8_t fft_num)
+{
+    if (!lut || !storage || !compute || !agc_num || !fft_num) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(lut, 0, sizeof(csi_gain_lut_t));
+    lut->table = storage;
+    lut->compute = compute;
+    lut->agc_min = agc_min;
+    lut->agc_num = agc_num;
+    lut->fft_min = fft_min;
+    lut->fft_num = fft_num;
+    csi_gain_lut_reset(lut);
+
+    return ESP_OK;
+}
+
+void csi_gain_lut_reset(csi_gain_lut_t *lut)
+{
+    memset(lut->table, 0, CSI_GAIN_LUT_STORAGE_LEN(lut->agc_num, lut->fft_num) * sizeof(int32_t));
+}
+
+static int32_t CSI_HOT_ATTR csi_gain_lut_compute(csi_gain_lut_t *lut, uint8_t agc_gain, int8_t fft_gain)
+{
+    float gain = 0;
+
+    if (lut->compute(&gain, agc_gain, fft_gain) != ESP_OK || !(gain > 0)) {
+        return 0;
+    }
+
+    /* Rounded, and at least one LSB so that a computed entry is never taken for an empty one */
+    float q16 = gain * CSI_GAIN_LUT_ONE + 0.5f;
+    return q16 >= CSI_GAIN_LUT_MAX ? CSI_GAIN_LUT_MAX : q16 < 1 ? 1 : (int32_t)q16;
+}
+
+int32_t CSI_HOT_ATTR csi_gain_lut_get(csi_gain_lut_t *lut, uint8_t agc_gain, int8_t fft_gain)
+{
+    unsigned agc_index = (unsigned)(agc_gain - lut->agc_min);
+    unsigned fft_index = (unsigned)(fft_gain - lut->fft_min);
+
+    /* Gains below the window wrap to large indexes */
+    if (agc_index >= lut->agc_num || fft_index >= lut->fft_num) {
+        int32_t gain = csi_gain_lut_compute(lut, agc_gain, fft_gain);
+        lut->outside++;
+        return gain ? gain : CSI_GAIN_LUT_ONE;
+    }
+
+    int32_t *entry = &lut->table[agc_index * lut->fft_num + fft_index];
+
+    if (*entry) {
+        lut->hits++;
+        return *entry;
+    }
+
+    *entry = csi_gain_lut_compute(lut, agc_gain, fft_gain);
+    if (!*entry) {
+        return CSI_GAIN_LUT_ONE;
+    }
+
+    lut->computes++;
+    return *entry;
+}
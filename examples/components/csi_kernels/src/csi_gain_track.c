@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_gain_track.c
+ * @brief Gain baseline that follows the environment, with drift and jump detection
+ */
+
+#include <math.h>
+#include <string.h>
+#include <sys/param.h>
+#include "csi_attr.h"
+#include "csi_gain_track.h"
+
+void csi_gain_track_init(csi_gain_track_t *track, const csi_gain_track_config_t *config)
+{
+    static const csi_gain_track_config_t s_default = CSI_GAIN_TRACK_CONFIG_DEFAULT();
+
+    memset(track, 0, sizeof(csi_gain_track_t));
+    track->config = config ? *config : s_default;
+    track->config.warmup_packets = MAX(track->config.warmup_packets, 1);
+    track->config.drift_packets = MAX(track->config.drift_packets, 1);
+    track->config.alpha = MIN(MAX(track->config.alpha, 1e-4f), 1.0f);
+}
+
+void csi_gain_track_reset(csi_gain_track_t *track)
+{
+    track->agc_mean = 0;
+    track->fft_mean = 0;
+    track->count = 0;
+    track->drift_count = 0;
+}
+
+static inline float CSI_HOT_ATTR csi_gain_track_level(const csi_gain_track_t *track, float agc_gain, float fft_gain)
+{
+    return agc_gain + track->config.fft_weight * fft_gain;
+}
+
+static void CSI_HOT_ATTR csi_gain_track_set_baseline(csi_gain_track_t *track)
+{
+    track->agc_gain_baseline = (uint8_t)MIN(MAX(lroundf(track->agc_mean), 0), UINT8_MAX);
+    track->fft_gain_baseline = (int8_t)MIN(MAX(lroundf(track->fft_mean), INT8_MIN), INT8_MAX);
+    track->baseline_level = csi_gain_track_level(track, track->agc_gain_baseline, track->fft_gain_baseline);
+    track->drift_count = 0;
+    track->rebaselines += track->seq != 0;
+    /* Skips 0 on wrap, which stands for no baseline */
+    track->seq = track->seq == UINT8_MAX ? 1 : track->seq + 1;
+}
+
+uint32_t CSI_HOT_ATTR csi_gain_track_push(csi_gain_track_t *track, uint8_t agc_gain, int8_t fft_gain)
+{
+    const csi_gain_track_config_t *config = &track->config;
+
+    /* Plain mean of the warmup frames, the first baseline does not lean on the newest ones */
+    if (track->count < config->warmup_packets) {
+        track->count++;
+        track->agc_mean += (agc_gain - track->agc_mean) / track->count;
+        track->fft_mean += (fft_gain - track->fft_mean) / track->count;
+
+        if (track->count < config->warmup_packets) {
+            return CSI_GAIN_TRACK_FLAG_WARMUP;
+        }
+
+        csi_gain_track_set_baseline(track);
+        return CSI_GAIN_TRACK_FLAG_REBASELINE;
+    }
+
+    uint32_t flags = 0;
+    float mean_level = csi_gain_track_level(track, track->agc_mean, track->fft_mean);
+
+    if (fabsf(csi_gain_track_level(track, agc_gain, fft_gain) - mean_level) > config->jump_threshold) {
+        flags |= CSI_GAIN_TRACK_FLAG_JUMP;
+        track->jumps++;
+    }
+
+    /* A jump still moves the mean, so a lasting step turns into drift */
+    track->count += track->count < UINT32_MAX;
+    track->agc_mean += config->alpha * (agc_gain - track->agc_mean);
+    track->fft_mean += config->alpha * (fft_gain - track->fft_mean);
+    mean_level = csi_gain_track_level(track, track->agc_mean, track->fft_mean);
+
+    if (fabsf(mean_level - track->baseline_level) <= config->drift_threshold) {
+        track->drift_count = 0;
+    } else if (++track->drift_count < config->drift_packets) {
+        flags |= CSI_GAIN_TRACK_FLAG_DRIFT;
+    } else {
+        csi_gain_track_set_baseline(track);
+        flags |= CSI_GAIN_TRACK_FLAG_REBASELINE;
+    }
+
+    return flags;
+}
@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_link_table.c
+ * @brief Transmitter MAC to link index lookup for the CSI callback
+ */
+
+#include <string.h>
+#include "csi_attr.h"
+#include "csi_link_table.h"
+
+#define CSI_LINK_TABLE_MASK     (CSI_LINK_TABLE_BUCKETS - 1)
+
+_Static_assert((CSI_LINK_TABLE_BUCKETS & CSI_LINK_TABLE_MASK) == 0, "bucket count must be a power of two");
+_Static_assert(CSI_LINK_TABLE_MAX <= INT8_MAX, "link index must fit a bucket");
+
+/* FNV-1a, folded so the low bits also depend on the high ones. Transmitter
+ * MACs of one deployment often differ in the last byte only. */
+static inline uint32_t CSI_HOT_ATTR csi_link_hash(const uint8_t mac[6])
+{
+    uint32_t hash = 2166136261u;
+
+    for (int i = 0; i < 6; i++) {
+        hash = (hash ^ mac[i]) * 16777619u;
+    }
+
+    return (hash ^ (hash >> 16)) & CSI_LINK_TABLE_MASK;
+}
+
+void csi_link_table_init(csi_link_table_t *table)
+{
+    memset(table, 0, sizeof(csi_link_table_t));
+    memset(table->bucket, CSI_LINK_NONE, sizeof(table->bucket));
+}
+
+esp_err_t csi_link_table_add(csi_link_table_t *table, const uint8_t mac[6], int *index)
+{
+    if (!table || !mac) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int link = csi_link_table_find(table, mac);
+
+    if (link == CSI_LINK_NONE) {
+        if (table->num >= CSI_LINK_TABLE_MAX) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        /* Never full: at most half of the buckets are taken */
+        uint32_t slot = csi_link_hash(mac);
+
+        while (table->bucket[slot] != CSI_LINK_NONE) {
+            slot = (slot + 1) & CSI_LINK_TABLE_MASK;
+        }
+
+        link = table->num++;
+        memcpy(table->mac[link], mac, 6);
+        table->bucket[slot] = link;
+    }
+
+    if (index) {
+        *index = link;
+    }
+
+    return ESP_OK;
+}
+
+int CSI_HOT_ATTR csi_link_table_find(const csi_link_table_t *table, const uint8_t mac[6])
+{
+    uint32_t slot = csi_link_hash(mac);
+
+    for (int8_t link; (link = table->bucket[slot]) != CSI_LINK_NONE; slot = (slot + 1) & CSI_LINK_TABLE_MASK) {
+        if (!memcmp(table->mac[link], mac, 6)) {
+            return link;
+        }
+    }
+
+    return CSI_LINK_NONE;
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_phase.c
+ * @brief Phase arithmetic on the circle
+ */
+
+#include <stddef.h>
+#include <math.h>
+#include "csi_attr.h"
+#include "csi_phase.h"
+
+float CSI_HOT_ATTR circular_difference(float angle1, float angle2)
+{
+    float diff = fmodf(angle2 - angle1 + (float)M_PI, 2 * (float)M_PI);
+
+    if (diff < 0) {
+        diff += 2 * (float)M_PI;
+    }
+
+    return diff - (float)M_PI;
+}
+
+void circular_mean_init(circular_mean_t *mean, float *storage, uint16_t capacity)
+{
+    mean->capacity = capacity ? capacity : 1;
+    mean->sin_ring = storage;
+    mean->cos_ring = storage + mean->capacity;
+    mean->alpha = 0;
+    circular_mean_reset(mean);
+}
+
+void circular_mean_init_exp(circular_mean_t *mean, float alpha)
+{
+    mean->capacity = 0;
+    mean->sin_ring = NULL;
+    mean->cos_ring = NULL;
+    mean->alpha = alpha > 0 && alpha <= 1 ? alpha : 1;
+    circular_mean_reset(mean);
+}
+
+void circular_mean_reset(circular_mean_t *mean)
+{
+    mean->count = 0;
+    mean->head = 0;
+    mean->since_sum = 0;
+    mean->sin_sum = 0;
+    mean->cos_sum = 0;
+    mean->weight = 0;
+}
+
+void CSI_HOT_ATTR circular_mean_push(circular_mean_t *mean, float angle)
+{
+    float s = sinf(angle);
+    float c = cosf(angle);
+
+    if (!mean->sin_ring) {
+        float keep = 1.0f - mean->alpha;
+
+        mean->sin_sum = keep * mean->sin_sum + mean->alpha * s;
+        mean->cos_sum = keep * mean->cos_sum + mean->alpha * c;
+        mean->weight = keep * mean->weight + mean->alpha;
+        return;
+    }
+
+    if (mean->count == mean->capacity) {
+        mean->sin_sum -= mean->sin_ring[mean->head];
+        mean->cos_sum -= mean->cos_ring[mean->head];
+    } else {
+        mean->count++;
+    }
+
+    mean->sin_ring[mean->head] = s;
+    mean->cos_ring[mean->head] = c;
+    mean->head = (mean->head + 1) % mean->capacity;
+    mean->sin_sum += s;
+    mean->cos_sum += c;
+
+    /* Amortized O(1): one exact pass per window length */
+    if (++mean->since_sum >= mean->capacity) {
+        mean->since_sum = 0;
+        mean->sin_sum = 0;
+        mean->cos_sum = 0;
+        for (int i = 0; i < mean->count; i++) {
+            mean->sin_sum += mean->sin_ring[i];
+            mean->cos_sum += mean->cos_ring[i];
+        }
+    }
+    mean->weight = mean->count;
+}
+
+float circular_mean_get(const circular_mean_t *mean)
+{
+    return mean->weight > 0 ? atan2f(mean->sin_sum, mean->cos_sum) : 0;
+}
+
+float circular_mean_resultant(const circular_mean_t *mean)
+{
+    if (!(mean->weight > 0)) {
+        return 0;
+    }
+
+    float r = sqrtf(mean->sin_sum * mean->sin_sum + mean->cos_sum * mean->cos_sum) / mean->weight;
+    return r > 1.0f ? 1.0f : r;
+}
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_unpack.c
+ * @brief Whole CSI buffers to int16 samples with the gain compensation applied
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "csi_attr.h"
+#include "csi_unpack.h"
+
+/* Largest factors whose product with any sample still fits 32 bits, above them the product is 64-bit */
+#define CSI_UNPACK_LLTF12_NARROW_MAX    (1u << 20)  /* |sample| <= 2048 */
+#define CSI_UNPACK_INT8_NARROW_MAX      (1u << 24)  /* |sample| <= 128 */
+
+FORCE_INLINE_ATTR int16_t csi_unpack_saturate(int32_t value)
+{
+    return value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : (int16_t)value;
+}
+
+/* Divided rather than shifted, so that it truncates toward zero like the float cast */
+FORCE_INLINE_ATTR int16_t csi_unpack_scale(int32_t value, int32_t gain_q16, bool narrow)
+{
+    if (narrow) {
+        return csi_unpack_saturate(value * gain_q16 / CSI_UNPACK_GAIN_ONE);
+    }
+
+    return csi_unpack_saturate((int32_t)((int64_t)value * gain_q16 / CSI_UNPACK_GAIN_ONE));
+}
+
+int32_t csi_unpack_gain_q16(float gain)
+{
+    if (!(gain > 0)) {
+        return 0;
+    }
+
+    float q16 = gain * CSI_UNPACK_GAIN_ONE + 0.5f;
+    return q16 >= 2147483648.0f ? INT32_MAX : (int32_t)q16;
+}
+
+/* Instantiated once per mode, so that the loops carry no branch */
+FORCE_INLINE_ATTR int16_t csi_unpack_apply(int32_t value, int32_t gain_q16, bool unity, bool narrow)
+{
+    return unity ? (int16_t)value : csi_unpack_scale(value, gain_q16, narrow);
+}
+
+FORCE_INLINE_ATTR void csi_unpack_lltf12_loop(int16_t *out, const uint8_t *bytes, uint16_t num,
+                                              int32_t gain_q16, bool unity, bool narrow)
+{
+    uint16_t i = 0;
+
+    /* Two slots per little-endian word: bits 0-11 and 16-27, sign extended by shifting them to the top */
+    for (; i + 2 <= num; i += 2) {
+        uint32_t word;
+
+        memcpy(&word, bytes + 2 * i, sizeof(word));
+        out[i] = csi_unpack_apply((int32_t)(word << 20) >> 20, gain_q16, unity, narrow);
+        out[i + 1] = csi_unpack_apply((int32_t)(word << 4) >> 20, gain_q16, unity, narrow);
+    }
+
+    if (i < num) {
+        uint16_t slot;
+
+        memcpy(&slot, bytes + 2 * i, sizeof(slot));
+        out[i] = csi_unpack_apply((int32_t)((uint32_t)slot << 20) >> 20, gain_q16, unity, narrow);
+    }
+}
+
+FORCE_INLINE_ATTR void csi_unpack_int8_loop(int16_t *out, const int8_t *buf, uint16_t len,
+                                            int32_t gain_q16, bool unity, bool narrow)
+{
+    uint16_t i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        uint32_t word;
+
+        memcpy(&word, buf + i, sizeof(word));
+        out[i] = csi_unpack_apply((int32_t)(word << 24) >> 24, gain_q16, unity, narrow);
+        out[i + 1] = csi_unpack_apply((int32_t)(word << 16) >> 24, gain_q16, unity, narrow);
+        out[i + 2] = csi_unpack_apply((int32_t)(word << 8) >> 24, gain_q16, unity, narrow);
+        out[i + 3] = csi_unpack_apply((int32_t)word >> 24, gain_q16, unity, narrow);
+    }
+
+    for (; i < len; i++) {
+        out[i] = csi_unpack_apply(buf[i], gain_q16, unity, narrow);
+    }
+}
+
+uint16_t CSI_HOT_ATTR csi_unpack_lltf12(int16_t *out, const void *buf, uint16_t len, int32_t gain_q16)
+{
+    uint16_t num = CSI_UNPACK_LLTF12_NUM(len);
+
+    if (gain_q16 == CSI_UNPACK_GAIN_ONE) {
+        csi_unpack_lltf12_loop(out, buf, num, gain_q16, true, true);
+    } else if ((uint32_t)gain_q16 < CSI_UNPACK_LLTF12_NARROW_MAX) {
+        csi_unpack_lltf12_loop(out, buf, num, gain_q16, false, true);
+    } else {
+        csi_unpack_lltf12_loop(out, buf, num, gain_q16, false, false);
+    }
+
+    return num;
+}
+
+uint16_t CSI_HOT_ATTR csi_unpack_int8(int16_t *out, const int8_t *buf, uint16_t len, int32_t gain_q16)
+{
+    if (gain_q16 == CSI_UNPACK_GAIN_ONE) {
+        csi_unpack_int8_loop(out, buf, len, gain_q16, true, true);
+    } else if ((uint32_t)gain_q16 < CSI_UNPACK_INT8_NARROW_MAX) {
+        csi_unpack_int8_loop(out, buf, len, gain_q16, false, true);
+    } else {
+        csi_unpack_int8_loop(out, buf, len, gain_q16, false, false);
+    }
+
+    return len;
+}
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file excitation.c
+ * @brief Motion-adaptive rate of the packets sent only to excite CSI
+ */
+
+#include <stdlib.h>
+#include <sys/param.h>
+#include "excitation.h"
+
+void excitation_init(excitation_t *exc, const excitation_config_t *config, uint32_t now_ms)
+{
+    exc->config = *config;
+    exc->config.floor_hz = MAX(exc->config.floor_hz, 1);
+    exc->config.ceiling_hz = MAX(exc->config.ceiling_hz, exc->config.floor_hz);
+    exc->config.decay_ms = MAX(exc->config.decay_ms, 1);
+    exc->rate_hz = exc->config.ceiling_hz;
+    exc->motion_ms = now_ms;
+    exc->step_ms = now_ms;
+}
+
+bool excitation_update(excitation_t *exc, bool motion, uint32_t now_ms)
+{
+    const excitation_config_t *config = &exc->config;
+    uint16_t rate_hz = exc->rate_hz;
+
+    if (motion) {
+        exc->motion_ms = now_ms;
+        rate_hz = config->ceiling_hz;
+    } else if (now_ms - exc->motion_ms >= config->hold_ms && now_ms - exc->step_ms >= config->decay_ms
+               && rate_hz > config->floor_hz) {
+        rate_hz = MAX(rate_hz / 2, config->floor_hz);
+    }
+
+    if (rate_hz == exc->rate_hz) {
+        return false;
+    }
+
+    exc->rate_hz = rate_hz;
+    exc->step_ms = now_ms;
+
+    return true;
+}
+
+float excitation_csi_change(const int8_t *buf, uint16_t len, uint16_t *prev, uint16_t num)
+{
+    uint32_t diff = 0;
+    uint32_t total = 0;
+
+    num = MIN(num, len / 2);
+
+    for (int i = 0; i < num; i++) {
+        uint16_t amplitude = abs(buf[2 * i]) + abs(buf[2 * i + 1]);
+
+        diff += abs((int)amplitude - prev[i]);
+        total += prev[i];
+        prev[i] = amplitude;
+    }
+
+    return total ? (float)diff / total : 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file minmax_window.c
+ * @brief Sliding-window minimum and maximum in amortized O(1)
+ */
+
+#include <math.h>
+#include "minmax_window.h"
+
+void minmax_window_init(minmax_window_t *win, minmax_window_entry_t *storage, uint16_t capacity)
+{
+    win->capacity = capacity ? capacity : 1;
+    win->min_queue = storage;
+    win->max_queue = storage + win->capacity;
+    minmax_window_reset(win);
+}
+
+void minmax_window_reset(minmax_window_t *win)
+{
+    win->min_head = 0;
+    win->min_len = 0;
+    win->max_head = 0;
+    win->max_len = 0;
+    win->seq = 0;
+}
+
+/* One deque, @p lower says whether a smaller value dominates */
+static void minmax_window_queue_push(minmax_window_entry_t *queue, uint16_t capacity, uint16_t *head,
+                                     uint16_t *len, float value, uint32_t seq, bool lower)
+{
+    while (*len && seq - queue[*head].seq >= capacity) {
+        *head = (*head + 1) % capacity;
+        (*len)--;
+    }
+
+    if (isnan(value)) {
+        return;
+    }
+
+    while (*len) {
+        float back = queue[(*head + *len - 1) % capacity].value;
+
+        if (lower ? back < value : back > value) {
+            break;
+        }
+
+        (*len)--;
+    }
+
+    queue[(*head + *len) % capacity] = (minmax_window_entry_t) {
+        .value = value, .seq = seq
+    };
+    (*len)++;
+}
+
+void minmax_window_push_range(minmax_window_t *win, float low, float high)
+{
+    uint32_t seq = win->seq++;
+
+    minmax_window_queue_push(win->min_queue, win->capacity, &win->min_head, &win->min_len, low, seq, true);
+    minmax_window_queue_push(win->max_queue, win->capacity, &win->max_head, &win->max_len, high, seq, false);
+}
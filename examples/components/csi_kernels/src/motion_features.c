@@ -0,0 +1,251 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file motion_features.c
+ * @brief Compact motion feature vectors computed from the CSI frames on the device
+ */
+
+#include <math.h>
+#include <string.h>
+#include "csi_attr.h"
+#include "motion_features.h"
+
+#define MOTION_FEATURES_AMP_MIN     0.5f    /* Mean amplitude below which a subcarrier is null */
+
+static const uint8_t s_taps[MOTION_FEATURES_TAP_MAX] = {0, 1, 2, 3};
+
+esp_err_t motion_features_init(motion_features_t *mf, Complex *storage, const motion_features_config_t *config)
+{
+    if (!mf || !storage || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t window_len = config->window_len;
+
+    if (window_len < MOTION_FEATURES_WINDOW_MIN || window_len > FFT_MAX_N || (window_len & (window_len - 1))
+            || !config->interval || !config->tap_num || config->tap_num > MOTION_FEATURES_TAP_MAX
+            || !config->band_num || config->band_num > MOTION_FEATURES_BAND_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(mf, 0, sizeof(motion_features_t));
+    mf->config = *config;
+    mf->history = storage;
+    mf->alpha = 2.0f / (window_len + 1);
+
+    for (int n = 0; n < window_len; n++) {
+        mf->window[n] = 0.5f - 0.5f * cosf(2 * (float)M_PI * n / window_len);
+        mf->window_energy += mf->window[n] * mf->window[n];
+    }
+
+    motion_features_reset(mf);
+
+    return ESP_OK;
+}
+
+void motion_features_reset(motion_features_t *mf)
+{
+    memset(mf->history, 0, MOTION_FEATURES_STORAGE_LEN(mf->config.window_len, mf->config.tap_num) * sizeof(Complex));
+    memset(mf->amp_mean, 0, sizeof(mf->amp_mean));
+    memset(mf->amp_variance, 0, sizeof(mf->amp_variance));
+    memset(mf->diff_cos, 0, sizeof(mf->diff_cos));
+    memset(mf->diff_sin, 0, sizeof(mf->diff_sin));
+    memset(mf->diff_weight, 0, sizeof(mf->diff_weight));
+    mf->head = 0;
+    mf->since_vector = 0;
+    mf->frames = 0;
+    mf->seq = 0;
+}
+
+/* Exponential mean and variance of the amplitudes, and circular mean of the adjacent differences */
+static void CSI_HOT_ATTR motion_features_update_stats(motion_features_t *mf, const int8_t *csi)
+{
+    float alpha = mf->frames ? mf->alpha : 1.0f;
+    float keep = 1.0f - alpha;
+
+    for (int k = 0; k < FFT_MAX_N; k++) {
+        float re = csi[2 * k];
+        float im = csi[2 * k + 1];
+        float amplitude = sqrtf(re * re + im * im);
+        float delta = amplitude - mf->amp_mean[k];
+
+        mf->amp_mean[k] += alpha * delta;
+        mf->amp_variance[k] = keep * (mf->amp_variance[k] + alpha * delta * delta);
+
+        if (k == FFT_MAX_N - 1) {
+            break;
+        }
+
+        /* H[k + 1] * conj(H[k]), its angle is the phase difference */
+        float next_re = csi[2 * k + 2];
+        float next_im = csi[2 * k + 3];
+        float diff_re = next_re * re + next_im * im;
+        float diff_im = next_im * re - next_re * im;
+        float norm = sqrtf(diff_re * diff_re + diff_im * diff_im);
+
+        mf->diff_cos[k] *= keep;
+        mf->diff_sin[k] *= keep;
+        mf->diff_weight[k] *= keep;
+
+        if (norm > 0) {
+            mf->diff_cos[k] += alpha * diff_re / norm;
+            mf->diff_sin[k] += alpha * diff_im / norm;
+            mf->diff_weight[k] += alpha;
+        }
+    }
+}
+
+static void CSI_HOT_ATTR motion_features_doppler(motion_features_t *mf, motion_features_vector_t *vector)
+{
+    uint16_t window_len = mf->config.window_len;
+    uint8_t doppler_num = window_len / 2;
+    float energy = 0;
+    Complex x[FFT_MAX_N];
+
+    memset(vector->doppler, 0, sizeof(vector->doppler));
+
+    for (int t = 0; t < mf->config.tap_num; t++) {
+        const Complex *ring = mf->history + t * window_len;
+        Complex mean = {0, 0};
+
+        for (int n = 0; n < window_len; n++) {
+            mean.real += ring[n].real;
+            mean.imag += ring[n].imag;
+            energy += ring[n].real * ring[n].real + ring[n].imag * ring[n].imag;
+        }
+
+        mean.real /= window_len;
+        mean.imag /= window_len;
+
+        /* Oldest first, the ring is full and head is its oldest slot */
+        for (int n = 0; n < window_len; n++) {
+            const Complex *h = &ring[(mf->head + n) & (window_len - 1)];
+
+            x[n].real = (h->real - mean.real) * mf->window[n];
+            x[n].imag = (h->imag - mean.imag) * mf->window[n];
+        }
+
+        fft(x, window_len, 0);
+
+        /* Approaching and receding paths fold into the same rate */
+        for (int k = 1; k <= doppler_num; k++) {
+            float power = x[k].real * x[k].real + x[k].imag * x[k].imag;
+
+            if (k < doppler_num) {
+                power += x[window_len - k].real * x[window_len - k].real
+                         + x[window_len - k].imag * x[window_len - k].imag;
+            }
+
+            vector->doppler[k - 1] += power;
+        }
+    }
+
+    /* Parseval: a tap that is all motion gives a sum near 1 */
+    float scale = energy > 0 ? 1.0f / (energy * mf->window_energy) : 0;
+
+    vector->doppler_num = doppler_num;
+    vector->motion_energy = 0;
+
+    for (int k = 0; k < doppler_num; k++) {
+        vector->doppler[k] *= scale;
+        vector->motion_energy += vector->doppler[k];
+    }
+}
+
+static void CSI_HOT_ATTR motion_features_amplitude(const motion_features_t *mf, motion_features_vector_t *vector)
+{
+    uint8_t band_num = mf->config.band_num;
+
+    vector->band_num = band_num;
+
+    for (int b = 0; b < band_num; b++) {
+        float sum = 0;
+        int count = 0;
+
+        for (int k = b * FFT_MAX_N / band_num; k < (b + 1) * FFT_MAX_N / band_num; k++) {
+            float mean = mf->amp_mean[k];
+
+            if (mean >= MOTION_FEATURES_AMP_MIN) {
+                sum += mf->amp_variance[k] / (mean * mean);
+                count++;
+            }
+        }
+
+        vector->amp_variance[b] = count ? sum / count : 0;
+    }
+}
+
+static void CSI_HOT_ATTR motion_features_phase(const motion_features_t *mf, motion_features_vector_t *vector)
+{
+    float cos_sum = 0;
+    float sin_sum = 0;
+    float variance = 0;
+    int count = 0;
+
+    for (int k = 0; k < FFT_MAX_N - 1; k++) {
+        float weight = mf->diff_weight[k];
+
+        if (weight <= 0) {
+            continue;
+        }
+
+        float c = mf->diff_cos[k] / weight;
+        float s = mf->diff_sin[k] / weight;
+
+        cos_sum += c;
+        sin_sum += s;
+        variance += 1.0f - sqrtf(c * c + s * s);
+        count++;
+    }
+
+    vector->phase_diff_mean = count ? atan2f(sin_sum, cos_sum) : 0;
+    vector->phase_diff_variance = count ? variance / count : 0;
+}
+
+bool CSI_HOT_ATTR motion_features_push(motion_features_t *mf, const int8_t *csi, uint16_t len, motion_features_vector_t *vector)
+{
+    uint16_t window_len = mf->config.window_len;
+    int8_t padded[2 * FFT_MAX_N];
+    Complex_Iq taps[MOTION_FEATURES_TAP_MAX];
+
+    if (len < 2 * FFT_MAX_N) {
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, csi, len & ~1);
+        csi = padded;
+    }
+
+    cir_taps_iq(csi, s_taps, mf->config.tap_num, taps);
+
+    for (int t = 0; t < mf->config.tap_num; t++) {
+        Complex *h = &mf->history[t * window_len + mf->head];
+
+        h->real = taps[t].real / 65536.0f;
+        h->imag = taps[t].imag / 65536.0f;
+    }
+
+    motion_features_update_stats(mf, csi);
+
+    mf->head = (mf->head + 1) & (window_len - 1);
+    mf->frames++;
+
+    if (mf->since_vector < UINT16_MAX) {
+        mf->since_vector++;
+    }
+
+    if (mf->frames < window_len || mf->since_vector < mf->config.interval) {
+        return false;
+    }
+
+    vector->seq = mf->seq++;
+    vector->frames = mf->since_vector;
+    mf->since_vector = 0;
+
+    motion_features_doppler(mf, vector);
+    motion_features_amplitude(mf, vector);
+    motion_features_phase(mf, vector);
+
+    return true;
+}
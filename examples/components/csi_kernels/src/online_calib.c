@@ -0,0 +1,174 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file online_calib.c
+ * @brief Streaming calibration of the presence thresholds in constant memory
+ */
+
+#include <math.h>
+#include <string.h>
+#include <sys/param.h>
+#include "online_calib.h"
+
+void p2_quantile_init(p2_quantile_t *q, float p)
+{
+    memset(q, 0, sizeof(p2_quantile_t));
+    q->p = MIN(MAX(p, 0.0f), 1.0f);
+
+    for (int i = 0; i < P2_QUANTILE_MARKERS; i++) {
+        q->position[i] = i;
+    }
+
+    q->desired[0] = 0;
+    q->desired[1] = 2 * q->p;
+    q->desired[2] = 4 * q->p;
+    q->desired[3] = 2 + 2 * q->p;
+    q->desired[4] = 4;
+}
+
+/* Piecewise-parabolic prediction of marker i moved by d, d is -1 or 1 */
+static float p2_parabolic(const p2_quantile_t *q, int i, int d)
+{
+    const float *h = q->height;
+    const int32_t *n = q->position;
+
+    return h[i] + (float)d / (n[i + 1] - n[i - 1])
+           * ((n[i] - n[i - 1] + d) * (h[i + 1] - h[i]) / (n[i + 1] - n[i])
+              + (n[i + 1] - n[i] - d) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+}
+
+void p2_quantile_push(p2_quantile_t *q, float value)
+{
+    float *h = q->height;
+    int32_t *n = q->position;
+
+    if (isnan(value)) {
+        return;
+    }
+
+    /* Insertion sort of the first samples, they become the initial markers */
+    if (q->count < P2_QUANTILE_MARKERS) {
+        int i = q->count++;
+
+        for (; i > 0 && h[i - 1] > value; i--) {
+            h[i] = h[i - 1];
+        }
+        h[i] = value;
+        return;
+    }
+
+    int k;
+    if (value < h[0]) {
+        h[0] = value;
+        k = 0;
+    } else if (value >= h[4]) {
+        h[4] = value;
+        k = 3;
+    } else {
+        for (k = 0; k < 3 && value >= h[k + 1]; k++) {
+        }
+    }
+
+    q->count++;
+    for (int i = k + 1; i < P2_QUANTILE_MARKERS; i++) {
+        n[i]++;
+    }
+
+    /* Desired positions grow by 0, p/2, p, (1+p)/2 and 1 per sample */
+    q->desired[1] += q->p / 2;
+    q->desired[2] += q->p;
+    q->desired[3] += (1 + q->p) / 2;
+    q->desired[4] += 1;
+
+    for (int i = 1; i < P2_QUANTILE_MARKERS - 1; i++) {
+        float offset = q->desired[i] - n[i];
+
+        if ((offset >= 1 && n[i + 1] - n[i] > 1) || (offset <= -1 && n[i - 1] - n[i] < -1)) {
+            int d = offset > 0 ? 1 : -1;
+            float height = p2_parabolic(q, i, d);
+
+            /* Fall back to linear when the parabola leaves the neighbours' bracket */
+            if (!(h[i - 1] < height && height < h[i + 1])) {
+                height = h[i] + d * (h[i + d] - h[i]) / (n[i + d] - n[i]);
+            }
+
+            h[i] = height;
+            n[i] += d;
+        }
+    }
+}
+
+float p2_quantile_get(const p2_quantile_t *q)
+{
+    if (q->count >= P2_QUANTILE_MARKERS) {
+        return q->height[2];
+    }
+
+    if (!q->count) {
+        return 0;
+    }
+
+    /* Nearest rank of the sorted samples */
+    int rank = (int)ceilf(q->p * q->count) - 1;
+    return q->height[MIN(MAX(rank, 0), (int)q->count - 1)];
+}
+
+void online_calib_init(online_calib_t *calib, const online_calib_config_t *config)
+{
+    const online_calib_config_t config_default = ONLINE_CALIB_CONFIG_DEFAULT();
+
+    calib->config = config ? *config : config_default;
+    calib->config.target_samples = MAX(calib->config.target_samples, ONLINE_CALIB_MIN_SAMPLES);
+    online_calib_reset(calib);
+}
+
+void online_calib_reset(online_calib_t *calib)
+{
+    welford_reset(&calib->wander);
+    welford_reset(&calib->jitter);
+    p2_quantile_init(&calib->wander_level, calib->config.quantile);
+    p2_quantile_init(&calib->jitter_level, calib->config.quantile);
+}
+
+void online_calib_push(online_calib_t *calib, float wander, float jitter)
+{
+    if (isnan(wander) || isnan(jitter)) {
+        return;
+    }
+
+    welford_push(&calib->wander, wander);
+    welford_push(&calib->jitter, jitter);
+    p2_quantile_push(&calib->wander_level, wander);
+    p2_quantile_push(&calib->jitter_level, jitter);
+}
+
+/* Standard error of the mean relative to the mean, 1 when the mean is 0 */
+static float online_calib_relative_error(const welford_t *w)
+{
+    float mean = fabsf(w->mean);
+
+    if (w->count < 2 || mean == 0) {
+        return 1;
+    }
+
+    return MIN(sqrtf(welford_variance(w) / w->count) / mean, 1.0f);
+}
+
+void online_calib_get(const online_calib_t *calib, online_calib_result_t *result)
+{
+    uint32_t samples = calib->wander.count;
+    float error = MAX(online_calib_relative_error(&calib->wander), online_calib_relative_error(&calib->jitter));
+
+    result->samples = samples;
+    result->progress = MIN((float)samples / calib->config.target_samples, 1.0f);
+    result->confidence = result->progress * (1 - error);
+    result->wander_mean = calib->wander.mean;
+    result->wander_std = sqrtf(welford_variance(&calib->wander));
+    result->wander_threshold = p2_quantile_get(&calib->wander_level);
+    result->jitter_mean = calib->jitter.mean;
+    result->jitter_std = sqrtf(welford_variance(&calib->jitter));
+    result->jitter_threshold = p2_quantile_get(&calib->jitter_level);
+}
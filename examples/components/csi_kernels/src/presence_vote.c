@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file presence_vote.c
+ * @brief Confidence-weighted vote over the detection results of several links
+ */
+
+#include <sys/param.h>
+#include "presence_vote.h"
+
+float presence_vote_weight(const presence_vote_config_t *config, bool has_rssi, int8_t rssi, uint32_t age_ms)
+{
+    float weight = 1.0f;
+
+    if (age_ms >= config->timeout_ms) {
+        return 0;
+    }
+
+    if (has_rssi) {
+        weight = (float)(rssi - config->rssi_floor_dbm) / config->rssi_span_db;
+        weight = MIN(MAX(weight, config->rssi_weight_min), 1.0f);
+    }
+
+    return weight * (1.0f - (float)age_ms / config->timeout_ms);
+}
+
+void presence_vote_fuse(const presence_vote_config_t *config, const presence_vote_t *votes, size_t vote_num,
+                        bool *room_status, bool *human_status)
+{
+    float total_weight = 0;      /* Sum of the weights of the voting links */
+    float detection_weight = 0;  /* Links detecting anything (presence or motion) */
+    float motion_weight = 0;     /* Links detecting motion specifically */
+
+    for (size_t i = 0; i < vote_num; i++) {
+        total_weight += votes[i].weight;
+
+        if (votes[i].room_status || votes[i].human_status) {
+            detection_weight += votes[i].weight;
+        }
+        if (votes[i].human_status) {
+            motion_weight += votes[i].weight;
+        }
+    }
+
+    *room_status = total_weight > 0 && detection_weight > total_weight * config->ratio;
+    *human_status = *room_status && motion_weight > total_weight * config->ratio;
+}
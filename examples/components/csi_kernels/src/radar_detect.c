@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file radar_detect.c
+ * @brief Presence and motion decision on the esp-radar wander/jitter waveforms
+ */
+
+#include <sys/param.h>
+#include "radar_detect.h"
+
+bool radar_detect_update(const radar_detect_config_t *config, radar_window_t *wander_win, radar_window_t *jitter_win,
+                         float wander, float jitter, radar_detect_result_t *result)
+{
+    bool wander_valid = !config->calibrated_only || config->wander_threshold > RADAR_DETECT_THRESHOLD_MIN;
+    bool jitter_valid = !config->calibrated_only || config->jitter_threshold > RADAR_DETECT_THRESHOLD_MIN;
+    uint32_t vote_len = MIN(config->vote_len, jitter_win->size);
+    uint32_t move_count = 0;
+
+    radar_window_push(wander_win, wander);
+    radar_window_push(jitter_win, jitter);
+
+    if (jitter_win->count < vote_len) {
+        return false;
+    }
+
+    result->wander_average = radar_window_trimmean(wander_win, 0.5f);
+    result->jitter_median = radar_window_median(jitter_win);
+
+    for (uint32_t i = 0; jitter_valid && i < vote_len; i++) {
+        float sample = radar_window_recent(jitter_win, i);
+        float value = sample * config->jitter_sensitivity;
+
+        if (value > config->jitter_threshold
+                || (value > result->jitter_median && sample > RADAR_DETECT_JITTER_FLOOR)) {
+            move_count++;
+        }
+    }
+
+    result->room_status = wander_valid
+                          && result->wander_average * config->wander_sensitivity > config->wander_threshold;
+    result->human_status = jitter_valid && move_count >= config->move_votes;
+
+    return true;
+}
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file radar_window.c
+ * @brief Sliding-window order statistics for radar post-processing
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "csi_attr.h"
+#include "radar_window.h"
+
+/* First index in sorted[0, n) whose value is not less than value */
+static uint16_t CSI_HOT_ATTR lower_bound(const float *sorted, uint16_t n, float value)
+{
+    uint16_t lo = 0, hi = n;
+
+    while (lo < hi) {
+        uint16_t mid = lo + (hi - lo) / 2;
+
+        if (sorted[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static void CSI_HOT_ATTR sorted_insert(radar_window_t *win, float value)
+{
+    uint16_t pos = lower_bound(win->sorted, win->count, value);
+    memmove(win->sorted + pos + 1, win->sorted + pos, (win->count - pos) * sizeof(float));
+    win->sorted[pos] = value;
+    win->count++;
+}
+
+static void CSI_HOT_ATTR sorted_remove(radar_window_t *win, float value)
+{
+    uint16_t pos = lower_bound(win->sorted, win->count, value);
+
+    if (pos >= win->count) {
+        pos = win->count - 1;
+    }
+
+    memmove(win->sorted + pos, win->sorted + pos + 1, (win->count - pos - 1) * sizeof(float));
+    win->count--;
+}
+
+esp_err_t radar_window_init(radar_window_t *win, float *storage, uint16_t capacity, uint16_t size)
+{
+    if (!win || !storage || !size || size > capacity) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    win->ring     = storage;
+    win->sorted   = storage + capacity;
+    win->capacity = capacity;
+    win->size     = size;
+    radar_window_reset(win);
+
+    return ESP_OK;
+}
+
+void radar_window_reset(radar_window_t *win)
+{
+    win->count = 0;
+    win->head  = 0;
+    win->total = 0;
+}
+
+esp_err_t radar_window_set_size(radar_window_t *win, uint16_t size)
+{
+    if (!size || size > win->capacity) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (size == win->size) {
+        return ESP_OK;
+    }
+
+    uint16_t keep = win->count < size ? win->count : size;
+
+    /* Use the sorted half as scratch to linearize the newest samples, oldest first */
+    for (uint16_t i = 0; i < keep; i++) {
+        win->sorted[i] = radar_window_recent(win, keep - 1 - i);
+    }
+
+    memcpy(win->ring, win->sorted, keep * sizeof(float));
+
+    win->size  = size;
+    win->head  = keep % size;
+    win->count = 0;
+
+    for (uint16_t i = 0; i < keep; i++) {
+        sorted_insert(win, win->ring[i]);
+    }
+
+    return ESP_OK;
+}
+
+void CSI_HOT_ATTR radar_window_push(radar_window_t *win, float value)
+{
+    if (isnan(value)) {
+        return;
+    }
+
+    if (win->count == win->size) {
+        /* Ring is full: ring[head] is the oldest sample */
+        sorted_remove(win, win->ring[win->head]);
+    }
+
+    win->ring[win->head] = value;
+    win->head = (win->head + 1) % win->size;
+    sorted_insert(win, value);
+    win->total++;
+}
+
+float radar_window_recent(const radar_window_t *win, uint16_t age)
+{
+    if (age >= win->count) {
+        return 0.0f;
+    }
+
+    return win->ring[(win->head + win->size - 1 - age) % win->size];
+}
+
+float radar_window_trimmean(const radar_window_t *win, float percent)
+{
+    uint16_t trim = (uint16_t)(win->count * percent / 2);
+
+    if (win->count <= 2 * trim) {
+        return 0.0f;
+    }
+
+    float sum = 0;
+
+    for (uint16_t i = trim; i < win->count - trim; i++) {
+        sum += win->sorted[i];
+    }
+
+    return sum / (win->count - 2 * trim);
+}
+
+float radar_window_quantile(const radar_window_t *win, float q)
+{
+    if (win->count == 0) {
+        return 0.0f;
+    }
+
+    if (q <= 0.0f) {
+        return win->sorted[0];
+    }
+
+    if (q >= 1.0f) {
+        return win->sorted[win->count - 1];
+    }
+
+    float rank  = q * (win->count - 1);
+    uint16_t lo = (uint16_t)rank;
+    float frac  = rank - lo;
+
+    if (lo + 1 >= win->count) {
+        return win->sorted[lo];
+    }
+
+    return win->sorted[lo] + (win->sorted[lo + 1] - win->sorted[lo]) * frac;
+}
@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_boot.h
+ * @brief Staged boot: independent init steps in parallel, and timestamped milestones
+ *
+ * Every milestone keeps the time since reset it was first reached at, so the
+ * time to the first detection after a power cut can be read back, and
+ * compared between firmware versions. The steps of one stage run in tasks of
+ * their pipeline stage at the same time, the stage ends when all are done.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "csi_task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_BOOT_MILESTONE_MAX  16
+
+typedef struct {
+    const char *name;           /**< Static string */
+    int64_t time_us;            /**< Since reset */
+} csi_boot_milestone_t;
+
+typedef struct {
+    const char *name;           /**< Milestone reached when the step returns */
+    esp_err_t (*init)(void *arg);
+    void *arg;
+    csi_task_stage_t stage;
+    uint32_t stack_size;
+} csi_boot_step_t;
+
+/**
+ * @brief Record a milestone, only its first time counts
+ *
+ * Safe from any task. Names are compared by content, so a literal may be
+ * passed from several places.
+ */
+void csi_boot_mark(const char *name);
+
+/**
+ * @brief Time since reset a milestone was reached at, -1 if not yet
+ */
+int64_t csi_boot_get_us(const char *name);
+
+/**
+ * @brief Run the steps at the same time and wait until all returned
+ *
+ * @return
+ *      - ESP_OK when every step succeeded
+ *      - The error of the first failing step
+ *      - ESP_ERR_NO_MEM if a task could not be created, its step then runs in the caller
+ */
+esp_err_t csi_boot_run_parallel(const csi_boot_step_t *steps, size_t num);
+
+/**
+ * @brief Copy the milestones in the order they were reached
+ *
+ * @return Number copied
+ */
+size_t csi_boot_get_milestones(csi_boot_milestone_t *milestones, size_t max);
+
+/**
+ * @brief Format the milestones as {"milestones":[{"name":..,"ms":..},..]}
+ *
+ * @return Length written, without the terminator
+ */
+int csi_boot_json(char *buf, size_t size);
+
+/**
+ * @brief Log the milestones with the time from each one to the next
+ */
+void csi_boot_log(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_diag.h
+ * @brief Periodic samples of the task CPU shares, stack use and heap of each capability
+ *
+ * A background task samples every interval. The heap of each capability,
+ * internal, DMA and PSRAM, goes into a ring of history_len samples on
+ * caller storage: free bytes, largest free block and lowest free ever.
+ * A fit of the free bytes over the ring gives the erosion per hour, which
+ * the per-packet allocations leave behind. The task table keeps, per task,
+ * the CPU share of the last interval and the highest seen, and the stack
+ * high-water mark next to the stack size of the tasks csi_task_create()
+ * made, so a blanket 4096 can be cut to what a task really uses.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_DIAG_TASK_MAX           32      /**< Tasks kept in the task table */
+#define CSI_DIAG_TASK_NAME_LEN      16
+
+typedef enum {
+    CSI_DIAG_CAPS_INTERNAL = 0,
+    CSI_DIAG_CAPS_DMA,
+    CSI_DIAG_CAPS_PSRAM,
+    CSI_DIAG_CAPS_MAX,
+} csi_diag_caps_t;
+
+typedef struct {
+    uint32_t interval_ms;           /**< Between two samples */
+    uint16_t history_len;           /**< Samples kept in the ring */
+} csi_diag_config_t;
+
+#define CSI_DIAG_CONFIG_DEFAULT() { \
+    .interval_ms = 60000, \
+    .history_len = 60, \
+}
+
+typedef struct {
+    uint32_t free;
+    uint32_t largest_free;          /**< Largest block a single allocation can get */
+    uint32_t min_free;              /**< Lowest free since boot */
+} csi_diag_heap_t;
+
+typedef struct {
+    uint32_t time_ms;               /**< esp_log_timestamp() of the sample */
+    uint16_t cpu_permille;          /**< Busy share of all cores in the interval, 0 without run time statistics */
+    uint16_t task_num;
+    csi_diag_heap_t heap[CSI_DIAG_CAPS_MAX];
+} csi_diag_sample_t;
+
+typedef struct {
+    char name[CSI_DIAG_TASK_NAME_LEN];
+    const char *stage;              /**< csi_task_stage_name(), "-" for tasks made elsewhere */
+    uint8_t priority;
+    int8_t core;                    /**< -1 if not pinned */
+    bool alive;                     /**< Still in the last sample */
+    uint32_t stack_size;            /**< Bytes, 0 if not made by csi_task_create() */
+    uint32_t stack_free_min;        /**< High-water mark: bytes never used */
+    uint16_t cpu_permille;          /**< Of one core, in the last interval */
+    uint16_t cpu_max_permille;      /**< Highest interval share seen */
+} csi_diag_task_t;
+
+/**
+ * @brief Start sampling into caller-provided history storage, takes one sample right away
+ *
+ * @param storage Array of config->history_len samples
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL, the interval or the length is 0
+ *      - ESP_ERR_INVALID_STATE if already started
+ *      - ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t csi_diag_init(const csi_diag_config_t *config, csi_diag_sample_t *storage);
+
+/**
+ * @brief Take a sample now instead of waiting for the interval
+ */
+void csi_diag_sample(void);
+
+/**
+ * @brief Copy up to max samples of the ring, oldest first
+ *
+ * @return Samples copied
+ */
+size_t csi_diag_get_history(csi_diag_sample_t *samples, size_t max);
+
+/**
+ * @brief Copy the task table, in the order the tasks were first seen
+ *
+ * @return Tasks copied
+ */
+size_t csi_diag_get_tasks(csi_diag_task_t *tasks, size_t max);
+
+/**
+ * @brief Share of the free bytes not in the largest block, in permille
+ */
+uint16_t csi_diag_fragmentation_permille(const csi_diag_heap_t *heap);
+
+/**
+ * @brief Least-squares slope of the free bytes of a capability over the ring
+ *
+ * @return Bytes per hour, negative while the heap erodes, 0 with fewer than two samples
+ */
+int32_t csi_diag_heap_trend(csi_diag_caps_t caps);
+
+/**
+ * @brief Print the task table, the latest heap of each capability and its trend with ESP_LOGI
+ *
+ * @param history Also print every sample of the ring
+ */
+void csi_diag_print(bool history);
+
+/**
+ * @brief Buffer size csi_diag_json() needs with a full task table and ring
+ */
+size_t csi_diag_json_len(bool history);
+
+/**
+ * @brief Write the tasks and the latest heaps as a JSON object
+ *
+ * @param history Also write the ring as "history", one array per sample:
+ *                time_ms, cpu_permille, task_num, then free, largest_free
+ *                and min_free of each capability
+ *
+ * @return Length written without the terminator, truncated to size - 1
+ */
+int csi_diag_json(char *buf, size_t size, bool history);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_task.h
+ * @brief Priority and core of each stage of the CSI pipeline
+ *
+ * Tasks are created per stage instead of with hand-picked priorities. The
+ * priorities come from Kconfig and form bands, from decoding down to
+ * housekeeping, so a single-core C5/C6 serves the CSI path first. On a
+ * dual-core chip, CONFIG_CSI_TASK_PIN_TO_CORE puts decoding on the core
+ * without the Wi-Fi task, and the UI and HTTP server on the Wi-Fi core.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CSI_TASK_STAGE_DECODE,          /**< Draining and processing the CSI frames */
+    CSI_TASK_STAGE_LINK,            /**< UART and ESP-NOW links between boards */
+    CSI_TASK_STAGE_FUSION,          /**< Joining and fusing several receivers */
+    CSI_TASK_STAGE_OUTPUT,          /**< Serial output, WebSocket push */
+    CSI_TASK_STAGE_UI,              /**< Display, HTTP server */
+    CSI_TASK_STAGE_BACKGROUND,      /**< LEDs, test servers, housekeeping */
+    CSI_TASK_STAGE_MAX,
+} csi_task_stage_t;
+
+/**
+ * @brief Priority of a stage
+ */
+UBaseType_t csi_task_priority(csi_task_stage_t stage);
+
+/**
+ * @brief Core of a stage, tskNO_AFFINITY when it is not pinned
+ */
+BaseType_t csi_task_core(csi_task_stage_t stage);
+
+/**
+ * @brief Name of a stage, for logs
+ */
+const char *csi_task_stage_name(csi_task_stage_t stage);
+
+/**
+ * @brief Create a task with the priority and core of its stage
+ *
+ * The task is remembered with its stage for csi_task_log_usage().
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the stage is unknown
+ *      - ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t csi_task_create(TaskFunction_t task, const char *name, uint32_t stack_size, void *arg,
+                          csi_task_stage_t stage, TaskHandle_t *handle);
+
+/**
+ * @brief Remember a task created elsewhere, e.g. by a driver or library, with its stage
+ */
+void csi_task_register(TaskHandle_t handle, csi_task_stage_t stage);
+
+/**
+ * @brief Stage and stack size of a task made by csi_task_create() or remembered by csi_task_register()
+ *
+ * @param stack_size Bytes, 0 for a task registered with csi_task_register()
+ *
+ * @return false if the task is unknown
+ */
+bool csi_task_lookup(TaskHandle_t handle, csi_task_stage_t *stage, uint32_t *stack_size);
+
+/**
+ * @brief Log the priority and core of every stage
+ */
+void csi_task_log_topology(void);
+
+/**
+ * @brief Log the CPU share of every task since the previous call, or since boot on the first one
+ *
+ * Shares are in percent of one core, so they add up to 100 times the core
+ * count. Needs CONFIG_FREERTOS_USE_TRACE_FACILITY and
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_SUPPORTED if the run time statistics are disabled
+ *      - ESP_ERR_NO_MEM if the task list could not be allocated
+ */
+esp_err_t csi_task_log_usage(void);
+
+#ifdef __cplusplus
+}
+#endif
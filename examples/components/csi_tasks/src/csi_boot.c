@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_boot.c
+ * @brief Staged boot: independent init steps in parallel, and timestamped milestones
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "csi_boot.h"
+
+#define CSI_BOOT_STEP_MAX   8
+
+static const char *TAG = "csi_boot";
+
+static csi_boot_milestone_t s_milestones[CSI_BOOT_MILESTONE_MAX];
+static uint8_t s_milestone_num = 0;
+static portMUX_TYPE s_milestone_lock = portMUX_INITIALIZER_UNLOCKED;
+
+typedef struct {
+    const csi_boot_step_t *step;
+    esp_err_t ret;
+    SemaphoreHandle_t done;
+} csi_boot_job_t;
+
+void csi_boot_mark(const char *name)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_milestone_lock);
+    bool known = false;
+
+    for (int i = 0; i < s_milestone_num && !known; i++) {
+        known = !strcmp(s_milestones[i].name, name);
+    }
+
+    if (!known && s_milestone_num < CSI_BOOT_MILESTONE_MAX) {
+        s_milestones[s_milestone_num++] = (csi_boot_milestone_t) {
+            .name = name, .time_us = now
+        };
+    }
+    portEXIT_CRITICAL(&s_milestone_lock);
+}
+
+int64_t csi_boot_get_us(const char *name)
+{
+    int64_t time_us = -1;
+
+    portENTER_CRITICAL(&s_milestone_lock);
+    for (int i = 0; i < s_milestone_num; i++) {
+        if (!strcmp(s_milestones[i].name, name)) {
+            time_us = s_milestones[i].time_us;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_milestone_lock);
+
+    return time_us;
+}
+
+static void csi_boot_step_task(void *arg)
+{
+    csi_boot_job_t *job = arg;
+
+    job->ret = job->step->init(job->step->arg);
+    csi_boot_mark(job->step->name);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t csi_boot_run_parallel(const csi_boot_step_t *steps, size_t num)
+{
+    csi_boot_job_t jobs[CSI_BOOT_STEP_MAX];
+    esp_err_t ret = ESP_OK;
+    size_t started = 0;
+
+    if (!steps || num > CSI_BOOT_STEP_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(num, 0);
+
+    if (!done) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Not registered with csi_task, the tasks are gone once the stage ends */
+    for (size_t i = 0; i < num; i++) {
+        jobs[i] = (csi_boot_job_t) {
+            .step = &steps[i], .ret = ESP_OK, .done = done
+        };
+
+        if (xTaskCreatePinnedToCore(csi_boot_step_task, steps[i].name, steps[i].stack_size, &jobs[i],
+                                    csi_task_priority(steps[i].stage), NULL, csi_task_core(steps[i].stage)) == pdPASS) {
+            started++;
+            continue;
+        }
+
+        ESP_LOGW(TAG, "No task for %s, running it in place", steps[i].name);
+        jobs[i].ret = steps[i].init(steps[i].arg);
+        csi_boot_mark(steps[i].name);
+
+        if (ret == ESP_OK) {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+
+    for (size_t i = 0; i < started; i++) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+
+    vSemaphoreDelete(done);
+
+    for (size_t i = 0; i < num; i++) {
+        if (jobs[i].ret != ESP_OK) {
+            ESP_LOGE(TAG, "<%s> %s", esp_err_to_name(jobs[i].ret), steps[i].name);
+            return jobs[i].ret;
+        }
+    }
+
+    return ret;
+}
+
+size_t csi_boot_get_milestones(csi_boot_milestone_t *milestones, size_t max)
+{
+    portENTER_CRITICAL(&s_milestone_lock);
+    size_t num = MIN(max, s_milestone_num);
+    memcpy(milestones, s_milestones, num * sizeof(*milestones));
+    portEXIT_CRITICAL(&s_milestone_lock);
+
+    return num;
+}
+
+int csi_boot_json(char *buf, size_t size)
+{
+    csi_boot_milestone_t milestones[CSI_BOOT_MILESTONE_MAX];
+    size_t num = csi_boot_get_milestones(milestones, CSI_BOOT_MILESTONE_MAX);
+    int len = snprintf(buf, size, "{\"milestones\":[");
+
+    for (size_t i = 0; i < num && len < (int)size; i++) {
+        len += snprintf(buf + len, size - len, "%s{\"name\":\"%s\",\"ms\":%lu}", i ? "," : "",
+                        milestones[i].name, (unsigned long)(milestones[i].time_us / 1000));
+    }
+
+    if (len < (int)size) {
+        len += snprintf(buf + len, size - len, "]}");
+    }
+
+    return MIN(len, (int)size - 1);
+}
+
+void csi_boot_log(void)
+{
+    csi_boot_milestone_t milestones[CSI_BOOT_MILESTONE_MAX];
+    size_t num = csi_boot_get_milestones(milestones, CSI_BOOT_MILESTONE_MAX);
+
+    for (size_t i = 0; i < num; i++) {
+        ESP_LOGI(TAG, "%-16s %6lu ms  +%lu ms", milestones[i].name, (unsigned long)(milestones[i].time_us / 1000),
+                 (unsigned long)((milestones[i].time_us - (i ? milestones[i - 1].time_us : 0)) / 1000));
+    }
+}
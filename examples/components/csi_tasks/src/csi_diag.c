@@ -0,0 +1,500 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_diag.c
+ * @brief Periodic samples of the task CPU shares, stack use and heap of each capability
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/param.h>
+
+#include "sdkconfig.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "csi_diag.h"
+#include "csi_task.h"
+
+#define CSI_DIAG_TASK_STACK         3072
+#define CSI_DIAG_MS_PER_HOUR        3600000.0f
+#define CSI_DIAG_JSON_HEAD_LEN      640     /* Uptime, interval and the heap of every capability */
+#define CSI_DIAG_JSON_TASK_LEN      200
+#define CSI_DIAG_JSON_SAMPLE_LEN    144
+
+static const char *TAG = "csi_diag";
+
+static const struct {
+    const char *name;
+    uint32_t caps;
+} s_caps[CSI_DIAG_CAPS_MAX] = {
+    [CSI_DIAG_CAPS_INTERNAL] = {"internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT},
+    [CSI_DIAG_CAPS_DMA]      = {"dma",      MALLOC_CAP_DMA},
+    [CSI_DIAG_CAPS_PSRAM]    = {"psram",    MALLOC_CAP_SPIRAM},
+};
+
+/* The ring and the task table are read by any task under s_diag_lock, samples are taken under sample_mutex */
+static struct {
+    csi_diag_config_t config;
+    csi_diag_sample_t *history;
+    uint16_t head;                  /* Next slot of the ring */
+    uint16_t count;
+    csi_diag_task_t tasks[CSI_DIAG_TASK_MAX];
+    TaskHandle_t handles[CSI_DIAG_TASK_MAX];
+    uint32_t run_time[CSI_DIAG_TASK_MAX];   /* Counter at the previous sample */
+    uint8_t task_num;
+    uint32_t prev_total;
+    SemaphoreHandle_t sample_mutex;
+    TaskHandle_t task;
+} s_diag;
+
+static portMUX_TYPE s_diag_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+/* Sampling the heap must not use it, so the task list is static */
+static TaskStatus_t s_status[CSI_DIAG_TASK_MAX];
+
+static int csi_diag_task_slot(TaskHandle_t handle)
+{
+    for (int i = 0; i < s_diag.task_num; i++) {
+        if (s_diag.handles[i] == handle) {
+            return i;
+        }
+    }
+
+    /* A new task takes a free slot, then the slot of a task that is gone */
+    if (s_diag.task_num < CSI_DIAG_TASK_MAX) {
+        return s_diag.task_num++;
+    }
+
+    for (int i = 0; i < CSI_DIAG_TASK_MAX; i++) {
+        if (!s_diag.tasks[i].alive) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Returns the busy share of all cores, the idle tasks are the rest */
+static uint16_t csi_diag_sample_tasks(uint16_t *task_num)
+{
+    uint32_t total = 0;
+    uint64_t busy = 0;
+    UBaseType_t num = uxTaskGetSystemState(s_status, CSI_DIAG_TASK_MAX, &total);
+
+    /* 0 when there are more tasks than the list holds */
+    if (!num) {
+        ESP_LOGW(TAG, "More than %d tasks, raise CSI_DIAG_TASK_MAX", CSI_DIAG_TASK_MAX);
+    }
+
+    uint32_t elapsed = total - s_diag.prev_total;
+    s_diag.prev_total = total;
+    *task_num = num;
+
+    portENTER_CRITICAL(&s_diag_lock);
+
+    for (int i = 0; i < s_diag.task_num; i++) {
+        s_diag.tasks[i].alive = false;
+    }
+
+    for (int i = 0; i < num; i++) {
+        const TaskStatus_t *status = &s_status[i];
+        int slot = csi_diag_task_slot(status->xHandle);
+
+        if (slot < 0) {
+            continue;
+        }
+
+        csi_diag_task_t *task = &s_diag.tasks[slot];
+
+        if (s_diag.handles[slot] != status->xHandle) {
+            csi_task_stage_t stage;
+
+            memset(task, 0, sizeof(csi_diag_task_t));
+            strlcpy(task->name, status->pcTaskName, sizeof(task->name));
+            task->stage = csi_task_lookup(status->xHandle, &stage, &task->stack_size) ? csi_task_stage_name(stage) : "-";
+            s_diag.handles[slot] = status->xHandle;
+            s_diag.run_time[slot] = status->ulRunTimeCounter;
+        }
+
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+        task->core = status->xCoreID == tskNO_AFFINITY ? -1 : (int8_t)status->xCoreID;
+#else
+        task->core = -1;
+#endif
+        task->priority = status->uxCurrentPriority;
+        task->stack_free_min = status->usStackHighWaterMark;
+        task->alive = true;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        uint32_t run_time = status->ulRunTimeCounter - s_diag.run_time[slot];
+
+        s_diag.run_time[slot] = status->ulRunTimeCounter;
+        task->cpu_permille = elapsed ? MIN(1000ULL * run_time / elapsed, 1000) : 0;
+        task->cpu_max_permille = MAX(task->cpu_max_permille, task->cpu_permille);
+
+        if (strncmp(status->pcTaskName, "IDLE", 4)) {
+            busy += run_time;
+        }
+#endif
+    }
+
+    portEXIT_CRITICAL(&s_diag_lock);
+
+    return elapsed ? MIN(1000 * busy / ((uint64_t)elapsed * portNUM_PROCESSORS), 1000) : 0;
+}
+#endif
+
+void csi_diag_sample(void)
+{
+    if (!s_diag.history) {
+        return;
+    }
+
+    xSemaphoreTake(s_diag.sample_mutex, portMAX_DELAY);
+
+    csi_diag_sample_t sample = {
+        .time_ms = esp_log_timestamp(),
+    };
+
+    for (int c = 0; c < CSI_DIAG_CAPS_MAX; c++) {
+        multi_heap_info_t info;
+
+        heap_caps_get_info(&info, s_caps[c].caps);
+        sample.heap[c].free = info.total_free_bytes;
+        sample.heap[c].largest_free = info.largest_free_block;
+        sample.heap[c].min_free = info.minimum_free_bytes;
+    }
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    sample.cpu_permille = csi_diag_sample_tasks(&sample.task_num);
+#else
+    sample.task_num = uxTaskGetNumberOfTasks();
+#endif
+
+    portENTER_CRITICAL(&s_diag_lock);
+    s_diag.history[s_diag.head] = sample;
+    s_diag.head = (s_diag.head + 1) % s_diag.config.history_len;
+    s_diag.count = MIN(s_diag.count + 1, s_diag.config.history_len);
+    portEXIT_CRITICAL(&s_diag_lock);
+
+    xSemaphoreGive(s_diag.sample_mutex);
+}
+
+static void csi_diag_task(void *arg)
+{
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(s_diag.config.interval_ms));
+        csi_diag_sample();
+    }
+}
+
+esp_err_t csi_diag_init(const csi_diag_config_t *config, csi_diag_sample_t *storage)
+{
+    if (!config || !storage || !config->interval_ms || !config->history_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_diag.history) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_diag.sample_mutex = xSemaphoreCreateMutex();
+
+    if (!s_diag.sample_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_diag.config = *config;
+    s_diag.history = storage;
+    csi_diag_sample();
+
+    esp_err_t ret = csi_task_create(csi_diag_task, "csi_diag", CSI_DIAG_TASK_STACK, NULL,
+                                    CSI_TASK_STAGE_BACKGROUND, &s_diag.task);
+
+    if (ret != ESP_OK) {
+        s_diag.history = NULL;
+        vSemaphoreDelete(s_diag.sample_mutex);
+    }
+
+    return ret;
+}
+
+size_t csi_diag_get_history(csi_diag_sample_t *samples, size_t max)
+{
+    size_t num = 0;
+
+    if (!s_diag.history) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&s_diag_lock);
+    uint16_t first = (s_diag.head + s_diag.config.history_len - s_diag.count) % s_diag.config.history_len;
+
+    for (num = 0; num < MIN(max, s_diag.count); num++) {
+        samples[num] = s_diag.history[(first + num) % s_diag.config.history_len];
+    }
+    portEXIT_CRITICAL(&s_diag_lock);
+
+    return num;
+}
+
+size_t csi_diag_get_tasks(csi_diag_task_t *tasks, size_t max)
+{
+    portENTER_CRITICAL(&s_diag_lock);
+    size_t num = MIN(max, s_diag.task_num);
+    memcpy(tasks, s_diag.tasks, num * sizeof(csi_diag_task_t));
+    portEXIT_CRITICAL(&s_diag_lock);
+
+    return num;
+}
+
+uint16_t csi_diag_fragmentation_permille(const csi_diag_heap_t *heap)
+{
+    return heap->free ? 1000 - (uint16_t)(1000ULL * heap->largest_free / heap->free) : 0;
+}
+
+int32_t csi_diag_heap_trend(csi_diag_caps_t caps)
+{
+    float mean_t = 0;
+    float mean_free = 0;
+    float cov = 0;
+    float var = 0;
+    uint32_t first_ms = 0;
+    uint16_t count;
+
+    if (!s_diag.history || caps >= CSI_DIAG_CAPS_MAX) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&s_diag_lock);
+    count = s_diag.count;
+    uint16_t first = (s_diag.head + s_diag.config.history_len - count) % s_diag.config.history_len;
+
+    /* Both centered on the first sample so the floats keep their precision */
+    for (int pass = 0; pass < 2 && count >= 2; pass++) {
+        for (int i = 0; i < count; i++) {
+            const csi_diag_sample_t *sample = &s_diag.history[(first + i) % s_diag.config.history_len];
+
+            if (!i && !pass) {
+                first_ms = sample->time_ms;
+            }
+
+            float t = (sample->time_ms - first_ms) / CSI_DIAG_MS_PER_HOUR;
+            float free = (float)sample->heap[caps].free - s_diag.history[first].heap[caps].free;
+
+            if (!pass) {
+                mean_t += t / count;
+                mean_free += free / count;
+            } else {
+                cov += (t - mean_t) * (free - mean_free);
+                var += (t - mean_t) * (t - mean_t);
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_diag_lock);
+
+    return var > 0 ? (int32_t)lroundf(cov / var) : 0;
+}
+
+/* The newest sample is the one before head */
+static bool csi_diag_latest(csi_diag_sample_t *sample)
+{
+    bool valid;
+
+    if (!s_diag.history) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_diag_lock);
+    valid = s_diag.count;
+    if (valid) {
+        *sample = s_diag.history[(s_diag.head + s_diag.config.history_len - 1) % s_diag.config.history_len];
+    }
+    portEXIT_CRITICAL(&s_diag_lock);
+
+    return valid;
+}
+
+void csi_diag_print(bool history)
+{
+    csi_diag_task_t task;
+
+    ESP_LOGI(TAG, "%-16s %-10s %4s %4s %6s %6s %6s %6s %6s", "task", "stage", "core", "prio", "cpu%", "max%",
+             "stack", "used", "free");
+
+    for (size_t i = 0; i < CSI_DIAG_TASK_MAX; i++) {
+        portENTER_CRITICAL(&s_diag_lock);
+        bool valid = i < s_diag.task_num;
+        if (valid) {
+            task = s_diag.tasks[i];
+        }
+        portEXIT_CRITICAL(&s_diag_lock);
+
+        if (!valid) {
+            break;
+        }
+
+        if (!task.alive) {
+            continue;
+        }
+
+        if (task.stack_size) {
+            ESP_LOGI(TAG, "%-16s %-10s %4d %4u %5.1f%% %5.1f%% %6lu %6lu %6lu", task.name, task.stage, task.core,
+                     task.priority, task.cpu_permille / 10.0f, task.cpu_max_permille / 10.0f,
+                     (unsigned long)task.stack_size, (unsigned long)(task.stack_size - task.stack_free_min),
+                     (unsigned long)task.stack_free_min);
+        } else {
+            ESP_LOGI(TAG, "%-16s %-10s %4d %4u %5.1f%% %5.1f%% %6s %6s %6lu", task.name, task.stage, task.core,
+                     task.priority, task.cpu_permille / 10.0f, task.cpu_max_permille / 10.0f, "-", "-",
+                     (unsigned long)task.stack_free_min);
+        }
+    }
+
+    csi_diag_sample_t latest;
+
+    if (!csi_diag_latest(&latest)) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "%-10s %8s %8s %8s %6s %10s", "heap", "free", "largest", "min", "frag%", "trend/h");
+
+    for (int c = 0; c < CSI_DIAG_CAPS_MAX; c++) {
+        const csi_diag_heap_t *heap = &latest.heap[c];
+
+        ESP_LOGI(TAG, "%-10s %8lu %8lu %8lu %5.1f%% %10ld", s_caps[c].name, (unsigned long)heap->free,
+                 (unsigned long)heap->largest_free, (unsigned long)heap->min_free,
+                 csi_diag_fragmentation_permille(heap) / 10.0f, (long)csi_diag_heap_trend(c));
+    }
+
+    if (!history) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "%10s %6s %5s %8s %8s %8s %8s %8s", "time_ms", "cpu%", "tasks", "free", "largest", "min",
+             "dma", "psram");
+
+    for (uint16_t i = 0; i < s_diag.config.history_len; i++) {
+        csi_diag_sample_t sample;
+        bool valid;
+
+        portENTER_CRITICAL(&s_diag_lock);
+        valid = i < s_diag.count;
+        if (valid) {
+            uint16_t first = (s_diag.head + s_diag.config.history_len - s_diag.count) % s_diag.config.history_len;
+            sample = s_diag.history[(first + i) % s_diag.config.history_len];
+        }
+        portEXIT_CRITICAL(&s_diag_lock);
+
+        if (!valid) {
+            break;
+        }
+
+        const csi_diag_heap_t *internal = &sample.heap[CSI_DIAG_CAPS_INTERNAL];
+        ESP_LOGI(TAG, "%10lu %5.1f%% %5u %8lu %8lu %8lu %8lu %8lu", (unsigned long)sample.time_ms,
+                 sample.cpu_permille / 10.0f, sample.task_num, (unsigned long)internal->free,
+                 (unsigned long)internal->largest_free, (unsigned long)internal->min_free,
+                 (unsigned long)sample.heap[CSI_DIAG_CAPS_DMA].free,
+                 (unsigned long)sample.heap[CSI_DIAG_CAPS_PSRAM].free);
+    }
+}
+
+size_t csi_diag_json_len(bool history)
+{
+    return CSI_DIAG_JSON_HEAD_LEN + CSI_DIAG_TASK_MAX * CSI_DIAG_JSON_TASK_LEN +
+           (history ? s_diag.config.history_len * CSI_DIAG_JSON_SAMPLE_LEN : 0);
+}
+
+int csi_diag_json(char *buf, size_t size, bool history)
+{
+    csi_diag_task_t task;
+    csi_diag_sample_t sample;
+    int len = snprintf(buf, size, "{\"uptime_ms\":%lu,\"interval_ms\":%lu,\"tasks\":[",
+                       (unsigned long)esp_log_timestamp(), (unsigned long)s_diag.config.interval_ms);
+
+    for (size_t i = 0, n = 0; (size_t)len < size && i < CSI_DIAG_TASK_MAX; i++) {
+        bool valid;
+
+        portENTER_CRITICAL(&s_diag_lock);
+        valid = i < s_diag.task_num;
+        if (valid) {
+            task = s_diag.tasks[i];
+        }
+        portEXIT_CRITICAL(&s_diag_lock);
+
+        if (!valid) {
+            break;
+        }
+
+        if (!task.alive) {
+            continue;
+        }
+
+        len += snprintf(buf + len, size - len,
+                        "%s{\"name\":\"%s\",\"stage\":\"%s\",\"core\":%d,\"priority\":%u,\"cpu_permille\":%u,"
+                        "\"cpu_max_permille\":%u,\"stack_size\":%lu,\"stack_free_min\":%lu}",
+                        n++ ? "," : "", task.name, task.stage, task.core, task.priority, task.cpu_permille,
+                        task.cpu_max_permille, (unsigned long)task.stack_size, (unsigned long)task.stack_free_min);
+    }
+
+    if ((size_t)len < size) {
+        len += snprintf(buf + len, size - len, "],\"heap\":[");
+    }
+
+    bool have_latest = csi_diag_latest(&sample);
+
+    for (int c = 0; have_latest && (size_t)len < size && c < CSI_DIAG_CAPS_MAX; c++) {
+        const csi_diag_heap_t *heap = &sample.heap[c];
+
+        len += snprintf(buf + len, size - len,
+                        "%s{\"caps\":\"%s\",\"free\":%lu,\"largest_free\":%lu,\"min_free\":%lu,"
+                        "\"fragmentation_permille\":%u,\"trend_per_hour\":%ld}",
+                        c ? "," : "", s_caps[c].name, (unsigned long)heap->free, (unsigned long)heap->largest_free,
+                        (unsigned long)heap->min_free, csi_diag_fragmentation_permille(heap),
+                        (long)csi_diag_heap_trend(c));
+    }
+
+    if ((size_t)len < size) {
+        len += snprintf(buf + len, size - len, history ? "],\"history\":[" : "]");
+    }
+
+    /* One array per sample, the ring is long and the keys would be most of it */
+    for (uint16_t i = 0; history && s_diag.history && (size_t)len < size && i < s_diag.config.history_len; i++) {
+        bool valid;
+
+        portENTER_CRITICAL(&s_diag_lock);
+        valid = i < s_diag.count;
+        if (valid) {
+            uint16_t first = (s_diag.head + s_diag.config.history_len - s_diag.count) % s_diag.config.history_len;
+            sample = s_diag.history[(first + i) % s_diag.config.history_len];
+        }
+        portEXIT_CRITICAL(&s_diag_lock);
+
+        if (!valid) {
+            break;
+        }
+
+        len += snprintf(buf + len, size - len, "%s[%lu,%u,%u", i ? "," : "", (unsigned long)sample.time_ms,
+                        sample.cpu_permille, sample.task_num);
+
+        for (int c = 0; (size_t)len < size && c < CSI_DIAG_CAPS_MAX; c++) {
+            len += snprintf(buf + len, size - len, ",%lu,%lu,%lu", (unsigned long)sample.heap[c].free,
+                            (unsigned long)sample.heap[c].largest_free, (unsigned long)sample.heap[c].min_free);
+        }
+
+        if ((size_t)len < size) {
+            len += snprintf(buf + len, size - len, "]");
+        }
+    }
+
+    if ((size_t)len < size) {
+        len += snprintf(buf + len, size - len, history ? "]}" : "}");
+    }
+
+    return MIN(len, (int)size - 1);
+}
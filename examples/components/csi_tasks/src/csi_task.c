@@ -0,0 +1,221 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_task.c
+ * @brief Priority and core of each stage of the CSI pipeline
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "csi_task.h"
+
+#define CSI_TASK_REGISTERED_MAX     16
+#define CSI_TASK_USAGE_MAX          40      /* Tasks whose previous run time is kept */
+
+#if CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1
+#define CSI_TASK_WIFI_CORE          1
+#else
+#define CSI_TASK_WIFI_CORE          0
+#endif
+
+#if CONFIG_CSI_TASK_PIN_TO_CORE
+#define CSI_TASK_CORE_CSI           (!CSI_TASK_WIFI_CORE)
+#define CSI_TASK_CORE_WIFI          CSI_TASK_WIFI_CORE
+#else
+#define CSI_TASK_CORE_CSI           tskNO_AFFINITY
+#define CSI_TASK_CORE_WIFI          tskNO_AFFINITY
+#endif
+
+static const char *TAG = "csi_task";
+
+typedef struct {
+    const char *name;
+    UBaseType_t priority;
+    BaseType_t core;
+} csi_task_stage_info_t;
+
+/* The radio path and what feeds it stay off the Wi-Fi core, what waits for people goes on it */
+static const csi_task_stage_info_t s_stages[CSI_TASK_STAGE_MAX] = {
+    [CSI_TASK_STAGE_DECODE]     = {"decode",     CONFIG_CSI_TASK_PRIORITY_DECODE,     CSI_TASK_CORE_CSI},
+    [CSI_TASK_STAGE_LINK]       = {"link",       CONFIG_CSI_TASK_PRIORITY_LINK,       CSI_TASK_CORE_CSI},
+    [CSI_TASK_STAGE_FUSION]     = {"fusion",     CONFIG_CSI_TASK_PRIORITY_FUSION,     CSI_TASK_CORE_CSI},
+    [CSI_TASK_STAGE_OUTPUT]     = {"output",     CONFIG_CSI_TASK_PRIORITY_OUTPUT,     CSI_TASK_CORE_WIFI},
+    [CSI_TASK_STAGE_UI]         = {"ui",         CONFIG_CSI_TASK_PRIORITY_UI,         CSI_TASK_CORE_WIFI},
+    [CSI_TASK_STAGE_BACKGROUND] = {"background", CONFIG_CSI_TASK_PRIORITY_BACKGROUND, tskNO_AFFINITY},
+};
+
+typedef struct {
+    TaskHandle_t handle;
+    uint8_t stage;
+    uint32_t stack_size;
+} csi_task_entry_t;
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t run_time;
+} csi_task_run_time_t;
+
+static csi_task_entry_t s_tasks[CSI_TASK_REGISTERED_MAX];
+static uint8_t s_task_num = 0;
+static portMUX_TYPE s_task_lock = portMUX_INITIALIZER_UNLOCKED;
+
+UBaseType_t csi_task_priority(csi_task_stage_t stage)
+{
+    return stage < CSI_TASK_STAGE_MAX ? s_stages[stage].priority : tskIDLE_PRIORITY + 1;
+}
+
+BaseType_t csi_task_core(csi_task_stage_t stage)
+{
+    return stage < CSI_TASK_STAGE_MAX ? s_stages[stage].core : tskNO_AFFINITY;
+}
+
+const char *csi_task_stage_name(csi_task_stage_t stage)
+{
+    return stage < CSI_TASK_STAGE_MAX ? s_stages[stage].name : "-";
+}
+
+static void csi_task_remember(TaskHandle_t handle, csi_task_stage_t stage, uint32_t stack_size)
+{
+    portENTER_CRITICAL(&s_task_lock);
+    if (s_task_num < CSI_TASK_REGISTERED_MAX) {
+        s_tasks[s_task_num++] = (csi_task_entry_t) {
+            .handle = handle, .stage = stage, .stack_size = stack_size
+        };
+    }
+    portEXIT_CRITICAL(&s_task_lock);
+}
+
+void csi_task_register(TaskHandle_t handle, csi_task_stage_t stage)
+{
+    if (!handle || stage >= CSI_TASK_STAGE_MAX) {
+        return;
+    }
+
+    csi_task_remember(handle, stage, 0);
+}
+
+bool csi_task_lookup(TaskHandle_t handle, csi_task_stage_t *stage, uint32_t *stack_size)
+{
+    bool found = false;
+
+    portENTER_CRITICAL(&s_task_lock);
+    for (int i = 0; i < s_task_num; i++) {
+        if (s_tasks[i].handle == handle) {
+            *stage = s_tasks[i].stage;
+            *stack_size = s_tasks[i].stack_size;
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_task_lock);
+
+    return found;
+}
+
+esp_err_t csi_task_create(TaskFunction_t task, const char *name, uint32_t stack_size, void *arg,
+                          csi_task_stage_t stage, TaskHandle_t *handle)
+{
+    TaskHandle_t created = NULL;
+
+    if (!task || stage >= CSI_TASK_STAGE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xTaskCreatePinnedToCore(task, name, stack_size, arg, s_stages[stage].priority,
+                                &created, s_stages[stage].core) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task %s", name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    csi_task_remember(created, stage, stack_size);
+
+    if (handle) {
+        *handle = created;
+    }
+
+    return ESP_OK;
+}
+
+void csi_task_log_topology(void)
+{
+    for (int i = 0; i < CSI_TASK_STAGE_MAX; i++) {
+        if (s_stages[i].core == tskNO_AFFINITY) {
+            ESP_LOGI(TAG, "%-10s priority %2u, any core", s_stages[i].name, (unsigned)s_stages[i].priority);
+        } else {
+            ESP_LOGI(TAG, "%-10s priority %2u, core %d", s_stages[i].name, (unsigned)s_stages[i].priority,
+                     (int)s_stages[i].core);
+        }
+    }
+}
+
+static const char *csi_task_lookup_stage(TaskHandle_t handle)
+{
+    for (int i = 0; i < s_task_num; i++) {
+        if (s_tasks[i].handle == handle) {
+            return s_stages[s_tasks[i].stage].name;
+        }
+    }
+
+    return "-";
+}
+
+esp_err_t csi_task_log_usage(void)
+{
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    static csi_task_run_time_t s_prev[CSI_TASK_USAGE_MAX];
+    static uint32_t s_prev_num = 0;
+    static uint32_t s_prev_total = 0;
+    /* A few spare slots for tasks created while the list is read */
+    UBaseType_t task_num = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = malloc(task_num * sizeof(TaskStatus_t));
+    uint32_t total = 0;
+
+    if (!status) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    task_num = uxTaskGetSystemState(status, task_num, &total);
+    uint32_t elapsed = total - s_prev_total;
+
+    ESP_LOGI(TAG, "%-16s %-10s %4s %4s %6s", "task", "stage", "core", "prio", "cpu%");
+
+    for (int i = 0; i < task_num && elapsed; i++) {
+        uint32_t run_time = status[i].ulRunTimeCounter;
+        uint32_t prev = 0;
+
+        for (int j = 0; j < s_prev_num; j++) {
+            if (s_prev[j].handle == status[i].xHandle) {
+                prev = s_prev[j].run_time;
+                break;
+            }
+        }
+
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+        int core = status[i].xCoreID == tskNO_AFFINITY ? -1 : (int)status[i].xCoreID;
+#else
+        int core = -1;
+#endif
+        ESP_LOGI(TAG, "%-16s %-10s %4d %4u %5.1f%%", status[i].pcTaskName, csi_task_lookup_stage(status[i].xHandle),
+                 core, (unsigned)status[i].uxCurrentPriority, 100.0f * (run_time - prev) / elapsed);
+    }
+
+    s_prev_num = MIN(task_num, CSI_TASK_USAGE_MAX);
+    for (int i = 0; i < s_prev_num; i++) {
+        s_prev[i].handle = status[i].xHandle;
+        s_prev[i].run_time = status[i].ulRunTimeCounter;
+    }
+    s_prev_total = total;
+
+    free(status);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
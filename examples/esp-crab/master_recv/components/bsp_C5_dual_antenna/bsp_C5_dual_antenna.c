@@ -52,6 +52,11 @@ static bool i2c_initialized = false;
 
 static button_handle_t g_btn_handle = NULL;
 
+static portMUX_TYPE s_display_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static bsp_display_stats_t s_display_stats;
+static int64_t s_flush_start_us;
+static void (*s_port_flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+
 esp_err_t bsp_i2c_init(void)
 {
     /* I2C was initialized before */
@@ -232,6 +237,87 @@ esp_err_t bsp_display_new(const bsp_display_config_t *config, esp_lcd_panel_hand
 
 }
 
+/* LVGL flushes one strip at a time, even with a double buffer, so a single start time is enough */
+static void bsp_display_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    s_flush_start_us = esp_timer_get_time();
+    s_port_flush_cb(drv, area, color_map);
+}
+
+static bool bsp_display_flush_done_cb(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    uint32_t flush_us = esp_timer_get_time() - s_flush_start_us;
+
+    portENTER_CRITICAL_ISR(&s_display_stats_lock);
+    s_display_stats.flushes++;
+    s_display_stats.flush_us_total += flush_us;
+    if (flush_us > s_display_stats.flush_us_max) {
+        s_display_stats.flush_us_max = flush_us;
+    }
+    portEXIT_CRITICAL_ISR(&s_display_stats_lock);
+
+    lv_disp_flush_ready((lv_disp_drv_t *)user_ctx);
+    return false;
+}
+
+static void bsp_display_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
+{
+    portENTER_CRITICAL(&s_display_stats_lock);
+    s_display_stats.frames++;
+    s_display_stats.frame_ms_total += time_ms;
+    if (time_ms > s_display_stats.frame_ms_max) {
+        s_display_stats.frame_ms_max = time_ms;
+    }
+    if (s_display_stats.frame_period_ms && time_ms > s_display_stats.frame_period_ms) {
+        s_display_stats.dropped_frames += time_ms / s_display_stats.frame_period_ms;
+    }
+    s_display_stats.dirty_pixels += px;
+    portEXIT_CRITICAL(&s_display_stats_lock);
+}
+
+/* Paces the refresh timer at the target rate and wraps the esp_lvgl_port flush to time it */
+static void bsp_display_pacing_init(lv_disp_t *display, esp_lcd_panel_io_handle_t io_handle, uint8_t target_fps)
+{
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = bsp_display_flush_done_cb,
+    };
+    lv_timer_t *refr_timer;
+
+    lvgl_port_lock(0);
+    refr_timer = _lv_disp_get_refr_timer(display);
+    if (target_fps) {
+        lv_timer_set_period(refr_timer, 1000 / target_fps);
+    }
+    s_display_stats.frame_period_ms = refr_timer->period;
+
+    s_port_flush_cb = display->driver->flush_cb;
+    display->driver->flush_cb = bsp_display_flush_cb;
+    display->driver->monitor_cb = bsp_display_monitor_cb;
+    /* Replaces the esp_lvgl_port callback, which only calls lv_disp_flush_ready() */
+    esp_lcd_panel_io_register_event_callbacks(io_handle, &cbs, display->driver);
+    lvgl_port_unlock();
+
+    ESP_LOGI(TAG, "Display refresh every %u ms, %s buffer", (unsigned)refr_timer->period,
+             display->driver->draw_buf->buf2 ? "double" : "single");
+}
+
+esp_err_t bsp_display_get_stats(bsp_display_stats_t *stats, bool reset)
+{
+    if (!disp) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_display_stats_lock);
+    *stats = s_display_stats;
+    if (reset) {
+        memset(&s_display_stats, 0, sizeof(bsp_display_stats_t));
+        s_display_stats.frame_period_ms = stats->frame_period_ms;
+    }
+    portEXIT_CRITICAL(&s_display_stats_lock);
+
+    return ESP_OK;
+}
+
 static lv_disp_t *bsp_display_lcd_init(const bsp_display_cfg_t *cfg)
 {
     assert(cfg != NULL);
@@ -250,6 +336,7 @@ static lv_disp_t *bsp_display_lcd_init(const bsp_display_cfg_t *cfg)
         .panel_handle = panel_handle,
         .buffer_size = cfg->buffer_size,
         .double_buffer = cfg->double_buffer,
+        .trans_size = cfg->trans_size,
         .hres = BSP_LCD_H_RES,
         .vres = BSP_LCD_V_RES,
         .monochrome = false,
@@ -265,7 +352,13 @@ static lv_disp_t *bsp_display_lcd_init(const bsp_display_cfg_t *cfg)
         }
     };
 
-    return lvgl_port_add_disp(&disp_cfg);
+    lv_disp_t *display = lvgl_port_add_disp(&disp_cfg);
+
+    if (display) {
+        bsp_display_pacing_init(display, io_handle, cfg->target_fps);
+    }
+
+    return display;
 }
 
 __attribute__((weak)) esp_err_t esp_lcd_touch_enter_sleep(esp_lcd_touch_handle_t tp)
@@ -353,10 +446,19 @@ lv_disp_t *bsp_display_start(void)
 #else
         .double_buffer = 0,
 #endif
+        .target_fps = CONFIG_BSP_DISPLAY_TARGET_FPS,
+#if CONFIG_BSP_LCD_DRAW_BUF_PSRAM
+        .trans_size = BSP_LCD_H_RES * BSP_LCD_TRANS_BUF_HEIGHT,
+        .flags = {
+            .buff_dma = false,
+            .buff_spiram = true,
+        }
+#else
         .flags = {
             .buff_dma = true,
             .buff_spiram = false,
         }
+#endif
     };
     return bsp_display_start_with_config(&cfg);
 }
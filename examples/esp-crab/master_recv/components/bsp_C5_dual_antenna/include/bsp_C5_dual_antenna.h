@@ -87,11 +87,16 @@ typedef struct {
     lvgl_port_cfg_t lvgl_port_cfg;  /*!< LVGL port configuration */
     uint32_t        buffer_size;    /*!< Size of the buffer for the screen in pixels */
     bool            double_buffer;  /*!< True, if should be allocated two buffers */
+    uint8_t         target_fps;     /*!< Frames per second LVGL refreshes at most, 0 keeps LV_DISP_DEF_REFR_PERIOD */
+    uint32_t        trans_size;     /*!< Pixels of the internal DMA buffer a PSRAM buffer is sent through, 0 for none */
     struct {
         unsigned int buff_dma: 1;    /*!< Allocated LVGL buffer will be DMA capable */
         unsigned int buff_spiram: 1; /*!< Allocated LVGL buffer will be in PSRAM */
     } flags;
 } bsp_display_cfg_t;
+
+/* Draw buffers in PSRAM are sent to the panel through an internal strip of this many lines */
+#define BSP_LCD_TRANS_BUF_HEIGHT    10
 typedef struct {
     uint32_t red;      // 红色值
     uint32_t green;    // 绿色值
@@ -260,6 +265,37 @@ esp_err_t bsp_display_enter_sleep(void);
  */
 esp_err_t bsp_display_exit_sleep(void);
 
+/**
+ * @brief Display refresh statistics
+ *
+ * A frame is one LVGL refresh that redrew something. With a double buffer,
+ * LVGL renders the next strip while the previous one is sent by DMA, so the
+ * frame time covers both and the flush time only the transfers.
+ */
+typedef struct {
+    uint32_t frames;            /*!< Refreshes that redrew something */
+    uint32_t dropped_frames;    /*!< Frame slots missed because a refresh outlasted the frame period */
+    uint32_t frame_ms_total;    /*!< Render and flush time of all frames */
+    uint32_t frame_ms_max;
+    uint32_t flushes;           /*!< Strips sent to the panel */
+    uint32_t flush_us_total;    /*!< Time from the start of a strip transfer to its completion */
+    uint32_t flush_us_max;
+    uint64_t dirty_pixels;      /*!< Pixels redrawn by all frames */
+    uint16_t frame_period_ms;   /*!< Refresh period from target_fps */
+} bsp_display_stats_t;
+
+/**
+ * @brief Copy the display refresh statistics
+ *
+ * @param[out] stats Statistics since the start or the previous reset
+ * @param[in]  reset Clear the counters after copying them
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the display is not started
+ */
+esp_err_t bsp_display_get_stats(bsp_display_stats_t *stats, bool reset);
+
 /**
  * @brief Rotate screen
  *
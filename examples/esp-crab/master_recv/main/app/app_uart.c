@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <inttypes.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/uart.h"
@@ -6,36 +8,78 @@
 #include "sdkconfig.h"
 #include "esp_log.h"
 #include "app_uart.h"
+#include "uart_link.h"
+#include "csi_queue.h"
+#include "csi_task.h"
 #include "bsp_C5_dual_antenna.h"
 #define UART_PORT_NUM      UART_NUM_1
 #define UART_BAUD_RATE     2000000
 #define TXD_PIN            (BSP_CNT_4)
 #define RXD_PIN            (BSP_CNT_3)
 #define BUF_SIZE           4096
+#define LINK_STATS_LOG_INTERVAL_MS  10000
+#define UART_RECV_QUEUE_LEN         20
 static const char *TAG = "UART";
-QueueHandle_t uart_recv_queue;
+csi_queue_t uart_recv_queue;
 static QueueHandle_t uart0_queue;
+static uart_link_parser_t s_link_parser;
+
+static void uart_link_record_cb(const csi_data_t *record, void *ctx)
+{
+    csi_queue_send(&uart_recv_queue, record);
+    ESP_LOGD(TAG, "%" PRIu32 ",%lld,%.2f", record->id, record->time_delta, record->cir[0]);
+}
+
+/* Drain the driver ring buffer straight into the parser buffer, no intermediate copy */
+static void uart_link_read(void)
+{
+    size_t buffered = 0;
+    uart_get_buffered_data_len(UART_PORT_NUM, &buffered);
+
+    while (buffered > 0) {
+        size_t space = 0;
+        uint8_t *buf = uart_link_parser_get_buffer(&s_link_parser, &space);
+        int len = uart_read_bytes(UART_PORT_NUM, buf, MIN(space, buffered), 0);
+        if (len <= 0) {
+            break;
+        }
+        uart_link_parser_commit(&s_link_parser, len);
+        buffered -= len;
+    }
+}
+
+static void uart_link_log_stats(void)
+{
+    static uint32_t s_last_log_time = 0;
+    static uint32_t s_last_errors = 0;
+    const uart_link_stats_t *stats = &s_link_parser.stats;
+    csi_queue_stats_t queue_stats;
+    csi_queue_get_stats(&uart_recv_queue, &queue_stats);
+    uint32_t queue_drops = csi_queue_drops(&queue_stats);
+    uint32_t errors = stats->crc_errors + stats->length_errors + stats->lost_frames + queue_drops;
+
+    if (esp_log_timestamp() - s_last_log_time < LINK_STATS_LOG_INTERVAL_MS || errors == s_last_errors) {
+        return;
+    }
+
+    s_last_log_time = esp_log_timestamp();
+    s_last_errors = errors;
+    ESP_LOGW(TAG, "link frames: %" PRIu32 ", records: %" PRIu32 ", crc_err: %" PRIu32 ", len_err: %" PRIu32
+             ", lost: %" PRIu32 ", resync: %" PRIu32 ", queue_drop: %" PRIu32 ", queue_high: %" PRIu32,
+             stats->frames, stats->records, stats->crc_errors, stats->length_errors,
+             stats->lost_frames, stats->resync_bytes, queue_drops, queue_stats.high_water);
+}
+
 static void uart_event_task(void *pvParameters)
 {
     uart_event_t event;
-    uint8_t* dtmp = (uint8_t*) malloc(2 * BUF_SIZE);
-    csi_data_t* csi_data;
-    uint16_t table_row_last=0;
+    uart_link_parser_init(&s_link_parser, uart_link_record_cb, NULL);
     for (;;) {
         if (xQueueReceive(uart0_queue, (void *)&event, (TickType_t)portMAX_DELAY)) {
             switch (event.type) {
             case UART_DATA:
-                UBaseType_t queue_size = uxQueueMessagesWaiting(uart0_queue);
-                uart_read_bytes(UART_PORT_NUM, dtmp, event.size, portMAX_DELAY);
-                // ESP_LOGI(TAG, "[UART DATA]: %d %u", event.size,queue_size);
-                    for (int i = 0; i <= (int)event.size - 32; i++) {
-                        if (dtmp[i] == 0xAA && dtmp[i + 1] == 0x55 && dtmp[i + 30] == 0x55 && dtmp[i + 31] == 0xAA) {
-                            xQueueSend(uart_recv_queue,(csi_data_t*)&dtmp[i], 0);
-                            csi_data = (csi_data_t *)&dtmp[i];
-                            ESP_LOGD(TAG,"%d,%lld,%.2f",csi_data->start[0],csi_data->time_delta,csi_data->cir[0]);
-                            i = i + 24-1;
-                        }
-                    }         
+                uart_link_read();
+                uart_link_log_stats();
                 break;
             case UART_FIFO_OVF:
                 ESP_LOGW(TAG, "hw fifo overflow");
@@ -62,8 +106,6 @@ static void uart_event_task(void *pvParameters)
             }
         }
     }
-    free(dtmp);
-    dtmp = NULL;
     vTaskDelete(NULL);
 }
 
@@ -85,8 +127,11 @@ void init_uart() {
     ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
     ESP_ERROR_CHECK(uart_set_pin(UART_PORT_NUM, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
         ESP_LOGI("UART", "UART initialized");
-    uart_recv_queue = xQueueCreate(20, sizeof(csi_data_t));
-    xTaskCreate(uart_event_task, "uart_event_task", 4096, NULL, 9, NULL); // 核心 1
+    /* The join wants the latest slave records, an old one has likely missed its partner already */
+    csi_queue_config_t queue_config = CSI_QUEUE_CONFIG_DEFAULT("uart_recv", UART_RECV_QUEUE_LEN, sizeof(csi_data_t));
+    queue_config.policy = CSI_QUEUE_DROP_OLDEST;
+    ESP_ERROR_CHECK(csi_queue_init(&uart_recv_queue, &queue_config));
+    ESP_ERROR_CHECK(csi_task_create(uart_event_task, "uart_event_task", 4096, NULL, CSI_TASK_STAGE_LINK, NULL));
 
 }
 
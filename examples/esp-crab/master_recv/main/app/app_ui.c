@@ -7,21 +7,50 @@
 #include "freertos/task.h"
 #include "bsp_C5_dual_antenna.h"
 #include "app_uart.h"
+#include "csi_join.h"
+#include "csi_queue.h"
+#include "time_sync.h"
+#include "csi_phase.h"
+#include "minmax_window.h"
+#include "csi_seqlock.h"
 #include <math.h>
+#include <stdlib.h>
+#include <sys/param.h>
 
-#define DISPLAY_SAMPLE_STEP 3 
+#define DISPLAY_SAMPLE_STEP         3   // CSI samples averaged into one chart point
+#define DISPLAY_FRAME_INTERVAL_MS   (1000 / CONFIG_BSP_DISPLAY_TARGET_FPS)  // One chart update per display frame
+#define DISPLAY_PHASE_MEAN_LEN      20  // Samples in the phase mean
+#define DISPLAY_AMP_MIN_SPAN        100 // Smallest amplitude range, keeps noise from filling the chart
 #define LVGL_CHART_POINTS   (100 / DISPLAY_SAMPLE_STEP)
 #define PI 3.14159265
 #define SAMPLE_RATE LVGL_CHART_POINTS
+#define JOIN_POLL_INTERVAL_MS       20
+#define JOIN_STATS_LOG_INTERVAL_MS  10000
+#define JOIN_MAX_SKEW_US            1000    // Once synced, pairs further apart on the common timebase are different packets
 
-extern QueueHandle_t uart_recv_queue;
-extern  QueueHandle_t csi_display_queue;
-extern csi_data_t master_data[DATA_TABLE_SIZE];
-lv_chart_series_t * ser[6];
-int16_t sine_wave[LVGL_CHART_POINTS*3];
-float angle = 0;
+extern csi_queue_t uart_recv_queue;
+extern csi_queue_t csi_display_queue;
+extern csi_join_t csi_join;
+static lv_chart_series_t * ser[6];
+static int16_t sine_wave[LVGL_CHART_POINTS*3];
 static const char *TAG = "app_ui";
 
+/* Published by the display task once per frame, read by the screen events */
+typedef struct {
+    float phase;                    /* Mean phase, before the calibration offset */
+    uint32_t frames;                /* Frames drawn, 0 until the first one */
+} app_ui_view_t;
+
+/* Published by the screen events in the LVGL task, read by the display task every frame */
+typedef struct {
+    float phase_offset;             /* Mean phase at the last calibration, shown as zero */
+} app_ui_control_t;
+
+static csi_seqlock_t s_view_lock = CSI_SEQLOCK_INIT();
+static app_ui_view_t s_view;
+static csi_seqlock_t s_control_lock = CSI_SEQLOCK_INIT();
+static app_ui_control_t s_control;
+
 void generate_sine_wave(int16_t *data) 
 {
     int16_t num_samples = SAMPLE_RATE*3;
@@ -50,8 +79,18 @@ void ScreenSSliderLight_function(lv_event_t * e)
 
 void PhaseCalibration_button(lv_event_t * e)
 {
-    angle =0;
-    ESP_LOGI(TAG, "PhaseCalibration_button");
+    app_ui_view_t view;
+
+    if (!csi_seqlock_read(&s_view_lock, &view, &s_view, sizeof(view), NULL) || !view.frames) {
+        ESP_LOGW(TAG, "No phase to calibrate yet");
+        return;
+    }
+
+    app_ui_control_t control = {
+        .phase_offset = view.phase,
+    };
+    csi_seqlock_write(&s_control_lock, &s_control, &control, sizeof(control));
+    ESP_LOGI(TAG, "PhaseCalibration_button, offset %.2f rad", control.phase_offset);
 }
 
 
@@ -73,152 +112,237 @@ void app_ui_init(void)
     generate_sine_wave(sine_wave);
 }
 
-float circular_difference(float angle1, float angle2) 
+/* Chart points are aggregated between frames, the charts are redrawn in one locked batch per frame */
+typedef struct {
+    float amp_sum[2];               /* Point being aggregated */
+    float amp_low;
+    float amp_high;
+    uint8_t samples;
+    lv_coord_t pending[LVGL_CHART_POINTS][2];   /* Points not drawn yet */
+    uint8_t pending_num;
+    circular_mean_t phase;          /* Mean of the newest phases */
+    float phase_storage[CIRCULAR_MEAN_STORAGE_LEN(DISPLAY_PHASE_MEAN_LEN)];
+    minmax_window_t range;          /* Envelope of the points on the chart */
+    minmax_window_entry_t range_storage[MINMAX_WINDOW_STORAGE_LEN(LVGL_CHART_POINTS)];
+    uint32_t frame_time;
+    app_ui_view_t view;
+    app_ui_control_t control;       /* Last consistent copy, kept while a read meets the writer */
+} csi_display_state_t;
+
+static void csi_display_init(csi_display_state_t *state)
+{
+    memset(state, 0, sizeof(csi_display_state_t));
+    minmax_window_init(&state->range, state->range_storage, LVGL_CHART_POINTS);
+    circular_mean_init(&state->phase, state->phase_storage, DISPLAY_PHASE_MEAN_LEN);
+    state->frame_time = esp_log_timestamp();
+}
+
+static void csi_display_put(csi_display_state_t *state, float amp0, float amp1, float phase)
+{
+    circular_mean_push(&state->phase, phase);
+
+    if (!state->samples) {
+        state->amp_low = MIN(amp0, amp1);
+        state->amp_high = MAX(amp0, amp1);
+    } else {
+        state->amp_low = MIN(state->amp_low, MIN(amp0, amp1));
+        state->amp_high = MAX(state->amp_high, MAX(amp0, amp1));
+    }
+    state->amp_sum[0] += amp0;
+    state->amp_sum[1] += amp1;
+
+    if (++state->samples < DISPLAY_SAMPLE_STEP) {
+        return;
+    }
+
+    /* More points than the chart holds only when the UI stalled for a whole window, keep the newest */
+    if (state->pending_num == LVGL_CHART_POINTS) {
+        memmove(state->pending[0], state->pending[1], (LVGL_CHART_POINTS - 1) * sizeof(state->pending[0]));
+        state->pending_num--;
+    }
+
+    state->pending[state->pending_num][0] = (lv_coord_t)(state->amp_sum[0] / DISPLAY_SAMPLE_STEP);
+    state->pending[state->pending_num][1] = (lv_coord_t)(state->amp_sum[1] / DISPLAY_SAMPLE_STEP);
+    state->pending_num++;
+    minmax_window_push_range(&state->range, state->amp_low, state->amp_high);
+
+    state->amp_sum[0] = 0;
+    state->amp_sum[1] = 0;
+    state->samples = 0;
+}
+
+/* Ticks until the next frame is due, forever while nothing is pending */
+static TickType_t csi_display_wait(const csi_display_state_t *state)
 {
-    float diff = fmod(angle2 - angle1 + PI, 2 * PI);
-    if (diff < 0) {
-        diff += 2 * PI;
+    uint32_t elapsed = esp_log_timestamp() - state->frame_time;
+
+    if (!state->pending_num) {
+        return portMAX_DELAY;
+    }
+
+    return elapsed < DISPLAY_FRAME_INTERVAL_MS ? pdMS_TO_TICKS(DISPLAY_FRAME_INTERVAL_MS - elapsed) : 0;
+}
+
+/* Draw the pending points once DISPLAY_FRAME_INTERVAL_MS passed since the last frame */
+static void csi_display_flush(csi_display_state_t *state)
+{
+    if (!state->pending_num || esp_log_timestamp() - state->frame_time < DISPLAY_FRAME_INTERVAL_MS) {
+        return;
+    }
+
+    state->frame_time = esp_log_timestamp();
+
+    lv_coord_t y_min = (lv_coord_t)floorf(minmax_window_min(&state->range));
+    lv_coord_t y_max = (lv_coord_t)ceilf(minmax_window_max(&state->range));
+    if (y_max - y_min < DISPLAY_AMP_MIN_SPAN) {
+        y_min -= (DISPLAY_AMP_MIN_SPAN - (y_max - y_min)) / 2;
+        y_max = y_min + DISPLAY_AMP_MIN_SPAN;
+    }
+    state->view = (app_ui_view_t) {
+        .phase = circular_mean_get(&state->phase),
+        .frames = state->view.frames + 1,
+    };
+    csi_seqlock_write(&s_view_lock, &s_view, &state->view, sizeof(app_ui_view_t));
+
+    app_ui_control_t control;
+    if (csi_seqlock_read(&s_control_lock, &control, &s_control, sizeof(control), NULL)) {
+        state->control = control;
     }
-    return diff - PI;
+
+    /* The sine is drawn half a turn from the calibrated phase, as it always was */
+    float phase = state->view.phase - state->control.phase_offset;
+    uint8_t sine_offset = get_sine_wave_index(fmodf(phase + 4 * PI, 2 * PI) - PI);
+
+    lvgl_port_lock(0);
+    for (int i = 0; i < state->pending_num; i++) {
+        lv_chart_set_next_value(ui_ScreenW_Chart, ser[0], state->pending[i][0]);
+        lv_chart_set_next_value(ui_ScreenW_Chart, ser[1], state->pending[i][1]);
+    }
+    lv_chart_set_ext_y_array(ui_ScreenWP_Chart, ser[2], sine_wave + sine_offset);
+    lv_chart_set_range(ui_ScreenW_Chart, LV_CHART_AXIS_PRIMARY_Y, y_min, y_max);
+    lvgl_port_unlock();
+
+    state->pending_num = 0;
+}
+
+/* Slave clock on the local timebase, learned from the pairs themselves: both records of an id are the same packet */
+static time_sync_t s_slave_clock;
+static int64_t s_master_time_us;
+static uint32_t s_skew_drops;
+
+static bool csi_pair_in_sync(const csi_data_t *master, const csi_data_t *slave)
+{
+    /* time_delta only holds the 32-bit rx_ctrl timestamp, extend both sides */
+    int64_t local_us = s_master_time_us + (int32_t)((uint32_t)master->time_delta - (uint32_t)s_master_time_us);
+    int64_t remote_us = s_slave_clock.pairs ? time_sync_extend32(&s_slave_clock, (uint32_t)slave->time_delta)
+                                            : (uint32_t)slave->time_delta;
+    bool in_sync = true;
+
+    s_master_time_us = local_us;
+
+    if (time_sync_locked(&s_slave_clock)
+            && llabs(time_sync_to_local(&s_slave_clock, remote_us) - local_us) > JOIN_MAX_SKEW_US) {
+        s_skew_drops++;
+        in_sync = false;
+    }
+
+    /* Also fed when rejected, a run of outliers restarts the estimate after a reboot */
+    time_sync_update(&s_slave_clock, remote_us, local_us);
+    return in_sync;
+}
+
+static void csi_display_pair(const csi_data_t *master, const csi_data_t *slave, void *ctx)
+{
+    if (!csi_pair_in_sync(master, slave)) {
+        return;
+    }
+
+    csi_display_put((csi_display_state_t *)ctx, slave->cir[0]*5, master->cir[1]*5,
+                    master->cir[2] - slave->cir[2]);
+}
+
+static void csi_join_log_stats(void)
+{
+    static uint32_t s_last_log_time = 0;
+    csi_join_stats_t stats;
+
+    if (esp_log_timestamp() - s_last_log_time < JOIN_STATS_LOG_INTERVAL_MS) {
+        return;
+    }
+
+    s_last_log_time = esp_log_timestamp();
+    csi_join_get_stats(&csi_join, &stats);
+
+    if (!stats.slave) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "join hit %.1f%% (%u/%u, late %u), late drop %.1f%% (%u), torn reads %u",
+             100.0f * stats.hits / stats.slave, (unsigned)stats.hits, (unsigned)stats.slave, (unsigned)stats.late_hits,
+             100.0f * stats.late_drops / stats.slave, (unsigned)stats.late_drops, (unsigned)stats.torn_reads);
+    ESP_LOGI(TAG, "slave clock %s, drift %.2f ppm, error %.0f us, skew drops %u, outliers %u",
+             time_sync_locked(&s_slave_clock) ? "synced" : "syncing", time_sync_drift_ppm(&s_slave_clock),
+             s_slave_clock.residual_us, (unsigned)s_skew_drops, (unsigned)s_slave_clock.outliers);
+}
+
+/* Logged only when the display fell behind since the last report */
+static void csi_display_log_stats(void)
+{
+    static uint32_t s_last_log_time = 0;
+    static uint32_t s_last_drops = 0;
+    csi_queue_stats_t stats;
+
+    if (esp_log_timestamp() - s_last_log_time < JOIN_STATS_LOG_INTERVAL_MS) {
+        return;
+    }
+
+    s_last_log_time = esp_log_timestamp();
+    csi_queue_get_stats(&csi_display_queue, &stats);
+
+    if (csi_queue_drops(&stats) == s_last_drops) {
+        return;
+    }
+
+    s_last_drops = csi_queue_drops(&stats);
+    ESP_LOGW(TAG, "display queue sent %u, decimated %u, dropped %u, high water %u/%u",
+             (unsigned)stats.sent, (unsigned)stats.decimated, (unsigned)stats.dropped_newest,
+             (unsigned)stats.high_water, (unsigned)csi_display_queue.config.length);
 }
 
 void csi_data_display_task(void *arg)         
 {
     app_ui_init();
-    static uint16_t y_range[2] ={0};
-    uint8_t count=0;
     csi_data_t csi_display_data;
+    static csi_display_state_t state;
 
-    uint8_t sine_offest[2];
-    uint8_t cnt=0;
-    float range[4][LVGL_CHART_POINTS] = {};
     uint8_t csi_mode = *((bool *)arg);
     if (csi_mode){
         ESP_LOGI(TAG,"Self_Transmit_and_Receive_Mode");
     } else {
         ESP_LOGI(TAG,"Single_Transmit_and_Dual_Receive_Mode");
     }
+    csi_display_init(&state);
     if (csi_mode){
-        while (xQueueReceive(csi_display_queue, &csi_display_data, portMAX_DELAY) == pdTRUE) {
-            cnt++;
-            UBaseType_t queueLength = uxQueueMessagesWaiting(csi_display_queue);
-            if (queueLength>10){
-                ESP_LOGI(TAG, "ui queueLength:%d", queueLength);
-            }           
-            range[0][count] = csi_display_data.cir[0]*5;
-            range[1][count] = csi_display_data.cir[1]*5;
-            range[2][count] = csi_display_data.cir[2];
-            range[3][count] = csi_display_data.cir[3];
-
-            y_range[0] = 500;
-            y_range[1] = 0;
-            for (int i=0;i<LVGL_CHART_POINTS;i++){
-                if (y_range[0]>range[0][i]){
-                    y_range[0] = range[0][i];
-                }
-                if (y_range[0]>range[1][i]){
-                    y_range[0] = range[1][i];
-                }
-                if (y_range[1]<range[0][i]){
-                    y_range[1] = range[0][i];
-                }
-                if (y_range[1]<range[1][i]){
-                    y_range[1] = range[1][i];
-                }
-            }
-            if  ( (y_range[1]-y_range[0])<100){
-                y_range[1] += (100-y_range[1]+y_range[0])/2;
-                y_range[0] -= (100-y_range[1]+y_range[0])/2;
-            }
-            lvgl_port_lock(0);
-            lv_chart_set_next_value(ui_ScreenW_Chart, ser[0], (uint16_t)(range[0][count]));
-            lv_chart_set_next_value(ui_ScreenW_Chart, ser[1], (uint16_t)(range[1][count]));
-
-            float sum[2]={0};
-            for (int i=count;i>count-20;i--){
-                uint8_t index = (i+LVGL_CHART_POINTS)%LVGL_CHART_POINTS;
-                sum[0] += circular_difference(range[2][count], range[2][index]);
-                sum[1] += circular_difference(range[3][count], range[3][index]);
-            }
-            sum[0] = fmod(sum[0]/20 + range[2][count] + 2 * PI, 2 * PI) - PI;
-            sum[1] = fmod(sum[1]/20 + range[3][count] + 2 * PI, 2 * PI) - PI;
-
-            sine_offest[0] = get_sine_wave_index(sum[0]);
-            sine_offest[1] = get_sine_wave_index(sum[1]);
-            lv_chart_set_ext_y_array(ui_ScreenWP_Chart, ser[2], sine_wave+sine_offest[0]);
-            lv_chart_set_range(ui_ScreenW_Chart, LV_CHART_AXIS_PRIMARY_Y, y_range[0], y_range[1]);
-
-            lvgl_port_unlock();
-
-            count++;
-            if (count == LVGL_CHART_POINTS) {
-                count = 0;
+        while (1) {
+            if (csi_queue_receive(&csi_display_queue, &csi_display_data, csi_display_wait(&state))) {
+                csi_display_put(&state, csi_display_data.cir[0]*5, csi_display_data.cir[1]*5,
+                                csi_display_data.cir[2]);
             }
+            csi_display_flush(&state);
+            csi_display_log_stats();
         }
     }else {
-        static csi_data_t csi_display_data_new = {0};
-        while (xQueueReceive(uart_recv_queue, &csi_display_data_new, portMAX_DELAY) == pdTRUE) {
-            cnt++;
-            if (csi_display_data.start[0] == 0){
-                goto NEXT;
-            }
-            
-            csi_data_t csi_master_data  = master_data[csi_display_data.id % DATA_TABLE_SIZE];
-            if (csi_master_data.id != csi_display_data.id){
-                ESP_LOGE(TAG, "%ld id_master  %ld csi_display_data.id %ld",csi_display_data.id % DATA_TABLE_SIZE,csi_master_data.id,csi_display_data.id);
-                goto NEXT;
-            }
-            range[0][count] = csi_display_data.cir[0]*5;
-            range[1][count] = csi_master_data.cir[1]*5;
-            range[2][count] = csi_master_data.cir[2] - csi_display_data.cir[2];
-            range[3][count] = csi_display_data.cir[3];
-
-            y_range[0] = 500;
-            y_range[1] = 0;
-            for (int i=0;i<LVGL_CHART_POINTS;i++){
-                if (y_range[0]>range[0][i]){
-                    y_range[0] = range[0][i];
-                }
-                if (y_range[0]>range[1][i]){
-                    y_range[0] = range[1][i];
-                }
-                if (y_range[1]<range[0][i]){
-                    y_range[1] = range[0][i];
+        /* Slave records may arrive before or after the local record with the same id */
+        while (1) {
+            if (csi_queue_receive(&uart_recv_queue, &csi_display_data, pdMS_TO_TICKS(JOIN_POLL_INTERVAL_MS))) {
+                if (csi_display_data.start[0] != 0){
+                    csi_join_put_slave(&csi_join, &csi_display_data, csi_display_pair, &state);
                 }
-                if (y_range[1]<range[1][i]){
-                    y_range[1] = range[1][i];
-                }
-            }
-            if  ( (y_range[1]-y_range[0])<100){
-                y_range[1] += (100-y_range[1]+y_range[0])/2;
-                y_range[0] -= (100-y_range[1]+y_range[0])/2;
-            }
-            lvgl_port_lock(0);
-            lv_chart_set_next_value(ui_ScreenW_Chart, ser[0], (uint16_t)(range[0][count]));
-            lv_chart_set_next_value(ui_ScreenW_Chart, ser[1], (uint16_t)(range[1][count]));
-
-            float sum[2]={0};
-            for (int i=count;i>count-20;i--){
-                uint8_t index = (i+LVGL_CHART_POINTS)%LVGL_CHART_POINTS;
-                sum[0] += circular_difference(range[2][count], range[2][index]);
-                sum[1] += circular_difference(range[3][count], range[3][index]);
+            } else {
+                csi_join_poll(&csi_join, csi_display_pair, &state);
             }
-            sum[0] = fmod(sum[0]/20 + range[2][count] + 2 * PI, 2 * PI) - PI;
-            sum[1] = fmod(sum[1]/20 + range[3][count] + 2 * PI, 2 * PI) - PI;
-            
-            sine_offest[0] = get_sine_wave_index(sum[0]);
-            sine_offest[1] = get_sine_wave_index(sum[1]);
-            lv_chart_set_ext_y_array(ui_ScreenWP_Chart, ser[2], sine_wave+sine_offest[0]);
-            lv_chart_set_range(ui_ScreenW_Chart, LV_CHART_AXIS_PRIMARY_Y, y_range[0], y_range[1]);
-
-            lvgl_port_unlock();
-
-            count++;
-            if (count == LVGL_CHART_POINTS) {
-                count = 0;
-            }
-NEXT:
-            csi_display_data = csi_display_data_new;
+            csi_display_flush(&state);
+            csi_join_log_stats();
         }
     }
-}
\ No newline at end of file
+}
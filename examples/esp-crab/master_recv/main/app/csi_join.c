@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_join.c
+ * @brief Pairs master and slave csi_data_t records that belong to the same packet id
+ */
+
+#include <string.h>
+#include "csi_join.h"
+
+typedef enum {
+    JOIN_MATCHED,
+    JOIN_WAIT,
+    JOIN_EXPIRED,
+} join_result_t;
+
+esp_err_t csi_join_init(csi_join_t *join, uint32_t window)
+{
+    if (!join || !window || window > CSI_JOIN_TABLE_SIZE / 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(join, 0, sizeof(csi_join_t));
+    join->window = window;
+
+    return csi_seqlock_table_init(&join->master_table, join->master_storage, sizeof(csi_data_t), CSI_JOIN_TABLE_SIZE);
+}
+
+void csi_join_put_master(csi_join_t *join, const csi_data_t *master)
+{
+    csi_seqlock_table_publish(&join->master_table, master->id, master);
+
+    join->stats.master++;
+    __atomic_store_n(&join->master_latest, master->id, __ATOMIC_RELEASE);
+    __atomic_store_n(&join->master_valid, 1, __ATOMIC_RELEASE);
+}
+
+static join_result_t join_try(csi_join_t *join, const csi_data_t *slave, csi_join_pair_cb_t cb, void *ctx)
+{
+    csi_data_t master;
+
+    if (csi_seqlock_table_read(&join->master_table, slave->id, &master) && master.id == slave->id && master.start[0]) {
+        cb(&master, slave, ctx);
+        return JOIN_MATCHED;
+    }
+
+    if (!__atomic_load_n(&join->master_valid, __ATOMIC_ACQUIRE)) {
+        return JOIN_WAIT;
+    }
+
+    /* Signed distance, the master side may be ahead of or behind the slave */
+    int32_t lag = (int32_t)(__atomic_load_n(&join->master_latest, __ATOMIC_ACQUIRE) - slave->id);
+
+    return lag >= (int32_t)join->window ? JOIN_EXPIRED : JOIN_WAIT;
+}
+
+/* Retry the parked records in arrival order, keep the ones still waiting */
+static void join_retry_pending(csi_join_t *join, csi_join_pair_cb_t cb, void *ctx)
+{
+    uint8_t kept = 0;
+
+    for (uint8_t i = 0; i < join->pending_count; i++) {
+        switch (join_try(join, &join->pending[i], cb, ctx)) {
+        case JOIN_MATCHED:
+            join->stats.hits++;
+            join->stats.late_hits++;
+            break;
+
+        case JOIN_EXPIRED:
+            join->stats.late_drops++;
+            break;
+
+        case JOIN_WAIT:
+            if (kept != i) {
+                join->pending[kept] = join->pending[i];
+            }
+            kept++;
+            break;
+        }
+    }
+
+    join->pending_count = kept;
+}
+
+void csi_join_put_slave(csi_join_t *join, const csi_data_t *slave, csi_join_pair_cb_t cb, void *ctx)
+{
+    join->stats.slave++;
+    join_retry_pending(join, cb, ctx);
+
+    switch (join_try(join, slave, cb, ctx)) {
+    case JOIN_MATCHED:
+        join->stats.hits++;
+        return;
+
+    case JOIN_EXPIRED:
+        join->stats.late_drops++;
+        return;
+
+    case JOIN_WAIT:
+        break;
+    }
+
+    if (join->pending_count == CSI_JOIN_PENDING_MAX) {
+        /* The oldest record is the least likely to still find its master */
+        join->stats.late_drops++;
+        memmove(join->pending, join->pending + 1, (CSI_JOIN_PENDING_MAX - 1) * sizeof(csi_data_t));
+        join->pending_count--;
+    }
+
+    join->pending[join->pending_count++] = *slave;
+}
+
+void csi_join_poll(csi_join_t *join, csi_join_pair_cb_t cb, void *ctx)
+{
+    join_retry_pending(join, cb, ctx);
+}
+
+void csi_join_get_stats(const csi_join_t *join, csi_join_stats_t *stats)
+{
+    *stats = join->stats;
+    stats->torn_reads = __atomic_load_n(&join->master_table.torn_reads, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_join.h
+ * @brief Pairs master and slave csi_data_t records that belong to the same packet id
+ *
+ * The master records are published by process_csi_data_task through a
+ * csi_seqlock_table_t indexed by id, so the display task never reads a
+ * half-written record and the decoding path never waits for it. Slave
+ * records that arrive before their master record are parked and retried,
+ * and are only dropped once the master id has moved more than `window`
+ * packets past them. Each match is handed to the caller's pair callback.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "app_uart.h"
+#include "csi_seqlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_JOIN_TABLE_SIZE         64  /**< Master slots, power of two */
+#define CSI_JOIN_PENDING_MAX        16  /**< Slave records waiting for their master */
+
+typedef struct {
+    uint32_t master;        /**< Master records published */
+    uint32_t slave;         /**< Slave records offered */
+    uint32_t hits;          /**< Pairs delivered */
+    uint32_t late_hits;     /**< Pairs delivered after the slave record had to wait */
+    uint32_t late_drops;    /**< Slave records whose master never came or was overwritten */
+    uint32_t torn_reads;    /**< Seqlock reads retried because the writer was active */
+} csi_join_stats_t;
+
+/**
+ * @brief Called with every matched pair, both records are only valid during the call
+ */
+typedef void (*csi_join_pair_cb_t)(const csi_data_t *master, const csi_data_t *slave, void *ctx);
+
+typedef struct {
+    csi_seqlock_table_t master_table;
+    uint32_t master_storage[CSI_SEQLOCK_TABLE_STORAGE_LEN(sizeof(csi_data_t), CSI_JOIN_TABLE_SIZE)];
+    uint32_t master_latest;             /**< Newest master id, valid once master_valid is set */
+    uint32_t master_valid;
+    uint32_t window;
+    csi_data_t pending[CSI_JOIN_PENDING_MAX];
+    uint8_t pending_count;
+    csi_join_stats_t stats;
+} csi_join_t;
+
+/**
+ * @brief Initialize the join stage
+ *
+ * @param join   Join stage to initialize
+ * @param window Number of packet ids a slave record may wait for its master record,
+ *               at most CSI_JOIN_TABLE_SIZE / 2
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the window is 0 or too large
+ */
+esp_err_t csi_join_init(csi_join_t *join, uint32_t window);
+
+/**
+ * @brief Writer: publish a master record, only one task may call it
+ */
+void csi_join_put_master(csi_join_t *join, const csi_data_t *master);
+
+/**
+ * @brief Reader: offer a slave record and deliver every pair that is now complete
+ *
+ * @param cb  Called in the caller's context for each pair
+ * @param ctx Passed to cb
+ */
+void csi_join_put_slave(csi_join_t *join, const csi_data_t *slave, csi_join_pair_cb_t cb, void *ctx);
+
+/**
+ * @brief Reader: retry the parked slave records, call it when no slave record arrived for a while
+ */
+void csi_join_poll(csi_join_t *join, csi_join_pair_cb_t cb, void *ctx);
+
+/**
+ * @brief Copy the join counters
+ */
+void csi_join_get_stats(const csi_join_t *join, csi_join_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <sys/param.h>
 #include "nvs_flash.h"
 #include "esp_mac.h"
 #include "rom/ets_sys.h"
@@ -22,93 +23,72 @@
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_now.h"
-#include "app_ifft.h"
-#include "app_gpio.h"
+#include "csi_attr.h"
+#include "csi_fft.h"
+#include "csi_mem.h"
+#include "csi_sync_gpio.h"
+#include "csi_wifi.h"
 #include "esp_timer.h"
 #include "app_uart.h"
+#include "csi_frame_ring.h"
+#include "csi_join.h"
+#include "csi_queue.h"
+#include "csi_task.h"
+#include "csi_boot.h"
 #include "IQmathLib.h"
 #include "bsp_C5_dual_antenna.h"
 #include "ui.h"
 #include "app_ui.h"
 #include "esp_csi_gain_ctrl.h"
+#include "csi_gain_lut.h"
+#include "csi_gain_track.h"
+#include "csi_gain_baseline.h"
 
 #define CONFIG_LESS_INTERFERENCE_CHANNEL    40
-#define CONFIG_WIFI_BAND_MODE               WIFI_BAND_MODE_5G_ONLY
-#define CONFIG_WIFI_2G_BANDWIDTHS           WIFI_BW_HT40
-#define CONFIG_WIFI_5G_BANDWIDTHS           WIFI_BW_HT40
-#define CONFIG_WIFI_2G_PROTOCOL             WIFI_PROTOCOL_11N
-#define CONFIG_WIFI_5G_PROTOCOL             WIFI_PROTOCOL_11N
+#define CONFIG_WIFI_BANDWIDTH               WIFI_BW_HT40
 #define CONFIG_ESP_NOW_PHYMODE              WIFI_PHY_MODE_HT40
+#define CONFIG_SYNC_GPIO                    27  // Falling edge restarts the time base of both chips
 #define CONFIG_GAIN_CONTROL                 1   // 1:enable gain control, 0:disable gain control
 #define CONFIG_FORCE_GAIN                   0   // 1:force gain control, 0:automatic gain control
+#define CONFIG_CIR_DECODE_IQ                0   // 1:Q16 CORDIC decode with a gain table, 0:float decode
+#define CONFIG_GAIN_LUT_AGC_MIN             0   // Q16 decode: gain pairs whose compensation is kept in a table,
+#define CONFIG_GAIN_LUT_AGC_NUM             64  // others are computed for every packet
+#define CONFIG_GAIN_LUT_FFT_MIN             -16
+#define CONFIG_GAIN_LUT_FFT_NUM             32
 #define CONFIG_PRINT_CSI_DATA               0
 #define CONFIG_CRAB_MODE                    Self_Transmit_and_Receive_Mode
+#define CONFIG_CSI_RECV_RING_LEN            32  // Preallocated CSI frames, power of two
+#define CONFIG_CSI_FRAME_OFFSET             4   // Zero subcarriers before the first reported one
+#define CONFIG_CSI_JOIN_WINDOW              16  // Packet ids a slave record may wait for the local record
+#define CONFIG_CSI_DISPLAY_QUEUE_LEN        20
+#define CONFIG_CSI_DISPLAY_DECIMATE_LEVEL   10  // Waiting records from which only every other one is drawn
+#define CONFIG_TASK_USAGE_LOG_INTERVAL_MS   30000
 
-csi_data_t master_data[DATA_TABLE_SIZE];
+csi_join_t csi_join;
 int64_t time_zero = 0;
 typedef struct {
     uint32_t id;
     uint32_t time;
     int8_t fft_gain;
     uint8_t agc_gain;
-    int8_t buf[256];
+    uint8_t gain_flags;         /**< CSI_GAIN_TRACK_FLAG_* */
+    uint8_t gain_seq;           /**< Baseline the gains are compensated against, 0 for none */
+    uint8_t agc_gain_baseline;
+    int8_t fft_gain_baseline;
+    int8_t buf[4 * FFT_MAX_N];  /**< Interleaved CSI, one FFT_MAX_N segment per antenna */
 } csi_recv_queue_t;
 uint32_t recv_cnt = 0;
-QueueHandle_t csi_recv_queue;
-QueueHandle_t csi_display_queue;
+#if CONFIG_GAIN_CONTROL
+/* Only used by the CSI callback, the decoding task gets the baseline with each frame */
+static csi_gain_track_t s_gain_track;
+static csi_gain_baseline_t s_gain_baseline;
+#endif
+csi_frame_ring_t csi_recv_ring;
+csi_queue_t csi_display_queue;
 static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
 static const char *TAG = "csi_recv";
 
-static void wifi_init()
-{
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    ESP_ERROR_CHECK(esp_netif_init());
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    esp_wifi_set_band_mode(CONFIG_WIFI_BAND_MODE);
-    wifi_protocols_t protocols = {
-        .ghz_2g = CONFIG_WIFI_2G_PROTOCOL,
-        .ghz_5g = CONFIG_WIFI_5G_PROTOCOL
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_protocols(ESP_IF_WIFI_STA, &protocols));
-
-    wifi_bandwidths_t bandwidth = {
-        .ghz_2g = CONFIG_WIFI_2G_BANDWIDTHS,
-        .ghz_5g = CONFIG_WIFI_5G_BANDWIDTHS
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_bandwidths(ESP_IF_WIFI_STA, &bandwidth));
-
-    ESP_ERROR_CHECK(esp_wifi_start());
-    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
-
-    if ((CONFIG_WIFI_BAND_MODE == WIFI_BAND_MODE_2G_ONLY && CONFIG_WIFI_2G_BANDWIDTHS == WIFI_BW_HT20) || (CONFIG_WIFI_BAND_MODE == WIFI_BAND_MODE_5G_ONLY && CONFIG_WIFI_5G_BANDWIDTHS == WIFI_BW_HT20)) {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_LESS_INTERFERENCE_CHANNEL, WIFI_SECOND_CHAN_NONE));
-    } else {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_LESS_INTERFERENCE_CHANNEL, WIFI_SECOND_CHAN_BELOW));
-    }
-
-    ESP_ERROR_CHECK(esp_wifi_set_mac(WIFI_IF_STA, CONFIG_CSI_SEND_MAC));
-}
-
-static void wifi_esp_now_init(esp_now_peer_info_t peer)
-{
-    ESP_ERROR_CHECK(esp_now_init());
-    ESP_ERROR_CHECK(esp_now_set_pmk((uint8_t *)"pmk1234567890123"));
-    esp_now_rate_config_t rate_config = {
-        .phymode = CONFIG_ESP_NOW_PHYMODE,
-        .rate = WIFI_PHY_RATE_MCS0_LGI,
-        .ersu = false,
-        .dcm = false
-    };
-    ESP_ERROR_CHECK(esp_now_add_peer(&peer));
-    ESP_ERROR_CHECK(esp_now_set_peer_rate_config(peer.peer_addr, &rate_config));
-}
-
-static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
+static void CSI_HOT_ATTR wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 {
     static int64_t last_time = 0;
     if (!info || !info->buf) {
@@ -122,33 +102,57 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 
     const wifi_pkt_rx_ctrl_t *rx_ctrl = &info->rx_ctrl;
     static int s_count = 0;
-    static uint8_t agc_gain = 0;
-    static int8_t fft_gain = 0;
+    if (!s_count) {
+        csi_boot_mark("first_csi");
+    }
+    uint8_t agc_gain = 0;
+    int8_t fft_gain = 0;
+    uint32_t gain_flags = 0;
 #if CONFIG_GAIN_CONTROL
-    static uint8_t agc_gain_baseline = 0;
-    static int8_t fft_gain_baseline = 0;
     esp_csi_gain_ctrl_get_rx_gain(rx_ctrl, &agc_gain, &fft_gain);
-    if (s_count < 100) {
-        esp_csi_gain_ctrl_record_rx_gain(agc_gain, fft_gain);
-    } else if (s_count == 100) {
-        esp_csi_gain_ctrl_get_rx_gain_baseline(&agc_gain_baseline, &fft_gain_baseline);
+    csi_gain_baseline_record(&s_gain_baseline, agc_gain, fft_gain);
+
+    gain_flags = csi_gain_track_push(&s_gain_track, agc_gain, fft_gain);
+    if (gain_flags & CSI_GAIN_TRACK_FLAG_REBASELINE) {
+        /* Before the decode task compensates against the baseline, see csi_gain_baseline.h */
+        csi_gain_baseline_lock(&s_gain_baseline);
+        ESP_LOGI(TAG, "gain baseline %d, agc_gain_baseline %d, fft_gain_baseline %d, jumps %u",
+                 s_gain_track.seq, s_gain_track.agc_gain_baseline, s_gain_track.fft_gain_baseline,
+                 (unsigned)s_gain_track.jumps);
 #if CONFIG_FORCE_GAIN
-        esp_csi_gain_ctrl_set_rx_force_gain(agc_gain_baseline, fft_gain_baseline);
-        ESP_LOGI(TAG, "fft_force %d, agc_force %d", fft_gain_baseline, agc_gain_baseline);
+        esp_csi_gain_ctrl_set_rx_force_gain(s_gain_track.agc_gain_baseline, s_gain_track.fft_gain_baseline);
+        ESP_LOGI(TAG, "fft_force %d, agc_force %d", s_gain_track.fft_gain_baseline, s_gain_track.agc_gain_baseline);
 #endif
     }
 #endif
 
-    csi_recv_queue_t *csi_send_queuedata = (csi_recv_queue_t *)calloc(1, sizeof(csi_recv_queue_t));
-    memcpy(&(csi_send_queuedata->id), info->payload + 15, sizeof(uint32_t));
+    uint32_t id = 0;
+    memcpy(&id, info->payload + 15, sizeof(uint32_t));
 
-    csi_send_queuedata->time = info->rx_ctrl.timestamp;
-    csi_send_queuedata->agc_gain = agc_gain;
-    csi_send_queuedata->fft_gain = fft_gain;
+    /* Fill the preallocated slot in place; a full ring is counted as an overrun */
+    csi_recv_queue_t *csi_send_queuedata = csi_frame_ring_acquire(&csi_recv_ring);
+    if (csi_send_queuedata) {
+        csi_send_queuedata->id = id;
+        csi_send_queuedata->time = info->rx_ctrl.timestamp;
+        csi_send_queuedata->agc_gain = agc_gain;
+        csi_send_queuedata->fft_gain = fft_gain;
+        csi_send_queuedata->gain_flags = gain_flags;
+#if CONFIG_GAIN_CONTROL
+        csi_send_queuedata->gain_seq = s_gain_track.seq;
+        csi_send_queuedata->agc_gain_baseline = s_gain_track.agc_gain_baseline;
+        csi_send_queuedata->fft_gain_baseline = s_gain_track.fft_gain_baseline;
+#else
+        csi_send_queuedata->gain_seq = 0;
+#endif
 
-    memset(csi_send_queuedata->buf, 0, 256);
-    memcpy(csi_send_queuedata->buf + 8, info->buf, info->len);
-    xQueueSend(csi_recv_queue, &csi_send_queuedata, 0);
+        /* A plain copy, the decode task splits the antennas in its single pass */
+        size_t len = MIN(info->len, sizeof(csi_send_queuedata->buf) - 2 * CONFIG_CSI_FRAME_OFFSET);
+        memset(csi_send_queuedata->buf, 0, 2 * CONFIG_CSI_FRAME_OFFSET);
+        memcpy(csi_send_queuedata->buf + 2 * CONFIG_CSI_FRAME_OFFSET, info->buf, len);
+        memset(csi_send_queuedata->buf + 2 * CONFIG_CSI_FRAME_OFFSET + len, 0,
+               sizeof(csi_send_queuedata->buf) - 2 * CONFIG_CSI_FRAME_OFFSET - len);
+        csi_frame_ring_commit(&csi_recv_ring);
+    }
 
 #if CONFIG_PRINT_CSI_DATA
     if (!s_count) {
@@ -157,7 +161,7 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
     }
 
     ets_printf("CSI_DATA,%d," MACSTR ",%d,%d,%d,%d,%d,%d,%d,%d,%d",
-               csi_send_queuedata->id, MAC2STR(info->mac), rx_ctrl->rssi, rx_ctrl->rate,
+               id, MAC2STR(info->mac), rx_ctrl->rssi, rx_ctrl->rate,
                rx_ctrl->noise_floor, fft_gain, agc_gain, rx_ctrl->channel,
                rx_ctrl->timestamp, rx_ctrl->sig_len, rx_ctrl->rx_state);
 
@@ -176,8 +180,13 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 static void wifi_csi_init()
 {
     ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
-    csi_recv_queue = xQueueCreate(20, sizeof(csi_recv_queue_t *));
-    csi_display_queue = xQueueCreate(20, sizeof(csi_data_t));
+#if CONFIG_GAIN_CONTROL
+    csi_gain_track_init(&s_gain_track, NULL);
+#endif
+    csi_queue_config_t display_queue_config = CSI_QUEUE_CONFIG_DEFAULT("display", CONFIG_CSI_DISPLAY_QUEUE_LEN, sizeof(csi_data_t));
+    display_queue_config.policy = CSI_QUEUE_DECIMATE;
+    display_queue_config.decimate_level = CONFIG_CSI_DISPLAY_DECIMATE_LEVEL;
+    ESP_ERROR_CHECK(csi_queue_init(&csi_display_queue, &display_queue_config));
     wifi_csi_config_t csi_config = {
         .enable                   = true,
         .acquire_csi_legacy       = false,
@@ -204,35 +213,94 @@ static void process_csi_data_task(void *pvParameter)
 {
     static int s_count = 0;
     csi_recv_queue_t *csi_recv_queue_data = NULL;
-    Complex_Iq x_iq[64];
+    /* Only the direct-path tap is reported, so skip the full inverse FFT */
+    static const uint8_t cir_taps[] = {0};
+#if CONFIG_CIR_DECODE_IQ
+    _iq16 cir[2] = {};
+    _iq16 pha[2] = {};
+#else
     float cir[2] = {};
     float pha[2] = {};
-    while (xQueueReceive(csi_recv_queue, &csi_recv_queue_data, portMAX_DELAY) == pdTRUE) {
-        UBaseType_t queueLength = uxQueueMessagesWaiting(csi_recv_queue);
-        if (queueLength > 10) {
-            ESP_LOGW(TAG, "csi queueLength:%d", queueLength);
-        }
+#endif
 #if !CONFIG_FORCE_GAIN && CONFIG_GAIN_CONTROL
-        float scaling_factor = 0;
-        esp_csi_gain_ctrl_get_gain_compensation(&scaling_factor, csi_recv_queue_data->agc_gain, csi_recv_queue_data->fft_gain);
+    uint8_t gain_seq = 0;
+#if CONFIG_CIR_DECODE_IQ
+    static int32_t gain_lut_storage[CSI_GAIN_LUT_STORAGE_LEN(CONFIG_GAIN_LUT_AGC_NUM, CONFIG_GAIN_LUT_FFT_NUM)];
+    static csi_gain_lut_t gain_lut;
+    int32_t baseline_reciprocal = CSI_GAIN_LUT_ONE;  /* Of the baseline factor, one division per baseline */
+    ESP_ERROR_CHECK(csi_gain_lut_init(&gain_lut, gain_lut_storage, esp_csi_gain_ctrl_get_gain_compensation,
+                                      CONFIG_GAIN_LUT_AGC_MIN, CONFIG_GAIN_LUT_AGC_NUM,
+                                      CONFIG_GAIN_LUT_FFT_MIN, CONFIG_GAIN_LUT_FFT_NUM));
 #else
-        float scaling_factor = 1.0f;
+    float baseline_reciprocal = 1.0f;   /* Of the baseline compensation, one division per baseline */
 #endif
-
-        for (int i = 0; i < 64; i++) {
-            x_iq[i].real = _IQ16(csi_recv_queue_data->buf[2 * i]);
-            x_iq[i].imag = _IQ16(csi_recv_queue_data->buf[2 * i + 1]);
+#endif
+    while ((csi_recv_queue_data = csi_frame_ring_receive(&csi_recv_ring, portMAX_DELAY)) != NULL) {
+        uint32_t queueLength = csi_frame_ring_count(&csi_recv_ring);
+        if (queueLength > CONFIG_CSI_RECV_RING_LEN / 2) {
+            csi_frame_ring_stats_t stats;
+            csi_frame_ring_get_stats(&csi_recv_ring, &stats);
+            ESP_LOGW(TAG, "csi queueLength:%u, overruns:%u", (unsigned)queueLength, (unsigned)stats.overruns);
+        }
+#if !CONFIG_FORCE_GAIN && CONFIG_GAIN_CONTROL && CONFIG_CIR_DECODE_IQ
+        if (csi_recv_queue_data->gain_seq != gain_seq) {
+            /* The table follows the baseline of the gain control component, fixed along with our first one */
+            if (!gain_seq) {
+                csi_gain_lut_reset(&gain_lut);
+            }
+            gain_seq = csi_recv_queue_data->gain_seq;
+            int32_t baseline_gain = csi_gain_lut_get(&gain_lut, csi_recv_queue_data->agc_gain_baseline,
+                                                     csi_recv_queue_data->fft_gain_baseline);
+            baseline_reciprocal = csi_gain_lut_reciprocal(baseline_gain);
         }
-        fft_iq(x_iq, 1);
-        cir[0] = complex_magnitude_iq(x_iq[0]) * scaling_factor;
-        pha[0] = complex_phase_iq(x_iq[0]);
-        for (int i = 64; i < 128; i++) {
-            x_iq[i - 64].real = _IQ16(csi_recv_queue_data->buf[2 * i]);
-            x_iq[i - 64].imag = _IQ16(csi_recv_queue_data->buf[2 * i + 1]);
+        int32_t gain = CSI_GAIN_LUT_ONE;
+        if (gain_seq) {
+            gain = csi_gain_lut_relative(csi_gain_lut_get(&gain_lut, csi_recv_queue_data->agc_gain, csi_recv_queue_data->fft_gain),
+                                         baseline_reciprocal);
         }
-        fft_iq(x_iq, 1);
-        cir[1] = complex_magnitude_iq(x_iq[0]) * scaling_factor;
-        pha[1] = complex_phase_iq(x_iq[0]);
+#elif !CONFIG_FORCE_GAIN && CONFIG_GAIN_CONTROL
+        if (csi_recv_queue_data->gain_seq != gain_seq) {
+            float baseline_gain = 0;
+            gain_seq = csi_recv_queue_data->gain_seq;
+            esp_csi_gain_ctrl_get_gain_compensation(&baseline_gain, csi_recv_queue_data->agc_gain_baseline,
+                                                    csi_recv_queue_data->fft_gain_baseline);
+            baseline_reciprocal = baseline_gain > 0 ? 1.0f / baseline_gain : 1.0f;
+        }
+        float gain = 1.0f;
+        if (gain_seq) {
+            esp_csi_gain_ctrl_get_gain_compensation(&gain, csi_recv_queue_data->agc_gain, csi_recv_queue_data->fft_gain);
+            gain *= baseline_reciprocal;
+        }
+#elif CONFIG_CIR_DECODE_IQ
+        int32_t gain = CSI_GAIN_LUT_ONE;
+#else
+        float gain = 1.0f;
+#endif
+#if CONFIG_GAIN_CONTROL
+        /* The AGC switched under the frame, its amplitude is not comparable with its neighbours' */
+        if (csi_recv_queue_data->gain_flags & CSI_GAIN_TRACK_FLAG_JUMP) {
+            csi_frame_ring_release(&csi_recv_ring);
+            continue;
+        }
+#endif
+
+#if CONFIG_CIR_DECODE_IQ
+        cir_taps_dual_polar_iq(csi_recv_queue_data->buf, cir_taps, 1, cir, pha);
+        cir[0] = csi_gain_lut_apply(cir[0], gain);
+        cir[1] = csi_gain_lut_apply(cir[1], gain);
+
+        /* Float only for the record, whose layout is shared with the other board */
+        csi_data_t data = {
+            .start = {0xAA, 0x55},
+            .id = csi_recv_queue_data->id,
+            .time_delta = csi_recv_queue_data->time - time_zero,
+            .cir = {_IQ16toF(cir[0]), _IQ16toF(cir[1]), _IQ16toF(pha[0]), _IQ16toF(pha[1])},
+            .end = {0x55, 0xAA},
+        };
+#else
+        cir_taps_dual_polar(csi_recv_queue_data->buf, cir_taps, 1, cir, pha);
+        cir[0] *= gain;
+        cir[1] *= gain;
 
         csi_data_t data = {
             .start = {0xAA, 0x55},
@@ -241,35 +309,42 @@ static void process_csi_data_task(void *pvParameter)
             .cir = {cir[0], cir[1], pha[0], pha[1]},
             .end = {0x55, 0xAA},
         };
-        master_data[csi_recv_queue_data->id % DATA_TABLE_SIZE] = data;
-        xQueueSend(csi_display_queue, &data, 0);
-        free(csi_recv_queue_data);
+#endif
+        csi_join_put_master(&csi_join, &data);
+        /* Only the self transmit mode draws the local records, the dual receive mode draws joined pairs */
+        if (CONFIG_CRAB_MODE) {
+            csi_queue_send(&csi_display_queue, &data);
+        }
+        csi_frame_ring_release(&csi_recv_ring);
     }
 }
 
-void app_main()
+/* Rendering cost since the previous call, logged with the task CPU shares */
+static void display_log_stats(void)
 {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
+    bsp_display_stats_t stats;
+
+    if (bsp_display_get_stats(&stats, true) != ESP_OK || !stats.frames) {
+        return;
     }
-    ESP_ERROR_CHECK(ret);
-    bsp_slave_reset();
-    bsp_display_cfg_t cfg = {
-        .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
+
+    ESP_LOGI(TAG, "display %u frames, %u dropped (period %u ms), frame avg %u ms max %u ms, "
+             "flush avg %u us max %u us, %u px/frame",
+             (unsigned)stats.frames, (unsigned)stats.dropped_frames, (unsigned)stats.frame_period_ms,
+             (unsigned)(stats.frame_ms_total / stats.frames), (unsigned)stats.frame_ms_max,
+             (unsigned)(stats.flushes ? stats.flush_us_total / stats.flushes : 0), (unsigned)stats.flush_us_max,
+             (unsigned)(stats.dirty_pixels / stats.frames));
+}
+
+/* Boot steps, the radio and the board I/O need nothing from each other */
+static esp_err_t boot_radio_init(void *arg)
+{
+    csi_wifi_config_t wifi_config = {
+        .channel = CONFIG_LESS_INTERFERENCE_CHANNEL,
+        .bandwidth = CONFIG_WIFI_BANDWIDTH,
+        .mac = CONFIG_CSI_SEND_MAC,
     };
-    bsp_display_start_with_config(&cfg);
-    bsp_display_lock(0);
-    ui_init();
-    bsp_display_unlock();
-    bsp_display_backlight_on();
-    wifi_init();
+    ESP_ERROR_CHECK(csi_wifi_init(&wifi_config));
     /**
      * @brief Initialize ESP-NOW
      *  ESP-NOW protocol see: https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/network/esp_now.html
@@ -281,20 +356,119 @@ void app_main()
         .peer_addr = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
     };
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C6
-    wifi_esp_now_init(peer);
+    ESP_ERROR_CHECK(csi_wifi_esp_now_init(&peer, CONFIG_ESP_NOW_PHYMODE, WIFI_PHY_RATE_MCS0_LGI));
 #endif
-    init_gpio();
-
     wifi_csi_init();
-    vTaskDelay(100 / portTICK_PERIOD_MS);
+    return ESP_OK;
+}
+
+static esp_err_t boot_io_init(void *arg)
+{
+    csi_sync_gpio_config_t sync_config = {
+        .gpio_num = CONFIG_SYNC_GPIO,
+        .ring = &csi_recv_ring,
+        .time_zero = &time_zero,
+    };
+    ESP_ERROR_CHECK(csi_sync_gpio_init(&sync_config));
     init_uart();
-    bsp_led_init();
+    return bsp_led_init();
+}
 
-    xTaskCreate(process_csi_data_task, "process_csi_data_task", 4096, NULL, 6, NULL);
-    bool arg = CONFIG_CRAB_MODE;
-    xTaskCreate(csi_data_display_task, "csi_data_display_task", 4096, &arg, 6, NULL);
+/* The LVGL screens take longest to build, so the display comes up once CSI is captured */
+static void boot_display_task(void *arg)
+{
+    static bool s_crab_mode = CONFIG_CRAB_MODE;
+    bsp_display_cfg_t cfg = {
+        .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
+        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
+#if CONFIG_BSP_LCD_DRAW_BUF_DOUBLE
+        .double_buffer = 1,
+#else
+        .double_buffer = 0,
+#endif
+        .target_fps = CONFIG_BSP_DISPLAY_TARGET_FPS,
+#if CONFIG_BSP_LCD_DRAW_BUF_PSRAM
+        .trans_size = BSP_LCD_H_RES * BSP_LCD_TRANS_BUF_HEIGHT,
+        .flags = {
+            .buff_spiram = true,
+        }
+#else
+        .flags = {
+            .buff_dma = true,
+        }
+#endif
+    };
+    /* Rendering waits behind the CSI path, on the Wi-Fi core of dual-core chips */
+    cfg.lvgl_port_cfg.task_priority = csi_task_priority(CSI_TASK_STAGE_UI);
+    cfg.lvgl_port_cfg.task_affinity = csi_task_core(CSI_TASK_STAGE_UI);
+    lv_disp_t *display = bsp_display_start_with_config(&cfg);
+
+    if (display) {
+        csi_mem_note("lcd_draw_buf1", display->driver->draw_buf->buf1, cfg.buffer_size * sizeof(lv_color_t));
+        csi_mem_note("lcd_draw_buf2", display->driver->draw_buf->buf2, cfg.buffer_size * sizeof(lv_color_t));
+    }
+    csi_mem_note("ui_img_272184077", ui_img_272184077.data, ui_img_272184077.data_size);
+    bsp_display_lock(0);
+    ui_init();
+    bsp_display_unlock();
+    bsp_display_backlight_on();
+    csi_boot_mark("display");
+
+    ESP_ERROR_CHECK(csi_task_create(csi_data_display_task, "csi_data_display_task", 4096, &s_crab_mode, CSI_TASK_STAGE_UI, NULL));
+    vTaskDelete(NULL);
+}
+
+void app_main()
+{
+    csi_boot_mark("app_main");
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+    csi_boot_mark("nvs");
+    bsp_slave_reset();
+
+    ESP_ERROR_CHECK(csi_join_init(&csi_join, CONFIG_CSI_JOIN_WINDOW));
+    /* Before the boot steps: the sync ISR armed by io flushes the ring, which radio must not wipe afterwards */
+    ESP_ERROR_CHECK(csi_frame_ring_init(&csi_recv_ring, sizeof(csi_recv_queue_t), CONFIG_CSI_RECV_RING_LEN));
+    const csi_boot_step_t boot_steps[] = {
+        {.name = "radio", .init = boot_radio_init, .stage = CSI_TASK_STAGE_LINK, .stack_size = 4096},
+        {.name = "io", .init = boot_io_init, .stage = CSI_TASK_STAGE_BACKGROUND, .stack_size = 3072},
+    };
+    ESP_ERROR_CHECK(csi_boot_run_parallel(boot_steps, sizeof(boot_steps) / sizeof(boot_steps[0])));
+
+    csi_task_log_topology();
+    ESP_ERROR_CHECK(csi_task_create(process_csi_data_task, "process_csi_data_task", 4096, NULL, CSI_TASK_STAGE_DECODE, NULL));
+    csi_boot_mark("csi_live");
+    /* Gone once the display is up, so not registered with its stage */
+    xTaskCreatePinnedToCore(boot_display_task, "boot_display", 4096, NULL, csi_task_priority(CSI_TASK_STAGE_UI),
+                            NULL, csi_task_core(CSI_TASK_STAGE_UI));
     uint32_t recv_cnt_prv = 0;
+    uint32_t usage_log_time = esp_log_timestamp();
+    bool boot_logged = false;
     while (1) {
+        if (!boot_logged && csi_boot_get_us("first_csi") >= 0 && csi_boot_get_us("display") >= 0) {
+            csi_boot_log();
+#if CONFIG_CSI_MEM_LOG_MAP
+            csi_mem_note("wifi_csi_rx_cb", wifi_csi_rx_cb, 0);
+#if CONFIG_CIR_DECODE_IQ
+            csi_mem_note("cir_taps_dual_polar_iq", cir_taps_dual_polar_iq, 0);
+#else
+            csi_mem_note("cir_taps_dual_polar", cir_taps_dual_polar, 0);
+#endif
+            csi_mem_log_map();
+#endif
+            boot_logged = true;
+        }
+
+        if (esp_log_timestamp() - usage_log_time >= CONFIG_TASK_USAGE_LOG_INTERVAL_MS) {
+            usage_log_time = esp_log_timestamp();
+            csi_task_log_usage();
+            display_log_stats();
+        }
+
         static bool level = 1;
         static uint8_t time = 100;
         if ((recv_cnt -  recv_cnt_prv) >= 20) {
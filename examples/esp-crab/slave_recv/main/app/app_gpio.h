@@ -1,11 +0,0 @@
-
-#pragma once
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-void init_gpio(void);
-
-#ifdef __cplusplus
-}
-#endif
\ No newline at end of file
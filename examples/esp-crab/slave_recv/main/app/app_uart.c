@@ -6,8 +6,10 @@
 #include "sdkconfig.h"
 #include "esp_log.h"
 #include "app_uart.h"
+#include "uart_link.h"
 
 static const char *TAG = "UART";
+static uart_link_encoder_t s_link_encoder;
 
 void init_uart() {
     uart_config_t uart_config = {
@@ -33,6 +35,22 @@ int uart_send_data(const char *data, uint8_t len) {
     return uart_write_bytes(UART_PORT_NUM, data, len);
 }
 
+int uart_send_record(const csi_data_t *record, bool flush) {
+    if (uart_link_encoder_add(&s_link_encoder, record) || flush) {
+        return uart_send_flush();
+    }
+    return 0;
+}
+
+int uart_send_flush(void) {
+    const uint8_t *frame = NULL;
+    size_t len = uart_link_encoder_finish(&s_link_encoder, &frame);
+    if (!len) {
+        return 0;
+    }
+    return uart_write_bytes(UART_PORT_NUM, frame, len);
+}
+
 // void uart_receive_data() {
 //     uint8_t data[BUF_SIZE];
 //     int length = uart_read_bytes(UART_PORT_NUM, data, BUF_SIZE, 20 / portTICK_RATE_MS);
@@ -1,5 +1,8 @@
 
 #pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart_link.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -10,17 +13,27 @@ extern "C" {
 #define RXD_PIN            (GPIO_NUM_12)
 #define BUF_SIZE           4096
 
-typedef struct {
-    uint8_t start[2];      
-    uint32_t id;           
-    int64_t time_delta;    
-    float cir[4];          
-    uint8_t end[2];        
-} __attribute__((packed)) csi_data_t;
-
 void init_uart(void);
 int uart_send_data(const char *data, uint8_t len);
 
+/**
+ * @brief Queue one record on the framed link to master_recv
+ *
+ * Records are batched into one CRC-protected frame, which is written once it
+ * holds UART_LINK_MAX_RECORDS records or when flush is set.
+ *
+ * @param record Record to send
+ * @param flush  Write the pending frame now, e.g. when no more records are waiting
+ *
+ * @return Bytes written to the UART, 0 if the record was only queued
+ */
+int uart_send_record(const csi_data_t *record, bool flush);
+
+/**
+ * @brief Write the pending frame, if any
+ */
+int uart_send_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
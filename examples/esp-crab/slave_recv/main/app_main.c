@@ -15,6 +15,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <sys/param.h>
 #include "nvs_flash.h"
 #include "esp_mac.h"
 #include "rom/ets_sys.h"
@@ -22,24 +23,34 @@
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_now.h"
-#include "app_ifft.h"
-#include "app_gpio.h"
+#include "csi_fft.h"
+#include "csi_task.h"
+#include "csi_sync_gpio.h"
+#include "csi_wifi.h"
 #include "esp_timer.h"
 #include "app_uart.h"
+#include "csi_frame_ring.h"
 #include "IQmathLib.h"
 #include "bsp_C5_dual_antenna.h"
 #include "esp_csi_gain_ctrl.h"
+#include "csi_gain_lut.h"
+#include "csi_gain_track.h"
+#include "csi_gain_baseline.h"
 
 #define CONFIG_LESS_INTERFERENCE_CHANNEL    40
-#define CONFIG_WIFI_BAND_MODE               WIFI_BAND_MODE_5G_ONLY
-#define CONFIG_WIFI_2G_BANDWIDTHS           WIFI_BW_HT40
-#define CONFIG_WIFI_5G_BANDWIDTHS           WIFI_BW_HT40
-#define CONFIG_WIFI_2G_PROTOCOL             WIFI_PROTOCOL_11N
-#define CONFIG_WIFI_5G_PROTOCOL             WIFI_PROTOCOL_11N
+#define CONFIG_WIFI_BANDWIDTH               WIFI_BW_HT40
 #define CONFIG_ESP_NOW_PHYMODE              WIFI_PHY_MODE_HT40
+#define CONFIG_SYNC_GPIO                    27  // Falling edge restarts the time base of both chips
 #define CONFIG_GAIN_CONTROL                 1   // 1:enable gain control, 0:disable gain control
 #define CONFIG_FORCE_GAIN                   0   // 1:force gain control, 0:automatic gain control
+#define CONFIG_CIR_DECODE_IQ                0   // 1:Q16 CORDIC decode with a gain table, 0:float decode
+#define CONFIG_GAIN_LUT_AGC_MIN             0   // Q16 decode: gain pairs whose compensation is kept in a table,
+#define CONFIG_GAIN_LUT_AGC_NUM             64  // others are computed for every packet
+#define CONFIG_GAIN_LUT_FFT_MIN             -16
+#define CONFIG_GAIN_LUT_FFT_NUM             32
 #define CONFIG_PRINT_CSI_DATA               1
+#define CONFIG_CSI_SEND_RING_LEN            32  // Preallocated CSI frames, power of two
+#define CONFIG_CSI_FRAME_OFFSET             4   // Zero subcarriers before the first reported one
 
 int64_t time_zero = 0;
 typedef struct {
@@ -47,63 +58,22 @@ typedef struct {
     uint32_t time;
     uint8_t fft_gain;
     uint8_t agc_gain;
-    int8_t buf[256];
+    uint8_t gain_flags;         /**< CSI_GAIN_TRACK_FLAG_* */
+    uint8_t gain_seq;           /**< Baseline the gains are compensated against, 0 for none */
+    uint8_t agc_gain_baseline;
+    int8_t fft_gain_baseline;
+    int8_t buf[4 * FFT_MAX_N];  /**< Interleaved CSI, one FFT_MAX_N segment per antenna */
 } csi_send_queue_t;
 uint32_t recv_cnt = 0;
-QueueHandle_t csi_send_queue;
+#if CONFIG_GAIN_CONTROL
+/* Only used by the CSI callback, the decoding task gets the baseline with each frame */
+static csi_gain_track_t s_gain_track;
+static csi_gain_baseline_t s_gain_baseline;
+#endif
+csi_frame_ring_t csi_send_ring;
 static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
 static const char *TAG = "csi_recv";
 
-static void wifi_init()
-{
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    ESP_ERROR_CHECK(esp_netif_init());
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    esp_wifi_set_band_mode(CONFIG_WIFI_BAND_MODE);
-    wifi_protocols_t protocols = {
-        .ghz_2g = CONFIG_WIFI_2G_PROTOCOL,
-        .ghz_5g = CONFIG_WIFI_5G_PROTOCOL
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_protocols(ESP_IF_WIFI_STA, &protocols));
-
-    wifi_bandwidths_t bandwidth = {
-        .ghz_2g = CONFIG_WIFI_2G_BANDWIDTHS,
-        .ghz_5g = CONFIG_WIFI_5G_BANDWIDTHS
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_bandwidths(ESP_IF_WIFI_STA, &bandwidth));
-
-    ESP_ERROR_CHECK(esp_wifi_start());
-    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
-
-    if ((CONFIG_WIFI_BAND_MODE == WIFI_BAND_MODE_2G_ONLY && CONFIG_WIFI_2G_BANDWIDTHS == WIFI_BW_HT20) || (CONFIG_WIFI_BAND_MODE == WIFI_BAND_MODE_5G_ONLY && CONFIG_WIFI_5G_BANDWIDTHS == WIFI_BW_HT20)) {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_LESS_INTERFERENCE_CHANNEL, WIFI_SECOND_CHAN_NONE));
-    } else {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_LESS_INTERFERENCE_CHANNEL, WIFI_SECOND_CHAN_BELOW));
-    }
-
-    ESP_ERROR_CHECK(esp_wifi_set_mac(WIFI_IF_STA, CONFIG_CSI_SEND_MAC));
-}
-
-static void wifi_esp_now_init(esp_now_peer_info_t peer)
-{
-    ESP_ERROR_CHECK(esp_now_init());
-    ESP_ERROR_CHECK(esp_now_set_pmk((uint8_t *)"pmk1234567890123"));
-    esp_now_rate_config_t rate_config = {
-        .phymode = CONFIG_ESP_NOW_PHYMODE,
-        .rate = WIFI_PHY_RATE_MCS0_LGI,
-        .ersu = false,
-        .dcm = false
-    };
-    ESP_ERROR_CHECK(esp_now_add_peer(&peer));
-    ESP_ERROR_CHECK(esp_now_set_peer_rate_config(peer.peer_addr, &rate_config));
-
-}
-
 static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 {
     static int64_t last_time = 0;
@@ -118,33 +88,54 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 
     const wifi_pkt_rx_ctrl_t *rx_ctrl = &info->rx_ctrl;
     static int s_count = 0;
-    static uint8_t agc_gain = 0;
-    static int8_t fft_gain = 0;
+    uint8_t agc_gain = 0;
+    int8_t fft_gain = 0;
+    uint32_t gain_flags = 0;
 #if CONFIG_GAIN_CONTROL
-    static uint8_t agc_gain_baseline = 0;
-    static int8_t fft_gain_baseline = 0;
     esp_csi_gain_ctrl_get_rx_gain(info, &agc_gain, &fft_gain);
-    if (s_count < 100) {
-        esp_csi_gain_ctrl_record_rx_gain(agc_gain, fft_gain);
-    } else if (s_count == 100) {
-        esp_csi_gain_ctrl_get_rx_gain_baseline(&agc_gain_baseline, &fft_gain_baseline);
+    csi_gain_baseline_record(&s_gain_baseline, agc_gain, fft_gain);
+
+    gain_flags = csi_gain_track_push(&s_gain_track, agc_gain, fft_gain);
+    if (gain_flags & CSI_GAIN_TRACK_FLAG_REBASELINE) {
+        /* Before the decode task compensates against the baseline, see csi_gain_baseline.h */
+        csi_gain_baseline_lock(&s_gain_baseline);
+        ESP_LOGI(TAG, "gain baseline %d, agc_gain_baseline %d, fft_gain_baseline %d, jumps %u",
+                 s_gain_track.seq, s_gain_track.agc_gain_baseline, s_gain_track.fft_gain_baseline,
+                 (unsigned)s_gain_track.jumps);
 #if CONFIG_FORCE_GAIN
-        esp_csi_gain_ctrl_set_rx_force_gain(agc_gain_baseline, fft_gain_baseline);
-        ESP_LOGI(TAG, "fft_force %d, agc_force %d", fft_gain_baseline, agc_gain_baseline);
+        esp_csi_gain_ctrl_set_rx_force_gain(s_gain_track.agc_gain_baseline, s_gain_track.fft_gain_baseline);
+        ESP_LOGI(TAG, "fft_force %d, agc_force %d", s_gain_track.fft_gain_baseline, s_gain_track.agc_gain_baseline);
 #endif
     }
 #endif
 
-    csi_send_queue_t *csi_send_queuedata = (csi_send_queue_t *)calloc(1, sizeof(csi_send_queue_t));
-    memcpy(&(csi_send_queuedata->id), info->payload + 15, sizeof(uint32_t));
-
-    csi_send_queuedata->time = info->rx_ctrl.timestamp;
-    csi_send_queuedata->agc_gain = agc_gain;
-    csi_send_queuedata->fft_gain = fft_gain;
+    uint32_t id = 0;
+    memcpy(&id, info->payload + 15, sizeof(uint32_t));
+
+    /* Fill the preallocated slot in place; a full ring is counted as an overrun */
+    csi_send_queue_t *csi_send_queuedata = csi_frame_ring_acquire(&csi_send_ring);
+    if (csi_send_queuedata) {
+        csi_send_queuedata->id = id;
+        csi_send_queuedata->time = info->rx_ctrl.timestamp;
+        csi_send_queuedata->agc_gain = agc_gain;
+        csi_send_queuedata->fft_gain = fft_gain;
+        csi_send_queuedata->gain_flags = gain_flags;
+#if CONFIG_GAIN_CONTROL
+        csi_send_queuedata->gain_seq = s_gain_track.seq;
+        csi_send_queuedata->agc_gain_baseline = s_gain_track.agc_gain_baseline;
+        csi_send_queuedata->fft_gain_baseline = s_gain_track.fft_gain_baseline;
+#else
+        csi_send_queuedata->gain_seq = 0;
+#endif
 
-    memset(csi_send_queuedata->buf, 0, 256);
-    memcpy(csi_send_queuedata->buf + 8, info->buf, info->len);
-    xQueueSend(csi_send_queue, &csi_send_queuedata, 0);
+        /* A plain copy, the decode task splits the antennas in its single pass */
+        size_t len = MIN(info->len, sizeof(csi_send_queuedata->buf) - 2 * CONFIG_CSI_FRAME_OFFSET);
+        memset(csi_send_queuedata->buf, 0, 2 * CONFIG_CSI_FRAME_OFFSET);
+        memcpy(csi_send_queuedata->buf + 2 * CONFIG_CSI_FRAME_OFFSET, info->buf, len);
+        memset(csi_send_queuedata->buf + 2 * CONFIG_CSI_FRAME_OFFSET + len, 0,
+               sizeof(csi_send_queuedata->buf) - 2 * CONFIG_CSI_FRAME_OFFSET - len);
+        csi_frame_ring_commit(&csi_send_ring);
+    }
 
 #if CONFIG_PRINT_CSI_DATA
     if (!s_count) {
@@ -153,7 +144,7 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
     }
 
     ets_printf("CSI_DATA,%d," MACSTR ",%d,%d,%d,%d,%d,%d,%d,%d,%d",
-               csi_send_queuedata->id, MAC2STR(info->mac), rx_ctrl->rssi, rx_ctrl->rate,
+               id, MAC2STR(info->mac), rx_ctrl->rssi, rx_ctrl->rate,
                rx_ctrl->noise_floor, fft_gain, agc_gain, rx_ctrl->channel,
                rx_ctrl->timestamp, rx_ctrl->sig_len, rx_ctrl->rx_state);
 
@@ -172,7 +163,10 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 static void wifi_csi_init()
 {
     ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
-    csi_send_queue = xQueueCreate(20, sizeof(csi_send_queue_t *));
+    ESP_ERROR_CHECK(csi_frame_ring_init(&csi_send_ring, sizeof(csi_send_queue_t), CONFIG_CSI_SEND_RING_LEN));
+#if CONFIG_GAIN_CONTROL
+    csi_gain_track_init(&s_gain_track, NULL);
+#endif
     wifi_csi_config_t csi_config = {
         .enable                   = true,
         .acquire_csi_legacy       = false,
@@ -200,35 +194,94 @@ static void uart_send_task(void *pvParameter)
 {
     static int s_count = 0;
     csi_send_queue_t *csi_send_queue_data = NULL;
-    Complex_Iq x_iq[64];
+    /* Only the direct-path tap is reported, so skip the full inverse FFT */
+    static const uint8_t cir_taps[] = {0};
+#if CONFIG_CIR_DECODE_IQ
+    _iq16 cir[2] = {};
+    _iq16 pha[2] = {};
+#else
     float cir[2] = {};
     float pha[2] = {};
-    while (xQueueReceive(csi_send_queue, &csi_send_queue_data, portMAX_DELAY) == pdTRUE) {
-        UBaseType_t queueLength = uxQueueMessagesWaiting(csi_send_queue);
-        if (queueLength > 10) {
-            ESP_LOGW(TAG, "csi queueLength:%d", queueLength);
-        }
+#endif
 #if !CONFIG_FORCE_GAIN && CONFIG_GAIN_CONTROL
-        float scaling_factor = 0;
-        esp_csi_gain_ctrl_get_gain_compensation(&scaling_factor, csi_send_queue_data->agc_gain, csi_send_queue_data->fft_gain);
+    uint8_t gain_seq = 0;
+#if CONFIG_CIR_DECODE_IQ
+    static int32_t gain_lut_storage[CSI_GAIN_LUT_STORAGE_LEN(CONFIG_GAIN_LUT_AGC_NUM, CONFIG_GAIN_LUT_FFT_NUM)];
+    static csi_gain_lut_t gain_lut;
+    int32_t baseline_reciprocal = CSI_GAIN_LUT_ONE;  /* Of the baseline factor, one division per baseline */
+    ESP_ERROR_CHECK(csi_gain_lut_init(&gain_lut, gain_lut_storage, esp_csi_gain_ctrl_get_gain_compensation,
+                                      CONFIG_GAIN_LUT_AGC_MIN, CONFIG_GAIN_LUT_AGC_NUM,
+                                      CONFIG_GAIN_LUT_FFT_MIN, CONFIG_GAIN_LUT_FFT_NUM));
 #else
-        float scaling_factor = 1.0f;
+    float baseline_reciprocal = 1.0f;   /* Of the baseline compensation, one division per baseline */
 #endif
-
-        for (int i = 0; i < 64; i++) {
-            x_iq[i].real = _IQ16(csi_send_queue_data->buf[2 * i]);
-            x_iq[i].imag = _IQ16(csi_send_queue_data->buf[2 * i + 1]);
+#endif
+    while ((csi_send_queue_data = csi_frame_ring_receive(&csi_send_ring, portMAX_DELAY)) != NULL) {
+        uint32_t queueLength = csi_frame_ring_count(&csi_send_ring);
+        if (queueLength > CONFIG_CSI_SEND_RING_LEN / 2) {
+            csi_frame_ring_stats_t stats;
+            csi_frame_ring_get_stats(&csi_send_ring, &stats);
+            ESP_LOGW(TAG, "csi queueLength:%u, overruns:%u", (unsigned)queueLength, (unsigned)stats.overruns);
+        }
+#if !CONFIG_FORCE_GAIN && CONFIG_GAIN_CONTROL && CONFIG_CIR_DECODE_IQ
+        if (csi_send_queue_data->gain_seq != gain_seq) {
+            /* The table follows the baseline of the gain control component, fixed along with our first one */
+            if (!gain_seq) {
+                csi_gain_lut_reset(&gain_lut);
+            }
+            gain_seq = csi_send_queue_data->gain_seq;
+            int32_t baseline_gain = csi_gain_lut_get(&gain_lut, csi_send_queue_data->agc_gain_baseline,
+                                                     csi_send_queue_data->fft_gain_baseline);
+            baseline_reciprocal = csi_gain_lut_reciprocal(baseline_gain);
+        }
+        int32_t gain = CSI_GAIN_LUT_ONE;
+        if (gain_seq) {
+            gain = csi_gain_lut_relative(csi_gain_lut_get(&gain_lut, csi_send_queue_data->agc_gain, csi_send_queue_data->fft_gain),
+                                         baseline_reciprocal);
         }
-        fft_iq(x_iq, 1);
-        cir[0] = complex_magnitude_iq(x_iq[0]) * scaling_factor;
-        pha[0] = complex_phase_iq(x_iq[0]);
-        for (int i = 64; i < 128; i++) {
-            x_iq[i - 64].real = _IQ16(csi_send_queue_data->buf[2 * i]);
-            x_iq[i - 64].imag = _IQ16(csi_send_queue_data->buf[2 * i + 1]);
+#elif !CONFIG_FORCE_GAIN && CONFIG_GAIN_CONTROL
+        if (csi_send_queue_data->gain_seq != gain_seq) {
+            float baseline_gain = 0;
+            gain_seq = csi_send_queue_data->gain_seq;
+            esp_csi_gain_ctrl_get_gain_compensation(&baseline_gain, csi_send_queue_data->agc_gain_baseline,
+                                                    csi_send_queue_data->fft_gain_baseline);
+            baseline_reciprocal = baseline_gain > 0 ? 1.0f / baseline_gain : 1.0f;
         }
-        fft_iq(x_iq, 1);
-        cir[1] = complex_magnitude_iq(x_iq[0]) * scaling_factor;
-        pha[1] = complex_phase_iq(x_iq[0]);
+        float gain = 1.0f;
+        if (gain_seq) {
+            esp_csi_gain_ctrl_get_gain_compensation(&gain, csi_send_queue_data->agc_gain, csi_send_queue_data->fft_gain);
+            gain *= baseline_reciprocal;
+        }
+#elif CONFIG_CIR_DECODE_IQ
+        int32_t gain = CSI_GAIN_LUT_ONE;
+#else
+        float gain = 1.0f;
+#endif
+#if CONFIG_GAIN_CONTROL
+        /* The AGC switched under the frame, its amplitude is not comparable with its neighbours' */
+        if (csi_send_queue_data->gain_flags & CSI_GAIN_TRACK_FLAG_JUMP) {
+            csi_frame_ring_release(&csi_send_ring);
+            continue;
+        }
+#endif
+
+#if CONFIG_CIR_DECODE_IQ
+        cir_taps_dual_polar_iq(csi_send_queue_data->buf, cir_taps, 1, cir, pha);
+        cir[0] = csi_gain_lut_apply(cir[0], gain);
+        cir[1] = csi_gain_lut_apply(cir[1], gain);
+
+        /* Float only for the record, whose layout is shared with the other board */
+        csi_data_t data = {
+            .start = {0xAA, 0x55},
+            .id = csi_send_queue_data->id,
+            .time_delta = csi_send_queue_data->time - time_zero,
+            .cir = {_IQ16toF(cir[0]), _IQ16toF(cir[1]), _IQ16toF(pha[0]), _IQ16toF(pha[1])},
+            .end = {0x55, 0xAA},
+        };
+#else
+        cir_taps_dual_polar(csi_send_queue_data->buf, cir_taps, 1, cir, pha);
+        cir[0] *= gain;
+        cir[1] *= gain;
 
         csi_data_t data = {
             .start = {0xAA, 0x55},
@@ -237,8 +290,10 @@ static void uart_send_task(void *pvParameter)
             .cir = {cir[0], cir[1], pha[0], pha[1]},
             .end = {0x55, 0xAA},
         };
-        uart_send_data((const char *)&data, sizeof(data));
-        free(csi_send_queue_data);
+#endif
+        /* Batch while frames are still waiting, send as soon as the ring runs dry */
+        uart_send_record(&data, csi_frame_ring_count(&csi_send_ring) <= 1);
+        csi_frame_ring_release(&csi_send_ring);
     }
 }
 
@@ -250,7 +305,12 @@ void app_main()
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
-    wifi_init();
+    csi_wifi_config_t wifi_config = {
+        .channel = CONFIG_LESS_INTERFERENCE_CHANNEL,
+        .bandwidth = CONFIG_WIFI_BANDWIDTH,
+        .mac = CONFIG_CSI_SEND_MAC,
+    };
+    ESP_ERROR_CHECK(csi_wifi_init(&wifi_config));
 
     /**
      * @brief Initialize ESP-NOW
@@ -263,13 +323,19 @@ void app_main()
         .peer_addr = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
     };
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C6
-    wifi_esp_now_init(peer);
+    ESP_ERROR_CHECK(csi_wifi_esp_now_init(&peer, CONFIG_ESP_NOW_PHYMODE, WIFI_PHY_RATE_MCS0_LGI));
 #endif
-    init_gpio();
+    csi_sync_gpio_config_t sync_config = {
+        .gpio_num = CONFIG_SYNC_GPIO,
+        .ring = &csi_send_ring,
+        .time_zero = &time_zero,
+    };
+    ESP_ERROR_CHECK(csi_sync_gpio_init(&sync_config));
     init_uart();
     bsp_led_init();
     wifi_csi_init();
-    xTaskCreate(uart_send_task, "uart_send_task", 4096, NULL, 6, NULL);
+    csi_task_log_topology();
+    ESP_ERROR_CHECK(csi_task_create(uart_send_task, "uart_send_task", 4096, NULL, CSI_TASK_STAGE_LINK, NULL));
     uint32_t recv_cnt_prv = 0;
     while (1) {
         static bool level = 1;
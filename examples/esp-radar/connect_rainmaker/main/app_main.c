@@ -9,6 +9,8 @@
 #include "freertos/timers.h"
 
 #include <esp_log.h>
+#include <esp_check.h>
+#include <esp_bit_defs.h>
 #include <nvs_flash.h>
 
 #include "ping/ping_sock.h"
@@ -33,6 +35,7 @@
 
 #include "esp_radar.h"
 #include "esp_ping.h"
+#include "excitation.h"
 
 #if CONFIG_IDF_TARGET_ESP32C5
 #define WS2812_GPIO 27
@@ -57,6 +60,11 @@
 #define AUTO_CALIBRATE_RAPORT_INTERVAL             5
 
 #define RADAR_PING_DATA_INTERVAL                   10
+#define RADAR_EXCITATION_FLOOR_HZ                  10          /**< Ping rate of a room without movement */
+#define RADAR_EXCITATION_CEILING_HZ                (1000 / RADAR_PING_DATA_INTERVAL)
+#define RADAR_EXCITATION_HOLD_MS                   (30 * 1000)
+#define RADAR_EXCITATION_DECAY_MS                  (10 * 1000)
+#define RADAR_EXCITATION_UPDATE_MS                 500
 #define RADAR_DETECT_BUFF_MAX_SIZE                 16
 #define RADAR_PARAM_SOMEONE_STATUS                 "someone_status"
 #define RADAR_PARAM_SOMEONE_TIMEOUT                "someone_timeout"
@@ -67,6 +75,12 @@
 #define RADAR_PARAM_FILTER_COUNT                   "filter_count"
 #define RADAR_PARAM_THRESHOLD_CALIBRATE            "threshold_calibrate"
 #define RADAR_PARAM_THRESHOLD_CALIBRATE_TIMEOUT    "threshold_calibrate_timeout"
+#define RADAR_PARAM_EXCITATION_RATE                "excitation_rate"
+
+#define RADAR_REPORT_INTERVAL_MS                   (10 * 1000) /**< Minimum interval between two batched reports */
+#define RADAR_REPORT_URGENT_INTERVAL_MS            (1 * 1000)  /**< Minimum interval before a presence transition is reported */
+#define RADAR_REPORT_TASK_STACK_SIZE               (6 * 1024)
+#define RADAR_REPORT_TASK_PRIORITY                 (tskIDLE_PRIORITY + 2)
 static led_strip_handle_t led_strip;
 typedef struct  {
     bool threshold_calibrate;               /**< Self-calibration acquisition, the most suitable threshold, calibration is to ensure that no one is in the room */
@@ -83,6 +97,7 @@ static nvs_handle_t g_nvs_handle                  = 0;
 static int32_t g_auto_calibrate_timerleft         = 0;
 static TimerHandle_t g_auto_calibrate_timerhandle = NULL;
 static esp_rmaker_device_t *radar_device          = NULL;
+static volatile bool g_excitation_motion          = false;
 static radar_detect_config_t g_detect_config      = {
     .someone_timeout = 3 * 60,
     .move_threshold  = 0.002,
@@ -91,9 +106,66 @@ static radar_detect_config_t g_detect_config      = {
     .threshold_calibrate_timeout = 60,
 };
 
+/**
+ * @brief Parameters reported to the cloud through the reporting stage
+ */
+typedef enum {
+    RADAR_REPORT_SOMEONE_STATUS,
+    RADAR_REPORT_MOVE_STATUS,
+    RADAR_REPORT_MOVE_COUNT,
+    RADAR_REPORT_MOVE_THRESHOLD,
+    RADAR_REPORT_THRESHOLD_CALIBRATE,
+    RADAR_REPORT_THRESHOLD_CALIBRATE_TIMEOUT,
+    RADAR_REPORT_EXCITATION_RATE,
+    RADAR_REPORT_MAX,
+} radar_report_id_t;
+
+static const char *const s_report_param_names[RADAR_REPORT_MAX] = {
+    [RADAR_REPORT_SOMEONE_STATUS]              = RADAR_PARAM_SOMEONE_STATUS,
+    [RADAR_REPORT_MOVE_STATUS]                 = RADAR_PARAM_MOVE_STATUS,
+    [RADAR_REPORT_MOVE_COUNT]                  = RADAR_PARAM_MOVE_COUNT,
+    [RADAR_REPORT_MOVE_THRESHOLD]              = RADAR_PARAM_MOVE_THRESHOLD,
+    [RADAR_REPORT_THRESHOLD_CALIBRATE]         = RADAR_PARAM_THRESHOLD_CALIBRATE,
+    [RADAR_REPORT_THRESHOLD_CALIBRATE_TIMEOUT] = RADAR_PARAM_THRESHOLD_CALIBRATE_TIMEOUT,
+    [RADAR_REPORT_EXCITATION_RATE]             = RADAR_PARAM_EXCITATION_RATE,
+};
+
+/* Counted between two reports and restarted from 0 after each */
+#define RADAR_REPORT_COUNTERS                      BIT(RADAR_REPORT_MOVE_COUNT)
+
+/**
+ * @brief Reporting stage
+ *
+ * The radar callback and the calibration timer only store the latest value
+ * of a parameter and mark it dirty. The report task sends every dirty value
+ * that differs from the one last reported in a single MQTT message, at most
+ * every RADAR_REPORT_INTERVAL_MS, or RADAR_REPORT_URGENT_INTERVAL_MS after
+ * the previous report when the presence or movement state changed.
+ */
+static struct {
+    esp_rmaker_param_t *params[RADAR_REPORT_MAX];   /**< Looked up once in radar_report_init() */
+    esp_rmaker_param_val_t pending[RADAR_REPORT_MAX];
+    esp_rmaker_param_val_t reported[RADAR_REPORT_MAX];
+    uint32_t dirty;                                 /**< BIT(radar_report_id_t) of the pending values */
+    uint32_t reports;                               /**< MQTT messages sent */
+    uint32_t updates;                               /**< Parameter values sent */
+    TaskHandle_t task;
+} s_report;
+static portMUX_TYPE s_report_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Ping the gateway to excite CSI, a running session is replaced
+ */
 static esp_err_t ping_router_start(uint32_t interval_ms)
 {
     static esp_ping_handle_t ping_handle = NULL;
+
+    if (ping_handle) {
+        esp_ping_stop(ping_handle);
+        esp_ping_delete_session(ping_handle);
+        ping_handle = NULL;
+    }
+
     esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
     config.count       = 0;
     config.timeout_ms  = 1000;
@@ -117,6 +189,215 @@ static esp_err_t ping_router_start(uint32_t interval_ms)
     return ESP_OK;
 }
 
+static bool radar_report_equal(const esp_rmaker_param_val_t *a, const esp_rmaker_param_val_t *b)
+{
+    if (a->type != b->type) {
+        return false;
+    }
+
+    switch (a->type) {
+    case RMAKER_VAL_TYPE_BOOLEAN:
+        return a->val.b == b->val.b;
+    case RMAKER_VAL_TYPE_INTEGER:
+        return a->val.i == b->val.i;
+    case RMAKER_VAL_TYPE_FLOAT:
+        return a->val.f == b->val.f;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Queue the value of a parameter for the next report
+ *
+ * @param urgent Report within RADAR_REPORT_URGENT_INTERVAL_MS, e.g. on a presence transition
+ */
+static void radar_report_set(radar_report_id_t id, esp_rmaker_param_val_t val, bool urgent)
+{
+    portENTER_CRITICAL(&s_report_lock);
+    s_report.pending[id] = val;
+    s_report.dirty |= BIT(id);
+    portEXIT_CRITICAL(&s_report_lock);
+
+    if (urgent && s_report.task) {
+        xTaskNotifyGive(s_report.task);
+    }
+}
+
+/**
+ * @brief Reporting stage id of a parameter, RADAR_REPORT_MAX if it is reported directly
+ */
+static radar_report_id_t radar_report_find(const esp_rmaker_param_t *param)
+{
+    int i = 0;
+
+    for (; i < RADAR_REPORT_MAX && s_report.params[i] != param; i++) {
+    }
+
+    return i;
+}
+
+/**
+ * @brief Add to a counter of RADAR_REPORT_COUNTERS
+ */
+static void radar_report_add(radar_report_id_t id, int count)
+{
+    portENTER_CRITICAL(&s_report_lock);
+    s_report.pending[id].val.i += count;
+    s_report.dirty |= BIT(id);
+    portEXIT_CRITICAL(&s_report_lock);
+}
+
+/**
+ * @brief Send the dirty values that changed as one report
+ *
+ * @return Whether a report was sent
+ */
+static bool radar_report_flush(void)
+{
+    esp_rmaker_param_val_t values[RADAR_REPORT_MAX];
+    uint32_t dirty = 0;
+
+    /* Keep the values until the time is synchronized, the cloud drops the reports without a timestamp */
+    if (!esp_rmaker_time_check()) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_report_lock);
+    dirty = s_report.dirty;
+    memcpy(values, s_report.pending, sizeof(values));
+    s_report.dirty = 0;
+
+    for (int i = 0; i < RADAR_REPORT_MAX; i++) {
+        if (RADAR_REPORT_COUNTERS & BIT(i)) {
+            s_report.pending[i].val.i = 0;
+        }
+    }
+    portEXIT_CRITICAL(&s_report_lock);
+
+    int last = -1;
+
+    for (int i = 0; i < RADAR_REPORT_MAX; i++) {
+        /* A counter restarts at 0 after each report, an equal count is new movement */
+        if ((dirty & BIT(i)) && !(RADAR_REPORT_COUNTERS & BIT(i))
+                && radar_report_equal(&values[i], &s_report.reported[i])) {
+            dirty &= ~BIT(i);
+        }
+
+        if (dirty & BIT(i)) {
+            last = i;
+        }
+    }
+
+    if (last < 0) {
+        return false;
+    }
+
+    /**
+     * @note esp_rmaker_param_update() only marks the parameter as changed,
+     *       the report of the last one carries all the marked parameters
+     */
+    for (int i = 0; i <= last; i++) {
+        if (!(dirty & BIT(i))) {
+            continue;
+        }
+
+        if (i < last) {
+            esp_rmaker_param_update(s_report.params[i], values[i]);
+        } else {
+            esp_rmaker_param_update_and_report(s_report.params[i], values[i]);
+        }
+
+        s_report.reported[i] = values[i];
+        s_report.updates++;
+    }
+
+    s_report.reports++;
+    ESP_LOGD(TAG, "Report 0x%02lx, reports: %lu, updates: %lu", (unsigned long)dirty,
+             (unsigned long)s_report.reports, (unsigned long)s_report.updates);
+
+    return true;
+}
+
+static void radar_report_task(void *arg)
+{
+    uint32_t last_report = esp_log_timestamp() - RADAR_REPORT_INTERVAL_MS;
+    bool urgent = false;
+
+    for (;;) {
+        uint32_t interval = urgent ? RADAR_REPORT_URGENT_INTERVAL_MS : RADAR_REPORT_INTERVAL_MS;
+        int32_t wait_ms = (int32_t)(last_report + interval - esp_log_timestamp());
+
+        if (wait_ms > 0) {
+            urgent |= ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms)) > 0;
+            continue;
+        }
+
+        urgent = false;
+
+        if (radar_report_flush()) {
+            last_report = esp_log_timestamp();
+        } else {
+            /* Nothing changed, the next urgent value is sent right away */
+            urgent = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RADAR_REPORT_INTERVAL_MS)) > 0;
+        }
+    }
+}
+
+/**
+ * @brief Look up the reported parameters of the device and start the report task
+ */
+static esp_err_t radar_report_init(esp_rmaker_device_t *device)
+{
+    for (int i = 0; i < RADAR_REPORT_MAX; i++) {
+        s_report.params[i] = esp_rmaker_device_get_param_by_name(device, s_report_param_names[i]);
+        ESP_RETURN_ON_FALSE(s_report.params[i], ESP_ERR_NOT_FOUND, TAG, "param '%s' not found", s_report_param_names[i]);
+
+        /* Invalid never compares equal, so the first value of each parameter is sent */
+        s_report.reported[i].type = RMAKER_VAL_TYPE_INVALID;
+    }
+
+    for (int i = 0; i < RADAR_REPORT_MAX; i++) {
+        if (RADAR_REPORT_COUNTERS & BIT(i)) {
+            s_report.pending[i] = esp_rmaker_int(0);
+        }
+    }
+
+    BaseType_t ret = xTaskCreate(radar_report_task, "radar_report", RADAR_REPORT_TASK_STACK_SIZE,
+                                 NULL, RADAR_REPORT_TASK_PRIORITY, &s_report.task);
+    ESP_RETURN_ON_FALSE(ret == pdPASS, ESP_ERR_NO_MEM, TAG, "create report task failed");
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Ping at the ceiling rate while people move, decay to the floor rate in a still room
+ */
+static void excitation_task(void *arg)
+{
+    excitation_config_t config = {
+        .floor_hz   = RADAR_EXCITATION_FLOOR_HZ,
+        .ceiling_hz = RADAR_EXCITATION_CEILING_HZ,
+        .hold_ms    = RADAR_EXCITATION_HOLD_MS,
+        .decay_ms   = RADAR_EXCITATION_DECAY_MS,
+    };
+    excitation_t exc = {0};
+    excitation_init(&exc, &config, esp_log_timestamp());
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(RADAR_EXCITATION_UPDATE_MS));
+
+        bool motion = g_excitation_motion;
+        g_excitation_motion = false;
+
+        if (excitation_update(&exc, motion, esp_log_timestamp())) {
+            ESP_LOGI(TAG, "Excitation rate: %u Hz", excitation_rate_hz(&exc));
+            ping_router_start(excitation_interval_ms(&exc));
+            radar_report_set(RADAR_REPORT_EXCITATION_RATE, esp_rmaker_int(excitation_rate_hz(&exc)), false);
+        }
+    }
+}
+
 static void radar_cb(void *ctx, const wifi_radar_info_t *info)
 {
     bool someone_status = false;
@@ -166,6 +447,9 @@ static void radar_cb(void *ctx, const wifi_radar_info_t *info)
 
     /* Calibrate the environment, LED will flash yellow */
     if (g_detect_config.threshold_calibrate) {
+        /* The thresholds are calibrated at the ceiling rate, the one that detects */
+        g_excitation_motion = true;
+
         static bool led_status = false;
 
         if (led_status) {
@@ -193,14 +477,16 @@ static void radar_cb(void *ctx, const wifi_radar_info_t *info)
         someone_status = false;
     }
 
+    bool move_changed = move_status != s_last_move_status;
+
     if (move_status) {
-        if (move_status != s_last_move_status) {
+        if (move_changed) {
             led_strip_set_pixel(led_strip, 0, 0, 255, 0);
             ESP_LOGI(TAG, "someone moves in the room");
         }
 
         s_last_move_time = esp_log_timestamp();
-    } else if (move_status != s_last_move_status) {
+    } else if (move_changed) {
         ESP_LOGI(TAG, "No one moves in the room");
     } else if (esp_log_timestamp() - s_last_move_time > 3 * 1000) {
         if (someone_status) {
@@ -213,41 +499,20 @@ static void radar_cb(void *ctx, const wifi_radar_info_t *info)
     s_last_move_status = move_status;
 
     /**
-     * @brief Report the room status to the cloud every 10 seconds or when the room status changes
+     * @brief Queue the room status for the report task, transitions are reported right away,
+     *        the move count at most every RADAR_REPORT_INTERVAL_MS
      */
-    if (!esp_rmaker_time_check()) {
-        return;
-    }
-
-    static bool s_report_someone_status     = false;
-    static bool s_report_move_status        = false;
-    static uint32_t s_report_move_count     = 0;
-    static uint32_t s_report_move_timestamp = 0;
-    s_report_move_count = move_status ? s_report_move_count + 1 : s_report_move_count;
+    static bool s_last_someone_status = false;
+    bool someone_changed = someone_status != s_last_someone_status;
+    s_last_someone_status = someone_status;
 
-    if (s_report_someone_status != someone_status && !someone_status) {
-        esp_rmaker_param_t *someone_status_param = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_SOMEONE_STATUS);
-        esp_rmaker_param_update_and_report(someone_status_param, esp_rmaker_bool(someone_status));
-        s_report_someone_status = someone_status;
+    if (move_status) {
+        g_excitation_motion = true;
+        radar_report_add(RADAR_REPORT_MOVE_COUNT, 1);
     }
 
-    if (move_status != s_report_move_status
-            /* Reduce the number of times to report data and reduce server pressure */
-            || (move_status && esp_log_timestamp() - s_report_move_timestamp > 10 * 1000)) {
-        esp_rmaker_param_t *someone_status_param = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_SOMEONE_STATUS);
-        esp_rmaker_param_update(someone_status_param, esp_rmaker_bool(someone_status));
-        esp_rmaker_param_t *move_status_param = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_MOVE_STATUS);
-        esp_rmaker_param_update(move_status_param, esp_rmaker_bool(move_status | (s_report_move_count > 0)));
-        esp_rmaker_param_t *move_count_param = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_MOVE_COUNT);
-        esp_rmaker_param_update_and_report(move_count_param, esp_rmaker_int(s_report_move_count));
-
-        if (!s_report_move_status || !s_report_move_count) {
-            s_report_move_status = move_status;
-        }
-
-        s_report_move_count     = 0;
-        s_report_move_timestamp = esp_log_timestamp();
-    }
+    radar_report_set(RADAR_REPORT_MOVE_STATUS, esp_rmaker_bool(move_status), move_changed);
+    radar_report_set(RADAR_REPORT_SOMEONE_STATUS, esp_rmaker_bool(someone_status), someone_changed);
 }
 
 static esp_err_t radar_start()
@@ -284,17 +549,16 @@ static void auto_calibrate_timercb(TimerHandle_t timer)
         xTimerStop(g_auto_calibrate_timerhandle, portMAX_DELAY);
 
         esp_radar_train_stop(&g_someone_threshold, &g_detect_config.move_threshold);
-        esp_rmaker_param_t *move_threshold_param = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_MOVE_THRESHOLD);
-        esp_rmaker_param_update(move_threshold_param, esp_rmaker_float(g_detect_config.move_threshold));
+        radar_report_set(RADAR_REPORT_MOVE_THRESHOLD, esp_rmaker_float(g_detect_config.move_threshold), true);
 
         nvs_set_blob(g_nvs_handle, "detect_config", &g_detect_config, sizeof(radar_detect_config_t));
         nvs_commit(g_nvs_handle);
     }
 
-    esp_rmaker_param_t *param_threshold_calibrate = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_THRESHOLD_CALIBRATE);
-    esp_rmaker_param_update(param_threshold_calibrate, esp_rmaker_bool(g_detect_config.threshold_calibrate));
-    esp_rmaker_param_t *param_threshold_calibrate_timeout = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_THRESHOLD_CALIBRATE_TIMEOUT);
-    esp_rmaker_param_update_and_report(param_threshold_calibrate_timeout, esp_rmaker_int(g_auto_calibrate_timerleft));
+    /* The countdown goes out with the next report, the end of the calibration right away */
+    radar_report_set(RADAR_REPORT_THRESHOLD_CALIBRATE, esp_rmaker_bool(g_detect_config.threshold_calibrate),
+                     !g_detect_config.threshold_calibrate);
+    radar_report_set(RADAR_REPORT_THRESHOLD_CALIBRATE_TIMEOUT, esp_rmaker_int(g_auto_calibrate_timerleft), false);
 }
 
 /* Callback to handle commands received from the RainMaker cloud */
@@ -335,7 +599,15 @@ static esp_err_t write_cb(const esp_rmaker_device_t *device, const esp_rmaker_pa
         return ESP_OK;
     }
 
-    esp_rmaker_param_update_and_report(param, val);
+    /* Echo the accepted value, through the reporting stage when it holds the parameter */
+    radar_report_id_t id = radar_report_find(param);
+
+    if (id < RADAR_REPORT_MAX) {
+        radar_report_set(id, val, true);
+    } else {
+        esp_rmaker_param_update_and_report(param, val);
+    }
+
     nvs_set_blob(g_nvs_handle, "detect_config", &g_detect_config, sizeof(radar_detect_config_t));
     nvs_commit(g_nvs_handle);
     return ESP_OK;
@@ -419,6 +691,7 @@ void app_main()
         {RADAR_PARAM_SOMEONE_TIMEOUT, PROP_FLAG_READ | PROP_FLAG_WRITE, ESP_RMAKER_UI_TEXT, esp_rmaker_int(g_detect_config.someone_timeout), esp_rmaker_int(10), esp_rmaker_int(3600), esp_rmaker_int(10)},
         {RADAR_PARAM_FILTER_WINDOW, PROP_FLAG_READ | PROP_FLAG_WRITE, ESP_RMAKER_UI_TEXT, esp_rmaker_int(g_detect_config.filter_window), esp_rmaker_int(1), esp_rmaker_int(16), esp_rmaker_int(1)},
         {RADAR_PARAM_FILTER_COUNT, PROP_FLAG_READ | PROP_FLAG_WRITE, ESP_RMAKER_UI_TEXT, esp_rmaker_int(g_detect_config.filter_count), esp_rmaker_int(1), esp_rmaker_int(16), esp_rmaker_int(1)},
+        {RADAR_PARAM_EXCITATION_RATE, PROP_FLAG_READ, ESP_RMAKER_UI_TEXT, esp_rmaker_int(RADAR_EXCITATION_CEILING_HZ), invalid_val, invalid_val, invalid_val},
     };
 
     for (int i = 0; i < sizeof(radar_param_list) / sizeof(radar_param_list[0]); ++i) {
@@ -438,8 +711,8 @@ void app_main()
         ESP_ERROR_CHECK(esp_rmaker_device_add_param(radar_device, param));
     }
 
-    esp_rmaker_param_t *move_count_param = esp_rmaker_device_get_param_by_name(radar_device, RADAR_PARAM_MOVE_COUNT);
-    esp_rmaker_device_assign_primary_param(radar_device, move_count_param);
+    ESP_ERROR_CHECK(radar_report_init(radar_device));
+    esp_rmaker_device_assign_primary_param(radar_device, s_report.params[RADAR_REPORT_MOVE_COUNT]);
     ESP_ERROR_CHECK(esp_rmaker_node_add_device(node, radar_device));
 
     /* Enable OTA */
@@ -478,4 +751,5 @@ void app_main()
      */
     radar_start();
     ping_router_start(RADAR_PING_DATA_INTERVAL);
+    xTaskCreate(excitation_task, "excitation", 3072, NULL, tskIDLE_PRIORITY + 2, NULL);
 }
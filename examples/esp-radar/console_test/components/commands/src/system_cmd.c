@@ -14,6 +14,8 @@
 
 #include "esp_log.h"
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/param.h>
 #include "argtable3/argtable3.h"
@@ -23,8 +25,13 @@
 #include "esp_partition.h"
 #include "esp_console.h"
 #include "esp_chip_info.h"
+#include "csi_perf.h"
+#include "csi_task.h"
+#include "csi_diag.h"
 
 
+#define PERF_JSON_MAX_LEN   2048
+
 static const char *TAG = "system_cmd";
 
 /**
@@ -254,6 +261,156 @@ static void register_log()
     ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
 }
 
+static struct {
+    struct arg_lit *json;
+    struct arg_lit *reset;
+    struct arg_end *end;
+} perf_args;
+
+/**
+ * @brief  A function which implements perf command.
+ */
+static int perf_func(int argc, char **argv)
+{
+    if (arg_parse(argc, argv, (void **)&perf_args) != ESP_OK) {
+        arg_print_errors(stderr, perf_args.end, argv[0]);
+        return ESP_FAIL;
+    }
+
+    if (perf_args.json->count) {
+        char *buf = malloc(PERF_JSON_MAX_LEN);
+
+        if (!buf) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        csi_perf_json(buf, PERF_JSON_MAX_LEN);
+        printf("%s\n", buf);
+        free(buf);
+    } else {
+        csi_perf_print();
+    }
+
+    if (perf_args.reset->count) {
+        csi_perf_reset();
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief  Register perf command.
+ */
+static void register_perf()
+{
+    perf_args.json  = arg_lit0("j", "json", "Print the stages as one JSON line");
+    perf_args.reset = arg_lit0("r", "reset", "Clear the histograms after printing them");
+    perf_args.end   = arg_end(2);
+
+    const esp_console_cmd_t cmd = {
+        .command = "perf",
+        .help = "Latency of the CSI pipeline stages in us: count, drops, mean, p50, p90, p99, max",
+        .hint = NULL,
+        .func = &perf_func,
+        .argtable = &perf_args,
+    };
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+/**
+ * @brief  A function which implements tasks command.
+ */
+static int tasks_func(int argc, char **argv)
+{
+    csi_task_log_topology();
+
+    esp_err_t ret = csi_task_log_usage();
+
+    if (ret == ESP_ERR_NOT_SUPPORTED) {
+        printf("Enable CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS for the CPU share\n");
+    }
+
+    return ret;
+}
+
+/**
+ * @brief  Register tasks command.
+ */
+static void register_tasks()
+{
+    const esp_console_cmd_t cmd = {
+        .command = "tasks",
+        .help = "Priority and core of the pipeline stages, CPU share of every task since the previous call",
+        .hint = NULL,
+        .func = &tasks_func,
+    };
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+static struct {
+    struct arg_lit *json;
+    struct arg_lit *history;
+    struct arg_lit *sample;
+    struct arg_end *end;
+} diag_args;
+
+/**
+ * @brief  A function which implements diag command.
+ */
+static int diag_func(int argc, char **argv)
+{
+    if (arg_parse(argc, argv, (void **)&diag_args) != ESP_OK) {
+        arg_print_errors(stderr, diag_args.end, argv[0]);
+        return ESP_FAIL;
+    }
+
+    bool history = diag_args.history->count;
+
+    if (diag_args.sample->count) {
+        csi_diag_sample();
+    }
+
+    if (diag_args.json->count) {
+        size_t len = csi_diag_json_len(history);
+        char *buf = malloc(len);
+
+        if (!buf) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        csi_diag_json(buf, len, history);
+        printf("%s\n", buf);
+        free(buf);
+    } else {
+        csi_diag_print(history);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief  Register diag command.
+ */
+static void register_diag()
+{
+    diag_args.json    = arg_lit0("j", "json", "Print the diagnostics as one JSON line");
+    diag_args.history = arg_lit0("H", "history", "Also print every sample of the history ring");
+    diag_args.sample  = arg_lit0("s", "sample", "Take a sample first instead of showing the last periodic one");
+    diag_args.end     = arg_end(3);
+
+    const esp_console_cmd_t cmd = {
+        .command = "diag",
+        .help = "CPU share and stack high-water of every task, free, largest block, minimum and trend of each heap",
+        .hint = NULL,
+        .func = &diag_func,
+        .argtable = &diag_args,
+    };
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
 void cmd_register_system(void)
 {
     register_version();
@@ -261,4 +418,7 @@ void cmd_register_system(void)
     register_restart();
     register_reset();
     register_log();
+    register_perf();
+    register_tasks();
+    register_diag();
 }
\ No newline at end of file
@@ -15,11 +15,14 @@
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/param.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 #include "esp_err.h"
 #include "esp_console.h"
 
@@ -30,11 +33,24 @@
 #include "lwip/sockets.h"
 #include "ping/ping_sock.h"
 #include "hal/uart_ll.h"
-#include "mbedtls/base64.h"
 
 #include "led_strip.h"
 #include "esp_radar.h"
+#include "radar_window.h"
+#include "radar_detect.h"
+#include "motion_features.h"
+#include "csi_seqlock.h"
+#include "csi_frame_ring.h"
+#include "csi_output.h"
+#include "csi_codec.h"
+#include "csi_recorder.h"
+#include "csi_bench.h"
+#include "csi_perf.h"
 #include "csi_commands.h"
+#include "csi_task.h"
+#include "csi_diag.h"
+#include "csi_attr.h"
+#include "csi_mem.h"
 
 extern esp_ping_handle_t g_ping_handle;
 static led_strip_handle_t led_strip;
@@ -56,9 +72,25 @@ static led_strip_handle_t led_strip;
 #define CONFIG_SEND_DATA_FREQUENCY          100
 
 #define RADAR_EVALUATE_SERVER_PORT          3232
-#define RADAR_BUFF_MAX_LEN                  25
-
-static QueueHandle_t g_csi_info_queue    = NULL;
+#define RADAR_WINDOW_MAX_LEN                128
+#define CSI_FRAME_RING_LEN                  32
+#define CSI_FRAME_MAX_DATA_LEN              1024  /* Covers LLTF + HE-LTF + STBC-HE-LTF, longer frames are truncated */
+#define CSI_OUTPUT_RECORD_HEADER_MAX_LEN    256   /* CSV columns before the data column */
+#define CSI_OUTPUT_FLUSH_DEADLINE_MS        20    /* Longest a record waits to be batched with the next ones */
+#define CSI_OUTPUT_REPORT_INTERVAL_MS       10000
+#define CSI_FEATURES_RECORD_MAX_LEN         1024  /* One CSI_FEATURES line with 32 Doppler bins and 16 bands */
+#define CSI_DIAG_INTERVAL_MS                60000
+#define CSI_DIAG_HISTORY_LEN                60    /* One hour of heap trend */
+#define CSI_RECORD_NVS_NAMESPACE            "csi_rec"
+#define CSI_RECORD_DUMP_LINE_MAX_LEN        (32 + 4 * ((CSI_RECORDER_SECTOR_SIZE + 2) / 3))
+
+static csi_frame_ring_t g_csi_frame_ring = {0};
+static int64_t g_csi_frame_commit_us[CSI_FRAME_RING_LEN];    /* Commit time of each ring slot, same index */
+static CSI_MEM_BULK_BSS_ATTR csi_diag_sample_t s_diag_history[CSI_DIAG_HISTORY_LEN];
+static csi_perf_stage_t g_perf_csi_cb        = CSI_PERF_STAGE_NONE;
+static csi_perf_stage_t g_perf_frame_handoff = CSI_PERF_STAGE_NONE;
+static csi_perf_stage_t g_perf_format        = CSI_PERF_STAGE_NONE;
+static csi_perf_stage_t g_perf_radar_cb      = CSI_PERF_STAGE_NONE;
 static bool g_wifi_connect_status        = false;
 static uint32_t g_send_data_interval     = 1000 / CONFIG_SEND_DATA_FREQUENCY;
 static const char *TAG                   = "app_main";
@@ -72,6 +104,7 @@ static struct {
     struct arg_str *predict_move_threshold;
     struct arg_str *predict_move_sensitivity;
     struct arg_int *predict_buff_size;
+    struct arg_int *predict_window_size;
     struct arg_int *predict_outliers_number;
     struct arg_str *collect_taget;
     struct arg_int *collect_number;
@@ -80,6 +113,14 @@ static struct {
     struct arg_lit *csi_stop;
     struct arg_str *csi_output_type;
     struct arg_str *csi_output_format;
+    struct arg_str *csi_codec_mask;
+    struct arg_int *csi_codec_decimate;
+    struct arg_int *csi_codec_delta;
+    struct arg_str *csi_codec_encoding;
+    struct arg_int *csi_codec_lossless;
+    struct arg_int *csi_codec_key_interval;
+    struct arg_int *features_window;
+    struct arg_int *features_interval;
     struct arg_int *csi_scale_shift;
     struct arg_int *channel_filter;
     struct arg_int *send_data_interval;
@@ -92,36 +133,67 @@ static struct console_input_config {
     float predict_move_threshold;
     float predict_move_sensitivity;
     uint32_t predict_buff_size;
+    uint32_t predict_window_size;
     uint32_t predict_outliers_number;
     char collect_taget[16];
     uint32_t collect_number;
     char csi_output_type[16];
     char csi_output_format[16];
+    csi_codec_config_t codec_config;
+    bool codec_update;              /* Applied by csi_data_print_task(), under g_codec_lock */
+    motion_features_config_t features_config;
+    bool features_update;           /* Applied by csi_data_print_task(), under g_codec_lock */
 } g_console_input_config = {
     .predict_someone_threshold = 0,
     .predict_someone_sensitivity = 0.15,
     .predict_move_threshold    = 0.0003,
     .predict_move_sensitivity  = 0.20,
     .predict_buff_size         = 5,
+    .predict_window_size       = 25,
     .predict_outliers_number   = 2,
     .train_start               = false,
     .collect_taget             = "unknown",
     .csi_output_type           = "LLTF",
-    .csi_output_format         = "decimal"
+    .csi_output_format         = "decimal",
+    .codec_config              = CSI_CODEC_CONFIG_DEFAULT(),
+    .features_config           = MOTION_FEATURES_CONFIG_DEFAULT(),
 };
+static portMUX_TYPE g_codec_lock = portMUX_INITIALIZER_UNLOCKED;
 
 static TimerHandle_t g_collect_timer_handele = NULL;
 
-void wifi_csi_raw_cb(void *ctx, const wifi_csi_filtered_info_t *info)
+/* Kept in NVS, so a field install records again after a power cut */
+static struct {
+    bool autostart;
+    uint32_t csi_every;             /* Record every n-th CSI frame, 0 records radar results only */
+    bool restart;                   /* The codec of the recorder starts over, in csi_data_print_task() */
+} g_record = {
+    .csi_every = 1,
+};
+
+void CSI_HOT_ATTR wifi_csi_raw_cb(void *ctx, const wifi_csi_filtered_info_t *info)
 {
-    wifi_csi_filtered_info_t *q_data = malloc(sizeof(wifi_csi_filtered_info_t) + info->valid_len);
-    *q_data = *info;
-    memcpy(q_data->valid_data, info->valid_data, info->valid_len);
+    csi_bench_capture_frame(info);
+
+    if (!g_csi_frame_ring.pool) {
+        return;
+    }
+
+    int64_t start_us = csi_perf_begin();
+    wifi_csi_filtered_info_t *q_data = csi_frame_ring_acquire(&g_csi_frame_ring);
 
-    if (!g_csi_info_queue || xQueueSend(g_csi_info_queue, &q_data, 0) == pdFALSE) {
-        ESP_LOGW(TAG, "g_csi_info_queue full");
-        free(q_data);
+    /* Counted as an overrun, csi_data_print_task() reports it with the output back-pressure */
+    if (!q_data) {
+        csi_perf_drop(g_perf_frame_handoff);
+        return;
     }
+
+    *q_data = *info;
+    q_data->valid_len = MIN(info->valid_len, CSI_FRAME_MAX_DATA_LEN);
+    memcpy(q_data->valid_data, info->valid_data, q_data->valid_len);
+    g_csi_frame_commit_us[g_csi_frame_ring.head & (CSI_FRAME_RING_LEN - 1)] = esp_timer_get_time();
+    csi_frame_ring_commit(&g_csi_frame_ring);
+    csi_perf_end(g_perf_csi_cb, start_us);
 }
 
 static void collect_timercb(TimerHandle_t timer)
@@ -181,8 +253,27 @@ static int wifi_cmd_radar(int argc, char **argv)
         ESP_LOGI(TAG, "predict_someone_sensitivity: %f", g_console_input_config.predict_someone_sensitivity);
     }
 
+    /* Both index the radar windows, whose storage holds RADAR_WINDOW_MAX_LEN samples */
     if (radar_args.predict_buff_size->count) {
-        g_console_input_config.predict_buff_size = radar_args.predict_buff_size->ival[0];
+        int buff_size = radar_args.predict_buff_size->ival[0];
+
+        if (buff_size < 1 || buff_size > RADAR_WINDOW_MAX_LEN) {
+            ESP_LOGE(TAG, "Invalid predict buffer size: %d, in [1, %d]", buff_size, RADAR_WINDOW_MAX_LEN);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        g_console_input_config.predict_buff_size = buff_size;
+    }
+
+    if (radar_args.predict_window_size->count) {
+        int window_size = radar_args.predict_window_size->ival[0];
+
+        if (window_size < 1 || window_size > RADAR_WINDOW_MAX_LEN) {
+            ESP_LOGE(TAG, "Invalid predict window size: %d, in [1, %d]", window_size, RADAR_WINDOW_MAX_LEN);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        g_console_input_config.predict_window_size = window_size;
     }
 
     if (radar_args.predict_outliers_number->count) {
@@ -207,6 +298,86 @@ static int wifi_cmd_radar(int argc, char **argv)
         strcpy(g_console_input_config.csi_output_format, radar_args.csi_output_format->sval[0]);
     }
 
+    if (radar_args.csi_codec_mask->count || radar_args.csi_codec_decimate->count || radar_args.csi_codec_delta->count
+            || radar_args.csi_codec_encoding->count || radar_args.csi_codec_lossless->count
+            || radar_args.csi_codec_key_interval->count) {
+        csi_codec_config_t codec_config;
+
+        portENTER_CRITICAL(&g_codec_lock);
+        codec_config = g_console_input_config.codec_config;
+        portEXIT_CRITICAL(&g_codec_lock);
+
+        if (radar_args.csi_codec_mask->count
+                && csi_codec_parse_mask(radar_args.csi_codec_mask->sval[0], &codec_config) != ESP_OK) {
+            ESP_LOGE(TAG, "Invalid subcarrier mask: %s", radar_args.csi_codec_mask->sval[0]);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (radar_args.csi_codec_encoding->count
+                && csi_codec_parse_encoding(radar_args.csi_codec_encoding->sval[0], &codec_config.encoding) != ESP_OK) {
+            ESP_LOGE(TAG, "Invalid codec encoding: %s", radar_args.csi_codec_encoding->sval[0]);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (radar_args.csi_codec_decimate->count) {
+            codec_config.decimate = MIN(MAX(radar_args.csi_codec_decimate->ival[0], 1), 16);
+        }
+
+        if (radar_args.csi_codec_delta->count) {
+            codec_config.delta = radar_args.csi_codec_delta->ival[0];
+        }
+
+        if (radar_args.csi_codec_lossless->count) {
+            codec_config.lossless = radar_args.csi_codec_lossless->ival[0];
+        }
+
+        if (radar_args.csi_codec_key_interval->count) {
+            codec_config.key_interval = MIN(MAX(radar_args.csi_codec_key_interval->ival[0], 1), UINT16_MAX);
+        }
+
+        portENTER_CRITICAL(&g_codec_lock);
+        g_console_input_config.codec_config = codec_config;
+        g_console_input_config.codec_update = true;
+        portEXIT_CRITICAL(&g_codec_lock);
+
+        ESP_LOGI(TAG, "CSI codec: mask %s, decimate %u, delta %d, encoding %s, lossless %d, key interval %u",
+                 codec_config.mask_enable ? "on" : "all", codec_config.decimate, codec_config.delta,
+                 radar_args.csi_codec_encoding->count ? radar_args.csi_codec_encoding->sval[0] : "unchanged",
+                 codec_config.lossless, codec_config.key_interval);
+    }
+
+    if (radar_args.features_window->count || radar_args.features_interval->count) {
+        motion_features_config_t features_config;
+
+        portENTER_CRITICAL(&g_codec_lock);
+        features_config = g_console_input_config.features_config;
+        portEXIT_CRITICAL(&g_codec_lock);
+
+        if (radar_args.features_window->count) {
+            int window_len = radar_args.features_window->ival[0];
+
+            if (window_len < MOTION_FEATURES_WINDOW_MIN || window_len > FFT_MAX_N || (window_len & (window_len - 1))) {
+                ESP_LOGE(TAG, "Invalid feature window: %d, a power of two in [%d, %d]",
+                         window_len, MOTION_FEATURES_WINDOW_MIN, FFT_MAX_N);
+                return ESP_ERR_INVALID_ARG;
+            }
+
+            features_config.window_len = window_len;
+        }
+
+        if (radar_args.features_interval->count) {
+            features_config.interval = MIN(MAX(radar_args.features_interval->ival[0], 1), UINT16_MAX);
+        }
+
+        portENTER_CRITICAL(&g_codec_lock);
+        g_console_input_config.features_config = features_config;
+        g_console_input_config.features_update = true;
+        portEXIT_CRITICAL(&g_codec_lock);
+
+        ESP_LOGI(TAG, "Motion features: window %u frames, one vector every %u frames",
+                 features_config.window_len, features_config.interval);
+    }
+
     if (radar_args.csi_output_type->count) {
         esp_radar_config_t radar_config = {0};
         esp_radar_get_config(&radar_config);
@@ -305,7 +476,8 @@ void cmd_register_radar(void)
     radar_args.predict_someone_sensitivity  = arg_str0(NULL, "predict_someone_sensitivity", "<0 ~ 1.0>", "Configure the sensitivity for someone");
     radar_args.predict_move_threshold    = arg_str0(NULL, "predict_move_threshold", "<0 ~ 1.0>", "Configure the threshold for move");
     radar_args.predict_move_sensitivity  = arg_str0(NULL, "predict_move_sensitivity", "<0 ~ 1.0>", "Configure the sensitivity for move");
-    radar_args.predict_buff_size         = arg_int0(NULL, "predict_buff_size", "1 ~ 100", "Buffer size for filtering outliers");
+    radar_args.predict_buff_size         = arg_int0(NULL, "predict_buff_size", "<1 ~ 128>", "Buffer size for filtering outliers");
+    radar_args.predict_window_size       = arg_int0(NULL, "predict_window_size", "<1 ~ 128>", "Number of frames used for the trimmed mean and median");
     radar_args.predict_outliers_number   = arg_int0(NULL, "predict_outliers_number", "<1 ~ 100>", "The number of items in the buffer queue greater than the threshold");
 
     radar_args.collect_taget    = arg_str0(NULL, "collect_tagets", "<0 ~ 20>", "Type of CSI data collected");
@@ -315,7 +487,15 @@ void cmd_register_radar(void)
     radar_args.csi_start         = arg_lit0(NULL, "csi_start", "Start collecting CSI data from Wi-Fi");
     radar_args.csi_stop          = arg_lit0(NULL, "csi_stop", "Stop CSI data collection from Wi-Fi");
     radar_args.csi_output_type   = arg_str0(NULL, "csi_output_type", "<NULL, LLTF, HT-LTF, HE-LTF, STBC-HT-LTF, STBC-HE-LTF>", "Type of CSI data");
-    radar_args.csi_output_format = arg_str0(NULL, "csi_output_format", "<decimal, base64>", "Format of CSI data");
+    radar_args.csi_output_format = arg_str0(NULL, "csi_output_format", "<decimal, base64, compressed, features>", "Format of CSI data, features sends motion feature vectors instead");
+    radar_args.csi_codec_mask    = arg_str0(NULL, "csi_codec_mask", "<all, 0-25,38-63>", "Subcarriers sent in the compressed format");
+    radar_args.csi_codec_decimate = arg_int0(NULL, "csi_codec_decimate", "<1~16>", "Keep every n-th selected subcarrier in the compressed format");
+    radar_args.csi_codec_delta   = arg_int0(NULL, "csi_codec_delta", "<0 or 1>", "Send differences to the previous frame between key frames");
+    radar_args.csi_codec_encoding = arg_str0(NULL, "csi_codec_encoding", "<int8, packed, nibble>", "Encoding of the differences");
+    radar_args.csi_codec_lossless = arg_int0(NULL, "csi_codec_lossless", "<0 or 1>", "Escape nibble differences that do not fit instead of clamping them");
+    radar_args.csi_codec_key_interval = arg_int0(NULL, "csi_codec_key_interval", "<frames>", "Frames from one key frame to the next");
+    radar_args.features_window   = arg_int0(NULL, "features_window", "<8, 16, 32, 64>", "Frames of CIR tap history per Doppler spectrum in the features format");
+    radar_args.features_interval = arg_int0(NULL, "features_interval", "<frames>", "Frames from one feature vector to the next");
     radar_args.csi_scale_shift   = arg_int0(NULL, "scale_shift", "<0~15>", "manually left shift bits of the scale of the CSI data");
     radar_args.channel_filter    = arg_int0(NULL, "channel_filter", "<0 or 1>", "enable to turn on channel filter to smooth adjacent sub-carrier");
 
@@ -334,22 +514,495 @@ void cmd_register_radar(void)
     ESP_ERROR_CHECK(esp_console_cmd_register(&radar_cmd));
 }
 
+static void record_config_save(void)
+{
+    nvs_handle_t handle;
+
+    if (nvs_open(CSI_RECORD_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+
+    nvs_set_u8(handle, "autostart", g_record.autostart);
+    nvs_set_u32(handle, "csi_every", g_record.csi_every);
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+static void record_config_load(void)
+{
+    nvs_handle_t handle;
+    uint8_t autostart = 0;
+
+    if (nvs_open(CSI_RECORD_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+
+    if (nvs_get_u8(handle, "autostart", &autostart) == ESP_OK) {
+        g_record.autostart = autostart;
+    }
+
+    nvs_get_u32(handle, "csi_every", &g_record.csi_every);
+    nvs_close(handle);
+}
+
+/* One line per sector, base64 straight from the mapped flash, written at once so CSI output cannot split it */
+static bool record_dump_sector(const csi_recorder_sector_t *sector, void *arg)
+{
+    char *line = arg;
+    char *dst = line + sprintf(line, "CSI_REC,%u,%lu,", sector->session, (unsigned long)sector->seq);
+
+    dst = csi_output_put_base64(dst, sector->records, sector->len);
+    *dst++ = '\n';
+    fwrite(line, 1, dst - line, stdout);
+    fflush(stdout);
+
+    return true;
+}
+
+static struct {
+    struct arg_lit *start;
+    struct arg_lit *stop;
+    struct arg_lit *erase;
+    struct arg_lit *dump;
+    struct arg_int *csi_every;
+    struct arg_end *end;
+} record_args;
+
+static int wifi_cmd_record(int argc, char **argv)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (arg_parse(argc, argv, (void **) &record_args) != ESP_OK) {
+        arg_print_errors(stderr, record_args.end, argv[0]);
+        return ESP_FAIL;
+    }
+
+    if (record_args.csi_every->count) {
+        g_record.csi_every = MAX(record_args.csi_every->ival[0], 0);
+        record_config_save();
+    }
+
+    if (record_args.stop->count) {
+        ret = csi_recorder_stop();
+        g_record.autostart = false;
+        record_config_save();
+    }
+
+    if (record_args.erase->count && ret == ESP_OK) {
+        ret = csi_recorder_erase();
+    }
+
+    if (record_args.dump->count && ret == ESP_OK) {
+        char *line = malloc(CSI_RECORD_DUMP_LINE_MAX_LEN);
+
+        if (!line) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        ret = csi_recorder_read(record_dump_sector, line);
+        free(line);
+    }
+
+    if (record_args.start->count && ret == ESP_OK) {
+        g_record.restart = true;
+        ret = csi_recorder_start();
+        g_record.autostart = ret == ESP_OK;
+        record_config_save();
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "<%s> record", esp_err_to_name(ret));
+        return ret;
+    }
+
+    csi_recorder_stats_t stats;
+    csi_recorder_get_stats(&stats);
+
+    printf("recorder: %s, session %u, %lu of %lu sectors used, %lu passes, every %lu-th CSI frame\n",
+           stats.running ? "running" : "stopped", stats.session, (unsigned long)stats.used, (unsigned long)stats.sectors,
+           (unsigned long)(stats.sectors ? stats.seq / stats.sectors : 0), (unsigned long)g_record.csi_every);
+    printf("recorder: %lu records, %llu bytes, %lu dropped, %lu page writes, %lu erases, %lu errors\n",
+           (unsigned long)stats.records, stats.bytes, (unsigned long)stats.dropped, (unsigned long)stats.page_writes,
+           (unsigned long)stats.erases, (unsigned long)stats.errors);
+
+    return ESP_OK;
+}
+
+void cmd_register_record(void)
+{
+    record_args.start     = arg_lit0(NULL, "start", "Start recording into the csi_rec partition, also after every boot");
+    record_args.stop      = arg_lit0(NULL, "stop", "Stop recording and write the buffered records to flash");
+    record_args.erase     = arg_lit0(NULL, "erase", "Erase every record, only while stopped");
+    record_args.dump      = arg_lit0(NULL, "dump", "Print the records as CSI_REC,session,sector,base64 lines, only while stopped");
+    record_args.csi_every = arg_int0(NULL, "csi_every", "<n>", "Record every n-th CSI frame, 0 records the radar results only");
+    record_args.end       = arg_end(5);
+
+    const esp_console_cmd_t record_cmd = {
+        .command = "record",
+        .help = "Record CSI and radar results into flash, without arguments print the recorder status",
+        .hint = NULL,
+        .func = &wifi_cmd_record,
+        .argtable = &record_args
+    };
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&record_cmd));
+}
+
+static struct {
+    struct arg_lit *start;
+    struct arg_lit *stop;
+    struct arg_int *rate;
+    struct arg_int *burst;
+    struct arg_int *subcarriers;
+    struct arg_str *ltf;
+    struct arg_lit *replay;
+    struct arg_int *capture;
+    struct arg_lit *console;
+    struct arg_int *duration;
+    struct arg_int *interval;
+    struct arg_end *end;
+} bench_args;
+
+static int wifi_cmd_bench(int argc, char **argv)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (arg_parse(argc, argv, (void **) &bench_args) != ESP_OK) {
+        arg_print_errors(stderr, bench_args.end, argv[0]);
+        return ESP_FAIL;
+    }
+
+    if (bench_args.stop->count) {
+        csi_bench_stop();
+    }
+
+    if (bench_args.capture->count) {
+        ret = csi_bench_capture(bench_args.capture->ival[0]);
+    }
+
+    if (bench_args.start->count && ret == ESP_OK) {
+        csi_bench_config_t config = CSI_BENCH_CONFIG_DEFAULT();
+
+        if (bench_args.ltf->count && csi_bench_parse_ltf(bench_args.ltf->sval[0], &config.ltf) != ESP_OK) {
+            ESP_LOGE(TAG, "Invalid LTF type: %s", bench_args.ltf->sval[0]);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (bench_args.rate->count) {
+            config.rate = MAX(bench_args.rate->ival[0], 0);
+        }
+
+        if (bench_args.burst->count) {
+            config.burst = MIN(MAX(bench_args.burst->ival[0], 0), UINT16_MAX);
+        }
+
+        if (bench_args.subcarriers->count) {
+            config.subcarriers = MIN(MAX(bench_args.subcarriers->ival[0], 0), UINT16_MAX);
+        }
+
+        if (bench_args.duration->count) {
+            config.duration_ms = MAX(bench_args.duration->ival[0], 0);
+        }
+
+        if (bench_args.interval->count) {
+            config.report_interval_ms = MAX(bench_args.interval->ival[0], 0);
+        }
+
+        config.replay = bench_args.replay->count;
+        config.frame_cb = bench_args.console->count ? wifi_csi_raw_cb : NULL;
+        ret = csi_bench_start(&config);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "<%s> csi_bench", esp_err_to_name(ret));
+        return ret;
+    }
+
+    csi_bench_stats_t stats;
+    csi_bench_get_stats(&stats);
+
+    printf("csi_bench: %s, %lu frames offered, %lu accepted, %lu dropped, %lu radar results, %u frames captured\n",
+           csi_bench_is_running() ? "running" : "stopped", (unsigned long)stats.offered, (unsigned long)stats.pushed,
+           (unsigned long)stats.dropped, (unsigned long)stats.results, csi_bench_captured());
+
+    return ESP_OK;
+}
+
+void cmd_register_bench(void)
+{
+    bench_args.start       = arg_lit0(NULL, "start", "Push frames into the radar decoder until the duration ends");
+    bench_args.stop        = arg_lit0(NULL, "stop", "End the run, it logs its totals");
+    bench_args.rate        = arg_int0(NULL, "rate", "<frames/s>", "Frames offered per second, 100 by default");
+    bench_args.burst       = arg_int0(NULL, "burst", "<frames>", "Frames pushed back to back, 1 by default");
+    bench_args.subcarriers = arg_int0(NULL, "subcarriers", "<1~512>", "Subcarriers of the synthetic frames, 64 by default");
+    bench_args.ltf         = arg_str0(NULL, "ltf", "<LLTF, HT-LTF, HE-LTF>", "Field that holds the synthetic CSI");
+    bench_args.replay      = arg_lit0(NULL, "replay", "Loop the captured frames instead of synthetic ones");
+    bench_args.capture     = arg_int0(NULL, "capture", "<1~32>", "Keep the next live CSI frames for --replay");
+    bench_args.console     = arg_lit0(NULL, "console", "Also send every frame through the CSI output of the console");
+    bench_args.duration    = arg_int0(NULL, "duration", "<ms>", "Length of the run, 0 until --stop, 10000 by default");
+    bench_args.interval    = arg_int0(NULL, "interval", "<ms>", "Time between two reports, 1000 by default");
+    bench_args.end         = arg_end(11);
+
+    const esp_console_cmd_t bench_cmd = {
+        .command = "csi_bench",
+        .help = "Load the CSI decoder with synthetic or replayed frames, without arguments print the last run",
+        .hint = NULL,
+        .func = &wifi_cmd_bench,
+        .argtable = &bench_args
+    };
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&bench_cmd));
+}
+
+static char *csi_output_put_str(char *dst, const char *str)
+{
+    size_t len = strlen(str);
+
+    memcpy(dst, str, len);
+    return dst + len;
+}
+
+static char *csi_output_put_mac(char *dst, const uint8_t *mac)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    for (int i = 0; i < 6; i++) {
+        if (i) {
+            *dst++ = ':';
+        }
+        *dst++ = hex[mac[i] >> 4];
+        *dst++ = hex[mac[i] & 0xf];
+    }
+
+    return dst;
+}
+
+/* Append ",value" for every value, the record layout is the CSV header in csi_data_print_task() */
+static char *csi_output_put_fields(char *dst, const int32_t *values, size_t num)
+{
+    for (size_t i = 0; i < num; i++) {
+        *dst++ = ',';
+        dst = csi_output_put_int(dst, values[i]);
+    }
+
+    return dst;
+}
+
+/* Encoder state and scratch of the compressed format, csi_data_print_task() only */
+static csi_codec_t s_csi_codec;
+static uint8_t s_csi_codec_buf[CSI_CODEC_KEY_HEADER_LEN + 2 * CSI_FRAME_MAX_DATA_LEN];
+
+/* Encoder of the recorded CSI, its own so the format on the console does not matter */
+static csi_codec_t s_record_codec;
+
+/* Latest radar decision, written by wifi_radar_handle() and sent along with the feature vectors */
+typedef struct {
+    float waveform_wander;
+    float waveform_jitter;
+    bool room_status;
+    bool human_status;
+} radar_summary_t;
+
+static csi_seqlock_t g_radar_summary_lock = CSI_SEQLOCK_INIT();
+static radar_summary_t g_radar_summary;
+
+/* Feature state of the features format, csi_data_print_task() only */
+static motion_features_t s_motion_features;
+static Complex s_motion_features_storage[MOTION_FEATURES_STORAGE_LEN(FFT_MAX_N, MOTION_FEATURES_TAP_MAX)];
+
+static char *csi_output_put_float_array(char *dst, const float *values, size_t num)
+{
+    *dst++ = '"';
+    *dst++ = '[';
+
+    for (size_t i = 0; i < num; i++) {
+        dst += sprintf(dst, i ? ",%.4g" : "%.4g", values[i]);
+    }
+
+    *dst++ = ']';
+    *dst++ = '"';
+    return dst;
+}
+
+/* One CSI_FEATURES line per vector stands for features_interval CSI_DATA lines */
+static void csi_features_frame(const wifi_csi_filtered_info_t *info)
+{
+    motion_features_vector_t vector;
+
+    if (g_console_input_config.features_update) {
+        motion_features_config_t features_config;
+
+        portENTER_CRITICAL(&g_codec_lock);
+        features_config = g_console_input_config.features_config;
+        g_console_input_config.features_update = false;
+        portEXIT_CRITICAL(&g_codec_lock);
+
+        motion_features_init(&s_motion_features, s_motion_features_storage, &features_config);
+    }
+
+    if (!motion_features_push(&s_motion_features, info->valid_data, info->valid_len, &vector)) {
+        return;
+    }
+
+    if (!vector.seq) {
+        static const char header[] = "type,sequence,timestamp,taget_seq,target,mac,rssi,frames,motion_energy,phase_diff_mean,phase_diff_variance,waveform_wander,waveform_jitter,someone_status,move_status,doppler,amp_variance\n";
+        char *dst = csi_output_begin(sizeof(header) - 1);
+
+        if (dst) {
+            memcpy(dst, header, sizeof(header) - 1);
+            csi_output_end(sizeof(header) - 1);
+        }
+    }
+
+    radar_summary_t radar = {0};
+    csi_seqlock_read(&g_radar_summary_lock, &radar, &g_radar_summary, sizeof(radar), NULL);
+
+    char *begin = csi_output_begin(CSI_FEATURES_RECORD_MAX_LEN);
+
+    if (!begin) {
+        csi_perf_drop(g_perf_format);
+        return;
+    }
+
+    char *dst = csi_output_put_str(begin, "CSI_FEATURES,");
+    dst = csi_output_put_uint(dst, vector.seq);
+    *dst++ = ',';
+    dst = csi_output_put_uint(dst, esp_log_timestamp());
+    *dst++ = ',';
+    dst = csi_output_put_uint(dst, g_console_input_config.collect_number);
+    *dst++ = ',';
+    dst = csi_output_put_str(dst, g_console_input_config.collect_taget);
+    *dst++ = ',';
+    dst = csi_output_put_mac(dst, info->mac);
+    *dst++ = ',';
+    dst = csi_output_put_int(dst, info->rx_ctrl_info.rssi);
+    *dst++ = ',';
+    dst = csi_output_put_uint(dst, vector.frames);
+    dst += sprintf(dst, ",%.4g,%.4f,%.4f,%.6f,%.6f,%d,%d,", vector.motion_energy, vector.phase_diff_mean,
+                   vector.phase_diff_variance, radar.waveform_wander, radar.waveform_jitter,
+                   radar.room_status, radar.human_status);
+    dst = csi_output_put_float_array(dst, vector.doppler, vector.doppler_num);
+    *dst++ = ',';
+    dst = csi_output_put_float_array(dst, vector.amp_variance, vector.band_num);
+    *dst++ = '\n';
+    csi_output_end(dst - begin);
+}
+
+static void csi_record_frame(const wifi_csi_filtered_info_t *info)
+{
+    static uint32_t s_skipped = 0;
+    bool first_of_type = false;
+
+    if (!csi_recorder_is_running() || !g_record.csi_every || ++s_skipped < g_record.csi_every) {
+        return;
+    }
+
+    s_skipped = 0;
+
+    if (g_record.restart) {
+        csi_codec_config_t codec_config;
+
+        portENTER_CRITICAL(&g_codec_lock);
+        codec_config = g_console_input_config.codec_config;
+        portEXIT_CRITICAL(&g_codec_lock);
+
+        csi_codec_init(&s_record_codec, &codec_config);
+        g_record.restart = false;
+    }
+
+    csi_recorder_csi_t *record = csi_recorder_begin(CSI_RECORDER_TYPE_CSI,
+                                                    sizeof(*record) + csi_codec_max_len(info->valid_len), &first_of_type);
+
+    if (!record) {
+        csi_codec_force_key(&s_record_codec);
+        return;
+    }
+
+    /* Every sector starts with a key frame, it decodes on its own once the ring overwrote the one before */
+    if (first_of_type) {
+        csi_codec_force_key(&s_record_codec);
+    }
+
+    const esp_radar_rx_ctrl_info_t *rx_ctrl = &info->rx_ctrl_info;
+    memcpy(record->mac, info->mac, sizeof(record->mac));
+    record->rssi = rx_ctrl->rssi;
+    record->noise_floor = rx_ctrl->noise_floor;
+    record->rate = rx_ctrl->rate;
+    record->channel = rx_ctrl->channel;
+    record->secondary_channel = rx_ctrl->secondary_channel;
+    record->agc_gain = rx_ctrl->agc_gain;
+    record->rx_timestamp = rx_ctrl->timestamp;
+
+    csi_recorder_end(sizeof(*record) + csi_codec_encode(&s_record_codec, info->valid_data, info->valid_len, record->data));
+}
+
+static void csi_output_report(void)
+{
+    static uint32_t s_ring_overruns = 0;
+    csi_output_stats_t stats;
+    csi_frame_ring_stats_t ring_stats;
+
+    csi_output_get_stats(&stats, true);
+    csi_frame_ring_get_stats(&g_csi_frame_ring, &ring_stats);
+    uint32_t overruns = ring_stats.overruns - s_ring_overruns;
+    s_ring_overruns = ring_stats.overruns;
+
+    if (stats.stalls || stats.dropped || overruns) {
+        ESP_LOGW(TAG, "CSI output back-pressure: %u records in %u writes, waited %u times for %u ms, "
+                 "dropped %u, frame ring overruns %u, longest write %u us",
+                 stats.records, stats.writes, stats.stalls, stats.stall_ms, stats.dropped, overruns, stats.write_max_us);
+    } else {
+        ESP_LOGD(TAG, "CSI output: %u records in %u writes, %llu bytes", stats.records, stats.writes, stats.bytes);
+    }
+
+    csi_codec_stats_t codec_stats;
+    csi_codec_get_stats(&s_csi_codec, &codec_stats, true);
+
+    if (codec_stats.records) {
+        ESP_LOGI(TAG, "CSI codec: %u records, %u keys, %llu -> %llu bytes (%.1f%%), %u clamped",
+                 codec_stats.records, codec_stats.keys, codec_stats.input_bytes, codec_stats.output_bytes,
+                 100.0 * codec_stats.output_bytes / MAX(codec_stats.input_bytes, 1), codec_stats.clamped);
+    }
+}
+
 static void csi_data_print_task(void *arg)
 {
     wifi_csi_filtered_info_t *info = NULL;
-    char *buffer = malloc(8 * 1024);
     static uint32_t count = 0;
+    TickType_t report_tick = xTaskGetTickCount();
 
-    while (xQueueReceive(g_csi_info_queue, &info, portMAX_DELAY)) {
-        size_t len = 0;
+    ESP_ERROR_CHECK(csi_codec_init(&s_csi_codec, &g_console_input_config.codec_config));
+    ESP_ERROR_CHECK(motion_features_init(&s_motion_features, s_motion_features_storage,
+                                         &g_console_input_config.features_config));
+
+    while (1) {
+        info = csi_frame_ring_receive(&g_csi_frame_ring, MIN(csi_output_poll(), pdMS_TO_TICKS(CSI_OUTPUT_REPORT_INTERVAL_MS)));
+
+        if (xTaskGetTickCount() - report_tick >= pdMS_TO_TICKS(CSI_OUTPUT_REPORT_INTERVAL_MS)) {
+            csi_output_report();
+            report_tick = xTaskGetTickCount();
+        }
+
+        if (!info) {
+            continue;
+        }
+
+        int64_t start_us = csi_perf_begin();
+        csi_perf_record(g_perf_frame_handoff, start_us - g_csi_frame_commit_us[g_csi_frame_ring.tail & (CSI_FRAME_RING_LEN - 1)]);
         esp_radar_rx_ctrl_info_t *rx_ctrl = &info->rx_ctrl_info;
+        bool features = !strcasecmp(g_console_input_config.csi_output_format, "features");
+
+        if (!count && !features) {
+            static const char header[] = "type,sequence,timestamp,taget_seq,target,mac,rssi,rate,sig_mode,mcs,bandwidth,smoothing,not_sounding,aggregation,stbc,fec_coding,sgi,noise_floor,ampdu_cnt,channel,secondary_channel,local_timestamp,ant,sig_len,rx_state,agc_gain,fft_gain,len,first_word,data\n";
+            char *dst = csi_output_begin(sizeof(header) - 1);
 
-        if (!count) {
-            ESP_LOGI(TAG, "================ CSI RECV ================");
-            len += sprintf(buffer + len, "type,sequence,timestamp,taget_seq,target,mac,rssi,rate,sig_mode,mcs,bandwidth,smoothing,not_sounding,aggregation,stbc,fec_coding,sgi,noise_floor,ampdu_cnt,channel,secondary_channel,local_timestamp,ant,sig_len,rx_state,agc_gain,fft_gain,len,first_word,data\n");
+            if (dst) {
+                memcpy(dst, header, sizeof(header) - 1);
+                csi_output_end(sizeof(header) - 1);
+            }
         }
+
         uint16_t valid_len = info->valid_len;
-        ESP_LOGI(TAG, "info->valid_len1: %d", info->valid_len);
         if (!strcasecmp(g_console_input_config.csi_output_type, "LLTF")) {
             info->valid_len = info->valid_lltf_len;
         } else if (!strcasecmp(g_console_input_config.csi_output_type, "HT-LTF")) {
@@ -363,96 +1016,136 @@ static void csi_data_print_task(void *arg)
             info->valid_len = info->valid_he_ltf_len + info->valid_stbc_he_ltf_len;
 #endif
         }
-        ESP_LOGI(TAG, "info->valid_len: %d", info->valid_len);
         if (info->valid_len == 0) {
             info->valid_len = valid_len;
 
         }
-        len += sprintf(buffer + len, "CSI_DATA,%d,%u,%u,%s," MACSTR ",%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%u,%d,%d,%d,%d,%d,%d,%d,",
-                       count++, esp_log_timestamp(), g_console_input_config.collect_number, g_console_input_config.collect_taget,
-                       MAC2STR(info->mac), rx_ctrl->rssi, rx_ctrl->rate, rx_ctrl->signal_mode,
-                       rx_ctrl->mcs, rx_ctrl->cwb, 0, 0,
-                       0, rx_ctrl->stbc, 0, 0,
-                       rx_ctrl->noise_floor, 0, rx_ctrl->channel, rx_ctrl->secondary_channel,
-                       rx_ctrl->timestamp, 0, 0, 0, rx_ctrl->agc_gain, rx_ctrl->fft_gain, info->valid_len, 0);
+        info->valid_len = MIN(info->valid_len, valid_len);
+        csi_record_frame(info);
+
+        if (features) {
+            csi_features_frame(info);
+            csi_frame_ring_release(&g_csi_frame_ring);
+            csi_perf_end(g_perf_format, start_us);
+            continue;
+        }
 
-        if (!strcasecmp(g_console_input_config.csi_output_format, "base64")) {
-            size_t size = 0;
-            mbedtls_base64_encode((uint8_t *)buffer + len, sizeof(buffer) - len, &size, (uint8_t *)info->valid_data, info->valid_len);
-            len += size;
-            len += sprintf(buffer + len, "\n");
-        } else {
-            len += sprintf(buffer + len, "\"[%d", info->valid_data[0]);
+        bool base64 = !strcasecmp(g_console_input_config.csi_output_format, "base64");
+        bool compressed = !strcasecmp(g_console_input_config.csi_output_format, "compressed");
+        size_t data_max_len = base64 ? 4 * ((info->valid_len + 2) / 3) : 5 * info->valid_len + 4;
+        size_t codec_len = 0;
+
+        if (compressed) {
+            if (g_console_input_config.codec_update) {
+                csi_codec_config_t codec_config;
 
-            for (int i = 1; i < info->valid_len; i++) {
-                len += sprintf(buffer + len, ",%d", info->valid_data[i]);
+                portENTER_CRITICAL(&g_codec_lock);
+                codec_config = g_console_input_config.codec_config;
+                g_console_input_config.codec_update = false;
+                portEXIT_CRITICAL(&g_codec_lock);
+
+                csi_codec_init(&s_csi_codec, &codec_config);
             }
 
-            len += sprintf(buffer + len, "]\"\n");
+            codec_len = csi_codec_encode(&s_csi_codec, info->valid_data, info->valid_len, s_csi_codec_buf);
+            data_max_len = 1 + 4 * ((codec_len + 2) / 3);
         }
 
-        printf("%s", buffer);
-        free(info);
+        char *begin = csi_output_begin(CSI_OUTPUT_RECORD_HEADER_MAX_LEN + data_max_len + 1);
+
+        if (!begin) {
+            /* The decoder misses this record, the next one must not depend on it */
+            if (compressed) {
+                csi_codec_force_key(&s_csi_codec);
+            }
+            csi_perf_drop(g_perf_format);
+            count++;
+            csi_frame_ring_release(&g_csi_frame_ring);
+            continue;
+        }
+
+        const int32_t rx_fields[] = {
+            rx_ctrl->rssi, rx_ctrl->rate, rx_ctrl->signal_mode, rx_ctrl->mcs, rx_ctrl->cwb, 0, 0,
+            0, rx_ctrl->stbc, 0, 0, rx_ctrl->noise_floor, 0, rx_ctrl->channel, rx_ctrl->secondary_channel,
+        };
+        const int32_t tail_fields[] = {
+            0, 0, 0, rx_ctrl->agc_gain, rx_ctrl->fft_gain, info->valid_len, 0,
+        };
+
+        char *dst = csi_output_put_str(begin, "CSI_DATA,");
+        dst = csi_output_put_uint(dst, count++);
+        *dst++ = ',';
+        dst = csi_output_put_uint(dst, esp_log_timestamp());
+        *dst++ = ',';
+        dst = csi_output_put_uint(dst, g_console_input_config.collect_number);
+        *dst++ = ',';
+        dst = csi_output_put_str(dst, g_console_input_config.collect_taget);
+        *dst++ = ',';
+        dst = csi_output_put_mac(dst, info->mac);
+        dst = csi_output_put_fields(dst, rx_fields, sizeof(rx_fields) / sizeof(rx_fields[0]));
+        *dst++ = ',';
+        dst = csi_output_put_uint(dst, rx_ctrl->timestamp);
+        dst = csi_output_put_fields(dst, tail_fields, sizeof(tail_fields) / sizeof(tail_fields[0]));
+        *dst++ = ',';
+
+        if (compressed) {
+            /* '~' is not in the base64 alphabet, so the tool tells the two formats apart */
+            *dst++ = '~';
+            dst = csi_output_put_base64(dst, s_csi_codec_buf, codec_len);
+        } else if (base64) {
+            dst = csi_output_put_base64(dst, info->valid_data, info->valid_len);
+        } else {
+            dst = csi_output_put_int8_array(dst, info->valid_data, info->valid_len);
+        }
+
+        *dst++ = '\n';
+        csi_output_end(dst - begin);
+        csi_frame_ring_release(&g_csi_frame_ring);
+        csi_perf_end(g_perf_format, start_us);
     }
 
-    free(buffer);
     vTaskDelete(NULL);
 }
 
-static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
+static void wifi_radar_handle(void *ctx, const wifi_radar_info_t *info)
 {
-    static float *s_buff_wander  = NULL;
-    static float *s_buff_jitter  = NULL;
-    static uint32_t s_buff_count = 0;
-    uint32_t buff_max_size       = g_console_input_config.predict_buff_size;
-    uint32_t buff_outliers_num   = g_console_input_config.predict_outliers_number;
-    uint32_t someone_count       = 0;
-    uint32_t move_count          = 0;
-    bool room_status             = false;
-    bool human_status            = false;
+    static radar_window_t s_wander_win = {0};
+    static radar_window_t s_jitter_win = {0};
+    static float s_wander_storage[RADAR_WINDOW_STORAGE_LEN(RADAR_WINDOW_MAX_LEN)];
+    static float s_jitter_storage[RADAR_WINDOW_STORAGE_LEN(RADAR_WINDOW_MAX_LEN)];
+    radar_detect_result_t result = {0};
+    const radar_detect_config_t detect_config = {
+        .vote_len           = g_console_input_config.predict_buff_size,
+        .move_votes         = g_console_input_config.predict_outliers_number,
+        .wander_threshold   = g_console_input_config.predict_someone_threshold,
+        .wander_sensitivity = g_console_input_config.predict_someone_sensitivity,
+        .jitter_threshold   = g_console_input_config.predict_move_threshold,
+        .jitter_sensitivity = g_console_input_config.predict_move_sensitivity,
+    };
 
-    if (!s_buff_wander) {
-        s_buff_wander = calloc(RADAR_BUFF_MAX_LEN, sizeof(float));
+    if (!s_wander_win.capacity) {
+        radar_window_init(&s_wander_win, s_wander_storage, RADAR_WINDOW_MAX_LEN, g_console_input_config.predict_window_size);
+        radar_window_init(&s_jitter_win, s_jitter_storage, RADAR_WINDOW_MAX_LEN, g_console_input_config.predict_window_size);
     }
 
-    if (!s_buff_jitter) {
-        s_buff_jitter = calloc(RADAR_BUFF_MAX_LEN, sizeof(float));
+    /* The console only records the requested length, apply it here on the radar task */
+    if (s_wander_win.size != g_console_input_config.predict_window_size) {
+        radar_window_set_size(&s_wander_win, g_console_input_config.predict_window_size);
+        radar_window_set_size(&s_jitter_win, g_console_input_config.predict_window_size);
     }
 
-    s_buff_wander[s_buff_count % RADAR_BUFF_MAX_LEN] = info->waveform_wander;
-    s_buff_jitter[s_buff_count % RADAR_BUFF_MAX_LEN] = info->waveform_jitter;
-    s_buff_count++;
-
-    if (s_buff_count < buff_max_size) {
+    if (!radar_detect_update(&detect_config, &s_wander_win, &s_jitter_win,
+                             info->waveform_wander, info->waveform_jitter, &result)) {
         return;
     }
 
-    extern float trimmean(const float * array, size_t len, float percent);
-    extern float median(const float * a, size_t len);
-
-    float wander_average = trimmean(s_buff_wander, RADAR_BUFF_MAX_LEN, 0.5);
-    float jitter_midean = median(s_buff_jitter, RADAR_BUFF_MAX_LEN);
-
-    for (int i = 0; i < buff_max_size; i++) {
-        uint32_t index = (s_buff_count - 1 - i) % RADAR_BUFF_MAX_LEN;
-
-        if ((wander_average * g_console_input_config.predict_someone_sensitivity > g_console_input_config.predict_someone_threshold)) {
-            someone_count++;
-        }
-
-        if (s_buff_jitter[index] * g_console_input_config.predict_move_sensitivity > g_console_input_config.predict_move_threshold
-                || (s_buff_jitter[index] * g_console_input_config.predict_move_sensitivity > jitter_midean && s_buff_jitter[index] > 0.0002)) {
-            move_count++;
-        }
-    }
-
-    if (someone_count >= 1) {
-        room_status = true;
-    }
-
-    if (move_count >= buff_outliers_num) {
-        human_status = true;
-    }
+    const radar_summary_t summary = {
+        .waveform_wander = info->waveform_wander,
+        .waveform_jitter = info->waveform_jitter,
+        .room_status     = result.room_status,
+        .human_status    = result.human_status,
+    };
+    csi_seqlock_write(&g_radar_summary_lock, &g_radar_summary, &summary, sizeof(summary));
 
     static uint32_t s_count = 0;
 
@@ -489,11 +1182,23 @@ static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
 
     printf("RADAR_DADA,%d,%s,%.6f,%.6f,%.6f,%d,%.6f,%.6f,%.6f,%d\n",
            s_count++, timestamp_str,
-           info->waveform_wander, wander_average, g_console_input_config.predict_someone_threshold / g_console_input_config.predict_someone_sensitivity, room_status,
-           info->waveform_jitter, jitter_midean, jitter_midean / g_console_input_config.predict_move_sensitivity, human_status);
+           info->waveform_wander, result.wander_average, g_console_input_config.predict_someone_threshold / g_console_input_config.predict_someone_sensitivity, result.room_status,
+           info->waveform_jitter, result.jitter_median, result.jitter_median / g_console_input_config.predict_move_sensitivity, result.human_status);
+
+    csi_recorder_radar_t *record = csi_recorder_begin(CSI_RECORDER_TYPE_RADAR, sizeof(*record), NULL);
+
+    if (record) {
+        record->waveform_wander = info->waveform_wander;
+        record->wander_average  = result.wander_average;
+        record->waveform_jitter = info->waveform_jitter;
+        record->jitter_median   = result.jitter_median;
+        record->room_status     = result.room_status;
+        record->human_status    = result.human_status;
+        csi_recorder_end(sizeof(*record));
+    }
 
-    if (room_status) {
-        if (human_status) {
+    if (result.room_status) {
+        if (result.human_status) {
             led_strip_set_pixel(led_strip, 0, 0, 255, 0);
             ESP_LOGI(TAG, "Someone moved");
             s_last_move_time = esp_log_timestamp();
@@ -504,7 +1209,7 @@ static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
 
         s_last_someone_time = esp_log_timestamp();
     } else if (esp_log_timestamp() - s_last_someone_time > 3 * 1000) {
-        if (human_status) {
+        if (result.human_status) {
             s_last_move_time = esp_log_timestamp();
             led_strip_set_pixel(led_strip, 0, 255, 0, 0);
         } else if (esp_log_timestamp() - s_last_move_time > 3 * 1000) {
@@ -514,6 +1219,15 @@ static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
     led_strip_refresh(led_strip);
 }
 
+static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
+{
+    int64_t start_us = csi_perf_begin();
+
+    csi_bench_radar_result();
+    wifi_radar_handle(ctx, info);
+    csi_perf_end(g_perf_radar_cb, start_us);
+}
+
 static void trigger_router_send_data_task(void *arg)
 {
     esp_radar_config_t radar_config = {0};
@@ -611,7 +1325,8 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
     if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         g_wifi_connect_status = true;
 
-        xTaskCreate(trigger_router_send_data_task, "trigger_router_send_data", 4 * 1024, NULL, 5, NULL);
+        csi_task_create(trigger_router_send_data_task, "trigger_router_send_data", 4 * 1024, NULL,
+                        CSI_TASK_STAGE_LINK, NULL);
 
 #ifdef RECV_ESPNOW_CSI
         ESP_ERROR_CHECK(esp_wifi_set_promiscuous(false));
@@ -722,16 +1437,64 @@ void app_main(void)
     cmd_register_wifi_config();
     cmd_register_wifi_scan();
     cmd_register_radar();
+    cmd_register_record();
+    cmd_register_bench();
     ESP_ERROR_CHECK(esp_console_start_repl(repl));
 
+    /**
+     * @brief Preallocate the CSI frames handed from wifi_csi_raw_cb to the printing task
+     */
+    ESP_ERROR_CHECK(csi_frame_ring_init(&g_csi_frame_ring, sizeof(wifi_csi_filtered_info_t) + CSI_FRAME_MAX_DATA_LEN,
+                                        CSI_FRAME_RING_LEN));
+
+    /**
+     * @brief Latency probes, shown by the perf command
+     */
+    g_perf_csi_cb        = csi_perf_register("csi_cb");
+    g_perf_frame_handoff = csi_perf_register("frame_handoff");
+    g_perf_format        = csi_perf_register("format");
+    g_perf_radar_cb      = csi_perf_register("radar_cb");
+
+    /**
+     * @brief Task CPU, stack high-water and heap fragmentation history, shown by the diag command
+     */
+    csi_diag_config_t diag_config = CSI_DIAG_CONFIG_DEFAULT();
+    diag_config.interval_ms = CSI_DIAG_INTERVAL_MS;
+    diag_config.history_len = CSI_DIAG_HISTORY_LEN;
+    ESP_ERROR_CHECK(csi_diag_init(&diag_config, s_diag_history));
+
+    /**
+     * @brief Batch the formatted CSI records into few large console writes
+     */
+    csi_output_config_t output_config = CSI_OUTPUT_CONFIG_DEFAULT();
+    output_config.flush_deadline_ms = CSI_OUTPUT_FLUSH_DEADLINE_MS;
+    ESP_ERROR_CHECK(csi_output_init(&output_config));
+
+    /**
+     * @brief Record into the csi_rec partition, resumed after a reboot if it was recording
+     */
+    csi_recorder_config_t recorder_config = CSI_RECORDER_CONFIG_DEFAULT();
+    record_config_load();
+
+    if (csi_recorder_init(&recorder_config) == ESP_OK && g_record.autostart) {
+        g_record.restart = true;
+        csi_recorder_start();
+    }
+
     /**
      * @brief Start Wi-Fi radar
      */
     esp_radar_start();
 
+#if CONFIG_CSI_MEM_LOG_MAP
+    csi_mem_note("csi_diag history", s_diag_history, sizeof(s_diag_history));
+    csi_mem_note("motion_features", s_motion_features_storage, sizeof(s_motion_features_storage));
+    csi_mem_note("wifi_csi_raw_cb", wifi_csi_raw_cb, 0);
+    csi_mem_log_map();
+#endif
+
     /**
      * @brief Initialize CSI serial port printing task, Use tasks to avoid blocking wifi_csi_raw_cb
      */
-    g_csi_info_queue = xQueueCreate(64, sizeof(void *));
-    xTaskCreate(csi_data_print_task, "csi_data_print", 4 * 1024, NULL, 0, NULL);
+    ESP_ERROR_CHECK(csi_task_create(csi_data_print_task, "csi_data_print", 6 * 1024, NULL, CSI_TASK_STAGE_DECODE, NULL));
 }
@@ -0,0 +1,427 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_bench.c
+ * @brief Synthetic CSI load to find the packet rate a chip sustains without a sender
+ */
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "csi_bench.h"
+#include "csi_perf.h"
+#include "csi_task.h"
+
+#define CSI_BENCH_TASK_STACK        4096
+#define CSI_BENCH_SLOT_SIZE         (sizeof(wifi_csi_filtered_info_t) + CSI_BENCH_FRAME_MAX_LEN)
+#define CSI_BENCH_STATIC_AMPLITUDE  24.0f   /* Static paths of the synthetic channel */
+#define CSI_BENCH_MOVING_AMPLITUDE  8.0f    /* The moving path */
+#define CSI_BENCH_DOPPLER_HZ        2.0f    /* Of the moving path, at the offered rate */
+#define CSI_BENCH_PATH_DELAY        0.3f    /* Phase step of the moving path per subcarrier, radians */
+
+static const char *TAG = "csi_bench";
+
+extern esp_err_t csi_data_push(wifi_csi_filtered_info_t *info);
+
+static struct {
+    csi_bench_config_t config;
+    TaskHandle_t task;
+    volatile bool running;
+    volatile bool stop;
+    csi_bench_stats_t stats;        /* Bench task only, but results */
+    uint32_t last_push_us;          /* Low word of esp_timer_get_time(), read by the radar callback */
+    csi_perf_stage_t perf_push;
+    csi_perf_stage_t perf_result;
+#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61
+    int dec_ltf_type;               /* Of the decoder before the run, restored after it */
+#endif
+    float moving[2];                /* Phasor of the moving path, advanced every frame */
+    float moving_step[2];
+    int8_t static_csi[CSI_BENCH_FRAME_MAX_LEN];
+} s_bench;
+
+/* Captured frames, CSI_BENCH_SLOT_SIZE each, filled by the CSI callback under s_capture_lock */
+static struct {
+    uint8_t *slots;
+    uint16_t num;
+    volatile uint16_t captured;
+} s_capture;
+
+static portMUX_TYPE s_capture_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t csi_bench_parse_ltf(const char *name, csi_bench_ltf_t *ltf)
+{
+    if (!strcasecmp(name, "LLTF")) {
+        *ltf = CSI_BENCH_LTF_LLTF;
+    } else if (!strcasecmp(name, "HT-LTF")) {
+        *ltf = CSI_BENCH_LTF_HTLTF;
+#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C6 || CONFIG_IDF_TARGET_ESP32C61
+    } else if (!strcasecmp(name, "HE-LTF")) {
+        *ltf = CSI_BENCH_LTF_HELTF;
+#endif
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+
+/* Static paths of random amplitude and phase, the same for every run */
+static void csi_bench_synth_init(void)
+{
+    uint32_t seed = 0x12345678;
+    float step = 2 * (float)M_PI * CSI_BENCH_DOPPLER_HZ / s_bench.config.rate;
+
+    for (int i = 0; i < CSI_BENCH_FRAME_MAX_LEN; i++) {
+        seed = seed * 1664525 + 1013904223;
+        s_bench.static_csi[i] = (int8_t)((int)(seed >> 24) * (2 * (int)CSI_BENCH_STATIC_AMPLITUDE) / 256
+                                         - (int)CSI_BENCH_STATIC_AMPLITUDE);
+    }
+
+    s_bench.moving[0] = 1;
+    s_bench.moving[1] = 0;
+    s_bench.moving_step[0] = cosf(step);
+    s_bench.moving_step[1] = sinf(step);
+}
+
+static void csi_bench_synth_fill(wifi_csi_filtered_info_t *info)
+{
+    uint16_t len = 2 * s_bench.config.subcarriers;
+    float re = s_bench.moving[0];
+    float im = s_bench.moving[1];
+    float delay_re = cosf(CSI_BENCH_PATH_DELAY);
+    float delay_im = sinf(CSI_BENCH_PATH_DELAY);
+
+    memset(info, 0, sizeof(wifi_csi_filtered_info_t));
+    memcpy(info->mac, "\x1a\x00\x00\x00\x00\x00", sizeof(info->mac));
+    info->rx_ctrl_info.rssi = -50;
+    info->rx_ctrl_info.noise_floor = -95;
+    info->valid_len = len;
+
+    switch (s_bench.config.ltf) {
+    case CSI_BENCH_LTF_HTLTF:
+        info->valid_ht_ltf_len = len;
+        break;
+#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C6 || CONFIG_IDF_TARGET_ESP32C61
+    case CSI_BENCH_LTF_HELTF:
+        info->valid_he_ltf_len = len;
+        break;
+#endif
+    default:
+        info->valid_lltf_len = len;
+        break;
+    }
+
+    /* The moving path turns by CSI_BENCH_PATH_DELAY from one subcarrier to the next */
+    for (int k = 0; k < s_bench.config.subcarriers; k++) {
+        float h_re = s_bench.static_csi[2 * k] + CSI_BENCH_MOVING_AMPLITUDE * re;
+        float h_im = s_bench.static_csi[2 * k + 1] + CSI_BENCH_MOVING_AMPLITUDE * im;
+        float next_re = re * delay_re - im * delay_im;
+
+        im = re * delay_im + im * delay_re;
+        re = next_re;
+        info->valid_data[2 * k] = (int8_t)lroundf(h_re);
+        info->valid_data[2 * k + 1] = (int8_t)lroundf(h_im);
+    }
+
+    /* Advance the Doppler phasor, renormalized so the rounding does not let it drift */
+    re = s_bench.moving[0] * s_bench.moving_step[0] - s_bench.moving[1] * s_bench.moving_step[1];
+    im = s_bench.moving[0] * s_bench.moving_step[1] + s_bench.moving[1] * s_bench.moving_step[0];
+    float norm = 1.0f / sqrtf(re * re + im * im);
+    s_bench.moving[0] = re * norm;
+    s_bench.moving[1] = im * norm;
+}
+
+static void csi_bench_push(uint32_t index)
+{
+    const wifi_csi_filtered_info_t *replay = NULL;
+    size_t len = 2 * s_bench.config.subcarriers;
+
+    if (s_bench.config.replay) {
+        replay = (const wifi_csi_filtered_info_t *)(s_capture.slots + (index % s_capture.captured) * CSI_BENCH_SLOT_SIZE);
+        len = replay->valid_len;
+    }
+
+    /* The decoder takes ownership and frees it, like the frames of the Wi-Fi callback */
+    wifi_csi_filtered_info_t *info = malloc(sizeof(wifi_csi_filtered_info_t) + len);
+
+    if (!info) {
+        s_bench.stats.no_mem++;
+        return;
+    }
+
+    if (replay) {
+        memcpy(info, replay, sizeof(wifi_csi_filtered_info_t) + len);
+    } else {
+        csi_bench_synth_fill(info);
+    }
+
+    info->rx_ctrl_info.timestamp = (uint32_t)esp_timer_get_time();
+    s_bench.stats.offered++;
+
+    if (s_bench.config.frame_cb) {
+        s_bench.config.frame_cb(NULL, info);
+    }
+
+    int64_t start_us = csi_perf_begin();
+    esp_err_t ret = csi_data_push(info);
+    csi_perf_end(s_bench.perf_push, start_us);
+
+    if (ret != ESP_OK) {
+        csi_perf_drop(s_bench.perf_push);
+        s_bench.stats.dropped++;
+        return;
+    }
+
+    __atomic_store_n(&s_bench.last_push_us, (uint32_t)esp_timer_get_time(), __ATOMIC_RELAXED);
+    __atomic_store_n(&s_bench.stats.pushed, s_bench.stats.pushed + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Log the rates since prev and the latency percentiles since the start of the run
+ */
+static void csi_bench_report(const char *title, const csi_bench_stats_t *prev, int64_t elapsed_us)
+{
+    csi_bench_stats_t stats;
+    csi_perf_summary_t push = {0};
+    csi_perf_summary_t result = {0};
+    float seconds = elapsed_us > 0 ? elapsed_us / 1000000.0f : 1;
+
+    csi_bench_get_stats(&stats);
+    csi_perf_get(s_bench.perf_push, &push);
+    csi_perf_get(s_bench.perf_result, &result);
+
+    ESP_LOGI(TAG, "%s: offered %.1f frames/s, accepted %.1f frames/s, %.1f results/s, dropped %lu, no_mem %lu, "
+             "skipped %lu bursts, push p50 %lu us p99 %lu us, latency p50 %lu us p90 %lu us p99 %lu us max %lu us",
+             title, (stats.offered - prev->offered) / seconds, (stats.pushed - prev->pushed) / seconds,
+             (stats.results - prev->results) / seconds, (unsigned long)(stats.dropped - prev->dropped),
+             (unsigned long)(stats.no_mem - prev->no_mem), (unsigned long)(stats.skipped - prev->skipped),
+             (unsigned long)push.p50_us, (unsigned long)push.p99_us, (unsigned long)result.p50_us,
+             (unsigned long)result.p90_us, (unsigned long)result.p99_us, (unsigned long)result.max_us);
+
+    csi_task_log_usage();
+}
+
+#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61
+/* The decoder reads the field the synthetic CSI is in, the captured frames keep what they had */
+static void csi_bench_set_dec_ltf(bool restore)
+{
+    esp_radar_config_t radar_config = {0};
+    esp_radar_get_config(&radar_config);
+
+    if (restore) {
+        radar_config.dec_config.ltf_type = s_bench.dec_ltf_type;
+    } else {
+        s_bench.dec_ltf_type = radar_config.dec_config.ltf_type;
+        radar_config.dec_config.ltf_type = s_bench.config.ltf == CSI_BENCH_LTF_HELTF ? RADAR_LTF_TYPE_HELTF
+                                           : s_bench.config.ltf == CSI_BENCH_LTF_HTLTF ? RADAR_LTF_TYPE_HTLTF
+                                           : RADAR_LTF_TYPE_LLTF;
+    }
+
+    esp_radar_change_config(&radar_config);
+}
+#endif
+
+static void csi_bench_task(void *arg)
+{
+    const csi_bench_config_t *config = &s_bench.config;
+    int64_t period_us = MAX((int64_t)config->burst * 1000000 / config->rate, 1);
+    int64_t start_us = esp_timer_get_time();
+    int64_t next_us = start_us;
+    int64_t report_us = start_us;
+    csi_bench_stats_t interval = {0};
+    uint32_t index = 0;
+
+#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61
+    if (!config->replay) {
+        csi_bench_set_dec_ltf(false);
+    }
+#endif
+
+    ESP_LOGI(TAG, "%lu frames/s in bursts of %u, %s, for %lu ms", (unsigned long)config->rate, config->burst,
+             config->replay ? "replayed" : "synthetic", (unsigned long)config->duration_ms);
+
+    /* Starts the CPU shares over, so the reports cover the run only */
+    csi_task_log_usage();
+
+    while (!s_bench.stop) {
+        int64_t now = esp_timer_get_time();
+
+        if (config->duration_ms && now - start_us >= config->duration_ms * 1000LL) {
+            break;
+        }
+
+        /* The generator could not keep up, what it missed is not made up for */
+        if (now - next_us > CSI_BENCH_MAX_LAG_MS * 1000) {
+            uint32_t late = (now - next_us) / period_us;
+
+            s_bench.stats.skipped += late;
+            next_us += late * period_us;
+        }
+
+        while (next_us <= now && !s_bench.stop) {
+            for (int i = 0; i < config->burst; i++) {
+                csi_bench_push(index++);
+            }
+
+            next_us += period_us;
+        }
+
+        if (now - report_us >= config->report_interval_ms * 1000LL) {
+            csi_bench_report("CSI bench", &interval, now - report_us);
+            csi_bench_get_stats(&interval);
+            report_us = now;
+        }
+
+        int64_t wait_us = next_us - esp_timer_get_time();
+        vTaskDelay(MAX(wait_us / 1000 / portTICK_PERIOD_MS, 1));
+    }
+
+    /* Let the decoder finish the frames still queued before the totals, the rates leave that time out */
+    int64_t run_us = esp_timer_get_time() - start_us;
+    vTaskDelay(pdMS_TO_TICKS(500));
+
+    csi_bench_stats_t total = {0};
+    csi_bench_report("CSI bench total", &total, run_us);
+    csi_perf_print();
+
+#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61
+    if (!config->replay) {
+        csi_bench_set_dec_ltf(true);
+    }
+#endif
+
+    s_bench.task = NULL;
+    s_bench.running = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t csi_bench_start(const csi_bench_config_t *config)
+{
+    if (!config || !config->rate || !config->burst || !config->report_interval_ms
+            || (!config->replay && (!config->subcarriers || 2 * config->subcarriers > CSI_BENCH_FRAME_MAX_LEN))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_bench.running || s_capture.captured < s_capture.num || (config->replay && !s_capture.captured)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* Looked up again after the first run */
+    s_bench.perf_push   = csi_perf_register("bench_push");
+    s_bench.perf_result = csi_perf_register("bench_result");
+
+    s_bench.config = *config;
+    s_bench.stop = false;
+    memset(&s_bench.stats, 0, sizeof(s_bench.stats));
+    csi_bench_synth_init();
+
+    /* The percentiles of every stage cover the run only */
+    csi_perf_reset();
+
+    /* No higher than decoding, like the Wi-Fi task it stands in for, so it competes with it */
+    s_bench.running = true;
+    esp_err_t ret = csi_task_create(csi_bench_task, "csi_bench", CSI_BENCH_TASK_STACK, NULL,
+                                    CSI_TASK_STAGE_DECODE, &s_bench.task);
+
+    if (ret != ESP_OK) {
+        s_bench.running = false;
+    }
+
+    return ret;
+}
+
+void csi_bench_stop(void)
+{
+    s_bench.stop = true;
+}
+
+bool csi_bench_is_running(void)
+{
+    return s_bench.running;
+}
+
+esp_err_t csi_bench_capture(uint16_t num)
+{
+    if (!num || num > CSI_BENCH_CAPTURE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_bench.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t *slots = malloc(num * CSI_BENCH_SLOT_SIZE);
+
+    if (!slots) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&s_capture_lock);
+    uint8_t *old = s_capture.slots;
+    s_capture.slots = slots;
+    s_capture.num = num;
+    s_capture.captured = 0;
+    portEXIT_CRITICAL(&s_capture_lock);
+
+    free(old);
+
+    return ESP_OK;
+}
+
+uint16_t csi_bench_captured(void)
+{
+    return s_capture.captured;
+}
+
+void csi_bench_capture_frame(const wifi_csi_filtered_info_t *info)
+{
+    if (s_capture.captured >= s_capture.num) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_capture_lock);
+
+    if (s_capture.captured < s_capture.num) {
+        wifi_csi_filtered_info_t *slot = (wifi_csi_filtered_info_t *)(s_capture.slots
+                                                                      + s_capture.captured * CSI_BENCH_SLOT_SIZE);
+
+        *slot = *info;
+        slot->valid_len = MIN(info->valid_len, CSI_BENCH_FRAME_MAX_LEN);
+        memcpy(slot->valid_data, info->valid_data, slot->valid_len);
+        s_capture.captured++;
+    }
+
+    portEXIT_CRITICAL(&s_capture_lock);
+}
+
+void csi_bench_radar_result(void)
+{
+    if (!s_bench.running) {
+        return;
+    }
+
+    /* Latency from the newest frame the decoder took, none yet in this run leaves nothing to measure */
+    if (__atomic_load_n(&s_bench.stats.pushed, __ATOMIC_ACQUIRE)) {
+        uint32_t now_us = (uint32_t)esp_timer_get_time();
+        csi_perf_record(s_bench.perf_result, now_us - __atomic_load_n(&s_bench.last_push_us, __ATOMIC_RELAXED));
+    }
+
+    __atomic_fetch_add(&s_bench.stats.results, 1, __ATOMIC_RELAXED);
+}
+
+void csi_bench_get_stats(csi_bench_stats_t *stats)
+{
+    *stats = s_bench.stats;
+    stats->results = __atomic_load_n(&s_bench.stats.results, __ATOMIC_RELAXED);
+}
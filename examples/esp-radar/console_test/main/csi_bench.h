@@ -0,0 +1,137 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_bench.h
+ * @brief Synthetic CSI load to find the packet rate a chip sustains without a sender
+ *
+ * A task stands in for the Wi-Fi driver: every rate / burst seconds it
+ * pushes burst frames into the esp-radar decoder with csi_data_push(), and
+ * optionally hands each to a frame callback too, e.g. wifi_csi_raw_cb() for
+ * the console output path. Bursts due closer together than a tick go out
+ * back to back. The frames are either synthetic, a static channel with one
+ * moving path, or frames captured from the live CSI beforehand and replayed
+ * in a loop.
+ *
+ * The radar results are counted with csi_bench_radar_result(). Their
+ * latency is taken from the newest frame pushed before them, which is the
+ * decode time while the decoder keeps up; once it falls behind, its queue
+ * refuses frames and they are counted as drops.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_radar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_BENCH_FRAME_MAX_LEN     1024    /**< Largest CSI payload generated or captured, in bytes */
+#define CSI_BENCH_CAPTURE_MAX       32      /**< Frames kept for the replay */
+#define CSI_BENCH_MAX_LAG_MS        100     /**< Bursts later than this are skipped instead of caught up */
+
+typedef enum {
+    CSI_BENCH_LTF_LLTF = 0,
+    CSI_BENCH_LTF_HTLTF,
+    CSI_BENCH_LTF_HELTF,
+} csi_bench_ltf_t;
+
+typedef void (*csi_bench_frame_cb_t)(void *ctx, const wifi_csi_filtered_info_t *info);
+
+typedef struct {
+    uint32_t rate;                  /**< Frames per second offered */
+    uint16_t burst;                 /**< Frames pushed back to back */
+    uint16_t subcarriers;           /**< Of the synthetic frames, 2 bytes each */
+    csi_bench_ltf_t ltf;            /**< Field that holds the synthetic CSI */
+    bool replay;                    /**< Loop the captured frames instead */
+    uint32_t duration_ms;           /**< 0 runs until csi_bench_stop() */
+    uint32_t report_interval_ms;
+    csi_bench_frame_cb_t frame_cb;  /**< Also gets every frame, may be NULL */
+} csi_bench_config_t;
+
+#define CSI_BENCH_CONFIG_DEFAULT() { \
+    .rate = 100, \
+    .burst = 1, \
+    .subcarriers = 64, \
+    .ltf = CSI_BENCH_LTF_LLTF, \
+    .replay = false, \
+    .duration_ms = 10000, \
+    .report_interval_ms = 1000, \
+    .frame_cb = NULL, \
+}
+
+typedef struct {
+    uint32_t offered;               /**< Frames generated */
+    uint32_t pushed;                /**< Accepted by the decoder queue */
+    uint32_t dropped;               /**< Refused by the decoder queue */
+    uint32_t no_mem;                /**< Not generated, the allocation failed */
+    uint32_t skipped;               /**< Bursts skipped, the generator itself fell behind */
+    uint32_t results;               /**< Radar results */
+} csi_bench_stats_t;
+
+/**
+ * @brief Parse LLTF, HT-LTF or HE-LTF
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the name is unknown
+ */
+esp_err_t csi_bench_parse_ltf(const char *name, csi_bench_ltf_t *ltf);
+
+/**
+ * @brief Start the load, the previous run must have finished
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the rate, burst or subcarriers are out of range
+ *      - ESP_ERR_INVALID_STATE if a run or a capture is going on, or replay is set and nothing was captured
+ *      - ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t csi_bench_start(const csi_bench_config_t *config);
+
+/**
+ * @brief Ask the run to end, it logs its totals when it does
+ */
+void csi_bench_stop(void);
+
+bool csi_bench_is_running(void);
+
+/**
+ * @brief Keep the next num live frames for the replay, dropping the previous capture
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if num is 0 or above CSI_BENCH_CAPTURE_MAX
+ *      - ESP_ERR_INVALID_STATE while a run is going on
+ *      - ESP_ERR_NO_MEM if the frames could not be allocated
+ */
+esp_err_t csi_bench_capture(uint16_t num);
+
+/**
+ * @brief Frames captured so far
+ */
+uint16_t csi_bench_captured(void);
+
+/**
+ * @brief Offer a live frame to the capture, from the CSI callback
+ */
+void csi_bench_capture_frame(const wifi_csi_filtered_info_t *info);
+
+/**
+ * @brief Count a radar result, from the radar callback
+ */
+void csi_bench_radar_result(void);
+
+/**
+ * @brief Copy the counters of the current or last run
+ */
+void csi_bench_get_stats(csi_bench_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,283 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_codec.c
+ * @brief Subcarrier selection and delta compression of CSI records
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/param.h>
+
+#include "esp_bit_defs.h"
+#include "csi_codec.h"
+
+#define CSI_CODEC_NIBBLE_ESCAPE     -8
+
+esp_err_t csi_codec_init(csi_codec_t *codec, const csi_codec_config_t *config)
+{
+    if (!codec || !config || !config->decimate || !config->key_interval
+            || config->encoding > CSI_CODEC_ENCODING_NIBBLE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(codec, 0, sizeof(csi_codec_t));
+    codec->config = *config;
+    codec->need_key = true;
+
+    return ESP_OK;
+}
+
+void csi_codec_force_key(csi_codec_t *codec)
+{
+    codec->need_key = true;
+}
+
+size_t csi_codec_max_len(uint16_t len)
+{
+    return CSI_CODEC_KEY_HEADER_LEN + 2 * MIN(len, CSI_CODEC_VALUE_MAX);
+}
+
+/* Rebuild the value offsets when the CSI length changes, e.g. between LLTF and HT-LTF frames */
+static void csi_codec_select(csi_codec_t *codec, uint16_t len)
+{
+    const csi_codec_config_t *config = &codec->config;
+    int picked = 0;
+
+    codec->len = len;
+    codec->num = 0;
+    memset(codec->selection, 0, sizeof(codec->selection));
+
+    for (int i = 0; i < len / 2; i++) {
+        if (config->mask_enable && !(config->mask[i / 8] & BIT(i % 8))) {
+            continue;
+        }
+
+        if (picked++ % config->decimate) {
+            continue;
+        }
+
+        codec->selection[i / 8] |= BIT(i % 8);
+        codec->index[codec->num++] = 2 * i;
+        codec->index[codec->num++] = 2 * i + 1;
+    }
+}
+
+/* Deltas of int8 values span [-255, 255], their zigzag codes fit in 9 bits */
+static uint8_t *csi_codec_put_packed(csi_codec_t *codec, uint8_t *dst, const int8_t *csi)
+{
+    for (int first = 0; first < codec->num; first += CSI_CODEC_GROUP_LEN) {
+        int last = MIN(first + CSI_CODEC_GROUP_LEN, codec->num);
+        uint16_t zigzag[CSI_CODEC_GROUP_LEN];
+        uint16_t widest = 0;
+
+        for (int i = first; i < last; i++) {
+            int8_t value = csi[codec->index[i]];
+            int32_t delta = value - codec->reference[i];
+
+            zigzag[i - first] = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+            widest |= zigzag[i - first];
+            codec->reference[i] = value;
+        }
+
+        uint8_t width = widest ? 32 - __builtin_clz(widest) : 0;
+        uint32_t bits = 0;
+        int bit_num = 0;
+
+        *dst++ = width;
+        for (int i = 0; i < last - first && width; i++) {
+            bits |= (uint32_t)zigzag[i] << bit_num;
+            for (bit_num += width; bit_num >= 8; bit_num -= 8, bits >>= 8) {
+                *dst++ = bits;
+            }
+        }
+        if (bit_num) {
+            *dst++ = bits;
+        }
+    }
+
+    return dst;
+}
+
+static uint8_t *csi_codec_put_nibbles(csi_codec_t *codec, uint8_t *dst, const int8_t *csi)
+{
+    bool lossless = codec->config.lossless;
+    uint8_t *escape = dst + (codec->num + 1) / 2;
+
+    memset(dst, 0, (codec->num + 1) / 2);
+
+    for (int i = 0; i < codec->num; i++) {
+        int8_t value = csi[codec->index[i]];
+        int32_t delta = value - codec->reference[i];
+
+        if (delta < -7 || delta > 7) {
+            if (lossless) {
+                /* The full value follows the nibbles, in the order of the escapes */
+                *escape++ = value;
+                delta = CSI_CODEC_NIBBLE_ESCAPE;
+            } else {
+                delta = MIN(MAX(delta, -7), 7);
+                value = codec->reference[i] + delta;
+                codec->stats.clamped++;
+            }
+        }
+
+        dst[i / 2] |= (delta & 0x0f) << (4 * (i & 1));
+        codec->reference[i] = value;
+    }
+
+    return escape;
+}
+
+size_t csi_codec_encode(csi_codec_t *codec, const int8_t *csi, uint16_t len, uint8_t *out)
+{
+    const csi_codec_config_t *config = &codec->config;
+    uint8_t flags = CSI_CODEC_VERSION << 5;
+    uint8_t *dst = out;
+
+    len = MIN(len, CSI_CODEC_VALUE_MAX);
+
+    if (len != codec->len) {
+        csi_codec_select(codec, len);
+        codec->need_key = true;
+    }
+
+    bool key = codec->need_key || codec->since_key >= config->key_interval;
+    bool lossless = config->lossless || config->encoding != CSI_CODEC_ENCODING_NIBBLE;
+
+    if (key) {
+        flags |= CSI_CODEC_FLAG_KEY | CSI_CODEC_FLAG_LOSSLESS;
+    } else if (config->delta) {
+        flags |= CSI_CODEC_FLAG_DELTA | (config->encoding << 2) | (lossless ? CSI_CODEC_FLAG_LOSSLESS : 0);
+    } else {
+        flags |= CSI_CODEC_FLAG_LOSSLESS;
+    }
+
+    *dst++ = flags;
+    *dst++ = codec->sequence++;
+    *dst++ = len & 0xff;
+    *dst++ = len >> 8;
+    *dst++ = codec->num & 0xff;
+    *dst++ = codec->num >> 8;
+
+    if (key) {
+        uint8_t mask_len = (len / 2 + 7) / 8;
+        *dst++ = mask_len;
+        memcpy(dst, codec->selection, mask_len);
+        dst += mask_len;
+    }
+
+    if (!(flags & CSI_CODEC_FLAG_DELTA)) {
+        for (int i = 0; i < codec->num; i++) {
+            codec->reference[i] = csi[codec->index[i]];
+        }
+        memcpy(dst, codec->reference, codec->num);
+        dst += codec->num;
+    } else if (config->encoding == CSI_CODEC_ENCODING_NIBBLE) {
+        dst = csi_codec_put_nibbles(codec, dst, csi);
+    } else if (config->encoding == CSI_CODEC_ENCODING_PACKED) {
+        dst = csi_codec_put_packed(codec, dst, csi);
+    } else {
+        for (int i = 0; i < codec->num; i++) {
+            int8_t value = csi[codec->index[i]];
+            *dst++ = (uint8_t)(value - codec->reference[i]);
+            codec->reference[i] = value;
+        }
+    }
+
+    if (key) {
+        codec->need_key = false;
+        codec->since_key = 0;
+        codec->stats.keys++;
+    }
+    codec->since_key++;
+    codec->stats.records++;
+    codec->stats.input_bytes += len;
+    codec->stats.output_bytes += dst - out;
+
+    return dst - out;
+}
+
+void csi_codec_get_stats(csi_codec_t *codec, csi_codec_stats_t *stats, bool reset)
+{
+    *stats = codec->stats;
+
+    if (reset) {
+        memset(&codec->stats, 0, sizeof(codec->stats));
+    }
+}
+
+esp_err_t csi_codec_parse_mask(const char *ranges, csi_codec_config_t *config)
+{
+    uint8_t mask[CSI_CODEC_MASK_LEN] = {0};
+    const char *p = ranges;
+
+    if (!ranges || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!strcasecmp(ranges, "all")) {
+        config->mask_enable = false;
+        memset(config->mask, 0xff, sizeof(config->mask));
+        return ESP_OK;
+    }
+
+    while (*p) {
+        char *end = NULL;
+        long first = strtol(p, &end, 10);
+        long last = first;
+
+        if (end == p) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        p = end;
+        if (*p == '-') {
+            last = strtol(++p, &end, 10);
+            if (end == p) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            p = end;
+        }
+
+        if (first < 0 || last < first || last >= CSI_CODEC_SUBCARRIER_MAX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        for (long i = first; i <= last; i++) {
+            mask[i / 8] |= BIT(i % 8);
+        }
+
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    config->mask_enable = true;
+    memcpy(config->mask, mask, sizeof(mask));
+    return ESP_OK;
+}
+
+esp_err_t csi_codec_parse_encoding(const char *name, csi_codec_encoding_t *encoding)
+{
+    static const char *const names[] = {
+        [CSI_CODEC_ENCODING_INT8] = "int8",
+        [CSI_CODEC_ENCODING_PACKED] = "packed",
+        [CSI_CODEC_ENCODING_NIBBLE] = "nibble",
+    };
+
+    for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!strcasecmp(name, names[i])) {
+            *encoding = i;
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_INVALID_ARG;
+}
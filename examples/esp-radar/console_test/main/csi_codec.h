@@ -0,0 +1,162 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_codec.h
+ * @brief Subcarrier selection and delta compression of CSI records
+ *
+ * A subcarrier mask and a decimation step select which {real, imag} pairs
+ * are sent. Key frames carry the selected values as they are, together with
+ * the selection bitmap. The frames between two keys may carry the difference
+ * to the previous frame instead, either as int8, bit-packed in groups of
+ * CSI_CODEC_GROUP_LEN at the width of the largest zigzag delta of the group,
+ * or as 4-bit nibbles. Nibbles are lossy unless lossless is set: a delta
+ * outside [-7, 7] is then escaped and sent as a full byte, else it is
+ * clamped. The encoder follows the values the decoder reconstructs, so
+ * clamping never drifts.
+ *
+ * An encoded record, all fields little endian:
+ *
+ *  - u8 flags, see CSI_CODEC_FLAG_*, the version in the top three bits
+ *  - u8 sequence, +1 per record, a gap makes the decoder wait for a key
+ *  - u16 len, bytes of the original CSI, unselected values decode to 0
+ *  - u16 num, selected values
+ *  - key frames: u8 bitmap bytes, then the bitmap, one bit per subcarrier
+ *  - num int8 values, or their deltas in the flagged encoding
+ *
+ * console_test/tools/esp_csi_tool.py decodes it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_CODEC_VERSION           1
+#define CSI_CODEC_VALUE_MAX         1024    /**< Largest CSI accepted, in bytes */
+#define CSI_CODEC_SUBCARRIER_MAX    (CSI_CODEC_VALUE_MAX / 2)
+#define CSI_CODEC_MASK_LEN          (CSI_CODEC_SUBCARRIER_MAX / 8)
+#define CSI_CODEC_HEADER_LEN        6
+#define CSI_CODEC_GROUP_LEN         16      /**< Deltas sharing one bit width in the packed encoding */
+#define CSI_CODEC_KEY_HEADER_LEN    (CSI_CODEC_HEADER_LEN + 1 + CSI_CODEC_MASK_LEN)
+
+#define CSI_CODEC_FLAG_KEY          0x01    /**< Bitmap and plain values follow */
+#define CSI_CODEC_FLAG_DELTA        0x02    /**< Values are deltas to the previous record */
+#define CSI_CODEC_FLAG_ENCODING     0x0c    /**< csi_codec_encoding_t of the deltas, shifted by 2 */
+#define CSI_CODEC_FLAG_LOSSLESS     0x10    /**< The record decodes to the exact input */
+
+typedef enum {
+    CSI_CODEC_ENCODING_INT8,    /**< One int8 per delta, wrapping */
+    CSI_CODEC_ENCODING_PACKED,  /**< Per group a u8 bit width, then the zigzag deltas at that width, LSB first */
+    CSI_CODEC_ENCODING_NIBBLE,  /**< Two deltas per byte, low nibble first */
+} csi_codec_encoding_t;
+
+typedef struct {
+    bool mask_enable;                       /**< Apply mask, otherwise every subcarrier is selected */
+    uint8_t mask[CSI_CODEC_MASK_LEN];       /**< One bit per subcarrier, LSB first */
+    uint8_t decimate;                       /**< Keep every decimate-th selected subcarrier, 1 keeps all */
+    bool delta;                             /**< Send differences between the keys */
+    csi_codec_encoding_t encoding;          /**< Encoding of the differences */
+    bool lossless;                          /**< Escape the nibbles that do not fit instead of clamping */
+    uint16_t key_interval;                  /**< Records from one key to the next */
+} csi_codec_config_t;
+
+#define CSI_CODEC_CONFIG_DEFAULT() { \
+    .mask_enable = false, \
+    .decimate = 1, \
+    .delta = true, \
+    .encoding = CSI_CODEC_ENCODING_PACKED, \
+    .lossless = true, \
+    .key_interval = 100, \
+}
+
+typedef struct {
+    uint32_t records;           /**< Records encoded */
+    uint32_t keys;              /**< Of which key frames */
+    uint32_t clamped;           /**< Nibble deltas clamped, lossy mode only */
+    uint64_t input_bytes;       /**< CSI bytes in */
+    uint64_t output_bytes;      /**< Encoded bytes out */
+} csi_codec_stats_t;
+
+typedef struct {
+    csi_codec_config_t config;
+    uint16_t len;                               /**< CSI length the selection was built for */
+    uint16_t num;                               /**< Selected values */
+    uint8_t sequence;
+    uint16_t since_key;                         /**< Records since the last key */
+    bool need_key;
+    uint8_t selection[CSI_CODEC_MASK_LEN];      /**< Effective bitmap for len */
+    uint16_t index[CSI_CODEC_VALUE_MAX];        /**< Selected value offsets in the CSI */
+    int8_t reference[CSI_CODEC_VALUE_MAX];      /**< Values the decoder holds */
+    csi_codec_stats_t stats;
+} csi_codec_t;
+
+/**
+ * @brief Set up an encoder, the first record is a key
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the config is out of range
+ */
+esp_err_t csi_codec_init(csi_codec_t *codec, const csi_codec_config_t *config);
+
+/**
+ * @brief Make the next record a key, e.g. after a record was dropped on the way out
+ */
+void csi_codec_force_key(csi_codec_t *codec);
+
+/**
+ * @brief Upper bound of an encoded record for len bytes of CSI
+ */
+size_t csi_codec_max_len(uint16_t len);
+
+/**
+ * @brief Encode one CSI record
+ *
+ * @param csi Interleaved int8 CSI
+ * @param len Bytes of CSI, longer records are truncated to CSI_CODEC_VALUE_MAX
+ * @param out At least csi_codec_max_len(len) bytes
+ *
+ * @return Bytes written to out
+ */
+size_t csi_codec_encode(csi_codec_t *codec, const int8_t *csi, uint16_t len, uint8_t *out);
+
+/**
+ * @brief Copy the counters
+ *
+ * @param stats Filled with the counters
+ * @param reset Clear the counters afterwards
+ */
+void csi_codec_get_stats(csi_codec_t *codec, csi_codec_stats_t *stats, bool reset);
+
+/**
+ * @brief Parse a subcarrier mask such as "0-25,38-63" or "all"
+ *
+ * @param ranges Comma separated subcarrier indices and inclusive ranges
+ * @param config mask and mask_enable are set on success
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the text is malformed or out of [0, CSI_CODEC_SUBCARRIER_MAX)
+ */
+esp_err_t csi_codec_parse_mask(const char *ranges, csi_codec_config_t *config);
+
+/**
+ * @brief Parse an encoding name: int8, packed or nibble
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the name is unknown
+ */
+esp_err_t csi_codec_parse_encoding(const char *name, csi_codec_encoding_t *encoding);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,275 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_output.c
+ * @brief Batched console output for CSI records
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "csi_mem.h"
+#include "csi_output.h"
+#include "csi_perf.h"
+#include "csi_task.h"
+
+#define CSI_OUTPUT_TASK_STACK   3072
+
+static const char *TAG = "csi_output";
+
+typedef struct {
+    size_t len;
+    TickType_t first_tick;      /* When the first record was committed */
+    char data[];
+} csi_output_buffer_t;
+
+static struct {
+    csi_output_config_t config;
+    QueueHandle_t free_queue;
+    QueueHandle_t write_queue;
+    csi_output_buffer_t *current;   /* Being filled, producer only */
+    TaskHandle_t task;
+    csi_perf_stage_t perf_write;
+    csi_output_stats_t stats;
+} s_output;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void csi_output_task(void *arg)
+{
+    csi_output_buffer_t *buffer = NULL;
+
+    while (xQueueReceive(s_output.write_queue, &buffer, portMAX_DELAY)) {
+        int64_t start = esp_timer_get_time();
+        fwrite(buffer->data, 1, buffer->len, stdout);
+        fflush(stdout);
+        uint32_t write_us = esp_timer_get_time() - start;
+        csi_perf_record(s_output.perf_write, write_us);
+
+        portENTER_CRITICAL(&s_stats_lock);
+        s_output.stats.writes++;
+        s_output.stats.bytes += buffer->len;
+        if (write_us > s_output.stats.write_max_us) {
+            s_output.stats.write_max_us = write_us;
+        }
+        portEXIT_CRITICAL(&s_stats_lock);
+
+        buffer->len = 0;
+        xQueueSend(s_output.free_queue, &buffer, portMAX_DELAY);
+    }
+}
+
+/* The write queue holds every buffer, so this never blocks */
+static void csi_output_submit(void)
+{
+    xQueueSend(s_output.write_queue, &s_output.current, portMAX_DELAY);
+    s_output.current = NULL;
+}
+
+esp_err_t csi_output_init(const csi_output_config_t *config)
+{
+    if (!config || !config->buffer_size || config->buffer_num < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_output.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_output.config = *config;
+    s_output.perf_write = csi_perf_register("output_write");
+    s_output.free_queue = xQueueCreate(config->buffer_num, sizeof(csi_output_buffer_t *));
+    s_output.write_queue = xQueueCreate(config->buffer_num, sizeof(csi_output_buffer_t *));
+
+    if (!s_output.free_queue || !s_output.write_queue) {
+        goto err;
+    }
+
+    for (int i = 0; i < config->buffer_num; i++) {
+        csi_output_buffer_t *buffer = csi_mem_calloc(CSI_MEM_BULK, 1, sizeof(csi_output_buffer_t) + config->buffer_size,
+                                                     "csi_output");
+
+        if (!buffer) {
+            goto err;
+        }
+
+        buffer->len = 0;
+        xQueueSend(s_output.free_queue, &buffer, 0);
+    }
+
+    if (csi_task_create(csi_output_task, "csi_output", CSI_OUTPUT_TASK_STACK, NULL,
+                        CSI_TASK_STAGE_OUTPUT, &s_output.task) != ESP_OK) {
+        goto err;
+    }
+
+    return ESP_OK;
+
+err:
+    ESP_LOGE(TAG, "Failed to allocate %u x %u byte output buffers", config->buffer_num, (unsigned)config->buffer_size);
+
+    if (s_output.free_queue) {
+        csi_output_buffer_t *buffer = NULL;
+        while (xQueueReceive(s_output.free_queue, &buffer, 0)) {
+            csi_mem_free(buffer);
+        }
+        vQueueDelete(s_output.free_queue);
+    }
+    if (s_output.write_queue) {
+        vQueueDelete(s_output.write_queue);
+    }
+    memset(&s_output, 0, sizeof(s_output));
+    return ESP_ERR_NO_MEM;
+}
+
+char *csi_output_begin(size_t max_len)
+{
+    if (!s_output.task) {
+        return NULL;
+    }
+
+    if (s_output.current && s_output.current->len + max_len > s_output.config.buffer_size) {
+        csi_output_submit();
+    }
+
+    if (!s_output.current && max_len <= s_output.config.buffer_size
+            && !xQueueReceive(s_output.free_queue, &s_output.current, 0)) {
+        /* Every buffer waits for the serial port, the producer has to slow down */
+        TickType_t start = xTaskGetTickCount();
+        xQueueReceive(s_output.free_queue, &s_output.current, pdMS_TO_TICKS(s_output.config.wait_ms));
+
+        portENTER_CRITICAL(&s_stats_lock);
+        s_output.stats.stalls++;
+        s_output.stats.stall_ms += pdTICKS_TO_MS(xTaskGetTickCount() - start);
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+
+    if (!s_output.current) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_output.stats.dropped++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return NULL;
+    }
+
+    return s_output.current->data + s_output.current->len;
+}
+
+void csi_output_end(size_t len)
+{
+    if (!s_output.current->len) {
+        s_output.current->first_tick = xTaskGetTickCount();
+    }
+
+    s_output.current->len += len;
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_output.stats.records++;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+TickType_t csi_output_poll(void)
+{
+    if (!s_output.current || !s_output.current->len) {
+        return portMAX_DELAY;
+    }
+
+    TickType_t deadline = pdMS_TO_TICKS(s_output.config.flush_deadline_ms);
+    TickType_t elapsed = xTaskGetTickCount() - s_output.current->first_tick;
+
+    if (elapsed < deadline) {
+        return deadline - elapsed;
+    }
+
+    csi_output_submit();
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_output.stats.deadline_flushes++;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    return portMAX_DELAY;
+}
+
+void csi_output_get_stats(csi_output_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_output.stats;
+    if (reset) {
+        memset(&s_output.stats, 0, sizeof(s_output.stats));
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+char *csi_output_put_uint(char *dst, uint32_t value)
+{
+    char digits[10];
+    int n = 0;
+
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    while (n) {
+        *dst++ = digits[--n];
+    }
+
+    return dst;
+}
+
+char *csi_output_put_int(char *dst, int32_t value)
+{
+    if (value < 0) {
+        *dst++ = '-';
+        return csi_output_put_uint(dst, -(uint32_t)value);
+    }
+
+    return csi_output_put_uint(dst, value);
+}
+
+char *csi_output_put_base64(char *dst, const void *src, size_t len)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const uint8_t *p = src;
+
+    for (; len >= 3; len -= 3, p += 3) {
+        uint32_t v = p[0] << 16 | p[1] << 8 | p[2];
+        *dst++ = alphabet[v >> 18];
+        *dst++ = alphabet[(v >> 12) & 0x3f];
+        *dst++ = alphabet[(v >> 6) & 0x3f];
+        *dst++ = alphabet[v & 0x3f];
+    }
+
+    if (len) {
+        uint32_t v = p[0] << 16 | (len == 2 ? p[1] << 8 : 0);
+        *dst++ = alphabet[v >> 18];
+        *dst++ = alphabet[(v >> 12) & 0x3f];
+        *dst++ = len == 2 ? alphabet[(v >> 6) & 0x3f] : '=';
+        *dst++ = '=';
+    }
+
+    return dst;
+}
+
+char *csi_output_put_int8_array(char *dst, const int8_t *src, size_t len)
+{
+    *dst++ = '"';
+    *dst++ = '[';
+
+    for (size_t i = 0; i < len; i++) {
+        if (i) {
+            *dst++ = ',';
+        }
+        dst = csi_output_put_int(dst, src[i]);
+    }
+
+    *dst++ = ']';
+    *dst++ = '"';
+    return dst;
+}
@@ -0,0 +1,128 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_output.h
+ * @brief Batched console output for CSI records
+ *
+ * Records are formatted straight into one of a few preallocated buffers. A
+ * buffer is handed to a writer task when the next record does not fit or
+ * when its first record is older than the flush deadline; the writer sends
+ * it to stdout with a single write, which the console VFS routes to the UART
+ * or USB-Serial-JTAG console. Formatting therefore never waits for the
+ * serial port unless all buffers are queued for writing; that wait, and the
+ * records dropped when it times out, are counted as back-pressure.
+ *
+ * Only one task may produce records.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    size_t buffer_size;         /**< Bytes per buffer, must hold the longest record */
+    uint8_t buffer_num;         /**< Buffers in the pool, at least 2 */
+    uint32_t flush_deadline_ms; /**< Longest a record waits in a partly filled buffer */
+    uint32_t wait_ms;           /**< Longest csi_output_begin() waits for a free buffer before dropping */
+} csi_output_config_t;
+
+#define CSI_OUTPUT_CONFIG_DEFAULT() { \
+    .buffer_size = 8 * 1024, \
+    .buffer_num = 3, \
+    .flush_deadline_ms = 20, \
+    .wait_ms = 100, \
+}
+
+typedef struct {
+    uint32_t records;           /**< Records committed */
+    uint32_t writes;            /**< Buffers written */
+    uint64_t bytes;             /**< Bytes written */
+    uint32_t deadline_flushes;  /**< Buffers sent early because of the flush deadline */
+    uint32_t stalls;            /**< csi_output_begin() calls that had to wait for a free buffer */
+    uint32_t stall_ms;          /**< Total time spent waiting for a free buffer */
+    uint32_t dropped;           /**< Records dropped because no buffer became free within wait_ms */
+    uint32_t write_max_us;      /**< Longest single write */
+} csi_output_stats_t;
+
+/**
+ * @brief Allocate the buffers and start the writer task
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the config is incomplete
+ *      - ESP_ERR_INVALID_STATE if already initialized
+ *      - ESP_ERR_NO_MEM if the buffers or the task could not be allocated
+ */
+esp_err_t csi_output_init(const csi_output_config_t *config);
+
+/**
+ * @brief Reserve room for one record
+ *
+ * @param max_len Upper bound of the record length
+ *
+ * @return Where to format the record, NULL if it must be dropped
+ */
+char *csi_output_begin(size_t max_len);
+
+/**
+ * @brief Commit the record written at the csi_output_begin() position
+ *
+ * @param len Bytes written, at most max_len
+ */
+void csi_output_end(size_t len);
+
+/**
+ * @brief Send a partly filled buffer once its deadline passed
+ *
+ * The producer calls this whenever it wakes up and uses the result as the
+ * timeout of its next wait for input.
+ *
+ * @return Ticks until the next deadline, portMAX_DELAY if nothing is pending
+ */
+TickType_t csi_output_poll(void);
+
+/**
+ * @brief Copy the counters
+ *
+ * @param stats Filled with the counters
+ * @param reset Clear the counters afterwards
+ */
+void csi_output_get_stats(csi_output_stats_t *stats, bool reset);
+
+/**
+ * @brief Format a signed decimal number, return the end of the text
+ */
+char *csi_output_put_int(char *dst, int32_t value);
+
+/**
+ * @brief Format an unsigned decimal number, return the end of the text
+ */
+char *csi_output_put_uint(char *dst, uint32_t value);
+
+/**
+ * @brief Base64-encode len bytes, return the end of the text
+ *
+ * Writes 4 * ((len + 2) / 3) characters.
+ */
+char *csi_output_put_base64(char *dst, const void *src, size_t len);
+
+/**
+ * @brief Format int8 values as "[a,b,...]" in quotes, return the end of the text
+ *
+ * Writes at most 5 * len + 4 characters.
+ */
+char *csi_output_put_int8_array(char *dst, const int8_t *src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,460 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_recorder.c
+ * @brief Binary CSI and radar records kept in a flash partition ring
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "csi_recorder.h"
+#include "csi_task.h"
+#include "csi_mem.h"
+
+#define CSI_RECORDER_TASK_STACK     3072
+#define CSI_RECORDER_BUFFER_NUM     2
+#define CSI_RECORDER_STOP_WAIT_MS   3000
+
+static const char *TAG = "csi_recorder";
+
+typedef struct {
+    uint8_t *data;              /* CSI_RECORDER_SECTOR_SIZE bytes */
+    uint32_t sector;            /* Index in the partition */
+    uint32_t seq;
+    size_t fill;                /* Bytes holding the header and records */
+    size_t programmed;          /* Bytes in flash, flash task only */
+    uint32_t types;             /* Bit per csi_recorder_type_t in the sector */
+    bool erased;
+    bool closed;                /* No more records, programmed completely next */
+    bool busy;                  /* Assigned to a sector and not in flash yet */
+} csi_recorder_buffer_t;
+
+/* The buffers and stats are shared by the producers and the flash task, under lock */
+static struct {
+    csi_recorder_config_t config;
+    const esp_partition_t *partition;
+    uint32_t sectors;
+    uint32_t next_sector;
+    uint32_t next_seq;
+    uint16_t session;
+    bool running;
+    csi_recorder_buffer_t buffers[CSI_RECORDER_BUFFER_NUM];
+    csi_recorder_buffer_t *active;
+    csi_recorder_record_header_t *record;   /* Between csi_recorder_begin() and csi_recorder_end() */
+    uint8_t record_seq;
+    SemaphoreHandle_t lock;
+    TaskHandle_t task;
+    csi_recorder_stats_t stats;
+} s_recorder;
+
+static bool sector_header_valid(const csi_recorder_sector_header_t *header)
+{
+    return header->magic == CSI_RECORDER_MAGIC && header->version == CSI_RECORDER_VERSION;
+}
+
+/* Records end at a type of 0xff or at a length running past the sector, which a cut write leaves behind */
+static size_t sector_records_len(const uint8_t *records, size_t size)
+{
+    size_t pos = 0;
+
+    while (pos + sizeof(csi_recorder_record_header_t) <= size) {
+        const csi_recorder_record_header_t *record = (const csi_recorder_record_header_t *)(records + pos);
+
+        if (record->type == CSI_RECORDER_TYPE_END
+                || pos + sizeof(*record) + record->len > size) {
+            break;
+        }
+
+        pos += sizeof(*record) + record->len;
+    }
+
+    return pos;
+}
+
+/* Program the part of the buffer that is ready: whole pages while it fills, everything once closed */
+static void csi_recorder_flush_buffer(csi_recorder_buffer_t *buffer)
+{
+    xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+    bool closed = buffer->closed;
+    size_t end = (buffer->fill + (closed ? CSI_RECORDER_PAGE_SIZE - 1 : 0)) & ~(CSI_RECORDER_PAGE_SIZE - 1);
+    xSemaphoreGive(s_recorder.lock);
+
+    size_t offset = buffer->sector * CSI_RECORDER_SECTOR_SIZE;
+    esp_err_t ret = ESP_OK;
+    uint32_t erases = 0;
+    uint32_t page_writes = 0;
+
+    if (!buffer->erased) {
+        ret = esp_partition_erase_range(s_recorder.partition, offset, CSI_RECORDER_SECTOR_SIZE);
+        buffer->erased = ret == ESP_OK;
+        erases++;
+    }
+
+    if (ret == ESP_OK && end > buffer->programmed) {
+        ret = esp_partition_write(s_recorder.partition, offset + buffer->programmed,
+                                  buffer->data + buffer->programmed, end - buffer->programmed);
+        page_writes = (end - buffer->programmed) / CSI_RECORDER_PAGE_SIZE;
+        buffer->programmed = end;
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> sector %lu lost", esp_err_to_name(ret), (unsigned long)buffer->sector);
+    }
+
+    xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+    s_recorder.stats.erases += erases;
+    s_recorder.stats.page_writes += page_writes;
+
+    if (ret != ESP_OK) {
+        s_recorder.stats.errors++;
+    }
+
+    /* A failed sector is given up, retrying would stall the ring behind it */
+    if (ret != ESP_OK || closed) {
+        buffer->busy = false;
+
+        if (s_recorder.active == buffer) {
+            s_recorder.active = NULL;
+        }
+    }
+    xSemaphoreGive(s_recorder.lock);
+}
+
+static void csi_recorder_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(s_recorder.config.flush_interval_ms));
+
+        /* Oldest sector first, so flash never holds a newer sector without the one before it */
+        xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+        csi_recorder_buffer_t *first = &s_recorder.buffers[0];
+        csi_recorder_buffer_t *second = &s_recorder.buffers[1];
+
+        if (second->busy && (!first->busy || second->seq < first->seq)) {
+            first = &s_recorder.buffers[1];
+            second = &s_recorder.buffers[0];
+        }
+
+        bool first_busy = first->busy;
+        bool second_busy = second->busy;
+        xSemaphoreGive(s_recorder.lock);
+
+        if (first_busy) {
+            csi_recorder_flush_buffer(first);
+        }
+
+        if (second_busy) {
+            csi_recorder_flush_buffer(second);
+        }
+    }
+}
+
+esp_err_t csi_recorder_init(const csi_recorder_config_t *config)
+{
+    if (!config || !config->partition_label || !config->flush_interval_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_recorder.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, CSI_RECORDER_SUBTYPE,
+                                                                 config->partition_label);
+
+    if (!partition || partition->size < 2 * CSI_RECORDER_SECTOR_SIZE) {
+        ESP_LOGW(TAG, "No '%s' partition, recording is off", config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_recorder.config = *config;
+    s_recorder.partition = partition;
+    s_recorder.sectors = partition->size / CSI_RECORDER_SECTOR_SIZE;
+    s_recorder.stats.sectors = s_recorder.sectors;
+
+    /* Continue the ring after the newest sector, also to wear all sectors alike */
+    for (uint32_t i = 0; i < s_recorder.sectors; i++) {
+        csi_recorder_sector_header_t header;
+
+        if (esp_partition_read(partition, i * CSI_RECORDER_SECTOR_SIZE, &header, sizeof(header)) != ESP_OK
+                || !sector_header_valid(&header)) {
+            continue;
+        }
+
+        if (!s_recorder.stats.used || header.seq >= s_recorder.next_seq) {
+            s_recorder.next_seq = header.seq + 1;
+            s_recorder.next_sector = (i + 1) % s_recorder.sectors;
+            s_recorder.session = header.session;
+        }
+
+        s_recorder.stats.used++;
+    }
+
+    s_recorder.lock = xSemaphoreCreateMutex();
+
+    if (!s_recorder.lock) {
+        goto err;
+    }
+
+    for (int i = 0; i < CSI_RECORDER_BUFFER_NUM; i++) {
+        s_recorder.buffers[i].data = csi_mem_calloc(CSI_MEM_BULK, 1, CSI_RECORDER_SECTOR_SIZE, "csi_recorder");
+
+        if (!s_recorder.buffers[i].data) {
+            goto err;
+        }
+    }
+
+    if (csi_task_create(csi_recorder_task, "csi_recorder", CSI_RECORDER_TASK_STACK, NULL,
+                        CSI_TASK_STAGE_OUTPUT, &s_recorder.task) != ESP_OK) {
+        goto err;
+    }
+
+    ESP_LOGI(TAG, "%lu KB at 0x%lx, %lu of %lu sectors used, next is %lu",
+             (unsigned long)(partition->size / 1024), (unsigned long)partition->address,
+             (unsigned long)s_recorder.stats.used, (unsigned long)s_recorder.sectors,
+             (unsigned long)s_recorder.next_sector);
+    return ESP_OK;
+
+err:
+    ESP_LOGE(TAG, "Failed to allocate the recorder");
+
+    for (int i = 0; i < CSI_RECORDER_BUFFER_NUM; i++) {
+        csi_mem_free(s_recorder.buffers[i].data);
+    }
+    if (s_recorder.lock) {
+        vSemaphoreDelete(s_recorder.lock);
+    }
+    memset(&s_recorder, 0, sizeof(s_recorder));
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t csi_recorder_start(void)
+{
+    if (!s_recorder.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+    if (!s_recorder.running) {
+        s_recorder.session++;
+        s_recorder.running = true;
+    }
+    xSemaphoreGive(s_recorder.lock);
+
+    ESP_LOGI(TAG, "Recording session %u", s_recorder.session);
+    return ESP_OK;
+}
+
+esp_err_t csi_recorder_stop(void)
+{
+    if (!s_recorder.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+    s_recorder.running = false;
+    if (s_recorder.active) {
+        s_recorder.active->closed = true;
+        s_recorder.active = NULL;
+    }
+    xSemaphoreGive(s_recorder.lock);
+
+    xTaskNotifyGive(s_recorder.task);
+
+    for (int i = 0; i < CSI_RECORDER_STOP_WAIT_MS / 10; i++) {
+        xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+        bool busy = s_recorder.buffers[0].busy || s_recorder.buffers[1].busy;
+        xSemaphoreGive(s_recorder.lock);
+
+        if (!busy) {
+            return ESP_OK;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    return ESP_ERR_TIMEOUT;
+}
+
+bool csi_recorder_is_running(void)
+{
+    return s_recorder.running;
+}
+
+void *csi_recorder_begin(csi_recorder_type_t type, size_t max_len, bool *first_of_type)
+{
+    if (!s_recorder.running || max_len > CSI_RECORDER_RECORD_MAX_LEN) {
+        return NULL;
+    }
+
+    xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+
+    if (!s_recorder.running) {
+        xSemaphoreGive(s_recorder.lock);
+        return NULL;
+    }
+
+    csi_recorder_buffer_t *buffer = s_recorder.active;
+
+    if (buffer && buffer->fill + sizeof(csi_recorder_record_header_t) + max_len > CSI_RECORDER_SECTOR_SIZE) {
+        buffer->closed = true;
+        buffer = NULL;
+        s_recorder.active = NULL;
+        xTaskNotifyGive(s_recorder.task);
+    }
+
+    for (int i = 0; !buffer && i < CSI_RECORDER_BUFFER_NUM; i++) {
+        if (s_recorder.buffers[i].busy) {
+            continue;
+        }
+
+        buffer = &s_recorder.buffers[i];
+        buffer->sector = s_recorder.next_sector;
+        buffer->seq = s_recorder.next_seq++;
+        buffer->programmed = 0;
+        buffer->types = 0;
+        buffer->erased = false;
+        buffer->closed = false;
+        buffer->busy = true;
+        s_recorder.next_sector = (s_recorder.next_sector + 1) % s_recorder.sectors;
+        s_recorder.stats.used = MIN(s_recorder.stats.used + 1, s_recorder.sectors);
+        s_recorder.active = buffer;
+
+        const csi_recorder_sector_header_t header = {
+            .magic = CSI_RECORDER_MAGIC,
+            .seq = buffer->seq,
+            .version = CSI_RECORDER_VERSION,
+            .session = s_recorder.session,
+            .reserved = UINT32_MAX,
+        };
+        memset(buffer->data, 0xff, CSI_RECORDER_SECTOR_SIZE);
+        memcpy(buffer->data, &header, sizeof(header));
+        buffer->fill = sizeof(header);
+
+        /* Erase ahead, while the records are still collected in RAM */
+        xTaskNotifyGive(s_recorder.task);
+    }
+
+    if (!buffer) {
+        s_recorder.stats.dropped++;
+        xSemaphoreGive(s_recorder.lock);
+        return NULL;
+    }
+
+    if (first_of_type) {
+        *first_of_type = !(buffer->types & BIT(type));
+    }
+    buffer->types |= BIT(type);
+
+    s_recorder.record = (csi_recorder_record_header_t *)(buffer->data + buffer->fill);
+    s_recorder.record->type = type;
+
+    return s_recorder.record + 1;
+}
+
+void csi_recorder_end(size_t len)
+{
+    csi_recorder_record_header_t *record = s_recorder.record;
+
+    record->seq = s_recorder.record_seq++;
+    record->len = len;
+    record->timestamp = esp_log_timestamp();
+
+    s_recorder.active->fill += sizeof(*record) + len;
+    s_recorder.stats.records++;
+    s_recorder.stats.bytes += sizeof(*record) + len;
+    s_recorder.record = NULL;
+    xSemaphoreGive(s_recorder.lock);
+}
+
+esp_err_t csi_recorder_erase(void)
+{
+    if (!s_recorder.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (s_recorder.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = esp_partition_erase_range(s_recorder.partition, 0, s_recorder.partition->size);
+
+    xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+    s_recorder.stats.erases += s_recorder.sectors;
+    if (ret == ESP_OK) {
+        s_recorder.stats.used = 0;
+    } else {
+        s_recorder.stats.errors++;
+    }
+    xSemaphoreGive(s_recorder.lock);
+
+    return ret;
+}
+
+esp_err_t csi_recorder_read(csi_recorder_read_cb_t cb, void *arg)
+{
+    const void *map = NULL;
+    esp_partition_mmap_handle_t map_handle;
+
+    if (!s_recorder.task || s_recorder.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = esp_partition_mmap(s_recorder.partition, 0, s_recorder.partition->size,
+                                       ESP_PARTITION_MMAP_DATA, &map, &map_handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> esp_partition_mmap", esp_err_to_name(ret));
+        return ret;
+    }
+
+    /* The sector after the newest one is the oldest once the ring wrapped */
+    for (uint32_t i = 0; i < s_recorder.sectors; i++) {
+        uint32_t index = (s_recorder.next_sector + i) % s_recorder.sectors;
+        const uint8_t *data = (const uint8_t *)map + index * CSI_RECORDER_SECTOR_SIZE;
+        const csi_recorder_sector_header_t *header = (const csi_recorder_sector_header_t *)data;
+
+        if (!sector_header_valid(header)) {
+            continue;
+        }
+
+        const csi_recorder_sector_t sector = {
+            .seq = header->seq,
+            .session = header->session,
+            .records = data + sizeof(*header),
+            .len = sector_records_len(data + sizeof(*header), CSI_RECORDER_SECTOR_SIZE - sizeof(*header)),
+        };
+
+        if (sector.len && !cb(&sector, arg)) {
+            break;
+        }
+    }
+
+    esp_partition_munmap(map_handle);
+    return ESP_OK;
+}
+
+void csi_recorder_get_stats(csi_recorder_stats_t *stats)
+{
+    if (!s_recorder.task) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(s_recorder.lock, portMAX_DELAY);
+    *stats = s_recorder.stats;
+    stats->seq = s_recorder.next_seq;
+    stats->session = s_recorder.session;
+    stats->running = s_recorder.running;
+    xSemaphoreGive(s_recorder.lock);
+}
@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_recorder.h
+ * @brief Binary CSI and radar records kept in a flash partition ring
+ *
+ * The partition is used as a ring of 4 KB sectors. Records are written into
+ * one of two sector-sized RAM buffers; a background task erases the flash
+ * sector of a buffer as soon as it is assigned, then programs it in whole
+ * 256-byte pages, at least every flush interval and completely once the
+ * sector is full or the recording stops. Producers therefore never wait for
+ * the flash, and no record costs a flash write of its own. Once the ring is
+ * full the oldest sector is erased next, so every sector wears at the same
+ * rate, also across reboots: the ring continues after the newest sector
+ * found at init.
+ *
+ * A sector, all fields little endian:
+ *
+ *  - csi_recorder_sector_header_t
+ *  - records, each a csi_recorder_record_header_t and len payload bytes,
+ *    until a type of 0xff (erased flash) or the end of the sector
+ *
+ * Payloads of CSI_RECORDER_TYPE_CSI are a csi_recorder_csi_t whose data is
+ * a csi_codec.h record; the first CSI record of every sector is a key
+ * frame, so each sector decodes on its own once older ones are overwritten.
+ * Payloads of CSI_RECORDER_TYPE_RADAR are a csi_recorder_radar_t.
+ *
+ * The readout maps the partition and hands out the records in place, oldest
+ * sector first.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_RECORDER_VERSION        1
+#define CSI_RECORDER_MAGIC          0x52495343  /**< "CSIR" */
+#define CSI_RECORDER_SECTOR_SIZE    4096
+#define CSI_RECORDER_PAGE_SIZE      256
+#define CSI_RECORDER_SUBTYPE        0x40        /**< Data subtype of the partition */
+
+typedef enum {
+    CSI_RECORDER_TYPE_CSI   = 1,
+    CSI_RECORDER_TYPE_RADAR = 2,
+    CSI_RECORDER_TYPE_END   = 0xff,
+} csi_recorder_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t seq;               /**< +1 per sector written, never reset */
+    uint16_t version;
+    uint16_t session;           /**< +1 per csi_recorder_start() */
+    uint32_t reserved;
+} csi_recorder_sector_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;               /**< csi_recorder_type_t */
+    uint8_t seq;                /**< +1 per record */
+    uint16_t len;               /**< Payload bytes */
+    uint32_t timestamp;         /**< esp_log_timestamp() when the record was written, ms */
+} csi_recorder_record_header_t;
+
+#define CSI_RECORDER_RECORD_MAX_LEN (CSI_RECORDER_SECTOR_SIZE - sizeof(csi_recorder_sector_header_t) \
+                                     - sizeof(csi_recorder_record_header_t))
+
+typedef struct __attribute__((packed)) {
+    uint8_t mac[6];
+    int8_t rssi;
+    int8_t noise_floor;
+    uint8_t rate;
+    uint8_t channel;
+    uint8_t secondary_channel;
+    uint8_t agc_gain;
+    uint32_t rx_timestamp;      /**< Local timestamp of the packet, us */
+    uint8_t data[];             /**< csi_codec.h record */
+} csi_recorder_csi_t;
+
+typedef struct __attribute__((packed)) {
+    float waveform_wander;
+    float wander_average;
+    float waveform_jitter;
+    float jitter_median;
+    uint8_t room_status;
+    uint8_t human_status;
+} csi_recorder_radar_t;
+
+typedef struct {
+    const char *partition_label;
+    uint32_t flush_interval_ms; /**< Longest a completed page waits in RAM */
+} csi_recorder_config_t;
+
+#define CSI_RECORDER_CONFIG_DEFAULT() { \
+    .partition_label = "csi_rec", \
+    .flush_interval_ms = 1000, \
+}
+
+typedef struct {
+    uint32_t sectors;           /**< Sectors in the partition */
+    uint32_t used;              /**< Sectors holding records */
+    uint32_t seq;               /**< Sectors started since the partition was erased first */
+    uint16_t session;           /**< Session being recorded, or the last one */
+    bool running;
+    uint32_t records;           /**< Records written since init */
+    uint32_t dropped;           /**< Records dropped because both buffers waited for the flash */
+    uint64_t bytes;             /**< Record bytes written since init */
+    uint32_t page_writes;
+    uint32_t erases;
+    uint32_t errors;            /**< Failed erases and writes, their sector is lost */
+} csi_recorder_stats_t;
+
+typedef struct {
+    uint32_t seq;
+    uint16_t session;
+    const uint8_t *records;     /**< Mapped flash, valid during the callback only */
+    size_t len;
+} csi_recorder_sector_t;
+
+/**
+ * @brief Return false to stop the readout
+ */
+typedef bool (*csi_recorder_read_cb_t)(const csi_recorder_sector_t *sector, void *arg);
+
+/**
+ * @brief Find the partition, the newest sector in it, and start the flash task
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if the partition table has no such partition
+ *      - ESP_ERR_INVALID_STATE if already initialized
+ *      - ESP_ERR_NO_MEM if the buffers or the task could not be allocated
+ */
+esp_err_t csi_recorder_init(const csi_recorder_config_t *config);
+
+/**
+ * @brief Start a new session, its first record opens the sector after the newest one
+ */
+esp_err_t csi_recorder_start(void);
+
+/**
+ * @brief Stop the session and wait until its records are in flash
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_TIMEOUT if the flash task did not finish in time
+ */
+esp_err_t csi_recorder_stop(void);
+
+bool csi_recorder_is_running(void);
+
+/**
+ * @brief Reserve room for one record
+ *
+ * Holds the recorder until csi_recorder_end(), which must follow unless
+ * NULL is returned.
+ *
+ * @param max_len       Upper bound of the payload length
+ * @param first_of_type Set when the sector holds no record of this type yet, may be NULL
+ *
+ * @return Where to write the payload, NULL if the recorder is stopped or the record is dropped
+ */
+void *csi_recorder_begin(csi_recorder_type_t type, size_t max_len, bool *first_of_type);
+
+/**
+ * @brief Commit the record reserved by csi_recorder_begin()
+ *
+ * @param len Payload bytes written, at most max_len
+ */
+void csi_recorder_end(size_t len);
+
+/**
+ * @brief Erase the whole partition, only while stopped
+ */
+esp_err_t csi_recorder_erase(void);
+
+/**
+ * @brief Map the partition and pass every sector holding records to cb, oldest first, only while stopped
+ */
+esp_err_t csi_recorder_read(csi_recorder_read_cb_t cb, void *arg);
+
+void csi_recorder_get_stats(csi_recorder_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -29,79 +29,55 @@
 #include "lwip/netdb.h"
 #include "lwip/sockets.h"
 
-#include "mbedtls/base64.h"
+#include "esp_timer.h"
 #include "esp_radar.h"
 
-#define RX_BUFFER_SIZE              1460
+#include "replay_parser.h"
+#include "csi_task.h"
+
+#define RX_BUFFER_SIZE              4096    /* Holds the longest text record, see REPLAY_FRAME_MAX_LEN */
+#define REPLAY_STATS_INTERVAL_MS    5000
 #define KEEPALIVE_IDLE              1
 #define KEEPALIVE_INTERVAL          1
 #define KEEPALIVE_COUNT             3
-typedef union {
-    struct  {
-        const char *type;
-        const char *id;
-        const char *timestamp;
-        const char *action_id;
-        const char *action;
-        const char *mac;
-        const char *rssi;
-        const char *rate;
-        const char *sig_mode;
-        const char *mcs;
-        const char *bandwidth;
-        const char *smoothing;
-        const char *not_sounding;
-        const char *aggregation;
-        const char *stbc;
-        const char *fec_coding;
-        const char *sgi;
-        const char *noise_floor;
-        const char *ampdu_cnt;
-        const char *channel;
-        const char *secondary_channel;
-        const char *local_timestamp;
-        const char *ant;
-        const char *sig_len;
-        const char *rx_state;
-        const char *len;
-        const char *first_word;
-        const char *data;
-    };
-    const char *data_array[28];
-} csi_data_str_t;
 
 static char *TAG = "radar_evaluate";
 static char g_wifi_radar_cb_ctx[32] = {0};
 static TaskHandle_t g_tcp_server_task_handle = NULL;
+static uint32_t g_replay_push_errors = 0;
 
-static void csi_info_analysis(char *data, size_t size)
-{
-    uint8_t column = 0;
-    const char *s = ",";
-    char *token   = NULL;
-    csi_data_str_t *csi_data = malloc(sizeof(csi_data_str_t));
-
-    token = strtok(data, s);
+extern esp_err_t csi_data_push(wifi_csi_filtered_info_t *info);
 
-    do {
-        csi_data->data_array[column++] = token;
-        token = strtok(NULL, s);
-    } while (token != NULL && column < 28);
+static void replay_record_cb(wifi_csi_filtered_info_t *info, const char *label, void *ctx)
+{
+    strlcpy(g_wifi_radar_cb_ctx, label, sizeof(g_wifi_radar_cb_ctx));
 
-    if (token != NULL) {
-        ESP_LOGE(TAG, "data error, temp_data: %s", data);
+    if (csi_data_push(info) != ESP_OK) {
+        g_replay_push_errors++;
     }
+}
 
-    wifi_csi_filtered_info_t *filtered_info = malloc(sizeof(wifi_csi_filtered_info_t) + 52 * 2);
-    mbedtls_base64_decode((uint8_t *)filtered_info->valid_data, 52 * 2, (size_t *)&filtered_info->valid_len, (uint8_t *)csi_data->data, strlen(csi_data->data));
-    filtered_info->rx_ctrl_info.timestamp = atoi(csi_data->local_timestamp);
-    strcpy(g_wifi_radar_cb_ctx, csi_data->timestamp);
-    // ESP_LOGI(TAG,"count: %s, timestamp: %d", csi_data->id, filtered_info->rx_ctrl.timestamp);
-
-    extern esp_err_t csi_data_push(wifi_csi_filtered_info_t *info);
-    csi_data_push(filtered_info);
-
-    free(csi_data);
+/**
+ * @brief Log the replay rate and decode cost since prev, then update prev
+ */
+static void replay_stats_log(const char *title, const replay_parser_stats_t *stats,
+                             replay_parser_stats_t *prev, int64_t elapsed_us)
+{
+    uint32_t records = stats->records - prev->records;
+    uint64_t decode_us = stats->decode_us - prev->decode_us;
+    uint64_t bytes = stats->bytes - prev->bytes;
+
+    ESP_LOGI(TAG, "%s: %lu records, %.1f records/s, %.1f KB/s, decode avg %lu us max %lu us, "
+             "text %lu, binary %lu, skipped %lu, errors %lu, no_mem %lu, push errors %lu", title,
+             (unsigned long)records, elapsed_us > 0 ? records * 1000000.0f / elapsed_us : 0,
+             elapsed_us > 0 ? bytes * 1000000.0f / 1024 / elapsed_us : 0,
+             records ? (unsigned long)(decode_us / records) : 0, (unsigned long)stats->decode_max_us,
+             (unsigned long)(stats->text_records - prev->text_records),
+             (unsigned long)(stats->binary_records - prev->binary_records),
+             (unsigned long)(stats->skipped - prev->skipped), (unsigned long)(stats->errors - prev->errors),
+             (unsigned long)(stats->no_mem - prev->no_mem), (unsigned long)g_replay_push_errors);
+
+    *prev = *stats;
 }
 
 static void tcp_server_task(void *arg)
@@ -115,6 +91,7 @@ static void tcp_server_task(void *arg)
     int keepCount = KEEPALIVE_COUNT;
     struct sockaddr_storage dest_addr;
     uint32_t port = (uint32_t)arg;
+    replay_parser_t parser = {0};
 
     if (addr_family == AF_INET) {
         struct sockaddr_in *dest_addr_ip4 = (struct sockaddr_in *)&dest_addr;
@@ -124,10 +101,21 @@ static void tcp_server_task(void *arg)
         ip_protocol = IPPROTO_IP;
     }
 
+    esp_err_t ret = replay_parser_init(&parser, RX_BUFFER_SIZE, replay_record_cb, NULL);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "<%s> replay_parser_init", esp_err_to_name(ret));
+        g_tcp_server_task_handle = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+
     int listen_sock = socket(addr_family, SOCK_STREAM, ip_protocol);
 
     if (listen_sock < 0) {
         ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        replay_parser_deinit(&parser);
+        g_tcp_server_task_handle = NULL;
         vTaskDelete(NULL);
         return;
     }
@@ -179,58 +167,43 @@ static void tcp_server_task(void *arg)
         ESP_LOGI(TAG, "Socket accepted ip address: %s", addr_str);
 
         int len;
-        char *rx_buffer = malloc(RX_BUFFER_SIZE);
-        size_t buf_size = 0;
+        replay_parser_reset(&parser);
+        replay_parser_stats_t total = {0};
+        replay_parser_stats_t interval = {0};
+        g_replay_push_errors = 0;
 
         esp_radar_config_t radar_config = {0};
         esp_radar_get_config(&radar_config);
         radar_config.dec_config.wifi_radar_cb_ctx = g_wifi_radar_cb_ctx;
         esp_radar_change_config(&radar_config);
 
+        int64_t start_us = esp_timer_get_time();
+        int64_t report_us = start_us;
+
         do {
-            len = recv(sock, rx_buffer + buf_size, RX_BUFFER_SIZE - buf_size - 1, 0);
+            size_t avail = 0;
+            uint8_t *rx_buffer = replay_parser_get_buffer(&parser, &avail);
+            len = recv(sock, rx_buffer, avail, 0);
 
-            // ESP_LOGW(TAG, "len: %d, rx_buffer: %s", len, rx_buffer);
             if (len < 0) {
                 ESP_LOGE(TAG, "Error occurred during receiving: errno %d", errno);
-
             } else if (len == 0) {
                 ESP_LOGW(TAG, "Connection closed");
             } else {
-                buf_size += len;
-                rx_buffer[buf_size] = 0; // Null-terminate whatever is received and treat it like a string
-                // ESP_LOGI(TAG, "Received %d, buf_size: %d", len, buf_size);
-
-                while (buf_size > 250) {
-                    char *begin = strstr(rx_buffer, "CSI_DATA");
-                    char *end   = strstr(rx_buffer, "\n");
-                    ssize_t size  = end - begin;
-
-                    // ESP_LOGW("TAG", "begin: %p, end: %p, size: %d", begin, end, size);
-                    // ESP_LOGW(TAG, "size: %d, received: %d, buf_size: %d", size, len, buf_size);
-
-                    if (begin && end && size > 250) {
-                        begin[size] = '\0';
-                        csi_info_analysis(begin, size);
-                    }
-
-                    if (end) {
-                        buf_size -= (end + 1 - rx_buffer);
-                        memcpy(rx_buffer, end + 1, buf_size);
-                        memset(rx_buffer + buf_size, 0, end + 1 - rx_buffer);
-                    }
-
-                    if (begin && !end) {
-                        break;
-                    }
-                }
+                replay_parser_commit(&parser, len);
+            }
+
+            int64_t now = esp_timer_get_time();
+            if (now - report_us >= REPLAY_STATS_INTERVAL_MS * 1000) {
+                replay_stats_log("Replay", &parser.stats, &interval, now - report_us);
+                report_us = now;
             }
         } while (len > 0);
 
         shutdown(sock, 0);
         close(sock);
-        free(rx_buffer);
 
+        replay_stats_log("Replay total", &parser.stats, &total, esp_timer_get_time() - start_us);
         ESP_LOGW(TAG, "Socket close: %s", addr_str);
 
         vTaskDelay(pdMS_TO_TICKS(1000));
@@ -241,6 +214,7 @@ static void tcp_server_task(void *arg)
 
 CLEAN_UP:
     close(listen_sock);
+    replay_parser_deinit(&parser);
     g_tcp_server_task_handle = NULL;
     vTaskDelete(NULL);
 }
@@ -248,7 +222,8 @@ CLEAN_UP:
 esp_err_t radar_evaluate_server(uint32_t port)
 {
     if (!g_tcp_server_task_handle) {
-        xTaskCreate(tcp_server_task, "tcp_server", 4 * 1024, (void *)port, 0, &g_tcp_server_task_handle);
+        csi_task_create(tcp_server_task, "tcp_server", 4 * 1024, (void *)port, CSI_TASK_STAGE_BACKGROUND,
+                        &g_tcp_server_task_handle);
     }
 
     return ESP_OK;
@@ -0,0 +1,295 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file replay_parser.c
+ * @brief Streaming parser for recorded CSI traces replayed over TCP
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "esp_timer.h"
+#include "replay_parser.h"
+
+#define REPLAY_TEXT_PREFIX          "CSI_DATA,"
+#define REPLAY_FIELD_TIMESTAMP      2
+#define REPLAY_FIELD_LOCAL_TIME     21
+#define BASE64_INVALID              0xff
+
+static uint8_t s_base64_lut[256];
+
+static void base64_lut_init(void)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    memset(s_base64_lut, BASE64_INVALID, sizeof(s_base64_lut));
+
+    for (int i = 0; i < 64; i++) {
+        s_base64_lut[(uint8_t)alphabet[i]] = i;
+    }
+}
+
+/* Decoded length of src, or -1 if it cannot be base64 */
+static int base64_decoded_len(const uint8_t *src, size_t len)
+{
+    while (len && src[len - 1] == '=') {
+        len--;
+    }
+
+    if (len % 4 == 1) {
+        return -1;
+    }
+
+    return len / 4 * 3 + (len % 4 ? len % 4 - 1 : 0);
+}
+
+/* Decode straight into dst, which holds base64_decoded_len() bytes, false on an invalid character */
+static bool base64_decode(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    while (len && src[len - 1] == '=') {
+        len--;
+    }
+
+    for (; len >= 4; len -= 4, src += 4, dst += 3) {
+        uint8_t a = s_base64_lut[src[0]], b = s_base64_lut[src[1]];
+        uint8_t c = s_base64_lut[src[2]], d = s_base64_lut[src[3]];
+
+        if ((a | b | c | d) & 0xc0) {
+            return false;
+        }
+
+        dst[0] = a << 2 | b >> 4;
+        dst[1] = b << 4 | c >> 2;
+        dst[2] = c << 6 | d;
+    }
+
+    if (len >= 2) {
+        uint8_t a = s_base64_lut[src[0]], b = s_base64_lut[src[1]];
+        uint8_t c = len == 3 ? s_base64_lut[src[2]] : 0;
+
+        if ((a | b | c) & 0xc0) {
+            return false;
+        }
+
+        dst[0] = a << 2 | b >> 4;
+        if (len == 3) {
+            dst[1] = b << 4 | c >> 2;
+        }
+    }
+
+    return true;
+}
+
+static wifi_csi_filtered_info_t *replay_info_alloc(replay_parser_t *parser, size_t len, uint32_t local_timestamp)
+{
+    wifi_csi_filtered_info_t *info = malloc(sizeof(wifi_csi_filtered_info_t) + len);
+
+    if (!info) {
+        parser->stats.no_mem++;
+        return NULL;
+    }
+
+    memset(info, 0, sizeof(wifi_csi_filtered_info_t));
+    info->valid_len = len;
+    info->rx_ctrl_info.timestamp = local_timestamp;
+    return info;
+}
+
+/* Decode one "CSI_DATA,..." line of line_len bytes without its '\n' */
+static wifi_csi_filtered_info_t *replay_parse_line(replay_parser_t *parser, const uint8_t *line, size_t line_len)
+{
+    const uint8_t *end = line + line_len;
+    const uint8_t *field = line;
+    const uint8_t *timestamp = NULL;
+    size_t timestamp_len = 0;
+    uint32_t local_timestamp = 0;
+
+    if (line_len && end[-1] == '\r') {
+        end--;
+    }
+
+    for (int column = 0; column <= REPLAY_FIELD_LOCAL_TIME; column++) {
+        const uint8_t *comma = memchr(field, ',', end - field);
+
+        if (!comma) {
+            parser->stats.errors++;
+            return NULL;
+        }
+
+        if (column == REPLAY_FIELD_TIMESTAMP) {
+            timestamp = field;
+            timestamp_len = comma - field;
+        } else if (column == REPLAY_FIELD_LOCAL_TIME) {
+            for (const uint8_t *p = field; p < comma && *p >= '0' && *p <= '9'; p++) {
+                local_timestamp = local_timestamp * 10 + (*p - '0');
+            }
+        }
+
+        field = comma + 1;
+    }
+
+    /* The data column is the last one, older recordings have fewer columns before it */
+    const uint8_t *data = end;
+    while (data > field && data[-1] != ',') {
+        data--;
+    }
+
+    int len = base64_decoded_len(data, end - data);
+    if (len <= 0 || len > REPLAY_FRAME_MAX_LEN) {
+        parser->stats.errors++;
+        return NULL;
+    }
+
+    wifi_csi_filtered_info_t *info = replay_info_alloc(parser, len, local_timestamp);
+    if (!info) {
+        return NULL;
+    }
+
+    if (!base64_decode((uint8_t *)info->valid_data, data, end - data)) {
+        parser->stats.errors++;
+        free(info);
+        return NULL;
+    }
+
+    timestamp_len = timestamp_len < REPLAY_LABEL_LEN - 1 ? timestamp_len : REPLAY_LABEL_LEN - 1;
+    memcpy(parser->label, timestamp, timestamp_len);
+    parser->label[timestamp_len] = '\0';
+    parser->stats.text_records++;
+    return info;
+}
+
+/* Bytes consumed from buf, 0 if the record is incomplete */
+static size_t replay_parse_record(replay_parser_t *parser, const uint8_t *buf, size_t len,
+                                  wifi_csi_filtered_info_t **info)
+{
+    *info = NULL;
+
+    if (buf[0] == REPLAY_FRAME_MAGIC) {
+        replay_frame_header_t header;
+
+        if (len < sizeof(header)) {
+            return 0;
+        }
+
+        memcpy(&header, buf, sizeof(header));
+
+        /* Not a frame after all, step over the byte and resynchronize on the next record */
+        if (header.version != REPLAY_FRAME_VERSION || !header.len || header.len > REPLAY_FRAME_MAX_LEN) {
+            parser->stats.errors++;
+            return 1;
+        }
+
+        if (len < sizeof(header) + header.len) {
+            return 0;
+        }
+
+        *info = replay_info_alloc(parser, header.len, header.local_timestamp);
+        if (*info) {
+            memcpy((*info)->valid_data, buf + sizeof(header), header.len);
+            snprintf(parser->label, sizeof(parser->label), "%lu", (unsigned long)header.timestamp);
+            parser->stats.binary_records++;
+        }
+
+        return sizeof(header) + header.len;
+    }
+
+    const uint8_t *newline = memchr(buf, '\n', len);
+    if (!newline) {
+        return 0;
+    }
+
+    size_t line_len = newline - buf;
+    if (line_len > strlen(REPLAY_TEXT_PREFIX) && !memcmp(buf, REPLAY_TEXT_PREFIX, strlen(REPLAY_TEXT_PREFIX))) {
+        *info = replay_parse_line(parser, buf, line_len);
+    } else {
+        parser->stats.skipped++;
+    }
+
+    return line_len + 1;
+}
+
+esp_err_t replay_parser_init(replay_parser_t *parser, size_t size, replay_parser_cb_t cb, void *ctx)
+{
+    if (!parser || !cb || size < sizeof(replay_frame_header_t) + REPLAY_FRAME_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(parser, 0, sizeof(replay_parser_t));
+    parser->buf = malloc(size);
+
+    if (!parser->buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    parser->size = size;
+    parser->cb = cb;
+    parser->ctx = ctx;
+    base64_lut_init();
+
+    return ESP_OK;
+}
+
+void replay_parser_deinit(replay_parser_t *parser)
+{
+    free(parser->buf);
+    parser->buf = NULL;
+}
+
+void replay_parser_reset(replay_parser_t *parser)
+{
+    parser->len = 0;
+    memset(&parser->stats, 0, sizeof(parser->stats));
+}
+
+uint8_t *replay_parser_get_buffer(replay_parser_t *parser, size_t *avail)
+{
+    /* Only a record longer than the buffer can fill it, drop it to get going again */
+    if (parser->len == parser->size) {
+        parser->stats.errors++;
+        parser->len = 0;
+    }
+
+    *avail = parser->size - parser->len;
+    return parser->buf + parser->len;
+}
+
+void replay_parser_commit(replay_parser_t *parser, size_t len)
+{
+    size_t pos = 0;
+
+    parser->len += len;
+    parser->stats.bytes += len;
+
+    while (pos < parser->len) {
+        wifi_csi_filtered_info_t *info = NULL;
+        int64_t start = esp_timer_get_time();
+        size_t used = replay_parse_record(parser, parser->buf + pos, parser->len - pos, &info);
+
+        if (!used) {
+            break;
+        }
+
+        pos += used;
+
+        if (info) {
+            uint32_t decode_us = esp_timer_get_time() - start;
+            parser->stats.decode_us += decode_us;
+            if (decode_us > parser->stats.decode_max_us) {
+                parser->stats.decode_max_us = decode_us;
+            }
+
+            parser->stats.records++;
+            parser->cb(info, parser->label, parser->ctx);
+        }
+    }
+
+    parser->len -= pos;
+    if (pos && parser->len) {
+        memmove(parser->buf, parser->buf + pos, parser->len);
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file replay_parser.h
+ * @brief Streaming parser for recorded CSI traces replayed over TCP
+ *
+ * The stream may carry two record formats, freely mixed and told apart by
+ * their first byte:
+ *
+ *  - Text: the CSV lines recorded from the serial port, "CSI_DATA,...\n",
+ *    with the data column base64 encoded. Field 2 (timestamp) becomes the
+ *    label, field 21 (local_timestamp) rx_ctrl_info.timestamp and the last
+ *    field the CSI data. Lines not starting with "CSI_DATA," are skipped.
+ *  - Binary: a replay_frame_header_t followed by len bytes of int8 CSI.
+ *
+ * The socket receives straight into the parser buffer. Complete records are
+ * parsed where they lie, the CSI is decoded directly into the record that is
+ * handed on, and the partial record left at the end of the buffer is moved to
+ * the front once per receive instead of once per line.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_radar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REPLAY_FRAME_MAGIC      0xC5    /**< Not valid ASCII, so it never starts a text line */
+#define REPLAY_FRAME_VERSION    1
+#define REPLAY_FRAME_MAX_LEN    1024    /**< Largest CSI payload accepted, in bytes */
+#define REPLAY_LABEL_LEN        32      /**< Label buffer, including the terminator */
+
+/**
+ * @brief Header of a binary replay record, all fields little endian
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t magic;              /**< REPLAY_FRAME_MAGIC */
+    uint8_t version;            /**< REPLAY_FRAME_VERSION */
+    uint16_t len;               /**< CSI bytes following the header */
+    uint32_t timestamp;         /**< Recording time in ms, used as label like the text timestamp column */
+    uint32_t local_timestamp;   /**< rx_ctrl_info.timestamp of the recorded frame, in us */
+} replay_frame_header_t;
+
+/**
+ * @brief Called for every decoded record
+ *
+ * The callback takes ownership of info, which was allocated with malloc().
+ * label is only valid during the call.
+ */
+typedef void (*replay_parser_cb_t)(wifi_csi_filtered_info_t *info, const char *label, void *ctx);
+
+typedef struct {
+    uint32_t records;           /**< Records handed to the callback */
+    uint32_t text_records;
+    uint32_t binary_records;
+    uint32_t skipped;           /**< Lines that are not CSI records, e.g. the CSV header */
+    uint32_t errors;            /**< Malformed or oversized records, dropped */
+    uint32_t no_mem;            /**< Records dropped because the allocation failed */
+    uint64_t bytes;             /**< Bytes received */
+    uint64_t decode_us;         /**< Time spent parsing and decoding, callback excluded */
+    uint32_t decode_max_us;     /**< Longest parse and decode of one record */
+} replay_parser_stats_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;                 /**< Bytes of an unfinished record at the start of buf */
+    replay_parser_cb_t cb;
+    void *ctx;
+    char label[REPLAY_LABEL_LEN];
+    replay_parser_stats_t stats;
+} replay_parser_t;
+
+/**
+ * @brief Allocate the receive buffer
+ *
+ * @param parser Parser to initialize
+ * @param size   Buffer size, must hold the longest record
+ * @param cb     Receives the decoded records
+ * @param ctx    Passed to cb
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if size cannot hold a binary record of REPLAY_FRAME_MAX_LEN
+ *      - ESP_ERR_NO_MEM if the buffer could not be allocated
+ */
+esp_err_t replay_parser_init(replay_parser_t *parser, size_t size, replay_parser_cb_t cb, void *ctx);
+
+/**
+ * @brief Free the buffer
+ */
+void replay_parser_deinit(replay_parser_t *parser);
+
+/**
+ * @brief Drop a partial record and clear the counters, e.g. for a new connection
+ */
+void replay_parser_reset(replay_parser_t *parser);
+
+/**
+ * @brief Get the free space to receive into
+ *
+ * @param parser Parser
+ * @param avail  Set to the number of bytes that may be written, never 0
+ *
+ * @return Write position inside the parser buffer
+ */
+uint8_t *replay_parser_get_buffer(replay_parser_t *parser, size_t *avail);
+
+/**
+ * @brief Parse the len bytes written to the replay_parser_get_buffer() position
+ *
+ * Calls the callback for every complete record and keeps the rest for the
+ * next call.
+ */
+void replay_parser_commit(replay_parser_t *parser, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -33,6 +33,7 @@ from PyQt5.QtCore import QDate, QDate, QTime, QDateTime
 
 import threading
 import base64
+import struct
 import time
 from datetime import datetime
 from multiprocessing import Process, Queue
@@ -82,6 +83,10 @@ CSI_DATA_TARGETS = ['unknown', 'train', 'none', 'someone', 'static', 'move', 'fr
 RADAR_DATA_COLUMNS_NAMES = ['type', 'seq', 'timestamp',
                             'waveform_wander', 'wander_average', 'waveform_wander_threshold', 'someone_status',
                             'waveform_jitter', 'jitter_midean', 'waveform_jitter_threshold', 'move_status']
+# Motion feature vectors of the features format, see motion_features.h of the csi_kernels component
+CSI_FEATURES_COLUMNS_NAMES = ['type', 'seq', 'timestamp', 'taget_seq', 'taget', 'mac', 'rssi', 'frames',
+                              'motion_energy', 'phase_diff_mean', 'phase_diff_variance', 'waveform_wander',
+                              'waveform_jitter', 'someone_status', 'move_status', 'doppler', 'amp_variance']
 
 g_csi_amplitude_array = np.zeros(
     [CSI_DATA_INDEX, CSI_DATA_COLUMNS], dtype=np.int32)
@@ -188,12 +193,125 @@ def base64_encode_bin(list_data):
     return str_data
 
 
+# Compressed CSI records, see main/csi_codec.h. The data column is '~' and the base64 of the record
+CSI_CODEC_PREFIX = '~'
+CSI_CODEC_VERSION = 1
+CSI_CODEC_FLAG_KEY = 0x01
+CSI_CODEC_FLAG_DELTA = 0x02
+CSI_CODEC_ENCODING_INT8 = 0
+CSI_CODEC_ENCODING_PACKED = 1
+CSI_CODEC_GROUP_LEN = 16
+CSI_CODEC_ENCODING_NIBBLE = 2
+CSI_CODEC_HEADER = struct.Struct('<BBHH')
+
+
+def int8(value):
+    return ((value + 128) & 0xff) - 128
+
+
+class CsiCodecDecoder:
+    """Stateful decoder, one per sender: deltas need the previous record and the selection of the last key"""
+
+    def __init__(self):
+        self.index = None
+        self.reference = None
+        self.sequence = None
+        self.len = 0
+
+    def decode(self, str_data):
+        """Return the CSI as a list of len int8 values, unselected ones 0, or [] until the next key"""
+        try:
+            data = base64.b64decode(str(str_data).strip()[len(CSI_CODEC_PREFIX):], validate=True)
+            return self._decode(data)
+        except Exception as e:
+            print(f'CSI codec: {e}, data: {str(str_data)[:100]}')
+            self.sequence = None
+            return []
+
+    def _decode(self, data):
+        flags, sequence, length, num = CSI_CODEC_HEADER.unpack_from(data)
+        pos = CSI_CODEC_HEADER.size
+
+        if flags >> 5 != CSI_CODEC_VERSION:
+            raise ValueError(f'version {flags >> 5}')
+
+        in_order = self.sequence is not None and sequence == (self.sequence + 1) & 0xff
+        self.sequence = sequence
+
+        if flags & CSI_CODEC_FLAG_KEY:
+            mask_len = data[pos]
+            mask = data[pos + 1:pos + 1 + mask_len]
+            pos += 1 + mask_len
+            self.index = []
+            for i in range(length // 2):
+                if mask[i // 8] & (1 << (i % 8)):
+                    self.index += [2 * i, 2 * i + 1]
+            self.len = length
+            self.reference = [0] * num
+        elif not in_order or self.index is None or length != self.len:
+            # A record went missing, nothing decodes until the next key
+            self.index = None
+            return []
+
+        if len(self.index) != num:
+            raise ValueError(f'{num} values, the key selected {len(self.index)}')
+
+        if not flags & CSI_CODEC_FLAG_DELTA:
+            self.reference = [int8(v) for v in data[pos:pos + num]]
+        else:
+            encoding = (flags >> 2) & 0x3
+            if encoding == CSI_CODEC_ENCODING_NIBBLE:
+                escape = pos + (num + 1) // 2
+                for i in range(num):
+                    nibble = (data[pos + i // 2] >> (4 * (i & 1))) & 0xf
+                    delta = nibble - 16 if nibble & 0x8 else nibble
+                    if delta == -8:
+                        self.reference[i] = int8(data[escape])
+                        escape += 1
+                    else:
+                        self.reference[i] = int8(self.reference[i] + delta)
+            elif encoding == CSI_CODEC_ENCODING_PACKED:
+                for first in range(0, num, CSI_CODEC_GROUP_LEN):
+                    count = min(CSI_CODEC_GROUP_LEN, num - first)
+                    width = data[pos]
+                    size = (count * width + 7) // 8
+                    bits = int.from_bytes(data[pos + 1:pos + 1 + size], 'little')
+                    pos += 1 + size
+                    for i in range(first, first + count):
+                        zigzag = bits & ((1 << width) - 1)
+                        bits >>= width
+                        self.reference[i] = int8(self.reference[i] + ((zigzag >> 1) ^ -(zigzag & 1)))
+            else:
+                for i in range(num):
+                    self.reference[i] = int8(self.reference[i] + data[pos + i])
+
+        csi = [0] * self.len
+        for i, value in zip(self.index, self.reference):
+            csi[i] = value
+        return csi
+
+
+# Binary replay record, see main/replay_parser.h:
+# magic, version, len, timestamp (ms), local_timestamp (us), then len int8 CSI values
+REPLAY_FRAME_MAGIC = 0xC5
+REPLAY_FRAME_VERSION = 1
+REPLAY_FRAME_HEADER = struct.Struct('<BBHII')
+
+
+def replay_frame_pack(data_series, csi_raw_data):
+    data = struct.pack(f'<{len(csi_raw_data)}b', *csi_raw_data)
+    header = REPLAY_FRAME_HEADER.pack(REPLAY_FRAME_MAGIC, REPLAY_FRAME_VERSION, len(data),
+                                      int(data_series['timestamp']) & 0xffffffff,
+                                      int(data_series['local_timestamp']) & 0xffffffff)
+    return header + data
+
+
 def get_label(folder_path):
     parts = str.split(folder_path, os.path.sep)
     return parts[-1]
 
 
-def evaluate_data_send(serial_queue_write, folder_path):
+def evaluate_data_send(serial_queue_write, folder_path, binary=False):
     label = get_label(folder_path)
     if label == 'train':
         command = f'radar --train_start'
@@ -212,6 +330,10 @@ def evaluate_data_send(serial_queue_write, folder_path):
         data_pd = pd.read_csv(file_path)
         for index, data_series in enumerate(data_pd.iloc):
             csi_raw_data = json.loads(data_series['data'])
+            if binary:
+                tcpCliSock.sendall(replay_frame_pack(data_series, csi_raw_data))
+                continue
+
             data_pd.loc[index, 'data'] = base64_encode_bin(csi_raw_data)
             temp_list = base64_decode_bin(data_pd.loc[index, 'data'])
             # print(f"temp_list: {temp_list}")
@@ -232,10 +354,11 @@ def evaluate_data_send(serial_queue_write, folder_path):
 
 
 class DataGraphicalWindow(QMainWindow, Ui_MainWindow):
-    def __init__(self, serial_queue_write, csi_output_type='LLTF', parent=None):
+    def __init__(self, serial_queue_write, csi_output_type='LLTF', csi_output_format='base64', parent=None):
         super(DataGraphicalWindow, self).__init__(parent)
         self.setupUi(self)
         self.csi_output_type = csi_output_type
+        self.csi_output_format = csi_output_format
         global g_display_raw_data
         global g_display_radar_model
         global display_eigenvalues_table
@@ -729,7 +852,7 @@ class DataGraphicalWindow(QMainWindow, Ui_MainWindow):
                 self.model_evaluate_statistics.setItem(row, 2, item)
 
     def command_boot(self):
-        command = f'radar --csi_output_type {self.csi_output_type} --csi_output_format base64'
+        command = f'radar --csi_output_type {self.csi_output_type} --csi_output_format {self.csi_output_format}'
         self.serial_queue_write.put(command)
 
         if self.checkBox_router_auto_connect.isChecked() and len(self.lineEdit_router_ssid.text()) > 0:
@@ -762,7 +885,7 @@ class DataGraphicalWindow(QMainWindow, Ui_MainWindow):
             command = 'wifi_config --disconnect'
             self.serial_queue_write.put(command)
             time.sleep(3)
-            command = 'radar --csi_output_type ' + self.csi_output_type + ' --csi_output_format base64'
+            command = 'radar --csi_output_type ' + self.csi_output_type + ' --csi_output_format ' + self.csi_output_format
             self.serial_queue_write.put(command)
 
         with open('./config/gui_config.json', 'r') as file:
@@ -1125,6 +1248,7 @@ def serial_handle(queue_read, queue_write, port):
     data_valid_list = pd.DataFrame(columns=['type', 'columns_names', 'file_name', 'file_fd', 'file_writer'],
                                    data=[['CSI_DATA', CSI_DATA_COLUMNS_NAMES, 'log/csi_data.csv', None, None],
                                          ['RADAR_DADA', RADAR_DATA_COLUMNS_NAMES, 'log/radar_data.csv', None, None],
+                                         ['CSI_FEATURES', CSI_FEATURES_COLUMNS_NAMES, 'log/csi_features.csv', None, None],
                                          ['DEVICE_INFO', DEVICE_INFO_COLUMNS_NAMES, 'log/device_info.csv', None, None]])
 
     for data_valid in data_valid_list.iloc:
@@ -1135,6 +1259,7 @@ def serial_handle(queue_read, queue_write, port):
         data_valid['file_writer'].writerow(data_valid['columns_names'])
 
     log_data_writer = open('log/log_data.txt', 'w+')
+    codec_decoders = {}
     taget_last = 'unknown'
     taget_seq_last = 0
 
@@ -1223,8 +1348,12 @@ def serial_handle(queue_read, queue_write, port):
                     if data_series['type'] == 'CSI_DATA':
                         try:
                             # csi_raw_data = json.loads(data_series['data'])
-                            csi_raw_data = base64_decode_bin(
-                                data_series['data'])
+                            if str(data_series['data']).startswith(CSI_CODEC_PREFIX):
+                                decoder = codec_decoders.setdefault(data_series['mac'], CsiCodecDecoder())
+                                csi_raw_data = decoder.decode(data_series['data'])
+                            else:
+                                csi_raw_data = base64_decode_bin(
+                                    data_series['data'])
                             # 如果解码失败返回空列表，跳过这条数据
                             if len(csi_raw_data) == 0:
                                 print(f"CSI_DATA decode failed, skipping data: {data_series['data'][:50]}...")
@@ -1305,10 +1434,15 @@ if __name__ == '__main__':
     parser.add_argument('-t', '--csi_output_type', dest='csi_output_type', action='store',
                         choices=['LLTF', 'HT_LTF', 'HE_LTF', 'STBC-HT-LTF', 'STBC-HE-LTF'], default='LLTF',
                         help='CSI output type: LLTF, HT_LTF, HE_LTF, STBC-HT-LTF, or STBC-HE-LTF (default: LLTF)')
+    parser.add_argument('-f', '--csi_output_format', dest='csi_output_format', action='store',
+                        choices=['base64', 'compressed', 'features'], default='base64',
+                        help='CSI output format: base64, compressed with the csi_codec settings of the device, '
+                             'or features for motion feature vectors instead of the CSI (default: base64)')
 
     args = parser.parse_args()
     serial_port = args.port
     csi_output_type = args.csi_output_type
+    csi_output_format = args.csi_output_format
 
     serial_queue_read = Queue(maxsize=64)
     serial_queue_write = Queue(maxsize=64)
@@ -1323,7 +1457,7 @@ if __name__ == '__main__':
     app = QApplication(sys.argv)
     app.setWindowIcon(QIcon('../../../docs/_static/icon.png'))
 
-    window = DataGraphicalWindow(serial_queue_write, csi_output_type)
+    window = DataGraphicalWindow(serial_queue_write, csi_output_type, csi_output_format)
     data_handle_thread = DataHandleThread(serial_queue_read)
     data_handle_thread.signal_device_info.connect(window.show_device_info)
     data_handle_thread.signal_log_msg.connect(window.show_textBrowser_log)
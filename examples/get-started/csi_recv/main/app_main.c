@@ -15,6 +15,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <sys/param.h>
 
 #include "nvs_flash.h"
 
@@ -26,6 +28,12 @@
 #include "esp_now.h"
 #include "esp_csi_gain_ctrl.h"
 
+#include "csi_record.h"
+#include "csi_unpack.h"
+#include "csi_link_table.h"
+#include "csi_gain_track.h"
+#include "csi_gain_baseline.h"
+
 #define CONFIG_LESS_INTERFERENCE_CHANNEL   11
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61 || (CONFIG_IDF_TARGET_ESP32C6 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0))
 #define CONFIG_WIFI_BAND_MODE               WIFI_BAND_MODE_2G_ONLY
@@ -41,6 +49,15 @@
 #define CONFIG_ESP_NOW_RATE             WIFI_PHY_RATE_MCS0_LGI
 #define CONFIG_FORCE_GAIN                   0
 
+/**
+ * @brief CSI_OUTPUT_FORMAT_TEXT prints one CSV line per packet,
+ *        CSI_OUTPUT_FORMAT_BINARY writes a compact csi_record_header_t + raw CSI record,
+ *        decode it with `tools/csi_data_read_parse.py --format binary`
+ */
+#define CSI_OUTPUT_FORMAT_TEXT              0
+#define CSI_OUTPUT_FORMAT_BINARY            1
+#define CONFIG_CSI_OUTPUT_FORMAT            CSI_OUTPUT_FORMAT_TEXT
+
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61
 #define CSI_FORCE_LLTF                      0
 #endif
@@ -53,8 +70,40 @@
 #define ESP_IF_WIFI_STA ESP_MAC_WIFI_STA
 #endif
 
-static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
+/**
+ * @brief Drop the packets received while the AGC jumps, their amplitude is not comparable
+ *        with their neighbours'. The seq gap shows them to the host
+ */
+#define CONFIG_GAIN_SKIP_JUMPS              1
+
+/**
+ * @brief Transmitters received from, one link each. csi_send with CONFIG_CSI_SEND_INDEX n
+ *        uses {0x1a, 0x00, 0x00, 0x00, 0x00, n}. At most CSI_LINK_TABLE_MAX.
+ */
+static const uint8_t CONFIG_CSI_SEND_MAC[][6] = {
+    {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00},
+};
+#define CONFIG_CSI_SEND_NUM                 (sizeof(CONFIG_CSI_SEND_MAC) / sizeof(CONFIG_CSI_SEND_MAC[0]))
+
+/**
+ * @brief State of one transmitter, each link tracks its own gain baseline
+ */
+typedef struct {
+    uint32_t count;                 /**< Packets received from the transmitter */
+#if CONFIG_GAIN_CONTROL
+    csi_gain_track_t gain_track;
+    float baseline_compensation;    /**< Compensation of the baseline gains, 0 until the baseline is set */
+    uint32_t skipped;               /**< Packets dropped for a gain jump since the last baseline */
+#endif
+} csi_link_t;
+
 static const char *TAG = "csi_recv";
+static csi_link_table_t s_link_table;
+static csi_link_t s_links[CSI_LINK_TABLE_MAX];
+#if CONFIG_GAIN_CONTROL
+/* Only used by the CSI callback */
+static csi_gain_baseline_t s_gain_baseline;
+#endif
 
 static void wifi_init()
 {
@@ -116,7 +165,7 @@ static void wifi_init()
     }
 #endif
 
-    ESP_ERROR_CHECK(esp_wifi_set_mac(WIFI_IF_STA, CONFIG_CSI_SEND_MAC));
+    ESP_ERROR_CHECK(esp_wifi_set_mac(WIFI_IF_STA, CONFIG_CSI_SEND_MAC[0]));
 }
 
 static void wifi_esp_now_init(esp_now_peer_info_t peer)
@@ -141,33 +190,67 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
         return;
     }
 
-    if (memcmp(info->mac, CONFIG_CSI_SEND_MAC, 6)) {
+    int link_index = csi_link_table_find(&s_link_table, info->mac);
+    if (link_index == CSI_LINK_NONE) {
         return;
     }
 
+    csi_link_t *link = &s_links[link_index];
     const wifi_pkt_rx_ctrl_t *rx_ctrl = &info->rx_ctrl;
     static int s_count = 0;
     float compensate_gain = 1.0f;
-    static uint8_t agc_gain = 0;
-    static int8_t fft_gain = 0;
+    uint8_t agc_gain = 0;
+    int8_t fft_gain = 0;
 #if CONFIG_GAIN_CONTROL
-    static uint8_t agc_gain_baseline = 0;
-    static int8_t fft_gain_baseline = 0;
     esp_csi_gain_ctrl_get_rx_gain(rx_ctrl, &agc_gain, &fft_gain);
-    if (s_count < 100) {
-        esp_csi_gain_ctrl_record_rx_gain(agc_gain, fft_gain);
-    } else if (s_count == 100) {
-        esp_csi_gain_ctrl_get_rx_gain_baseline(&agc_gain_baseline, &fft_gain_baseline);
+    csi_gain_track_t *gain_track = &link->gain_track;
+    /* Shared by all links and fixed at the first baseline of any, the per-link division below cancels it */
+    csi_gain_baseline_record(&s_gain_baseline, agc_gain, fft_gain);
+
+    uint32_t gain_flags = csi_gain_track_push(gain_track, agc_gain, fft_gain);
+    if (gain_flags & CSI_GAIN_TRACK_FLAG_REBASELINE) {
+        csi_gain_baseline_lock(&s_gain_baseline);
+        esp_csi_gain_ctrl_get_gain_compensation(&link->baseline_compensation, gain_track->agc_gain_baseline,
+                                                gain_track->fft_gain_baseline);
+        ESP_LOGI(TAG, "link %d " MACSTR ", baseline %d, agc_gain_baseline %d, fft_gain_baseline %d, skipped %" PRIu32,
+                 link_index, MAC2STR(info->mac), gain_track->seq, gain_track->agc_gain_baseline,
+                 gain_track->fft_gain_baseline, link->skipped);
+        link->skipped = 0;
 #if CONFIG_FORCE_GAIN
-        esp_csi_gain_ctrl_set_rx_force_gain(agc_gain_baseline, fft_gain_baseline);
-        ESP_LOGD(TAG, "fft_force %d, agc_force %d", fft_gain_baseline, agc_gain_baseline);
+        /* The forced gain applies to the radio, so only to a single transmitter */
+        if (CONFIG_CSI_SEND_NUM == 1) {
+            esp_csi_gain_ctrl_set_rx_force_gain(gain_track->agc_gain_baseline, gain_track->fft_gain_baseline);
+            ESP_LOGD(TAG, "fft_force %d, agc_force %d", gain_track->fft_gain_baseline, gain_track->agc_gain_baseline);
+        }
 #endif
     }
-    esp_csi_gain_ctrl_get_gain_compensation(&compensate_gain, agc_gain, fft_gain);
-    ESP_LOGI(TAG, "compensate_gain %f, agc_gain %d, fft_gain %d", compensate_gain, agc_gain, fft_gain);
+
+    if (CONFIG_GAIN_SKIP_JUMPS && (gain_flags & CSI_GAIN_TRACK_FLAG_JUMP)) {
+        link->skipped++;
+        link->count++;
+        return;
+    }
+
+    /* Relative to the baseline of the link, whatever the baseline of the gain control component */
+    if (link->baseline_compensation > 0) {
+        esp_csi_gain_ctrl_get_gain_compensation(&compensate_gain, agc_gain, fft_gain);
+        compensate_gain /= link->baseline_compensation;
+    }
+    ESP_LOGD(TAG, "compensate_gain %f, agc_gain %d, fft_gain %d", compensate_gain, agc_gain, fft_gain);
 #endif
+    link->count++;
 
     uint32_t rx_id = *(uint32_t *)(info->payload + 15);
+#if CONFIG_CSI_OUTPUT_FORMAT == CSI_OUTPUT_FORMAT_BINARY
+#if (CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61) && CSI_FORCE_LLTF
+    csi_record_output(rx_id, info, fft_gain, agc_gain, compensate_gain, true);
+#else
+    csi_record_output(rx_id, info, fft_gain, agc_gain, compensate_gain, false);
+#endif
+    s_count++;
+    return;
+#endif
+
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C6 || CONFIG_IDF_TARGET_ESP32C61
     if (!s_count) {
         ESP_LOGI(TAG, "================ CSI RECV ================");
@@ -192,19 +275,21 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
                rx_ctrl->timestamp, rx_ctrl->ant, rx_ctrl->sig_len, rx_ctrl->rx_state);
 
 #endif
+    /* Only called from the Wi-Fi task, one buffer is enough */
+    static int16_t s_samples[CSI_RECORD_MAX_DATA_LEN];
+    int32_t gain_q16 = csi_unpack_gain_q16(compensate_gain);
+    uint16_t len = MIN(info->len, CSI_RECORD_MAX_DATA_LEN);
+
 #if (CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61) && CSI_FORCE_LLTF
-    int16_t csi = ((int16_t)(((((uint16_t)info->buf[1]) << 8) | info->buf[0]) << 4) >> 4);
-    ets_printf(",%d,%d,\"[%d", (info->len - 2) / 2, info->first_word_invalid, (int16_t)(compensate_gain * csi));
-    for (int i = 2; i < (info->len - 2); i += 2) {
-        csi = ((int16_t)(((((uint16_t)info->buf[i + 1]) << 8) | info->buf[i]) << 4) >> 4);
-        ets_printf(",%d", (int16_t)(compensate_gain * csi));
-    }
+    uint16_t num = csi_unpack_lltf12(s_samples, info->buf, len, gain_q16);
 #else
-    ets_printf(",%d,%d,\"[%d", info->len, info->first_word_invalid, (int16_t)(compensate_gain * info->buf[0]));
-    for (int i = 1; i < info->len; i++) {
-        ets_printf(",%d", (int16_t)(compensate_gain * info->buf[i]));
-    }
+    uint16_t num = csi_unpack_int8(s_samples, info->buf, len, gain_q16);
 #endif
+
+    ets_printf(",%d,%d,\"[", num, info->first_word_invalid);
+    for (int i = 0; i < num; i++) {
+        ets_printf(i ? ",%d" : "%d", s_samples[i]);
+    }
     ets_printf("]\"\n");
     s_count++;
 }
@@ -258,6 +343,19 @@ static void wifi_csi_init()
     };
 #endif
     ESP_ERROR_CHECK(esp_wifi_set_csi_config(&csi_config));
+
+    csi_link_table_init(&s_link_table);
+    for (int i = 0; i < CONFIG_CSI_SEND_NUM; i++) {
+        ESP_ERROR_CHECK(csi_link_table_add(&s_link_table, CONFIG_CSI_SEND_MAC[i], NULL));
+        ESP_LOGI(TAG, "link %d, transmitter " MACSTR, i, MAC2STR(CONFIG_CSI_SEND_MAC[i]));
+#if CONFIG_GAIN_CONTROL
+        csi_gain_track_init(&s_links[i].gain_track, NULL);
+#endif
+    }
+
+#if CONFIG_CSI_OUTPUT_FORMAT == CSI_OUTPUT_FORMAT_BINARY
+    ESP_ERROR_CHECK(csi_record_output_init());
+#endif
     ESP_ERROR_CHECK(esp_wifi_set_csi_rx_cb(wifi_csi_rx_cb, NULL));
     ESP_ERROR_CHECK(esp_wifi_set_csi(true));
 }
@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -35,12 +37,58 @@
 #include "protocol_examples_common.h"
 #include "esp_csi_gain_ctrl.h"
 
+#include "csi_record.h"
+#include "csi_stream.h"
+#include "csi_unpack.h"
+#include "csi_gain_track.h"
+#include "csi_gain_baseline.h"
+#include "excitation.h"
+
 #define CONFIG_SEND_FREQUENCY      100
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61
 #define CSI_FORCE_LLTF                      0
 #endif
 #define CONFIG_FORCE_GAIN                   0
 
+/**
+ * @brief Drop the packets received while the AGC jumps, their amplitude is not comparable
+ *        with their neighbours'. The seq gap shows them to the host
+ */
+#define CONFIG_GAIN_SKIP_JUMPS              1
+
+/**
+ * @brief Lower the ping rate to CONFIG_EXCITATION_FLOOR_HZ while the CSI stays static,
+ *        back to CONFIG_SEND_FREQUENCY as soon as it changes, see excitation.h
+ */
+#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61
+#define CONFIG_EXCITATION_ADAPTIVE          !CSI_FORCE_LLTF /* The change is computed on int8 pairs */
+#else
+#define CONFIG_EXCITATION_ADAPTIVE          1
+#endif
+#define CONFIG_EXCITATION_FLOOR_HZ          10
+#define CONFIG_EXCITATION_HOLD_MS           (30 * 1000)
+#define CONFIG_EXCITATION_DECAY_MS          (10 * 1000)
+#define CONFIG_EXCITATION_UPDATE_MS         500
+#define CONFIG_EXCITATION_SUBCARRIER_NUM    64
+#define CONFIG_EXCITATION_MOTION_THRESHOLD  0.25f   /**< Relative amplitude change between two frames, tune for the room */
+
+/**
+ * @brief CSI_OUTPUT_FORMAT_TEXT prints one CSV line per packet,
+ *        CSI_OUTPUT_FORMAT_BINARY writes a compact csi_record_header_t + raw CSI record,
+ *        decode it with `tools/csi_data_read_parse.py --format binary`,
+ *        CSI_OUTPUT_FORMAT_NETWORK streams the same records in batches to CONFIG_CSI_STREAM_HOST,
+ *        receive them with `tools/csi_stream_collect.py`
+ */
+#define CSI_OUTPUT_FORMAT_TEXT              0
+#define CSI_OUTPUT_FORMAT_BINARY            1
+#define CSI_OUTPUT_FORMAT_NETWORK           2
+#define CONFIG_CSI_OUTPUT_FORMAT            CSI_OUTPUT_FORMAT_TEXT
+
+#define CONFIG_CSI_STREAM_TRANSPORT         CSI_STREAM_TRANSPORT_UDP
+#define CONFIG_CSI_STREAM_HOST              "192.168.1.100"
+#define CONFIG_CSI_STREAM_PORT              5566
+#define CONFIG_CSI_STREAM_QUEUE_LEN         16      /**< Records waiting to be sent, power of two, ~1 KB each */
+
 #if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32C3 || CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C6 || CONFIG_IDF_TARGET_ESP32C61
 #define CONFIG_GAIN_CONTROL                 1
 #endif
@@ -50,6 +98,14 @@
 #endif
 
 static const char *TAG = "csi_recv_router";
+static volatile bool s_excitation_motion = false;
+#if CONFIG_GAIN_CONTROL
+/* Only used by the CSI callback */
+static csi_gain_track_t s_gain_track;
+static csi_gain_baseline_t s_gain_baseline;
+static float s_baseline_compensation = 0;  /**< Compensation of the baseline gains, 0 until the baseline is set */
+static uint32_t s_gain_skipped = 0;         /**< Packets dropped for a gain jump since the last baseline */
+#endif
 
 static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 {
@@ -62,28 +118,72 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
         return;
     }
 
+#if CONFIG_EXCITATION_ADAPTIVE
+    static uint16_t s_amplitude[CONFIG_EXCITATION_SUBCARRIER_NUM] = {0};
+
+    if (excitation_csi_change(info->buf, info->len, s_amplitude, CONFIG_EXCITATION_SUBCARRIER_NUM)
+            > CONFIG_EXCITATION_MOTION_THRESHOLD) {
+        s_excitation_motion = true;
+    }
+#endif
+
     const wifi_pkt_rx_ctrl_t *rx_ctrl = &info->rx_ctrl;
     static int s_count = 0;
     float compensate_gain = 1.0f;
-    static uint8_t agc_gain = 0;
-    static int8_t fft_gain = 0;
+    uint8_t agc_gain = 0;
+    int8_t fft_gain = 0;
 #if CONFIG_GAIN_CONTROL
-    static uint8_t agc_gain_baseline = 0;
-    static int8_t fft_gain_baseline = 0;
     esp_csi_gain_ctrl_get_rx_gain(rx_ctrl, &agc_gain, &fft_gain);
-    if (s_count < 100) {
-        esp_csi_gain_ctrl_record_rx_gain(agc_gain, fft_gain);
-    } else if (s_count == 100) {
-        esp_csi_gain_ctrl_get_rx_gain_baseline(&agc_gain_baseline, &fft_gain_baseline);
+    /* Fixed at our first baseline, the division below cancels it */
+    csi_gain_baseline_record(&s_gain_baseline, agc_gain, fft_gain);
+
+    uint32_t gain_flags = csi_gain_track_push(&s_gain_track, agc_gain, fft_gain);
+    if (gain_flags & CSI_GAIN_TRACK_FLAG_REBASELINE) {
+        csi_gain_baseline_lock(&s_gain_baseline);
+        esp_csi_gain_ctrl_get_gain_compensation(&s_baseline_compensation, s_gain_track.agc_gain_baseline,
+                                                s_gain_track.fft_gain_baseline);
+        ESP_LOGI(TAG, "gain baseline %d, agc_gain_baseline %d, fft_gain_baseline %d, skipped %" PRIu32,
+                 s_gain_track.seq, s_gain_track.agc_gain_baseline, s_gain_track.fft_gain_baseline, s_gain_skipped);
+        s_gain_skipped = 0;
 #if CONFIG_FORCE_GAIN
-        esp_csi_gain_ctrl_set_rx_force_gain(agc_gain_baseline, fft_gain_baseline);
-        ESP_LOGI(TAG, "fft_force %d, agc_force %d", fft_gain_baseline, agc_gain_baseline);
+        esp_csi_gain_ctrl_set_rx_force_gain(s_gain_track.agc_gain_baseline, s_gain_track.fft_gain_baseline);
+        ESP_LOGI(TAG, "fft_force %d, agc_force %d", s_gain_track.fft_gain_baseline, s_gain_track.agc_gain_baseline);
 #endif
     }
-    esp_csi_gain_ctrl_get_gain_compensation(&compensate_gain, agc_gain, fft_gain);
+
+    /* A skipped packet still takes its sequence number, the host sees the gap */
+    if (CONFIG_GAIN_SKIP_JUMPS && (gain_flags & CSI_GAIN_TRACK_FLAG_JUMP)) {
+        s_gain_skipped++;
+        s_count++;
+        return;
+    }
+
+    if (s_baseline_compensation > 0) {
+        esp_csi_gain_ctrl_get_gain_compensation(&compensate_gain, agc_gain, fft_gain);
+        compensate_gain /= s_baseline_compensation;
+    }
     ESP_LOGD(TAG, "compensate_gain %f, agc_gain %d, fft_gain %d", compensate_gain, agc_gain, fft_gain);
 #endif
 
+#if CONFIG_CSI_OUTPUT_FORMAT == CSI_OUTPUT_FORMAT_BINARY
+#if (CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61) && CSI_FORCE_LLTF
+    csi_record_output(s_count, info, fft_gain, agc_gain, compensate_gain, true);
+#else
+    csi_record_output(s_count, info, fft_gain, agc_gain, compensate_gain, false);
+#endif
+    s_count++;
+    return;
+#elif CONFIG_CSI_OUTPUT_FORMAT == CSI_OUTPUT_FORMAT_NETWORK
+    /* A shed record still takes its sequence number, the collector sees the gap */
+#if (CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61) && CSI_FORCE_LLTF
+    csi_stream_record(s_count, info, fft_gain, agc_gain, compensate_gain, true);
+#else
+    csi_stream_record(s_count, info, fft_gain, agc_gain, compensate_gain, false);
+#endif
+    s_count++;
+    return;
+#endif
+
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C6 || CONFIG_IDF_TARGET_ESP32C61
     if (!s_count) {
         ESP_LOGI(TAG, "================ CSI RECV ================");
@@ -106,21 +206,21 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
                rx_ctrl->timestamp, rx_ctrl->ant, rx_ctrl->sig_len, rx_ctrl->rx_state);
 #endif
 
-#if (CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61) && CSI_FORCE_LLTF
-
-    int16_t csi = ((int16_t)(((((uint16_t)info->buf[1]) << 8) | info->buf[0]) << 4) >> 4);
-    ets_printf(",%d,%d,\"[%d", (info->len - 2) / 2, info->first_word_invalid, (int16_t)(compensate_gain * csi));
-    for (int i = 2; i < (info->len - 2); i += 2) {
-        csi = ((int16_t)(((((uint16_t)info->buf[i + 1]) << 8) | info->buf[i]) << 4) >> 4);
-        ets_printf(",%d", (int16_t)(compensate_gain * csi));
-    }
+    /* Only called from the Wi-Fi task, one buffer is enough */
+    static int16_t s_samples[CSI_RECORD_MAX_DATA_LEN];
+    int32_t gain_q16 = csi_unpack_gain_q16(compensate_gain);
+    uint16_t len = MIN(info->len, CSI_RECORD_MAX_DATA_LEN);
 
+#if (CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61) && CSI_FORCE_LLTF
+    uint16_t num = csi_unpack_lltf12(s_samples, info->buf, len, gain_q16);
 #else
-    ets_printf(",%d,%d,\"[%d", info->len, info->first_word_invalid, (int16_t)(compensate_gain * info->buf[0]));
-    for (int i = 1; i < info->len; i++) {
-        ets_printf(",%d", (int16_t)(compensate_gain * info->buf[i]));
-    }
+    uint16_t num = csi_unpack_int8(s_samples, info->buf, len, gain_q16);
 #endif
+
+    ets_printf(",%d,%d,\"[", num, info->first_word_invalid);
+    for (int i = 0; i < num; i++) {
+        ets_printf(i ? ",%d" : "%d", s_samples[i]);
+    }
     ets_printf("]\"\n");
     s_count++;
 }
@@ -176,17 +276,37 @@ static void wifi_csi_init()
     static wifi_ap_record_t s_ap_info = {0};
     ESP_ERROR_CHECK(esp_wifi_sta_get_ap_info(&s_ap_info));
     ESP_ERROR_CHECK(esp_wifi_set_csi_config(&csi_config));
+#if CONFIG_CSI_OUTPUT_FORMAT == CSI_OUTPUT_FORMAT_BINARY
+    ESP_ERROR_CHECK(csi_record_output_init());
+#elif CONFIG_CSI_OUTPUT_FORMAT == CSI_OUTPUT_FORMAT_NETWORK
+    csi_stream_config_t stream_config = CSI_STREAM_CONFIG_DEFAULT(CONFIG_CSI_STREAM_HOST, CONFIG_CSI_STREAM_PORT);
+    stream_config.transport = CONFIG_CSI_STREAM_TRANSPORT;
+    stream_config.queue_len = CONFIG_CSI_STREAM_QUEUE_LEN;
+    ESP_ERROR_CHECK(csi_stream_init(&stream_config));
+#endif
+#if CONFIG_GAIN_CONTROL
+    csi_gain_track_init(&s_gain_track, NULL);
+#endif
     ESP_ERROR_CHECK(esp_wifi_set_csi_rx_cb(wifi_csi_rx_cb, s_ap_info.bssid));
     ESP_ERROR_CHECK(esp_wifi_set_csi(true));
 }
 
-static esp_err_t wifi_ping_router_start()
+/**
+ * @brief Ping the gateway to excite CSI, a running session is replaced
+ */
+static esp_err_t wifi_ping_router_start(uint32_t interval_ms)
 {
     static esp_ping_handle_t ping_handle = NULL;
 
+    if (ping_handle) {
+        esp_ping_stop(ping_handle);
+        esp_ping_delete_session(ping_handle);
+        ping_handle = NULL;
+    }
+
     esp_ping_config_t ping_config = ESP_PING_DEFAULT_CONFIG();
     ping_config.count             = 0;
-    ping_config.interval_ms       = 1000 / CONFIG_SEND_FREQUENCY;
+    ping_config.interval_ms       = interval_ms;
     ping_config.task_stack_size   = 3072;
     ping_config.data_size         = 1;
 
@@ -203,6 +323,35 @@ static esp_err_t wifi_ping_router_start()
     return ESP_OK;
 }
 
+#if CONFIG_EXCITATION_ADAPTIVE
+/**
+ * @brief Follow the motion seen in the CSI with the ping rate
+ */
+static void excitation_task(void *arg)
+{
+    excitation_config_t config = EXCITATION_CONFIG_DEFAULT();
+    config.floor_hz   = CONFIG_EXCITATION_FLOOR_HZ;
+    config.ceiling_hz = CONFIG_SEND_FREQUENCY;
+    config.hold_ms    = CONFIG_EXCITATION_HOLD_MS;
+    config.decay_ms   = CONFIG_EXCITATION_DECAY_MS;
+
+    excitation_t exc = {0};
+    excitation_init(&exc, &config, esp_log_timestamp());
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_EXCITATION_UPDATE_MS));
+
+        bool motion = s_excitation_motion;
+        s_excitation_motion = false;
+
+        if (excitation_update(&exc, motion, esp_log_timestamp())) {
+            ESP_LOGI(TAG, "excitation rate: %u Hz", excitation_rate_hz(&exc));
+            wifi_ping_router_start(excitation_interval_ms(&exc));
+        }
+    }
+}
+#endif
+
 void app_main()
 {
     ESP_ERROR_CHECK(nvs_flash_init());
@@ -217,5 +366,9 @@ void app_main()
     ESP_ERROR_CHECK(example_connect());
 
     wifi_csi_init();
-    wifi_ping_router_start();
+    wifi_ping_router_start(1000 / CONFIG_SEND_FREQUENCY);
+
+#if CONFIG_EXCITATION_ADAPTIVE
+    xTaskCreate(excitation_task, "excitation", 3072, NULL, tskIDLE_PRIORITY + 2, NULL);
+#endif
 }
@@ -0,0 +1,291 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_stream.c
+ * @brief Binary CSI records batched into datagrams and streamed to a collector over UDP or TCP
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+
+#include "csi_frame_ring.h"
+#include "csi_task.h"
+#include "csi_record.h"
+#include "csi_stream.h"
+
+#define CSI_STREAM_TASK_STACK       4096
+#define CSI_STREAM_SEND_TIMEOUT_MS  5000    /* A TCP write stalled this long closes the connection */
+#define CSI_STREAM_LOG_INTERVAL_MS  10000   /* Shortest time between two logs of new losses */
+
+_Static_assert(sizeof(csi_stream_header_t) + CSI_RECORD_MAX_LEN <= CSI_STREAM_BATCH_MAX,
+               "The largest record must fit a batch on its own");
+
+static const char *TAG = "csi_stream";
+
+static csi_stream_config_t s_config;
+static csi_frame_ring_t s_ring;
+static bool s_started;
+static int s_sock = -1;
+static uint8_t s_batch[CSI_STREAM_BATCH_MAX];
+static size_t s_batch_len;
+static TickType_t s_batch_start;
+static uint32_t s_batch_seq;
+static uint32_t s_reported_losses;
+static uint32_t s_reported_ms;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static csi_stream_stats_t s_stats;
+
+static void csi_stream_close(void)
+{
+    if (s_sock >= 0) {
+        close(s_sock);
+        s_sock = -1;
+    }
+}
+
+static esp_err_t csi_stream_connect(void)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = s_config.transport == CSI_STREAM_TRANSPORT_TCP ? SOCK_STREAM : SOCK_DGRAM,
+    };
+    struct addrinfo *res = NULL;
+    char port[8];
+
+    snprintf(port, sizeof(port), "%u", s_config.port);
+
+    int ret = getaddrinfo(s_config.host, port, &hints, &res);
+    if (ret != 0 || !res) {
+        ESP_LOGW(TAG, "Cannot resolve %s, error %d", s_config.host, ret);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_sock = socket(res->ai_family, res->ai_socktype, 0);
+    if (s_sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        freeaddrinfo(res);
+        return ESP_FAIL;
+    }
+
+    /* A connected UDP socket takes send() and reports an unreachable collector */
+    if (connect(s_sock, res->ai_addr, res->ai_addrlen) != 0) {
+        ESP_LOGW(TAG, "Cannot connect to %s:%u: errno %d", s_config.host, s_config.port, errno);
+        freeaddrinfo(res);
+        csi_stream_close();
+        return ESP_FAIL;
+    }
+    freeaddrinfo(res);
+
+    if (s_config.transport == CSI_STREAM_TRANSPORT_TCP) {
+        struct timeval timeout = {
+            .tv_sec = CSI_STREAM_SEND_TIMEOUT_MS / 1000,
+            .tv_usec = (CSI_STREAM_SEND_TIMEOUT_MS % 1000) * 1000,
+        };
+        int nodelay = 1;
+
+        setsockopt(s_sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        setsockopt(s_sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.connects++;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    ESP_LOGI(TAG, "Streaming to %s:%u over %s", s_config.host, s_config.port,
+             s_config.transport == CSI_STREAM_TRANSPORT_TCP ? "TCP" : "UDP");
+
+    return ESP_OK;
+}
+
+static bool csi_stream_write(const uint8_t *data, size_t len)
+{
+    if (s_config.transport == CSI_STREAM_TRANSPORT_UDP) {
+        /* ENOMEM while lwIP is out of buffers costs this batch only */
+        return send(s_sock, data, len, 0) == (ssize_t)len;
+    }
+
+    while (len) {
+        int sent = send(s_sock, data, len, 0);
+
+        if (sent <= 0) {
+            ESP_LOGW(TAG, "Connection to %s lost: errno %d", s_config.host, errno);
+            csi_stream_close();
+            return false;
+        }
+
+        data += sent;
+        len -= sent;
+    }
+
+    return true;
+}
+
+static void csi_stream_log_losses(void)
+{
+    uint32_t losses = s_stats.shed + s_stats.send_failed;
+    uint32_t now = esp_log_timestamp();
+
+    if (losses != s_reported_losses && now - s_reported_ms >= CSI_STREAM_LOG_INTERVAL_MS) {
+        ESP_LOGW(TAG, "%lu records lost: %lu shed, %lu not sent, %lu sent in %lu batches",
+                 (unsigned long)(losses - s_reported_losses), (unsigned long)s_stats.shed,
+                 (unsigned long)s_stats.send_failed, (unsigned long)s_stats.records,
+                 (unsigned long)s_stats.batches);
+        s_reported_losses = losses;
+        s_reported_ms = now;
+    }
+}
+
+static void csi_stream_flush(void)
+{
+    csi_stream_header_t *header = (csi_stream_header_t *)s_batch;
+    csi_frame_ring_stats_t ring_stats;
+
+    if (!header->record_num) {
+        return;
+    }
+
+    csi_frame_ring_get_stats(&s_ring, &ring_stats);
+
+    header->len = s_batch_len - sizeof(csi_stream_header_t);
+    header->seq = s_batch_seq;
+    header->dropped = ring_stats.overruns + s_stats.send_failed;
+
+    /* Only batches sent take a number, a gap at the collector is a loss on the network */
+    bool sent = s_sock >= 0 && csi_stream_write(s_batch, s_batch_len);
+    if (sent) {
+        s_batch_seq++;
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.shed = ring_stats.overruns;
+    if (sent) {
+        s_stats.records += header->record_num;
+        s_stats.batches++;
+        s_stats.bytes += s_batch_len;
+    } else {
+        s_stats.send_failed += header->record_num;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    header->record_num = 0;
+    s_batch_len = sizeof(csi_stream_header_t);
+
+    csi_stream_log_losses();
+}
+
+static void csi_stream_task(void *arg)
+{
+    csi_stream_header_t *header = (csi_stream_header_t *)s_batch;
+    TickType_t last_connect = 0;
+    bool connecting = true;
+
+    for (;;) {
+        /* Records that arrive while the collector is away are still batched and counted as not sent */
+        if (s_sock < 0 && (connecting || xTaskGetTickCount() - last_connect >= pdMS_TO_TICKS(s_config.reconnect_ms))) {
+            last_connect = xTaskGetTickCount();
+            connecting = false;
+            csi_stream_connect();
+        }
+
+        TickType_t wait = pdMS_TO_TICKS(s_config.reconnect_ms);
+        if (header->record_num) {
+            TickType_t waited = xTaskGetTickCount() - s_batch_start;
+            wait = waited < pdMS_TO_TICKS(s_config.flush_ms) ? pdMS_TO_TICKS(s_config.flush_ms) - waited : 0;
+        }
+
+        const csi_record_header_t *record = csi_frame_ring_receive(&s_ring, wait);
+
+        if (!record) {
+            csi_stream_flush();
+            continue;
+        }
+
+        size_t record_len = sizeof(csi_record_header_t) + record->len;
+
+        if (s_batch_len + record_len > CSI_STREAM_BATCH_MAX || header->record_num == UINT8_MAX) {
+            csi_stream_flush();
+        }
+
+        if (!header->record_num) {
+            s_batch_start = xTaskGetTickCount();
+        }
+
+        memcpy(s_batch + s_batch_len, record, record_len);
+        s_batch_len += record_len;
+        header->record_num++;
+        csi_frame_ring_release(&s_ring);
+    }
+}
+
+esp_err_t csi_stream_init(const csi_stream_config_t *config)
+{
+    if (!config || !config->host || !config->port || !config->flush_ms || !config->reconnect_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_config = *config;
+
+    esp_err_t ret = csi_frame_ring_init(&s_ring, CSI_RECORD_MAX_LEN, config->queue_len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    csi_stream_header_t *header = (csi_stream_header_t *)s_batch;
+    header->magic[0] = CSI_STREAM_MAGIC_0;
+    header->magic[1] = CSI_STREAM_MAGIC_1;
+    header->version  = CSI_STREAM_VERSION;
+    esp_wifi_get_mac(WIFI_IF_STA, header->sensor);
+    s_batch_len = sizeof(csi_stream_header_t);
+
+    ret = csi_task_create(csi_stream_task, "csi_stream", CSI_STREAM_TASK_STACK, NULL, CSI_TASK_STAGE_OUTPUT, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_started = true;
+
+    return ESP_OK;
+}
+
+bool csi_stream_record(uint32_t seq, const wifi_csi_info_t *info, int8_t fft_gain, uint8_t agc_gain,
+                       float compensate_gain, bool lltf_12bit)
+{
+    uint8_t *slot = csi_frame_ring_acquire(&s_ring);
+
+    if (!slot) {
+        return false;
+    }
+
+    csi_record_build(slot, seq, info, fft_gain, agc_gain, compensate_gain, lltf_12bit);
+    csi_frame_ring_commit(&s_ring);
+
+    return true;
+}
+
+void csi_stream_get_stats(csi_stream_stats_t *stats)
+{
+    csi_frame_ring_stats_t ring_stats;
+
+    csi_frame_ring_get_stats(&s_ring, &ring_stats);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    stats->shed = ring_stats.overruns;
+}
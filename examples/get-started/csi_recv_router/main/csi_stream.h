@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file csi_stream.h
+ * @brief Binary CSI records batched into datagrams and streamed to a collector over UDP or TCP
+ *
+ * The Wi-Fi task builds each csi_record into a slot of a preallocated
+ * frame ring and returns; when the ring is full the record is shed and
+ * counted, the callback never waits for the network. A task of the output
+ * stage packs the records back to back behind a csi_stream_header_t until
+ * the next one would not fit CSI_STREAM_BATCH_MAX bytes or the
+ * oldest one has waited flush_ms, then sends the batch as one UDP datagram,
+ * or writes it to a TCP connection that is reopened every reconnect_ms
+ * while the collector is away.
+ *
+ * The batch sequence number shows datagrams lost on the network, the
+ * record sequence numbers lost records, and the dropped counter how many
+ * of them the sensor shed or could not send itself. The matching
+ * collector is get-started/tools/csi_stream_collect.py.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_STREAM_MAGIC_0              0xC5
+#define CSI_STREAM_MAGIC_1              0x5B
+#define CSI_STREAM_VERSION              1
+#define CSI_STREAM_BATCH_MAX            1400    /**< Batch bytes, header included, one unfragmented datagram */
+
+typedef enum {
+    CSI_STREAM_TRANSPORT_UDP = 0,
+    CSI_STREAM_TRANSPORT_TCP,
+} csi_stream_transport_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic[2];           /**< CSI_STREAM_MAGIC_0, CSI_STREAM_MAGIC_1 */
+    uint8_t version;            /**< CSI_STREAM_VERSION */
+    uint8_t record_num;         /**< csi_record_header_t and payload pairs that follow */
+    uint16_t len;               /**< Bytes of records after the header */
+    uint8_t sensor[6];          /**< Station MAC of the sender */
+    uint32_t seq;               /**< Batch sequence number, one per batch sent, a gap is a lost datagram */
+    uint32_t dropped;           /**< Records shed or not sent by the sender since boot */
+} csi_stream_header_t;
+
+typedef struct {
+    csi_stream_transport_t transport;
+    const char *host;               /**< Collector name or address, kept by reference */
+    uint16_t port;
+    uint32_t queue_len;             /**< Records waiting for the task, power of two */
+    uint32_t flush_ms;              /**< Longest a record waits for its batch to fill */
+    uint32_t reconnect_ms;          /**< Between two connection attempts */
+} csi_stream_config_t;
+
+#define CSI_STREAM_CONFIG_DEFAULT(host_, port_) { \
+    .transport = CSI_STREAM_TRANSPORT_UDP, \
+    .host = host_, \
+    .port = port_, \
+    .queue_len = 16, \
+    .flush_ms = 20, \
+    .reconnect_ms = 2000, \
+}
+
+typedef struct {
+    uint32_t records;               /**< Records sent */
+    uint32_t batches;               /**< Batches sent */
+    uint32_t bytes;                 /**< Batch bytes sent, headers included */
+    uint32_t shed;                  /**< Records dropped because the queue was full */
+    uint32_t send_failed;           /**< Records of batches that could not be sent */
+    uint32_t connects;              /**< Sockets opened, the first one included */
+} csi_stream_stats_t;
+
+/**
+ * @brief Allocate the queue and start the task, the first connection is made by the task
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the config is incomplete or the queue length not a power of two
+ *      - ESP_ERR_INVALID_STATE if already started
+ *      - ESP_ERR_NO_MEM if the queue or the task could not be allocated
+ */
+esp_err_t csi_stream_init(const csi_stream_config_t *config);
+
+/**
+ * @brief Queue one CSI packet as a binary record, never blocks
+ *
+ * Only one task may queue records, the Wi-Fi task. The arguments are
+ * those of csi_record_output().
+ *
+ * @return true if queued, false if shed
+ */
+bool csi_stream_record(uint32_t seq, const wifi_csi_info_t *info, int8_t fft_gain, uint8_t agc_gain,
+                       float compensate_gain, bool lltf_12bit);
+
+/**
+ * @brief Copy the counters
+ */
+void csi_stream_get_stats(csi_stream_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,8 +14,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <unistd.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "nvs_flash.h"
 
 #include "esp_mac.h"
@@ -24,6 +25,8 @@
 #include "esp_netif.h"
 #include "esp_now.h"
 
+#include "send_pacer.h"
+
 #define CONFIG_LESS_INTERFERENCE_CHANNEL   11
 
 #if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61 || (CONFIG_IDF_TARGET_ESP32C6 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0))
@@ -40,11 +43,17 @@
 #define CONFIG_ESP_NOW_RATE             WIFI_PHY_RATE_MCS0_LGI
 #define CONFIG_SEND_FREQUENCY               100
 
+/**
+ * @brief Last byte of the transmitter MAC. Give each transmitter heard by one csi_recv its own
+ *        index, and list its MAC in CONFIG_CSI_SEND_MAC of csi_recv
+ */
+#define CONFIG_CSI_SEND_INDEX               0
+
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
 #define ESP_IF_WIFI_STA ESP_MAC_WIFI_STA
 #endif
 
-static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
+static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, CONFIG_CSI_SEND_INDEX};
 static const char *TAG = "csi_send";
 
 static void wifi_init()
@@ -159,12 +168,18 @@ void app_main()
     ESP_LOGI(TAG, "wifi_channel: %d, send_frequency: %d, mac: " MACSTR,
              CONFIG_LESS_INTERFERENCE_CHANNEL, CONFIG_SEND_FREQUENCY, MAC2STR(CONFIG_CSI_SEND_MAC));
 
-    for (uint32_t count = 0; ; ++count) {
-        esp_err_t ret = esp_now_send(peer.peer_addr, (const uint8_t *)&count, sizeof(count));
-        if (ret != ESP_OK) {
-            ESP_LOGW(TAG, "free_heap: %ld <%s> ESP-NOW send error", esp_get_free_heap_size(), esp_err_to_name(ret));
-        }
+    send_pacer_config_t pacer_config = SEND_PACER_CONFIG_DEFAULT(CONFIG_SEND_FREQUENCY);
+    memcpy(pacer_config.peer_addr, peer.peer_addr, sizeof(pacer_config.peer_addr));
+    ESP_ERROR_CHECK(send_pacer_start(&pacer_config));
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(10 * 1000));
 
-        usleep(1000 * 1000 / CONFIG_SEND_FREQUENCY);
+        send_pacer_stats_t stats;
+        send_pacer_get_stats(&stats, true);
+        ESP_LOGI(TAG, "rate: %.1f/%d Hz, jitter avg/max: %lu/%lu us, missed: %lu, busy: %lu, retries: %lu, dropped: %lu, fail: %lu, free_heap: %ld",
+                 stats.rate, CONFIG_SEND_FREQUENCY, (unsigned long)stats.jitter_avg_us, (unsigned long)stats.jitter_max_us,
+                 (unsigned long)stats.missed, (unsigned long)stats.busy, (unsigned long)stats.retries,
+                 (unsigned long)stats.dropped, (unsigned long)stats.send_fail, esp_get_free_heap_size());
     }
 }
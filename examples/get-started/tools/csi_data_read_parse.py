@@ -13,6 +13,7 @@
 import sys
 import csv
 import json
+import struct
 import argparse
 import pandas as pd
 import numpy as np
@@ -52,6 +53,14 @@ agc_gain_data = np.zeros([CSI_DATA_INDEX], dtype=np.float64)
 fft_gain_data = np.zeros([CSI_DATA_INDEX], dtype=np.float64)
 fft_gains = []
 agc_gains = []
+csi_data_count = 0
+
+# Binary record written by csi_record_output() (csi_record.h), little endian
+CSI_RECORD_MAGIC = b'\xc5\x1b'
+CSI_RECORD_VERSION = 1
+CSI_RECORD_MAX_DATA_LEN = 1024
+CSI_RECORD_FLAG_LLTF_12BIT = 0x01
+CSI_RECORD_HEADER = struct.Struct('<2sBBHII6sbBbbBBHBBf')
 
 class csi_data_graphical_window(QWidget):
     def __init__(self):
@@ -187,10 +196,61 @@ def generate_subcarrier_colors(red_range, green_range, yellow_range, total_num,i
     return colors
 
 
+def csi_data_handle(csi_data, csi_raw_data, csv_writer, callback=None):
+    global fft_gains, agc_gains, csi_data_count
+    csi_data_len = int(csi_data[-3])
+    fft_gain = int(csi_data[6])
+    agc_gain = int(csi_data[7])
+
+    fft_gains.append(fft_gain)
+    agc_gains.append(agc_gain)
+
+    csv_writer.writerow(csi_data)
+
+    # Rotate data to the left
+    # csi_data_array[:-1] = csi_data_array[1:]
+    # csi_data_phase[:-1] = csi_data_phase[1:]
+    csi_data_complex[:-1] = csi_data_complex[1:]
+    agc_gain_data[:-1] = agc_gain_data[1:]
+    fft_gain_data[:-1] = fft_gain_data[1:]
+    agc_gain_data[-1] = agc_gain
+    fft_gain_data[-1] = fft_gain
+
+    if csi_data_count == 0:
+        csi_data_count = 1
+        print('none',csi_data_len)
+        if csi_data_len == 106:
+            colors = generate_subcarrier_colors((0,25), (27,53), None, len(csi_raw_data))
+        elif  csi_data_len == 114:
+            colors = generate_subcarrier_colors((0,27), (29,56), None, len(csi_raw_data))
+        elif  csi_data_len == 52:
+            colors = generate_subcarrier_colors((0,12), (13,26), None, len(csi_raw_data))
+        elif  csi_data_len == 234 :
+            colors = generate_subcarrier_colors((0,28), (29,56), (60,116), len(csi_raw_data))
+        elif  csi_data_len == 228 :
+            colors = generate_subcarrier_colors((0,28), (29,57), (57,113), len(csi_raw_data))
+        elif  csi_data_len == 490 :
+            colors = generate_subcarrier_colors((0,61), (62,122), (123,245), len(csi_raw_data))
+        elif  csi_data_len == 128 :
+            colors = generate_subcarrier_colors((0,31), (32,63), None, len(csi_raw_data))
+        elif  csi_data_len == 256 :
+            colors = generate_subcarrier_colors((0,32), (32,63), (64,128), len(csi_raw_data))
+        elif  csi_data_len == 512 :
+            colors = generate_subcarrier_colors((0,63), (64,127), (128,256), len(csi_raw_data))
+        elif  csi_data_len == 384 :
+            colors = generate_subcarrier_colors((0,63), (64,127), (128,192), len(csi_raw_data))
+        elif csi_data_len > 0 and csi_data_len <= 612:
+            raw_len = len(csi_raw_data)
+            colors = generate_subcarrier_colors((0,raw_len//2), (raw_len//2+1,raw_len-1), None, raw_len)
+        callback(colors)
+
+    for i in range(csi_data_len // 2):
+        csi_data_complex[-1][i] = complex(csi_raw_data[i * 2 + 1],
+                                        csi_raw_data[i * 2])
+
+
 def csi_data_read_parse(port: str, csv_writer, log_file_fd,callback=None):
-    global fft_gains, agc_gains
     set = serial.Serial(port=port, baudrate=2000000,bytesize=8, parity='N', stopbits=1)
-    count =0
     if set.isOpen():
         print('open success')
     else:
@@ -234,71 +294,98 @@ def csi_data_read_parse(port: str, csv_writer, log_file_fd,callback=None):
             log_file_fd.flush()
             continue
 
-        fft_gain = int(csi_data[6])
-        agc_gain = int(csi_data[7])
-
-        fft_gains.append(fft_gain)
-        agc_gains.append(agc_gain)
-
-        csv_writer.writerow(csi_data)
-
-        # Rotate data to the left
-        # csi_data_array[:-1] = csi_data_array[1:]
-        # csi_data_phase[:-1] = csi_data_phase[1:]
-        csi_data_complex[:-1] = csi_data_complex[1:]
-        agc_gain_data[:-1] = agc_gain_data[1:]
-        fft_gain_data[:-1] = fft_gain_data[1:]
-        agc_gain_data[-1] = agc_gain
-        fft_gain_data[-1] = fft_gain
-
-        if count ==0:
-            count = 1
-            print('none',csi_data_len)
-            if csi_data_len == 106:
-                colors = generate_subcarrier_colors((0,25), (27,53), None, len(csi_raw_data))
-            elif  csi_data_len == 114:
-                colors = generate_subcarrier_colors((0,27), (29,56), None, len(csi_raw_data))
-            elif  csi_data_len == 52:
-                colors = generate_subcarrier_colors((0,12), (13,26), None, len(csi_raw_data))
-            elif  csi_data_len == 234 :
-                colors = generate_subcarrier_colors((0,28), (29,56), (60,116), len(csi_raw_data))
-            elif  csi_data_len == 228 :
-                colors = generate_subcarrier_colors((0,28), (29,57), (57,113), len(csi_raw_data))
-            elif  csi_data_len == 490 :
-                colors = generate_subcarrier_colors((0,61), (62,122), (123,245), len(csi_raw_data))
-            elif  csi_data_len == 128 :
-                colors = generate_subcarrier_colors((0,31), (32,63), None, len(csi_raw_data))
-            elif  csi_data_len == 256 :
-                colors = generate_subcarrier_colors((0,32), (32,63), (64,128), len(csi_raw_data))
-            elif  csi_data_len == 512 :
-                colors = generate_subcarrier_colors((0,63), (64,127), (128,256), len(csi_raw_data))
-            elif  csi_data_len == 384 :
-                colors = generate_subcarrier_colors((0,63), (64,127), (128,192), len(csi_raw_data))
-            elif csi_data_len > 0 and csi_data_len <= 612:
-                raw_len = len(csi_raw_data)
-                colors = generate_subcarrier_colors((0,raw_len//2), (raw_len//2+1,raw_len-1), None, raw_len)
-            callback(colors)
-
-        for i in range(csi_data_len // 2):
-            csi_data_complex[-1][i] = complex(csi_raw_data[i * 2 + 1],
-                                            csi_raw_data[i * 2])
+        csi_data_handle(csi_data, csi_raw_data, csv_writer, callback)
+    set.close()
+    return
+
+
+def csi_record_decode(header, payload):
+    """Convert one binary record to the CSV row printed in text mode (DATA_COLUMNS_NAMES_C5C6)"""
+    (_, _, flags, _, seq, timestamp, mac, rssi, rate, noise_floor, fft_gain, agc_gain,
+     channel, sig_len, rx_state, first_word_invalid, compensate_gain) = header
+
+    if flags & CSI_RECORD_FLAG_LLTF_12BIT:
+        csi_raw_data = []
+        for (value,) in struct.iter_unpack('<H', payload[:len(payload) & ~1]):
+            value &= 0xfff
+            csi_raw_data.append(int(compensate_gain * (value - 0x1000 if value & 0x800 else value)))
+    else:
+        csi_raw_data = [int(compensate_gain * value) for value in struct.unpack('<%db' % len(payload), payload)]
+
+    mac_str = ':'.join('%02x' % b for b in mac)
+    csi_data = ['CSI_DATA', seq, mac_str, rssi, rate, noise_floor, fft_gain, agc_gain, channel,
+                timestamp, sig_len, rx_state, len(csi_raw_data), first_word_invalid,
+                json.dumps(csi_raw_data, separators=(',', ':'))]
+    return csi_data, csi_raw_data
+
+
+def csi_record_read_parse(port: str, csv_writer, log_file_fd, callback=None):
+    set = serial.Serial(port=port, baudrate=2000000,bytesize=8, parity='N', stopbits=1)
+    if set.isOpen():
+        print('open success')
+    else:
+        print('open failed')
+        return
+
+    buffer = bytearray()
+    while True:
+        data = set.read(max(1, set.in_waiting))
+        if not data:
+            break
+        buffer += data
+
+        while True:
+            index = buffer.find(CSI_RECORD_MAGIC)
+            if index == -1:
+                # Keep a trailing 0xc5, it may be the first half of the magic
+                index = len(buffer) - 1 if buffer.endswith(CSI_RECORD_MAGIC[:1]) else len(buffer)
+            if index > 0:
+                # Log lines and other bytes between records
+                log_file_fd.write(buffer[:index].decode('utf-8', errors='replace'))
+                log_file_fd.flush()
+                del buffer[:index]
+            if len(buffer) < CSI_RECORD_HEADER.size:
+                break
+
+            header = CSI_RECORD_HEADER.unpack_from(buffer)
+            version, flags, payload_len = header[1], header[2], header[3]
+            if version != CSI_RECORD_VERSION or flags & ~CSI_RECORD_FLAG_LLTF_12BIT or payload_len > CSI_RECORD_MAX_DATA_LEN:
+                # False magic inside other data, skip it and resync
+                log_file_fd.write('record header is invalid\n')
+                del buffer[:1]
+                continue
+
+            record_len = CSI_RECORD_HEADER.size + payload_len
+            if len(buffer) < record_len:
+                break
+
+            payload = bytes(buffer[CSI_RECORD_HEADER.size:record_len])
+            del buffer[:record_len]
+
+            csi_data, csi_raw_data = csi_record_decode(header, payload)
+            csi_data_handle(csi_data, csi_raw_data, csv_writer, callback)
     set.close()
     return
 
 
 class SubThread (QThread):
     data_ready = pyqtSignal(object)
-    def __init__(self, serial_port, save_file_name, log_file_name):
+    def __init__(self, serial_port, save_file_name, log_file_name, data_format='text'):
         super().__init__()
         self.serial_port = serial_port
+        self.data_format = data_format
 
         save_file_fd = open(save_file_name, 'w')
         self.log_file_fd = open(log_file_name, 'w')
         self.csv_writer = csv.writer(save_file_fd)
-        self.csv_writer.writerow(DATA_COLUMNS_NAMES)
+        # Binary records carry the same fields on every target
+        self.csv_writer.writerow(DATA_COLUMNS_NAMES_C5C6 if data_format == 'binary' else DATA_COLUMNS_NAMES)
 
     def run(self):
-        csi_data_read_parse(self.serial_port, self.csv_writer, self.log_file_fd,callback=self.data_ready.emit)
+        if self.data_format == 'binary':
+            csi_record_read_parse(self.serial_port, self.csv_writer, self.log_file_fd,callback=self.data_ready.emit)
+        else:
+            csi_data_read_parse(self.serial_port, self.csv_writer, self.log_file_fd,callback=self.data_ready.emit)
 
     def __del__(self):
         self.wait()
@@ -318,15 +405,18 @@ if __name__ == '__main__':
                         help='Save the data printed by the serial port to a file')
     parser.add_argument('-l', '--log', dest='log_file', action='store', default='./csi_data_log.txt',
                         help='Save other serial data the bad CSI data to a log file')
+    parser.add_argument('-f', '--format', dest='data_format', action='store', choices=['text', 'binary'], default='text',
+                        help='CSI output format of the device, binary requires CONFIG_CSI_OUTPUT_FORMAT = CSI_OUTPUT_FORMAT_BINARY')
 
     args = parser.parse_args()
     serial_port = args.port
     file_name = args.store_file
     log_file_name = args.log_file
+    data_format = args.data_format
 
     app = QApplication(sys.argv)
 
-    subthread = SubThread(serial_port, file_name, log_file_name)
+    subthread = SubThread(serial_port, file_name, log_file_name, data_format)
 
     window = csi_data_graphical_window()
     subthread.data_ready.connect(window.update_curve_colors)
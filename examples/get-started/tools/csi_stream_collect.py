@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+# -*-coding:utf-8-*-
+
+# SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+#
+
+# Collects the CSI batches csi_recv_router streams with CSI_OUTPUT_FORMAT_NETWORK
+# (main/csi_stream.h) from any number of sensors and saves one CSV per sensor,
+# in the layout csi_data_read_parse.py saves binary records in. Only the
+# standard library is needed, so it runs on a headless collector.
+
+import os
+import sys
+import csv
+import json
+import time
+import struct
+import socket
+import argparse
+import threading
+import socketserver
+
+DATA_COLUMNS_NAMES_C5C6 = ['type', 'id', 'mac', 'rssi', 'rate', 'noise_floor', 'fft_gain', 'agc_gain', 'channel',
+                           'local_timestamp', 'sig_len', 'rx_state', 'len', 'first_word', 'data']
+
+# Batch header of csi_stream.h and record header of csi_record.h, little endian
+CSI_STREAM_MAGIC = b'\xc5\x5b'
+CSI_STREAM_VERSION = 1
+CSI_STREAM_HEADER = struct.Struct('<2sBBH6sII')
+CSI_RECORD_MAGIC = b'\xc5\x1b'
+CSI_RECORD_VERSION = 1
+CSI_RECORD_FLAG_LLTF_12BIT = 0x01
+CSI_RECORD_HEADER = struct.Struct('<2sBBHII6sbBbbBBHBBf')
+
+
+def csi_record_decode(header, payload):
+    """Convert one binary record to the CSV row printed in text mode (DATA_COLUMNS_NAMES_C5C6)"""
+    (_, _, flags, _, seq, timestamp, mac, rssi, rate, noise_floor, fft_gain, agc_gain,
+     channel, sig_len, rx_state, first_word_invalid, compensate_gain) = header
+
+    if flags & CSI_RECORD_FLAG_LLTF_12BIT:
+        csi_raw_data = []
+        for (value,) in struct.iter_unpack('<H', payload[:len(payload) & ~1]):
+            value &= 0xfff
+            csi_raw_data.append(int(compensate_gain * (value - 0x1000 if value & 0x800 else value)))
+    else:
+        csi_raw_data = [int(compensate_gain * value) for value in struct.unpack('<%db' % len(payload), payload)]
+
+    mac_str = ':'.join('%02x' % b for b in mac)
+    return ['CSI_DATA', seq, mac_str, rssi, rate, noise_floor, fft_gain, agc_gain, channel,
+            timestamp, sig_len, rx_state, len(csi_raw_data), first_word_invalid,
+            json.dumps(csi_raw_data, separators=(',', ':'))]
+
+
+class Sensor:
+    """CSV file and loss accounting of one sender, keyed by its station MAC"""
+
+    def __init__(self, name, output_dir):
+        self.name = name
+        self.file = open(os.path.join(output_dir, 'csi_%s.csv' % name.replace(':', '')), 'w', newline='')
+        self.writer = csv.writer(self.file)
+        self.writer.writerow(DATA_COLUMNS_NAMES_C5C6)
+        self.batches = 0
+        self.records = 0
+        self.batch_seq = None
+        self.record_seq = None
+        self.lost_batches = 0
+        self.lost_records = 0
+        self.dropped = 0
+
+    def batch(self, seq, dropped):
+        # A sensor that restarted counts from 0 again, that is not a loss
+        if self.batch_seq is not None and seq > self.batch_seq + 1:
+            self.lost_batches += seq - self.batch_seq - 1
+        self.batch_seq = seq
+        self.batches += 1
+        self.dropped = dropped
+
+    def record(self, row):
+        seq = row[1]
+        if self.record_seq is not None and seq > self.record_seq + 1:
+            self.lost_records += seq - self.record_seq - 1
+        self.record_seq = seq
+        self.records += 1
+        self.writer.writerow(row)
+
+    def summary(self):
+        return ('%s: %d records in %d batches, %d records missing (%d shed or unsent by the sensor), %d batches lost'
+                % (self.name, self.records, self.batches, self.lost_records, self.dropped, self.lost_batches))
+
+
+class Collector:
+    def __init__(self, output_dir):
+        self.output_dir = output_dir
+        self.sensors = {}
+        self.lock = threading.Lock()
+        self.invalid = 0
+
+    def batch(self, data):
+        """Handle one batch, return False if it is not one"""
+        if len(data) < CSI_STREAM_HEADER.size:
+            self.invalid += 1
+            return False
+
+        magic, version, record_num, length, sensor_mac, seq, dropped = CSI_STREAM_HEADER.unpack_from(data)
+        if magic != CSI_STREAM_MAGIC or version != CSI_STREAM_VERSION \
+                or len(data) < CSI_STREAM_HEADER.size + length:
+            self.invalid += 1
+            return False
+
+        name = ':'.join('%02x' % b for b in sensor_mac)
+        rows = []
+        offset = CSI_STREAM_HEADER.size
+        end = offset + length
+
+        for _ in range(record_num):
+            if end - offset < CSI_RECORD_HEADER.size:
+                break
+            header = CSI_RECORD_HEADER.unpack_from(data, offset)
+            if header[0] != CSI_RECORD_MAGIC or header[1] != CSI_RECORD_VERSION:
+                break
+            payload_start = offset + CSI_RECORD_HEADER.size
+            payload_end = payload_start + header[3]
+            if payload_end > end:
+                break
+            rows.append(csi_record_decode(header, data[payload_start:payload_end]))
+            offset = payload_end
+
+        if len(rows) != record_num:
+            self.invalid += 1
+
+        with self.lock:
+            sensor = self.sensors.get(name)
+            if not sensor:
+                sensor = self.sensors[name] = Sensor(name, self.output_dir)
+                print('new sensor %s' % name)
+            sensor.batch(seq, dropped)
+            for row in rows:
+                sensor.record(row)
+
+        return True
+
+    def report(self):
+        with self.lock:
+            for sensor in self.sensors.values():
+                sensor.file.flush()
+                print(sensor.summary())
+            if self.invalid:
+                print('%d invalid batches' % self.invalid)
+
+
+def serve_udp(collector, port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
+    sock.bind(('0.0.0.0', port))
+    print('listening on UDP port %d' % port)
+
+    while True:
+        data, _ = sock.recvfrom(65536)
+        collector.batch(data)
+
+
+def serve_tcp(collector, port):
+    class Handler(socketserver.BaseRequestHandler):
+        def handle(self):
+            print('connection from %s:%d' % self.client_address)
+            buffer = bytearray()
+
+            while True:
+                data = self.request.recv(65536)
+                if not data:
+                    break
+                buffer += data
+
+                while len(buffer) >= CSI_STREAM_HEADER.size:
+                    if buffer[:2] != CSI_STREAM_MAGIC:
+                        # Lost framing, look for the next batch
+                        index = buffer.find(CSI_STREAM_MAGIC, 1)
+                        del buffer[:index if index > 0 else len(buffer)]
+                        collector.invalid += 1
+                        continue
+                    batch_len = CSI_STREAM_HEADER.size + CSI_STREAM_HEADER.unpack_from(buffer)[3]
+                    if len(buffer) < batch_len:
+                        break
+                    collector.batch(bytes(buffer[:batch_len]))
+                    del buffer[:batch_len]
+
+            print('connection from %s:%d closed' % self.client_address)
+
+    socketserver.ThreadingTCPServer.allow_reuse_address = True
+    server = socketserver.ThreadingTCPServer(('0.0.0.0', port), Handler)
+    server.daemon_threads = True
+    print('listening on TCP port %d' % port)
+    server.serve_forever()
+
+
+if __name__ == '__main__':
+    if sys.version_info < (3, 6):
+        print(' Python version should >= 3.6')
+        exit()
+
+    parser = argparse.ArgumentParser(
+        description='Collect the CSI streamed by csi_recv_router sensors, one CSV per sensor')
+    transport = parser.add_mutually_exclusive_group(required=True)
+    transport.add_argument('-u', '--udp', dest='udp_port', type=int,
+                           help='UDP port to listen on, CONFIG_CSI_STREAM_PORT')
+    transport.add_argument('-t', '--tcp', dest='tcp_port', type=int,
+                           help='TCP port to listen on, CONFIG_CSI_STREAM_PORT with CSI_STREAM_TRANSPORT_TCP')
+    parser.add_argument('-o', '--output', dest='output_dir', action='store', default='.',
+                        help='Directory of the csi_<mac>.csv files')
+    parser.add_argument('-i', '--interval', dest='interval', type=float, default=10,
+                        help='Seconds between two loss reports')
+
+    args = parser.parse_args()
+    os.makedirs(args.output_dir, exist_ok=True)
+    collector = Collector(args.output_dir)
+
+    if args.udp_port:
+        target, port = serve_udp, args.udp_port
+    else:
+        target, port = serve_tcp, args.tcp_port
+    threading.Thread(target=target, args=(collector, port), daemon=True).start()
+
+    try:
+        while True:
+            time.sleep(args.interval)
+            collector.report()
+    except KeyboardInterrupt:
+        collector.report()
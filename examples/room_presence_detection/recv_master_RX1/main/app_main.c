@@ -9,8 +9,9 @@
  *
  * This firmware runs on the master receiver device. It:
  * - Receives ESP-NOW packets and extracts CSI data (Link 1)
- * - Receives detection results from slave nodes (Link 2, 3)
- * - Fuses multi-link results using voting mechanism
+ * - Registers slave nodes by ESP-NOW source MAC and receives their detection results
+ * - Fuses any number of links with a confidence-weighted vote
+ * - Moves slave report times to its own clock, synced on the sender's packets
  * - Creates WiFi AP hotspot for web access
  * - Provides HTTP server with WebSocket for real-time status
  * - Shows status via LED
@@ -19,6 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <math.h>
 #include <sys/param.h>
 
@@ -26,6 +28,7 @@
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 
 #include "nvs_flash.h"
 #include "esp_mac.h"
@@ -35,29 +38,84 @@
 #include "esp_now.h"
 #include "esp_timer.h"
 #include "esp_http_server.h"
+#include "esp_idf_version.h"
 #include "esp_event.h"
+#include "esp_bit_defs.h"
 
 #include "led_strip.h"
 #include "esp_radar.h"
+#include "radar_window.h"
+#include "presence_vote.h"
+#include "online_calib.h"
+#include "channel_survey.h"
+#include "time_sync.h"
+#include "settings_store.h"
+#include "csi_wifi.h"
+#include "espnow_rate.h"
+#include "csi_perf.h"
+#include "csi_queue.h"
+#include "csi_task.h"
+#include "csi_diag.h"
+#include "csi_mem.h"
+#include "csi_boot.h"
+#include "web_assets.h"
 
 static const char *TAG = "recv_master";
 
-/* Embedded web files */
-extern const uint8_t index_html_start[] asm("_binary_index_html_start");
-extern const uint8_t index_html_end[] asm("_binary_index_html_end");
-extern const uint8_t style_css_start[] asm("_binary_style_css_start");
-extern const uint8_t style_css_end[] asm("_binary_style_css_end");
-extern const uint8_t app_js_start[] asm("_binary_app_js_start");
-extern const uint8_t app_js_end[] asm("_binary_app_js_end");
-
 /* Configuration */
 #define CONFIG_WIFI_CHANNEL             11
 #define CONFIG_AP_SSID                  "RoomSensor"
 #define CONFIG_AP_PASSWORD              "12345678"
 #define CONFIG_AP_MAX_CONN              4
-#define RADAR_BUFF_MAX_LEN              25
-#define MAX_SLAVE_NODES                 2
+#define RADAR_WINDOW_MAX_LEN            128   /* Upper bound for the runtime window length */
+#define RADAR_WINDOW_DEFAULT_LEN        25
+#define DETECT_DEFAULT_CSI_INTERVAL_MS  10    /* CSI decimation, 100 Hz is the rate of send_TX */
+#define DETECT_DEFAULT_VOTE_LEN         5
+#define DETECT_DEFAULT_MOVE_VOTES       2
+#define DETECT_CSI_INTERVAL_MAX_MS      1000
+#define CONFIG_MAX_LINKS                16    /* Registry slots, link 0 is the local CSI link */
 #define LINK_TIMEOUT_MS                 3000  /* Consider link dead after 3s */
+#define LINK_EVICT_MS                   60000 /* Free the slot of a node silent for 60s */
+#define LINK_DEFAULT_WANDER_SENS        0.15f
+#define LINK_DEFAULT_JITTER_SENS        0.20f
+#define CONFIG_FUSION_PRESENCE_RATIO    0.5f  /* Weighted share of links that must agree, exclusive */
+#define FUSION_RSSI_WEIGHT_FLOOR_DBM    -90   /* RSSI mapped to the minimum weight */
+#define FUSION_RSSI_WEIGHT_SPAN_DB      40    /* RSSI above the floor that reaches full weight */
+#define FUSION_RSSI_WEIGHT_MIN          0.25f
+#define CONFIG_WS_PUSH_MIN_INTERVAL_MS  50    /* Max WebSocket rate for room/motion transitions */
+#define CONFIG_WS_UPDATE_INTERVAL_MS    250   /* Max WebSocket rate for value-only updates */
+#define CONFIG_WS_HEARTBEAT_MS          5000  /* Resend the unchanged status this often */
+#define CONFIG_STATUS_LONG_POLL_MS      10000 /* Longest wait of /api/status?since=<gen> */
+#define CONFIG_STATUS_LONG_POLL_MAX     2     /* Long-polls parked at once, more are answered at once */
+#define CONFIG_FUSION_QUEUE_LEN         32    /* Pending radar/ESP-NOW events */
+#define CONFIG_TASK_USAGE_LOG_INTERVAL_MS 60000 /* Per-task CPU share in the status log */
+#define CONFIG_DIAG_INTERVAL_MS         60000 /* Task and heap sample served on /api/diag */
+#define CONFIG_DIAG_HISTORY_LEN         60    /* Samples kept, one hour of heap trend */
+#define FUSION_IDLE_CHECK_MS            500   /* Re-run fusion without input to expire dead links */
+#define CONFIG_CALIB_DURATION_MS        30000 /* Manual calibration, /api/calibrate may ask for another */
+#define CONFIG_CALIB_DURATION_MAX_MS    600000
+#define CONFIG_CALIB_BACKGROUND_ENABLE  1     /* Re-baseline while the room stays empty */
+#define CONFIG_CALIB_BACKGROUND_VACANT_MS    (5 * 60 * 1000)    /* Empty this long before a background run */
+#define CONFIG_CALIB_BACKGROUND_INTERVAL_MS  (60 * 60 * 1000)   /* Between two completed background runs */
+#define CONFIG_CALIB_BACKGROUND_WEIGHT  0.25f /* Share of a background run in the thresholds */
+
+#define CONFIG_POWER_DUTY_ENABLE        1     /* Duty-cycle the sender and the slaves while the room stays empty */
+#define CONFIG_POWER_VACANT_MS          (10 * 60 * 1000)    /* Empty this long before the duty cycle */
+#define CONFIG_POWER_CYCLE_MS           10000 /* One sensing burst per cycle */
+#define CONFIG_POWER_BURST_MS           2000
+#define CONFIG_POWER_ANNOUNCE_MS        60000 /* Repeat the duty command for nodes that missed it or rebooted */
+#define CONFIG_POWER_WAKE_REPEAT_MS     500   /* Repeat the wake-up until every slave is continuous */
+#define CONFIG_SEND_FREQUENCY           100   /* Packets per second of send_TX, the duty cycle is set in its slots */
+#define CONFIG_SEND_PHYMODE             WIFI_PHY_MODE_HT40      /* CONFIG_ESP_NOW_PHYMODE of send_TX */
+#define CONFIG_SEND_RATE                WIFI_PHY_RATE_MCS0_LGI  /* CONFIG_ESP_NOW_RATE of send_TX */
+
+#define CONFIG_CHANNEL_SURVEY_ENABLE    1     /* Survey at boot and periodically, POST /api/channel always works */
+#define CONFIG_CHANNEL_SURVEY_LIST      {1, 6, 11}  /* Candidate channels, 2.4 GHz */
+#define CONFIG_CHANNEL_SURVEY_DWELL_MS  500   /* Listening time per channel */
+#define CONFIG_CHANNEL_SURVEY_BOOT_DELAY_MS  30000   /* Lets the other nodes boot before the first survey */
+#define CONFIG_CHANNEL_SURVEY_INTERVAL_MS    (6 * 60 * 60 * 1000)    /* Periodic survey, only while the room is empty */
+#define CONFIG_CHANNEL_SURVEY_RETRY_MS  60000 /* Next try of a periodic survey the room did not allow */
+#define CONFIG_CHANNEL_SWITCH_DELAY_MS  1000  /* The switch command is repeated this long before every node switches */
 
 /* Sender's MAC address - used for CSI filtering */
 static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
@@ -79,15 +137,51 @@ static led_strip_handle_t g_led_strip = NULL;
 static httpd_handle_t g_httpd = NULL;
 static SemaphoreHandle_t g_state_mutex = NULL;
 
+/*
+ * Detection tuning of a node, set on POST /api/detect without a reboot. The
+ * local link of the master decides on the window median and waits for
+ * vote_len samples before its first result, move_votes only applies to the
+ * slaves.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t csi_interval_ms;   /* CSI decimation, csi_recv_interval of esp-radar, 0 while a slave has not reported it */
+    uint16_t window_len;        /* Wander and jitter smoothing windows, up to RADAR_WINDOW_MAX_LEN */
+    uint8_t vote_len;           /* Recent jitter samples that vote on motion */
+    uint8_t move_votes;         /* Outliers among them that mark motion */
+} detect_config_t;
+
+#define DETECT_CONFIG_DEFAULT() { \
+    .csi_interval_ms = DETECT_DEFAULT_CSI_INTERVAL_MS, \
+    .window_len = RADAR_WINDOW_DEFAULT_LEN, \
+    .vote_len = DETECT_DEFAULT_VOTE_LEN, \
+    .move_votes = DETECT_DEFAULT_MOVE_VOTES, \
+}
+
 /* Per-link status and sensitivity */
 typedef struct {
+    bool used;              /* Registry slot taken, see link_registry_join() */
     bool active;
     bool room_status;       /* Recalculated by master based on sensitivity */
     bool human_status;      /* Recalculated by master based on sensitivity */
+    uint8_t mac[6];         /* ESP-NOW source address, registry key */
+    uint8_t node_id;        /* Node ID reported by the slave, 0 for the local link */
     float wander;           /* Raw value from sensor */
     float jitter;           /* Raw value from sensor */
     int8_t rssi;
-    uint32_t last_update;
+    float weight;           /* Vote weight in the last fusion, 0 while inactive */
+    uint32_t last_update;   /* When the values were measured, master esp_log_timestamp() */
+
+    /* Clock sync of a slave, see time_sync.h */
+    bool synced;            /* Report times are on the master timebase */
+    uint16_t report_age_ms; /* Measurement to fusion delay of the last report */
+    uint16_t sync_error_us; /* Mean prediction error of the clock estimate */
+    float clock_drift_ppm;
+
+    /* Duty cycle reported by a slave, see power_update() */
+    uint8_t power_mode;     /* POWER_MODE_* */
+    uint16_t duty_permille; /* Radio-on share between its last two power reports */
+
+    detect_config_t detect; /* In effect on the node, reported by a slave */
     
     /* Per-link sensitivity (independently adjustable) */
     float wander_sensitivity;
@@ -96,44 +190,160 @@ typedef struct {
 
 /* Global detection state */
 typedef struct {
-    /* Local detection buffers (Link 0) */
-    float wander_buff[RADAR_BUFF_MAX_LEN];
-    float jitter_buff[RADAR_BUFF_MAX_LEN];
-    uint32_t buff_count;
+    /* Local detection windows (Link 0) */
+    radar_window_t wander_win;
+    radar_window_t jitter_win;
     
     /* Global thresholds (from calibration) */
     float wander_threshold;
     float jitter_threshold;
     
-    /* Per-link status */
-    link_status_t links[3];  /* 0=local, 1=slave1, 2=slave2 */
+    /* Per-link status, 0=local, the others are slaves in join order */
+    link_status_t links[CONFIG_MAX_LINKS];
     
     /* Fused result */
-    bool room_status;        /* >=2 links detect presence/motion -> has person */
-    bool human_status;       /* >=2 links detect motion -> moving; else stationary */
+    bool room_status;        /* Weighted majority detects presence/motion -> has person */
+    bool human_status;       /* Weighted majority detects motion -> moving; else stationary */
     
     /* Calibration */
-    bool calibrating;
+    bool calibrating;                   /* Manual run from /api/calibrate */
     uint32_t calibration_start_time;
     uint32_t calibration_duration_ms;
+    online_calib_t calib;               /* Local link samples of the manual or background run */
+
+    /* Background re-baselining, driven by the fusion task */
+    bool background_enable;
+    bool background_running;
+    uint32_t vacant_since;              /* Fused room status empty since */
+    uint32_t background_last;           /* End of the last completed background run */
+    uint32_t background_runs;
+    uint32_t background_aborts;         /* Runs dropped because the room was occupied */
+
+    /* Duty cycle of the sender and the slaves, driven by the fusion task */
+    uint8_t power_mode;                 /* POWER_MODE_* */
+    bool power_wake_request;            /* A duty-cycled slave went continuous on its own detection */
+    uint32_t power_since;               /* Current mode since */
+    uint32_t power_cmd_last;            /* Last broadcast of the mode */
+    uint32_t power_wake_start;          /* Wake-up broadcast started, 0 once every slave is continuous */
+    uint32_t power_wakes;
+    uint32_t power_wake_latency_ms;     /* Last wake-up until every slave reported continuous mode */
+    uint32_t power_wake_latency_max_ms;
 } master_state_t;
 
+static float g_wander_win_storage[RADAR_WINDOW_STORAGE_LEN(RADAR_WINDOW_MAX_LEN)];
+static float g_jitter_win_storage[RADAR_WINDOW_STORAGE_LEN(RADAR_WINDOW_MAX_LEN)];
+
 static master_state_t g_state = {
-    .buff_count = 0,
     .wander_threshold = 0.0f,
     .jitter_threshold = 0.0003f,
     .room_status = false,
     .human_status = false,
     .calibrating = false,
     .calibration_start_time = 0,
-    .calibration_duration_ms = 30000,
+    .calibration_duration_ms = CONFIG_CALIB_DURATION_MS,
+    .background_enable = CONFIG_CALIB_BACKGROUND_ENABLE,
     .links = {
-        { .wander_sensitivity = 0.15f, .jitter_sensitivity = 0.20f },  /* Link 0 (local) */
-        { .wander_sensitivity = 0.15f, .jitter_sensitivity = 0.20f },  /* Link 1 (slave1) */
-        { .wander_sensitivity = 0.15f, .jitter_sensitivity = 0.20f },  /* Link 2 (slave2) */
+        /* Link 0 (local), slaves get their slot when their first report arrives */
+        { .used = true, .synced = true, .duty_permille = 1000, .detect = DETECT_CONFIG_DEFAULT(),
+          .wander_sensitivity = LINK_DEFAULT_WANDER_SENS, .jitter_sensitivity = LINK_DEFAULT_JITTER_SENS },
     },
 };
 
+static uint32_t g_link_join_rejects = 0;
+
+/* Per-slave clock estimates, only used by the fusion task, reset when a slot is reassigned */
+static time_sync_t g_link_clocks[CONFIG_MAX_LINKS];
+
+/* Arrival times of the sender's packets, only used by the ESP-NOW callback */
+static time_sync_beacons_t g_sync_beacons;
+
+#define CHANNEL_SURVEY_MAX          13
+
+/* Sensing channel and the last survey, see channel_task() */
+static struct {
+    uint8_t channel;                                /* Home channel of every node */
+    bool surveying;                                 /* Local radar results are dropped meanwhile */
+    channel_survey_stat_t *dwell;                   /* Channel counted by the promiscuous callback, NULL between dwells */
+    int64_t dwell_start_us;
+    channel_survey_stat_t stats[CHANNEL_SURVEY_MAX];
+    uint8_t stat_num;
+    uint32_t survey_time;                           /* End of the last survey, esp_log_timestamp() */
+    uint32_t surveys;
+    uint32_t switches;
+    uint32_t sender_heard;                          /* Last sender packet on the home channel */
+} g_channel = {
+    .channel = CONFIG_WIFI_CHANNEL,
+};
+static portMUX_TYPE g_channel_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t g_channel_task = NULL;
+static const channel_survey_config_t s_channel_survey_config = CHANNEL_SURVEY_CONFIG_DEFAULT();
+
+/**
+ * @brief Detection status as seen by readers (HTTP, WebSocket, logs)
+ *
+ * Only the fusion task writes it, through status_snapshot_publish(); readers
+ * copy a consistent version with status_snapshot_read() and never lock. Every
+ * publish starts a new generation, seq / 2.
+ */
+typedef struct {
+    bool room_status;
+    bool human_status;
+    bool calibrating;
+    float wander_threshold;
+    float jitter_threshold;
+    uint8_t power_mode;
+    uint32_t power_wakes;
+    uint32_t power_wake_latency_ms;
+    uint32_t power_wake_latency_max_ms;
+    link_status_t links[CONFIG_MAX_LINKS];  /* Unused slots have used == false */
+} presence_status_t;
+
+static struct {
+    uint32_t seq;               /* Odd while the fusion task is updating status */
+    presence_status_t status;
+} g_status_snapshot;
+
+/* Input of the fusion task, posted by the driver callbacks and the HTTP handlers */
+typedef enum {
+    FUSION_EVENT_LOCAL,         /* Raw waveform from the local radar callback */
+    FUSION_EVENT_SLAVE,         /* Detection report from a slave node */
+    FUSION_EVENT_REFRESH,       /* Thresholds, sensitivity or calibration changed */
+    FUSION_EVENT_POWER,         /* Duty cycle report from a slave node */
+    FUSION_EVENT_CONFIG,        /* Detection tuning reported by a slave node */
+} fusion_event_type_t;
+
+typedef struct {
+    uint8_t type;               /* fusion_event_type_t */
+    uint8_t node_id;
+    uint8_t room_status;
+    uint8_t human_status;
+    uint8_t mac[6];             /* Source address of a slave report */
+    int8_t rssi;
+    float wander;
+    float jitter;
+    bool sync_valid;            /* Both nodes heard sync_seq, beacon_local_us is set */
+    uint32_t sync_time_us;      /* Slave arrival time of the sender packet */
+    int64_t beacon_local_us;    /* Master arrival time of the same packet */
+    uint32_t report_time_us;    /* Slave time of the report */
+    int64_t rx_us;              /* Master arrival time of the report */
+    uint8_t power_mode;         /* Of a power report */
+    uint16_t duty_permille;
+    detect_config_t detect;     /* Of a config report */
+    int64_t post_us;            /* Set by fusion_post() */
+} fusion_event_t;
+
+static csi_queue_t g_fusion_queue;
+
+/* Task and heap samples, served as JSON on /api/diag */
+static CSI_MEM_BULK_BSS_ATTR csi_diag_sample_t g_diag_history[CONFIG_DIAG_HISTORY_LEN];
+
+/* Latency probes, served as JSON on /api/perf */
+static csi_perf_stage_t g_perf_fusion_queue = CSI_PERF_STAGE_NONE;
+static csi_perf_stage_t g_perf_fusion       = CSI_PERF_STAGE_NONE;
+static csi_perf_stage_t g_perf_report_age   = CSI_PERF_STAGE_NONE;
+static csi_perf_stage_t g_perf_status_json  = CSI_PERF_STAGE_NONE;
+static csi_perf_stage_t g_perf_ws_push      = CSI_PERF_STAGE_NONE;
+
 /* ESP-NOW message from slave */
 typedef struct __attribute__((packed)) {
     uint8_t msg_type;
@@ -144,132 +354,276 @@ typedef struct __attribute__((packed)) {
     float jitter;
     int8_t rssi;
     uint32_t timestamp;
+    uint32_t sync_seq;          /* Newest sender packet heard by the slave */
+    uint32_t sync_time_us;      /* Slave arrival time of that packet, 0 if none yet */
+    uint32_t time_us;           /* Slave time of the report */
 } slave_report_t;
 
+#define SLAVE_MSG_REPORT        0x01    /* slave_report_t */
+#define SLAVE_MSG_REPORT_BATCH  0x02    /* slave_report_t followed by older samples, only the report is used */
+#define SLAVE_MSG_POWER         0x03    /* slave_power_t */
+#define SLAVE_MSG_CONFIG        0x04    /* slave_config_t */
+
+/* Power state of a slave, sent on every mode change and at the end of each burst */
+typedef struct __attribute__((packed)) {
+    uint8_t msg_type;
+    uint8_t node_id;
+    uint8_t mode;               /* POWER_MODE_* */
+    uint16_t duty_permille;     /* Radio-on share since the previous power report */
+    uint32_t bursts;            /* Bursts since the slave booted */
+} slave_power_t;
+
+/* Detection tuning in effect on a slave, sent at boot and after every DETECT_CMD */
+typedef struct __attribute__((packed)) {
+    uint8_t msg_type;
+    uint8_t node_id;
+    detect_config_t config;
+} slave_config_t;
+
+/* Detection tuning command, broadcast or sent to one slave, see recv_slave espnow_recv_cb() */
+#define DETECT_CMD                  0x18    /* [detect_config_t] */
+
+/* Duty cycle command to the sender and the slaves, see their espnow_recv_cb() */
+#define POWER_CMD                   0x15    /* [mode][cycle_slots u16][burst_slots u16] */
+#define POWER_MODE_CONTINUOUS       0
+#define POWER_MODE_DUTY             1
+#define POWER_MS_TO_SLOTS(ms)       ((ms) * CONFIG_SEND_FREQUENCY / 1000)
+
+_Static_assert(POWER_MS_TO_SLOTS(CONFIG_POWER_CYCLE_MS) <= UINT16_MAX, "CONFIG_POWER_CYCLE_MS too long");
+_Static_assert(CONFIG_POWER_BURST_MS > 0 && CONFIG_POWER_BURST_MS < CONFIG_POWER_CYCLE_MS,
+               "The burst must be a part of the cycle");
+
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
 #define ESP_IF_WIFI_STA ESP_MAC_WIFI_STA
 #endif
 
-/* Utility functions */
-static float trimmean(const float *array, size_t len, float percent)
+/* NVS Storage - persist calibration and sensitivity across power cycles */
+#define NVS_NAMESPACE "presence"
+#define SETTINGS_VERSION                3
+#define SETTINGS_MAX_NODES              32    /* Slave sensitivities kept by MAC, the least recently set is dropped */
+#define CONFIG_SETTINGS_DEBOUNCE_MS     2000  /* Quiet time before a change is written, covers a slider drag */
+#define CONFIG_SETTINGS_MAX_DELAY_MS    10000
+
+typedef struct {
+    uint8_t mac[6];
+    float wander_sensitivity;
+    float jitter_sensitivity;
+} settings_node_t;
+
+/*
+ * Layout of the settings blob, bump SETTINGS_VERSION on any change and
+ * convert the old layout in settings_migrate()
+ */
+typedef struct {
+    float wander_threshold;
+    float jitter_threshold;
+    float wander_sensitivity;           /* Local link */
+    float jitter_sensitivity;
+    float legacy_sensitivity[2][2];     /* By node ID 1 and 2, taken over from the three-link firmware, 0 if none */
+    uint8_t node_num;
+    settings_node_t nodes[SETTINGS_MAX_NODES];  /* Most recently set first */
+    uint8_t channel;                    /* Picked by the channel survey, added in layout 2 */
+    detect_config_t detect;             /* Local link, added in layout 3 */
+} presence_settings_t;
+
+/* Guarded by g_state_mutex, settings_store.c writes a copy */
+static presence_settings_t g_settings;
+
+static bool detect_config_valid(const detect_config_t *config)
 {
-    if (len == 0) return 0.0f;
-    float *sorted = malloc(len * sizeof(float));
-    if (!sorted) return 0.0f;
-    memcpy(sorted, array, len * sizeof(float));
-    
-    for (size_t i = 0; i < len - 1; i++) {
-        for (size_t j = 0; j < len - i - 1; j++) {
-            if (sorted[j] > sorted[j + 1]) {
-                float temp = sorted[j];
-                sorted[j] = sorted[j + 1];
-                sorted[j + 1] = temp;
-            }
-        }
+    return config->csi_interval_ms >= 1 && config->csi_interval_ms <= DETECT_CSI_INTERVAL_MAX_MS
+           && config->window_len >= 1 && config->window_len <= RADAR_WINDOW_MAX_LEN
+           && config->vote_len >= 1 && config->vote_len <= config->window_len
+           && config->move_votes >= 1 && config->move_votes <= config->vote_len;
+}
+
+/* Per-node key of the previous firmware: 's' followed by the 12 hex digits of the MAC */
+static bool settings_parse_legacy_link_key(const char *key, uint8_t mac[6])
+{
+    unsigned int b[6];
+
+    if (strlen(key) != 13 || sscanf(key, "s%2x%2x%2x%2x%2x%2x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
     }
-    
-    size_t trim = (size_t)(len * percent / 2);
-    float sum = 0;
-    size_t count = 0;
-    for (size_t i = trim; i < len - trim; i++) {
-        sum += sorted[i];
-        count++;
+
+    for (int i = 0; i < 6; i++) {
+        mac[i] = b[i];
     }
-    free(sorted);
-    return count > 0 ? sum / count : 0.0f;
+    return true;
 }
 
-static float median(const float *array, size_t len)
+static bool settings_get_legacy_float(nvs_handle_t handle, const char *key, float *value)
 {
-    if (len == 0) return 0.0f;
-    float *sorted = malloc(len * sizeof(float));
-    if (!sorted) return 0.0f;
-    memcpy(sorted, array, len * sizeof(float));
-    
-    for (size_t i = 0; i < len - 1; i++) {
-        for (size_t j = 0; j < len - i - 1; j++) {
-            if (sorted[j] > sorted[j + 1]) {
-                float temp = sorted[j];
-                sorted[j] = sorted[j + 1];
-                sorted[j + 1] = temp;
-            }
+    size_t len = sizeof(float);
+    return nvs_get_blob(handle, key, value, &len) == ESP_OK && len == sizeof(float);
+}
+
+/**
+ * @brief Take over the separate keys of the previous firmware, which are left in place
+ */
+static bool settings_migrate(nvs_handle_t handle, uint16_t version, const void *blob, size_t len, void *out)
+{
+    presence_settings_t *settings = out;
+    bool found = false;
+
+    /* Layout 1 had everything up to the channel, layout 2 up to the detection tuning */
+    if ((version == 1 && len == offsetof(presence_settings_t, channel))
+            || (version == 2 && len == offsetof(presence_settings_t, detect))) {
+        memcpy(settings, blob, len);
+        return true;
+    }
+
+    if (version != SETTINGS_STORE_VERSION_LEGACY) {
+        ESP_LOGW(TAG, "Unknown settings layout %u, using defaults", version);
+        return false;
+    }
+
+    found |= settings_get_legacy_float(handle, "wander_th", &settings->wander_threshold);
+    found |= settings_get_legacy_float(handle, "jitter_th", &settings->jitter_threshold);
+    found |= settings_get_legacy_float(handle, "link0_w_sens", &settings->wander_sensitivity);
+    found |= settings_get_legacy_float(handle, "link0_j_sens", &settings->jitter_sensitivity);
+
+    for (int node_id = 1; node_id <= 2; node_id++) {
+        char key[NVS_KEY_NAME_MAX_SIZE];
+        float sens[2] = {LINK_DEFAULT_WANDER_SENS, LINK_DEFAULT_JITTER_SENS};
+        bool node_found = false;
+
+        snprintf(key, sizeof(key), "link%d_w_sens", node_id);
+        node_found |= settings_get_legacy_float(handle, key, &sens[0]);
+        snprintf(key, sizeof(key), "link%d_j_sens", node_id);
+        node_found |= settings_get_legacy_float(handle, key, &sens[1]);
+
+        if (node_found) {
+            memcpy(settings->legacy_sensitivity[node_id - 1], sens, sizeof(sens));
+            found = true;
         }
     }
-    
-    float result = (len % 2 == 0) ? 
-        (sorted[len/2 - 1] + sorted[len/2]) / 2.0f : sorted[len/2];
-    free(sorted);
-    return result;
+
+    nvs_iterator_t it = NULL;
+    esp_err_t ret = nvs_entry_find(NVS_DEFAULT_PART_NAME, NVS_NAMESPACE, NVS_TYPE_BLOB, &it);
+    while (ret == ESP_OK && settings->node_num < SETTINGS_MAX_NODES) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+
+        settings_node_t *node = &settings->nodes[settings->node_num];
+        float sens[2];
+        size_t sens_len = sizeof(sens);
+        if (settings_parse_legacy_link_key(info.key, node->mac)
+                && nvs_get_blob(handle, info.key, sens, &sens_len) == ESP_OK && sens_len == sizeof(sens)) {
+            node->wander_sensitivity = sens[0];
+            node->jitter_sensitivity = sens[1];
+            settings->node_num++;
+            found = true;
+        }
+
+        ret = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+
+    return found;
 }
 
-/* NVS Storage - persist calibration and sensitivity across power cycles */
-#define NVS_NAMESPACE "presence"
+static void settings_load(void)
+{
+    g_settings = (presence_settings_t) {
+        .wander_threshold = g_state.wander_threshold,
+        .jitter_threshold = g_state.jitter_threshold,
+        .wander_sensitivity = LINK_DEFAULT_WANDER_SENS,
+        .jitter_sensitivity = LINK_DEFAULT_JITTER_SENS,
+        .channel = CONFIG_WIFI_CHANNEL,
+        .detect = DETECT_CONFIG_DEFAULT(),
+    };
+
+    settings_store_config_t config = SETTINGS_STORE_CONFIG_DEFAULT();
+    config.nvs_namespace = NVS_NAMESPACE;
+    config.version = SETTINGS_VERSION;
+    config.size = sizeof(presence_settings_t);
+    config.debounce_ms = CONFIG_SETTINGS_DEBOUNCE_MS;
+    config.max_delay_ms = CONFIG_SETTINGS_MAX_DELAY_MS;
+    config.migrate = settings_migrate;
+    ESP_ERROR_CHECK(settings_store_init(&config, &g_settings));
+
+    g_state.wander_threshold = g_settings.wander_threshold;
+    g_state.jitter_threshold = g_settings.jitter_threshold;
+    g_state.links[0].wander_sensitivity = g_settings.wander_sensitivity;
+    g_state.links[0].jitter_sensitivity = g_settings.jitter_sensitivity;
+    if (g_settings.channel >= 1 && g_settings.channel <= CHANNEL_SURVEY_MAX) {
+        g_channel.channel = g_settings.channel;
+    }
+    if (detect_config_valid(&g_settings.detect)) {
+        g_state.links[0].detect = g_settings.detect;
+    }
 
-static void nvs_save_settings(void)
+    const detect_config_t *detect = &g_state.links[0].detect;
+    ESP_LOGI(TAG, "Settings: wander_th=%.6f, jitter_th=%.6f, local link sensitivity %.2f/%.2f, %d slave nodes, channel %d",
+             g_state.wander_threshold, g_state.jitter_threshold,
+             g_state.links[0].wander_sensitivity, g_state.links[0].jitter_sensitivity, g_settings.node_num,
+             g_channel.channel);
+    ESP_LOGI(TAG, "Detection: CSI every %u ms, window %u, %u of %u votes",
+             detect->csi_interval_ms, detect->window_len, detect->move_votes, detect->vote_len);
+}
+
+/**
+ * @brief Schedule a write of the thresholds, the local link sensitivity and its detection tuning
+ */
+static void settings_save(void)
 {
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
-        return;
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    g_settings.wander_threshold = g_state.wander_threshold;
+    g_settings.jitter_threshold = g_state.jitter_threshold;
+    g_settings.wander_sensitivity = g_state.links[0].wander_sensitivity;
+    g_settings.jitter_sensitivity = g_state.links[0].jitter_sensitivity;
+    g_settings.detect = g_state.links[0].detect;
+    settings_store_save(&g_settings);
+    xSemaphoreGive(g_state_mutex);
+}
+
+/**
+ * @brief Save the sensitivity of a slave link under its MAC, so it follows the node across slots and reboots
+ */
+static void settings_save_link_sensitivity(const uint8_t mac[6], float wander_sens, float jitter_sens)
+{
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    int idx = 0;
+    while (idx < g_settings.node_num && memcmp(g_settings.nodes[idx].mac, mac, 6)) {
+        idx++;
     }
-    
-    /* Save thresholds */
-    nvs_set_blob(handle, "wander_th", &g_state.wander_threshold, sizeof(float));
-    nvs_set_blob(handle, "jitter_th", &g_state.jitter_threshold, sizeof(float));
-    
-    /* Save sensitivity for all links */
-    nvs_set_blob(handle, "link0_w_sens", &g_state.links[0].wander_sensitivity, sizeof(float));
-    nvs_set_blob(handle, "link0_j_sens", &g_state.links[0].jitter_sensitivity, sizeof(float));
-    nvs_set_blob(handle, "link1_w_sens", &g_state.links[1].wander_sensitivity, sizeof(float));
-    nvs_set_blob(handle, "link1_j_sens", &g_state.links[1].jitter_sensitivity, sizeof(float));
-    nvs_set_blob(handle, "link2_w_sens", &g_state.links[2].wander_sensitivity, sizeof(float));
-    nvs_set_blob(handle, "link2_j_sens", &g_state.links[2].jitter_sensitivity, sizeof(float));
-    
-    nvs_commit(handle);
-    nvs_close(handle);
-    
-    ESP_LOGI(TAG, "Settings saved to NVS");
+
+    /* Move to the front, a new node drops the last entry when the table is full */
+    if (idx == g_settings.node_num && g_settings.node_num < SETTINGS_MAX_NODES) {
+        g_settings.node_num++;
+    }
+    idx = MIN(idx, SETTINGS_MAX_NODES - 1);
+    memmove(&g_settings.nodes[1], &g_settings.nodes[0], idx * sizeof(settings_node_t));
+
+    settings_node_t *node = &g_settings.nodes[0];
+    memcpy(node->mac, mac, sizeof(node->mac));
+    node->wander_sensitivity = wander_sens;
+    node->jitter_sensitivity = jitter_sens;
+    settings_store_save(&g_settings);
+    xSemaphoreGive(g_state_mutex);
 }
 
-static void nvs_load_settings(void)
+/**
+ * @brief Look up the saved sensitivity of a slave link, left unchanged if none is saved
+ *
+ * Falls back to the values of the three-link firmware, where the slot index
+ * was the node ID. The caller holds g_state_mutex.
+ */
+static void settings_find_link_sensitivity(const uint8_t mac[6], uint8_t node_id, float *wander_sens, float *jitter_sens)
 {
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "No saved settings found, using defaults");
-        return;
+    for (int i = 0; i < g_settings.node_num; i++) {
+        if (!memcmp(g_settings.nodes[i].mac, mac, 6)) {
+            *wander_sens = g_settings.nodes[i].wander_sensitivity;
+            *jitter_sens = g_settings.nodes[i].jitter_sensitivity;
+            return;
+        }
+    }
+
+    if ((node_id == 1 || node_id == 2) && g_settings.legacy_sensitivity[node_id - 1][0] > 0) {
+        *wander_sens = g_settings.legacy_sensitivity[node_id - 1][0];
+        *jitter_sens = g_settings.legacy_sensitivity[node_id - 1][1];
     }
-    
-    size_t len = sizeof(float);
-    
-    /* Load thresholds */
-    nvs_get_blob(handle, "wander_th", &g_state.wander_threshold, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "jitter_th", &g_state.jitter_threshold, &len);
-    
-    /* Load sensitivity for all links */
-    len = sizeof(float);
-    nvs_get_blob(handle, "link0_w_sens", &g_state.links[0].wander_sensitivity, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "link0_j_sens", &g_state.links[0].jitter_sensitivity, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "link1_w_sens", &g_state.links[1].wander_sensitivity, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "link1_j_sens", &g_state.links[1].jitter_sensitivity, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "link2_w_sens", &g_state.links[2].wander_sensitivity, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "link2_j_sens", &g_state.links[2].jitter_sensitivity, &len);
-    
-    nvs_close(handle);
-    
-    ESP_LOGI(TAG, "Settings loaded from NVS: wander_th=%.6f, jitter_th=%.6f",
-             g_state.wander_threshold, g_state.jitter_threshold);
-    ESP_LOGI(TAG, "Link sensitivities: [0]%.2f/%.2f [1]%.2f/%.2f [2]%.2f/%.2f",
-             g_state.links[0].wander_sensitivity, g_state.links[0].jitter_sensitivity,
-             g_state.links[1].wander_sensitivity, g_state.links[1].jitter_sensitivity,
-             g_state.links[2].wander_sensitivity, g_state.links[2].jitter_sensitivity);
 }
 
 /* LED functions */
@@ -309,6 +663,16 @@ static void led_update(void)
     led_strip_refresh(g_led_strip);
 }
 
+/* WebSocket push requests, see ws_broadcast_task() */
+#define WS_NOTIFY_UPDATE        BIT0    /* Values changed */
+#define WS_NOTIFY_TRANSITION    BIT1    /* Room/motion/link/calibration state changed */
+#define WS_NOTIFY_FORCE         BIT2    /* Send even if unchanged, e.g. a new client */
+#define WS_NOTIFY_POLL          BIT3    /* A long-poll was parked, recheck its generation */
+#define WS_CALIBRATION_CHECK_MS 250
+
+static TaskHandle_t g_ws_task = NULL;
+static void ws_notify(uint32_t events);
+
 /**
  * @brief Recalculate detection status for a single link based on its sensitivity
  * 
@@ -340,56 +704,142 @@ static void recalculate_link_status(int link_idx)
 }
 
 /**
- * @brief Fuse multi-link detection results using voting
+ * @brief Find the slot of a slave node, registering it on its first report
+ *
+ * Fusion task only. A new node takes a free slot, or else the slot of the
+ * inactive node that has been silent the longest. Its sensitivity is
+ * restored from NVS by MAC.
+ *
+ * @return Link index, -1 if every slot holds an active node
+ */
+static int link_registry_join(const uint8_t mac[6], uint8_t node_id)
+{
+    uint32_t now = esp_log_timestamp();
+    int free_slot = -1;
+    int stale_slot = -1;
+    uint32_t stale_age = 0;
+
+    for (int i = 1; i < CONFIG_MAX_LINKS; i++) {
+        const link_status_t *link = &g_state.links[i];
+
+        if (!link->used) {
+            if (free_slot < 0) {
+                free_slot = i;
+            }
+        } else if (!memcmp(link->mac, mac, sizeof(link->mac))) {
+            return i;
+        } else if (!link->active && now - link->last_update >= stale_age) {
+            stale_slot = i;
+            stale_age = now - link->last_update;
+        }
+    }
+
+    int slot = free_slot >= 0 ? free_slot : stale_slot;
+    if (slot < 0) {
+        return -1;
+    }
+
+    if (g_state.links[slot].used) {
+        ESP_LOGI(TAG, "Link %d: node " MACSTR " replaced by " MACSTR,
+                 slot, MAC2STR(g_state.links[slot].mac), MAC2STR(mac));
+    }
+
+    float wander_sens = LINK_DEFAULT_WANDER_SENS;
+    float jitter_sens = LINK_DEFAULT_JITTER_SENS;
+
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    settings_find_link_sensitivity(mac, node_id, &wander_sens, &jitter_sens);
+    link_status_t *link = &g_state.links[slot];
+    memset(link, 0, sizeof(link_status_t));
+    link->used = true;
+    memcpy(link->mac, mac, sizeof(link->mac));
+    link->node_id = node_id;
+    link->last_update = now;
+    link->duty_permille = 1000;
+    link->wander_sensitivity = wander_sens;
+    link->jitter_sensitivity = jitter_sens;
+    xSemaphoreGive(g_state_mutex);
+    time_sync_init(&g_link_clocks[slot]);
+
+    ESP_LOGI(TAG, "Link %d: node " MACSTR " (id %d) joined, sensitivity %.2f/%.2f",
+             slot, MAC2STR(mac), node_id, wander_sens, jitter_sens);
+
+    return slot;
+}
+
+/* Vote weights of the links, see presence_vote_weight() */
+static const presence_vote_config_t s_vote_config = {
+    .ratio = CONFIG_FUSION_PRESENCE_RATIO,
+    .rssi_floor_dbm = FUSION_RSSI_WEIGHT_FLOOR_DBM,
+    .rssi_span_db = FUSION_RSSI_WEIGHT_SPAN_DB,
+    .rssi_weight_min = FUSION_RSSI_WEIGHT_MIN,
+    .timeout_ms = LINK_TIMEOUT_MS,
+};
+
+/**
+ * @brief Fuse multi-link detection results using a confidence-weighted vote
  * 
  * Logic:
  * - Link 0 (local): use sensitivity settings on master
- * - Link 1, 2 (slaves): use their own detection results (they have their own calibration)
- * - >=2 links detect (presence OR motion) -> room has person
- * - >=2 links detect motion -> person is moving
+ * - Slave links: use their own detection results (they have their own calibration)
+ * - Each active link votes with presence_vote_weight(): RSSI and report age,
+ *   the local radar callback has no RSSI and counts at full signal weight
+ * - Weighted share of links detecting (presence OR motion) > CONFIG_FUSION_PRESENCE_RATIO -> room has person
+ * - Weighted share of links detecting motion > CONFIG_FUSION_PRESENCE_RATIO -> person is moving
+ *
+ * With equal weights and the default ratio of 0.5 this is the former
+ * 1-of-1, 2-of-2 and 2-of-3 vote. Slaves silent for LINK_EVICT_MS leave the registry.
  */
 static void fuse_detection_results(void)
 {
     uint32_t now = esp_log_timestamp();
-    int detection_count = 0;  /* Links detecting anything (presence or motion) */
-    int motion_count = 0;     /* Links detecting motion specifically */
-    int active_count = 0;
+    presence_vote_t votes[CONFIG_MAX_LINKS];
+    size_t vote_num = 0;
+    presence_vote_config_t vote_config = s_vote_config;
     
-    for (int i = 0; i < 3; i++) {
+    /* Thresholds and sensitivity may be changed by the HTTP handlers */
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+
+    /* Between two bursts no link reports, the last burst still votes until the next one */
+    if (g_state.power_mode == POWER_MODE_DUTY || g_state.power_wake_start) {
+        vote_config.timeout_ms += CONFIG_POWER_CYCLE_MS;
+    }
+
+    for (int i = 0; i < CONFIG_MAX_LINKS; i++) {
+        link_status_t *link = &g_state.links[i];
+        uint32_t age = now - link->last_update;
+
+        if (!link->used) {
+            continue;
+        }
+
+        if (i > 0 && age >= LINK_EVICT_MS) {
+            ESP_LOGI(TAG, "Link %d: node " MACSTR " left, silent for %lu ms",
+                     i, MAC2STR(link->mac), (unsigned long)age);
+            memset(link, 0, sizeof(link_status_t));
+            continue;
+        }
+
         /* Check if link is still active */
-        if (g_state.links[i].active && 
-            (now - g_state.links[i].last_update) < LINK_TIMEOUT_MS) {
-            
-            active_count++;
-            
+        if (link->active && age < vote_config.timeout_ms) {
             /* Only recalculate for local link (0), slaves send their own detection */
             if (i == 0) {
                 recalculate_link_status(i);
             }
-            /* Slaves (i=1,2) already have room_status/human_status set from their report */
             
-            /* Count detections */
-            if (g_state.links[i].room_status || g_state.links[i].human_status) {
-                detection_count++;
-            }
-            if (g_state.links[i].human_status) {
-                motion_count++;
-            }
+            link->weight = presence_vote_weight(&vote_config, i > 0, link->rssi, age);
+            votes[vote_num++] = (presence_vote_t) {
+                .weight = link->weight,
+                .room_status = link->room_status,
+                .human_status = link->human_status,
+            };
         } else {
-            g_state.links[i].active = false;
+            link->active = false;
+            link->weight = 0;
         }
     }
     
-    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
-    
-    /* Adaptive threshold based on active links */
-    int min_detection = (active_count >= 2) ? 2 : 1;
-    
-    /* Room has person: >=min_detection links detect something */
-    g_state.room_status = (detection_count >= min_detection);
-    
-    /* Person moving: >=min_detection links detect motion */
-    g_state.human_status = g_state.room_status && (motion_count >= min_detection);
+    presence_vote_fuse(&vote_config, votes, vote_num, &g_state.room_status, &g_state.human_status);
     
     xSemaphoreGive(g_state_mutex);
     
@@ -397,163 +847,1140 @@ static void fuse_detection_results(void)
 }
 
 /**
- * @brief WiFi radar callback for local CSI processing (Link 1)
+ * @brief Fusion task: publish a new status version, single writer
  */
-static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
+static void status_snapshot_publish(void)
 {
-    uint32_t buff_min_size = 5;
-    
-    g_state.wander_buff[g_state.buff_count % RADAR_BUFF_MAX_LEN] = info->waveform_wander;
-    g_state.jitter_buff[g_state.buff_count % RADAR_BUFF_MAX_LEN] = info->waveform_jitter;
-    g_state.buff_count++;
-    
-    if (g_state.buff_count < buff_min_size) return;
-    
-    /* Calculate smoothed values */
-    float wander_avg = trimmean(g_state.wander_buff, RADAR_BUFF_MAX_LEN, 0.5f);
-    float jitter_med = median(g_state.jitter_buff, RADAR_BUFF_MAX_LEN);
-    
-    /* Update Link 0 (local) - store raw values only */
-    /* Status will be calculated by recalculate_link_status() based on per-link sensitivity */
-    g_state.links[0].active = true;
-    g_state.links[0].wander = wander_avg;
-    g_state.links[0].jitter = jitter_med;
-    g_state.links[0].last_update = esp_log_timestamp();
-    
-    /* Fuse all links (this calls recalculate_link_status for each) */
-    fuse_detection_results();
+    uint32_t seq = g_status_snapshot.seq;
+
+    __atomic_store_n(&g_status_snapshot.seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    g_status_snapshot.status.room_status = g_state.room_status;
+    g_status_snapshot.status.human_status = g_state.human_status;
+    g_status_snapshot.status.calibrating = g_state.calibrating;
+    g_status_snapshot.status.wander_threshold = g_state.wander_threshold;
+    g_status_snapshot.status.jitter_threshold = g_state.jitter_threshold;
+    g_status_snapshot.status.power_mode = g_state.power_mode;
+    g_status_snapshot.status.power_wakes = g_state.power_wakes;
+    g_status_snapshot.status.power_wake_latency_ms = g_state.power_wake_latency_ms;
+    g_status_snapshot.status.power_wake_latency_max_ms = g_state.power_wake_latency_max_ms;
+    memcpy(g_status_snapshot.status.links, g_state.links, sizeof(g_state.links));
+    xSemaphoreGive(g_state_mutex);
+
+    __atomic_store_n(&g_status_snapshot.seq, seq + 2, __ATOMIC_RELEASE);
 }
 
 /**
- * @brief ESP-NOW receive callback - handle reports from slaves
+ * @brief Generation of the latest completely published status, any task
  */
-static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len)
+static uint32_t status_generation(void)
 {
-    if (len < sizeof(slave_report_t)) return;
-    
-    slave_report_t *report = (slave_report_t *)data;
-    
-    if (report->msg_type == 0x01 && report->node_id >= 1 && report->node_id <= MAX_SLAVE_NODES) {
-        int link_idx = report->node_id;  /* 1 or 2 */
-        
-        /* Use slave's own detection results - they have their own calibrated thresholds */
-        /* This is more accurate because each device has different signal characteristics */
-        g_state.links[link_idx].active = true;
-        g_state.links[link_idx].room_status = report->room_status;    /* Trust slave's detection */
-        g_state.links[link_idx].human_status = report->human_status;  /* Trust slave's detection */
-        g_state.links[link_idx].wander = report->wander;
-        g_state.links[link_idx].jitter = report->jitter;
-        g_state.links[link_idx].rssi = report->rssi;
-        g_state.links[link_idx].last_update = esp_log_timestamp();
-        
-        ESP_LOGD(TAG, "Slave %d: room=%d, move=%d, wander=%.6f, jitter=%.6f",
-                 report->node_id, report->room_status, report->human_status,
-                 report->wander, report->jitter);
-        
-        fuse_detection_results();
-    }
+    return __atomic_load_n(&g_status_snapshot.seq, __ATOMIC_ACQUIRE) / 2;
 }
 
 /**
- * @brief Broadcast calibration command to slaves
+ * @brief Copy the latest published status, any task
+ *
+ * @return Generation of the copy
  */
-static void broadcast_calibration_cmd(uint8_t cmd)
+static uint32_t status_snapshot_read(presence_status_t *status)
 {
-    uint8_t broadcast_addr[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
-    esp_now_send(broadcast_addr, &cmd, 1);
-}
+    while (1) {
+        uint32_t seq = __atomic_load_n(&g_status_snapshot.seq, __ATOMIC_ACQUIRE);
 
-/* HTTP Handlers */
-static esp_err_t http_get_index(httpd_req_t *req)
-{
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, (const char *)index_html_start, 
-                    index_html_end - index_html_start);
-    return ESP_OK;
+        if (!(seq & 1)) {
+            *status = g_status_snapshot.status;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (__atomic_load_n(&g_status_snapshot.seq, __ATOMIC_RELAXED) == seq) {
+                return seq / 2;
+            }
+        }
+
+        /* The writer may be a lower priority task, let it finish */
+        vTaskDelay(1);
+    }
 }
 
-static esp_err_t http_get_style(httpd_req_t *req)
+/**
+ * @brief Queue an event for the fusion task, never blocks
+ */
+static void fusion_post(fusion_event_t *event)
 {
-    httpd_resp_set_type(req, "text/css");
-    httpd_resp_send(req, (const char *)style_css_start,
-                    style_css_end - style_css_start);
-    return ESP_OK;
+    event->post_us = esp_timer_get_time();
+
+    if (!g_fusion_queue.handle || !csi_queue_send(&g_fusion_queue, event)) {
+        csi_perf_drop(g_perf_fusion_queue);
+    }
 }
 
-static esp_err_t http_get_script(httpd_req_t *req)
+static void fusion_post_refresh(void)
 {
-    httpd_resp_set_type(req, "application/javascript");
-    httpd_resp_send(req, (const char *)app_js_start,
-                    app_js_end - app_js_start);
-    return ESP_OK;
+    fusion_event_t event = { .type = FUSION_EVENT_REFRESH };
+    fusion_post(&event);
 }
 
-static esp_err_t http_get_status(httpd_req_t *req)
+/**
+ * @brief Feed the sync pair of a slave report and date its values on the master timebase
+ *
+ * Until the clock estimate is locked the report is dated by its arrival.
+ */
+static void link_clock_update(int idx, const fusion_event_t *event)
 {
-    char buf[512];
-    
-    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
-    int len = snprintf(buf, sizeof(buf),
-        "{\"room\":%d,\"moving\":%d,\"calibrating\":%d,"
-        "\"links\":[{\"active\":%d,\"room\":%d,\"move\":%d,\"wander\":%.6f,\"jitter\":%.6f},"
-        "{\"active\":%d,\"room\":%d,\"move\":%d,\"wander\":%.6f,\"jitter\":%.6f},"
-        "{\"active\":%d,\"room\":%d,\"move\":%d,\"wander\":%.6f,\"jitter\":%.6f}]}",
-        g_state.room_status ? 1 : 0,
-        g_state.human_status ? 1 : 0,
-        g_state.calibrating ? 1 : 0,
-        g_state.links[0].active ? 1 : 0, g_state.links[0].room_status ? 1 : 0,
-        g_state.links[0].human_status ? 1 : 0, g_state.links[0].wander, g_state.links[0].jitter,
-        g_state.links[1].active ? 1 : 0, g_state.links[1].room_status ? 1 : 0,
-        g_state.links[1].human_status ? 1 : 0, g_state.links[1].wander, g_state.links[1].jitter,
-        g_state.links[2].active ? 1 : 0, g_state.links[2].room_status ? 1 : 0,
-        g_state.links[2].human_status ? 1 : 0, g_state.links[2].wander, g_state.links[2].jitter);
-    xSemaphoreGive(g_state_mutex);
-    
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, buf, len);
-    return ESP_OK;
+    time_sync_t *clock = &g_link_clocks[idx];
+    link_status_t *link = &g_state.links[idx];
+    int64_t measured_us = event->rx_us;
+
+    if (event->sync_valid) {
+        int64_t beacon_remote_us = clock->pairs ? time_sync_extend32(clock, event->sync_time_us) : event->sync_time_us;
+        time_sync_update(clock, beacon_remote_us, event->beacon_local_us);
+    }
+
+    link->synced = time_sync_locked(clock);
+    if (link->synced) {
+        /* A report cannot be measured after it arrived, clamp the estimate error */
+        measured_us = MIN(time_sync_to_local(clock, time_sync_extend32(clock, event->report_time_us)), event->rx_us);
+    }
+
+    int64_t age_us = esp_timer_get_time() - measured_us;
+    uint32_t age_ms = age_us / 1000;
+    csi_perf_record(g_perf_report_age, age_us);
+    link->report_age_ms = MIN(age_ms, UINT16_MAX);
+    link->sync_error_us = MIN(clock->residual_us, UINT16_MAX);
+    link->clock_drift_ppm = time_sync_drift_ppm(clock);
+    link->last_update = esp_log_timestamp() - age_ms;
 }
 
+/* Calibration commands to the slaves, see recv_slave espnow_recv_cb() */
+#define CALIB_CMD_START             0x10    /* [flags], CALIB_CMD_FLAG_* */
+#define CALIB_CMD_STOP              0x11    /* [weight], share of the run in the thresholds out of 255 */
+#define CALIB_CMD_ABORT             0x14    /* Drop the run, keep the thresholds */
+#define CALIB_CMD_FLAG_BACKGROUND   BIT0    /* Empty room run, no calibration LED */
+#define CALIB_CMD_WEIGHT_REPLACE    255
+
 /**
- * @brief Stop calibration and get thresholds
+ * @brief Broadcast calibration command to slaves
  */
-static void finish_calibration(void)
+static void broadcast_calibration_cmd(uint8_t cmd, uint8_t arg)
 {
-    if (!g_state.calibrating) return;
-    
-    ESP_LOGI(TAG, "Stopping calibration...");
-    esp_radar_train_stop(&g_state.wander_threshold, &g_state.jitter_threshold);
-    g_state.calibrating = false;
-    broadcast_calibration_cmd(0x11);
-    
-    ESP_LOGI(TAG, "Calibration done: wander_th=%.6f, jitter_th=%.6f",
-             g_state.wander_threshold, g_state.jitter_threshold);
-    
-    /* Save to NVS */
-    nvs_save_settings();
+    uint8_t broadcast_addr[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    uint8_t buf[2] = {cmd, arg};
+    espnow_rate_send(broadcast_addr, ESPNOW_RATE_CLASS_CONTROL, buf, sizeof(buf));
 }
 
-static esp_err_t http_post_calibrate(httpd_req_t *req)
-{
-    char buf[64];
+/**
+ * @brief Fusion task: feed the calibration and run the background re-baselining
+ *
+ * Once the fused room status has been empty for CONFIG_CALIB_BACKGROUND_VACANT_MS
+ * a background run collects the default 30 s of local samples, the slaves
+ * collect their own. The run is dropped as soon as the room is
+ * occupied; a complete one moves the thresholds by CONFIG_CALIB_BACKGROUND_WEIGHT.
+ * Detection keeps the current thresholds throughout.
+ */
+static void calibration_update(const fusion_event_t *event)
+{
+    uint32_t now = esp_log_timestamp();
+    uint8_t cmd = 0;
+    uint8_t arg = 0;
+    online_calib_result_t result = {0};
+
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+
+    if (event && (g_state.calibrating || g_state.background_running)) {
+        online_calib_push(&g_state.calib, event->wander, event->jitter);
+    }
+
+    if (g_state.room_status) {
+        g_state.vacant_since = now;
+    }
+
+    if (g_state.calibrating) {
+        /* The manual run owns the samples */
+    } else if (g_state.background_running) {
+        if (g_state.room_status || !g_state.background_enable) {
+            g_state.background_running = false;
+            g_state.background_aborts++;
+            cmd = CALIB_CMD_ABORT;
+        } else if (online_calib_complete(&g_state.calib)) {
+            online_calib_get(&g_state.calib, &result);
+            g_state.wander_threshold = online_calib_blend(g_state.wander_threshold, result.wander_threshold,
+                                                          CONFIG_CALIB_BACKGROUND_WEIGHT);
+            g_state.jitter_threshold = online_calib_blend(g_state.jitter_threshold, result.jitter_threshold,
+                                                          CONFIG_CALIB_BACKGROUND_WEIGHT);
+            g_state.background_running = false;
+            g_state.background_last = now;
+            g_state.background_runs++;
+            cmd = CALIB_CMD_STOP;
+            arg = CONFIG_CALIB_BACKGROUND_WEIGHT * CALIB_CMD_WEIGHT_REPLACE;
+        }
+    } else if (g_state.background_enable && g_state.wander_threshold > 0
+               && now - g_state.vacant_since >= CONFIG_CALIB_BACKGROUND_VACANT_MS
+               && (!g_state.background_runs || now - g_state.background_last >= CONFIG_CALIB_BACKGROUND_INTERVAL_MS)) {
+        /* Only re-baselines an existing calibration, an unset threshold never reports presence */
+        online_calib_init(&g_state.calib, NULL);
+        g_state.background_running = true;
+        cmd = CALIB_CMD_START;
+        arg = CALIB_CMD_FLAG_BACKGROUND;
+    }
+
+    xSemaphoreGive(g_state_mutex);
+
+    if (!cmd) {
+        return;
+    }
+
+    broadcast_calibration_cmd(cmd, arg);
+
+    if (cmd == CALIB_CMD_START) {
+        ESP_LOGI(TAG, "Room empty for %lu s, background calibration started",
+                 (unsigned long)((now - g_state.vacant_since) / 1000));
+    } else if (cmd == CALIB_CMD_ABORT) {
+        ESP_LOGI(TAG, "Background calibration dropped, room occupied");
+    } else {
+        ESP_LOGI(TAG, "Background calibration done: wander_th=%.6f, jitter_th=%.6f (run %.6f/%.6f, confidence %.2f)",
+                 g_state.wander_threshold, g_state.jitter_threshold,
+                 result.wander_threshold, result.jitter_threshold, result.confidence);
+        settings_save();
+    }
+}
+
+/**
+ * @brief Broadcast the duty cycle to the sender and the slaves
+ */
+static void broadcast_power_cmd(uint8_t mode)
+{
+    uint8_t broadcast_addr[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    uint16_t cycle_slots = POWER_MS_TO_SLOTS(CONFIG_POWER_CYCLE_MS);
+    uint16_t burst_slots = POWER_MS_TO_SLOTS(CONFIG_POWER_BURST_MS);
+    uint8_t buf[6] = {POWER_CMD, mode};
+
+    memcpy(buf + 2, &cycle_slots, sizeof(cycle_slots));
+    memcpy(buf + 4, &burst_slots, sizeof(burst_slots));
+    espnow_rate_send(broadcast_addr, ESPNOW_RATE_CLASS_CONTROL, buf, sizeof(buf));
+}
+
+/**
+ * @brief Fusion task: duty-cycle the sender and the slaves while the room stays empty
+ *
+ * After CONFIG_POWER_VACANT_MS without presence, and without a calibration,
+ * the sender only sends the first CONFIG_POWER_BURST_MS of every
+ * CONFIG_POWER_CYCLE_MS and the slaves sleep in between. Presence fused from
+ * a burst, a slave back to continuous mode on its own detection, or a manual
+ * calibration wakes every node. The wake-up is repeated until each slave that
+ * was duty-cycled reports continuous mode, which gives the wake latency.
+ */
+static void power_update(void)
+{
+    uint32_t now = esp_log_timestamp();
+    int cmd = -1;
+    bool changed = false;
+    uint32_t latency_ms = 0;
+    int pending = 0;
+
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+
+    bool wake = !CONFIG_POWER_DUTY_ENABLE || g_state.room_status || g_state.calibrating;
+
+    if (g_state.power_mode == POWER_MODE_DUTY) {
+        if (wake || g_state.power_wake_request) {
+            g_state.power_mode = POWER_MODE_CONTINUOUS;
+            g_state.power_since = now;
+            g_state.power_wake_start = now;
+            g_state.power_wakes++;
+            cmd = POWER_MODE_CONTINUOUS;
+            changed = true;
+        } else if (now - g_state.power_cmd_last >= CONFIG_POWER_ANNOUNCE_MS) {
+            cmd = POWER_MODE_DUTY;
+        }
+    } else if (g_state.power_wake_start) {
+        for (int i = 1; i < CONFIG_MAX_LINKS; i++) {
+            pending += g_state.links[i].used && g_state.links[i].power_mode == POWER_MODE_DUTY;
+        }
+
+        /* A slave that never answers within two cycles is gone, it rejoins in continuous mode */
+        if (!pending || now - g_state.power_wake_start >= 2 * CONFIG_POWER_CYCLE_MS) {
+            latency_ms = now - g_state.power_wake_start;
+            g_state.power_wake_start = 0;
+            if (!pending) {
+                g_state.power_wake_latency_ms = latency_ms;
+                g_state.power_wake_latency_max_ms = MAX(g_state.power_wake_latency_max_ms, latency_ms);
+            }
+        } else if (now - g_state.power_cmd_last >= CONFIG_POWER_WAKE_REPEAT_MS) {
+            cmd = POWER_MODE_CONTINUOUS;
+        }
+    } else if (!wake && !g_state.background_running
+               && now - g_state.vacant_since >= CONFIG_POWER_VACANT_MS
+               && now - g_state.power_since >= CONFIG_POWER_VACANT_MS) {
+        /* A wake-up without presence, e.g. a calibration, also restarts the wait */
+        g_state.power_mode = POWER_MODE_DUTY;
+        g_state.power_since = now;
+        cmd = POWER_MODE_DUTY;
+        changed = true;
+    }
+
+    g_state.power_wake_request = false;
+    if (cmd >= 0) {
+        g_state.power_cmd_last = now;
+    }
+
+    xSemaphoreGive(g_state_mutex);
+
+    if (cmd >= 0) {
+        broadcast_power_cmd(cmd);
+    }
+
+    if (changed && cmd == POWER_MODE_DUTY) {
+        ESP_LOGI(TAG, "Room empty for %lu s, duty cycle %d of %d ms",
+                 (unsigned long)((now - g_state.vacant_since) / 1000), CONFIG_POWER_BURST_MS, CONFIG_POWER_CYCLE_MS);
+    } else if (changed) {
+        ESP_LOGI(TAG, "Continuous mode, waking the nodes");
+    } else if (latency_ms) {
+        if (pending) {
+            ESP_LOGW(TAG, "Wake-up: %d slaves still duty-cycled after %lu ms", pending, (unsigned long)latency_ms);
+        } else {
+            ESP_LOGI(TAG, "Wake-up: every slave continuous after %lu ms", (unsigned long)latency_ms);
+        }
+    }
+}
+
+/**
+ * @brief Owns the local windows and the per-link detection state
+ *
+ * Radar and ESP-NOW callbacks only post fixed-size events; all smoothing,
+ * fusion and LED updates happen here, then the status is published and the
+ * WebSocket task notified.
+ */
+static void fusion_task(void *arg)
+{
+    uint32_t last_state = UINT32_MAX;
+    uint8_t last_link_state[CONFIG_MAX_LINKS] = {0};
+    fusion_event_t event;
+
+    while (1) {
+        bool refresh = false;
+        bool local = false;
+
+        int64_t start_us = csi_perf_begin();
+
+        if (csi_queue_receive(&g_fusion_queue, &event, pdMS_TO_TICKS(FUSION_IDLE_CHECK_MS))) {
+            start_us = csi_perf_begin();
+            csi_perf_record(g_perf_fusion_queue, start_us - event.post_us);
+
+            switch (event.type) {
+            case FUSION_EVENT_LOCAL: {
+                local = true;
+
+                /* A window length set on /api/detect keeps the newest samples, nothing is reallocated */
+                xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+                detect_config_t detect = g_state.links[0].detect;
+                xSemaphoreGive(g_state_mutex);
+                if (g_state.wander_win.size != detect.window_len) {
+                    radar_window_set_size(&g_state.wander_win, detect.window_len);
+                    radar_window_set_size(&g_state.jitter_win, detect.window_len);
+                }
+
+                radar_window_push(&g_state.wander_win, event.wander);
+                radar_window_push(&g_state.jitter_win, event.jitter);
+
+                if (g_state.wander_win.count < detect.vote_len) {
+                    continue;
+                }
+
+                /* Update Link 0 (local) - store smoothed raw values only */
+                /* Status will be calculated by recalculate_link_status() based on per-link sensitivity */
+                if (!g_state.links[0].active) {
+                    csi_boot_mark("first_detection");
+                }
+                g_state.links[0].active = true;
+                g_state.links[0].wander = radar_window_trimmean(&g_state.wander_win, 0.5f);
+                g_state.links[0].jitter = radar_window_median(&g_state.jitter_win);
+                g_state.links[0].last_update = esp_log_timestamp();
+                break;
+            }
+
+            case FUSION_EVENT_SLAVE: {
+                int idx = link_registry_join(event.mac, event.node_id);
+                if (idx < 0) {
+                    g_link_join_rejects++;
+                    ESP_LOGD(TAG, "Registry full, report from " MACSTR " dropped", MAC2STR(event.mac));
+                    continue;
+                }
+
+                /* Use slave's own detection results - they have their own calibrated thresholds */
+                link_status_t *link = &g_state.links[idx];
+                link->active = true;
+                link->node_id = event.node_id;
+                link->room_status = event.room_status;
+                link->human_status = event.human_status;
+                link->wander = event.wander;
+                link->jitter = event.jitter;
+                link->rssi = event.rssi;
+                link_clock_update(idx, &event);
+
+                ESP_LOGD(TAG, "Link %d (node %d): room=%d, move=%d, wander=%.6f, jitter=%.6f",
+                         idx, event.node_id, event.room_status, event.human_status,
+                         event.wander, event.jitter);
+                break;
+            }
+
+            case FUSION_EVENT_POWER: {
+                int idx = link_registry_join(event.mac, event.node_id);
+                if (idx < 0) {
+                    g_link_join_rejects++;
+                    continue;
+                }
+
+                link_status_t *link = &g_state.links[idx];
+                if (g_state.power_mode == POWER_MODE_DUTY && link->power_mode == POWER_MODE_DUTY
+                        && event.power_mode == POWER_MODE_CONTINUOUS) {
+                    g_state.power_wake_request = true;
+                }
+                refresh = link->power_mode != event.power_mode;
+                link->power_mode = event.power_mode;
+                link->duty_permille = event.duty_permille;
+
+                ESP_LOGD(TAG, "Link %d (node %d): power mode %d, duty %u permille",
+                         idx, event.node_id, event.power_mode, event.duty_permille);
+                break;
+            }
+
+            case FUSION_EVENT_CONFIG: {
+                int idx = link_registry_join(event.mac, event.node_id);
+                if (idx < 0) {
+                    g_link_join_rejects++;
+                    continue;
+                }
+
+                g_state.links[idx].detect = event.detect;
+                refresh = true;
+
+                ESP_LOGI(TAG, "Link %d (node %d): CSI every %u ms, window %u, %u of %u votes",
+                         idx, event.node_id, event.detect.csi_interval_ms, event.detect.window_len,
+                         event.detect.move_votes, event.detect.vote_len);
+                break;
+            }
+
+            case FUSION_EVENT_REFRESH:
+            default:
+                refresh = true;
+                break;
+            }
+        }
+
+        fuse_detection_results();
+        calibration_update(local ? &event : NULL);
+        power_update();
+        status_snapshot_publish();
+
+        /* Transitions go out at once, anything else is coalesced by the push task */
+        uint32_t state = (g_state.room_status ? BIT0 : 0) | (g_state.human_status ? BIT1 : 0);
+        bool transition = refresh || state != last_state;
+        for (int i = 0; i < CONFIG_MAX_LINKS; i++) {
+            const link_status_t *link = &g_state.links[i];
+            uint8_t link_state = (link->used ? BIT0 : 0) | (link->active ? BIT1 : 0)
+                                 | (link->room_status ? BIT2 : 0) | (link->human_status ? BIT3 : 0);
+            transition |= link_state != last_link_state[i];
+            last_link_state[i] = link_state;
+        }
+        ws_notify(transition ? WS_NOTIFY_TRANSITION : WS_NOTIFY_UPDATE);
+        last_state = state;
+        csi_perf_end(g_perf_fusion, start_us);
+    }
+}
+
+/**
+ * @brief WiFi radar callback for local CSI processing (Link 1)
+ */
+static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
+{
+    static bool s_first = true;
+
+    /* CSI of the surveyed channels is not comparable with the home channel */
+    if (g_channel.surveying) {
+        return;
+    }
+
+    if (s_first) {
+        csi_boot_mark("first_radar");
+        s_first = false;
+    }
+
+    fusion_event_t event = {
+        .type = FUSION_EVENT_LOCAL,
+        .wander = info->waveform_wander,
+        .jitter = info->waveform_jitter,
+    };
+    fusion_post(&event);
+}
+
+/**
+ * @brief ESP-NOW send callback, the acknowledgements of the commands to one slave steer their rate
+ */
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void espnow_send_cb(const esp_now_send_info_t *tx_info, esp_now_send_status_t status)
+{
+    espnow_rate_tx_done(tx_info->des_addr, status == ESP_NOW_SEND_SUCCESS);
+}
+#else
+static void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status)
+{
+    espnow_rate_tx_done(mac_addr, status == ESP_NOW_SEND_SUCCESS);
+}
+#endif
+
+/**
+ * @brief ESP-NOW receive callback - handle reports from slaves
+ */
+static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    /* Packets of the CSI sender carry their sequence number, the slaves report when they heard them */
+    if (!memcmp(recv_info->src_addr, CONFIG_CSI_SEND_MAC, sizeof(CONFIG_CSI_SEND_MAC))) {
+        if (len >= (int)sizeof(uint32_t)) {
+            uint32_t seq;
+            memcpy(&seq, data, sizeof(seq));
+            time_sync_beacon_put(&g_sync_beacons, seq, now_us);
+            g_channel.sender_heard = esp_log_timestamp();
+        }
+        espnow_rate_account(ESPNOW_RATE_CLASS_SENSING, CONFIG_SEND_RATE, len, false);
+        return;
+    }
+
+    espnow_rate_rx(recv_info->src_addr, recv_info->rx_ctrl->rssi);
+
+    if (len >= (int)sizeof(slave_power_t) && data[0] == SLAVE_MSG_POWER) {
+        const slave_power_t *power = (const slave_power_t *)data;
+        fusion_event_t event = {
+            .type = FUSION_EVENT_POWER,
+            .node_id = power->node_id,
+            .power_mode = power->mode,
+            .duty_permille = power->duty_permille,
+        };
+        memcpy(event.mac, recv_info->src_addr, sizeof(event.mac));
+        fusion_post(&event);
+        return;
+    }
+
+    if (len >= (int)sizeof(slave_config_t) && data[0] == SLAVE_MSG_CONFIG) {
+        const slave_config_t *config = (const slave_config_t *)data;
+        fusion_event_t event = {
+            .type = FUSION_EVENT_CONFIG,
+            .node_id = config->node_id,
+            .detect = config->config,
+        };
+        memcpy(event.mac, recv_info->src_addr, sizeof(event.mac));
+        fusion_post(&event);
+        return;
+    }
+
+    if (len < sizeof(slave_report_t)) return;
+    
+    const slave_report_t *report = (const slave_report_t *)data;
+    
+    /* Any node ID is accepted, the fusion task registers the node by its source MAC */
+    if ((report->msg_type == SLAVE_MSG_REPORT || report->msg_type == SLAVE_MSG_REPORT_BATCH)
+            && report->node_id >= 1) {
+        fusion_event_t event = {
+            .type = FUSION_EVENT_SLAVE,
+            .node_id = report->node_id,
+            .room_status = report->room_status,
+            .human_status = report->human_status,
+            .rssi = report->rssi,
+            .wander = report->wander,
+            .jitter = report->jitter,
+            .sync_time_us = report->sync_time_us,
+            .report_time_us = report->time_us,
+            .rx_us = now_us,
+        };
+        event.sync_valid = report->sync_time_us
+                           && time_sync_beacon_find(&g_sync_beacons, report->sync_seq, &event.beacon_local_us);
+        memcpy(event.mac, recv_info->src_addr, sizeof(event.mac));
+        fusion_post(&event);
+    }
+}
+
+/* Channel commands to the sender and the slaves, see their espnow_recv_cb() */
+#define CHANNEL_CMD_SURVEY          0x16    /* [num][dwell_ms u16][delay_ms u16][channel]..., the sender hops along */
+#define CHANNEL_CMD_SWITCH          0x17    /* [channel][delay_ms u16], every node switches after delay_ms */
+#define CHANNEL_CMD_REPEAT_MS       100     /* Repeats carry the remaining delay, any one of them is enough */
+#define CHANNEL_SURVEY_DELAY_MS     300
+#define CHANNEL_SURVEY_SETTLE_MS    20      /* Not counted after each hop, covers the spread of the nodes' hops */
+#define CHANNEL_SWITCH_VERIFY_MS    2000    /* The sender must be heard on the new channel within this */
+
+/*
+ * Wi-Fi task: count every frame of the channel being surveyed, an ESP-NOW
+ * frame of the sender is an action frame with its MAC as address 2
+ */
+static void channel_promiscuous_cb(void *buf, wifi_promiscuous_pkt_type_t type)
+{
+    const wifi_promiscuous_pkt_t *pkt = buf;
+    uint16_t len = pkt->rx_ctrl.sig_len;
+    bool csi = type == WIFI_PKT_MGMT && len >= 16 && !memcmp(pkt->payload + 10, CONFIG_CSI_SEND_MAC, 6);
+
+    portENTER_CRITICAL(&g_channel_lock);
+    if (g_channel.dwell) {
+        channel_survey_add_frame(&s_channel_survey_config, g_channel.dwell, len, pkt->rx_ctrl.noise_floor, csi);
+    }
+    portEXIT_CRITICAL(&g_channel_lock);
+}
+
+/**
+ * @brief Tune to a channel, with the HT40 secondary channel on the side that exists
+ */
+static esp_err_t channel_tune(uint8_t channel)
+{
+    return esp_wifi_set_channel(channel, csi_wifi_second_chan(channel, WIFI_BW_HT40));
+}
+
+/**
+ * @brief Repeat a channel command until the deadline, each copy carries the time left
+ *
+ * @param delay_offset Offset of the u16 delay in buf
+ */
+static void channel_cmd_broadcast(uint8_t *buf, size_t len, size_t delay_offset, int64_t deadline_us)
+{
+    uint8_t broadcast_addr[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    int64_t left_us;
+
+    while ((left_us = deadline_us - esp_timer_get_time()) > CHANNEL_CMD_REPEAT_MS * 1000 / 2) {
+        uint16_t delay_ms = left_us / 1000;
+        memcpy(buf + delay_offset, &delay_ms, sizeof(delay_ms));
+        espnow_rate_send(broadcast_addr, ESPNOW_RATE_CLASS_CONTROL, buf, len);
+        vTaskDelay(pdMS_TO_TICKS(MIN(CHANNEL_CMD_REPEAT_MS, left_us / 1000)));
+    }
+
+    while ((left_us = deadline_us - esp_timer_get_time()) > 0) {
+        vTaskDelay(MAX(pdMS_TO_TICKS(left_us / 1000), 1));
+    }
+}
+
+/**
+ * @brief Listen on every candidate channel, the sender hops along to measure its packet success rate
+ *
+ * The slaves stay on the home channel and miss the sender meanwhile. The
+ * web clients of the AP follow its beacons or reconnect.
+ */
+static void channel_survey_run(void)
+{
+    const uint8_t channels[] = CONFIG_CHANNEL_SURVEY_LIST;
+    const uint8_t num = MIN(sizeof(channels), CHANNEL_SURVEY_MAX);
+    uint16_t dwell_ms = CONFIG_CHANNEL_SURVEY_DWELL_MS;
+    uint8_t buf[6 + CHANNEL_SURVEY_MAX] = {CHANNEL_CMD_SURVEY, num};
+
+    memcpy(buf + 2, &dwell_ms, sizeof(dwell_ms));
+    memcpy(buf + 6, channels, num);
+
+    portENTER_CRITICAL(&g_channel_lock);
+    for (int i = 0; i < num; i++) {
+        channel_survey_reset(&g_channel.stats[i], channels[i]);
+    }
+    g_channel.stat_num = num;
+    portEXIT_CRITICAL(&g_channel_lock);
+
+    ESP_LOGI(TAG, "Channel survey of %d channels, %d ms each", num, dwell_ms);
+    g_channel.surveying = true;
+    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(channel_promiscuous_cb));
+    channel_cmd_broadcast(buf, 6 + num, 4, esp_timer_get_time() + CHANNEL_SURVEY_DELAY_MS * 1000);
+
+    for (int i = 0; i < num; i++) {
+        channel_tune(channels[i]);
+        vTaskDelay(pdMS_TO_TICKS(CHANNEL_SURVEY_SETTLE_MS));
+
+        portENTER_CRITICAL(&g_channel_lock);
+        g_channel.dwell = &g_channel.stats[i];
+        g_channel.dwell_start_us = esp_timer_get_time();
+        portEXIT_CRITICAL(&g_channel_lock);
+
+        vTaskDelay(pdMS_TO_TICKS(dwell_ms - CHANNEL_SURVEY_SETTLE_MS));
+
+        portENTER_CRITICAL(&g_channel_lock);
+        channel_survey_stat_t *stat = g_channel.dwell;
+        stat->dwell_us = esp_timer_get_time() - g_channel.dwell_start_us;
+        stat->csi_expected = (uint64_t)stat->dwell_us * CONFIG_SEND_FREQUENCY / 1000000;
+        g_channel.dwell = NULL;
+        portEXIT_CRITICAL(&g_channel_lock);
+    }
+
+    channel_tune(g_channel.channel);
+    esp_wifi_set_promiscuous_rx_cb(NULL);
+    g_channel.surveying = false;
+    g_channel.survey_time = esp_log_timestamp();
+    g_channel.surveys++;
+
+    for (int i = 0; i < num; i++) {
+        const channel_survey_stat_t *stat = &g_channel.stats[i];
+        ESP_LOGI(TAG, "Channel %2d: busy %.1f%%, noise %d dBm, CSI %lu/%lu, score %.3f", stat->channel,
+                 channel_survey_busy(stat) * 100, channel_survey_noise_dbm(&s_channel_survey_config, stat),
+                 (unsigned long)stat->csi_received, (unsigned long)stat->csi_expected,
+                 channel_survey_score(&s_channel_survey_config, stat));
+    }
+}
+
+/**
+ * @brief Make a channel the home channel of the master: AP, radio and the saved settings
+ */
+static void channel_set_home(uint8_t channel)
+{
+    wifi_config_t ap_config;
+
+    /* Moves the AP, its clients reconnect. The ESP-NOW peer is on the current channel */
+    esp_wifi_get_config(WIFI_IF_AP, &ap_config);
+    ap_config.ap.channel = channel;
+    esp_wifi_set_config(WIFI_IF_AP, &ap_config);
+    channel_tune(channel);
+
+    g_channel.channel = channel;
+
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    g_settings.channel = channel;
+    settings_store_save(&g_settings);
+    xSemaphoreGive(g_state_mutex);
+}
+
+/**
+ * @brief Move every node to a channel at the same time
+ *
+ * The switch command is repeated for CONFIG_CHANNEL_SWITCH_DELAY_MS. If the
+ * sender then stays silent on the new channel it missed every copy, and the
+ * master goes back once to repeat the command where the sender still is.
+ * Slaves that missed it find the sender again by themselves.
+ */
+static void channel_switch(uint8_t channel)
+{
+    uint8_t old_channel = g_channel.channel;
+    uint8_t buf[4] = {CHANNEL_CMD_SWITCH, channel};
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (attempt) {
+            ESP_LOGW(TAG, "Sender not heard on channel %d, repeating the switch on channel %d", channel, old_channel);
+            channel_tune(old_channel);
+        }
+
+        ESP_LOGI(TAG, "Switching every node from channel %d to %d", old_channel, channel);
+        channel_cmd_broadcast(buf, sizeof(buf), 2, esp_timer_get_time() + CONFIG_CHANNEL_SWITCH_DELAY_MS * 1000);
+
+        uint32_t switch_time = esp_log_timestamp();
+        channel_set_home(channel);
+        vTaskDelay(pdMS_TO_TICKS(CHANNEL_SWITCH_VERIFY_MS));
+
+        if ((int32_t)(g_channel.sender_heard - switch_time) > 0) {
+            break;
+        }
+    }
+
+    g_channel.switches++;
+}
+
+/**
+ * @brief Whether the room lets a periodic survey interrupt sensing
+ */
+static bool channel_survey_allowed(bool requested)
+{
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    bool allowed = !g_state.calibrating && !g_state.background_running
+                   && g_state.power_mode == POWER_MODE_CONTINUOUS && !g_state.power_wake_start
+                   && (requested || (CONFIG_CHANNEL_SURVEY_ENABLE && !g_state.room_status));
+    xSemaphoreGive(g_state_mutex);
+
+    return allowed;
+}
+
+/**
+ * @brief Survey at boot, every CONFIG_CHANNEL_SURVEY_INTERVAL_MS while the room is empty, and on request
+ *
+ * A notification with value CHANNEL_SURVEY_MAX + 1 asks for a survey, a
+ * channel number for a switch to it.
+ */
+static void channel_task(void *arg)
+{
+    uint32_t next = esp_log_timestamp() + CONFIG_CHANNEL_SURVEY_BOOT_DELAY_MS;
+
+    while (1) {
+        int32_t wait_ms = next - esp_log_timestamp();
+        uint32_t request = 0;
+
+        if (!xTaskNotifyWait(0, UINT32_MAX, &request, wait_ms > 0 ? pdMS_TO_TICKS(wait_ms) : 0)) {
+            request = 0;
+            if (!CONFIG_CHANNEL_SURVEY_ENABLE) {
+                next = esp_log_timestamp() + CONFIG_CHANNEL_SURVEY_INTERVAL_MS;
+                continue;
+            }
+        }
+
+        if (!channel_survey_allowed(request != 0)) {
+            if (!request) {
+                next = esp_log_timestamp() + CONFIG_CHANNEL_SURVEY_RETRY_MS;
+            } else {
+                ESP_LOGW(TAG, "Channel request dropped, calibration or duty cycle running");
+            }
+            continue;
+        }
+
+        if (request && request <= CHANNEL_SURVEY_MAX) {
+            if (request != g_channel.channel) {
+                channel_switch(request);
+            }
+            continue;
+        }
+
+        channel_survey_run();
+        next = esp_log_timestamp() + CONFIG_CHANNEL_SURVEY_INTERVAL_MS;
+
+        int best = channel_survey_pick(&s_channel_survey_config, g_channel.stats, g_channel.stat_num, g_channel.channel);
+        if (best >= 0 && g_channel.stats[best].channel != g_channel.channel) {
+            channel_switch(g_channel.stats[best].channel);
+        } else {
+            ESP_LOGI(TAG, "Staying on channel %d", g_channel.channel);
+        }
+    }
+}
+
+/* HTTP Handlers */
+#define HTTP_HEADER_VALUE_MAX_LEN   128
+
+/* Whether a comma separated header lists token, "gzip;q=0" counts as refused */
+static bool http_header_lists(const char *value, const char *token)
+{
+    size_t token_len = strlen(token);
+
+    for (const char *p = value; (p = strcasestr(p, token)) != NULL; p += token_len) {
+        const char *end = p + token_len;
+        bool starts = p == value || p[-1] == ',' || p[-1] == ' ';
+
+        if (starts && (!*end || *end == ',' || *end == ';' || *end == ' ')) {
+            const char *q = strstr(end, "q=");
+            const char *next = strchr(end, ',');
+            return !(q && (!next || q < next) && atof(q + 2) == 0);
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Serve an embedded asset, gzip when accepted, 304 when the client copy is current
+ */
+static esp_err_t http_get_asset(httpd_req_t *req)
+{
+    const web_asset_t *asset = req->user_ctx;
+    char value[HTTP_HEADER_VALUE_MAX_LEN];
+    bool gzip = httpd_req_get_hdr_value_str(req, "Accept-Encoding", value, sizeof(value)) == ESP_OK
+                && http_header_lists(value, "gzip");
+    const char *etag = gzip ? asset->etag_gzip : asset->etag;
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", asset->cache_control);
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", value, sizeof(value)) == ESP_OK
+            && (strstr(value, etag) || !strcmp(value, "*"))) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, asset->type);
+    if (gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return httpd_resp_send(req, (const char *)asset->gzip, asset->gzip_len);
+    }
+
+    return httpd_resp_send(req, (const char *)asset->data, asset->len);
+}
+
+/* Status JSON: fixed fields plus one object per registered link */
+#define STATUS_JSON_LINK_MAX_LEN    256
+#define STATUS_JSON_MAX_LEN         (256 + CONFIG_MAX_LINKS * STATUS_JSON_LINK_MAX_LEN)
+#define PERF_JSON_MAX_LEN           (64 + CSI_PERF_STAGE_MAX * 160 + 256)
+
+/**
+ * @brief Seconds left in the running calibration, 0 when not calibrating
+ */
+static int calibration_remaining_s(void)
+{
+    if (!g_state.calibrating) {
+        return 0;
+    }
+
+    uint32_t elapsed = esp_log_timestamp() - g_state.calibration_start_time;
+    int remaining = (int)(g_state.calibration_duration_ms - elapsed) / 1000;
+    return MAX(remaining, 0);
+}
+
+/**
+ * @brief Serialize the status with every registered link, shared by /api/status and the WebSocket
+ *
+ * "gen" is the snapshot generation /api/status?since= waits on, "id" is the
+ * link index the sensitivity API expects.
+ *
+ * @return Length as snprintf() reports it, the output is truncated if it is >= size
+ */
+static int status_json(char *buf, size_t size, uint32_t generation, const presence_status_t *st, int calib_remaining)
+{
+    int len = snprintf(buf, size,
+        "{\"gen\":%u,\"room\":%d,\"moving\":%d,\"calibrating\":%d,\"calib_remaining\":%d,"
+        "\"wander_th\":%.6f,\"jitter_th\":%.6f,"
+        "\"power\":{\"mode\":%d,\"wakes\":%lu,\"wake_ms\":%lu,\"wake_max_ms\":%lu},\"links\":[",
+        (unsigned)generation,
+        st->room_status ? 1 : 0,
+        st->human_status ? 1 : 0,
+        st->calibrating ? 1 : 0,
+        calib_remaining,
+        st->wander_threshold, st->jitter_threshold,
+        st->power_mode, (unsigned long)st->power_wakes,
+        (unsigned long)st->power_wake_latency_ms, (unsigned long)st->power_wake_latency_max_ms);
+    const char *sep = "";
+
+    for (int i = 0; i < CONFIG_MAX_LINKS && len > 0 && (size_t)len < size; i++) {
+        const link_status_t *link = &st->links[i];
+
+        if (!link->used) {
+            continue;
+        }
+
+        len += snprintf(buf + len, size - len,
+            "%s{\"id\":%d,\"node\":%d,\"mac\":\"" MACSTR "\",\"active\":%d,\"room\":%d,\"move\":%d,"
+            "\"rssi\":%d,\"weight\":%.2f,\"wander\":%.6f,\"jitter\":%.6f,\"w_sens\":%.3f,\"j_sens\":%.3f,"
+            "\"synced\":%d,\"age_ms\":%u,\"power\":%d,\"duty\":%u}",
+            sep, i, link->node_id, MAC2STR(link->mac), link->active ? 1 : 0,
+            link->room_status ? 1 : 0, link->human_status ? 1 : 0,
+            link->rssi, link->weight, link->wander, link->jitter,
+            link->wander_sensitivity, link->jitter_sensitivity,
+            link->synced ? 1 : 0, (unsigned)link->report_age_ms,
+            link->power_mode, (unsigned)link->duty_permille);
+        sep = ",";
+    }
+
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(buf + len, size - len, "]}");
+    }
+
+    return len;
+}
+
+/**
+ * @brief Boot milestones, in ms since reset
+ */
+static esp_err_t http_get_boot(httpd_req_t *req)
+{
+    char buf[CSI_BOOT_MILESTONE_MAX * 48 + 32];
+    int len = csi_boot_json(buf, sizeof(buf));
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, buf, len);
+    return ESP_OK;
+}
+
+/**
+ * @brief Latency histograms of the pipeline stages, "?reset=1" clears them after reading
+ */
+static esp_err_t http_get_perf(httpd_req_t *req)
+{
+    char *buf = malloc(PERF_JSON_MAX_LEN);
+    char query[32];
+    char value[8];
+
+    if (!buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    int len = csi_perf_json(buf, PERF_JSON_MAX_LEN);
+
+    /* Reopen the object to append the queue counters next to the stages */
+    if (len > 0 && buf[len - 1] == '}') {
+        len--;
+        len += snprintf(buf + len, PERF_JSON_MAX_LEN - len, ",\"queues\":[");
+        len += csi_queue_json(&g_fusion_queue, buf + len, PERF_JSON_MAX_LEN - len);
+        len += snprintf(buf + len, PERF_JSON_MAX_LEN - len, "]}");
+        len = MIN(len, PERF_JSON_MAX_LEN - 1);
+    }
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK
+            && httpd_query_key_value(query, "reset", value, sizeof(value)) == ESP_OK && atoi(value)) {
+        csi_perf_reset();
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, buf, len);
+    free(buf);
+    return ESP_OK;
+}
+
+/**
+ * @brief Task CPU, stack high-water and heap of each capability, "?history=1" adds the sample ring
+ */
+static esp_err_t http_get_diag(httpd_req_t *req)
+{
+    char query[32];
+    char value[8];
+    bool history = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK
+                   && httpd_query_key_value(query, "history", value, sizeof(value)) == ESP_OK && atoi(value);
+    size_t size = csi_diag_json_len(history);
+    char *buf = malloc(size);
+
+    if (!buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    int len = csi_diag_json(buf, size, history);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, buf, len);
+    free(buf);
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop the manual calibration and apply the thresholds of the run
+ *
+ * Detection kept the previous thresholds during the run. A run too short
+ * for thresholds leaves them as they are.
+ */
+static void finish_calibration(void)
+{
+    online_calib_result_t result;
+
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    if (!g_state.calibrating) {
+        xSemaphoreGive(g_state_mutex);
+        return;
+    }
+
+    bool ready = online_calib_ready(&g_state.calib);
+    online_calib_get(&g_state.calib, &result);
+    if (ready) {
+        g_state.wander_threshold = result.wander_threshold;
+        g_state.jitter_threshold = result.jitter_threshold;
+    }
+    g_state.calibrating = false;
+    xSemaphoreGive(g_state_mutex);
+
+    broadcast_calibration_cmd(CALIB_CMD_STOP, CALIB_CMD_WEIGHT_REPLACE);
+    fusion_post_refresh();
+
+    if (!ready) {
+        ESP_LOGW(TAG, "Calibration stopped after %lu samples, thresholds kept", (unsigned long)result.samples);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Calibration done: wander_th=%.6f, jitter_th=%.6f, %lu samples, confidence %.2f",
+             result.wander_threshold, result.jitter_threshold, (unsigned long)result.samples, result.confidence);
+    
+    settings_save();
+}
+
+/* Radar results per second of the local link, the sender caps the CSI rate. The caller holds g_state_mutex. */
+static uint32_t calib_sample_rate_hz(void)
+{
+    return MAX(MIN(CONFIG_SEND_FREQUENCY, 1000 / g_state.links[0].detect.csi_interval_ms), 1);
+}
+
+/* Value of "key": in a flat JSON body, false if absent */
+static bool http_body_float(const char *body, const char *key, float *value)
+{
+    const char *p = strstr(body, key);
+
+    if (!p || !(p = strchr(p + strlen(key), ':'))) {
+        return false;
+    }
+
+    p++;
+    while (*p == ' ' || *p == '"') p++;
+    char *end = NULL;
+    float parsed = strtof(p, &end);
+    if (end == p) {
+        /* true and false for the flags */
+        if (strncmp(p, "true", 4) && strncmp(p, "false", 5)) {
+            return false;
+        }
+        parsed = *p == 't' ? 1 : 0;
+    }
+
+    *value = parsed;
+    return true;
+}
+
+/**
+ * @brief Calibration control, the body is one of
+ *
+ * - "start", or {"action":"start","duration":60} in seconds
+ * - {"action":"extend","duration":30}, add to the running calibration
+ * - "stop"
+ * - {"action":"background","enable":true}, re-baseline while the room stays empty
+ */
+static esp_err_t http_post_calibrate(httpd_req_t *req)
+{
+    char buf[96];
+    float duration_s = CONFIG_CALIB_DURATION_MS / 1000;
     int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
     if (ret <= 0) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No body");
         return ESP_FAIL;
     }
     buf[ret] = '\0';
-    
-    if (strstr(buf, "start")) {
-        ESP_LOGI(TAG, "Starting calibration (30 seconds)...");
+    http_body_float(buf, "\"duration\"", &duration_s);
+    uint32_t duration_ms = MIN(MAX(duration_s, 1) * 1000, CONFIG_CALIB_DURATION_MAX_MS);
+    char resp[128];
+
+    if (strstr(buf, "background")) {
+        float enable = 1;
+        http_body_float(buf, "\"enable\"", &enable);
+
+        xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+        g_state.background_enable = enable != 0;
+        xSemaphoreGive(g_state_mutex);
+        fusion_post_refresh();
+
+        ESP_LOGI(TAG, "Background calibration %s", enable != 0 ? "enabled" : "disabled");
+        snprintf(resp, sizeof(resp), "{\"status\":\"background\",\"enable\":%d}", enable != 0);
+        httpd_resp_sendstr(req, resp);
+    } else if (strstr(buf, "extend")) {
+        xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+        bool calibrating = g_state.calibrating;
+        if (calibrating) {
+            uint32_t total_ms = MIN(g_state.calibration_duration_ms + duration_ms, CONFIG_CALIB_DURATION_MAX_MS);
+            g_state.calibration_duration_ms = total_ms;
+            g_state.calib.config.target_samples = (uint64_t)total_ms * calib_sample_rate_hz() / 1000;
+        }
+        uint32_t total_ms = g_state.calibration_duration_ms;
+        xSemaphoreGive(g_state_mutex);
+
+        if (!calibrating) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Not calibrating");
+            return ESP_FAIL;
+        }
+
+        ESP_LOGI(TAG, "Calibration extended to %lu seconds", (unsigned long)(total_ms / 1000));
+        snprintf(resp, sizeof(resp), "{\"status\":\"calibrating\",\"duration\":%lu}", (unsigned long)(total_ms / 1000));
+        httpd_resp_sendstr(req, resp);
+    } else if (strstr(buf, "start")) {
+        ESP_LOGI(TAG, "Starting calibration (%lu seconds)...", (unsigned long)(duration_ms / 1000));
+        xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+        bool background = g_state.background_running;
+        g_state.background_running = false;
         g_state.calibrating = true;
         g_state.calibration_start_time = esp_log_timestamp();
-        esp_radar_train_start();
-        broadcast_calibration_cmd(0x10);
-        httpd_resp_sendstr(req, "{\"status\":\"calibrating\",\"duration\":30}");
+        g_state.calibration_duration_ms = duration_ms;
+        online_calib_config_t calib_config = ONLINE_CALIB_CONFIG_DEFAULT();
+        calib_config.target_samples = (uint64_t)duration_ms * calib_sample_rate_hz() / 1000;
+        online_calib_init(&g_state.calib, &calib_config);
+        xSemaphoreGive(g_state_mutex);
+
+        /* A manual start takes over a background run, the slaves restart their samples */
+        if (background) {
+            broadcast_calibration_cmd(CALIB_CMD_ABORT, 0);
+        }
+        broadcast_calibration_cmd(CALIB_CMD_START, 0);
+        fusion_post_refresh();
+        snprintf(resp, sizeof(resp), "{\"status\":\"calibrating\",\"duration\":%lu}", (unsigned long)(duration_ms / 1000));
+        httpd_resp_sendstr(req, resp);
     } else if (strstr(buf, "stop")) {
         finish_calibration();
         
-        char resp[128];
         snprintf(resp, sizeof(resp), 
                  "{\"status\":\"done\",\"wander_th\":%.6f,\"jitter_th\":%.6f}",
                  g_state.wander_threshold, g_state.jitter_threshold);
@@ -566,10 +1993,136 @@ static esp_err_t http_post_calibrate(httpd_req_t *req)
     return ESP_OK;
 }
 
+/**
+ * @brief Progress and statistics of the local calibration run, manual or background
+ */
+static esp_err_t http_get_calibrate(httpd_req_t *req)
+{
+    online_calib_result_t result;
+    char resp[640];
+    uint32_t now = esp_log_timestamp();
+
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    online_calib_get(&g_state.calib, &result);
+    const char *mode = g_state.calibrating ? "manual" : g_state.background_running ? "background" : "idle";
+    int len = snprintf(resp, sizeof(resp),
+        "{\"mode\":\"%s\",\"remaining\":%d,\"samples\":%lu,\"target\":%lu,"
+        "\"progress\":%.3f,\"confidence\":%.3f,\"quantile\":%.3f,"
+        "\"wander\":{\"mean\":%.6f,\"std\":%.6f,\"threshold\":%.6f},"
+        "\"jitter\":{\"mean\":%.6f,\"std\":%.6f,\"threshold\":%.6f},"
+        "\"wander_th\":%.6f,\"jitter_th\":%.6f,"
+        "\"background\":{\"enable\":%d,\"vacant_ms\":%lu,\"runs\":%lu,\"aborts\":%lu}}",
+        mode, calibration_remaining_s(), (unsigned long)result.samples,
+        (unsigned long)g_state.calib.config.target_samples,
+        result.progress, result.confidence, g_state.calib.config.quantile,
+        result.wander_mean, result.wander_std, result.wander_threshold,
+        result.jitter_mean, result.jitter_std, result.jitter_threshold,
+        g_state.wander_threshold, g_state.jitter_threshold,
+        g_state.background_enable, g_state.room_status ? 0UL : (unsigned long)(now - g_state.vacant_since),
+        (unsigned long)g_state.background_runs, (unsigned long)g_state.background_aborts);
+    xSemaphoreGive(g_state_mutex);
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, MIN(len, (int)sizeof(resp) - 1));
+}
+
+/**
+ * @brief Sensing channel and the result of the last survey
+ */
+static esp_err_t http_get_channel(httpd_req_t *req)
+{
+    channel_survey_stat_t stats[CHANNEL_SURVEY_MAX];
+    char resp[128 + CHANNEL_SURVEY_MAX * 128];
+    const char *sep = "";
+
+    portENTER_CRITICAL(&g_channel_lock);
+    uint8_t num = g_channel.surveying ? 0 : g_channel.stat_num;
+    memcpy(stats, g_channel.stats, num * sizeof(stats[0]));
+    portEXIT_CRITICAL(&g_channel_lock);
+
+    int len = snprintf(resp, sizeof(resp),
+        "{\"channel\":%d,\"surveying\":%d,\"surveys\":%lu,\"switches\":%lu,\"age_s\":%lu,\"survey\":[",
+        g_channel.channel, g_channel.surveying, (unsigned long)g_channel.surveys, (unsigned long)g_channel.switches,
+        g_channel.surveys ? (unsigned long)((esp_log_timestamp() - g_channel.survey_time) / 1000) : 0UL);
+
+    for (int i = 0; i < num && len < (int)sizeof(resp); i++) {
+        const channel_survey_stat_t *stat = &stats[i];
+        len += snprintf(resp + len, sizeof(resp) - len,
+            "%s{\"channel\":%d,\"busy\":%.3f,\"frames\":%lu,\"noise\":%d,\"csi_rate\":%.3f,\"score\":%.3f}",
+            sep, stat->channel, channel_survey_busy(stat), (unsigned long)stat->frames,
+            channel_survey_noise_dbm(&s_channel_survey_config, stat), channel_survey_csi_rate(stat),
+            channel_survey_score(&s_channel_survey_config, stat));
+        sep = ",";
+    }
+
+    if (len < (int)sizeof(resp)) {
+        len += snprintf(resp + len, sizeof(resp) - len, "]}");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, MIN(len, (int)sizeof(resp) - 1));
+}
+
+/**
+ * @brief Channel control, the body is one of
+ *
+ * - "survey", measure the candidates and move every node to the best one
+ * - {"action":"switch","channel":6}, move every node to a channel
+ */
+static esp_err_t http_post_channel(httpd_req_t *req)
+{
+    char buf[64];
+    float channel = 0;
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No body");
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+
+    if (strstr(buf, "survey")) {
+        channel = CHANNEL_SURVEY_MAX + 1;
+    } else if (!strstr(buf, "switch") || !http_body_float(buf, "\"channel\"", &channel)
+               || channel < 1 || channel > CHANNEL_SURVEY_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid action");
+        return ESP_FAIL;
+    }
+
+    if (!channel_survey_allowed(true)) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "{\"status\":\"busy\"}");
+        return ESP_OK;
+    }
+
+    /* The channel task answers nothing, the result shows up on GET /api/channel */
+    xTaskNotify(g_channel_task, (uint32_t)channel, eSetValueWithOverwrite);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_sendstr(req, channel > CHANNEL_SURVEY_MAX ? "{\"status\":\"surveying\"}" : "{\"status\":\"switching\"}");
+    return ESP_OK;
+}
+
+/**
+ * @brief Send a command to one slave, registering it as a peer first
+ */
+static esp_err_t espnow_send_to_node(const uint8_t mac[6], const uint8_t *data, size_t len)
+{
+    if (!esp_now_is_peer_exist(mac)) {
+        esp_now_peer_info_t peer = {
+            .channel = 0,   /* Current channel */
+            .ifidx = WIFI_IF_STA,
+            .encrypt = false,
+        };
+        memcpy(peer.peer_addr, mac, sizeof(peer.peer_addr));
+        esp_now_add_peer(&peer);
+    }
+
+    return espnow_rate_send(mac, ESPNOW_RATE_CLASS_CONTROL, data, len);
+}
+
 /**
  * @brief API to get/set per-link sensitivity parameters
- * GET: returns all links' sensitivity
- * POST: {"link":0, "wander_sens":0.15, "jitter_sens":0.20}
+ * GET: returns the sensitivity of every registered link
+ * POST: {"link":0, "wander_sens":0.15, "jitter_sens":0.20}, link is the "id" from the status
  */
 static esp_err_t http_post_sensitivity(httpd_req_t *req)
 {
@@ -580,18 +2133,34 @@ static esp_err_t http_post_sensitivity(httpd_req_t *req)
     
     if (ret <= 0) {
         /* GET - return all links' sensitivity and thresholds */
-        char resp[512];
-        snprintf(resp, sizeof(resp),
-            "{\"wander_th\":%.6f,\"jitter_th\":%.6f,"
-            "\"links\":["
-            "{\"wander_sens\":%.3f,\"jitter_sens\":%.3f},"
-            "{\"wander_sens\":%.3f,\"jitter_sens\":%.3f},"
-            "{\"wander_sens\":%.3f,\"jitter_sens\":%.3f}]}",
-            g_state.wander_threshold, g_state.jitter_threshold,
-            g_state.links[0].wander_sensitivity, g_state.links[0].jitter_sensitivity,
-            g_state.links[1].wander_sensitivity, g_state.links[1].jitter_sensitivity,
-            g_state.links[2].wander_sensitivity, g_state.links[2].jitter_sensitivity);
+        const size_t resp_size = 64 + CONFIG_MAX_LINKS * 96;
+        char *resp = malloc(resp_size);
+        if (!resp) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+            return ESP_FAIL;
+        }
+
+        xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+        int len = snprintf(resp, resp_size, "{\"wander_th\":%.6f,\"jitter_th\":%.6f,\"links\":[",
+                           g_state.wander_threshold, g_state.jitter_threshold);
+        const char *sep = "";
+        for (int i = 0; i < CONFIG_MAX_LINKS && (size_t)len < resp_size; i++) {
+            const link_status_t *link = &g_state.links[i];
+            if (!link->used) {
+                continue;
+            }
+            len += snprintf(resp + len, resp_size - len,
+                            "%s{\"id\":%d,\"mac\":\"" MACSTR "\",\"wander_sens\":%.3f,\"jitter_sens\":%.3f}",
+                            sep, i, MAC2STR(link->mac), link->wander_sensitivity, link->jitter_sensitivity);
+            sep = ",";
+        }
+        xSemaphoreGive(g_state_mutex);
+
+        if ((size_t)len < resp_size) {
+            snprintf(resp + len, resp_size - len, "]}");
+        }
         httpd_resp_sendstr(req, resp);
+        free(resp);
         return ESP_OK;
     }
     buf[ret] = '\0';
@@ -633,68 +2202,254 @@ static esp_err_t http_post_sensitivity(httpd_req_t *req)
     }
     
     /* Validate and update */
-    if (link_idx < 0 || link_idx > 2) {
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid link index (0-2)\"}");
+    if (link_idx < 0 || link_idx >= CONFIG_MAX_LINKS) {
+        httpd_resp_sendstr(req, "{\"error\":\"Invalid link index\"}");
         return ESP_OK;
     }
     
     /* Update per-link sensitivity (store locally for display) */
     /* Allow very low values (0.001) for fine-tuning false positives */
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    link_status_t *link = &g_state.links[link_idx];
+    if (!link->used) {
+        xSemaphoreGive(g_state_mutex);
+        httpd_resp_sendstr(req, "{\"error\":\"No node on this link\"}");
+        return ESP_OK;
+    }
     if (wander_sens >= 0.001f && wander_sens <= 5.0f) {
-        g_state.links[link_idx].wander_sensitivity = wander_sens;
+        link->wander_sensitivity = wander_sens;
     }
     if (jitter_sens >= 0.001f && jitter_sens <= 5.0f) {
-        g_state.links[link_idx].jitter_sensitivity = jitter_sens;
+        link->jitter_sensitivity = jitter_sens;
     }
+    /* The slot may be reassigned by the fusion task once the mutex is released */
+    link_status_t target = *link;
+    xSemaphoreGive(g_state_mutex);
     
-    /* For slaves (link 1, 2), send sensitivity command via ESP-NOW */
+    /* For slaves, send sensitivity command via ESP-NOW to the node's own address */
     if (link_idx > 0) {
         uint8_t cmd_buf[10];
         cmd_buf[0] = 0x13;  /* Set sensitivity command */
-        cmd_buf[1] = (uint8_t)link_idx;  /* Target node ID */
-        memcpy(&cmd_buf[2], &g_state.links[link_idx].wander_sensitivity, 4);
-        memcpy(&cmd_buf[6], &g_state.links[link_idx].jitter_sensitivity, 4);
+        cmd_buf[1] = target.node_id;  /* Target node ID, checked by the slave */
+        memcpy(&cmd_buf[2], &target.wander_sensitivity, 4);
+        memcpy(&cmd_buf[6], &target.jitter_sensitivity, 4);
         
-        uint8_t broadcast_addr[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
-        esp_err_t err = esp_now_send(broadcast_addr, cmd_buf, sizeof(cmd_buf));
+        esp_err_t err = espnow_send_to_node(target.mac, cmd_buf, sizeof(cmd_buf));
         
-        ESP_LOGI(TAG, "Sent sensitivity to slave %d: wander=%.3f, jitter=%.3f (err=%d)",
-                 link_idx, 
-                 g_state.links[link_idx].wander_sensitivity,
-                 g_state.links[link_idx].jitter_sensitivity,
+        ESP_LOGI(TAG, "Sent sensitivity to link %d (node %d, " MACSTR "): wander=%.3f, jitter=%.3f (err=%d)",
+                 link_idx, target.node_id, MAC2STR(target.mac),
+                 target.wander_sensitivity,
+                 target.jitter_sensitivity,
                  err);
+        
+        /* Saved under the node's MAC, a slider drag is written once */
+        settings_save_link_sensitivity(target.mac, target.wander_sensitivity, target.jitter_sensitivity);
     } else {
         ESP_LOGI(TAG, "Master (Link 0) sensitivity updated: wander=%.3f, jitter=%.3f",
-                 g_state.links[0].wander_sensitivity,
-                 g_state.links[0].jitter_sensitivity);
+                 target.wander_sensitivity,
+                 target.jitter_sensitivity);
+        
+        settings_save();
     }
     
-    /* Save to NVS */
-    nvs_save_settings();
+    fusion_post_refresh();
     
     /* Return updated values for this link */
     char resp[128];
     snprintf(resp, sizeof(resp),
              "{\"link\":%d,\"wander_sens\":%.3f,\"jitter_sens\":%.3f}",
              link_idx,
-             g_state.links[link_idx].wander_sensitivity,
-             g_state.links[link_idx].jitter_sensitivity);
+             target.wander_sensitivity,
+             target.jitter_sensitivity);
+    httpd_resp_sendstr(req, resp);
+    return ESP_OK;
+}
+
+/**
+ * @brief Detection tuning of every link that reported it
+ */
+static esp_err_t http_get_detect(httpd_req_t *req)
+{
+    presence_status_t st;
+    char resp[32 + CONFIG_MAX_LINKS * 128];
+    const char *sep = "";
+
+    status_snapshot_read(&st);
+    int len = snprintf(resp, sizeof(resp), "{\"links\":[");
+
+    for (int i = 0; i < CONFIG_MAX_LINKS && len < (int)sizeof(resp); i++) {
+        const link_status_t *link = &st.links[i];
+        if (!link->used || !link->detect.csi_interval_ms) {
+            continue;
+        }
+        len += snprintf(resp + len, sizeof(resp) - len,
+            "%s{\"id\":%d,\"mac\":\"" MACSTR "\",\"csi_interval_ms\":%u,\"window\":%u,\"vote_len\":%u,\"move_votes\":%u}",
+            sep, i, MAC2STR(link->mac), link->detect.csi_interval_ms, link->detect.window_len,
+            link->detect.vote_len, link->detect.move_votes);
+        sep = ",";
+    }
+
+    if (len < (int)sizeof(resp)) {
+        len += snprintf(resp + len, sizeof(resp) - len, "]}");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, MIN(len, (int)sizeof(resp) - 1));
+}
+
+/**
+ * @brief Detection tuning, applied without a reboot
+ *
+ * POST {"link":1, "csi_interval_ms":20, "window":50, "vote_len":8, "move_votes":3},
+ * fields left out keep their value. Without "link" the master takes the
+ * tuning and broadcasts the result to every slave. A slave answers with the
+ * tuning it applied, shown on GET.
+ */
+static esp_err_t http_post_detect(httpd_req_t *req)
+{
+    char buf[160];
+    float link_idx = -1;
+    float value;
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No body");
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+
+    http_body_float(buf, "\"link\"", &link_idx);
+    if (link_idx >= CONFIG_MAX_LINKS) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid link index");
+        return ESP_FAIL;
+    }
+
+    int idx = link_idx < 0 ? 0 : (int)link_idx;
+    xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+    link_status_t target = g_state.links[idx];
+    detect_config_t local = g_state.links[0].detect;
+    xSemaphoreGive(g_state_mutex);
+
+    if (!target.used) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No node on this link");
+        return ESP_FAIL;
+    }
+
+    /* Out of range values are clamped into the field, then rejected as a whole */
+    detect_config_t config = target.detect.csi_interval_ms ? target.detect : local;
+    if (http_body_float(buf, "\"csi_interval_ms\"", &value)) {
+        config.csi_interval_ms = MIN(MAX(value, 0), UINT16_MAX);
+    }
+    if (http_body_float(buf, "\"window\"", &value)) {
+        config.window_len = MIN(MAX(value, 0), UINT16_MAX);
+    }
+    if (http_body_float(buf, "\"vote_len\"", &value)) {
+        config.vote_len = MIN(MAX(value, 0), UINT8_MAX);
+    }
+    if (http_body_float(buf, "\"move_votes\"", &value)) {
+        config.move_votes = MIN(MAX(value, 0), UINT8_MAX);
+    }
+
+    if (!detect_config_valid(&config)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid tuning");
+        return ESP_FAIL;
+    }
+
+    /* The fusion task resizes the local windows on its next sample */
+    if (idx == 0) {
+        xSemaphoreTake(g_state_mutex, portMAX_DELAY);
+        g_state.links[0].detect = config;
+        xSemaphoreGive(g_state_mutex);
+
+        if (config.csi_interval_ms != local.csi_interval_ms) {
+            esp_radar_config_t radar_config = {0};
+            esp_radar_get_config(&radar_config);
+            radar_config.csi_config.csi_recv_interval = config.csi_interval_ms;
+            esp_radar_change_config(&radar_config);
+        }
+        settings_save();
+    }
+
+    if (link_idx != 0) {
+        uint8_t cmd_buf[1 + sizeof(detect_config_t)] = {DETECT_CMD};
+        uint8_t broadcast_addr[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+        memcpy(cmd_buf + 1, &config, sizeof(config));
+        esp_err_t err = espnow_send_to_node(idx ? target.mac : broadcast_addr, cmd_buf, sizeof(cmd_buf));
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "<%s> Detection tuning not sent", esp_err_to_name(err));
+        }
+    }
+
+    ESP_LOGI(TAG, "Detection tuning of %s: CSI every %u ms, window %u, %u of %u votes",
+             link_idx < 0 ? "every link" : idx ? "a slave" : "the local link",
+             config.csi_interval_ms, config.window_len, config.move_votes, config.vote_len);
+    fusion_post_refresh();
+
+    char resp[128];
+    snprintf(resp, sizeof(resp), "{\"link\":%d,\"csi_interval_ms\":%u,\"window\":%u,\"vote_len\":%u,\"move_votes\":%u}",
+             link_idx < 0 ? -1 : idx, config.csi_interval_ms, config.window_len, config.vote_len, config.move_votes);
+    httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, resp);
     return ESP_OK;
 }
 
-/* WebSocket client management */
-#define MAX_WS_CLIENTS 4
-static int g_ws_clients[MAX_WS_CLIENTS] = {-1, -1, -1, -1};
-static SemaphoreHandle_t g_ws_mutex = NULL;
+/* WebSocket client management */
+#define MAX_WS_CLIENTS          4
+
+typedef enum {
+    WS_FORMAT_JSON = 0,     /* Text frame, same fields as /api/status plus thresholds */
+    WS_FORMAT_BINARY,       /* Binary ws_status_bin_t frame, connect with /ws?format=binary */
+    WS_FORMAT_MAX,
+} ws_format_t;
+
+typedef struct {
+    int fd;
+    ws_format_t format;
+} ws_client_t;
+
+static ws_client_t g_ws_clients[MAX_WS_CLIENTS] = {
+    {-1, WS_FORMAT_JSON}, {-1, WS_FORMAT_JSON}, {-1, WS_FORMAT_JSON}, {-1, WS_FORMAT_JSON}
+};
+static SemaphoreHandle_t g_ws_mutex = NULL;
+
+/**
+ * @brief Compact binary status frame, little endian
+ *
+ * A fixed header followed by link_num link records, one per registered link.
+ * flags: bit0 room, bit1 moving, bit2 calibrating; link flags: bit0 active, bit1 room, bit2 move
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t id;             /* Link index for /api/sensitivity */
+    uint8_t flags;
+    uint8_t mac[6];
+    int8_t rssi;
+    float wander;
+    float jitter;
+    float w_sens;
+    float j_sens;
+} ws_status_bin_link_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t flags;
+    uint16_t calib_remaining;   /* Seconds, up to CONFIG_CALIB_DURATION_MAX_MS */
+    uint8_t link_num;
+    float wander_th;
+    float jitter_th;
+    ws_status_bin_link_t links[];
+} ws_status_bin_t;
 
-static void ws_add_client(int fd)
+#define WS_STATUS_BIN_VERSION   3
+#define WS_STATUS_BIN_MAX_LEN   (sizeof(ws_status_bin_t) + CONFIG_MAX_LINKS * sizeof(ws_status_bin_link_t))
+
+static void ws_add_client(int fd, ws_format_t format)
 {
     xSemaphoreTake(g_ws_mutex, portMAX_DELAY);
     for (int i = 0; i < MAX_WS_CLIENTS; i++) {
-        if (g_ws_clients[i] < 0) {
-            g_ws_clients[i] = fd;
-            ESP_LOGI(TAG, "WebSocket client added: fd=%d, slot=%d", fd, i);
+        if (g_ws_clients[i].fd < 0) {
+            g_ws_clients[i].fd = fd;
+            g_ws_clients[i].format = format;
+            ESP_LOGI(TAG, "WebSocket client added: fd=%d, slot=%d, format=%d", fd, i, format);
             break;
         }
     }
@@ -705,8 +2460,8 @@ static void ws_remove_client(int fd)
 {
     xSemaphoreTake(g_ws_mutex, portMAX_DELAY);
     for (int i = 0; i < MAX_WS_CLIENTS; i++) {
-        if (g_ws_clients[i] == fd) {
-            g_ws_clients[i] = -1;
+        if (g_ws_clients[i].fd == fd) {
+            g_ws_clients[i].fd = -1;
             ESP_LOGI(TAG, "WebSocket client removed: fd=%d", fd);
             break;
         }
@@ -714,56 +2469,119 @@ static void ws_remove_client(int fd)
     xSemaphoreGive(g_ws_mutex);
 }
 
-/* Async send work structure */
+static uint32_t ws_client_count(ws_format_t format)
+{
+    uint32_t count = 0;
+
+    xSemaphoreTake(g_ws_mutex, portMAX_DELAY);
+    for (int i = 0; i < MAX_WS_CLIENTS; i++) {
+        if (g_ws_clients[i].fd >= 0 && g_ws_clients[i].format == format) {
+            count++;
+        }
+    }
+    xSemaphoreGive(g_ws_mutex);
+
+    return count;
+}
+
+/**
+ * @brief Reference-counted WebSocket frame shared by every client of one format
+ *
+ * The payload is immutable while a broadcast holds a reference; the owner may
+ * only rewrite it in place once it holds the last reference again.
+ */
 typedef struct {
-    httpd_handle_t hd;
-    int fd;
-    char data[512];
+    uint32_t refs;
+    ws_format_t format;
+    size_t capacity;
     size_t len;
-} ws_async_arg_t;
+    uint8_t payload[];
+} ws_frame_t;
 
-static void ws_async_send(void *arg)
+static ws_frame_t *ws_frame_alloc(ws_format_t format, size_t capacity)
 {
-    ws_async_arg_t *a = (ws_async_arg_t *)arg;
-    
-    httpd_ws_frame_t ws_pkt = {
-        .type = HTTPD_WS_TYPE_TEXT,
-        .payload = (uint8_t *)a->data,
-        .len = a->len,
-        .final = true,
-    };
-    
-    esp_err_t ret = httpd_ws_send_frame_async(a->hd, a->fd, &ws_pkt);
-    if (ret != ESP_OK) {
-        ESP_LOGD(TAG, "WS send failed fd=%d: %s", a->fd, esp_err_to_name(ret));
-        ws_remove_client(a->fd);
+    ws_frame_t *frame = malloc(sizeof(ws_frame_t) + capacity);
+    if (frame) {
+        frame->refs = 1;
+        frame->format = format;
+        frame->capacity = capacity;
+        frame->len = 0;
     }
-    
-    free(arg);
+    return frame;
 }
 
-static void ws_broadcast(const char *data, size_t len)
+static ws_frame_t *ws_frame_ref(ws_frame_t *frame)
 {
-    if (!g_httpd || !g_ws_mutex) return;
-    
+    __atomic_add_fetch(&frame->refs, 1, __ATOMIC_RELAXED);
+    return frame;
+}
+
+static void ws_frame_unref(ws_frame_t *frame)
+{
+    if (frame && __atomic_sub_fetch(&frame->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(frame);
+    }
+}
+
+/**
+ * @brief Get a frame the caller may write: reuse the previous one when no broadcast still holds it
+ */
+static ws_frame_t *ws_frame_get_writable(ws_frame_t **cached, ws_format_t format, size_t capacity)
+{
+    ws_frame_t *frame = *cached;
+
+    if (frame && __atomic_load_n(&frame->refs, __ATOMIC_ACQUIRE) == 1 && frame->capacity >= capacity) {
+        return frame;
+    }
+
+    ws_frame_unref(frame);
+    *cached = ws_frame_alloc(format, capacity);
+    return *cached;
+}
+
+/* Runs in the httpd task, sends the shared frame to every client of its format */
+static void ws_async_send(void *arg)
+{
+    ws_frame_t *frame = (ws_frame_t *)arg;
+    int fds[MAX_WS_CLIENTS];
+    int fd_num = 0;
+
     xSemaphoreTake(g_ws_mutex, portMAX_DELAY);
     for (int i = 0; i < MAX_WS_CLIENTS; i++) {
-        int fd = g_ws_clients[i];
-        if (fd >= 0) {
-            ws_async_arg_t *arg = malloc(sizeof(ws_async_arg_t));
-            if (arg) {
-                arg->hd = g_httpd;
-                arg->fd = fd;
-                memcpy(arg->data, data, len);
-                arg->len = len;
-                
-                if (httpd_queue_work(g_httpd, ws_async_send, arg) != ESP_OK) {
-                    free(arg);
-                }
-            }
+        if (g_ws_clients[i].fd >= 0 && g_ws_clients[i].format == frame->format) {
+            fds[fd_num++] = g_ws_clients[i].fd;
         }
     }
     xSemaphoreGive(g_ws_mutex);
+
+    httpd_ws_frame_t ws_pkt = {
+        .type = frame->format == WS_FORMAT_BINARY ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT,
+        .payload = frame->payload,
+        .len = frame->len,
+        .final = true,
+    };
+
+    for (int i = 0; i < fd_num; i++) {
+        esp_err_t ret = httpd_ws_send_frame_async(g_httpd, fds[i], &ws_pkt);
+        if (ret != ESP_OK) {
+            ESP_LOGD(TAG, "WS send failed fd=%d: %s", fds[i], esp_err_to_name(ret));
+            ws_remove_client(fds[i]);
+        }
+    }
+
+    ws_frame_unref(frame);
+}
+
+/**
+ * @brief Queue one frame to all clients of its format, the frame is never copied
+ */
+static void ws_broadcast(ws_frame_t *frame)
+{
+    if (!g_httpd || !g_ws_mutex || !frame) return;
+
+    if (httpd_queue_work(g_httpd, ws_async_send, ws_frame_ref(frame)) != ESP_OK) {
+        ws_frame_unref(frame);
+    }
 }
 
 /* WebSocket handler */
@@ -771,7 +2589,18 @@ static esp_err_t ws_handler(httpd_req_t *req)
 {
     if (req->method == HTTP_GET) {
         int fd = httpd_req_to_sockfd(req);
-        ws_add_client(fd);
+        ws_format_t format = WS_FORMAT_JSON;
+        char query[32];
+        char value[16];
+
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK
+                && httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK
+                && !strcmp(value, "binary")) {
+            format = WS_FORMAT_BINARY;
+        }
+
+        ws_add_client(fd, format);
+        ws_notify(WS_NOTIFY_FORCE);
         ESP_LOGI(TAG, "WebSocket handshake, fd=%d", fd);
         return ESP_OK;
     }
@@ -792,16 +2621,379 @@ static esp_err_t ws_handler(httpd_req_t *req)
 }
 
 /**
- * @brief WebSocket status broadcast task - runs at 4Hz
+ * @brief Fill the binary status frame, the buffer must hold WS_STATUS_BIN_MAX_LEN bytes
+ *
+ * @return Frame length in bytes
+ */
+static size_t ws_status_bin(ws_status_bin_t *bin, const presence_status_t *st, int calib_remaining)
+{
+    uint8_t link_num = 0;
+
+    bin->version = WS_STATUS_BIN_VERSION;
+    bin->flags = (st->room_status ? BIT0 : 0) | (st->human_status ? BIT1 : 0)
+                 | (st->calibrating ? BIT2 : 0);
+    bin->calib_remaining = MIN(calib_remaining, UINT16_MAX);
+    bin->wander_th = st->wander_threshold;
+    bin->jitter_th = st->jitter_threshold;
+
+    for (int i = 0; i < CONFIG_MAX_LINKS; i++) {
+        const link_status_t *link = &st->links[i];
+        ws_status_bin_link_t *out = &bin->links[link_num];
+
+        if (!link->used) {
+            continue;
+        }
+
+        out->id = i;
+        out->flags = (link->active ? BIT0 : 0) | (link->room_status ? BIT1 : 0)
+                     | (link->human_status ? BIT2 : 0);
+        memcpy(out->mac, link->mac, sizeof(out->mac));
+        out->rssi = link->rssi;
+        out->wander = link->wander;
+        out->jitter = link->jitter;
+        out->w_sens = link->wander_sensitivity;
+        out->j_sens = link->jitter_sensitivity;
+        link_num++;
+    }
+
+    bin->link_num = link_num;
+    return sizeof(ws_status_bin_t) + link_num * sizeof(ws_status_bin_link_t);
+}
+
+/* FNV-1a, only used to skip frames identical to the previous one */
+static uint32_t ws_payload_hash(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Serialized status shared by /api/status, its long-polls and the WebSocket push
+ *
+ * Each format is serialized once per snapshot generation and calibration
+ * second, by the first consumer asking for it; the others take a reference
+ * to the same immutable frame. lock only covers the pointer and its key,
+ * build keeps two consumers from serializing the same generation twice.
+ */
+static struct {
+    portMUX_TYPE lock;
+    SemaphoreHandle_t build;
+    ws_frame_t *frames[WS_FORMAT_MAX];
+    uint32_t generation[WS_FORMAT_MAX];
+    int calib_remaining[WS_FORMAT_MAX];
+} g_status_cache = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static ws_frame_t *status_cache_lookup(ws_format_t format, uint32_t generation, int calib_remaining)
+{
+    ws_frame_t *frame = NULL;
+
+    portENTER_CRITICAL(&g_status_cache.lock);
+    if (g_status_cache.frames[format] && g_status_cache.generation[format] == generation
+            && g_status_cache.calib_remaining[format] == calib_remaining) {
+        frame = ws_frame_ref(g_status_cache.frames[format]);
+    }
+    portEXIT_CRITICAL(&g_status_cache.lock);
+
+    return frame;
+}
+
+/* Called with g_status_cache.build held */
+static ws_frame_t *status_cache_build(ws_format_t format, int calib_remaining)
+{
+    size_t capacity = format == WS_FORMAT_BINARY ? WS_STATUS_BIN_MAX_LEN : STATUS_JSON_MAX_LEN;
+    int64_t start_us = csi_perf_begin();
+    presence_status_t st;
+    uint32_t generation = status_snapshot_read(&st);
+
+    /* Out of the cache no new reference can be taken, so refs == 1 means it is ours to rewrite */
+    portENTER_CRITICAL(&g_status_cache.lock);
+    ws_frame_t *frame = g_status_cache.frames[format];
+    g_status_cache.frames[format] = NULL;
+    portEXIT_CRITICAL(&g_status_cache.lock);
+
+    if (!ws_frame_get_writable(&frame, format, capacity)) {
+        return NULL;
+    }
+
+    if (format == WS_FORMAT_BINARY) {
+        frame->len = ws_status_bin((ws_status_bin_t *)frame->payload, &st, calib_remaining);
+    } else {
+        int len = status_json((char *)frame->payload, frame->capacity, generation, &st, calib_remaining);
+
+        if (len <= 0 || (size_t)len >= frame->capacity) {
+            ESP_LOGW(TAG, "Status JSON truncated (%d/%u bytes), not sent", len, (unsigned)frame->capacity);
+            ws_frame_unref(frame);
+            return NULL;
+        }
+
+        frame->len = len;
+        csi_perf_end(g_perf_status_json, start_us);
+    }
+
+    portENTER_CRITICAL(&g_status_cache.lock);
+    g_status_cache.frames[format] = ws_frame_ref(frame);
+    g_status_cache.generation[format] = generation;
+    g_status_cache.calib_remaining[format] = calib_remaining;
+    portEXIT_CRITICAL(&g_status_cache.lock);
+
+    return frame;
+}
+
+/**
+ * @brief Reference to the serialized latest status, any task
+ *
+ * @return Frame to release with ws_frame_unref(), NULL if out of memory
+ */
+static ws_frame_t *status_cache_get(ws_format_t format)
+{
+    int calib_remaining = calibration_remaining_s();
+    ws_frame_t *frame = status_cache_lookup(format, status_generation(), calib_remaining);
+
+    if (frame) {
+        return frame;
+    }
+
+    xSemaphoreTake(g_status_cache.build, portMAX_DELAY);
+    /* Another consumer may have built it while this one waited */
+    frame = status_cache_lookup(format, status_generation(), calib_remaining);
+    if (!frame) {
+        frame = status_cache_build(format, calib_remaining);
+    }
+    xSemaphoreGive(g_status_cache.build);
+
+    return frame;
+}
+
+/**
+ * @brief Broadcast the status frame of every format that has a client
+ *
+ * @param force Send even if the frame is identical to the last one (heartbeat, new client)
+ */
+static void ws_push_status(uint32_t *last_hash, bool force)
+{
+    int64_t start_us = csi_perf_begin();
+
+    for (int format = 0; format < WS_FORMAT_MAX; format++) {
+        if (!ws_client_count(format)) {
+            continue;
+        }
+
+        ws_frame_t *frame = status_cache_get(format);
+        if (!frame) {
+            continue;
+        }
+
+        /* "gen" leads the JSON and changes with every publish, even when nothing shown did */
+        const uint8_t *body = frame->payload;
+        const uint8_t *comma = memchr(frame->payload, ',', frame->len);
+        if (format == WS_FORMAT_JSON && comma) {
+            body = comma;
+        }
+
+        uint32_t hash = ws_payload_hash(body, frame->len - (body - frame->payload));
+        if (force || hash != last_hash[format]) {
+            last_hash[format] = hash;
+            ws_broadcast(frame);
+        }
+        ws_frame_unref(frame);
+    }
+
+    csi_perf_end(g_perf_ws_push, start_us);
+}
+
+static esp_err_t status_send(httpd_req_t *req)
+{
+    ws_frame_t *frame = status_cache_get(WS_FORMAT_JSON);
+
+    if (!frame) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    esp_err_t ret = httpd_resp_send(req, (const char *)frame->payload, frame->len);
+    ws_frame_unref(frame);
+    return ret;
+}
+
+/* httpd_req_async_handler_begin() first shipped in ESP-IDF v5.2 */
+#define STATUS_LONG_POLL_SUPPORTED  (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0))
+
+#if STATUS_LONG_POLL_SUPPORTED
+/* Long-polls waiting for a generation after since, guarded by g_status_cache.lock */
+typedef struct {
+    bool used;
+    httpd_req_t *req;           /* Async copy, NULL while the slot is being filled */
+    uint32_t since;
+    uint32_t deadline;
+} status_poll_t;
+
+static status_poll_t g_status_polls[CONFIG_STATUS_LONG_POLL_MAX];
+
+/**
+ * @brief Keep a request open until the generation moves past since
+ *
+ * @return ESP_OK if the request was taken over, it must not be answered by the caller
+ */
+static esp_err_t status_poll_park(httpd_req_t *req, uint32_t since)
+{
+    status_poll_t *poll = NULL;
+    httpd_req_t *copy = NULL;
+
+    portENTER_CRITICAL(&g_status_cache.lock);
+    for (int i = 0; i < CONFIG_STATUS_LONG_POLL_MAX && !poll; i++) {
+        if (!g_status_polls[i].used) {
+            poll = &g_status_polls[i];
+            poll->used = true;
+        }
+    }
+    portEXIT_CRITICAL(&g_status_cache.lock);
+
+    if (!poll) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = httpd_req_async_handler_begin(req, &copy);
+
+    portENTER_CRITICAL(&g_status_cache.lock);
+    if (ret == ESP_OK) {
+        poll->req = copy;
+        poll->since = since;
+        poll->deadline = esp_log_timestamp() + CONFIG_STATUS_LONG_POLL_MS;
+    } else {
+        poll->used = false;
+    }
+    portEXIT_CRITICAL(&g_status_cache.lock);
+
+    /* The generation may have moved on before the slot was filled */
+    ws_notify(WS_NOTIFY_POLL);
+    return ret;
+}
+
+/**
+ * @brief WebSocket task: answer the long-polls whose generation moved on or that timed out
+ *
+ * @param deadline Lowered to the earliest deadline of the polls still waiting
+ */
+static void status_poll_serve(uint32_t now, uint32_t *deadline)
+{
+    httpd_req_t *ready[CONFIG_STATUS_LONG_POLL_MAX];
+    int ready_num = 0;
+    uint32_t generation = status_generation();
+
+    portENTER_CRITICAL(&g_status_cache.lock);
+    for (int i = 0; i < CONFIG_STATUS_LONG_POLL_MAX; i++) {
+        status_poll_t *poll = &g_status_polls[i];
+
+        if (!poll->req) {
+            continue;
+        }
+
+        if (poll->since != generation || (int32_t)(now - poll->deadline) >= 0) {
+            ready[ready_num++] = poll->req;
+            poll->req = NULL;
+            poll->used = false;
+        } else if ((int32_t)(poll->deadline - *deadline) < 0) {
+            *deadline = poll->deadline;
+        }
+    }
+    portEXIT_CRITICAL(&g_status_cache.lock);
+
+    for (int i = 0; i < ready_num; i++) {
+        status_send(ready[i]);
+        httpd_req_async_handler_complete(ready[i]);
+    }
+}
+#else
+static esp_err_t status_poll_park(httpd_req_t *req, uint32_t since)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static void status_poll_serve(uint32_t now, uint32_t *deadline)
+{
+}
+#endif
+
+/**
+ * @brief Latest status, "?since=<gen>" waits up to CONFIG_STATUS_LONG_POLL_MS for a newer one
+ *
+ * A busy or unsupported long-poll is answered at once, clients just poll again.
+ */
+static esp_err_t http_get_status(httpd_req_t *req)
+{
+    char query[32];
+    char value[12];
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK
+            && httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+        uint32_t since = strtoul(value, NULL, 10);
+
+        if (since == status_generation() && status_poll_park(req, since) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+
+    return status_send(req);
+}
+
+/**
+ * @brief Request a status push from the WebSocket task
+ *
+ * @param events WS_NOTIFY_* bits, safe to call from any task
+ */
+static void ws_notify(uint32_t events)
+{
+    if (g_ws_task) {
+        xTaskNotify(g_ws_task, events, eSetBits);
+    }
+}
+
+/**
+ * @brief WebSocket status push task
+ *
+ * Woken by ws_notify(): room/motion/link transitions are pushed at once, limited
+ * to one frame per CONFIG_WS_PUSH_MIN_INTERVAL_MS; value-only updates are
+ * coalesced to one frame per CONFIG_WS_UPDATE_INTERVAL_MS. Frames identical to
+ * the last one are not sent, except for a heartbeat every CONFIG_WS_HEARTBEAT_MS.
+ * It also answers the parked /api/status long-polls.
  */
 static void ws_broadcast_task(void *arg)
 {
-    char buf[768];
+    uint32_t last_hash[WS_FORMAT_MAX] = {0};
+    uint32_t pending = 0;
+    uint32_t last_push = esp_log_timestamp();
+    int last_calib_remaining = -1;
     ESP_LOGI(TAG, "WebSocket broadcast task started");
     
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(250));  /* 4Hz update for smoother UI */
-        
+        uint32_t now = esp_log_timestamp();
+        uint32_t deadline = last_push + CONFIG_WS_HEARTBEAT_MS;
+
+        if (pending & (WS_NOTIFY_TRANSITION | WS_NOTIFY_FORCE)) {
+            deadline = last_push + CONFIG_WS_PUSH_MIN_INTERVAL_MS;
+        } else if (pending & WS_NOTIFY_UPDATE) {
+            deadline = last_push + CONFIG_WS_UPDATE_INTERVAL_MS;
+        }
+
+        /* Keep checking the calibration countdown while calibrating */
+        if (g_state.calibrating && (int32_t)(deadline - now) > WS_CALIBRATION_CHECK_MS) {
+            deadline = now + WS_CALIBRATION_CHECK_MS;
+        }
+
+        status_poll_serve(now, &deadline);
+
+        int32_t wait_ms = (int32_t)(deadline - now);
+        uint32_t events = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &events, wait_ms > 0 ? pdMS_TO_TICKS(wait_ms) : 0) == pdTRUE) {
+            pending |= events & ~WS_NOTIFY_POLL;
+        }
+
         /* Check calibration timeout - auto-stop after 30 seconds */
         if (g_state.calibrating) {
             uint32_t elapsed = esp_log_timestamp() - g_state.calibration_start_time;
@@ -812,41 +3004,25 @@ static void ws_broadcast_task(void *arg)
         }
         
         /* Calculate remaining calibration time */
-        int calib_remaining = 0;
-        if (g_state.calibrating) {
-            uint32_t elapsed = esp_log_timestamp() - g_state.calibration_start_time;
-            calib_remaining = (int)(g_state.calibration_duration_ms - elapsed) / 1000;
-            if (calib_remaining < 0) calib_remaining = 0;
+        int calib_remaining = calibration_remaining_s();
+        if (calib_remaining != last_calib_remaining) {
+            last_calib_remaining = calib_remaining;
+            pending |= WS_NOTIFY_UPDATE;
         }
-        
-        xSemaphoreTake(g_state_mutex, portMAX_DELAY);
-        int len = snprintf(buf, sizeof(buf),
-            "{\"room\":%d,\"moving\":%d,\"calibrating\":%d,\"calib_remaining\":%d,"
-            "\"wander_th\":%.6f,\"jitter_th\":%.6f,"
-            "\"links\":["
-            "{\"active\":%d,\"room\":%d,\"move\":%d,\"wander\":%.6f,\"jitter\":%.6f,\"w_sens\":%.3f,\"j_sens\":%.3f},"
-            "{\"active\":%d,\"room\":%d,\"move\":%d,\"wander\":%.6f,\"jitter\":%.6f,\"w_sens\":%.3f,\"j_sens\":%.3f},"
-            "{\"active\":%d,\"room\":%d,\"move\":%d,\"wander\":%.6f,\"jitter\":%.6f,\"w_sens\":%.3f,\"j_sens\":%.3f}]}",
-            g_state.room_status ? 1 : 0,
-            g_state.human_status ? 1 : 0,
-            g_state.calibrating ? 1 : 0,
-            calib_remaining,
-            g_state.wander_threshold, g_state.jitter_threshold,
-            /* Link 0 */
-            g_state.links[0].active ? 1 : 0, g_state.links[0].room_status ? 1 : 0,
-            g_state.links[0].human_status ? 1 : 0, g_state.links[0].wander, g_state.links[0].jitter,
-            g_state.links[0].wander_sensitivity, g_state.links[0].jitter_sensitivity,
-            /* Link 1 */
-            g_state.links[1].active ? 1 : 0, g_state.links[1].room_status ? 1 : 0,
-            g_state.links[1].human_status ? 1 : 0, g_state.links[1].wander, g_state.links[1].jitter,
-            g_state.links[1].wander_sensitivity, g_state.links[1].jitter_sensitivity,
-            /* Link 2 */
-            g_state.links[2].active ? 1 : 0, g_state.links[2].room_status ? 1 : 0,
-            g_state.links[2].human_status ? 1 : 0, g_state.links[2].wander, g_state.links[2].jitter,
-            g_state.links[2].wander_sensitivity, g_state.links[2].jitter_sensitivity);
-        xSemaphoreGive(g_state_mutex);
-        
-        ws_broadcast(buf, len);
+
+        now = esp_log_timestamp();
+        uint32_t since = now - last_push;
+        bool heartbeat = since >= CONFIG_WS_HEARTBEAT_MS;
+
+        if (!heartbeat
+                && !((pending & (WS_NOTIFY_TRANSITION | WS_NOTIFY_FORCE)) && since >= CONFIG_WS_PUSH_MIN_INTERVAL_MS)
+                && !((pending & WS_NOTIFY_UPDATE) && since >= CONFIG_WS_UPDATE_INTERVAL_MS)) {
+            continue;
+        }
+
+        ws_push_status(last_hash, heartbeat || (pending & WS_NOTIFY_FORCE));
+        pending = 0;
+        last_push = now;
     }
 }
 
@@ -856,8 +3032,10 @@ static void ws_broadcast_task(void *arg)
 static httpd_handle_t start_webserver(void)
 {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 10;
+    config.max_uri_handlers = 15;
     config.stack_size = 8192;
+    config.task_priority = csi_task_priority(CSI_TASK_STAGE_UI);
+    config.core_id = csi_task_core(CSI_TASK_STAGE_UI);
     
     if (httpd_start(&g_httpd, &config) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start HTTP server");
@@ -865,20 +3043,38 @@ static httpd_handle_t start_webserver(void)
     }
     
     /* Register URI handlers */
-    httpd_uri_t uri_index = { .uri = "/", .method = HTTP_GET, .handler = http_get_index };
-    httpd_uri_t uri_style = { .uri = "/style.css", .method = HTTP_GET, .handler = http_get_style };
-    httpd_uri_t uri_script = { .uri = "/app.js", .method = HTTP_GET, .handler = http_get_script };
+    for (int i = 0; i < g_web_asset_num; i++) {
+        httpd_uri_t uri_asset = {
+            .uri = g_web_assets[i].uri, .method = HTTP_GET, .handler = http_get_asset,
+            .user_ctx = (void *)&g_web_assets[i]
+        };
+        httpd_register_uri_handler(g_httpd, &uri_asset);
+    }
+
     httpd_uri_t uri_status = { .uri = "/api/status", .method = HTTP_GET, .handler = http_get_status };
     httpd_uri_t uri_calibrate = { .uri = "/api/calibrate", .method = HTTP_POST, .handler = http_post_calibrate };
+    httpd_uri_t uri_calibrate_get = { .uri = "/api/calibrate", .method = HTTP_GET, .handler = http_get_calibrate };
     httpd_uri_t uri_sensitivity = { .uri = "/api/sensitivity", .method = HTTP_POST, .handler = http_post_sensitivity };
+    httpd_uri_t uri_perf = { .uri = "/api/perf", .method = HTTP_GET, .handler = http_get_perf };
+    httpd_uri_t uri_diag = { .uri = "/api/diag", .method = HTTP_GET, .handler = http_get_diag };
+    httpd_uri_t uri_boot = { .uri = "/api/boot", .method = HTTP_GET, .handler = http_get_boot };
+    httpd_uri_t uri_channel = { .uri = "/api/channel", .method = HTTP_POST, .handler = http_post_channel };
+    httpd_uri_t uri_channel_get = { .uri = "/api/channel", .method = HTTP_GET, .handler = http_get_channel };
+    httpd_uri_t uri_detect = { .uri = "/api/detect", .method = HTTP_POST, .handler = http_post_detect };
+    httpd_uri_t uri_detect_get = { .uri = "/api/detect", .method = HTTP_GET, .handler = http_get_detect };
     httpd_uri_t uri_ws = { .uri = "/ws", .method = HTTP_GET, .handler = ws_handler, .is_websocket = true };
     
-    httpd_register_uri_handler(g_httpd, &uri_index);
-    httpd_register_uri_handler(g_httpd, &uri_style);
-    httpd_register_uri_handler(g_httpd, &uri_script);
     httpd_register_uri_handler(g_httpd, &uri_status);
     httpd_register_uri_handler(g_httpd, &uri_calibrate);
+    httpd_register_uri_handler(g_httpd, &uri_calibrate_get);
     httpd_register_uri_handler(g_httpd, &uri_sensitivity);
+    httpd_register_uri_handler(g_httpd, &uri_perf);
+    httpd_register_uri_handler(g_httpd, &uri_diag);
+    httpd_register_uri_handler(g_httpd, &uri_boot);
+    httpd_register_uri_handler(g_httpd, &uri_channel);
+    httpd_register_uri_handler(g_httpd, &uri_channel_get);
+    httpd_register_uri_handler(g_httpd, &uri_detect);
+    httpd_register_uri_handler(g_httpd, &uri_detect_get);
     httpd_register_uri_handler(g_httpd, &uri_ws);
     
     ESP_LOGI(TAG, "HTTP server started");
@@ -904,7 +3100,7 @@ static void wifi_ap_init(void)
             .ssid = CONFIG_AP_SSID,
             .password = CONFIG_AP_PASSWORD,
             .ssid_len = strlen(CONFIG_AP_SSID),
-            .channel = CONFIG_WIFI_CHANNEL,
+            .channel = g_channel.channel,
             .max_connection = CONFIG_AP_MAX_CONN,
             .authmode = WIFI_AUTH_WPA2_PSK,
         },
@@ -916,7 +3112,7 @@ static void wifi_ap_init(void)
     ESP_ERROR_CHECK(esp_wifi_start());
     
     /* Set STA channel same as AP */
-    ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_WIFI_CHANNEL, WIFI_SECOND_CHAN_BELOW));
+    ESP_ERROR_CHECK(channel_tune(g_channel.channel));
     ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
     
     /* Set fixed MAC for sender identification */
@@ -937,7 +3133,8 @@ static void radar_init(void)
     /* CSI configuration */
     esp_radar_csi_config_t csi_config = ESP_RADAR_CSI_CONFIG_DEFAULT();
     memcpy(csi_config.filter_mac, CONFIG_CSI_SEND_MAC, 6);
-    csi_config.csi_recv_interval = 10;
+    memcpy(g_state.links[0].mac, CONFIG_CSI_SEND_MAC, 6);
+    csi_config.csi_recv_interval = g_state.links[0].detect.csi_interval_ms;
     
     /* ESP-NOW configuration for receiving slave reports */
     esp_radar_espnow_config_t espnow_config = ESP_RADAR_ESPNOW_CONFIG_DEFAULT();
@@ -946,6 +3143,10 @@ static void radar_init(void)
     esp_radar_dec_config_t dec_config = ESP_RADAR_DEC_CONFIG_DEFAULT();
     dec_config.wifi_radar_cb = wifi_radar_cb;
     
+    /* Smoothing windows must be ready before the fusion task starts */
+    ESP_ERROR_CHECK(radar_window_init(&g_state.wander_win, g_wander_win_storage, RADAR_WINDOW_MAX_LEN, g_state.links[0].detect.window_len));
+    ESP_ERROR_CHECK(radar_window_init(&g_state.jitter_win, g_jitter_win_storage, RADAR_WINDOW_MAX_LEN, g_state.links[0].detect.window_len));
+    
     /* Initialize subsystems (WiFi already initialized in AP mode) */
     ESP_ERROR_CHECK(esp_wifi_set_promiscuous(true));
     ESP_ERROR_CHECK(esp_radar_csi_init(&csi_config));
@@ -956,21 +3157,43 @@ static void radar_init(void)
     
     /* Add broadcast peer */
     esp_now_peer_info_t peer = {
-        .channel = CONFIG_WIFI_CHANNEL,
+        .channel = 0,   /* Current channel, follows the channel survey */
         .ifidx = WIFI_IF_STA,
         .encrypt = false,
         .peer_addr = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
     };
     esp_now_add_peer(&peer);
+
+    /* Commands take the rate the link to each slave allows, the sender's packets keep theirs */
+    espnow_rate_config_t rate_config = ESPNOW_RATE_CONFIG_DEFAULT();
+    rate_config.sensing_phymode = CONFIG_SEND_PHYMODE;
+    rate_config.sensing_rate = CONFIG_SEND_RATE;
+    ESP_ERROR_CHECK(espnow_rate_init(&rate_config));
     
-    /* Register receive callback */
+    /* Register receive and send callbacks */
     esp_now_register_recv_cb(espnow_recv_cb);
+    esp_now_register_send_cb(espnow_send_cb);
     
     ESP_ERROR_CHECK(esp_radar_dec_init(&dec_config));
 }
 
+/* Boot steps, the LED driver and the radio need nothing from each other */
+static esp_err_t boot_led_init(void *arg)
+{
+    return led_init();
+}
+
+static esp_err_t boot_radio_init(void *arg)
+{
+    wifi_ap_init();
+    radar_init();
+    return ESP_OK;
+}
+
 void app_main(void)
 {
+    csi_boot_mark("app_main");
+
     /* Initialize NVS */
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -978,45 +3201,123 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    csi_boot_mark("nvs");
     
     /* Load saved settings from NVS */
-    nvs_load_settings();
+    settings_load();
     
     /* Initialize mutexes */
     g_state_mutex = xSemaphoreCreateMutex();
     g_ws_mutex = xSemaphoreCreateMutex();
-    
-    /* Initialize LED */
-    led_init();
+    g_status_cache.build = xSemaphoreCreateMutex();
+    online_calib_init(&g_state.calib, NULL);
+    /* A stale report is worth less than the latest one, so a full queue drops the oldest event */
+    csi_queue_config_t fusion_queue_config = CSI_QUEUE_CONFIG_DEFAULT("fusion", CONFIG_FUSION_QUEUE_LEN, sizeof(fusion_event_t));
+    fusion_queue_config.policy = CSI_QUEUE_DROP_OLDEST;
+    ESP_ERROR_CHECK(csi_queue_init(&g_fusion_queue, &fusion_queue_config));
+    status_snapshot_publish();
+
+    /* Latency probes, read on /api/perf */
+    g_perf_fusion_queue = csi_perf_register("fusion_queue");
+    g_perf_fusion       = csi_perf_register("fusion");
+    g_perf_report_age   = csi_perf_register("report_age");
+    g_perf_status_json  = csi_perf_register("status_json");
+    g_perf_ws_push      = csi_perf_register("ws_push");
+
+    /* Task and heap samples, read on /api/diag */
+    csi_diag_config_t diag_config = CSI_DIAG_CONFIG_DEFAULT();
+    diag_config.interval_ms = CONFIG_DIAG_INTERVAL_MS;
+    diag_config.history_len = CONFIG_DIAG_HISTORY_LEN;
+    ESP_ERROR_CHECK(csi_diag_init(&diag_config, g_diag_history));
     
     ESP_LOGI(TAG, "================ RECV MASTER ================");
     ESP_LOGI(TAG, "AP SSID: %s, Password: %s", CONFIG_AP_SSID, CONFIG_AP_PASSWORD);
     ESP_LOGI(TAG, "Web interface: http://192.168.4.1");
     
-    /* Initialize WiFi AP */
-    wifi_ap_init();
+    /* Initialize the LED, and the WiFi AP followed by radar, at the same time */
+    const csi_boot_step_t boot_steps[] = {
+        {.name = "led", .init = boot_led_init, .stage = CSI_TASK_STAGE_BACKGROUND, .stack_size = 3072},
+        {.name = "radio", .init = boot_radio_init, .stage = CSI_TASK_STAGE_LINK, .stack_size = 4096},
+    };
+    ESP_ERROR_CHECK(csi_boot_run_parallel(boot_steps, sizeof(boot_steps) / sizeof(boot_steps[0])));
     
-    /* Initialize radar */
-    radar_init();
+    csi_task_log_topology();
+
+    /* Start fusion before the callbacks produce events */
+    ESP_ERROR_CHECK(csi_task_create(fusion_task, "fusion", 4096, NULL, CSI_TASK_STAGE_FUSION, NULL));
+    ESP_ERROR_CHECK(csi_task_create(channel_task, "channel", 4096, NULL, CSI_TASK_STAGE_LINK, &g_channel_task));
     
     /* Start radar processing */
     ESP_ERROR_CHECK(esp_radar_start());
+    csi_boot_mark("csi_live");
     
-    /* Start HTTP server */
+    /* The web interface only comes up once CSI capture is live */
     start_webserver();
     
-    /* Start WebSocket broadcast task */
-    xTaskCreate(ws_broadcast_task, "ws_broadcast", 4096, NULL, 5, NULL);
+    /* Start WebSocket push task */
+    ESP_ERROR_CHECK(csi_task_create(ws_broadcast_task, "ws_broadcast", 4096, NULL, CSI_TASK_STAGE_OUTPUT, &g_ws_task));
+    csi_boot_mark("http");
     
     ESP_LOGI(TAG, "Master receiver started");
     ESP_LOGI(TAG, "Connect to WiFi '%s' and open http://192.168.4.1", CONFIG_AP_SSID);
     
     /* Main loop - periodic status logging */
+    TickType_t usage_tick = xTaskGetTickCount();
+    bool boot_logged = false;
+
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(5000));
+
+        if (!boot_logged && csi_boot_get_us("first_detection") >= 0) {
+            csi_boot_log();
+#if CONFIG_CSI_MEM_LOG_MAP
+            csi_mem_note("csi_diag history", g_diag_history, sizeof(g_diag_history));
+            csi_mem_log_map();
+#endif
+            boot_logged = true;
+        }
+
+        if (xTaskGetTickCount() - usage_tick >= pdMS_TO_TICKS(CONFIG_TASK_USAGE_LOG_INTERVAL_MS)) {
+            csi_task_log_usage();
+            espnow_rate_log_stats();
+            usage_tick = xTaskGetTickCount();
+        }
         
-        ESP_LOGI(TAG, "Status: Room=%d, Moving=%d, Links: [%d,%d,%d]",
-                 g_state.room_status, g_state.human_status,
-                 g_state.links[0].active, g_state.links[1].active, g_state.links[2].active);
+        presence_status_t st;
+        status_snapshot_read(&st);
+        int used_num = 0;
+        int active_num = 0;
+        int synced_num = 0;
+        uint16_t max_age_ms = 0;
+        uint16_t max_sync_error_us = 0;
+        for (int i = 0; i < CONFIG_MAX_LINKS; i++) {
+            const link_status_t *link = &st.links[i];
+            used_num += link->used ? 1 : 0;
+            active_num += link->active ? 1 : 0;
+            if (i > 0 && link->used && link->synced) {
+                synced_num++;
+                max_age_ms = MAX(max_age_ms, link->report_age_ms);
+                max_sync_error_us = MAX(max_sync_error_us, link->sync_error_us);
+            }
+        }
+        settings_store_stats_t settings_stats;
+        settings_store_get_stats(&settings_stats);
+        csi_queue_stats_t fusion_queue_stats;
+        csi_queue_get_stats(&g_fusion_queue, &fusion_queue_stats);
+        ESP_LOGI(TAG, "Status: Room=%d, Moving=%d, Links: %d active / %d registered (max %d), "
+                 "join rejects: %lu, fusion queue drops: %lu (high water %lu), settings saves/writes: %lu/%lu",
+                 st.room_status, st.human_status, active_num, used_num, CONFIG_MAX_LINKS,
+                 (unsigned long)g_link_join_rejects, (unsigned long)csi_queue_drops(&fusion_queue_stats),
+                 (unsigned long)fusion_queue_stats.high_water,
+                 (unsigned long)settings_stats.saves, (unsigned long)settings_stats.writes);
+        if (st.power_mode == POWER_MODE_DUTY || st.power_wakes) {
+            ESP_LOGI(TAG, "Power: %s, %lu wake-ups, last %lu ms, max %lu ms",
+                     st.power_mode == POWER_MODE_DUTY ? "duty" : "continuous", (unsigned long)st.power_wakes,
+                     (unsigned long)st.power_wake_latency_ms, (unsigned long)st.power_wake_latency_max_ms);
+        }
+        if (used_num > 1) {
+            ESP_LOGI(TAG, "Clock sync: %d/%d slaves, max report age %u ms, max sync error %u us",
+                     synced_num, used_num - 1, max_age_ms, max_sync_error_us);
+        }
     }
 }
@@ -1,12 +1,14 @@
 /**
  * Room Presence Sensor - Web Interface
  * Real-time status display via WebSocket
- * Per-link sensitivity control
+ * Per-link sensitivity control, one card per registered node
  */
 
 // State
 let ws = null;
 let isCalibrating = false;
+// Open the page with ?ws=binary to receive the compact binary status frame
+const wsBinary = new URLSearchParams(window.location.search).get('ws') === 'binary';
 
 // DOM Elements
 const statusPanel = document.querySelector('.status-panel');
@@ -17,39 +19,53 @@ const btnCalibrate = document.getElementById('btnCalibrate');
 const calibCountdown = document.getElementById('calibCountdown');
 const wanderThreshold = document.getElementById('wanderThreshold');
 const jitterThreshold = document.getElementById('jitterThreshold');
+const linksGrid = document.getElementById('linksGrid');
+const linkCardTemplate = document.getElementById('linkCardTemplate');
+
+// Link cards by link id, created as nodes join and removed when they leave
+const linkCards = new Map();
 
 // Initialize
 document.addEventListener('DOMContentLoaded', () => {
     initWebSocket();
-    initSliderListeners();
 });
 
-// Setup slider value display listeners
-function initSliderListeners() {
-    for (let i = 0; i < 3; i++) {
-        const wSlider = document.getElementById(`link${i}WSens`);
-        const jSlider = document.getElementById(`link${i}JSens`);
-        const wVal = document.getElementById(`link${i}WVal`);
-        const jVal = document.getElementById(`link${i}JVal`);
-        
-        if (wSlider && wVal) {
-            wSlider.addEventListener('input', () => {
-                wVal.textContent = parseFloat(wSlider.value).toFixed(2);
-            });
-        }
-        if (jSlider && jVal) {
-            jSlider.addEventListener('input', () => {
-                jVal.textContent = parseFloat(jSlider.value).toFixed(2);
-            });
-        }
-    }
+// Field of a link card, see linkCardTemplate in index.html
+function cardField(card, name) {
+    return card.querySelector(`[data-field="${name}"]`);
+}
+
+// Create the card of a link with its slider value display listeners
+function createLinkCard(id) {
+    const card = linkCardTemplate.content.firstElementChild.cloneNode(true);
+    card.id = `link${id}`;
+    
+    const wSlider = cardField(card, 'wSens');
+    const jSlider = cardField(card, 'jSens');
+    const wVal = cardField(card, 'wVal');
+    const jVal = cardField(card, 'jVal');
+    
+    wSlider.addEventListener('input', () => {
+        wVal.textContent = parseFloat(wSlider.value).toFixed(2);
+    });
+    jSlider.addEventListener('input', () => {
+        jVal.textContent = parseFloat(jSlider.value).toFixed(2);
+    });
+    card.querySelector('.btn-apply').addEventListener('click', () => applyLinkSensitivity(id));
+    
+    // Keep the cards in link order
+    const next = [...linkCards.keys()].filter(k => k > id).sort((a, b) => a - b)[0];
+    linksGrid.insertBefore(card, next !== undefined ? linkCards.get(next) : null);
+    linkCards.set(id, card);
+    return card;
 }
 
 // WebSocket Connection
 function initWebSocket() {
-    const wsUrl = `ws://${window.location.host}/ws`;
+    const wsUrl = `ws://${window.location.host}/ws` + (wsBinary ? '?format=binary' : '');
     
     ws = new WebSocket(wsUrl);
+    ws.binaryType = 'arraybuffer';
     
     ws.onopen = () => {
         console.log('WebSocket connected');
@@ -72,7 +88,7 @@ function initWebSocket() {
     
     ws.onmessage = (event) => {
         try {
-            const data = JSON.parse(event.data);
+            const data = (event.data instanceof ArrayBuffer) ? decodeBinaryStatus(event.data) : JSON.parse(event.data);
             updateUI(data);
         } catch (e) {
             console.error('Failed to parse message:', e);
@@ -80,14 +96,59 @@ function initWebSocket() {
     };
 }
 
+// Decode ws_status_bin_t (little endian), see app_main.c
+function decodeBinaryStatus(buffer) {
+    const view = new DataView(buffer);
+    const flags = view.getUint8(1);
+    const linkNum = view.getUint8(4);
+    const data = {
+        room: flags & 1,
+        moving: (flags >> 1) & 1,
+        calibrating: (flags >> 2) & 1,
+        calib_remaining: view.getUint16(2, true),
+        wander_th: view.getFloat32(5, true),
+        jitter_th: view.getFloat32(9, true),
+        links: []
+    };
+
+    for (let i = 0, offset = 13; i < linkNum; i++, offset += 25) {
+        const linkFlags = view.getUint8(offset + 1);
+        const mac = [];
+        for (let j = 0; j < 6; j++) {
+            mac.push(view.getUint8(offset + 2 + j).toString(16).padStart(2, '0'));
+        }
+        data.links.push({
+            id: view.getUint8(offset),
+            mac: mac.join(':'),
+            active: linkFlags & 1,
+            room: (linkFlags >> 1) & 1,
+            move: (linkFlags >> 2) & 1,
+            rssi: view.getInt8(offset + 8),
+            wander: view.getFloat32(offset + 9, true),
+            jitter: view.getFloat32(offset + 13, true),
+            w_sens: view.getFloat32(offset + 17, true),
+            j_sens: view.getFloat32(offset + 21, true)
+        });
+    }
+    return data;
+}
+
 // Update UI with sensor data
 function updateUI(data) {
     // Update main status
     updateMainStatus(data.room, data.moving, data.calibrating, data.calib_remaining);
     
     // Update link cards (including per-link sensitivity display)
-    for (let i = 0; i < 3; i++) {
-        updateLinkCard(i, data.links[i]);
+    const ids = new Set();
+    for (const link of data.links) {
+        ids.add(link.id);
+        updateLinkCard(link);
+    }
+    for (const [id, card] of linkCards) {
+        if (!ids.has(id)) {
+            card.remove();
+            linkCards.delete(id);
+        }
     }
     
     // Update calibration status
@@ -129,16 +190,20 @@ function updateMainStatus(room, moving, calibrating, calibRemaining) {
     }
 }
 
-function updateLinkCard(index, link) {
-    const card = document.getElementById(`link${index}`);
-    const status = document.getElementById(`link${index}Status`);
-    const wander = document.getElementById(`link${index}Wander`);
-    const jitter = document.getElementById(`link${index}Jitter`);
-    const bar = document.getElementById(`link${index}Bar`);
+function updateLinkCard(link) {
+    const card = linkCards.get(link.id) || createLinkCard(link.id);
+    const status = cardField(card, 'status');
+    const wander = cardField(card, 'wander');
+    const jitter = cardField(card, 'jitter');
+    const bar = cardField(card, 'bar');
+    
+    // Per-link sensitivity current display (read-only)
+    const wCurrent = cardField(card, 'wCurrent');
+    const jCurrent = cardField(card, 'jCurrent');
     
-    // Per-link sensitivity current display (read-only, only for link 0)
-    const wCurrent = document.getElementById(`link${index}WCurrent`);
-    const jCurrent = document.getElementById(`link${index}JCurrent`);
+    card.querySelector('.link-name').textContent = link.id === 0
+        ? 'Link 1 (Master)'
+        : `Link ${link.id + 1} (${link.mac}${link.rssi ? `, ${link.rssi} dBm` : ''})`;
     
     if (link.active) {
         card.classList.add('active');
@@ -158,7 +223,7 @@ function updateLinkCard(index, link) {
         wander.textContent = link.wander.toFixed(4);
         jitter.textContent = link.jitter.toFixed(6);
         
-        // Update current sensitivity display (from server, only for link 0)
+        // Update current sensitivity display (from server)
         if (wCurrent && link.w_sens !== undefined) {
             wCurrent.textContent = link.w_sens.toFixed(2);
         }
@@ -185,11 +250,12 @@ function updateLinkCard(index, link) {
 
 // Per-link sensitivity apply
 async function applyLinkSensitivity(linkIndex) {
-    const wSlider = document.getElementById(`link${linkIndex}WSens`);
-    const jSlider = document.getElementById(`link${linkIndex}JSens`);
-    const btn = document.querySelector(`#link${linkIndex} .btn-sm`);
+    const card = linkCards.get(linkIndex);
+    if (!card) return;
     
-    if (!wSlider || !jSlider) return;
+    const wSlider = cardField(card, 'wSens');
+    const jSlider = cardField(card, 'jSens');
+    const btn = card.querySelector('.btn-apply');
     
     const wander = parseFloat(wSlider.value);
     const jitter = parseFloat(jSlider.value);
@@ -278,12 +344,19 @@ function updateCalibrationUI(calibRemaining) {
     }
 }
 
-// Fallback polling if WebSocket not supported
+// Fallback long-poll if WebSocket not supported: each request returns once the status generation moves on
 if (!window.WebSocket) {
-    setInterval(() => {
-        fetch('/api/status')
+    const poll = (gen) => {
+        fetch(gen === undefined ? '/api/status' : `/api/status?since=${gen}`)
             .then(r => r.json())
-            .then(data => updateUI(data))
-            .catch(e => console.error('Poll failed:', e));
-    }, 1000);
+            .then(data => {
+                updateUI(data);
+                poll(data.gen);
+            })
+            .catch(e => {
+                console.error('Poll failed:', e);
+                setTimeout(() => poll(gen), 1000);
+            });
+    };
+    poll();
 }
@@ -0,0 +1,40 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/**
+ * @file web_assets.h
+ * @brief Static web assets, embedded as they are and gzip-compressed
+ *
+ * web_assets.c is generated at build time by web_assets.py from main/web.
+ * Browsers only offer brotli over HTTPS and the AP serves plain HTTP, so
+ * gzip is the one compressed variant.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *uri;            /**< "/" for the page */
+    const char *type;           /**< Content-Type */
+    const char *cache_control;  /**< Cache-Control, long for the assets the page references by hash */
+    const char *etag;           /**< Strong ETag of data, quoted */
+    const char *etag_gzip;      /**< Strong ETag of gzip, quoted */
+    const uint8_t *data;
+    size_t len;
+    const uint8_t *gzip;
+    size_t gzip_len;
+} web_asset_t;
+
+extern const web_asset_t g_web_assets[];
+extern const size_t g_web_asset_num;
+
+#ifdef __cplusplus
+}
+#endif
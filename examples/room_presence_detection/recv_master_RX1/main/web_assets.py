@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+#
+# Generate web_assets.c from the files in web/: every asset as it is and
+# gzip-compressed, its content type, a strong ETag per representation and
+# its Cache-Control. The page references the other assets with their hash
+# in a ?v= query, so they can be cached for a year and still change with a
+# firmware update; the page itself is revalidated, which costs a 304.
+#
+# Usage: web_assets.py <output.c> <asset>...
+
+import gzip
+import hashlib
+import os
+import sys
+
+CONTENT_TYPES = {
+    '.html': 'text/html',
+    '.css': 'text/css',
+    '.js': 'application/javascript',
+}
+PAGE = 'index.html'
+CACHE_PAGE = 'no-cache'
+CACHE_VERSIONED = 'public, max-age=31536000, immutable'
+
+
+def c_array(name, data):
+    lines = [f'static const uint8_t {name}[] = {{']
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ', '.join(f'0x{b:02x}' for b in data[i:i + 16]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def c_name(path):
+    return os.path.basename(path).replace('.', '_').replace('-', '_')
+
+
+def main():
+    output, paths = sys.argv[1], sys.argv[2:]
+    assets = {os.path.basename(p): open(p, 'rb').read() for p in paths}
+    hashes = {name: hashlib.sha256(data).hexdigest()[:16] for name, data in assets.items() if name != PAGE}
+
+    if PAGE in assets:
+        page = assets[PAGE]
+        for name, digest in hashes.items():
+            page = page.replace(f'"/{name}"'.encode(), f'"/{name}?v={digest}"'.encode())
+        assets[PAGE] = page
+
+    out = ['/* Generated by web_assets.py from main/web, do not edit */',
+           '',
+           '#include "web_assets.h"',
+           '']
+    entries = []
+
+    for name, data in assets.items():
+        ext = os.path.splitext(name)[1]
+        digest = hashlib.sha256(data).hexdigest()[:16]
+        # mtime=0 keeps the output, and so the firmware, reproducible
+        compressed = gzip.compress(data, compresslevel=9, mtime=0)
+        ident = c_name(name)
+
+        out.append(c_array(f'{ident}_data', data))
+        out.append(c_array(f'{ident}_gzip', compressed))
+        out.append('')
+        entries.append(f'''    {{
+        .uri = "/{'' if name == PAGE else name}",
+        .type = "{CONTENT_TYPES.get(ext, 'application/octet-stream')}",
+        .cache_control = "{CACHE_PAGE if name == PAGE else CACHE_VERSIONED}",
+        .etag = "\\"{digest}\\"",
+        .etag_gzip = "\\"{digest}-gz\\"",
+        .data = {ident}_data,
+        .len = sizeof({ident}_data),
+        .gzip = {ident}_gzip,
+        .gzip_len = sizeof({ident}_gzip),
+    }},''')
+        print(f'web_assets: {name} {len(data)} -> {len(compressed)} bytes gzip', file=sys.stderr)
+
+    out.append('const web_asset_t g_web_assets[] = {')
+    out.extend(entries)
+    out.append('};')
+    out.append('')
+    out.append('const size_t g_web_asset_num = sizeof(g_web_assets) / sizeof(g_web_assets[0]);')
+
+    with open(output, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()
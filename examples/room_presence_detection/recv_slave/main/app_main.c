@@ -12,12 +12,16 @@
  * - Calculates presence/movement indicators using esp-radar
  * - Sends detection results to the master node via ESP-NOW
  * - Shows status via LED
+ * - Sleeps between the sender's bursts while the master reports an empty room
+ * - Follows the channel the master picks, and searches for the sender if it is lost
  */
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <math.h>
+#include <sys/param.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -30,15 +34,59 @@
 #include "esp_netif.h"
 #include "esp_now.h"
 #include "esp_timer.h"
+#include "esp_bit_defs.h"
+#include "esp_idf_version.h"
 
 #include "led_strip.h"
 #include "esp_radar.h"
+#include "radar_window.h"
+#include "radar_detect.h"
+#include "online_calib.h"
+#include "settings_store.h"
+#include "csi_wifi.h"
+#include "espnow_rate.h"
 
 static const char *TAG = "recv_slave";
 
 /* Configuration */
 #define CONFIG_WIFI_CHANNEL             11
-#define RADAR_BUFF_MAX_LEN              25
+#define RADAR_WINDOW_MAX_LEN            128   /* Upper bound for the runtime window length */
+#define RADAR_WINDOW_DEFAULT_LEN        25
+
+/* Uplink to the master */
+#define UPLINK_MODE_PERIODIC            0     /* One report every CONFIG_UPLINK_PERIOD_MS */
+#define UPLINK_MODE_ON_CHANGE           1     /* Report transitions and significant changes, else a heartbeat */
+#define CONFIG_UPLINK_MODE              UPLINK_MODE_ON_CHANGE
+#define CONFIG_UPLINK_PERIOD_MS         100   /* Periodic interval, also the sample interval of a batch */
+#define CONFIG_UPLINK_MIN_GAP_MS        100   /* On-change: min gap between value-change reports */
+#define CONFIG_UPLINK_HEARTBEAT_MS      1000  /* On-change: max silence, keep well below the master's link timeout */
+#define CONFIG_UPLINK_CHANGE_RATIO      0.2f  /* On-change: relative wander/jitter change that is reported */
+#define CONFIG_UPLINK_BATCH_SAMPLES     0     /* >0: append up to this many samples taken since the last report */
+
+/* Duty cycle, see power_task() */
+#define CONFIG_SEND_FREQUENCY           100   /* Packets per second of send_TX, one slot each */
+#define CONFIG_SEND_PHYMODE             WIFI_PHY_MODE_HT40      /* CONFIG_ESP_NOW_PHYMODE of send_TX */
+#define CONFIG_SEND_RATE                WIFI_PHY_RATE_MCS0_LGI  /* CONFIG_ESP_NOW_RATE of send_TX */
+#define CONFIG_POWER_WAKE_GUARD_MS      20    /* Radio on this long before a burst and after it */
+#define CONFIG_POWER_RESYNC_CYCLES      3     /* Cycles without a sender packet before listening a whole cycle */
+#define POWER_DUTY_SUPPORTED            (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0))
+#define POWER_CMD                       0x15  /* [mode][cycle_slots u16][burst_slots u16] */
+#define POWER_MODE_CONTINUOUS           0
+#define POWER_MODE_DUTY                 1
+
+/* Sensing channel, see channel_task() */
+#define CONFIG_CHANNEL_LOST_MS          30000 /* Sender silent this long before the channels are searched */
+#define CONFIG_CHANNEL_SEARCH_DWELL_MS  500   /* Listening time per channel, several sender packets */
+#define CHANNEL_CMD_SWITCH              0x17  /* [channel][delay_ms u16] */
+#define CHANNEL_MAX                     13
+
+/* Detection tuning set by the master, see detect_config_apply() */
+#define DETECT_DEFAULT_CSI_INTERVAL_MS  10    /* CSI decimation, 100 Hz is the rate of send_TX */
+#define DETECT_DEFAULT_VOTE_LEN         5
+#define DETECT_DEFAULT_MOVE_VOTES       2
+#define DETECT_CSI_INTERVAL_MAX_MS      1000
+#define DETECT_CMD                      0x18  /* [detect_config_t] */
+#define CONFIG_DETECT_REPORT_MS         60000 /* Repeat the tuning in effect for a master that rebooted */
 
 /* Sender's MAC address - used for CSI filtering */
 static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
@@ -46,6 +94,14 @@ static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00
 /* Master receiver's MAC address - set during pairing or use broadcast */
 static uint8_t g_master_mac[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
 
+/*
+ * Sender of the first command, the master. Once it is an ESP-NOW peer the
+ * reports go to it unicast: they are acknowledged, so their rate can adapt
+ */
+static uint8_t g_master_heard_mac[6];
+static bool g_master_heard;
+static const uint8_t *g_report_mac = g_master_mac;
+
 /* LED GPIO - different for different boards */
 #if CONFIG_IDF_TARGET_ESP32C5
 #define WS2812_GPIO 27
@@ -63,20 +119,22 @@ static led_strip_handle_t g_led_strip = NULL;
 
 /* Detection state */
 typedef struct {
-    float wander_buff[RADAR_BUFF_MAX_LEN];
-    float jitter_buff[RADAR_BUFF_MAX_LEN];
-    uint32_t buff_count;
+    radar_window_t wander_win;
+    radar_window_t jitter_win;
     float wander_threshold;
     float jitter_threshold;
     float wander_sensitivity;
     float jitter_sensitivity;
     bool room_status;      /* Someone present */
     bool human_status;     /* Someone moving */
-    bool calibrating;
+    bool calibrating;      /* Manual run, the LED blinks */
+    bool background;       /* Empty-room run started by the master */
 } detection_state_t;
 
+static float g_wander_win_storage[RADAR_WINDOW_STORAGE_LEN(RADAR_WINDOW_MAX_LEN)];
+static float g_jitter_win_storage[RADAR_WINDOW_STORAGE_LEN(RADAR_WINDOW_MAX_LEN)];
+
 static detection_state_t g_detect = {
-    .buff_count = 0,
     .wander_threshold = 0.01f,    /* Non-zero default to avoid always-detect bug */
     .jitter_threshold = 0.001f,   /* Non-zero default */
     .wander_sensitivity = 0.15f,
@@ -86,6 +144,31 @@ static detection_state_t g_detect = {
     .calibrating = false,
 };
 
+/* Detection tuning, the same layout as on the master */
+typedef struct __attribute__((packed)) {
+    uint16_t csi_interval_ms;   /* CSI decimation, csi_recv_interval of esp-radar */
+    uint16_t window_len;        /* Wander and jitter smoothing windows, up to RADAR_WINDOW_MAX_LEN */
+    uint8_t vote_len;           /* Recent jitter samples that vote on motion */
+    uint8_t move_votes;         /* Outliers among them that mark motion */
+} detect_config_t;
+
+#define DETECT_CONFIG_DEFAULT() { \
+    .csi_interval_ms = DETECT_DEFAULT_CSI_INTERVAL_MS, \
+    .window_len = RADAR_WINDOW_DEFAULT_LEN, \
+    .vote_len = DETECT_DEFAULT_VOTE_LEN, \
+    .move_votes = DETECT_DEFAULT_MOVE_VOTES, \
+}
+
+/*
+ * Written by the ESP-NOW callback, the radar callback takes over the windows
+ * and votes, the main task the CSI decimation. Every change bumps the
+ * generation.
+ */
+static detect_config_t g_detect_config = DETECT_CONFIG_DEFAULT();
+static uint32_t g_detect_config_gen = 0;
+static portMUX_TYPE g_detect_config_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t g_main_task = NULL;
+
 /* ESP-NOW message structure for sending to master */
 typedef struct __attribute__((packed)) {
     uint8_t msg_type;      /* 0x01 = detection result */
@@ -96,8 +179,104 @@ typedef struct __attribute__((packed)) {
     float jitter;          /* Raw jitter value */
     int8_t rssi;           /* Signal strength */
     uint32_t timestamp;    /* Local timestamp */
+    uint32_t sync_seq;     /* Newest sender packet heard, the master pairs it with its own arrival time */
+    uint32_t sync_time_us; /* Local arrival time of that packet, low 32 bits of esp_timer, 0 if none yet */
+    uint32_t time_us;      /* Local time of the report, low 32 bits of esp_timer */
 } slave_report_t;
 
+#define SLAVE_MSG_REPORT        0x01    /* slave_report_t */
+#define SLAVE_MSG_REPORT_BATCH  0x02    /* slave_report_t, uint8_t sample count, slave_sample_t[] */
+#define SLAVE_MSG_POWER         0x03    /* slave_power_t */
+#define SLAVE_MSG_CONFIG        0x04    /* slave_config_t */
+
+/* One sample of a batched report, oldest first */
+typedef struct __attribute__((packed)) {
+    uint16_t age_ms;       /* Taken this long before the report timestamp */
+    uint8_t status;        /* bit0 room, bit1 moving */
+    float wander;
+    float jitter;
+} slave_sample_t;
+
+/* Power state, sent on every mode change and at the end of each burst */
+typedef struct __attribute__((packed)) {
+    uint8_t msg_type;      /* SLAVE_MSG_POWER */
+    uint8_t node_id;
+    uint8_t mode;          /* POWER_MODE_* */
+    uint16_t duty_permille; /* Radio-on share since the previous power report */
+    uint32_t bursts;       /* Bursts since boot */
+} slave_power_t;
+
+/* Detection tuning in effect, sent at boot, after every DETECT_CMD and every CONFIG_DETECT_REPORT_MS */
+typedef struct __attribute__((packed)) {
+    uint8_t msg_type;      /* SLAVE_MSG_CONFIG */
+    uint8_t node_id;
+    detect_config_t config;
+} slave_config_t;
+
+#define UPLINK_BATCH_MAX_SAMPLES    16
+
+_Static_assert(CONFIG_UPLINK_BATCH_SAMPLES <= UPLINK_BATCH_MAX_SAMPLES,
+               "CONFIG_UPLINK_BATCH_SAMPLES too large for one ESP-NOW frame");
+_Static_assert(sizeof(slave_report_t) + 1 + UPLINK_BATCH_MAX_SAMPLES * sizeof(slave_sample_t) <= ESP_NOW_MAX_DATA_LEN,
+               "Batched report does not fit one ESP-NOW frame");
+
+typedef struct {
+    uint32_t timestamp;
+    uint8_t status;
+    float wander;
+    float jitter;
+} uplink_sample_t;
+
+/* Uplink state, only used from the radar callback */
+typedef struct {
+    bool reported;             /* At least one report was sent */
+    bool room_status;          /* Values of the last report */
+    bool human_status;
+    float wander;
+    float jitter;
+    uint32_t last_report;
+#if CONFIG_UPLINK_BATCH_SAMPLES > 0
+    uint32_t last_sample;
+    uplink_sample_t samples[CONFIG_UPLINK_BATCH_SAMPLES];
+    uint8_t sample_head;       /* Next slot to write */
+    uint8_t sample_count;      /* Samples taken since the last report */
+#endif
+    uint32_t report_count;
+    uint32_t skip_count;       /* Radar callbacks that did not need a report */
+} uplink_state_t;
+
+static uplink_state_t g_uplink = {0};
+
+/* Newest sender packet, written by the ESP-NOW callback, read by the radar callback and power_task() */
+static struct {
+    uint32_t seq;
+    uint32_t time_us;
+} g_sync_beacon;
+static portMUX_TYPE g_sync_beacon_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Samples of the running calibration, fed by the radar callback and read by the ESP-NOW callback */
+static online_calib_t g_calib;
+static portMUX_TYPE g_calib_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Home channel and a switch the master scheduled, run by channel_task() */
+static uint8_t g_channel = CONFIG_WIFI_CHANNEL;
+static struct {
+    uint8_t channel;                    /* 0 if none */
+    uint32_t time;                      /* esp_log_timestamp() to switch at */
+} g_channel_switch;
+static portMUX_TYPE g_channel_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t g_sender_heard = 0;     /* Last sender packet, esp_log_timestamp() */
+static TaskHandle_t g_channel_task = NULL;
+
+/* Duty cycle asked for by the master or the radar callback, run by power_task() */
+static struct {
+    uint8_t mode;
+    uint16_t cycle_slots;
+    uint16_t burst_slots;
+} g_power_request;
+static portMUX_TYPE g_power_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t g_power_task = NULL;
+
 /* Node ID: Change this before flashing each slave!
  * RX2 (first slave)  -> node_id = 1
  * RX3 (second slave) -> node_id = 2
@@ -111,130 +290,113 @@ static uint8_t g_node_id = CONFIG_SLAVE_NODE_ID;
 #define ESP_IF_WIFI_STA ESP_MAC_WIFI_STA
 #endif
 
+/* NVS Storage - persist calibration and sensitivity across power cycles */
+#define NVS_NAMESPACE "presence"
+#define SETTINGS_VERSION                2
+#define CONFIG_SETTINGS_DEBOUNCE_MS     2000  /* Quiet time before a change is written */
+#define CONFIG_SETTINGS_MAX_DELAY_MS    10000
+
+/* Layout of the settings blob, bump SETTINGS_VERSION on any change and convert the old layout in settings_migrate() */
+typedef struct {
+    float wander_threshold;
+    float jitter_threshold;
+    float wander_sensitivity;
+    float jitter_sensitivity;
+    detect_config_t detect;     /* Added in layout 2 */
+} slave_settings_t;
+
+static bool detect_config_valid(const detect_config_t *config)
+{
+    return config->csi_interval_ms >= 1 && config->csi_interval_ms <= DETECT_CSI_INTERVAL_MAX_MS
+           && config->window_len >= 1 && config->window_len <= RADAR_WINDOW_MAX_LEN
+           && config->vote_len >= 1 && config->vote_len <= config->window_len
+           && config->move_votes >= 1 && config->move_votes <= config->vote_len;
+}
+
+static bool settings_get_legacy_float(nvs_handle_t handle, const char *key, float *value)
+{
+    size_t len = sizeof(float);
+    return nvs_get_blob(handle, key, value, &len) == ESP_OK && len == sizeof(float);
+}
+
 /**
- * @brief Calculate trimmed mean (remove outliers)
+ * @brief Take over the separate keys of the previous firmware, which are left in place
  */
-static float trimmean(const float *array, size_t len, float percent)
+static bool settings_migrate(nvs_handle_t handle, uint16_t version, const void *blob, size_t len, void *out)
 {
-    if (len == 0) return 0.0f;
-    
-    /* Simple implementation: sort and trim edges */
-    float *sorted = malloc(len * sizeof(float));
-    if (!sorted) return 0.0f;
-    
-    memcpy(sorted, array, len * sizeof(float));
-    
-    /* Bubble sort (small array, acceptable) */
-    for (size_t i = 0; i < len - 1; i++) {
-        for (size_t j = 0; j < len - i - 1; j++) {
-            if (sorted[j] > sorted[j + 1]) {
-                float temp = sorted[j];
-                sorted[j] = sorted[j + 1];
-                sorted[j + 1] = temp;
-            }
-        }
+    slave_settings_t *settings = out;
+    bool found = false;
+
+    /* Layout 1 had everything up to the detection tuning */
+    if (version == 1 && len == offsetof(slave_settings_t, detect)) {
+        memcpy(settings, blob, len);
+        return true;
     }
-    
-    size_t trim = (size_t)(len * percent / 2);
-    float sum = 0;
-    size_t count = 0;
-    
-    for (size_t i = trim; i < len - trim; i++) {
-        sum += sorted[i];
-        count++;
+
+    if (version != SETTINGS_STORE_VERSION_LEGACY) {
+        ESP_LOGW(TAG, "Unknown settings layout %u, using defaults", version);
+        return false;
     }
-    
-    free(sorted);
-    return count > 0 ? sum / count : 0.0f;
+
+    found |= settings_get_legacy_float(handle, "wander_th", &settings->wander_threshold);
+    found |= settings_get_legacy_float(handle, "jitter_th", &settings->jitter_threshold);
+    found |= settings_get_legacy_float(handle, "wander_sens", &settings->wander_sensitivity);
+    found |= settings_get_legacy_float(handle, "jitter_sens", &settings->jitter_sensitivity);
+
+    return found;
 }
 
 /**
- * @brief Calculate median
+ * @brief Schedule a write of the thresholds, sensitivity and detection tuning, safe from the ESP-NOW callback
  */
-static float median(const float *array, size_t len)
+static void settings_save(void)
 {
-    if (len == 0) return 0.0f;
-    
-    float *sorted = malloc(len * sizeof(float));
-    if (!sorted) return 0.0f;
-    
-    memcpy(sorted, array, len * sizeof(float));
-    
-    /* Bubble sort */
-    for (size_t i = 0; i < len - 1; i++) {
-        for (size_t j = 0; j < len - i - 1; j++) {
-            if (sorted[j] > sorted[j + 1]) {
-                float temp = sorted[j];
-                sorted[j] = sorted[j + 1];
-                sorted[j + 1] = temp;
-            }
-        }
-    }
-    
-    float result;
-    if (len % 2 == 0) {
-        result = (sorted[len / 2 - 1] + sorted[len / 2]) / 2.0f;
-    } else {
-        result = sorted[len / 2];
-    }
-    
-    free(sorted);
-    return result;
-}
+    slave_settings_t settings = {
+        .wander_threshold = g_detect.wander_threshold,
+        .jitter_threshold = g_detect.jitter_threshold,
+        .wander_sensitivity = g_detect.wander_sensitivity,
+        .jitter_sensitivity = g_detect.jitter_sensitivity,
+    };
 
-/* NVS Storage - persist calibration and sensitivity across power cycles */
-#define NVS_NAMESPACE "presence"
+    portENTER_CRITICAL(&g_detect_config_lock);
+    settings.detect = g_detect_config;
+    portEXIT_CRITICAL(&g_detect_config_lock);
 
-static void nvs_save_settings(void)
-{
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
-        return;
-    }
-    
-    /* Save thresholds */
-    nvs_set_blob(handle, "wander_th", &g_detect.wander_threshold, sizeof(float));
-    nvs_set_blob(handle, "jitter_th", &g_detect.jitter_threshold, sizeof(float));
-    
-    /* Save sensitivity */
-    nvs_set_blob(handle, "wander_sens", &g_detect.wander_sensitivity, sizeof(float));
-    nvs_set_blob(handle, "jitter_sens", &g_detect.jitter_sensitivity, sizeof(float));
-    
-    nvs_commit(handle);
-    nvs_close(handle);
-    
-    ESP_LOGI(TAG, "Settings saved to NVS");
+    settings_store_save(&settings);
 }
 
-static void nvs_load_settings(void)
+static void settings_load(void)
 {
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "No saved settings found, using defaults");
-        return;
+    slave_settings_t settings = {
+        .wander_threshold = g_detect.wander_threshold,
+        .jitter_threshold = g_detect.jitter_threshold,
+        .wander_sensitivity = g_detect.wander_sensitivity,
+        .jitter_sensitivity = g_detect.jitter_sensitivity,
+        .detect = g_detect_config,
+    };
+
+    settings_store_config_t config = SETTINGS_STORE_CONFIG_DEFAULT();
+    config.nvs_namespace = NVS_NAMESPACE;
+    config.version = SETTINGS_VERSION;
+    config.size = sizeof(slave_settings_t);
+    config.debounce_ms = CONFIG_SETTINGS_DEBOUNCE_MS;
+    config.max_delay_ms = CONFIG_SETTINGS_MAX_DELAY_MS;
+    config.migrate = settings_migrate;
+    ESP_ERROR_CHECK(settings_store_init(&config, &settings));
+
+    g_detect.wander_threshold = settings.wander_threshold;
+    g_detect.jitter_threshold = settings.jitter_threshold;
+    g_detect.wander_sensitivity = settings.wander_sensitivity;
+    g_detect.jitter_sensitivity = settings.jitter_sensitivity;
+    if (detect_config_valid(&settings.detect)) {
+        g_detect_config = settings.detect;
     }
-    
-    size_t len = sizeof(float);
-    
-    /* Load thresholds */
-    nvs_get_blob(handle, "wander_th", &g_detect.wander_threshold, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "jitter_th", &g_detect.jitter_threshold, &len);
-    
-    /* Load sensitivity */
-    len = sizeof(float);
-    nvs_get_blob(handle, "wander_sens", &g_detect.wander_sensitivity, &len);
-    len = sizeof(float);
-    nvs_get_blob(handle, "jitter_sens", &g_detect.jitter_sensitivity, &len);
-    
-    nvs_close(handle);
-    
+
     ESP_LOGI(TAG, "Settings loaded: wander_th=%.6f, jitter_th=%.6f, w_sens=%.2f, j_sens=%.2f",
              g_detect.wander_threshold, g_detect.jitter_threshold,
              g_detect.wander_sensitivity, g_detect.jitter_sensitivity);
+    ESP_LOGI(TAG, "Detection: CSI every %u ms, window %u, %u of %u votes", g_detect_config.csi_interval_ms,
+             g_detect_config.window_len, g_detect_config.move_votes, g_detect_config.vote_len);
 }
 
 /**
@@ -294,94 +456,469 @@ static void led_update_status(bool room_status, bool human_status, bool calibrat
 }
 
 /**
- * @brief Send detection result to master
+ * @brief Send detection result to master, with the pending batch samples if batching is enabled
  */
 static void send_result_to_master(float wander, float jitter, int8_t rssi)
 {
-    slave_report_t report = {
-        .msg_type = 0x01,
+    uint8_t buf[sizeof(slave_report_t) + 1 + UPLINK_BATCH_MAX_SAMPLES * sizeof(slave_sample_t)];
+    slave_report_t *report = (slave_report_t *)buf;
+    size_t len = sizeof(slave_report_t);
+    uint32_t now = esp_log_timestamp();
+
+    portENTER_CRITICAL(&g_sync_beacon_lock);
+    uint32_t sync_seq = g_sync_beacon.seq;
+    uint32_t sync_time_us = g_sync_beacon.time_us;
+    portEXIT_CRITICAL(&g_sync_beacon_lock);
+
+    *report = (slave_report_t) {
+        .msg_type = SLAVE_MSG_REPORT,
         .node_id = g_node_id,
         .room_status = g_detect.room_status ? 1 : 0,
         .human_status = g_detect.human_status ? 1 : 0,
         .wander = wander,
         .jitter = jitter,
         .rssi = rssi,
-        .timestamp = esp_log_timestamp(),
+        .timestamp = now,
+        .sync_seq = sync_seq,
+        .sync_time_us = sync_time_us,
+        .time_us = (uint32_t)esp_timer_get_time(),
     };
-    
-    esp_err_t ret = esp_now_send(g_master_mac, (uint8_t *)&report, sizeof(report));
+
+#if CONFIG_UPLINK_BATCH_SAMPLES > 0
+    if (g_uplink.sample_count) {
+        slave_sample_t *out = (slave_sample_t *)(buf + len + 1);
+        uint8_t first = (g_uplink.sample_head + CONFIG_UPLINK_BATCH_SAMPLES - g_uplink.sample_count)
+                        % CONFIG_UPLINK_BATCH_SAMPLES;
+
+        for (uint8_t i = 0; i < g_uplink.sample_count; i++) {
+            const uplink_sample_t *sample = &g_uplink.samples[(first + i) % CONFIG_UPLINK_BATCH_SAMPLES];
+            out[i].age_ms = MIN(now - sample->timestamp, UINT16_MAX);
+            out[i].status = sample->status;
+            out[i].wander = sample->wander;
+            out[i].jitter = sample->jitter;
+        }
+
+        report->msg_type = SLAVE_MSG_REPORT_BATCH;
+        buf[len] = g_uplink.sample_count;
+        len += 1 + g_uplink.sample_count * sizeof(slave_sample_t);
+        g_uplink.sample_count = 0;
+    }
+#endif
+
+    esp_err_t ret = espnow_rate_send(__atomic_load_n(&g_report_mac, __ATOMIC_ACQUIRE), ESPNOW_RATE_CLASS_REPORT, buf, len);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to send report to master: %s", esp_err_to_name(ret));
     }
 }
 
+#if CONFIG_UPLINK_MODE == UPLINK_MODE_ON_CHANGE
 /**
- * @brief WiFi radar callback - called when radar data is available
+ * @brief Whether a value moved far enough from the last reported one
+ *
+ * The change is relative to the larger of the reported value and the level at
+ * which detection triggers (threshold / sensitivity), so small values near zero
+ * do not report on every bit of noise.
  */
-static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
+static bool uplink_value_changed(float value, float reported, float threshold, float sensitivity)
 {
-    static uint32_t s_last_send_time = 0;
-    uint32_t buff_max_size = 5;
-    uint32_t buff_outliers_num = 2;
-    
-    /* Store in circular buffer */
-    g_detect.wander_buff[g_detect.buff_count % RADAR_BUFF_MAX_LEN] = info->waveform_wander;
-    g_detect.jitter_buff[g_detect.buff_count % RADAR_BUFF_MAX_LEN] = info->waveform_jitter;
-    g_detect.buff_count++;
-    
-    if (g_detect.buff_count < buff_max_size) {
+    float scale = fabsf(reported);
+
+    if (sensitivity > 0) {
+        scale = MAX(scale, threshold / sensitivity);
+    }
+
+    return fabsf(value - reported) > scale * CONFIG_UPLINK_CHANGE_RATIO;
+}
+#endif
+
+/**
+ * @brief Decide whether this radar result goes to the master
+ *
+ * Periodic mode reports every CONFIG_UPLINK_PERIOD_MS. On-change mode reports
+ * room/motion transitions at once, significant wander/jitter changes at most
+ * every CONFIG_UPLINK_MIN_GAP_MS, and otherwise a heartbeat every
+ * CONFIG_UPLINK_HEARTBEAT_MS, leaving the airtime to the CSI packets.
+ */
+static void uplink_update(float wander, float jitter, int8_t rssi)
+{
+    uint32_t now = esp_log_timestamp();
+    uint32_t since = now - g_uplink.last_report;
+
+#if CONFIG_UPLINK_BATCH_SAMPLES > 0
+    if (now - g_uplink.last_sample >= CONFIG_UPLINK_PERIOD_MS) {
+        uplink_sample_t *sample = &g_uplink.samples[g_uplink.sample_head];
+        sample->timestamp = now;
+        sample->status = (g_detect.room_status ? BIT0 : 0) | (g_detect.human_status ? BIT1 : 0);
+        sample->wander = wander;
+        sample->jitter = jitter;
+        g_uplink.sample_head = (g_uplink.sample_head + 1) % CONFIG_UPLINK_BATCH_SAMPLES;
+        g_uplink.sample_count = MIN(g_uplink.sample_count + 1, CONFIG_UPLINK_BATCH_SAMPLES);
+        g_uplink.last_sample = now;
+    }
+#endif
+
+#if CONFIG_UPLINK_MODE == UPLINK_MODE_ON_CHANGE
+    bool transition = !g_uplink.reported
+                      || g_detect.room_status != g_uplink.room_status
+                      || g_detect.human_status != g_uplink.human_status;
+    bool changed = uplink_value_changed(wander, g_uplink.wander, g_detect.wander_threshold, g_detect.wander_sensitivity)
+                   || uplink_value_changed(jitter, g_uplink.jitter, g_detect.jitter_threshold, g_detect.jitter_sensitivity);
+    bool due = transition
+               || (changed && since >= CONFIG_UPLINK_MIN_GAP_MS)
+               || since >= CONFIG_UPLINK_HEARTBEAT_MS;
+#else
+    bool due = since >= CONFIG_UPLINK_PERIOD_MS;
+#endif
+
+    if (!due) {
+        g_uplink.skip_count++;
         return;
     }
-    
-    /* Calculate smoothed values */
-    float wander_average = trimmean(g_detect.wander_buff, RADAR_BUFF_MAX_LEN, 0.5f);
-    float jitter_median = median(g_detect.jitter_buff, RADAR_BUFF_MAX_LEN);
-    
-    /* Count detections in window */
-    uint32_t someone_count = 0;
-    uint32_t move_count = 0;
-    
-    /* Only detect if threshold is positive (calibrated) */
-    bool has_valid_threshold = (g_detect.wander_threshold > 0.0001f);
-    
-    for (uint32_t i = 0; i < buff_max_size; i++) {
-        if (has_valid_threshold && 
-            wander_average * g_detect.wander_sensitivity > g_detect.wander_threshold) {
-            someone_count++;
+
+    send_result_to_master(wander, jitter, rssi);
+
+    g_uplink.reported = true;
+    g_uplink.room_status = g_detect.room_status;
+    g_uplink.human_status = g_detect.human_status;
+    g_uplink.wander = wander;
+    g_uplink.jitter = jitter;
+    g_uplink.last_report = now;
+    g_uplink.report_count++;
+
+    ESP_LOGI(TAG, "Room: %d, Moving: %d, Wander: %.6f, Jitter: %.6f",
+             g_detect.room_status, g_detect.human_status, wander, jitter);
+}
+
+/**
+ * @brief Ask power_task() for a mode, any task or callback
+ */
+static void power_request(uint8_t mode, uint16_t cycle_slots, uint16_t burst_slots)
+{
+#if !POWER_DUTY_SUPPORTED
+    mode = POWER_MODE_CONTINUOUS;
+#endif
+
+    if (mode == POWER_MODE_DUTY && (!cycle_slots || !burst_slots || burst_slots >= cycle_slots)) {
+        mode = POWER_MODE_CONTINUOUS;
+    }
+
+    portENTER_CRITICAL(&g_power_lock);
+    g_power_request.mode = mode;
+    g_power_request.cycle_slots = cycle_slots;
+    g_power_request.burst_slots = burst_slots;
+    portEXIT_CRITICAL(&g_power_lock);
+
+    if (g_power_task) {
+        xTaskNotifyGive(g_power_task);
+    }
+}
+
+/* Radio-on accounting of power_task() */
+typedef struct {
+    bool awake;
+    int64_t awake_since_us;
+    int64_t awake_us;          /* Radio-on time since window_start_us, without the current stretch */
+    int64_t window_start_us;
+    uint32_t bursts;
+} power_state_t;
+
+static void power_radio_set(power_state_t *power, bool on)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (on == power->awake) {
+        return;
+    }
+
+    /* Without a connection WIFI_PS_MIN_MODEM keeps the radio off outside the ESP-NOW wake window */
+    esp_wifi_set_ps(on ? WIFI_PS_NONE : WIFI_PS_MIN_MODEM);
+
+    if (on) {
+        power->awake_since_us = now;
+    } else {
+        power->awake_us += now - power->awake_since_us;
+    }
+    power->awake = on;
+}
+
+/**
+ * @brief Send the mode and the radio-on share since the previous power report
+ */
+static void power_report(power_state_t *power, uint8_t mode)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t awake_us = power->awake_us + (power->awake ? now - power->awake_since_us : 0);
+    int64_t elapsed_us = now - power->window_start_us;
+
+    slave_power_t msg = {
+        .msg_type = SLAVE_MSG_POWER,
+        .node_id = g_node_id,
+        .mode = mode,
+        .duty_permille = elapsed_us > 0 ? MIN(awake_us * 1000 / elapsed_us, 1000) : 1000,
+        .bursts = power->bursts,
+    };
+
+    power->awake_us = 0;
+    power->awake_since_us = now;
+    power->window_start_us = now;
+
+    esp_err_t ret = espnow_rate_send(__atomic_load_n(&g_report_mac, __ATOMIC_ACQUIRE), ESPNOW_RATE_CLASS_REPORT, (const uint8_t *)&msg, sizeof(msg));
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to send power report to master: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief Keep the radio on for the sender's bursts only while duty-cycled
+ *
+ * The sender sends the first burst_slots of every cycle_slots slots, and
+ * each packet carries its slot. The newest packet heard, see g_sync_beacon,
+ * gives the slot now and so the time to the next burst. The radio goes on
+ * CONFIG_POWER_WAKE_GUARD_MS before it and off as long after its end, when
+ * the measured duty cycle goes to the master. Each burst also carries the
+ * master's commands and the uplink reports.
+ */
+static void power_task(void *arg)
+{
+    const int64_t slot_us = 1000 * 1000 / CONFIG_SEND_FREQUENCY;
+    const int64_t guard_us = CONFIG_POWER_WAKE_GUARD_MS * 1000;
+    power_state_t power = {
+        .awake = true,
+        .awake_since_us = esp_timer_get_time(),
+        .window_start_us = esp_timer_get_time(),
+    };
+    uint8_t mode = POWER_MODE_CONTINUOUS;
+    bool in_burst = false;
+
+    while (1) {
+        portENTER_CRITICAL(&g_power_lock);
+        uint8_t request = g_power_request.mode;
+        uint32_t cycle_slots = g_power_request.cycle_slots;
+        uint32_t burst_slots = g_power_request.burst_slots;
+        portEXIT_CRITICAL(&g_power_lock);
+
+        if (request != mode) {
+            mode = request;
+            in_burst = false;
+
+            if (mode == POWER_MODE_CONTINUOUS) {
+                power_radio_set(&power, true);
+            } else {
+#if POWER_DUTY_SUPPORTED
+                esp_wifi_connectionless_module_set_wake_interval(MIN(cycle_slots * slot_us / 1000, UINT16_MAX));
+                esp_now_set_wake_window(0);
+#endif
+            }
+
+            ESP_LOGI(TAG, "Power mode %s, %lu of %lu slots", mode == POWER_MODE_DUTY ? "duty" : "continuous",
+                     (unsigned long)burst_slots, (unsigned long)cycle_slots);
+            power_report(&power, mode);
         }
-        
-        uint32_t index = (g_detect.buff_count - 1 - i) % RADAR_BUFF_MAX_LEN;
-        if (g_detect.jitter_threshold > 0.0001f &&
-            (g_detect.jitter_buff[index] * g_detect.jitter_sensitivity > g_detect.jitter_threshold
-            || (g_detect.jitter_buff[index] * g_detect.jitter_sensitivity > jitter_median 
-                && g_detect.jitter_buff[index] > 0.0002f))) {
-            move_count++;
+
+        if (mode == POWER_MODE_CONTINUOUS) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
         }
+
+        portENTER_CRITICAL(&g_sync_beacon_lock);
+        uint32_t seq = g_sync_beacon.seq;
+        uint32_t beacon_us = g_sync_beacon.time_us;
+        portEXIT_CRITICAL(&g_sync_beacon_lock);
+
+        int64_t cycle_us = cycle_slots * slot_us;
+        uint32_t age_us = (uint32_t)esp_timer_get_time() - beacon_us;
+        int64_t wait_us = 0;
+
+        if (!beacon_us || age_us > CONFIG_POWER_RESYNC_CYCLES * cycle_us) {
+            /* Lost the sender's grid, listen for a whole cycle */
+            power_radio_set(&power, true);
+            wait_us = cycle_us;
+        } else {
+            uint32_t phase = (seq + age_us / slot_us) % cycle_slots;
+            int64_t slot_offset_us = age_us % slot_us;
+            int64_t next_burst_us = (cycle_slots - phase) * slot_us - slot_offset_us;
+
+            if (phase < burst_slots) {
+                if (!in_burst) {
+                    in_burst = true;
+                    power.bursts++;
+                }
+                power_radio_set(&power, true);
+                wait_us = (burst_slots - phase) * slot_us - slot_offset_us + guard_us;
+            } else if (next_burst_us > 2 * guard_us) {
+                if (in_burst) {
+                    in_burst = false;
+                    power_report(&power, mode);
+                }
+                power_radio_set(&power, false);
+                wait_us = next_burst_us - guard_us;
+            } else {
+                power_radio_set(&power, true);
+                wait_us = next_burst_us;
+            }
+        }
+
+        /* A new request cuts the wait short */
+        ulTaskNotifyTake(pdTRUE, MAX(pdMS_TO_TICKS(wait_us / 1000), 1));
     }
-    
+}
+
+static void channel_tune(uint8_t channel)
+{
+    esp_wifi_set_channel(channel, csi_wifi_second_chan(channel, WIFI_BW_HT40));
+}
+
+static void channel_set_home(uint8_t channel)
+{
+    nvs_handle_t nvs;
+
+    channel_tune(channel);
+    g_channel = channel;
+
+    if (nvs_open("config", NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_set_u8(nvs, "channel", channel);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+}
+
+/**
+ * @brief Run the switches of the master, and find the sender again if it is lost
+ *
+ * A slave that missed every copy of a switch command, or booted with an old
+ * channel, hears no sender packet anymore. After CONFIG_CHANNEL_LOST_MS it
+ * listens on every channel in turn and stays where the sender is heard,
+ * else it returns home and tries again later.
+ */
+static void channel_task(void *arg)
+{
+    uint32_t search_last = esp_log_timestamp();
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        uint32_t now = esp_log_timestamp();
+
+        portENTER_CRITICAL(&g_channel_lock);
+        uint8_t channel = g_channel_switch.channel;
+        int32_t wait_ms = g_channel_switch.time - now;
+        portEXIT_CRITICAL(&g_channel_lock);
+
+        if (channel) {
+            if (wait_ms > 0) {
+                vTaskDelay(pdMS_TO_TICKS(wait_ms));
+            }
+
+            ESP_LOGI(TAG, "Switching from channel %d to %d", g_channel, channel);
+            channel_set_home(channel);
+            search_last = esp_log_timestamp();
+
+            portENTER_CRITICAL(&g_channel_lock);
+            g_channel_switch.channel = 0;
+            portEXIT_CRITICAL(&g_channel_lock);
+            continue;
+        }
+
+        if (now - g_sender_heard < CONFIG_CHANNEL_LOST_MS || now - search_last < CONFIG_CHANNEL_LOST_MS) {
+            continue;
+        }
+
+        ESP_LOGW(TAG, "Sender not heard on channel %d for %lu s, searching", g_channel,
+                 (unsigned long)((now - g_sender_heard) / 1000));
+        uint8_t found = 0;
+
+        for (int i = 1; i <= CHANNEL_MAX && !found; i++) {
+            uint8_t candidate = (g_channel + i - 1) % CHANNEL_MAX + 1;
+            uint32_t tune_time = esp_log_timestamp();
+
+            channel_tune(candidate);
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_CHANNEL_SEARCH_DWELL_MS));
+            if ((int32_t)(g_sender_heard - tune_time) > 0) {
+                found = candidate;
+            }
+        }
+
+        if (found && found != g_channel) {
+            ESP_LOGI(TAG, "Sender found on channel %d", found);
+            channel_set_home(found);
+        } else {
+            channel_tune(g_channel);
+        }
+        search_last = esp_log_timestamp();
+    }
+}
+
+/**
+ * @brief WiFi radar callback - called when radar data is available
+ */
+static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
+{
+    static detect_config_t s_config;
+    static uint32_t s_config_gen = UINT32_MAX;
+
+    /* A new window length keeps the newest samples, nothing is reallocated */
+    if (s_config_gen != g_detect_config_gen) {
+        portENTER_CRITICAL(&g_detect_config_lock);
+        s_config = g_detect_config;
+        s_config_gen = g_detect_config_gen;
+        portEXIT_CRITICAL(&g_detect_config_lock);
+        radar_window_set_size(&g_detect.wander_win, s_config.window_len);
+        radar_window_set_size(&g_detect.jitter_win, s_config.window_len);
+    }
+
+    radar_detect_result_t result;
+    const radar_detect_config_t detect_config = {
+        .vote_len = s_config.vote_len,
+        .move_votes = s_config.move_votes,
+        .wander_threshold = g_detect.wander_threshold,
+        .wander_sensitivity = g_detect.wander_sensitivity,
+        .jitter_threshold = g_detect.jitter_threshold,
+        .jitter_sensitivity = g_detect.jitter_sensitivity,
+        .calibrated_only = true,
+    };
+
+    if (!radar_detect_update(&detect_config, &g_detect.wander_win, &g_detect.jitter_win,
+                             info->waveform_wander, info->waveform_jitter, &result)) {
+        return;
+    }
+
     /* Update status */
-    g_detect.room_status = has_valid_threshold && (someone_count >= 1);
-    g_detect.human_status = (g_detect.jitter_threshold > 0.0001f) && (move_count >= buff_outliers_num);
+    g_detect.room_status = result.room_status;
+    g_detect.human_status = result.human_status;
     
-    /* Skip processing during calibration */
-    if (g_detect.calibrating) {
-        led_update_status(false, false, true);
-        return;
+    /* Detection keeps the current thresholds while a calibration collects samples */
+    if (g_detect.calibrating || g_detect.background) {
+        portENTER_CRITICAL(&g_calib_lock);
+        online_calib_push(&g_calib, info->waveform_wander, info->waveform_jitter);
+        portEXIT_CRITICAL(&g_calib_lock);
+    }
+    
+    /* A detection within a burst ends the duty cycle at once, the master wakes the other nodes */
+    if (g_power_request.mode == POWER_MODE_DUTY && (g_detect.room_status || g_detect.human_status)) {
+        power_request(POWER_MODE_CONTINUOUS, 0, 0);
+        ESP_LOGI(TAG, "Detection during a burst, continuous mode");
     }
     
     /* Update LED */
-    led_update_status(g_detect.room_status, g_detect.human_status, false);
+    led_update_status(g_detect.room_status, g_detect.human_status, g_detect.calibrating);
     
-    /* Send to master at ~10Hz */
-    uint32_t now = esp_log_timestamp();
-    if (now - s_last_send_time >= 100) {
-        send_result_to_master(wander_average, jitter_median, 0);
-        s_last_send_time = now;
-        
-        ESP_LOGI(TAG, "Room: %d, Moving: %d, Wander: %.6f, Jitter: %.6f",
-                 g_detect.room_status, g_detect.human_status, wander_average, jitter_median);
-    }
+    /* Report to master, see uplink_update() */
+    uplink_update(result.wander_average, result.jitter_median, 0);
+}
+
+/**
+ * @brief ESP-NOW send callback, the acknowledgements of the reports steer their rate
+ */
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void espnow_send_cb(const esp_now_send_info_t *tx_info, esp_now_send_status_t status)
+{
+    espnow_rate_tx_done(tx_info->des_addr, status == ESP_NOW_SEND_SUCCESS);
+}
+#else
+static void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status)
+{
+    espnow_rate_tx_done(mac_addr, status == ESP_NOW_SEND_SUCCESS);
 }
+#endif
 
 /**
  * @brief ESP-NOW receive callback - handle commands from master
@@ -389,34 +926,78 @@ static void wifi_radar_cb(void *ctx, const wifi_radar_info_t *info)
 static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len)
 {
     if (len < 1) return;
-    
+
+    /* Packets of the CSI sender carry their sequence number, remember when it arrived for clock sync */
+    if (!memcmp(recv_info->src_addr, CONFIG_CSI_SEND_MAC, sizeof(CONFIG_CSI_SEND_MAC))) {
+        if (len >= (int)sizeof(uint32_t)) {
+            uint32_t time_us = (uint32_t)esp_timer_get_time();
+            uint32_t seq;
+
+            memcpy(&seq, data, sizeof(seq));
+            portENTER_CRITICAL(&g_sync_beacon_lock);
+            g_sync_beacon.seq = seq;
+            g_sync_beacon.time_us = time_us ? time_us : 1;
+            portEXIT_CRITICAL(&g_sync_beacon_lock);
+            g_sender_heard = esp_log_timestamp();
+        }
+        espnow_rate_account(ESPNOW_RATE_CLASS_SENSING, CONFIG_SEND_RATE, len, false);
+        return;
+    }
+
     /* Only process messages that start with our command prefix (0x10-0x1F reserved for commands) */
-    /* This filters out CSI data packets from the TX sender */
     uint8_t cmd = data[0];
     
     /* Skip if not a command (commands are 0x10-0x1F) */
     if (cmd < 0x10 || cmd > 0x1F) {
         return;  /* Silently ignore non-command packets (likely CSI data) */
     }
+
+    /* Only the master sends commands, see master_peer_update() */
+    if (!__atomic_load_n(&g_master_heard, __ATOMIC_ACQUIRE)) {
+        memcpy(g_master_heard_mac, recv_info->src_addr, sizeof(g_master_heard_mac));
+        __atomic_store_n(&g_master_heard, true, __ATOMIC_RELEASE);
+    }
+    espnow_rate_rx(recv_info->src_addr, recv_info->rx_ctrl->rssi);
     
     /* Log who sent this command */
     ESP_LOGI(TAG, "Received command 0x%02x from " MACSTR, cmd, MAC2STR(recv_info->src_addr));
     
     switch (cmd) {
-        case 0x10:  /* Start calibration */
-            ESP_LOGI(TAG, "Starting calibration...");
-            g_detect.calibrating = true;
-            esp_radar_train_start();
+        case 0x10: {  /* Start calibration - format: [cmd][flags], bit0 background */
+            bool background = len >= 2 && (data[1] & BIT0);
+            ESP_LOGI(TAG, "Starting %s calibration...", background ? "background" : "manual");
+            portENTER_CRITICAL(&g_calib_lock);
+            online_calib_init(&g_calib, NULL);
+            portEXIT_CRITICAL(&g_calib_lock);
+            g_detect.calibrating = !background;
+            g_detect.background = background;
             break;
+        }
             
-        case 0x11:  /* Stop calibration */
-            ESP_LOGI(TAG, "Stopping calibration...");
-            esp_radar_train_stop(&g_detect.wander_threshold, &g_detect.jitter_threshold);
+        case 0x11: {  /* Stop calibration - format: [cmd][weight], share of the run out of 255 */
+            float weight = len >= 2 ? data[1] / 255.0f : 1.0f;
+            online_calib_result_t result;
+
+            portENTER_CRITICAL(&g_calib_lock);
+            bool ready = (g_detect.calibrating || g_detect.background) && online_calib_ready(&g_calib);
+            online_calib_get(&g_calib, &result);
             g_detect.calibrating = false;
-            ESP_LOGI(TAG, "Calibration complete: wander_th=%.6f, jitter_th=%.6f",
-                     g_detect.wander_threshold, g_detect.jitter_threshold);
-            nvs_save_settings();  /* Save to NVS */
+            g_detect.background = false;
+            portEXIT_CRITICAL(&g_calib_lock);
+
+            if (!ready) {
+                ESP_LOGW(TAG, "Calibration stopped after %lu samples, thresholds kept", (unsigned long)result.samples);
+                break;
+            }
+
+            g_detect.wander_threshold = online_calib_blend(g_detect.wander_threshold, result.wander_threshold, weight);
+            g_detect.jitter_threshold = online_calib_blend(g_detect.jitter_threshold, result.jitter_threshold, weight);
+            ESP_LOGI(TAG, "Calibration complete: wander_th=%.6f, jitter_th=%.6f, %lu samples, confidence %.2f",
+                     g_detect.wander_threshold, g_detect.jitter_threshold,
+                     (unsigned long)result.samples, result.confidence);
+            settings_save();
             break;
+        }
             
         case 0x12:  /* Set thresholds */
             if (len >= 9) {
@@ -435,7 +1016,7 @@ static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *
                     memcpy(&g_detect.jitter_sensitivity, data + 6, 4);
                     ESP_LOGI(TAG, "Sensitivity updated: wander=%.3f, jitter=%.3f",
                              g_detect.wander_sensitivity, g_detect.jitter_sensitivity);
-                    nvs_save_settings();  /* Save to NVS */
+                    settings_save();
                 } else {
                     ESP_LOGD(TAG, "Sensitivity command for node %d, I am node %d, ignoring",
                              target_node, g_node_id);
@@ -443,6 +1024,70 @@ static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *
             }
             break;
             
+        case 0x14:  /* Abort calibration, the room was occupied during a background run */
+            ESP_LOGI(TAG, "Calibration dropped, thresholds kept");
+            g_detect.calibrating = false;
+            g_detect.background = false;
+            break;
+
+        case POWER_CMD: {  /* Duty cycle - format: [cmd][mode][cycle_slots u16][burst_slots u16] */
+            uint16_t cycle_slots = 0;
+            uint16_t burst_slots = 0;
+
+            if (len >= 6) {
+                memcpy(&cycle_slots, data + 2, sizeof(cycle_slots));
+                memcpy(&burst_slots, data + 4, sizeof(burst_slots));
+            }
+
+            power_request(len >= 6 ? data[1] : POWER_MODE_CONTINUOUS, cycle_slots, burst_slots);
+            break;
+        }
+
+        case DETECT_CMD: {  /* Detection tuning - format: [cmd][detect_config_t] */
+            detect_config_t config;
+
+            if (len < 1 + (int)sizeof(config)) {
+                break;
+            }
+
+            memcpy(&config, data + 1, sizeof(config));
+            if (!detect_config_valid(&config)) {
+                ESP_LOGW(TAG, "Invalid detection tuning ignored");
+                break;
+            }
+
+            portENTER_CRITICAL(&g_detect_config_lock);
+            g_detect_config = config;
+            g_detect_config_gen++;
+            portEXIT_CRITICAL(&g_detect_config_lock);
+            settings_save();
+            if (g_main_task) {
+                xTaskNotifyGive(g_main_task);
+            }
+            break;
+        }
+
+        case CHANNEL_CMD_SWITCH: {  /* Move to a channel - format: [cmd][channel][delay_ms u16] */
+            uint16_t delay_ms;
+
+            if (len < 4 || data[1] < 1 || data[1] > CHANNEL_MAX) {
+                break;
+            }
+
+            /* The master repeats it with the time left, the first copy counts */
+            memcpy(&delay_ms, data + 2, sizeof(delay_ms));
+            portENTER_CRITICAL(&g_channel_lock);
+            if (!g_channel_switch.channel) {
+                g_channel_switch.channel = data[1];
+                g_channel_switch.time = esp_log_timestamp() + delay_ms;
+            }
+            portEXIT_CRITICAL(&g_channel_lock);
+            if (g_channel_task) {
+                xTaskNotifyGive(g_channel_task);
+            }
+            break;
+        }
+            
         default:
             ESP_LOGD(TAG, "Unknown command in valid range: 0x%02x", cmd);
             break;
@@ -456,12 +1101,12 @@ static void wifi_radar_init(void)
 {
     /* WiFi configuration */
     esp_radar_wifi_config_t wifi_config = ESP_RADAR_WIFI_CONFIG_DEFAULT();
-    wifi_config.channel = CONFIG_WIFI_CHANNEL;
+    wifi_config.channel = g_channel;
     
     /* CSI configuration */
     esp_radar_csi_config_t csi_config = ESP_RADAR_CSI_CONFIG_DEFAULT();
     memcpy(csi_config.filter_mac, CONFIG_CSI_SEND_MAC, 6);
-    csi_config.csi_recv_interval = 10;  /* 100Hz */
+    csi_config.csi_recv_interval = g_detect_config.csi_interval_ms;
     
     /* ESP-NOW configuration */
     esp_radar_espnow_config_t espnow_config = ESP_RADAR_ESPNOW_CONFIG_DEFAULT();
@@ -471,6 +1116,10 @@ static void wifi_radar_init(void)
     dec_config.wifi_radar_cb = wifi_radar_cb;
     dec_config.wifi_radar_cb_ctx = NULL;
     
+    /* Smoothing windows must be ready before the first radar callback */
+    ESP_ERROR_CHECK(radar_window_init(&g_detect.wander_win, g_wander_win_storage, RADAR_WINDOW_MAX_LEN, g_detect_config.window_len));
+    ESP_ERROR_CHECK(radar_window_init(&g_detect.jitter_win, g_jitter_win_storage, RADAR_WINDOW_MAX_LEN, g_detect_config.window_len));
+    
     /* Initialize radar subsystems */
     ESP_ERROR_CHECK(esp_radar_wifi_init(&wifi_config));
     ESP_ERROR_CHECK(esp_radar_csi_init(&csi_config));
@@ -479,7 +1128,7 @@ static void wifi_radar_init(void)
     
     /* Add master as ESP-NOW peer for sending reports */
     esp_now_peer_info_t peer = {
-        .channel = CONFIG_WIFI_CHANNEL,
+        .channel = 0,   /* Current channel, follows channel_task() */
         .ifidx = WIFI_IF_STA,
         .encrypt = false,
     };
@@ -489,9 +1138,72 @@ static void wifi_radar_init(void)
     if (ret != ESP_OK && ret != ESP_ERR_ESPNOW_EXIST) {
         ESP_LOGE(TAG, "Failed to add master peer: %s", esp_err_to_name(ret));
     }
+
+    /* Reports take the rate the link to the master allows, the sender's packets keep theirs */
+    espnow_rate_config_t rate_config = ESPNOW_RATE_CONFIG_DEFAULT();
+    rate_config.sensing_phymode = CONFIG_SEND_PHYMODE;
+    rate_config.sensing_rate = CONFIG_SEND_RATE;
+    ESP_ERROR_CHECK(espnow_rate_init(&rate_config));
     
-    /* Register receive callback */
+    /* Register receive and send callbacks */
     esp_now_register_recv_cb(espnow_recv_cb);
+    esp_now_register_send_cb(espnow_send_cb);
+}
+
+/**
+ * @brief Main task: make the master heard in a command a peer and send the reports to it
+ */
+static void master_peer_update(void)
+{
+    if (g_report_mac != g_master_mac || !__atomic_load_n(&g_master_heard, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    esp_now_peer_info_t peer = {
+        .channel = 0,   /* Current channel, follows channel_task() */
+        .ifidx = WIFI_IF_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, g_master_heard_mac, sizeof(peer.peer_addr));
+
+    esp_err_t ret = esp_now_add_peer(&peer);
+    if (ret != ESP_OK && ret != ESP_ERR_ESPNOW_EXIST) {
+        ESP_LOGW(TAG, "Failed to add master " MACSTR ": %s", MAC2STR(g_master_heard_mac), esp_err_to_name(ret));
+        return;
+    }
+
+    __atomic_store_n(&g_report_mac, g_master_heard_mac, __ATOMIC_RELEASE);
+    ESP_LOGI(TAG, "Reports go to master " MACSTR, MAC2STR(g_master_heard_mac));
+}
+
+/**
+ * @brief Main task: take over the CSI decimation of a new tuning and tell the master what is in effect
+ *
+ * @param csi_interval_ms Decimation in effect, updated
+ */
+static void detect_config_apply(uint16_t *csi_interval_ms)
+{
+    portENTER_CRITICAL(&g_detect_config_lock);
+    slave_config_t msg = {
+        .msg_type = SLAVE_MSG_CONFIG,
+        .node_id = g_node_id,
+        .config = g_detect_config,
+    };
+    portEXIT_CRITICAL(&g_detect_config_lock);
+
+    if (msg.config.csi_interval_ms != *csi_interval_ms) {
+        esp_radar_config_t radar_config = {0};
+        esp_radar_get_config(&radar_config);
+        radar_config.csi_config.csi_recv_interval = msg.config.csi_interval_ms;
+        esp_radar_change_config(&radar_config);
+        *csi_interval_ms = msg.config.csi_interval_ms;
+    }
+
+    ESP_LOGI(TAG, "Detection: CSI every %u ms, window %u, %u of %u votes", msg.config.csi_interval_ms,
+             msg.config.window_len, msg.config.move_votes, msg.config.vote_len);
+
+    /* Lost while the radio sleeps in a duty cycle, repeated every CONFIG_DETECT_REPORT_MS */
+    espnow_rate_send(__atomic_load_n(&g_report_mac, __ATOMIC_ACQUIRE), ESPNOW_RATE_CLASS_REPORT, (const uint8_t *)&msg, sizeof(msg));
 }
 
 void app_main(void)
@@ -505,7 +1217,7 @@ void app_main(void)
     ESP_ERROR_CHECK(ret);
     
     /* Load saved calibration and sensitivity settings */
-    nvs_load_settings();
+    settings_load();
     
     /* Initialize LED */
     led_init();
@@ -514,27 +1226,56 @@ void app_main(void)
     nvs_handle_t nvs;
     if (nvs_open("config", NVS_READONLY, &nvs) == ESP_OK) {
         nvs_get_u8(nvs, "node_id", &g_node_id);
+        nvs_get_u8(nvs, "channel", &g_channel);
         nvs_close(nvs);
     }
+    if (g_channel < 1 || g_channel > CHANNEL_MAX) {
+        g_channel = CONFIG_WIFI_CHANNEL;
+    }
     
     ESP_LOGI(TAG, "================ RECV SLAVE ================");
-    ESP_LOGI(TAG, "Node ID: %d", g_node_id);
+    ESP_LOGI(TAG, "Node ID: %d, channel %d", g_node_id, g_channel);
     ESP_LOGI(TAG, "Sender MAC filter: " MACSTR, MAC2STR(CONFIG_CSI_SEND_MAC));
     ESP_LOGI(TAG, "Thresholds: wander=%.6f, jitter=%.6f", 
              g_detect.wander_threshold, g_detect.jitter_threshold);
     ESP_LOGI(TAG, "Sensitivity: wander=%.3f, jitter=%.3f",
              g_detect.wander_sensitivity, g_detect.jitter_sensitivity);
     
-    /* Initialize WiFi radar */
+    /* Initialize WiFi radar, tuning commands wake this task from then on */
+    g_main_task = xTaskGetCurrentTaskHandle();
+    uint16_t csi_interval_ms = g_detect_config.csi_interval_ms;
     wifi_radar_init();
     
     /* Start radar processing */
     ESP_ERROR_CHECK(esp_radar_start());
     
+    /* Higher than the uplink work in the callbacks, a late radio wake-up misses the burst */
+    xTaskCreate(power_task, "power", 3072, NULL, 10, &g_power_task);
+    xTaskCreate(channel_task, "channel", 3072, NULL, 5, &g_channel_task);
+    
     ESP_LOGI(TAG, "Slave receiver started, waiting for CSI data...");
     
-    /* Main task just keeps running, all work is done in callbacks */
+    /* Main task only applies the tuning and logs the uplink counters, all other work is done in callbacks */
+    TickType_t log_tick = xTaskGetTickCount();
+    TickType_t report_tick = log_tick;
+    detect_config_apply(&csi_interval_ms);
+
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        bool changed = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        TickType_t now = xTaskGetTickCount();
+
+        master_peer_update();
+
+        if (changed || now - report_tick >= pdMS_TO_TICKS(CONFIG_DETECT_REPORT_MS)) {
+            detect_config_apply(&csi_interval_ms);
+            report_tick = now;
+        }
+
+        if (now - log_tick >= pdMS_TO_TICKS(10000)) {
+            ESP_LOGI(TAG, "Uplink: %lu reports sent, %lu results not reported",
+                     (unsigned long)g_uplink.report_count, (unsigned long)g_uplink.skip_count);
+            espnow_rate_log_stats();
+            log_tick = now;
+        }
     }
 }
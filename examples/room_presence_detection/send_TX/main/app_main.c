@@ -8,21 +8,31 @@
  * @brief CSI Send Node for Room Presence Detection
  *
  * This firmware runs on the transmitter device and broadcasts ESP-NOW packets
- * at a fixed frequency. The receivers use these packets to extract CSI data
+ * at a fixed frequency, paced by an esp_timer (see send_pacer.h). The receivers use these packets to extract CSI data
  * for presence detection.
+ *
+ * While the room is empty the master may ask for a duty cycle: packets are
+ * then only sent in bursts, and the receivers sleep in between. The master
+ * also moves the sender along its channel surveys and to the channel picked.
  */
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <unistd.h>
+#include <sys/param.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "nvs_flash.h"
 #include "esp_mac.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_now.h"
+#include "esp_timer.h"
+
+#include "csi_wifi.h"
+#include "send_pacer.h"
 
 static const char *TAG = "csi_send";
 
@@ -30,110 +40,154 @@ static const char *TAG = "csi_send";
 #define CONFIG_WIFI_CHANNEL             11
 #define CONFIG_SEND_FREQUENCY           100  // Hz
 
-#if CONFIG_IDF_TARGET_ESP32C5 || CONFIG_IDF_TARGET_ESP32C61 || \
-    (CONFIG_IDF_TARGET_ESP32C6 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0))
-#define CONFIG_WIFI_BAND_MODE           WIFI_BAND_MODE_2G_ONLY
-#define CONFIG_WIFI_2G_BANDWIDTHS       WIFI_BW_HT40
-#define CONFIG_WIFI_2G_PROTOCOL         WIFI_PROTOCOL_11N
-#else
 #define CONFIG_WIFI_BANDWIDTH           WIFI_BW_HT40
-#endif
 
 #define CONFIG_ESP_NOW_PHYMODE          WIFI_PHY_MODE_HT40
 #define CONFIG_ESP_NOW_RATE             WIFI_PHY_RATE_MCS0_LGI
 
+/* Duty-cycle command of the master, see recv_master_RX1 power_update() */
+#define POWER_CMD                       0x15  /* [mode][cycle_slots u16][burst_slots u16] */
+#define POWER_MODE_CONTINUOUS           0
+#define POWER_MODE_DUTY                 1
+
+/* Channel commands of the master, see recv_master_RX1 channel_task() */
+#define CHANNEL_CMD_SURVEY              0x16  /* [num][dwell_ms u16][delay_ms u16][channel]... */
+#define CHANNEL_CMD_SWITCH              0x17  /* [channel][delay_ms u16] */
+#define CHANNEL_SURVEY_MAX              13
+#define CHANNEL_NVS_NAMESPACE           "config"
+#define CHANNEL_NVS_KEY                 "channel"
+
 /* Fixed MAC address for the sender - receivers filter by this MAC */
 static const uint8_t CONFIG_CSI_SEND_MAC[] = {0x1a, 0x00, 0x00, 0x00, 0x00, 0x00};
 
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(6, 0, 0)
-#define ESP_IF_WIFI_STA ESP_MAC_WIFI_STA
-#endif
+/* Home channel and the hops of a survey, stepped by s_channel_timer in the esp_timer task */
+static struct {
+    uint8_t home;
+    uint8_t saved;                      /* Home channel in NVS, written by the main loop */
+    uint8_t hops[CHANNEL_SURVEY_MAX];
+    uint8_t hop_num;
+    uint8_t hop;                        /* Next hop, hop_num goes back home */
+    uint8_t pending;                    /* Channel of a scheduled switch, 0 if none */
+    uint32_t dwell_us;
+    bool busy;                          /* A survey or a switch is scheduled */
+} s_channel = {
+    .home = CONFIG_WIFI_CHANNEL,
+};
+static esp_timer_handle_t s_channel_timer = NULL;
 
 /**
- * @brief Initialize WiFi in station mode
+ * @brief Home channel saved by the survey of the master, CONFIG_WIFI_CHANNEL if none
  */
-static void wifi_init(void)
+static void channel_load(void)
 {
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    ESP_ERROR_CHECK(esp_netif_init());
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-
-#if CONFIG_IDF_TARGET_ESP32C5
-    ESP_ERROR_CHECK(esp_wifi_start());
-    esp_wifi_set_band_mode(CONFIG_WIFI_BAND_MODE);
-    wifi_protocols_t protocols = {
-        .ghz_2g = CONFIG_WIFI_2G_PROTOCOL,
-        .ghz_5g = CONFIG_WIFI_2G_PROTOCOL
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_protocols(ESP_IF_WIFI_STA, &protocols));
-    wifi_bandwidths_t bandwidth = {
-        .ghz_2g = CONFIG_WIFI_2G_BANDWIDTHS,
-        .ghz_5g = CONFIG_WIFI_2G_BANDWIDTHS
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_bandwidths(ESP_IF_WIFI_STA, &bandwidth));
-#elif (CONFIG_IDF_TARGET_ESP32C6 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)) || CONFIG_IDF_TARGET_ESP32C61
-    ESP_ERROR_CHECK(esp_wifi_start());
-    esp_wifi_set_band_mode(CONFIG_WIFI_BAND_MODE);
-    wifi_protocols_t protocols = {
-        .ghz_2g = CONFIG_WIFI_2G_PROTOCOL,
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_protocols(ESP_IF_WIFI_STA, &protocols));
-    wifi_bandwidths_t bandwidth = {
-        .ghz_2g = CONFIG_WIFI_2G_BANDWIDTHS,
-    };
-    ESP_ERROR_CHECK(esp_wifi_set_bandwidths(ESP_IF_WIFI_STA, &bandwidth));
-#else
-    ESP_ERROR_CHECK(esp_wifi_set_bandwidth(ESP_IF_WIFI_STA, CONFIG_WIFI_BANDWIDTH));
-    ESP_ERROR_CHECK(esp_wifi_start());
-#endif
-
-    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
-
-    /* Set channel with secondary channel below for HT40 */
-#if CONFIG_IDF_TARGET_ESP32C5
-    if ((CONFIG_WIFI_BAND_MODE == WIFI_BAND_MODE_2G_ONLY && CONFIG_WIFI_2G_BANDWIDTHS == WIFI_BW_HT20)) {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE));
-    } else {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_WIFI_CHANNEL, WIFI_SECOND_CHAN_BELOW));
+    nvs_handle_t nvs;
+    uint8_t channel = 0;
+
+    if (nvs_open(CHANNEL_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        nvs_get_u8(nvs, CHANNEL_NVS_KEY, &channel);
+        nvs_close(nvs);
     }
-#elif (CONFIG_IDF_TARGET_ESP32C6 && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)) || CONFIG_IDF_TARGET_ESP32C61
-    if (CONFIG_WIFI_BAND_MODE == WIFI_BAND_MODE_2G_ONLY && CONFIG_WIFI_2G_BANDWIDTHS == WIFI_BW_HT20) {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE));
-    } else {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_WIFI_CHANNEL, WIFI_SECOND_CHAN_BELOW));
+
+    if (channel >= 1 && channel <= CHANNEL_SURVEY_MAX) {
+        s_channel.home = channel;
+    }
+    s_channel.saved = s_channel.home;
+}
+
+static void channel_save(uint8_t channel)
+{
+    nvs_handle_t nvs;
+
+    if (nvs_open(CHANNEL_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_set_u8(nvs, CHANNEL_NVS_KEY, channel);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+}
+
+/* esp_timer task: the next survey hop, back home, or the scheduled switch */
+static void channel_timer_cb(void *arg)
+{
+    if (s_channel.pending) {
+        s_channel.home = s_channel.pending;
+        s_channel.pending = 0;
+        esp_wifi_set_channel(s_channel.home, csi_wifi_second_chan(s_channel.home, CONFIG_WIFI_BANDWIDTH));
+        s_channel.busy = false;
+        ESP_LOGI(TAG, "Switched to channel %d", s_channel.home);
+        return;
+    }
+
+    if (s_channel.hop < s_channel.hop_num) {
+        uint8_t channel = s_channel.hops[s_channel.hop++];
+        esp_wifi_set_channel(channel, csi_wifi_second_chan(channel, CONFIG_WIFI_BANDWIDTH));
+        esp_timer_start_once(s_channel_timer, s_channel.dwell_us);
+        return;
     }
-#else
-    if (CONFIG_WIFI_BANDWIDTH == WIFI_BW_HT20) {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE));
+
+    esp_wifi_set_channel(s_channel.home, csi_wifi_second_chan(s_channel.home, CONFIG_WIFI_BANDWIDTH));
+    s_channel.busy = false;
+}
+
+/**
+ * @brief Schedule the survey hops or the switch of a channel command
+ *
+ * The master repeats each command with the time left until it takes
+ * effect, the first copy heard schedules it and the later ones are ignored.
+ */
+static void channel_cmd(const uint8_t *data, int len)
+{
+    uint16_t delay_ms = 0;
+
+    if (s_channel.busy) {
+        return;
+    }
+
+    if (data[0] == CHANNEL_CMD_SURVEY && len >= 6 && data[1] && data[1] <= CHANNEL_SURVEY_MAX && len >= 6 + data[1]) {
+        uint16_t dwell_ms;
+        memcpy(&dwell_ms, data + 2, sizeof(dwell_ms));
+        memcpy(&delay_ms, data + 4, sizeof(delay_ms));
+        memcpy(s_channel.hops, data + 6, data[1]);
+        s_channel.hop_num = data[1];
+        s_channel.hop = 0;
+        s_channel.dwell_us = dwell_ms * 1000;
+        ESP_LOGI(TAG, "Channel survey of %d channels in %u ms", data[1], delay_ms);
+    } else if (data[0] == CHANNEL_CMD_SWITCH && len >= 4 && data[1] >= 1 && data[1] <= CHANNEL_SURVEY_MAX) {
+        memcpy(&delay_ms, data + 2, sizeof(delay_ms));
+        s_channel.pending = data[1];
+        ESP_LOGI(TAG, "Switching to channel %d in %u ms", data[1], delay_ms);
     } else {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(CONFIG_WIFI_CHANNEL, WIFI_SECOND_CHAN_BELOW));
+        return;
     }
-#endif
 
-    /* Set fixed MAC address for sender identification */
-    ESP_ERROR_CHECK(esp_wifi_set_mac(WIFI_IF_STA, CONFIG_CSI_SEND_MAC));
+    s_channel.busy = true;
+    esp_timer_start_once(s_channel_timer, MAX(delay_ms, 1) * 1000);
 }
 
 /**
- * @brief Initialize ESP-NOW
+ * @brief ESP-NOW receive callback - follow the master's duty cycle and channel
  */
-static void esp_now_init_config(esp_now_peer_info_t *peer)
+static void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len)
 {
-    ESP_ERROR_CHECK(esp_now_init());
-    ESP_ERROR_CHECK(esp_now_set_pmk((uint8_t *)"pmk1234567890123"));
-    ESP_ERROR_CHECK(esp_now_add_peer(peer));
-
-    esp_now_rate_config_t rate_config = {
-        .phymode = CONFIG_ESP_NOW_PHYMODE,
-        .rate = CONFIG_ESP_NOW_RATE,
-        .ersu = false,
-        .dcm = false
-    };
-    ESP_ERROR_CHECK(esp_now_set_peer_rate_config(peer->peer_addr, &rate_config));
+    uint16_t cycle_slots = 0;
+    uint16_t burst_slots = 0;
+
+    if (len >= 1 && (data[0] == CHANNEL_CMD_SURVEY || data[0] == CHANNEL_CMD_SWITCH)) {
+        channel_cmd(data, len);
+        return;
+    }
+
+    if (len < 6 || data[0] != POWER_CMD) {
+        return;
+    }
+
+    if (data[1] == POWER_MODE_DUTY) {
+        memcpy(&cycle_slots, data + 2, sizeof(cycle_slots));
+        memcpy(&burst_slots, data + 4, sizeof(burst_slots));
+    }
+
+    send_pacer_set_duty(cycle_slots, burst_slots);
+    ESP_LOGI(TAG, "Power mode %s, %u of %u slots", data[1] == POWER_MODE_DUTY ? "duty" : "continuous",
+             burst_slots, cycle_slots);
 }
 
 void app_main(void)
@@ -145,39 +199,59 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    channel_load();
 
-    /* Initialize WiFi */
-    wifi_init();
+    /* Initialize WiFi, HT40 on the side of the home channel that exists */
+    csi_wifi_config_t wifi_config = {
+        .channel = s_channel.home,
+        .bandwidth = CONFIG_WIFI_BANDWIDTH,
+        .mac = CONFIG_CSI_SEND_MAC,
+    };
+    ESP_ERROR_CHECK(csi_wifi_init(&wifi_config));
+
+    const esp_timer_create_args_t channel_timer_args = {
+        .callback = channel_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "channel",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&channel_timer_args, &s_channel_timer));
 
     /* Initialize ESP-NOW with broadcast peer */
     esp_now_peer_info_t peer = {
-        .channel = CONFIG_WIFI_CHANNEL,
+        .channel = 0,   /* Current channel, it follows the survey hops */
         .ifidx = WIFI_IF_STA,
         .encrypt = false,
         .peer_addr = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff},  // Broadcast
     };
-    esp_now_init_config(&peer);
+    ESP_ERROR_CHECK(csi_wifi_esp_now_init(&peer, CONFIG_ESP_NOW_PHYMODE, CONFIG_ESP_NOW_RATE));
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(espnow_recv_cb));
 
     ESP_LOGI(TAG, "================ CSI SEND ================");
-    ESP_LOGI(TAG, "WiFi Channel: %d, Send Frequency: %d Hz", CONFIG_WIFI_CHANNEL, CONFIG_SEND_FREQUENCY);
+    ESP_LOGI(TAG, "WiFi Channel: %d, Send Frequency: %d Hz", s_channel.home, CONFIG_SEND_FREQUENCY);
     ESP_LOGI(TAG, "Sender MAC: " MACSTR, MAC2STR(CONFIG_CSI_SEND_MAC));
     ESP_LOGI(TAG, "Broadcasting ESP-NOW packets for CSI extraction...");
 
-    /* Main loop: broadcast packets at fixed frequency */
-    uint32_t send_interval_us = 1000 * 1000 / CONFIG_SEND_FREQUENCY;
-    
-    for (uint32_t count = 0; ; ++count) {
-        esp_err_t ret = esp_now_send(peer.peer_addr, (const uint8_t *)&count, sizeof(count));
-        
-        if (ret != ESP_OK) {
-            ESP_LOGW(TAG, "ESP-NOW send error: %s, free heap: %ld", 
-                     esp_err_to_name(ret), esp_get_free_heap_size());
-        }
+    /* Packets are sent from the pacer timer, the main loop only reports */
+    send_pacer_config_t pacer_config = SEND_PACER_CONFIG_DEFAULT(CONFIG_SEND_FREQUENCY);
+    memcpy(pacer_config.peer_addr, peer.peer_addr, sizeof(pacer_config.peer_addr));
+    ESP_ERROR_CHECK(send_pacer_start(&pacer_config));
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(10 * 1000));
 
-        if (count % (CONFIG_SEND_FREQUENCY * 10) == 0) {
-            ESP_LOGI(TAG, "Sent %lu packets, free heap: %ld", count, esp_get_free_heap_size());
+        /* Written here, a flash write in the timer task would delay the pacer */
+        uint8_t home = s_channel.home;
+        if (home != s_channel.saved) {
+            channel_save(home);
+            s_channel.saved = home;
         }
 
-        usleep(send_interval_us);
+        send_pacer_stats_t stats;
+        send_pacer_get_stats(&stats, true);
+        ESP_LOGI(TAG, "Rate: %.1f/%d Hz, jitter avg/max: %lu/%lu us, missed: %lu, busy: %lu, retries: %lu, dropped: %lu, failed: %lu, idle: %lu, free heap: %ld",
+                 stats.rate, CONFIG_SEND_FREQUENCY, (unsigned long)stats.jitter_avg_us, (unsigned long)stats.jitter_max_us,
+                 (unsigned long)stats.missed, (unsigned long)stats.busy, (unsigned long)stats.retries,
+                 (unsigned long)stats.dropped, (unsigned long)stats.send_fail, (unsigned long)stats.idle,
+                 esp_get_free_heap_size());
     }
 }